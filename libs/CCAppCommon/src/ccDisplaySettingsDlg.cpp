@@ -81,6 +81,8 @@ ccDisplaySettingsDlg::ccDisplaySettingsDlg(QWidget* parent)
 	        { m_options.confirmQuit = state; });
 
 	connect(m_ui->useVBOCheckBox, &QAbstractButton::clicked, this, &ccDisplaySettingsDlg::changeVBOUsage);
+	connect(m_ui->useCompactVBOCheckBox, &QCheckBox::toggled, this, [&](bool state)
+	        { m_parameters.useCompactVBOs = state; });
 
 	connect(m_ui->colorRampWidthSpinBox, qOverload<int>(&QSpinBox::valueChanged), this, &ccDisplaySettingsDlg::changeColorScaleRampWidth);
 
@@ -210,6 +212,8 @@ void ccDisplaySettingsDlg::refresh()
 		m_ui->drawRoundedPointsCheckBox->setChecked(m_parameters.drawRoundedPoints);
 		m_ui->maxCloudSizeDoubleSpinBox->setValue(m_parameters.minLoDCloudSize / 1000000.0);
 		m_ui->useVBOCheckBox->setChecked(m_parameters.useVBOs);
+		m_ui->useCompactVBOCheckBox->setChecked(m_parameters.useCompactVBOs);
+		m_ui->useCompactVBOCheckBox->setEnabled(m_parameters.useVBOs);
 		m_ui->showCrossCheckBox->setChecked(m_parameters.displayCross);
 		m_ui->singleClickPickingCheckBox->setChecked(m_parameters.singleClickPicking);
 
@@ -421,6 +425,7 @@ void ccDisplaySettingsDlg::changeMaxCloudSize(double val)
 void ccDisplaySettingsDlg::changeVBOUsage()
 {
 	m_parameters.useVBOs = m_ui->useVBOCheckBox->isChecked();
+	m_ui->useCompactVBOCheckBox->setEnabled(m_parameters.useVBOs);
 	if (m_parameters.useVBOs && m_ui->maxCloudSizeDoubleSpinBox->value() < s_defaultMaxVBOCloudSizeM)
 	{
 		m_ui->maxCloudSizeDoubleSpinBox->setValue(s_defaultMaxVBOCloudSizeM);
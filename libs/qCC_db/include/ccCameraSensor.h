@@ -404,15 +404,17 @@ class QCC_DB_LIB_API ccCameraSensor : public ccSensor
 	    \param minCorner (optional) outputs 3D min corner (2 values)
 	    \param maxCorner (optional) outputs 3D max corner (2 values)
 	    \param realCorners (optional) image real 3D corners (4*2 values)
+	    \param bilinearInterpolation whether to use a bilinear interpolation of the input pixels (nearest pixel otherwise)
 	    \return ortho-rectified image
 	**/
 	ccImage* orthoRectifyAsImage(const ccImage*                  image,
 	                             CCCoreLib::GenericIndexedCloud* keypoints3D,
 	                             std::vector<KeyPoint>&          keypointsImage,
 	                             double&                         pixelSize,
-	                             double*                         minCorner   = nullptr,
-	                             double*                         maxCorner   = nullptr,
-	                             double*                         realCorners = nullptr) const;
+	                             double*                         minCorner             = nullptr,
+	                             double*                         maxCorner             = nullptr,
+	                             double*                         realCorners           = nullptr,
+	                             bool                            bilinearInterpolation = false) const;
 
 	//! Direct ortho-rectification of an image (as image)
 	/** No keypoint is required. The user must specify however the
@@ -424,18 +426,22 @@ class QCC_DB_LIB_API ccCameraSensor : public ccSensor
 	    \param minCorner (optional) outputs 3D min corner (2 values)
 	    \param maxCorner (optional) outputs 3D max corner (2 values)
 	    \param realCorners (optional) image real 3D corners (4*2 values)
+	    \param bilinearInterpolation whether to use a bilinear interpolation of the input pixels (nearest pixel otherwise)
 	    \return ortho-rectified image
 	**/
 	ccImage* orthoRectifyAsImageDirect(const ccImage*      image,
 	                                   PointCoordinateType altitude,
 	                                   double&             pixelSize,
-	                                   bool                undistortImages = true,
-	                                   double*             minCorner       = nullptr,
-	                                   double*             maxCorner       = nullptr,
-	                                   double*             realCorners     = nullptr) const;
+	                                   bool                undistortImages       = true,
+	                                   double*             minCorner             = nullptr,
+	                                   double*             maxCorner             = nullptr,
+	                                   double*             realCorners           = nullptr,
+	                                   bool                bilinearInterpolation = false) const;
 
 	//! Projective ortho-rectification of multiple images (as image files)
-	/** \param images set of N calibrated images (i.e. images with their associated sensor)
+	/** The images are processed in parallel. Each ortho-rectified image is saved
+	    as soon as it is ready (and released if it is not requested as output).
+	    \param images set of N calibrated images (i.e. images with their associated sensor)
 	    \param a {a0, a1, a2} triplets for all images (size: 3*N)
 	    \param b {b0, b1, b2} triplets for all images (size: 3*N)
 	    \param c {c0(=1), c1, c2} triplets for all images (size: 3*N)
@@ -443,6 +449,8 @@ class QCC_DB_LIB_API ccCameraSensor : public ccSensor
 	    \param outputDir output directory for resulting images (is successful)
 	    \param[out] orthoRectifiedImages resulting images (is successful)
 	    \param[out] relativePos relative positions (relatively to first image)
+	    \param bilinearInterpolation whether to use a bilinear interpolation of the input pixels (nearest pixel otherwise)
+	    \param maxThreadCount max number of threads (0 = all)
 	    \return true if successful
 	**/
 	static bool OrthoRectifyAsImages(std::vector<ccImage*>                   images,
@@ -450,9 +458,11 @@ class QCC_DB_LIB_API ccCameraSensor : public ccSensor
 	                                 double                                  b[],
 	                                 double                                  c[],
 	                                 unsigned                                maxSize,
-	                                 QDir*                                   outputDir            = nullptr,
-	                                 std::vector<ccImage*>*                  orthoRectifiedImages = nullptr,
-	                                 std::vector<std::pair<double, double>>* relativePos          = nullptr);
+	                                 QDir*                                   outputDir             = nullptr,
+	                                 std::vector<ccImage*>*                  orthoRectifiedImages  = nullptr,
+	                                 std::vector<std::pair<double, double>>* relativePos           = nullptr,
+	                                 bool                                    bilinearInterpolation = false,
+	                                 int                                     maxThreadCount        = 0);
 
 	//! Computes ortho-rectification parameters for a given image
 	/** Requires at least 4 key points!
@@ -493,6 +503,38 @@ class QCC_DB_LIB_API ccCameraSensor : public ccSensor
 	**/
 	bool computeUncertainty(CCCoreLib::ReferenceCloud* points, std::vector<Vector3Tpl<ScalarType>>& accuracy /*, bool lensDistortion*/);
 
+	//! Undistortion map (see computeUndistortionMap)
+	struct UndistortionMap
+	{
+		//! Image width
+		int width = 0;
+		//! Image height
+		int height = 0;
+		//! Index of the input pixel (y * width + x) for each output pixel (or -1 if none)
+		std::vector<int> sourcePixels;
+
+		//! Returns whether the map is valid
+		inline bool isValid() const { return width > 0 && height > 0 && sourcePixels.size() == static_cast<size_t>(width) * height; }
+	};
+
+	//! Computes the undistortion map of the sensor for a given image size
+	/** The map only depends on the sensor parameters and on the image size, so that it can
+	    be computed once and then applied to all the images of the same camera (see Undistort).
+	    \warning Only works with the simple radial distortion model for now (see RadialDistortionParameters).
+	    \param width image width
+	    \param height image height
+	    \param[out] map undistortion map
+	    \return success
+	**/
+	bool computeUndistortionMap(int width, int height, UndistortionMap& map) const;
+
+	//! Undistorts an image with a precomputed undistortion map
+	/** \param image input image (must have the same size as the map)
+	    \param map undistortion map (see computeUndistortionMap)
+	    \return undistorted image (or a null one if an error occurred)
+	**/
+	static QImage Undistort(const QImage& image, const UndistortionMap& map);
+
 	//! Undistorts an image based on the sensor distortion parameters
 	/** \warning Only works with the simple radial distortion model for now (see RadialDistortionParameters).
 	    \param image input image
@@ -515,6 +557,12 @@ class QCC_DB_LIB_API ccCameraSensor : public ccSensor
 	**/
 	bool isGlobalCoordInFrustum(const CCVector3& globalCoord /*, bool withLensCorrection*/) const;
 
+	//! Tests if a 3D point (expressed in the sensor coordinates system) is in the field of view of the camera.
+	/** \param localCoord local coordinates of the 3D point
+	    \return whether the point is in the field of view
+	**/
+	bool isLocalCoordInFrustum(const CCVector3& localCoord) const;
+
 	//! Compute the coefficients of the 6 planes frustum in the global coordinates system (normal vector are headed the frustum inside), the edges direction vectors and the frustum center
 	/** \param planeCoefficients coefficients of the six planes
 	    \param edges direction vectors of the frustum edges (there are 12 edges but some of them are collinear)
@@ -655,12 +703,12 @@ class ccOctreeFrustumIntersector
 	    \param frustumEdges 3D coordinates (global coordinates system) of the six director vector of the frustum edges
 	    \param frustumCenter 3D coordinates of the frustum center (global coordinates system) ; this is the center of the circumscribed sphere
 	**/
-	OctreeCellVisibility separatingAxisTest(const CCVector3& bbMin,
-	                                        const CCVector3& bbMax,
-	                                        const float      planesCoefficients[6][4],
-	                                        const CCVector3  frustumCorners[8],
-	                                        const CCVector3  frustumEdges[6],
-	                                        const CCVector3& frustumCenter);
+	static OctreeCellVisibility separatingAxisTest(const CCVector3& bbMin,
+	                                               const CCVector3& bbMax,
+	                                               const float      planesCoefficients[6][4],
+	                                               const CCVector3  frustumCorners[8],
+	                                               const CCVector3  frustumEdges[6],
+	                                               const CCVector3& frustumCenter);
 
   protected:
 	CCCoreLib::DgmOctree* m_associatedOctree;
@@ -24,7 +24,9 @@
 #include "ccMaterial.h"
 
 class ccGenericGLDisplay;
+class ccGLMatrix;
 class ccScalarField;
+class Frustum;
 class ccColorRampShader;
 class ccShader;
 
@@ -133,6 +135,8 @@ struct ccGLDrawContext
 	ccShader* customRenderingShader;
 	//! Use VBOs for faster display
 	bool useVBOs;
+	//! Store the cloud coordinates in a compact (quantized) format in the VBOs
+	bool useCompactVBOs;
 
 	//! Label marker size (radius)
 	float labelMarkerSize;
@@ -159,6 +163,18 @@ struct ccGLDrawContext
 	//! Entity picking mechanism
 	ccColorBasedEntityPicking entityPicking;
 
+	//! View frustum (optional, 3D pass only)
+	/** If set, the entities lying completely outside of it are not drawn (see ccHObject::draw).
+	    Expressed in the 3D view coordinate system (i.e. before any entity GL transformation).
+	**/
+	const Frustum* viewFrustum;
+	//! Cumulated GL transformation of the current entity (relatively to the view frustum - nullptr = identity)
+	const ccGLMatrix* viewFrustumTrans;
+	//! Number of entities actually drawn during the 3D pass (when a view frustum is set)
+	unsigned drawnEntityCount;
+	//! Number of entities culled during the 3D pass (when a view frustum is set)
+	unsigned culledEntityCount;
+
 	// Default constructor
 	ccGLDrawContext()
 	    : drawingFlags(0)
@@ -187,6 +203,7 @@ struct ccGLDrawContext
 	    , colorRampShader(nullptr)
 	    , customRenderingShader(nullptr)
 	    , useVBOs(true)
+	    , useCompactVBOs(false)
 	    , labelMarkerSize(5)
 	    , labelMarkerTextShift_pix(5)
 	    , dispNumberPrecision(6)
@@ -195,6 +212,10 @@ struct ccGLDrawContext
 	    , destBlend(GL_ONE_MINUS_SRC_ALPHA)
 	    , stereoPassIndex(0)
 	    , drawRoundedPoints(false)
+	    , viewFrustum(nullptr)
+	    , viewFrustumTrans(nullptr)
+	    , drawnEntityCount(0)
+	    , culledEntityCount(0)
 	{
 	}
 
@@ -20,9 +20,13 @@
 
 // Local
 #include "ccAdvancedTypes.h"
+#include "ccNearestNeighbourIndex.h"
 #include "ccOctree.h"
 #include "ccShiftedObject.h"
 
+// Qt
+#include <QMutex>
+
 // System
 #include <vector>
 
@@ -117,6 +121,24 @@ class QCC_DB_LIB_API ccGenericPointCloud : public ccShiftedObject
 	//! Erases the octree
 	virtual void deleteOctree();
 
+	/***************************************************
+	        Nearest neighbour index management
+	***************************************************/
+
+	//! Returns the nearest neighbour index (kd-tree) of this cloud
+	/** The index is persistent: it is only built once, then reused until the
+	    cloud geometry changes (see deleteNearestNeighbourIndex).
+	    This method is thread-safe: concurrent callers wait for the index
+	    to be built once, then share it.
+	    \param autoCompute whether to build the index if necessary
+	    \param progressCb the caller can get some notification of the process progress through this callback mechanism (see CCCoreLib documentation)
+	    \return the index (or a null pointer if it couldn't be built)
+	**/
+	ccNearestNeighbourIndex::Shared getNearestNeighbourIndex(bool autoCompute = true, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Releases the nearest neighbour index
+	void deleteNearestNeighbourIndex();
+
 	/***************************************************
 	                Features getters
 	***************************************************/
@@ -303,6 +325,11 @@ class QCC_DB_LIB_API ccGenericPointCloud : public ccShiftedObject
 	**/
 	VisibilityTableType m_pointsVisibility;
 
+	//! Nearest neighbour index (see getNearestNeighbourIndex)
+	ccNearestNeighbourIndex::Shared m_nnIndex;
+	//! Mutex protecting the nearest neighbour index (build and release)
+	mutable QMutex m_nnIndexMutex;
+
 	//! Point size (won't be applied if 0)
 	unsigned char m_pointSize;
 };
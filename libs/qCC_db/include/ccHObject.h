@@ -22,6 +22,9 @@
 #include "ccBBox.h"
 #include "ccObject.h"
 
+// System
+#include <unordered_map>
+
 class QIcon;
 
 //! Hierarchical CloudCompare Object
@@ -156,11 +159,19 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	}
 
 	//! Finds an entity in this object hierarchy
-	/** \param uniqueID child unique ID
+	/** All the entities are referenced in a global (thread-safe) index by their unique ID,
+	    so that this method doesn't need to scan the hierarchy.
+	    \param uniqueID child unique ID
 	    \return child (or nullptr if not found)
 	**/
 	ccHObject* find(unsigned uniqueID) const;
 
+	//! Returns whether an entity is part of this object hierarchy (i.e. a child of this object or of one of its descendants)
+	/** Contrary to isAncestorOf, the children that don't have this object as parent are also taken into account
+	    (see the DP_PARENT_OF_OTHER dependency flag).
+	**/
+	bool isHolderOf(const ccHObject* anObject) const;
+
 	//! Standard instances container (for children, etc.)
 	using Container = std::vector<ccHObject*>;
 
@@ -389,6 +400,10 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	//! Notifies all dependent entities that the geometry of this entity has changed
 	virtual void notifyGeometryUpdate();
 
+	// inherited from ccObject
+	void setEnabled(bool state) override;
+	void setUniqueID(unsigned ID) override;
+
 	// inherited from ccSerializableObject
 	bool  isSerializable() const override;
 	bool  toFile(QFile& out, short dataVersion) const override;
@@ -473,6 +488,25 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	{ /*does nothing by default*/
 	}
 
+	//! Returns whether the entity lies completely outside of the view frustum (if any)
+	/** Entities without a valid bounding-box (e.g. purely 2D ones) are never culled.
+	 **/
+	bool isOutOfViewFrustum(const CC_DRAW_CONTEXT& context);
+
+	//! Updates the children drawing order (opaque 3D pass only)
+	/** Opaque 3D children (clouds and meshes without transparent materials) are grouped
+	    by type and material set so as to limit the OpenGL state changes. The other children
+	    (labels, 2D or transparent entities, etc.) keep their position, and no child is moved
+	    across them. The original order is kept inside each group.
+	**/
+	void updateDrawOrder();
+
+	//! Invalidates the display caches (drawing order, bounding-boxes) after a modification of the hierarchy or of the geometry
+	void invalidateDisplayCaches();
+
+	//! Increments the display revision of the entity and of all its ancestors (see m_subtreeRevision)
+	void incrementSubtreeRevision();
+
 	//! Applies a GL transformation to the entity
 	/** this = rotMat*(this-rotCenter)+(rotCenter+trans)
 	    \param trans a ccGLMatrix structure
@@ -528,11 +562,20 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 	//! Selection behavior
 	SelectionBehavior m_selectionBehavior;
 
-	//! Dependencies map
+	//! Dependencies map type
+	using DependencyMap = std::unordered_map<ccHObject*, int>;
+
+	//! Dependencies map (i.e. the outgoing edges of the dependency graph)
 	/** First parameter: other object
 	    Second parameter: dependency flags (see DEPENDENCY_FLAGS)
+	    Whenever an object declares a dependency with another one, the other one
+	    is asked to notify it when it's deleted (so that the graph remains consistent
+	    and the deletion of an object costs O(degree)).
 	**/
-	std::map<ccHObject*, int> m_dependencies;
+	DependencyMap m_dependencies;
+
+	//! Objects holding this one as a child (usually only the parent)
+	Container m_holders;
 
 	//! Cumulative GL transformation
 	/** History of all the applied transformations since the creation of the object
@@ -542,6 +585,24 @@ class QCC_DB_LIB_API ccHObject : public ccObject
 
 	//! Flag to safely handle dependencies when the object is being deleted
 	bool m_isDeleting;
+
+	//! Children drawing order (indexes in m_children - see updateDrawOrder)
+	/** Cleared whenever the children list is modified.
+	 **/
+	std::vector<unsigned> m_drawOrder;
+
+	//! Revision of the displayed geometry of this entity and its descendants
+	/** Incremented whenever the geometry, the transformation or the children of the
+	    entity (or of one of its descendants) are modified.
+	 **/
+	unsigned m_subtreeRevision;
+	//! Subtree revision corresponding to m_drawOrder
+	unsigned m_drawOrderRevision;
+
+	//! Cached bounding-box used to display the name in 3D (see getBB_recursive)
+	ccBBox m_nameIn3DBBox;
+	//! Subtree revision corresponding to m_nameIn3DBBox
+	unsigned m_nameIn3DBBoxRevision;
 };
 
 /*** Helpers ***/
@@ -18,19 +18,66 @@
 #ifndef CC_MST_FOR_NORMS_DIRECTION_HEADER
 #define CC_MST_FOR_NORMS_DIRECTION_HEADER
 
+// Local
+#include "qCC_db.h"
+
+// system
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 class ccPointCloud;
 class ccProgressDialog;
 
 //! Minimum Spanning Tree for normals direction resolution
 /** See http://people.maths.ox.ac.uk/wendland/research/old/reconhtml/node3.html
  **/
-class ccMinimumSpanningTreeForNormsDirection
+class QCC_DB_LIB_API ccMinimumSpanningTreeForNormsDirection
 {
   public:
+	//! Compact kNN graph (CSR layout)
+	struct KNNGraph
+	{
+		//! Index of the first edge of each vertex (size: vertex count + 1)
+		std::vector<unsigned> firstEdge;
+		//! Edges target vertex
+		std::vector<unsigned> targets;
+		//! Edges weight (positive)
+		std::vector<float> weights;
+
+		//! Returns the source vertex of an edge
+		inline unsigned source(unsigned edgeIndex) const
+		{
+			return static_cast<unsigned>(std::upper_bound(firstEdge.begin(), firstEdge.end(), edgeIndex) - firstEdge.begin()) - 1;
+		}
+	};
+
+	//! Computes the Minimum Spanning Forest of a graph (Boruvka's algorithm)
+	/** The candidate edges of each component are determined in parallel.
+	    \param graph the graph (each edge is considered as undirected)
+	    \param maxThreadCount max number of threads (0 = all)
+	    \param[out] treeEdges the edges of the spanning forest
+	**/
+	static void ComputeMinimumSpanningForest(const KNNGraph&                             graph,
+	                                         int                                         maxThreadCount,
+	                                         std::vector<std::pair<unsigned, unsigned>>& treeEdges);
+
 	//! Main entry point
+	/** The kNN graph is built in parallel (in a compact CSR layout), then the
+	    Minimum Spanning Tree is computed with Boruvka's algorithm and the
+	    orientation is propagated along it (breadth first). If there's not
+	    enough memory to store the whole graph, the normals are oriented with
+	    the (slower) sequential method.
+	    \param cloud cloud (with normals)
+	    \param kNN number of neighbors
+	    \param progressDlg optional progress dialog
+	    \param maxThreadCount max number of threads (0 = all)
+	    \return success
+	**/
 	static bool OrientNormals(ccPointCloud*     cloud,
-	                          unsigned          kNN         = 6,
-	                          ccProgressDialog* progressDlg = nullptr);
+	                          unsigned          kNN            = 6,
+	                          ccProgressDialog* progressDlg    = nullptr,
+	                          int               maxThreadCount = 0);
 };
 
 #endif // CC_MST_FOR_NORMS_DIRECTION_HEADER
@@ -0,0 +1,146 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#ifndef CC_NEAREST_NEIGHBOUR_INDEX_HEADER
+#define CC_NEAREST_NEIGHBOUR_INDEX_HEADER
+
+// Local
+#include "qCC_db.h"
+
+// CCCoreLib
+#include <CCGeom.h>
+
+// Qt
+#include <QSharedPointer>
+
+// System
+#include <utility>
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericIndexedCloud;
+	class GenericProgressCallback;
+} // namespace CCCoreLib
+
+//! Persistent kd-tree for fast nearest neighbour(s) queries
+/** The points are copied (and re-ordered) in contiguous per-dimension buffers
+    so that the leaves can be scanned linearly. The tree is balanced (median
+    split along the largest dimension) and implicit: its shape only depends on
+    the number of points, so that no pointer is stored.
+    Queries are read-only and can be run concurrently by several threads.
+**/
+class QCC_DB_LIB_API ccNearestNeighbourIndex
+{
+  public:
+	//! Shared pointer
+	typedef QSharedPointer<ccNearestNeighbourIndex> Shared;
+
+	//! Max number of points per leaf
+	static const unsigned MAX_LEAF_SIZE = 16;
+
+	//! Builds the index of a cloud
+	/** \param cloud the cloud to index
+	    \param maxThreadCount max number of threads (0 = all)
+	    \param progressCb optional progress callback
+	    \return the index (or a null pointer if the cloud is empty, if there's not enough memory or if the process was cancelled)
+	**/
+	static Shared Build(CCCoreLib::GenericIndexedCloud*     cloud,
+	                    int                                 maxThreadCount = 0,
+	                    CCCoreLib::GenericProgressCallback* progressCb     = nullptr);
+
+	//! Returns the number of indexed points
+	inline unsigned size() const
+	{
+		return static_cast<unsigned>(m_indexes.size());
+	}
+
+	//! Finds the nearest neighbour of a point
+	/** \param P query point
+	    \param maxSquareDist max squared distance (or a negative value for no limit)
+	    \param[out] squareDist squared distance to the nearest neighbour (if any)
+	    \return the index of the nearest neighbour in the original cloud or -1 if none was found
+	**/
+	int findNearestNeighbour(const CCVector3& P, PointCoordinateType maxSquareDist, PointCoordinateType& squareDist) const;
+
+	//! Nearest neighbours buffer (see findKNearestNeighbours)
+	/** Reuse the same buffer for consecutive queries (one per thread)
+	    so as to avoid any memory allocation.
+	**/
+	struct KNNBuffer
+	{
+		//! (squared distance, point index) pairs
+		std::vector<std::pair<PointCoordinateType, unsigned>> neighbours;
+	};
+
+	//! Finds the k nearest neighbours of a point
+	/** The neighbours are sorted by increasing distance.
+	    \param P query point
+	    \param k number of neighbours
+	    \param buffer output buffer
+	    \param maxSquareDist max squared distance (or a negative value for no limit)
+	    \return the number of neighbours found (<= k)
+	**/
+	unsigned findKNearestNeighbours(const CCVector3&    P,
+	                                unsigned            k,
+	                                KNNBuffer&          buffer,
+	                                PointCoordinateType maxSquareDist = -1) const;
+
+	//! Finds all the neighbours of a point inside a sphere
+	/** The neighbours are not sorted.
+	    \param P query point (sphere center)
+	    \param radius sphere radius
+	    \param buffer output buffer
+	    \return the number of neighbours found
+	**/
+	unsigned findNeighboursInSphere(const CCVector3& P, PointCoordinateType radius, KNNBuffer& buffer) const;
+
+  protected:
+	//! Default constructor (see Build)
+	ccNearestNeighbourIndex();
+
+	//! Recursive search
+	template <class Result>
+	void searchNode(const CCVector3&    P,
+	                unsigned            nodeIndex,
+	                unsigned            level,
+	                unsigned            begin,
+	                unsigned            end,
+	                PointCoordinateType minSquareDist,
+	                PointCoordinateType offsets[3],
+	                Result&             result) const;
+
+	//! Returns the squared distance between a point and the index bounding-box (and the corresponding offsets)
+	PointCoordinateType initOffsets(const CCVector3& P, PointCoordinateType offsets[3]) const;
+
+	//! Re-ordered point coordinates (one buffer per dimension)
+	std::vector<PointCoordinateType> m_coords[3];
+	//! Original index of each re-ordered point
+	std::vector<unsigned> m_indexes;
+	//! Split value of each inner node
+	std::vector<PointCoordinateType> m_splitValues;
+	//! Split dimension of each inner node
+	std::vector<unsigned char> m_splitDims;
+	//! Tree depth (i.e. level of the leaves)
+	unsigned m_depth;
+	//! Bounding-box min corner
+	CCVector3 m_bbMin;
+	//! Bounding-box max corner
+	CCVector3 m_bbMax;
+};
+
+#endif // CC_NEAREST_NEIGHBOUR_INDEX_HEADER
@@ -25,6 +25,9 @@
 #include <QSharedPointer>
 #include <QVariant>
 
+// System
+#include <atomic>
+
 //! Object state flag
 enum CC_OBJECT_FLAG
 { // CC_UNUSED			= 1, //DGM: not used anymore (former CC_FATHER_DEPENDENT)
@@ -148,6 +151,8 @@ namespace CC_TYPES
 }
 
 //! Unique ID generator (should be unique for the whole application instance - with plugins, etc.)
+/** IDs can be fetched concurrently (e.g. by entities created in worker threads).
+ **/
 class QCC_DB_LIB_API ccUniqueIDGenerator
 {
   public:
@@ -181,12 +186,14 @@ class QCC_DB_LIB_API ccUniqueIDGenerator
 	//! Updates the value of the last generated unique ID with the current one
 	void update(unsigned ID)
 	{
-		if (ID > m_lastUniqueID)
-			m_lastUniqueID = ID;
+		unsigned lastID = m_lastUniqueID;
+		while (ID > lastID && !m_lastUniqueID.compare_exchange_weak(lastID, ID))
+		{
+		}
 	}
 
   protected:
-	unsigned m_lastUniqueID;
+	std::atomic<unsigned> m_lastUniqueID;
 };
 
 //! Generic "CloudCompare Object" template
@@ -107,6 +107,46 @@ class QCC_DB_LIB_API ccOctree : public QObject
 	bool intersectWithFrustum(ccCameraSensor*        sensor,
 	                          std::vector<unsigned>& inCameraFrustum);
 
+	//! Points inside the frustum of several camera sensors (see intersectWithFrusta)
+	/** The indexes of the points inside the frustum of the k-th sensor are
+	    pointIndexes[rangeStart[k]] to pointIndexes[rangeStart[k+1] - 1].
+	**/
+	struct FrustaIntersection
+	{
+		//! Points indexes (grouped by sensor)
+		std::vector<unsigned> pointIndexes;
+		//! Start of the range of each sensor in 'pointIndexes' (size: sensor count + 1)
+		std::vector<size_t> rangeStart;
+
+		//! Returns the number of points inside the frustum of a given sensor
+		inline size_t pointCount(size_t sensorIndex) const
+		{
+			return rangeStart[sensorIndex + 1] - rangeStart[sensorIndex];
+		}
+		//! Returns the indexes of the points inside the frustum of a given sensor
+		inline const unsigned* points(size_t sensorIndex) const
+		{
+			return pointIndexes.data() + rangeStart[sensorIndex];
+		}
+	};
+
+	//! Intersects octree with several camera sensors at once
+	/** The octree is traversed only once for all the sensors: each cell is only
+	    tested against the sensors whose frustum intersects its parent cell. The
+	    sub-trees are then processed in parallel.
+	    For each sensor, the points are the same as the ones returned by
+	    intersectWithFrustum (but not necessarily in the same order).
+	    \param sensors camera sensors
+	    \param[out] result points inside the frustum of each sensor
+	    \param maxThreadCount max number of threads (0 = all)
+	    \param progressCb optional progress callback
+	    \return success (false if there's not enough memory or if the process was cancelled)
+	**/
+	bool intersectWithFrusta(const std::vector<ccCameraSensor*>& sensors,
+	                         FrustaIntersection&                 result,
+	                         int                                 maxThreadCount = 0,
+	                         CCCoreLib::GenericProgressCallback* progressCb     = nullptr) const;
+
 	//! Octree-driven point picking algorithm
 	bool pointPicking(const CCVector2d&           clickPos,
 	                  const ccGLCameraParameters& camera,
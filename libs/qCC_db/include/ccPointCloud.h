@@ -168,6 +168,12 @@ class QCC_DB_LIB_API ccPointCloud : public CCCoreLib::PointCloudTpl<ccGenericPoi
 	{
 		m_vboManager.updateFlags |= vboSet::UPDATE_COLORS;
 	}
+	//! Notify a modification of the colors of a range of points only
+	/** Only the VBO chunks overlapping the range will be updated (instead of all the colors).
+	    \param firstIndex index of the first modified point
+	    \param lastIndex index of the last modified point (included)
+	**/
+	void colorsHaveChanged(unsigned firstIndex, unsigned lastIndex);
 	//! Notify a modification of normals display parameters or contents
 	inline void normalsHaveChanged()
 	{
@@ -370,19 +376,23 @@ class QCC_DB_LIB_API ccPointCloud : public CCCoreLib::PointCloudTpl<ccGenericPoi
 	}
 
 	//! Meshes a scan grid
-	/** \warning The mesh vertices will be this cloud instance!
+	/** The rows of the grid are triangulated in parallel.
+	    \warning The mesh vertices will be this cloud instance!
 	 **/
 	ccMesh* triangulateGrid(const Grid& grid, double minTriangleAngle_deg = 0.0) const;
 
   public: // normals computation/orientation
 	//! Compute the normals with the associated grid structure(s)
 	/** Can also orient the normals in the same run.
+	    The grids are processed in parallel (by bands of rows), with the same result as a sequential process.
 	 **/
 	bool computeNormalsWithGrids(double                       minTriangleAngle_deg = 1.0,
 	                             ccProgressDialog*            pDlg                 = nullptr,
 	                             ccNormalVectors::Orientation preferredOrientation = ccNormalVectors::Orientation::UNDEFINED);
 
 	//! Orient the normals with the associated grid structure(s)
+	/** The grids are processed in parallel (by bands of rows).
+	 **/
 	bool orientNormalsWithGrids(ccProgressDialog* pDlg = nullptr);
 
 	//! Normals are forced to point to O
@@ -395,8 +405,11 @@ class QCC_DB_LIB_API ccPointCloud : public CCCoreLib::PointCloudTpl<ccGenericPoi
 	                              ccProgressDialog*            pDlg = nullptr);
 
 	//! Orient the normals with a Minimum Spanning Tree
-	bool orientNormalsWithMST(unsigned          kNN  = 6,
-	                          ccProgressDialog* pDlg = nullptr);
+	/** See ccMinimumSpanningTreeForNormsDirection::OrientNormals.
+	 **/
+	bool orientNormalsWithMST(unsigned          kNN            = 6,
+	                          ccProgressDialog* pDlg           = nullptr,
+	                          int               maxThreadCount = 0);
 
 	//! Orient normals with Fast Marching
 	bool orientNormalsWithFM(unsigned char     level,
@@ -984,15 +997,30 @@ class QCC_DB_LIB_API ccPointCloud : public CCCoreLib::PointCloudTpl<ccGenericPoi
 		int rgbShift;
 		int normalShift;
 
+		//! Whether the coordinates are stored in the compact format (3 x 16 bits integers)
+		bool compact;
+		//! Dequantization origin (compact format only)
+		CCVector3d compactOrigin;
+		//! Dequantization step (compact format only)
+		double compactStep;
+
 		//! Inits the VBO
-		/** \return the number of allocated bytes (or -1 if an error occurred)
+		/** \param count number of points
+			\param compactCoords whether the coordinates are stored in the compact format
+			\param withColors whether colors are stored as well
+			\param withNormals whether normals are stored as well
+			\param reallocated optional output flag (whether the VBO has been reallocated or not)
+			\return the number of allocated bytes (or -1 if an error occurred)
 		 **/
-		int init(int count, bool withColors, bool withNormals, bool* reallocated = nullptr);
+		int init(int count, bool compactCoords, bool withColors, bool withNormals, bool* reallocated = nullptr);
 
 		VBO()
 		    : QOpenGLBuffer(QOpenGLBuffer::VertexBuffer)
 		    , rgbShift(0)
 		    , normalShift(0)
+		    , compact(false)
+		    , compactOrigin(0, 0, 0)
+		    , compactStep(1.0)
 		{
 		}
 	};
@@ -1022,6 +1050,7 @@ class QCC_DB_LIB_API ccPointCloud : public CCCoreLib::PointCloudTpl<ccGenericPoi
 		    , colorIsSF(false)
 		    , sourceSF(nullptr)
 		    , hasNormals(false)
+		    , compactCoords(false)
 		    , totalMemSizeBytes(0)
 		    , updateFlags(0)
 		    , state(NEW)
@@ -1033,8 +1062,12 @@ class QCC_DB_LIB_API ccPointCloud : public CCCoreLib::PointCloudTpl<ccGenericPoi
 		bool              colorIsSF;
 		ccScalarField*    sourceSF;
 		bool              hasNormals;
+		//! Whether the coordinates are quantized (per chunk) in VRAM
+		bool              compactCoords;
 		size_t            totalMemSizeBytes;
 		int               updateFlags;
+		//! Chunks with modified colors (partial update, see colorsHaveChanged(unsigned, unsigned))
+		std::vector<bool> colorChunksToUpdate;
 
 		//! Current state
 		STATES state;
@@ -1044,7 +1077,8 @@ class QCC_DB_LIB_API ccPointCloud : public CCCoreLib::PointCloudTpl<ccGenericPoi
 	vboSet m_vboManager;
 
 	// per-block data transfer to the GPU (VBO or standard mode)
-	void glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
+	//! Warning: if it returns true, the caller must pop the modelview matrix after drawing the chunk (dequantization of compact VBOs)
+	bool glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
 	void glChunkColorPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
 	void glChunkSFPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
 	void glChunkNormalPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs);
@@ -292,6 +292,40 @@ class QCC_DB_LIB_API ccScalarField : public CCCoreLib::ScalarField
 	//! Imports the parameters from another scalar field
 	void importParametersFrom(const ccScalarField* sf);
 
+	/*** Storage type ***/
+
+	//! Storage types
+	/** The values are always stored as 32-bit floats (see CCCoreLib::ScalarField).
+	    The storage type only tells the file filters that support typed properties
+	    (i.e. PLY) that the (raw) values are integers of a given type, so that they
+	    can be saved with this type. It is not saved in BIN files.
+	**/
+	enum class StorageType : uint8_t
+	{
+		Float32 = 0, //!< 32-bit float (default)
+		UInt8,       //!< 8-bit unsigned integer
+		Int8,        //!< 8-bit signed integer
+		UInt16,      //!< 16-bit unsigned integer
+		Int16,       //!< 16-bit signed integer
+		Int32        //!< 32-bit signed integer
+	};
+
+	//! Returns the current storage type
+	inline StorageType getStorageType() const
+	{
+		return m_storageType;
+	}
+
+	//! Sets the storage type
+	/** The values are checked first (the storage type is not changed if they can't all be stored exactly with this type).
+	    \param type storage type
+	    \return false if the values can't be stored with this type
+	**/
+	bool setStorageType(StorageType type);
+
+	//! Returns whether all the values can be stored (exactly) with a given storage type
+	bool canBeStoredAs(StorageType type) const;
+
 	// inherited from ccSerializableObject
 	inline bool isSerializable() const override
 	{
@@ -358,4 +392,7 @@ class QCC_DB_LIB_API ccScalarField : public CCCoreLib::ScalarField
 	    will turn this flag on.
 	**/
 	bool m_modified;
+
+	//! Storage type
+	StorageType m_storageType;
 };
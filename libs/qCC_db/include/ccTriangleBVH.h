@@ -0,0 +1,149 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#ifndef CC_TRIANGLE_BVH_HEADER
+#define CC_TRIANGLE_BVH_HEADER
+
+// Local
+#include "qCC_db.h"
+
+// CCCoreLib
+#include <CCGeom.h>
+
+// Qt
+#include <QSharedPointer>
+
+// System
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericIndexedMesh;
+	class GenericProgressCallback;
+} // namespace CCCoreLib
+
+//! Bounding volume hierarchy of the triangles of a mesh (for closest triangle queries)
+/** The hierarchy is balanced (median split of the triangle centers along the
+    largest dimension) and implicit, like ccNearestNeighbourIndex. The leaves
+    contain at most MAX_LEAF_SIZE triangles, stored as contiguous per-component
+    buffers (first vertex, edges, normal, etc.) so that all the point/triangle
+    distances of a leaf are evaluated in a single branch-free loop.
+    Queries are read-only and can be run concurrently by several threads.
+**/
+class QCC_DB_LIB_API ccTriangleBVH
+{
+  public:
+	//! Shared pointer
+	typedef QSharedPointer<ccTriangleBVH> Shared;
+
+	//! Max number of triangles per leaf
+	static const unsigned MAX_LEAF_SIZE = 8;
+
+	//! Builds the hierarchy of a mesh
+	/** \param mesh the mesh
+	    \param maxThreadCount max number of threads (0 = all)
+	    \param progressCb optional progress callback
+	    \return the hierarchy (or a null pointer if the mesh is empty, if there's not enough memory or if the process was cancelled)
+	**/
+	static Shared Build(CCCoreLib::GenericIndexedMesh*      mesh,
+	                    int                                 maxThreadCount = 0,
+	                    CCCoreLib::GenericProgressCallback* progressCb     = nullptr);
+
+	//! Returns the number of triangles
+	inline unsigned size() const
+	{
+		return static_cast<unsigned>(m_indexes.size());
+	}
+
+	//! Closest triangle
+	struct ClosestTriangle
+	{
+		//! Triangle index (in the original mesh) or -1 if none was found
+		int triangleIndex = -1;
+		//! Squared distance to the triangle
+		PointCoordinateType squareDist = 0;
+		//! Signed distance to the triangle plane (positive on the side of the triangle normal)
+		PointCoordinateType planeDist = 0;
+	};
+
+	//! Finds the closest triangle to a point
+	/** In 'robust' mode, if several triangles are (almost) equally close (e.g. if the
+	    closest point lies on an edge or a vertex shared by several triangles), the one
+	    that faces the point the most is kept (its plane distance is then more reliable
+	    to determine the distance sign).
+	    \param P query point
+	    \param maxSquareDist max squared distance (or a negative value for no limit)
+	    \param robust robust mode
+	    \param[out] result closest triangle (if any)
+	    \return whether a triangle was found
+	**/
+	bool findClosestTriangle(const CCVector3& P, PointCoordinateType maxSquareDist, bool robust, ClosestTriangle& result) const;
+
+	//! Returns the point of a triangle closest to a given point
+	static CCVector3 ClosestPointOnTriangle(const CCVector3& P, const CCVector3& A, const CCVector3& B, const CCVector3& C);
+
+  protected:
+	//! Default constructor (see Build)
+	ccTriangleBVH();
+
+	//! Recursive search
+	void searchNode(const CCVector3& P,
+	                unsigned         nodeIndex,
+	                unsigned         level,
+	                unsigned         begin,
+	                unsigned         end,
+	                bool             robust,
+	                ClosestTriangle& result) const;
+
+	//! Returns the squared distance between a point and the bounding-box of a node
+	PointCoordinateType boxSquareDist(const CCVector3& P, unsigned nodeIndex) const;
+
+	//! Triangle data (in leaf order)
+	enum TriangleData
+	{
+		AX,
+		AY,
+		AZ, //!< first vertex
+		ABX,
+		ABY,
+		ABZ, //!< first edge
+		ACX,
+		ACY,
+		ACZ, //!< second edge
+		NX,
+		NY,
+		NZ,             //!< normal (not normalized)
+		INV_N,          //!< inverse of the normal norm (or 0 for degenerate triangles)
+		INV_AB2,        //!< inverse of the squared length of AB (or 0)
+		INV_AC2,        //!< inverse of the squared length of AC (or 0)
+		INV_BC2,        //!< inverse of the squared length of BC (or 0)
+		TRIANGLE_DATA_COUNT
+	};
+
+	//! Triangle data buffers (one per TriangleData component)
+	std::vector<PointCoordinateType> m_data[TRIANGLE_DATA_COUNT];
+	//! Original index of each triangle (in leaf order)
+	std::vector<unsigned> m_indexes;
+	//! Nodes bounding-boxes (min corners)
+	std::vector<CCVector3> m_nodeMin;
+	//! Nodes bounding-boxes (max corners)
+	std::vector<CCVector3> m_nodeMax;
+	//! Tree depth (i.e. level of the leaves)
+	unsigned m_depth;
+};
+
+#endif // CC_TRIANGLE_BVH_HEADER
@@ -15,8 +15,13 @@
 // #                                                                        #
 // ##########################################################################
 
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_for.h>
+#endif
+
 #include "ccCameraSensor.h"
 
+#include <atomic>
 #include <cmath>
 
 // local
@@ -32,6 +37,11 @@
 #include <QDir>
 #include <QTextStream>
 
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 ccCameraSensor::IntrinsicParameters::IntrinsicParameters()
     : vertFocal_pix(1.0f)
     , skew(0)
@@ -1046,20 +1056,22 @@ bool ccCameraSensor::computeUncertainty(CCCoreLib::ReferenceCloud* points, std::
 }
 
 // see http://opencv.willowgarage.com/documentation/cpp/camera_calibration_and_3d_reconstruction.html
-QImage ccCameraSensor::undistort(const QImage& image) const
+bool ccCameraSensor::computeUndistortionMap(int width, int height, UndistortionMap& map) const
 {
-	if (image.isNull())
+	map = UndistortionMap();
+
+	if (width <= 0 || height <= 0)
 	{
-		ccLog::Warning("[ccCameraSensor::undistort] Invalid input image!");
-		return QImage();
+		ccLog::Warning("[ccCameraSensor::computeUndistortionMap] Invalid image size!");
+		return false;
 	}
 
 	// nothing to do
 	// no distortion parameters?
 	if (!m_distortionParams)
 	{
-		ccLog::Warning("[ccCameraSensor::undistort] No distortion model set!");
-		return QImage();
+		ccLog::Warning("[ccCameraSensor::computeUndistortionMap] No distortion model set!");
+		return false;
 	}
 
 	switch (m_distortionParams->getModel())
@@ -1072,8 +1084,8 @@ QImage ccCameraSensor::undistort(const QImage& image) const
 		float                             k2     = params->k2;
 		if (k1 == 0 && k2 == 0)
 		{
-			ccLog::Warning("[ccCameraSensor::undistort] Invalid radial distortion coefficients!");
-			return QImage();
+			ccLog::Warning("[ccCameraSensor::computeUndistortionMap] Invalid radial distortion coefficients!");
+			return false;
 		}
 		float k3 = 0;
 		if (m_distortionParams->getModel() == EXTENDED_RADIAL_DISTORTION)
@@ -1081,21 +1093,23 @@ QImage ccCameraSensor::undistort(const QImage& image) const
 			k3 = static_cast<ExtendedRadialDistortionParameters*>(m_distortionParams.data())->k3;
 		}
 
-		int width  = image.width();
-		int height = image.height();
-
-		float xScale = image.width() / static_cast<float>(m_intrinsicParams.arrayWidth);
-		float yScale = image.height() / static_cast<float>(m_intrinsicParams.arrayHeight);
+		float xScale = width / static_cast<float>(m_intrinsicParams.arrayWidth);
+		float yScale = height / static_cast<float>(m_intrinsicParams.arrayHeight);
 		float rScale = sqrt(xScale * xScale + yScale * yScale);
 
-		// try to reserve memory for new image
-		QImage newImage(QSize(width, height), image.format());
-		if (newImage.isNull())
+		// output pixel of each input pixel
+		std::vector<int> targetPixels;
+		try
+		{
+			targetPixels.resize(static_cast<size_t>(width) * height);
+			map.sourcePixels.resize(static_cast<size_t>(width) * height, -1);
+		}
+		catch (const std::bad_alloc&)
 		{
-			ccLog::Warning("[ccCameraSensor::undistort] Not enough memory!");
-			return QImage();
+			ccLog::Warning("[ccCameraSensor::computeUndistortionMap] Not enough memory!");
+			map = UndistortionMap();
+			return false;
 		}
-		newImage.fill(0);
 
 		float vertFocal_pix  = getVertFocal_pix() * xScale;
 		float horizFocal_pix = getHorizFocal_pix() * yScale;
@@ -1107,45 +1121,71 @@ QImage ccCameraSensor::undistort(const QImage& image) const
 		k2 *= rScale;
 		k3 *= rScale;
 
-		assert((image.depth() % 8) == 0);
-		int          depth        = image.depth() / 8;
-		int          bytesPerLine = image.bytesPerLine();
-		const uchar* iImageBits   = image.bits();
-		uchar*       oImageBits   = newImage.bits();
-
-		// image undistortion
+		auto computeRow = [&](int j)
 		{
+			float y  = j - cy;
+			float y2 = y * y;
+			int*  targetRow = targetPixels.data() + static_cast<size_t>(j) * width;
 			for (int i = 0; i < width; ++i)
 			{
 				float x  = i - cx;
 				float x2 = x * x;
-				for (int j = 0; j < height; ++j)
+
+				float p2  = x2 / hf2 + y2 / vf2;                    // p = pix/f
+				float rp  = 1.0f + p2 * (k1 + p2 * (k2 + p2 * k3)); // r(p) = 1.0 + k1 * ||p||^2 + k2 * ||p||^4 + k3 * ||p||^6
+				float eqx = rp * x + cx;
+				float eqy = rp * y + cy;
+
+				int pixx = static_cast<int>(eqx);
+				int pixy = static_cast<int>(eqy);
+				if (pixx >= 0
+				    && pixx < width
+				    && pixy >= 0
+				    && pixy < height)
+				{
+					targetRow[i] = pixy * width + pixx;
+				}
+				else
+				{
+					targetRow[i] = -1;
+				}
+			}
+		};
+
+#ifdef CC_CORE_LIB_USES_TBB
+		tbb::parallel_for(0, height, computeRow);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+		for (int j = 0; j < height; ++j)
+		{
+			computeRow(j);
+		}
+#endif
+
+		// invert the mapping
+		// (if several input pixels fall in the same output pixel, the last one in the column-wise order is kept)
+		for (int j = 0; j < height; ++j)
+		{
+			const int* targetRow = targetPixels.data() + static_cast<size_t>(j) * width;
+			for (int i = 0; i < width; ++i)
+			{
+				if (targetRow[i] >= 0)
 				{
-					float y  = j - cy;
-					float y2 = y * y;
-
-					float p2  = x2 / hf2 + y2 / vf2;                    // p = pix/f
-					float rp  = 1.0f + p2 * (k1 + p2 * (k2 + p2 * k3)); // r(p) = 1.0 + k1 * ||p||^2 + k2 * ||p||^4 + k3 * ||p||^6
-					float eqx = rp * x + cx;
-					float eqy = rp * y + cy;
-
-					int pixx = static_cast<int>(eqx);
-					int pixy = static_cast<int>(eqy);
-					if (pixx >= 0
-					    && pixx < width
-					    && pixy >= 0
-					    && pixy < height)
+					int& sourcePixel = map.sourcePixels[targetRow[i]];
+					if (sourcePixel < 0 || sourcePixel % width <= i)
 					{
-						const uchar* iPixel = iImageBits + j * bytesPerLine + i * depth;
-						uchar*       oPixel = oImageBits + pixy * bytesPerLine + pixx * depth;
-						memcpy(oPixel, iPixel, depth);
-						// newImage.setPixel(i, j, image.pixel(pixx, pixy));
+						sourcePixel = j * width + i;
 					}
 				}
 			}
 		}
 
-		return newImage;
+		map.width  = width;
+		map.height = height;
+
+		return true;
 	}
 
 	case BROWN_DISTORTION:
@@ -1158,9 +1198,83 @@ QImage ccCameraSensor::undistort(const QImage& image) const
 		break;
 	}
 
-	ccLog::Warning("[ccCameraSensor::undistort] Can't undistort the image with the current distortion model!");
+	ccLog::Warning("[ccCameraSensor::computeUndistortionMap] Can't undistort the images with the current distortion model!");
 
-	return QImage();
+	return false;
+}
+
+QImage ccCameraSensor::Undistort(const QImage& image, const UndistortionMap& map)
+{
+	if (image.isNull() || !map.isValid() || image.width() != map.width || image.height() != map.height)
+	{
+		ccLog::Warning("[ccCameraSensor::Undistort] Invalid input image or undistortion map!");
+		return QImage();
+	}
+
+	int width  = image.width();
+	int height = image.height();
+
+	// try to reserve memory for new image
+	QImage newImage(QSize(width, height), image.format());
+	if (newImage.isNull())
+	{
+		ccLog::Warning("[ccCameraSensor::Undistort] Not enough memory!");
+		return QImage();
+	}
+	newImage.fill(0);
+
+	assert((image.depth() % 8) == 0);
+	int          depth        = image.depth() / 8;
+	int          bytesPerLine = image.bytesPerLine();
+	const uchar* iImageBits   = image.constBits();
+	uchar*       oImageBits   = newImage.bits();
+
+	// image undistortion
+	auto undistortRow = [&](int j)
+	{
+		const int* sourceRow = map.sourcePixels.data() + static_cast<size_t>(j) * width;
+		uchar*     oPixel    = oImageBits + j * bytesPerLine;
+		for (int i = 0; i < width; ++i, oPixel += depth)
+		{
+			if (sourceRow[i] >= 0)
+			{
+				const uchar* iPixel = iImageBits + (sourceRow[i] / width) * bytesPerLine + (sourceRow[i] % width) * depth;
+				memcpy(oPixel, iPixel, depth);
+			}
+		}
+	};
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, height, undistortRow);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int j = 0; j < height; ++j)
+	{
+		undistortRow(j);
+	}
+#endif
+
+	return newImage;
+}
+
+QImage ccCameraSensor::undistort(const QImage& image) const
+{
+	if (image.isNull())
+	{
+		ccLog::Warning("[ccCameraSensor::undistort] Invalid input image!");
+		return QImage();
+	}
+
+	UndistortionMap map;
+	if (!computeUndistortionMap(image.width(), image.height(), map))
+	{
+		// warning message should have been already issued
+		return QImage();
+	}
+
+	return Undistort(image, map);
 }
 
 ccImage* ccCameraSensor::undistort(ccImage* image, bool inplace /*=true*/) const
@@ -1196,6 +1310,11 @@ bool ccCameraSensor::isGlobalCoordInFrustum(const CCVector3& globalCoord /*, boo
 	if (!fromGlobalCoordToLocalCoord(globalCoord, localCoord /*, withLensCorrection*/))
 		return false;
 
+	return isLocalCoordInFrustum(localCoord);
+}
+
+bool ccCameraSensor::isLocalCoordInFrustum(const CCVector3& localCoord) const
+{
 	// Tests if the projected point is between zNear and zFar
 	const float& z = localCoord.z;
 	const float& n = m_intrinsicParams.zNear_mm;
@@ -1791,13 +1910,66 @@ bool ccCameraSensor::computeOrthoRectificationParams(const ccImage*
 	return true;
 }
 
+//! Samples an image at a given position (in pixels)
+/** \param bilinear whether to interpolate the 4 nearest pixels (the nearest pixel is used otherwise)
+    \return false if the position is outside the image
+**/
+static bool SampleImage(const QImage& image, double x, double y, bool bilinear, QRgb& rgb)
+{
+	const int width  = image.width();
+	const int height = image.height();
+
+	if (!bilinear)
+	{
+		const int ix = static_cast<int>(x);
+		const int iy = static_cast<int>(y);
+		if (ix < 0 || ix >= width || iy < 0 || iy >= height)
+		{
+			return false;
+		}
+		rgb = image.pixel(ix, iy);
+		return true;
+	}
+
+	if (x < 0 || x >= width || y < 0 || y >= height)
+	{
+		return false;
+	}
+
+	// the pixel centers are at (i + 0.5, j + 0.5)
+	const double u  = std::min(std::max(x - 0.5, 0.0), width - 1.0);
+	const double v  = std::min(std::max(y - 0.5, 0.0), height - 1.0);
+	const int    x0 = static_cast<int>(u);
+	const int    y0 = static_cast<int>(v);
+	const int    x1 = std::min(x0 + 1, width - 1);
+	const int    y1 = std::min(y0 + 1, height - 1);
+	const double fx = u - x0;
+	const double fy = v - y0;
+
+	const QRgb c00 = image.pixel(x0, y0);
+	const QRgb c10 = image.pixel(x1, y0);
+	const QRgb c01 = image.pixel(x0, y1);
+	const QRgb c11 = image.pixel(x1, y1);
+
+	auto interpolate = [&](int (*channel)(QRgb))
+	{
+		const double value = (1.0 - fy) * ((1.0 - fx) * channel(c00) + fx * channel(c10))
+		                     + fy * ((1.0 - fx) * channel(c01) + fx * channel(c11));
+		return static_cast<int>(std::round(value));
+	};
+
+	rgb = qRgba(interpolate(qRed), interpolate(qGreen), interpolate(qBlue), interpolate(qAlpha));
+	return true;
+}
+
 ccImage* ccCameraSensor::orthoRectifyAsImageDirect(const ccImage*      image,
                                                    PointCoordinateType Z0,
                                                    double&             pixelSize,
                                                    bool                undistortImages /*=true*/,
                                                    double*             minCorner /*=nullptr*/,
                                                    double*             maxCorner /*=nullptr*/,
-                                                   double*             realCorners /*=nullptr*/) const
+                                                   double*             realCorners /*=nullptr*/,
+                                                   bool                bilinearInterpolation /*=false*/) const
 {
 	// first, we compute the ortho-rectified image corners
 	double corners[8];
@@ -1918,10 +2090,20 @@ ccImage* ccCameraSensor::orthoRectifyAsImageDirect(const ccImage*      image,
 	if (orthoImage.isNull()) // not enough memory!
 		return nullptr;
 
+	// the sensor transformation is the same for all the pixels
+	ccIndexedTransformation trans;
+	if (!getActiveAbsoluteTransformation(trans))
+		return nullptr;
+	const ccIndexedTransformation invTrans = trans.inverse();
+
 	const QRgb blackValue     = qRgb(0, 0, 0);
 	const QRgb blackAlphaZero = qRgba(0, 0, 0, 0);
 
-	for (unsigned i = 0; i < w; ++i)
+	uchar*    orthoBits         = orthoImage.bits();
+	const int orthoBytesPerLine = orthoImage.bytesPerLine();
+
+	// the columns are processed in parallel
+	auto processColumn = [&](int i)
 	{
 		PointCoordinateType xip = static_cast<PointCoordinateType>(minC[0] + i * _pixelSize);
 		for (unsigned j = 0; j < h; ++j)
@@ -1931,21 +2113,29 @@ ccImage* ccCameraSensor::orthoRectifyAsImageDirect(const ccImage*      image,
 			QRgb rgb = blackValue; // output pixel is (transparent) black by default
 
 			CCVector3 P3D(xip, yip, Z0);
+			invTrans.apply(P3D); // global to local coordinates
 			CCVector2 imageCoord;
-			if (fromGlobalCoordToImageCoord(P3D, imageCoord, undistortImages))
+			if (fromLocalCoordToImageCoord(P3D, imageCoord, undistortImages))
 			{
-				int x = static_cast<int>(imageCoord.x);
-				int y = static_cast<int>(imageCoord.y);
-				if (x >= 0 && x < width && y >= 0 && y < height)
-				{
-					rgb = image->data().pixel(x, y);
-				}
+				SampleImage(image->data(), imageCoord.x, imageCoord.y, bilinearInterpolation, rgb);
 			}
 
 			// pure black pixels are treated as transparent ones!
-			orthoImage.setPixel(i, h - 1 - j, rgb != blackValue ? rgb : blackAlphaZero);
+			reinterpret_cast<QRgb*>(orthoBits + (h - 1 - j) * orthoBytesPerLine)[i] = (rgb != blackValue ? rgb : blackAlphaZero);
 		}
+	};
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, static_cast<int>(w), processColumn);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int i = 0; i < static_cast<int>(w); ++i)
+	{
+		processColumn(i);
 	}
+#endif
 
 	// output pixel size (auto)
 	pixelSize = _pixelSize;
@@ -1959,7 +2149,8 @@ ccImage* ccCameraSensor::orthoRectifyAsImage(const ccImage*                  ima
                                              double&                         pixelSize,
                                              double*                         minCorner /*=nullptr*/,
                                              double*                         maxCorner /*=nullptr*/,
-                                             double*                         realCorners /*=nullptr*/) const
+                                             double*                         realCorners /*=nullptr*/,
+                                             bool                            bilinearInterpolation /*=false*/) const
 {
 	double a[3]{0.0, 0.0, 0.0};
 	double b[3]{0.0, 0.0, 0.0};
@@ -2073,7 +2264,11 @@ ccImage* ccCameraSensor::orthoRectifyAsImage(const ccImage*                  ima
 	const QRgb blackValue     = qRgb(0, 0, 0);
 	const QRgb blackAlphaZero = qRgba(0, 0, 0, 0);
 
-	for (unsigned i = 0; i < w; ++i)
+	uchar*    orthoBits         = orthoImage.bits();
+	const int orthoBytesPerLine = orthoImage.bytesPerLine();
+
+	// the columns are processed in parallel
+	auto processColumn = [&](int i)
 	{
 		double xip = minC[0] + static_cast<double>(i) * _pixelSize;
 		for (unsigned j = 0; j < h; ++j)
@@ -2083,28 +2278,30 @@ ccImage* ccCameraSensor::orthoRectifyAsImage(const ccImage*                  ima
 			double yip = minC[1] + static_cast<double>(j) * _pixelSize;
 			double q   = (c2 * xip - a2) * (c1 * yip - b1) - (c2 * yip - b2) * (c1 * xip - a1);
 			double p   = (a0 - xip) * (c1 * yip - b1) - (b0 - yip) * (c1 * xip - a1);
-			double yi  = p / q;
-			yi += halfHeight;
-			int y = static_cast<int>(yi);
+			double yi  = p / q + halfHeight;
 
-			if (y >= 0 && y < height)
-			{
-				q         = (c1 * xip - a1) * (c2 * yip - b2) - (c1 * yip - b1) * (c2 * xip - a2);
-				p         = (a0 - xip) * (c2 * yip - b2) - (b0 - yip) * (c2 * xip - a2);
-				double xi = p / q;
-				xi += halfWidth;
-				int x = static_cast<int>(xi);
+			q         = (c1 * xip - a1) * (c2 * yip - b2) - (c1 * yip - b1) * (c2 * xip - a2);
+			p         = (a0 - xip) * (c2 * yip - b2) - (b0 - yip) * (c2 * xip - a2);
+			double xi = p / q + halfWidth;
 
-				if (x >= 0 && x < width)
-				{
-					rgb = image->data().pixel(x, y);
-				}
-			}
+			SampleImage(image->data(), xi, yi, bilinearInterpolation, rgb);
 
 			// pure black pixels are treated as transparent ones!
-			orthoImage.setPixel(i, h - 1 - j, rgb != blackValue ? rgb : blackAlphaZero);
+			reinterpret_cast<QRgb*>(orthoBits + (h - 1 - j) * orthoBytesPerLine)[i] = (rgb != blackValue ? rgb : blackAlphaZero);
 		}
+	};
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, static_cast<int>(w), processColumn);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int i = 0; i < static_cast<int>(w); ++i)
+	{
+		processColumn(i);
 	}
+#endif
 
 	// output pixel size (auto)
 	pixelSize = _pixelSize;
@@ -2119,7 +2316,9 @@ bool ccCameraSensor::OrthoRectifyAsImages(std::vector<ccImage*>
                                           unsigned                                maxSize,
                                           QDir*                                   outputDir /*=nullptr*/,
                                           std::vector<ccImage*>*                  result /*=nullptr*/,
-                                          std::vector<std::pair<double, double>>* relativePos /*=nullptr*/)
+                                          std::vector<std::pair<double, double>>* relativePos /*=nullptr*/,
+                                          bool                                    bilinearInterpolation /*=false*/,
+                                          int                                     maxThreadCount /*=0*/)
 {
 	size_t count = images.size();
 	if (count == 0)
@@ -2255,13 +2454,34 @@ bool ccCameraSensor::OrthoRectifyAsImages(std::vector<ccImage*>
 		}
 	}
 
-	// projet each image accordingly
-	for (size_t k = 0; k < count; ++k)
+	// projet each image accordingly (the images are processed in parallel)
+	std::vector<ccImage*> orthoImages;
+	std::vector<QString>  logLines;
+	try
 	{
-		double* minC = &minCorners[2 * k];
-		double* maxC = &maxCorners[2 * k];
-		double  dx   = maxC[0] - minC[0];
-		double  dy   = maxC[1] - minC[1];
+		orthoImages.resize(count, nullptr);
+		logLines.resize(count);
+	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory
+		ccLog::Warning("[OrthoRectifyAsImages] Not enough memory!");
+		return false;
+	}
+
+	std::atomic<bool> notEnoughMemory(false);
+
+	auto processImage = [&](int k)
+	{
+		if (notEnoughMemory)
+		{
+			return;
+		}
+
+		const double* minC = &minCorners[2 * k];
+		const double* maxC = &maxCorners[2 * k];
+		double        dx   = maxC[0] - minC[0];
+		double        dy   = maxC[1] - minC[1];
 
 		ccImage* image  = images[k];
 		unsigned width  = images[k]->getW();
@@ -2272,17 +2492,8 @@ bool ccCameraSensor::OrthoRectifyAsImages(std::vector<ccImage*>
 		QImage orthoImage(w, h, QImage::Format_ARGB32);
 		if (orthoImage.isNull()) // not enough memory!
 		{
-			// clear mem.
-			if (result)
-			{
-				while (!result->empty())
-				{
-					delete result->back();
-					result->pop_back();
-				}
-			}
-			ccLog::Warning("[OrthoRectifyAsImages] Not enough memory!");
-			return false;
+			notEnoughMemory = true;
+			return;
 		}
 
 		// ortho rectification parameters
@@ -2296,12 +2507,16 @@ bool ccCameraSensor::OrthoRectifyAsImages(std::vector<ccImage*>
 		const double& c1 = c[k * 3 + 1];
 		const double& c2 = c[k * 3 + 2];
 
-		for (unsigned i = 0; i < w; ++i)
+		uchar*    orthoBits         = orthoImage.bits();
+		const int orthoBytesPerLine = orthoImage.bytesPerLine();
+
+		for (unsigned j = 0; j < h; ++j)
 		{
-			double xip = minC[0] + static_cast<double>(i) * pixelSize;
-			for (unsigned j = 0; j < h; ++j)
+			double yip      = minC[1] + static_cast<double>(j) * pixelSize;
+			QRgb*  orthoRow = reinterpret_cast<QRgb*>(orthoBits + (h - 1 - j) * orthoBytesPerLine);
+			for (unsigned i = 0; i < w; ++i)
 			{
-				double yip = minC[1] + static_cast<double>(j) * pixelSize;
+				double xip = minC[0] + static_cast<double>(i) * pixelSize;
 				double q   = (c2 * xip - a2) * (c1 * yip - b1) - (c2 * yip - b2) * (c1 * xip - a1);
 				double p   = (a0 - xip) * (c1 * yip - b1) - (b0 - yip) * (c1 * xip - a1);
 				double yi  = p / q;
@@ -2313,54 +2528,102 @@ bool ccCameraSensor::OrthoRectifyAsImages(std::vector<ccImage*>
 				xi += 0.5 * width;
 				yi += 0.5 * height;
 
-				int x = static_cast<int>(xi);
-				int y = static_cast<int>(yi);
-				if (x >= 0 && x < static_cast<int>(width) && y >= 0 && y < static_cast<int>(height))
+				QRgb rgb;
+				if (SampleImage(image->data(), xi, yi, bilinearInterpolation, rgb))
 				{
-					QRgb rgb = image->data().pixel(x, y);
 					// pure black pixels are treated as transparent ones!
 					if (qRed(rgb) + qGreen(rgb) + qBlue(rgb) > 0)
-						orthoImage.setPixel(i, h - 1 - j, rgb);
+						orthoRow[i] = rgb;
 					else
-						orthoImage.setPixel(i, h - 1 - j, qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), 0));
+						orthoRow[i] = qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), 0);
 				}
 				else
-					orthoImage.setPixel(i, h - 1 - j, qRgba(255, 0, 255, 0));
+					orthoRow[i] = qRgba(255, 0, 255, 0);
 			}
 		}
 
-		// eventually compute relative pos
-		if (relativePos)
-		{
-			double xShift = (minC[0] - minCorners[0]) / pixelSize;
-			double yShift = (minC[1] - minCorners[1]) / pixelSize;
-			relativePos->emplace_back(xShift, yShift);
-		}
-
 		if (outputDir)
 		{
-			// export image
+			// export image (as soon as it is ready)
 			QString exportFilename = QString("ortho_rectified_%1.png").arg(image->getName());
 			orthoImage.save(outputDir->absoluteFilePath(exportFilename));
 
-			// export meta-data
-			QFile f(outputDir->absoluteFilePath("ortho_rectification_log.txt"));
-			if (f.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) // always append
+			// prepare the meta-data (written afterwards, in the input order)
+			double      xShiftGlobal = (minC[0] - globalCorners[0]) / pixelSize;
+			double      yShiftGlobal = (minC[1] - globalCorners[1]) / pixelSize;
+			QTextStream stream(&logLines[k]);
+			stream.setRealNumberNotation(QTextStream::FixedNotation);
+			stream.setRealNumberPrecision(6);
+			stream << "Image" << ' ' << exportFilename << ' ';
+			stream << "Local3DBBox" << ' ' << minC[0] << ' ' << minC[1] << ' ' << maxC[0] << ' ' << maxC[1] << ' ';
+			stream << "Local2DBBox" << ' ' << xShiftGlobal << ' ' << yShiftGlobal << ' ' << xShiftGlobal + static_cast<double>(w - 1) << ' ' << yShiftGlobal + static_cast<double>(h - 1) << endl;
+		}
+
+		if (result)
+		{
+			try
 			{
-				double      xShiftGlobal = (minC[0] - globalCorners[0]) / pixelSize;
-				double      yShiftGlobal = (minC[1] - globalCorners[1]) / pixelSize;
-				QTextStream stream(&f);
-				stream.setRealNumberNotation(QTextStream::FixedNotation);
-				stream.setRealNumberPrecision(6);
-				stream << "Image" << ' ' << exportFilename << ' ';
-				stream << "Local3DBBox" << ' ' << minC[0] << ' ' << minC[1] << ' ' << maxC[0] << ' ' << maxC[1] << ' ';
-				stream << "Local2DBBox" << ' ' << xShiftGlobal << ' ' << yShiftGlobal << ' ' << xShiftGlobal + static_cast<double>(w - 1) << ' ' << yShiftGlobal + static_cast<double>(h - 1) << endl;
-				f.close();
+				orthoImages[k] = new ccImage(orthoImage, image->getName());
 			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+		}
+	};
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, static_cast<int>(count), processImage);
+#else
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+	for (int k = 0; k < static_cast<int>(count); ++k)
+	{
+		processImage(k);
+	}
+#endif
+
+	if (notEnoughMemory)
+	{
+		// clear mem.
+		for (ccImage* orthoImage : orthoImages)
+		{
+			delete orthoImage;
+		}
+		ccLog::Warning("[OrthoRectifyAsImages] Not enough memory!");
+		return false;
+	}
+
+	if (outputDir)
+	{
+		// export meta-data
+		QFile f(outputDir->absoluteFilePath("ortho_rectification_log.txt"));
+		if (f.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) // always append
+		{
+			QTextStream stream(&f);
+			for (const QString& line : logLines)
+			{
+				stream << line;
+			}
+			f.close();
+		}
+	}
+
+	for (size_t k = 0; k < count; ++k)
+	{
+		// eventually compute relative pos
+		if (relativePos)
+		{
+			const double* minC   = &minCorners[2 * k];
+			double        xShift = (minC[0] - minCorners[0]) / pixelSize;
+			double        yShift = (minC[1] - minCorners[1]) / pixelSize;
+			relativePos->emplace_back(xShift, yShift);
 		}
 
 		if (result)
-			result->push_back(new ccImage(orthoImage, image->getName()));
+			result->push_back(orthoImages[k]);
 	}
 
 	return true;
@@ -906,15 +906,16 @@ void ccGenericMesh::importParametersFrom(const ccGenericMesh* mesh)
 
 void ccGenericMesh::computeInterpolationWeights(unsigned triIndex, const CCVector3& P, CCVector3d& weights) const
 {
-	CCCoreLib::GenericTriangle* tri = const_cast<ccGenericMesh*>(this)->_getTriangle(triIndex);
-	const CCVector3*            A   = tri->_getA();
-	const CCVector3*            B   = tri->_getB();
-	const CCVector3*            C   = tri->_getC();
+	// we don't use _getTriangle here, as it relies on a temporary object (not thread-safe)
+	CCVector3 A;
+	CCVector3 B;
+	CCVector3 C;
+	getTriangleVertices(triIndex, A, B, C);
 
 	// barycentric interpolation weights
-	weights.x = ((P - *B).cross(*C - *B)).normd() /*/2*/;
-	weights.y = ((P - *C).cross(*A - *C)).normd() /*/2*/;
-	weights.z = ((P - *A).cross(*B - *A)).normd() /*/2*/;
+	weights.x = ((P - B).cross(C - B)).normd() /*/2*/;
+	weights.y = ((P - C).cross(A - C)).normd() /*/2*/;
+	weights.z = ((P - A).cross(B - A)).normd() /*/2*/;
 
 	// normalize weights
 	double sum = weights.x + weights.y + weights.z;
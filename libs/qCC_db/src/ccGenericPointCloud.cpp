@@ -64,6 +64,7 @@ void ccGenericPointCloud::clear()
 {
 	unallocateVisibilityArray();
 	deleteOctree();
+	deleteNearestNeighbourIndex();
 	enableTempColor(false);
 }
 
@@ -117,6 +118,32 @@ void ccGenericPointCloud::deleteOctree()
 	}
 }
 
+ccNearestNeighbourIndex::Shared ccGenericPointCloud::getNearestNeighbourIndex(bool autoCompute /*=true*/, CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	// the other callers wait for the index to be built (only once)
+	QMutexLocker locker(&m_nnIndexMutex);
+
+	if (m_nnIndex && m_nnIndex->size() != size())
+	{
+		// the cloud has changed since the index was built
+		m_nnIndex.clear();
+	}
+
+	if (!m_nnIndex && autoCompute)
+	{
+		m_nnIndex = ccNearestNeighbourIndex::Build(this, 0, progressCb);
+	}
+
+	return m_nnIndex;
+}
+
+void ccGenericPointCloud::deleteNearestNeighbourIndex()
+{
+	// the callers that already got the index keep a valid (shared) copy of it
+	QMutexLocker locker(&m_nnIndexMutex);
+	m_nnIndex.clear();
+}
+
 ccOctreeProxy* ccGenericPointCloud::getOctreeProxy() const
 {
 	for (auto child : m_children)
@@ -18,6 +18,7 @@
 #include "ccHObject.h"
 
 // Local
+#include "ccFrustum.h"
 #include "ccIncludeGL.h"
 
 // Objects handled by factory
@@ -34,6 +35,7 @@
 #include "ccExtru.h"
 #include "ccFacet.h"
 #include "ccGBLSensor.h"
+#include "ccGenericMesh.h"
 #include "ccImage.h"
 #include "ccMaterialSet.h"
 #include "ccMeshGroup.h"
@@ -47,6 +49,62 @@
 
 // Qt
 #include <QIcon>
+#include <QMutex>
+
+// System
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	//! Global unique ID index (see ccHObject::find)
+	struct UniqueIDIndex
+	{
+		QMutex                                        mutex;
+		std::unordered_multimap<unsigned, ccHObject*> objects;
+
+		void insert(unsigned uniqueID, ccHObject* object)
+		{
+			QMutexLocker locker(&mutex);
+			objects.emplace(uniqueID, object);
+		}
+
+		void remove(unsigned uniqueID, const ccHObject* object)
+		{
+			QMutexLocker locker(&mutex);
+			auto         range = objects.equal_range(uniqueID);
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				if (it->second == object)
+				{
+					objects.erase(it);
+					break;
+				}
+			}
+		}
+	};
+} // namespace
+
+static UniqueIDIndex& GetUniqueIDIndex()
+{
+	// never released, as entities may be destroyed after the static variables (at exit time)
+	static UniqueIDIndex* s_index = new UniqueIDIndex;
+	return *s_index;
+}
+
+//! Removes one of the holders of an entity (see ccHObject::m_holders)
+static void RemoveHolder(ccHObject::Container& holders, const ccHObject* holder)
+{
+	for (size_t i = 0; i < holders.size(); ++i)
+	{
+		if (holders[i] == holder)
+		{
+			holders.erase(holders.begin() + i);
+			break;
+		}
+	}
+}
 
 ccHObject::ccHObject(const QString& name, unsigned uniqueID /*=ccUniqueIDGenerator::InvalidUniqueID*/)
     : ccObject(name, uniqueID)
@@ -54,11 +112,16 @@ ccHObject::ccHObject(const QString& name, unsigned uniqueID /*=ccUniqueIDGenerat
     , m_parent(nullptr)
     , m_selectionBehavior(SELECTION_AA_BBOX)
     , m_isDeleting(false)
+    , m_subtreeRevision(1)
+    , m_drawOrderRevision(0)
+    , m_nameIn3DBBoxRevision(0)
 {
 	setVisible(false);
 	lockVisibility(true);
 
 	m_glTransHistory.toIdentity();
+
+	GetUniqueIDIndex().insert(getUniqueID(), this);
 }
 
 ccHObject::ccHObject(const ccHObject& object)
@@ -68,15 +131,30 @@ ccHObject::ccHObject(const ccHObject& object)
     , m_selectionBehavior(object.m_selectionBehavior)
     , m_glTransHistory(object.m_glTransHistory)
     , m_isDeleting(false)
+    , m_subtreeRevision(1)
+    , m_drawOrderRevision(0)
+    , m_nameIn3DBBoxRevision(0)
 {
+	GetUniqueIDIndex().insert(getUniqueID(), this);
 }
 
 ccHObject::~ccHObject()
 {
 	m_isDeleting = true;
 
+	GetUniqueIDIndex().remove(getUniqueID(), this);
+
+	// the children (if they survive) won't be held by this entity anymore
+	for (auto child : m_children)
+	{
+		RemoveHolder(child->m_holders, this);
+	}
+
 	// process dependencies
-	for (std::map<ccHObject*, int>::const_iterator it = m_dependencies.begin(); it != m_dependencies.end(); ++it)
+	// (the other entities may modify their own dependencies with this one in the meantime)
+	DependencyMap dependencies;
+	std::swap(dependencies, m_dependencies);
+	for (DependencyMap::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it)
 	{
 		assert(it->first);
 		// notify deletion to other object?
@@ -113,8 +191,48 @@ ccHObject::~ccHObject()
 	removeAllChildren();
 }
 
+void ccHObject::setUniqueID(unsigned ID)
+{
+	unsigned previousID = getUniqueID();
+
+	ccObject::setUniqueID(ID);
+
+	if (ID != previousID)
+	{
+		UniqueIDIndex& index = GetUniqueIDIndex();
+		index.remove(previousID, this);
+		index.insert(ID, this);
+	}
+}
+
+void ccHObject::invalidateDisplayCaches()
+{
+	m_drawOrder.clear();
+	incrementSubtreeRevision();
+}
+
+void ccHObject::incrementSubtreeRevision()
+{
+	// the caches of the entity and of all its ancestors are deprecated (but not the ones of the other branches)
+	for (ccHObject* obj = this; obj; obj = obj->m_parent)
+	{
+		++obj->m_subtreeRevision;
+	}
+}
+
+void ccHObject::setEnabled(bool state)
+{
+	if (state != isEnabled())
+	{
+		ccObject::setEnabled(state);
+		incrementSubtreeRevision(); // the parent bounding-boxes may have changed
+	}
+}
+
 void ccHObject::notifyGeometryUpdate()
 {
+	incrementSubtreeRevision();
+
 	// the associated display bounding-box is (potentially) deprecated!!!
 	if (m_currentDisplay)
 	{
@@ -123,15 +241,21 @@ void ccHObject::notifyGeometryUpdate()
 	}
 
 	// process dependencies
-	for (std::map<ccHObject*, int>::const_iterator it = m_dependencies.begin(); it != m_dependencies.end(); ++it)
+	// (the entities to notify are collected first, as they may modify the dependencies in the meantime)
+	Container toNotify;
+	for (DependencyMap::const_iterator it = m_dependencies.begin(); it != m_dependencies.end(); ++it)
 	{
 		assert(it->first);
-		// notify deletion to other object?
+		// notify update to other object?
 		if ((it->second & DP_NOTIFY_OTHER_ON_UPDATE) == DP_NOTIFY_OTHER_ON_UPDATE)
 		{
-			it->first->onUpdateOf(this);
+			toNotify.push_back(it->first);
 		}
 	}
+	for (ccHObject* obj : toNotify)
+	{
+		obj->onUpdateOf(this);
+	}
 }
 
 ccHObject* ccHObject::New(CC_CLASS_ENUM objectType, const char* name /*=nullptr*/)
@@ -273,7 +397,7 @@ void ccHObject::addDependency(ccHObject* otherObject, int flags, bool additive /
 	if (additive)
 	{
 		// look for already defined flags for this object
-		std::map<ccHObject*, int>::iterator it = m_dependencies.find(otherObject);
+		DependencyMap::iterator it = m_dependencies.find(otherObject);
 		if (it != m_dependencies.end())
 		{
 			// nothing changes? we stop here (especially to avoid infinite
@@ -295,7 +419,7 @@ void ccHObject::addDependency(ccHObject* otherObject, int flags, bool additive /
 
 int ccHObject::getDependencyFlagsWith(const ccHObject* otherObject) const
 {
-	std::map<ccHObject*, int>::const_iterator it = m_dependencies.find(const_cast<ccHObject*>(otherObject)); // DGM: not sure why erase won't accept a const pointer?! We try to modify the map here, not the pointer object!
+	DependencyMap::const_iterator it = m_dependencies.find(const_cast<ccHObject*>(otherObject)); // DGM: not sure why erase won't accept a const pointer?! We try to modify the map here, not the pointer object!
 
 	return (it != m_dependencies.end() ? it->second : 0);
 }
@@ -329,11 +453,18 @@ void ccHObject::onDeletionOf(const ccHObject* obj)
 	// modify the child contents!
 	removeDependencyWith(const_cast<ccHObject*>(obj)); // this method will only modify the dependency flags of obj
 
-	int pos = getChildIndex(obj);
-	if (pos >= 0)
+	// we only look for the object in the children list if it's actually held by this entity
+	// (to avoid scanning the whole list when the children are removed one after the other)
+	if (std::find(obj->m_holders.begin(), obj->m_holders.end(), this) != obj->m_holders.end())
 	{
-		// we can't swap children as we want to keep the order!
-		m_children.erase(m_children.begin() + pos);
+		int pos = getChildIndex(obj);
+		if (pos >= 0)
+		{
+			// we can't swap children as we want to keep the order!
+			m_children.erase(m_children.begin() + pos);
+			invalidateDisplayCaches();
+		}
+		RemoveHolder(const_cast<ccHObject*>(obj)->m_holders, this);
 	}
 }
 
@@ -359,6 +490,7 @@ bool ccHObject::addChild(ccHObject* child, int dependencyFlags /*=DP_PARENT_OF_O
 	// insert child
 	try
 	{
+		child->m_holders.reserve(child->m_holders.size() + 1);
 		if (insertIndex < 0 || static_cast<size_t>(insertIndex) >= m_children.size())
 			m_children.push_back(child);
 		else
@@ -369,6 +501,8 @@ bool ccHObject::addChild(ccHObject* child, int dependencyFlags /*=DP_PARENT_OF_O
 		// not enough memory!
 		return false;
 	}
+	child->m_holders.push_back(this);
+	invalidateDisplayCaches();
 
 	// we want to be notified whenever this child is deleted!
 	child->addDependency(this, DP_NOTIFY_OTHER_ON_DELETE); // DGM: potentially redundant with calls to 'addDependency' but we can't miss that ;)
@@ -423,19 +557,93 @@ ccHObject* ccHObject::find(unsigned uniqueID) const
 		return const_cast<ccHObject*>(this);
 	}
 
-	// otherwise we are going to test all children recursively
-	for (unsigned i = 0; i < getChildrenNumber(); ++i)
+	// otherwise we look for the entities with this ID (see the global index) that are in this object hierarchy
+	ccHObject* candidate = nullptr;
+	Container  otherCandidates;
 	{
-		ccHObject* match = getChild(i)->find(uniqueID);
-		if (match)
+		// the index is only locked while the candidates are copied (so as not to block
+		// the other lookups and registrations during the hierarchy walk)
+		UniqueIDIndex& index = GetUniqueIDIndex();
+		QMutexLocker   locker(&index.mutex);
+		auto           range = index.objects.equal_range(uniqueID);
+		for (auto it = range.first; it != range.second; ++it)
 		{
-			return match;
+			// the IDs are generally unique (no allocation in this case)
+			if (!candidate)
+			{
+				candidate = it->second;
+			}
+			else
+			{
+				otherCandidates.push_back(it->second);
+			}
+		}
+	}
+
+	if (candidate && isHolderOf(candidate))
+	{
+		return candidate;
+	}
+	for (ccHObject* otherCandidate : otherCandidates)
+	{
+		if (isHolderOf(otherCandidate))
+		{
+			return otherCandidate;
 		}
 	}
 
 	return nullptr;
 }
 
+bool ccHObject::isHolderOf(const ccHObject* anObject) const
+{
+	assert(anObject);
+
+	// we walk up the hierarchy: most entities only have one holder (their parent),
+	// in which case the chain is followed without any allocation
+	const ccHObject* obj = anObject;
+	while (obj->m_holders.size() == 1)
+	{
+		obj = obj->m_holders.front();
+		if (obj == this)
+		{
+			return true;
+		}
+	}
+	if (obj->m_holders.empty())
+	{
+		// root of the hierarchy
+		return false;
+	}
+
+	// otherwise (an entity may be the child of several other entities) each holder
+	// is only visited once, as the hierarchy can be a DAG with shared branches
+	std::vector<const ccHObject*>        toVisit(obj->m_holders.begin(), obj->m_holders.end());
+	std::unordered_set<const ccHObject*> visited;
+	while (!toVisit.empty())
+	{
+		const ccHObject* holder = toVisit.back();
+		toVisit.pop_back();
+		if (holder == this)
+		{
+			return true;
+		}
+		if (!visited.insert(holder).second)
+		{
+			continue;
+		}
+		for (const ccHObject* nextHolder : holder->m_holders)
+		{
+			if (visited.find(nextHolder) == visited.end())
+			{
+				toVisit.push_back(nextHolder);
+			}
+		}
+	}
+
+	return false;
+}
+
 unsigned ccHObject::filterChildren(Container&          filteredChildren,
                                    bool                recursive /*=false*/,
                                    CC_CLASS_ENUM       filter /*=CC_TYPES::OBJECT*/,
@@ -503,6 +711,7 @@ void ccHObject::transferChildren(ccHObject& newParent, bool forceFatherDependent
 		// we must explicitly remove any dependency with the child as we don't call 'detachChild'
 		removeDependencyWith(child);
 		child->removeDependencyWith(this);
+		RemoveHolder(child->m_holders, this);
 
 		newParent.addChild(child, fatherDependencyFlags);
 		child->addDependency(&newParent, childDependencyFlags);
@@ -511,6 +720,7 @@ void ccHObject::transferChildren(ccHObject& newParent, bool forceFatherDependent
 		assert(child->getParent() == &newParent || child->getParent() == nullptr);
 	}
 	m_children.clear();
+	invalidateDisplayCaches();
 }
 
 void ccHObject::swapChildren(unsigned firstChildIndex, unsigned secondChildIndex)
@@ -519,6 +729,7 @@ void ccHObject::swapChildren(unsigned firstChildIndex, unsigned secondChildIndex
 	assert(secondChildIndex < m_children.size());
 
 	std::swap(m_children[firstChildIndex], m_children[secondChildIndex]);
+	invalidateDisplayCaches();
 }
 
 int ccHObject::getIndex() const
@@ -720,6 +931,123 @@ void ccHObject::drawNameIn3D(CC_DRAW_CONTEXT& context)
 	}
 }
 
+bool ccHObject::isOutOfViewFrustum(const CC_DRAW_CONTEXT& context)
+{
+	if (!context.viewFrustum)
+	{
+		return false;
+	}
+
+	// the bounding-boxes are cached by the entities themselves
+	ccBBox box = getOwnBB(true); // with the OpenGL features (as some entities are purely 'GL'!)
+	if (!box.isValid())
+	{
+		return false;
+	}
+	if (context.viewFrustumTrans)
+	{
+		box = box * (*context.viewFrustumTrans);
+	}
+
+	const CCVector3& minC = box.minCorner();
+	const CCVector3& maxC = box.maxCorner();
+	AABox            aaBox(CCVector3f(static_cast<float>(minC.x), static_cast<float>(minC.y), static_cast<float>(minC.z)),
+	                       CCVector3f(static_cast<float>(maxC.x), static_cast<float>(maxC.y), static_cast<float>(maxC.z)));
+
+	return (context.viewFrustum->boxInFrustum(aaBox) == Frustum::OUTSIDE);
+}
+
+//! Returns whether an entity can be moved in the children drawing order (see ccHObject::updateDrawOrder)
+static bool IsOpaque3DEntity(const ccHObject* entity)
+{
+	if (entity->isKindOf(CC_TYPES::POINT_CLOUD))
+	{
+		return true;
+	}
+
+	if (entity->isKindOf(CC_TYPES::MESH))
+	{
+		// transparent materials must be drawn in the original order (blending)
+		const ccMaterialSet* materials = static_cast<const ccGenericMesh*>(entity)->getMaterialSet();
+		if (materials)
+		{
+			for (const ccMaterial::CShared& material : *materials)
+			{
+				if (material && (material->getDiffuseFront().a < 1.0f || material->getDiffuseBack().a < 1.0f))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	return false;
+}
+
+void ccHObject::updateDrawOrder()
+{
+	m_drawOrder.clear();
+	m_drawOrderRevision = m_subtreeRevision;
+
+	size_t count = m_children.size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	// drawing state of each child (type, then material set ID)
+	std::vector<std::pair<CC_CLASS_ENUM, unsigned>> keys;
+	std::vector<bool>                                 sortable;
+	try
+	{
+		keys.resize(count);
+		sortable.resize(count);
+		m_drawOrder.resize(count);
+	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory: we'll keep the original order
+		m_drawOrder.clear();
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const ccHObject* child = m_children[i];
+		sortable[i]            = IsOpaque3DEntity(child);
+		if (sortable[i])
+		{
+			const ccMaterialSet* materials = child->isKindOf(CC_TYPES::MESH) ? static_cast<const ccGenericMesh*>(child)->getMaterialSet() : nullptr;
+			keys[i]                        = {child->getClassID(), materials ? materials->getUniqueID() : 0};
+		}
+	}
+
+	std::iota(m_drawOrder.begin(), m_drawOrder.end(), 0u);
+
+	// only the runs of consecutive opaque 3D children are sorted
+	for (size_t runStart = 0; runStart < count;)
+	{
+		if (!sortable[runStart])
+		{
+			++runStart;
+			continue;
+		}
+
+		size_t runEnd = runStart + 1;
+		while (runEnd < count && sortable[runEnd])
+		{
+			++runEnd;
+		}
+
+		// the insertion order is the tie-breaker
+		std::sort(m_drawOrder.begin() + runStart, m_drawOrder.begin() + runEnd, [&keys](unsigned a, unsigned b)
+		          { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); });
+
+		runStart = runEnd;
+	}
+}
+
 void ccHObject::draw(CC_DRAW_CONTEXT& context)
 {
 	if (!isEnabled())
@@ -738,6 +1066,10 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 	// the entity must be either visible or selected, and of course it should be displayed in this context
 	bool drawInThisContext = ((m_visible || m_selected) && m_currentDisplay == context.display);
 
+	// cumulated GL transformation (for frustum culling)
+	const ccGLMatrix* parentFrustumTrans = context.viewFrustumTrans;
+	ccGLMatrix        frustumTrans;
+
 	if (draw3D)
 	{
 		// apply 3D 'temporary' transformation (for display only)
@@ -746,6 +1078,12 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 			glFunc->glMatrixMode(GL_MODELVIEW);
 			glFunc->glPushMatrix();
 			glFunc->glMultMatrixf(m_glTrans.data());
+
+			if (context.viewFrustum)
+			{
+				frustumTrans             = (parentFrustumTrans ? *parentFrustumTrans * m_glTrans : m_glTrans);
+				context.viewFrustumTrans = &frustumTrans;
+			}
 		}
 
 		// LOD for clouds is enabled?
@@ -760,7 +1098,11 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 	// draw entity
 	if (m_visible && drawInThisContext)
 	{
-		if ((!m_selected || !MACRO_SkipSelected(context)) && (m_selected || !MACRO_SkipUnselected(context)))
+		if (draw3D && isOutOfViewFrustum(context))
+		{
+			++context.culledEntityCount;
+		}
+		else if ((!m_selected || !MACRO_SkipSelected(context)) && (m_selected || !MACRO_SkipUnselected(context)))
 		{
 			// apply default color (in case of)
 			ccGL::Color(glFunc, context.pointsDefaultCol);
@@ -779,6 +1121,11 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 			{
 				toggleClipPlanes(context, false);
 			}
+
+			if (draw3D)
+			{
+				++context.drawnEntityCount;
+			}
 		}
 	}
 
@@ -788,7 +1135,13 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 		if (MACRO_Draw3D(context))
 		{
 			// we have to compute the 2D position during the 3D pass!
-			ccBBox bBox = getBB_recursive(true); // DGM: take the OpenGL features into account (as some entities are purely 'GL'!)
+			// (the bounding-box is only updated if the geometry or the hierarchy has changed)
+			if (m_nameIn3DBBoxRevision != m_subtreeRevision)
+			{
+				m_nameIn3DBBox         = getBB_recursive(true); // DGM: take the OpenGL features into account (as some entities are purely 'GL'!)
+				m_nameIn3DBBoxRevision = m_subtreeRevision;
+			}
+			const ccBBox& bBox = m_nameIn3DBBox;
 			if (bBox.isValid())
 			{
 				ccGLCameraParameters camera;
@@ -811,10 +1164,25 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 		}
 	}
 
-	// draw entity's children
-	for (auto child : m_children)
+	// draw entity's children (grouped by drawing state during the opaque 3D pass only)
+	bool sortChildren = (draw3D && !MACRO_Foreground(context) && !MACRO_EntityPicking(context) && m_children.size() > 1);
+	if (sortChildren && (m_drawOrder.size() != m_children.size() || m_drawOrderRevision != m_subtreeRevision))
+	{
+		updateDrawOrder();
+	}
+	if (sortChildren && m_drawOrder.size() == m_children.size())
 	{
-		child->draw(context);
+		for (unsigned childIndex : m_drawOrder)
+		{
+			m_children[childIndex]->draw(context);
+		}
+	}
+	else
+	{
+		for (auto child : m_children)
+		{
+			child->draw(context);
+		}
 	}
 
 	// if the entity is currently selected, we draw its bounding-box
@@ -824,12 +1192,16 @@ void ccHObject::draw(CC_DRAW_CONTEXT& context)
 	}
 
 	if (draw3D && m_glTransEnabled)
+	{
 		glFunc->glPopMatrix();
+		context.viewFrustumTrans = parentFrustumTrans;
+	}
 }
 
 void ccHObject::applyGLTransformation(const ccGLMatrix& trans)
 {
 	m_glTransHistory = trans * m_glTransHistory;
+	incrementSubtreeRevision();
 }
 
 void ccHObject::applyGLTransformation_recursive(const ccGLMatrix* transInput /*=nullptr*/)
@@ -903,6 +1275,8 @@ void ccHObject::detachChild(ccHObject* child)
 	{
 		// we can't swap children as we want to keep the order!
 		m_children.erase(m_children.begin() + pos);
+		RemoveHolder(child->m_holders, this);
+		invalidateDisplayCaches();
 	}
 }
 
@@ -913,6 +1287,7 @@ void ccHObject::detachAllChildren()
 		// remove any dependency (bilateral)
 		removeDependencyWith(child);
 		child->removeDependencyWith(this);
+		RemoveHolder(child->m_holders, this);
 
 		if (child->getParent() == this)
 		{
@@ -920,6 +1295,7 @@ void ccHObject::detachAllChildren()
 		}
 	}
 	m_children.clear();
+	invalidateDisplayCaches();
 }
 
 void ccHObject::removeChild(ccHObject* child)
@@ -945,6 +1321,8 @@ void ccHObject::removeChild(int pos)
 	//(DGM: do this BEFORE deleting the object (otherwise
 	// the dependency mechanism can 'backfire' ;)
 	m_children.erase(m_children.begin() + pos);
+	RemoveHolder(child->m_holders, this);
+	invalidateDisplayCaches();
 
 	// backup dependency flags
 	int flags = getDependencyFlagsWith(child);
@@ -985,6 +1363,11 @@ void ccHObject::removeAllChildren()
 	{
 		ccHObject* child = m_children.back();
 		m_children.pop_back();
+		invalidateDisplayCaches();
+		if (!m_isDeleting) // otherwise the holders have already been updated (and the child may already be deleted)
+		{
+			RemoveHolder(child->m_holders, this);
+		}
 
 		int flags = getDependencyFlagsWith(child);
 		if ((flags & DP_DELETE_OTHER) == DP_DELETE_OTHER)
@@ -20,6 +20,9 @@
 // CCCoreLib
 #include <ReferenceCloud.h>
 
+// Qt
+#include <QCoreApplication>
+
 // local
 #include "ccLog.h"
 #include "ccOctree.h"
@@ -28,11 +31,25 @@
 #include "ccScalarField.h"
 
 // system
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <map>
 #include <queue>
 #include <set>
 #include <vector>
 
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_for.h>
+#endif
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 namespace
 {
 	//! Weighted graph edge
@@ -499,9 +516,385 @@ static bool ComputeMSTGraphAtLevel(const CCCoreLib::DgmOctree::octreeCell& cell,
 }
 #endif
 
+namespace
+{
+	using KNNGraph = ccMinimumSpanningTreeForNormsDirection::KNNGraph;
+
+	//! Returns the (MST) weight of an edge
+	inline float EdgeWeight(const CCVector3& N1, const CCVector3& N2)
+	{
+		// dot product
+		return std::max(0.0f, 1.0f - static_cast<float>(std::abs(N1.dot(N2))));
+	}
+
+	//! Returns the root of a vertex in a union-find structure (with path halving)
+	inline unsigned FindRoot(std::vector<unsigned>& parents, unsigned v)
+	{
+		while (parents[v] != v)
+		{
+			parents[v] = parents[parents[v]];
+			v          = parents[v];
+		}
+		return v;
+	}
+
+	//! Atomically replaces a value by a smaller one
+	inline void AtomicMin(std::atomic<uint64_t>& value, uint64_t candidate)
+	{
+		uint64_t current = value.load(std::memory_order_relaxed);
+		while (candidate < current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+		{
+		}
+	}
+} // namespace
+
+//! Builds the kNN graph of a cloud (in parallel)
+static bool BuildKNNGraph(ccPointCloud*                       cloud,
+                          const ccOctree::Shared&             octree,
+                          unsigned char                       level,
+                          unsigned                            kNN,
+                          int                                 maxThreadCount,
+                          KNNGraph&                           graph,
+                          CCCoreLib::GenericProgressCallback* progressCb)
+{
+	unsigned vertexCount = cloud->size();
+
+	// at most kNN neighbors per vertex (in a first time, each vertex has kNN slots)
+	graph.firstEdge.resize(static_cast<size_t>(vertexCount) + 1);
+	graph.targets.resize(static_cast<size_t>(vertexCount) * kNN);
+	graph.weights.resize(static_cast<size_t>(vertexCount) * kNN);
+
+	// the points are processed by chunks, in the octree order (for a better spatial coherence)
+	static const unsigned                       s_chunkSize = 4096;
+	const CCCoreLib::DgmOctree::cellsContainer& codes       = octree->pointsAndTheirCellCodes();
+	const unsigned                              chunkCount  = (vertexCount + s_chunkSize - 1) / s_chunkSize;
+
+	CCCoreLib::NormalizedProgress nProgress(progressCb, chunkCount);
+	if (progressCb)
+	{
+		progressCb->update(0);
+		progressCb->setMethodTitle(QObject::tr("Orient normals (MST)"));
+		progressCb->setInfo(QObject::tr("Compute kNN graph\nPoints: %1").arg(vertexCount));
+		progressCb->start();
+	}
+
+	std::atomic<bool> notEnoughMemory(false);
+	std::atomic<bool> cancelled(false);
+
+	auto processChunk = [&](int chunkIndex)
+	{
+		if (notEnoughMemory || cancelled)
+		{
+			return;
+		}
+
+		try
+		{
+			CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
+			nNSS.level                = level;
+			nNSS.minNumberOfNeighbors = kNN + 1; //+1 because we'll get the query point itself!
+
+			unsigned firstPoint = chunkIndex * s_chunkSize;
+			unsigned lastPoint  = std::min(firstPoint + s_chunkSize, vertexCount);
+			for (unsigned k = firstPoint; k < lastPoint; ++k)
+			{
+				unsigned         index = codes[k].theIndex;
+				const CCVector3* P     = cloud->getPoint(index);
+				nNSS.queryPoint        = *P;
+				octree->getTheCellPosWhichIncludesThePoint(P, nNSS.cellPos, level);
+				octree->computeCellCenter(nNSS.cellPos, level, nNSS.cellCenter);
+				nNSS.pointsInNeighbourhood.clear();
+				nNSS.alreadyVisitedNeighbourhoodSize = 0;
+
+				// look for neighbors in a sphere
+				unsigned neighborCount = octree->findNearestNeighborsStartingFromCell(nNSS, false);
+				neighborCount          = std::min(neighborCount, kNN + 1);
+
+				const CCVector3& N1         = cloud->getPointNormal(index);
+				size_t           edgeIndex  = static_cast<size_t>(index) * kNN;
+				unsigned         edgeCount  = 0;
+				for (unsigned j = 0; j < neighborCount && edgeCount < kNN; ++j)
+				{
+					unsigned neighborIndex = nNSS.pointsInNeighbourhood[j].pointIndex;
+					if (neighborIndex != index)
+					{
+						graph.targets[edgeIndex + edgeCount] = neighborIndex;
+						graph.weights[edgeIndex + edgeCount] = EdgeWeight(N1, cloud->getPointNormal(neighborIndex));
+						++edgeCount;
+					}
+				}
+				graph.firstEdge[index + 1] = edgeCount; // temporarily store the edge count
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+			return;
+		}
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	};
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, static_cast<int>(chunkCount), processChunk);
+#else
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+	for (int chunkIndex = 0; chunkIndex < static_cast<int>(chunkCount); ++chunkIndex)
+	{
+		processChunk(chunkIndex);
+	}
+#endif
+
+	if (notEnoughMemory)
+	{
+		throw std::bad_alloc();
+	}
+	if (cancelled)
+	{
+		return false;
+	}
+
+	// compact the edges (CSR layout)
+	graph.firstEdge[0] = 0;
+	for (unsigned i = 0; i < vertexCount; ++i)
+	{
+		unsigned edgeCount     = graph.firstEdge[i + 1];
+		unsigned firstEdge     = graph.firstEdge[i];
+		graph.firstEdge[i + 1] = firstEdge + edgeCount;
+		if (firstEdge != static_cast<size_t>(i) * kNN && edgeCount != 0)
+		{
+			memmove(graph.targets.data() + firstEdge, graph.targets.data() + static_cast<size_t>(i) * kNN, edgeCount * sizeof(unsigned));
+			memmove(graph.weights.data() + firstEdge, graph.weights.data() + static_cast<size_t>(i) * kNN, edgeCount * sizeof(float));
+		}
+	}
+	graph.targets.resize(graph.firstEdge.back());
+	graph.targets.shrink_to_fit();
+	graph.weights.resize(graph.firstEdge.back());
+	graph.weights.shrink_to_fit();
+
+	return true;
+}
+
+void ccMinimumSpanningTreeForNormsDirection::ComputeMinimumSpanningForest(const KNNGraph&                             graph,
+                                                                          int                                         maxThreadCount,
+                                                                          std::vector<std::pair<unsigned, unsigned>>& treeEdges)
+{
+	const unsigned vertexCount = static_cast<unsigned>(graph.firstEdge.size() - 1);
+	const uint64_t noEdge      = std::numeric_limits<uint64_t>::max();
+
+	// union-find structure
+	std::vector<unsigned> parents(vertexCount);
+	for (unsigned i = 0; i < vertexCount; ++i)
+	{
+		parents[i] = i;
+	}
+	// component of each vertex (i.e. the root of the union-find structure)
+	std::vector<unsigned> components(parents);
+	// best (lightest) edge of each component: weight bits (high) + edge index (low), so that ties are consistently broken
+	std::vector<std::atomic<uint64_t>> bestEdges(vertexCount);
+
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#endif
+
+	treeEdges.reserve(vertexCount);
+
+	while (true)
+	{
+		auto findBestEdges = [&](int i)
+		{
+			unsigned component = components[i];
+			for (unsigned e = graph.firstEdge[i]; e < graph.firstEdge[i + 1]; ++e)
+			{
+				unsigned neighborComponent = components[graph.targets[e]];
+				if (neighborComponent != component)
+				{
+					uint32_t weightBits;
+					memcpy(&weightBits, &graph.weights[e], sizeof(float)); // positive floats are ordered as their bits
+					uint64_t key = (static_cast<uint64_t>(weightBits) << 32) | e;
+					AtomicMin(bestEdges[component], key);
+					AtomicMin(bestEdges[neighborComponent], key);
+				}
+			}
+		};
+
+		for (std::atomic<uint64_t>& bestEdge : bestEdges)
+		{
+			bestEdge.store(noEdge, std::memory_order_relaxed);
+		}
+
+#ifdef CC_CORE_LIB_USES_TBB
+		tbb::parallel_for(0, static_cast<int>(vertexCount), findBestEdges);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 4096) num_threads(threadCount)
+#endif
+		for (int i = 0; i < static_cast<int>(vertexCount); ++i)
+		{
+			findBestEdges(i);
+		}
+#endif
+
+		// merge the components along their best edge
+		size_t previousTreeEdgeCount = treeEdges.size();
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			uint64_t key = bestEdges[i].load(std::memory_order_relaxed);
+			if (key == noEdge)
+			{
+				continue;
+			}
+
+			unsigned e     = static_cast<unsigned>(key & 0xFFFFFFFF);
+			unsigned v1    = graph.source(e);
+			unsigned v2    = graph.targets[e];
+			unsigned root1 = FindRoot(parents, v1);
+			unsigned root2 = FindRoot(parents, v2);
+			if (root1 != root2)
+			{
+				parents[root2] = root1;
+				treeEdges.emplace_back(v1, v2);
+			}
+		}
+
+		if (treeEdges.size() == previousTreeEdgeCount)
+		{
+			// no more edge between components
+			break;
+		}
+
+		// update the components
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			components[i] = FindRoot(parents, i);
+		}
+	}
+}
+
+//! Orients the normals with a Minimum Spanning Tree (computed in parallel on a compact kNN graph)
+static bool OrientNormalsWithParallelMST(ccPointCloud*           cloud,
+                                         const ccOctree::Shared& octree,
+                                         unsigned char           level,
+                                         unsigned                kNN,
+                                         int                     maxThreadCount,
+                                         ccProgressDialog*       progressCb)
+{
+	unsigned vertexCount = cloud->size();
+
+	// spanning forest edges
+	std::vector<std::pair<unsigned, unsigned>> treeEdges;
+	{
+		KNNGraph graph;
+		if (!BuildKNNGraph(cloud, octree, level, kNN, maxThreadCount, graph, progressCb))
+		{
+			// process cancelled by the user
+			if (progressCb)
+			{
+				progressCb->stop();
+			}
+			return false;
+		}
+
+		if (progressCb)
+		{
+			progressCb->setInfo(QObject::tr("Compute Minimum spanning tree\nPoints: %1\nEdges: %2").arg(vertexCount).arg(graph.targets.size()));
+			QCoreApplication::processEvents();
+		}
+
+		ccMinimumSpanningTreeForNormsDirection::ComputeMinimumSpanningForest(graph, maxThreadCount, treeEdges);
+	}
+
+	// tree structure (CSR layout)
+	std::vector<unsigned> firstNeighbor(static_cast<size_t>(vertexCount) + 1, 0);
+	std::vector<unsigned> neighbors(treeEdges.size() * 2);
+	{
+		for (const std::pair<unsigned, unsigned>& edge : treeEdges)
+		{
+			++firstNeighbor[edge.first + 1];
+			++firstNeighbor[edge.second + 1];
+		}
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			firstNeighbor[i + 1] += firstNeighbor[i];
+		}
+		std::vector<unsigned> fillIndexes(firstNeighbor.begin(), firstNeighbor.end() - 1);
+		for (const std::pair<unsigned, unsigned>& edge : treeEdges)
+		{
+			neighbors[fillIndexes[edge.first]++]  = edge.second;
+			neighbors[fillIndexes[edge.second]++] = edge.first;
+		}
+		treeEdges = std::vector<std::pair<unsigned, unsigned>>(); // release memory
+	}
+
+	if (progressCb)
+	{
+		progressCb->setInfo(QObject::tr("Orient normals\nPoints: %1").arg(vertexCount));
+		QCoreApplication::processEvents();
+	}
+
+	// propagate the orientation along the trees (breadth first)
+	std::vector<bool>     visited(vertexCount, false);
+	std::vector<unsigned> queue;
+	queue.reserve(vertexCount);
+	size_t patchCount     = 0;
+	size_t inversionCount = 0;
+	for (unsigned root = 0; root < vertexCount; ++root)
+	{
+		if (visited[root])
+		{
+			continue;
+		}
+
+		// new patch
+		++patchCount;
+		visited[root] = true;
+		queue.clear();
+		queue.push_back(root);
+		for (size_t q = 0; q < queue.size(); ++q)
+		{
+			unsigned         v  = queue[q];
+			const CCVector3& N1 = cloud->getPointNormal(v);
+			for (unsigned n = firstNeighbor[v]; n < firstNeighbor[v + 1]; ++n)
+			{
+				unsigned w = neighbors[n];
+				if (visited[w])
+				{
+					continue;
+				}
+				visited[w] = true;
+
+				// shall the normal be inverted?
+				const CCVector3& N2 = cloud->getPointNormal(w);
+				if (N1.dot(N2) < 0)
+				{
+					cloud->setPointNormal(w, -N2);
+					++inversionCount;
+				}
+				queue.push_back(w);
+			}
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	ccLog::Print(QString("[OrientNormalsWithParallelMST] Patches = %1 / Inversions: %2").arg(patchCount).arg(inversionCount));
+
+	return true;
+}
+
 bool ccMinimumSpanningTreeForNormsDirection::OrientNormals(ccPointCloud*     cloud,
                                                            unsigned          kNN /*=6*/,
-                                                           ccProgressDialog* progressDlg /*=nullptr*/)
+                                                           ccProgressDialog* progressDlg /*=nullptr*/,
+                                                           int               maxThreadCount /*=0*/)
 {
 	assert(cloud);
 	if (!cloud->hasNormals())
@@ -562,7 +955,26 @@ bool ccMinimumSpanningTreeForNormsDirection::OrientNormals(ccPointCloud*     clo
 			}
 		}
 #else
-		if (!ResolveNormalsWithMST(cloud, octree, level, kNN, progressDlg))
+		// the parallel engine needs the whole kNN graph (with 32 bits edge indexes)
+		bool useParallelMST = (static_cast<uint64_t>(cloud->size()) * kNN < std::numeric_limits<unsigned>::max());
+		if (useParallelMST)
+		{
+			try
+			{
+				if (!OrientNormalsWithParallelMST(cloud, octree, level, kNN, maxThreadCount, progressDlg))
+				{
+					// process cancelled by the user
+					return false;
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				ccLog::Warning(QString("[orientNormalsWithMST] Not enough memory to build the whole kNN graph of cloud '%1': the slower (but lighter) sequential method will be used").arg(cloud->getName()));
+				useParallelMST = false;
+			}
+		}
+
+		if (!useParallelMST && !ResolveNormalsWithMST(cloud, octree, level, kNN, progressDlg))
 		{
 			// something went wrong
 			ccLog::Warning(QString("Failed to resolve normals orientation with Minimum Spanning Tree on cloud '%1'").arg(cloud->getName()));
@@ -0,0 +1,465 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_for.h>
+#endif
+
+#include "ccNearestNeighbourIndex.h"
+
+// CCCoreLib
+#include <GenericIndexedCloud.h>
+#include <GenericProgressCallback.h>
+
+// Qt
+#include <QString>
+
+// System
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+namespace
+{
+	//! Point + original index (used during the tree construction)
+	struct IndexedPoint
+	{
+		CCVector3 P;
+		unsigned  index;
+	};
+
+	//! Single nearest neighbour search result
+	struct NearestNeighbourResult
+	{
+		PointCoordinateType squareDist = std::numeric_limits<PointCoordinateType>::max();
+		int                 index      = -1;
+
+		inline PointCoordinateType worstSquareDist() const
+		{
+			return squareDist;
+		}
+
+		//! Should only be called if d2 < worstSquareDist()
+		inline void add(PointCoordinateType d2, unsigned pointIndex)
+		{
+			squareDist = d2;
+			index      = static_cast<int>(pointIndex);
+		}
+	};
+
+	//! K nearest neighbours search result (max-heap)
+	struct KNNResult
+	{
+		KNNResult(std::vector<std::pair<PointCoordinateType, unsigned>>& _heap, unsigned _k, PointCoordinateType _maxSquareDist)
+		    : heap(_heap)
+		    , k(_k)
+		    , maxSquareDist(_maxSquareDist)
+		{
+		}
+
+		inline PointCoordinateType worstSquareDist() const
+		{
+			return heap.size() < k ? maxSquareDist : heap.front().first;
+		}
+
+		//! Should only be called if d2 < worstSquareDist()
+		inline void add(PointCoordinateType d2, unsigned pointIndex)
+		{
+			if (heap.size() == k)
+			{
+				std::pop_heap(heap.begin(), heap.end());
+				heap.back() = {d2, pointIndex};
+			}
+			else
+			{
+				heap.emplace_back(d2, pointIndex);
+			}
+			std::push_heap(heap.begin(), heap.end());
+		}
+
+		std::vector<std::pair<PointCoordinateType, unsigned>>& heap;
+		unsigned                                                k;
+		PointCoordinateType                                     maxSquareDist;
+	};
+
+	//! Neighbours inside a sphere search result
+	struct SphereResult
+	{
+		SphereResult(std::vector<std::pair<PointCoordinateType, unsigned>>& _neighbours, PointCoordinateType _squareRadius)
+		    : neighbours(_neighbours)
+		    , squareRadius(_squareRadius)
+		{
+		}
+
+		inline PointCoordinateType worstSquareDist() const
+		{
+			return squareRadius;
+		}
+
+		//! Should only be called if d2 < worstSquareDist()
+		inline void add(PointCoordinateType d2, unsigned pointIndex)
+		{
+			neighbours.emplace_back(d2, pointIndex);
+		}
+
+		std::vector<std::pair<PointCoordinateType, unsigned>>& neighbours;
+		PointCoordinateType                                     squareRadius;
+	};
+} // namespace
+
+ccNearestNeighbourIndex::ccNearestNeighbourIndex()
+    : m_depth(0)
+    , m_bbMin(0, 0, 0)
+    , m_bbMax(0, 0, 0)
+{
+}
+
+ccNearestNeighbourIndex::Shared ccNearestNeighbourIndex::Build(CCCoreLib::GenericIndexedCloud*     cloud,
+                                                               int                                 maxThreadCount /*=0*/,
+                                                               CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	if (!cloud || cloud->size() == 0)
+	{
+		return {};
+	}
+
+	const unsigned pointCount = cloud->size();
+
+	// the tree is deep enough so that each leaf contains at most MAX_LEAF_SIZE points
+	unsigned depth = 0;
+	while (((pointCount - 1) >> depth) + 1 > MAX_LEAF_SIZE)
+	{
+		++depth;
+	}
+
+	Shared                                    index(new ccNearestNeighbourIndex);
+	std::vector<IndexedPoint>                 points;
+	std::vector<std::pair<unsigned, unsigned>> ranges;
+	std::vector<std::pair<unsigned, unsigned>> nextRanges;
+	try
+	{
+		points.resize(pointCount);
+		for (std::vector<PointCoordinateType>& coords : index->m_coords)
+		{
+			coords.resize(pointCount);
+		}
+		index->m_indexes.resize(pointCount);
+		index->m_splitValues.resize((static_cast<size_t>(1) << depth) - 1);
+		index->m_splitDims.resize(index->m_splitValues.size());
+		ranges.reserve(static_cast<size_t>(1) << depth);
+		nextRanges.reserve(ranges.capacity());
+	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory
+		return {};
+	}
+	index->m_depth = depth;
+
+	// copy the points (and compute the bounding-box)
+	{
+		const CCVector3* P = cloud->getPoint(0);
+		index->m_bbMin     = index->m_bbMax = *P;
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			P         = cloud->getPoint(i);
+			points[i] = {*P, i};
+			for (unsigned char d = 0; d < 3; ++d)
+			{
+				index->m_bbMin.u[d] = std::min(index->m_bbMin.u[d], P->u[d]);
+				index->m_bbMax.u[d] = std::max(index->m_bbMax.u[d], P->u[d]);
+			}
+		}
+	}
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Nearest neighbour index");
+			progressCb->setInfo(qPrintable(QString("Points: %1").arg(pointCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#endif
+
+	// split the nodes level by level (the nodes of a given level are independent)
+	ranges.emplace_back(0, pointCount);
+	for (unsigned level = 0; level < depth; ++level)
+	{
+		const int      nodeCount = static_cast<int>(ranges.size());
+		const unsigned firstNode = (1u << level) - 1;
+		nextRanges.resize(2 * ranges.size());
+
+		auto splitNode = [&](int j)
+		{
+			const unsigned begin = ranges[j].first;
+			const unsigned end   = ranges[j].second;
+
+			// we split along the largest dimension of the node points
+			CCVector3 bbMin = points[begin].P;
+			CCVector3 bbMax = bbMin;
+			for (unsigned i = begin + 1; i < end; ++i)
+			{
+				const CCVector3& P = points[i].P;
+				for (unsigned char d = 0; d < 3; ++d)
+				{
+					bbMin.u[d] = std::min(bbMin.u[d], P.u[d]);
+					bbMax.u[d] = std::max(bbMax.u[d], P.u[d]);
+				}
+			}
+			CCVector3     diag = bbMax - bbMin;
+			unsigned char dim  = (diag.x >= diag.y ? (diag.x >= diag.z ? 0 : 2) : (diag.y >= diag.z ? 1 : 2));
+
+			// median split
+			const unsigned mid = begin + (end - begin) / 2;
+			std::nth_element(points.begin() + begin,
+			                 points.begin() + mid,
+			                 points.begin() + end,
+			                 [dim](const IndexedPoint& a, const IndexedPoint& b) { return a.P.u[dim] < b.P.u[dim]; });
+
+			index->m_splitValues[firstNode + j] = points[mid].P.u[dim];
+			index->m_splitDims[firstNode + j]   = dim;
+			nextRanges[2 * j]                   = {begin, mid};
+			nextRanges[2 * j + 1]               = {mid, end};
+		};
+
+#ifdef CC_CORE_LIB_USES_TBB
+		tbb::parallel_for(0, nodeCount, splitNode);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int j = 0; j < nodeCount; ++j)
+		{
+			splitNode(j);
+		}
+#endif
+
+		std::swap(ranges, nextRanges);
+
+		if (progressCb)
+		{
+			progressCb->update((100.0f * (level + 1)) / depth);
+			if (progressCb->isCancelRequested())
+			{
+				return {};
+			}
+		}
+	}
+
+	// store the points in leaf order
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		const IndexedPoint& p = points[i];
+		index->m_coords[0][i] = p.P.x;
+		index->m_coords[1][i] = p.P.y;
+		index->m_coords[2][i] = p.P.z;
+		index->m_indexes[i]   = p.index;
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	return index;
+}
+
+PointCoordinateType ccNearestNeighbourIndex::initOffsets(const CCVector3& P, PointCoordinateType offsets[3]) const
+{
+	PointCoordinateType squareDist = 0;
+	for (unsigned char d = 0; d < 3; ++d)
+	{
+		if (P.u[d] < m_bbMin.u[d])
+			offsets[d] = m_bbMin.u[d] - P.u[d];
+		else if (P.u[d] > m_bbMax.u[d])
+			offsets[d] = P.u[d] - m_bbMax.u[d];
+		else
+			offsets[d] = 0;
+
+		squareDist += offsets[d] * offsets[d];
+	}
+
+	return squareDist;
+}
+
+template <class Result>
+void ccNearestNeighbourIndex::searchNode(const CCVector3&    P,
+                                         unsigned            nodeIndex,
+                                         unsigned            level,
+                                         unsigned            begin,
+                                         unsigned            end,
+                                         PointCoordinateType minSquareDist,
+                                         PointCoordinateType offsets[3],
+                                         Result&             result) const
+{
+	if (level == m_depth)
+	{
+		// leaf: we compute all the distances first (the loop can be vectorized)
+		PointCoordinateType        squareDists[MAX_LEAF_SIZE];
+		const unsigned             count = end - begin;
+		const PointCoordinateType* X     = m_coords[0].data() + begin;
+		const PointCoordinateType* Y     = m_coords[1].data() + begin;
+		const PointCoordinateType* Z     = m_coords[2].data() + begin;
+		for (unsigned i = 0; i < count; ++i)
+		{
+			PointCoordinateType dx = X[i] - P.x;
+			PointCoordinateType dy = Y[i] - P.y;
+			PointCoordinateType dz = Z[i] - P.z;
+			squareDists[i]         = dx * dx + dy * dy + dz * dz;
+		}
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			if (squareDists[i] < result.worstSquareDist())
+			{
+				result.add(squareDists[i], m_indexes[begin + i]);
+			}
+		}
+		return;
+	}
+
+	const unsigned char       dim   = m_splitDims[nodeIndex];
+	const PointCoordinateType diff  = P.u[dim] - m_splitValues[nodeIndex];
+	const unsigned            mid   = begin + (end - begin) / 2;
+	const unsigned            left  = 2 * nodeIndex + 1;
+	const unsigned            right = left + 1;
+
+	// we visit the closest child first
+	if (diff < 0)
+	{
+		searchNode(P, left, level + 1, begin, mid, minSquareDist, offsets, result);
+	}
+	else
+	{
+		searchNode(P, right, level + 1, mid, end, minSquareDist, offsets, result);
+	}
+
+	// then the other one (if it can still contain a closer point)
+	const PointCoordinateType previousOffset   = offsets[dim];
+	const PointCoordinateType farMinSquareDist = minSquareDist - previousOffset * previousOffset + diff * diff;
+	if (farMinSquareDist < result.worstSquareDist())
+	{
+		offsets[dim] = diff;
+		if (diff < 0)
+		{
+			searchNode(P, right, level + 1, mid, end, farMinSquareDist, offsets, result);
+		}
+		else
+		{
+			searchNode(P, left, level + 1, begin, mid, farMinSquareDist, offsets, result);
+		}
+		offsets[dim] = previousOffset;
+	}
+}
+
+int ccNearestNeighbourIndex::findNearestNeighbour(const CCVector3& P, PointCoordinateType maxSquareDist, PointCoordinateType& squareDist) const
+{
+	NearestNeighbourResult result;
+	if (maxSquareDist >= 0)
+	{
+		result.squareDist = maxSquareDist;
+	}
+
+	PointCoordinateType offsets[3];
+	PointCoordinateType minSquareDist = initOffsets(P, offsets);
+	if (minSquareDist < result.worstSquareDist())
+	{
+		searchNode(P, 0, 0, 0, size(), minSquareDist, offsets, result);
+	}
+
+	if (result.index >= 0)
+	{
+		squareDist = result.squareDist;
+	}
+
+	return result.index;
+}
+
+unsigned ccNearestNeighbourIndex::findKNearestNeighbours(const CCVector3&    P,
+                                                         unsigned            k,
+                                                         KNNBuffer&          buffer,
+                                                         PointCoordinateType maxSquareDist /*=-1*/) const
+{
+	buffer.neighbours.clear();
+	if (k == 0)
+	{
+		return 0;
+	}
+
+	try
+	{
+		buffer.neighbours.reserve(k);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return 0;
+	}
+
+	KNNResult result(buffer.neighbours, k, maxSquareDist >= 0 ? maxSquareDist : std::numeric_limits<PointCoordinateType>::max());
+
+	PointCoordinateType offsets[3];
+	PointCoordinateType minSquareDist = initOffsets(P, offsets);
+	if (minSquareDist < result.worstSquareDist())
+	{
+		searchNode(P, 0, 0, 0, size(), minSquareDist, offsets, result);
+	}
+
+	std::sort_heap(buffer.neighbours.begin(), buffer.neighbours.end());
+
+	return static_cast<unsigned>(buffer.neighbours.size());
+}
+
+unsigned ccNearestNeighbourIndex::findNeighboursInSphere(const CCVector3& P, PointCoordinateType radius, KNNBuffer& buffer) const
+{
+	buffer.neighbours.clear();
+	if (radius < 0)
+	{
+		return 0;
+	}
+
+	// the points lying exactly on the sphere are included
+	SphereResult result(buffer.neighbours, std::nextafter(radius * radius, std::numeric_limits<PointCoordinateType>::max()));
+
+	PointCoordinateType offsets[3];
+	PointCoordinateType minSquareDist = initOffsets(P, offsets);
+	if (minSquareDist < result.worstSquareDist())
+	{
+		try
+		{
+			searchNode(P, 0, 0, 0, size(), minSquareDist, offsets, result);
+		}
+		catch (const std::bad_alloc&)
+		{
+			// not enough memory
+			buffer.neighbours.clear();
+			return 0;
+		}
+	}
+
+	return static_cast<unsigned>(buffer.neighbours.size());
+}
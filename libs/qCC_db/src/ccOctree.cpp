@@ -38,8 +38,19 @@
 #endif
 
 // System
+#include <algorithm>
+#include <atomic>
 #include <random>
 
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_for.h>
+#endif
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 ccOctree::ccOctree(ccGenericPointCloud* aCloud)
     : CCCoreLib::DgmOctree(aCloud)
     , m_theAssociatedCloudAsGPC(aCloud)
@@ -522,6 +533,360 @@ bool ccOctree::intersectWithFrustum(ccCameraSensor* sensor, std::vector<unsigned
 	return true;
 }
 
+namespace
+{
+	//! Camera sensor frustum (global coordinates system)
+	struct SensorFrustum
+	{
+		const ccCameraSensor* sensor = nullptr;
+		float                 planesCoefficients[6][4];
+		CCVector3             corners[8];
+		CCVector3             edges[6];
+		CCVector3             center;
+		//! Global to sensor (local) coordinates system
+		ccGLMatrix globalToLocal;
+	};
+
+	//! Point inside a sensor frustum
+	struct FrustumPoint
+	{
+		unsigned sensorIndex;
+		unsigned pointIndex;
+	};
+
+	//! Octree cell with the sensors whose frustum intersects it (but doesn't contain it)
+	struct FrustaCell
+	{
+		unsigned char                  level         = 0;
+		CCCoreLib::DgmOctree::CellCode truncatedCode = 0;
+		//! First point (in the octree 'pointsAndTheirCellCodes' container)
+		unsigned firstPoint = 0;
+		//! Last point (excluded)
+		unsigned lastPoint = 0;
+		//! Intersecting sensors
+		std::vector<unsigned> sensors;
+	};
+
+	//! Below this number of points, the cells are not subdivided anymore (see ProcessFrustaCell)
+	static const unsigned c_frustaCellMinPointCount = 32;
+
+	//! Classifies the children of a cell (or its points, for the small or deepest cells)
+	/** Children cells still intersecting some sensors frusta are pushed in 'children'
+	    while the points of the cells completely inside a frustum are directly output.
+	    The points of the cells with only a few points (or with all their points in
+	    the same deepest cell) are directly tested against the frusta.
+	**/
+	void ProcessFrustaCell(const ccOctree&                   octree,
+	                       const std::vector<SensorFrustum>& frusta,
+	                       const FrustaCell&                 cell,
+	                       std::vector<FrustaCell>&          children,
+	                       std::vector<FrustumPoint>&        insidePoints)
+	{
+		const CCCoreLib::DgmOctree::cellsContainer& codes = octree.pointsAndTheirCellCodes();
+
+		if (cell.level == CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL
+		    || cell.lastPoint - cell.firstPoint <= c_frustaCellMinPointCount
+		    || codes[cell.firstPoint].theCode == codes[cell.lastPoint - 1].theCode) // no populated sub-level
+		{
+			// the points themselves are tested
+			const CCCoreLib::GenericIndexedCloudPersist* cloud = octree.associatedCloud();
+			for (unsigned i = cell.firstPoint; i < cell.lastPoint; ++i)
+			{
+				unsigned         pointIndex = codes[i].theIndex;
+				const CCVector3* P          = cloud->getPoint(pointIndex);
+				for (unsigned sensorIndex : cell.sensors)
+				{
+					const SensorFrustum& frustum    = frusta[sensorIndex];
+					CCVector3            localCoord = frustum.globalToLocal * (*P);
+					if (frustum.sensor->isLocalCoordInFrustum(localCoord))
+					{
+						insidePoints.push_back({sensorIndex, pointIndex});
+					}
+				}
+			}
+			return;
+		}
+
+		unsigned char childLevel = cell.level + 1;
+		unsigned char bitDec     = CCCoreLib::DgmOctree::GET_BIT_SHIFT(childLevel);
+
+		auto lessThanChildCode = [bitDec](CCCoreLib::DgmOctree::CellCode code, const CCCoreLib::DgmOctree::IndexAndCode& P)
+		{
+			return code < (P.theCode >> bitDec);
+		};
+
+		// the points of each (non empty) child cell are contiguous
+		unsigned firstPoint = cell.firstPoint;
+		while (firstPoint < cell.lastPoint)
+		{
+			CCCoreLib::DgmOctree::CellCode childCode = (codes[firstPoint].theCode >> bitDec);
+			unsigned                       lastPoint = static_cast<unsigned>(std::upper_bound(codes.begin() + firstPoint, codes.begin() + cell.lastPoint, childCode, lessThanChildCode) - codes.begin());
+
+			CCVector3 bbMin;
+			CCVector3 bbMax;
+			octree.computeCellLimits(childCode, childLevel, bbMin, bbMax, true);
+
+			FrustaCell child;
+			for (unsigned sensorIndex : cell.sensors)
+			{
+				const SensorFrustum& frustum = frusta[sensorIndex];
+
+				ccOctreeFrustumIntersector::OctreeCellVisibility result = ccOctreeFrustumIntersector::separatingAxisTest(bbMin, bbMax, frustum.planesCoefficients, frustum.corners, frustum.edges, frustum.center);
+				if (result == ccOctreeFrustumIntersector::CELL_INSIDE_FRUSTUM)
+				{
+					// all the points are inside the frustum since the cell itself is completely inside
+					for (unsigned i = firstPoint; i < lastPoint; ++i)
+					{
+						insidePoints.push_back({sensorIndex, codes[i].theIndex});
+					}
+				}
+				else if (result == ccOctreeFrustumIntersector::CELL_INTERSECT_FRUSTUM)
+				{
+					child.sensors.push_back(sensorIndex);
+				}
+			}
+
+			if (!child.sensors.empty())
+			{
+				child.level         = childLevel;
+				child.truncatedCode = childCode;
+				child.firstPoint    = firstPoint;
+				child.lastPoint     = lastPoint;
+				children.push_back(std::move(child));
+			}
+
+			firstPoint = lastPoint;
+		}
+	}
+} // namespace
+
+bool ccOctree::intersectWithFrusta(const std::vector<ccCameraSensor*>& sensors,
+                                   FrustaIntersection&                 result,
+                                   int                                 maxThreadCount /*=0*/,
+                                   CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/) const
+{
+	result.pointIndexes.clear();
+	result.rangeStart.clear();
+
+	const CCCoreLib::DgmOctree::cellsContainer& codes = pointsAndTheirCellCodes();
+
+	// root cell
+	std::vector<FrustaCell> cells(1);
+	cells.front().lastPoint = static_cast<unsigned>(codes.size());
+
+	std::vector<SensorFrustum> frusta;
+	try
+	{
+		result.rangeStart.resize(sensors.size() + 1, 0);
+		frusta.resize(sensors.size());
+
+		// initialization (not thread-safe)
+		for (size_t k = 0; k < sensors.size(); ++k)
+		{
+			ccCameraSensor* sensor = sensors[k];
+			if (!sensor)
+				continue;
+
+			SensorFrustum& frustum = frusta[k];
+			if (!sensor->computeGlobalPlaneCoefficients(frustum.planesCoefficients, frustum.corners, frustum.edges, frustum.center))
+			{
+				ccLog::Warning(QString("[ccOctree::intersectWithFrusta] Failed to compute the frustum of sensor '%1'").arg(sensor->getName()));
+				continue;
+			}
+			ccIndexedTransformation trans;
+			if (!sensor->getActiveAbsoluteTransformation(trans))
+				continue;
+
+			frustum.sensor        = sensor;
+			frustum.globalToLocal = trans.inverse();
+			cells.front().sensors.push_back(static_cast<unsigned>(k));
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccOctree::intersectWithFrusta] Not enough memory!");
+		return false;
+	}
+
+	if (codes.empty() || cells.front().sensors.empty())
+	{
+		// nothing to do
+		return true;
+	}
+
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#else
+	const int threadCount = std::max(maxThreadCount, 1);
+#endif
+	// the sub-trees are processed in parallel as soon as there are enough of them
+	const size_t minSubTreeCount = 64 * static_cast<size_t>(threadCount);
+
+	// points inside the frusta (in the order of the processed cells)
+	std::vector<std::vector<FrustumPoint>> insidePoints;
+
+	std::atomic<bool> notEnoughMemory(false);
+	std::atomic<bool> cancelled(false);
+
+	if (progressCb)
+	{
+		progressCb->update(0);
+		progressCb->setMethodTitle(QObject::tr("Frusta intersection"));
+		progressCb->setInfo(QObject::tr("Sensors: %1\nPoints: %2").arg(sensors.size()).arg(codes.size()));
+		progressCb->start();
+	}
+
+	// the top levels are processed level by level (breadth first)
+	while (!cells.empty())
+	{
+		bool subTrees = (cells.size() >= minSubTreeCount);
+
+		std::vector<std::vector<FrustaCell>> children;
+		size_t                               firstChunk = insidePoints.size();
+		try
+		{
+			children.resize(subTrees ? 0 : cells.size());
+			insidePoints.resize(firstChunk + cells.size());
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+			break;
+		}
+
+		CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(cells.size()));
+
+		auto processCell = [&](int i)
+		{
+			if (notEnoughMemory || cancelled)
+			{
+				return;
+			}
+
+			try
+			{
+				std::vector<FrustumPoint>& cellInsidePoints = insidePoints[firstChunk + i];
+				if (subTrees)
+				{
+					// the whole sub-tree is processed (depth first)
+					std::vector<FrustaCell> stack;
+					ProcessFrustaCell(*this, frusta, cells[i], stack, cellInsidePoints);
+					while (!stack.empty())
+					{
+						FrustaCell cell = std::move(stack.back());
+						stack.pop_back();
+						ProcessFrustaCell(*this, frusta, cell, stack, cellInsidePoints);
+					}
+
+					if (!nProgress.oneStep())
+					{
+						cancelled = true;
+					}
+				}
+				else
+				{
+					ProcessFrustaCell(*this, frusta, cells[i], children[i], cellInsidePoints);
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+		};
+
+#ifdef CC_CORE_LIB_USES_TBB
+		tbb::parallel_for(0, static_cast<int>(cells.size()), processCell);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int i = 0; i < static_cast<int>(cells.size()); ++i)
+		{
+			processCell(i);
+		}
+#endif
+
+		if (notEnoughMemory || cancelled || subTrees)
+		{
+			break;
+		}
+
+		// next level
+		std::vector<FrustaCell> nextCells;
+		try
+		{
+			for (std::vector<FrustaCell>& cellChildren : children)
+			{
+				for (FrustaCell& child : cellChildren)
+				{
+					nextCells.push_back(std::move(child));
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+			break;
+		}
+		cells = std::move(nextCells);
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (notEnoughMemory)
+	{
+		ccLog::Warning("[ccOctree::intersectWithFrusta] Not enough memory!");
+		result.rangeStart.clear();
+		return false;
+	}
+	if (cancelled)
+	{
+		result.rangeStart.clear();
+		return false;
+	}
+
+	// group the points by sensor
+	std::vector<size_t>& rangeStart = result.rangeStart;
+	for (const std::vector<FrustumPoint>& chunk : insidePoints)
+	{
+		for (const FrustumPoint& P : chunk)
+		{
+			++rangeStart[P.sensorIndex + 1];
+		}
+	}
+	for (size_t k = 1; k < rangeStart.size(); ++k)
+	{
+		rangeStart[k] += rangeStart[k - 1];
+	}
+
+	std::vector<size_t> fillIndexes;
+	try
+	{
+		result.pointIndexes.resize(rangeStart.back());
+		fillIndexes.assign(rangeStart.begin(), rangeStart.end() - 1);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccOctree::intersectWithFrusta] Not enough memory!");
+		result.rangeStart.clear();
+		return false;
+	}
+
+	for (std::vector<FrustumPoint>& chunk : insidePoints)
+	{
+		for (const FrustumPoint& P : chunk)
+		{
+			result.pointIndexes[fillIndexes[P.sensorIndex]++] = P.pointIndex;
+		}
+		chunk = std::vector<FrustumPoint>(); // release memory as soon as possible
+	}
+
+	return true;
+}
+
 bool ccOctree::pointPicking(const CCVector2d&           clickPos,
                             const ccGLCameraParameters& camera,
                             PointDescriptor&            output,
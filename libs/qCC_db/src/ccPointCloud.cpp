@@ -51,9 +51,21 @@
 #include <QSettings>
 
 // system
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <queue>
 
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_for.h>
+#endif
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 static const char s_deviationSFName[] = "Deviation";
 
 // 'Draw normals' shader program
@@ -411,6 +423,9 @@ ccPointCloud* ccPointCloud::partialClone(const CCCoreLib::ReferenceCloud* select
 							}
 							currentScalarField->computeMinAndMax();
 
+							// the copied values are checked against the source storage type (the SF stays a 'float' one otherwise)
+							currentScalarField->setStorageType(sf->getStorageType());
+
 							// copy display parameters
 							currentScalarField->importParametersFrom(sf);
 						}
@@ -545,6 +560,7 @@ void ccPointCloud::notifyGeometryUpdate()
 
 	releaseVBOs();
 	clearLOD();
+	deleteNearestNeighbourIndex();
 }
 
 void ccPointCloud::setDisplay(ccGenericGLDisplay* win)
@@ -1584,6 +1600,35 @@ void ccPointCloud::setPointColor(unsigned pointIndex, const ccColor::Rgba& col)
 	colorsHaveChanged();
 }
 
+void ccPointCloud::colorsHaveChanged(unsigned firstIndex, unsigned lastIndex)
+{
+	assert(firstIndex <= lastIndex && lastIndex < size());
+
+	if (m_vboManager.updateFlags & vboSet::UPDATE_COLORS)
+	{
+		// all the colors will be updated anyway
+		return;
+	}
+
+	try
+	{
+		m_vboManager.colorChunksToUpdate.resize(ccChunk::Count(m_points), false);
+	}
+	catch (const std::bad_alloc&)
+	{
+		// fall back to a full update
+		m_vboManager.colorChunksToUpdate.clear();
+		colorsHaveChanged();
+		return;
+	}
+
+	size_t lastChunk = std::min(static_cast<size_t>(lastIndex) >> ccChunk::SIZE_POWER, m_vboManager.colorChunksToUpdate.size() - 1);
+	for (size_t chunkIndex = (static_cast<size_t>(firstIndex) >> ccChunk::SIZE_POWER); chunkIndex <= lastChunk; ++chunkIndex)
+	{
+		m_vboManager.colorChunksToUpdate[chunkIndex] = true;
+	}
+}
+
 void ccPointCloud::setPointNormalIndex(unsigned pointIndex, CompressedNormType norm)
 {
 	assert(m_normals && pointIndex < m_normals->currentSize());
@@ -2625,7 +2670,7 @@ inline float GetSymmetricalNormalizedValue(ScalarType sfVal, const ccScalarField
 // the GL type depends on the PointCoordinateType 'size' (float or double)
 static GLenum GL_COORD_TYPE = sizeof(PointCoordinateType) == 4 ? GL_FLOAT : GL_DOUBLE;
 
-void ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs)
+bool ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t chunkIndex, unsigned decimStep, bool useVBOs)
 {
 	QOpenGLFunctions_2_1* glFunc = context.glFunctions<QOpenGLFunctions_2_1>();
 	assert(glFunc != nullptr);
@@ -2636,18 +2681,39 @@ void ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t c
 	    && m_vboManager.vbos[chunkIndex]
 	    && m_vboManager.vbos[chunkIndex]->isCreated())
 	{
+		VBO* vbo = m_vboManager.vbos[chunkIndex];
+
 		// we can use VBOs directly
-		if (m_vboManager.vbos[chunkIndex]->bind())
+		if (vbo->bind())
 		{
+			if (vbo->compact)
+			{
+				glFunc->glVertexPointer(3, GL_SHORT, decimStep * 3 * sizeof(GLshort), nullptr);
+				vbo->release();
+
+				// the dequantization is done by the vertex transformation stage
+				const double s           = vbo->compactStep;
+				const double dequant[16] = { s, 0, 0, 0,
+				                             0, s, 0, 0,
+				                             0, 0, s, 0,
+				                             vbo->compactOrigin.x, vbo->compactOrigin.y, vbo->compactOrigin.z, 1.0 };
+				glFunc->glMatrixMode(GL_MODELVIEW);
+				glFunc->glPushMatrix();
+				glFunc->glMultMatrixd(dequant);
+				// the scaling is uniform: rescaling the normals is enough (GL_TRANSFORM_BIT is saved by drawMeOnly)
+				glFunc->glEnable(GL_RESCALE_NORMAL);
+				return true;
+			}
+
 			glFunc->glVertexPointer(3, GL_COORD_TYPE, decimStep * 3 * sizeof(PointCoordinateType), nullptr);
-			m_vboManager.vbos[chunkIndex]->release();
+			vbo->release();
 		}
 		else
 		{
 			ccLog::Warning("[VBO] Failed to bind VBO?! We'll deactivate them then...");
 			m_vboManager.state = vboSet::FAILED;
 			// recall the method
-			glChunkVertexPointer(context, chunkIndex, decimStep, false);
+			return glChunkVertexPointer(context, chunkIndex, decimStep, false);
 		}
 	}
 	else
@@ -2655,6 +2721,8 @@ void ccPointCloud::glChunkVertexPointer(const CC_DRAW_CONTEXT& context, size_t c
 		// standard OpenGL copy
 		glFunc->glVertexPointer(3, GL_COORD_TYPE, decimStep * 3 * sizeof(PointCoordinateType), ccChunk::Start(m_points, chunkIndex));
 	}
+
+	return false;
 }
 
 /// Maximum number of points (per cloud) displayed in a single LOD iteration
@@ -3418,7 +3486,7 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 							size_t chunkSize = ccChunk::Size(k, m_points);
 
 							// points
-							glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
+							bool dequantize = glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
 							// normals
 							if (glParams.showNorms)
 							{
@@ -3453,6 +3521,11 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 								chunkSize = static_cast<unsigned>(static_cast<double>(chunkSize) / toDisplay.decimStep); // static_cast is equivalent to floor if value >= 0
 							}
 							glFunc->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(chunkSize));
+
+							if (dequantize)
+							{
+								glFunc->glPopMatrix();
+							}
 						}
 					}
 
@@ -3637,7 +3710,7 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 						size_t chunkSize = ccChunk::Size(k, m_points);
 
 						// points
-						glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
+						bool dequantize = glChunkVertexPointer(context, k, toDisplay.decimStep, useVBOs);
 						// normals
 						if (glParams.showNorms)
 							glChunkNormalPointer(context, k, toDisplay.decimStep, useVBOs);
@@ -3650,6 +3723,11 @@ void ccPointCloud::drawMeOnly(CC_DRAW_CONTEXT& context)
 							chunkSize = static_cast<unsigned>(static_cast<double>(chunkSize) / toDisplay.decimStep); // static_cast is equivalent to floor if value >= 0
 						}
 						glFunc->glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(chunkSize));
+
+						if (dequantize)
+						{
+							glFunc->glPopMatrix();
+						}
 					}
 				}
 
@@ -5466,6 +5544,69 @@ static bool CatchGLErrors(GLenum err, const char* context)
 // DGM: normals are so slow to display that it's a waste of memory and time to load them in VBOs!
 #define DONT_LOAD_NORMALS_IN_VBOS
 
+//! Max quantization error of the compact VBOs (relatively to the cloud bounding-box diagonal)
+static const double c_compactVBOMaxRelativeError = 1.0e-6;
+
+//! Quantizes the coordinates of a chunk of points on 16 bits (for compact VBOs)
+/** The coordinates are expressed relatively to the center of the chunk bounding-box,
+	with the same step along the 3 dimensions (so that the dequantization transformation
+	is a uniform scaling + a translation).
+	The maximum error is thus half a step (i.e. ~1/131000 of the largest dimension of the chunk).
+	\param maxStep max quantization step (the chunk is not quantized if the step would be larger)
+	\return true if the chunk has been quantized (false: it must be stored with floats)
+**/
+static bool QuantizeChunk(const CCVector3* points, size_t count, double maxStep, GLshort* output, CCVector3d& origin, double& step)
+{
+	// chunk bounding-box
+	CCVector3d bbMin(0, 0, 0);
+	CCVector3d bbMax(0, 0, 0);
+	bool       validBB = false;
+	for (size_t i = 0; i < count; ++i)
+	{
+		CCVector3d P = points[i].toDouble();
+		if (!std::isfinite(P.x) || !std::isfinite(P.y) || !std::isfinite(P.z))
+		{
+			continue;
+		}
+		if (validBB)
+		{
+			bbMin.x = std::min(bbMin.x, P.x);
+			bbMin.y = std::min(bbMin.y, P.y);
+			bbMin.z = std::min(bbMin.z, P.z);
+			bbMax.x = std::max(bbMax.x, P.x);
+			bbMax.y = std::max(bbMax.y, P.y);
+			bbMax.z = std::max(bbMax.z, P.z);
+		}
+		else
+		{
+			bbMin = bbMax = P;
+			validBB       = true;
+		}
+	}
+
+	origin               = (bbMin + bbMax) / 2;
+	CCVector3d diag      = bbMax - bbMin;
+	double maxHalfExtent = std::max(diag.x, std::max(diag.y, diag.z)) / 2;
+	step                 = (maxHalfExtent > 0 ? maxHalfExtent / 32767 : 1.0);
+	if (maxHalfExtent > 0 && step > maxStep)
+	{
+		// the chunk is too spread out: the error would be visible
+		return false;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		CCVector3d P = points[i].toDouble();
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			double q  = (P.u[d] - origin.u[d]) / step;
+			*output++ = std::isfinite(q) ? static_cast<GLshort>(std::max(-32767.0, std::min(32767.0, std::round(q)))) : 0;
+		}
+	}
+
+	return true;
+}
+
 bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams& glParams)
 {
 	if (isColorOverridden())
@@ -5510,8 +5651,13 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 			updateFlags |= UPDATE_NORMALS;
 		}
 #endif
+		if (m_vboManager.compactCoords != context.useCompactVBOs)
+		{
+			m_vboManager.updateFlags |= vboSet::UPDATE_POINTS;
+		}
+
 		// nothing to do?
-		if (m_vboManager.updateFlags == 0)
+		if (m_vboManager.updateFlags == 0 && m_vboManager.colorChunksToUpdate.empty())
 		{
 			return true;
 		}
@@ -5569,6 +5715,23 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 #else
 		m_vboManager.hasNormals = false;
 #endif
+		m_vboManager.compactCoords = context.useCompactVBOs;
+
+		// quantized coordinates buffer (compact VBOs)
+		std::vector<GLshort> compactCoordsBuffer;
+		double               compactMaxStep = 0.0;
+		if (m_vboManager.compactCoords)
+		{
+			try
+			{
+				compactCoordsBuffer.resize(ccChunk::SIZE * 3);
+				compactMaxStep = 2 * c_compactVBOMaxRelativeError * getOwnBB().getDiagNormd();
+			}
+			catch (const std::bad_alloc&)
+			{
+				// the points will be stored with floats
+			}
+		}
 
 		// process each chunk
 		for (size_t chunkIndex = 0; chunkIndex < chunksCount; ++chunkIndex)
@@ -5578,6 +5741,12 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 			int  chunkUpdateFlags = m_vboManager.updateFlags;
 			bool reallocated      = false;
 
+			if (chunkIndex < m_vboManager.colorChunksToUpdate.size() && m_vboManager.colorChunksToUpdate[chunkIndex])
+			{
+				// partial color update
+				chunkUpdateFlags |= vboSet::UPDATE_COLORS;
+			}
+
 			if (!m_vboManager.vbos[chunkIndex])
 			{
 				m_vboManager.vbos[chunkIndex] = new VBO;
@@ -5585,8 +5754,25 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 
 			VBO* currentVBO = m_vboManager.vbos[chunkIndex];
 
+			// the chunk is only stored in the compact format if the quantization error is small enough
+			bool compactChunk = false;
+			bool quantized    = false;
+			if (!compactCoordsBuffer.empty())
+			{
+				if (chunkUpdateFlags & vboSet::UPDATE_POINTS)
+				{
+					compactChunk = QuantizeChunk(ccChunk::Start(m_points, chunkIndex), chunkSize, compactMaxStep, compactCoordsBuffer.data(), currentVBO->compactOrigin, currentVBO->compactStep);
+					quantized    = true;
+				}
+				else
+				{
+					// same points, same format
+					compactChunk = currentVBO->compact;
+				}
+			}
+
 			// allocate memory for current VBO
-			int vboSizeBytes = currentVBO->init(chunkSize, m_vboManager.hasColors, m_vboManager.hasNormals, &reallocated);
+			int vboSizeBytes = currentVBO->init(chunkSize, compactChunk, m_vboManager.hasColors, m_vboManager.hasNormals, &reallocated);
 
 			QOpenGLFunctions_2_1* glFunc = context.glFunctions<QOpenGLFunctions_2_1>();
 			if (glFunc)
@@ -5609,7 +5795,20 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 				// load points
 				if (chunkUpdateFlags & vboSet::UPDATE_POINTS)
 				{
-					currentVBO->write(0, ccChunk::Start(m_points, chunkIndex), sizeof(PointCoordinateType) * chunkSize * 3);
+					if (currentVBO->compact)
+					{
+						if (!quantized)
+						{
+							// the VBO has been reallocated (the points haven't changed, so the result is the same as before)
+							quantized = QuantizeChunk(ccChunk::Start(m_points, chunkIndex), chunkSize, compactMaxStep, compactCoordsBuffer.data(), currentVBO->compactOrigin, currentVBO->compactStep);
+							assert(quantized);
+						}
+						currentVBO->write(0, compactCoordsBuffer.data(), sizeof(GLshort) * chunkSize * 3);
+					}
+					else
+					{
+						currentVBO->write(0, ccChunk::Start(m_points, chunkIndex), sizeof(PointCoordinateType) * chunkSize * 3);
+					}
 				}
 				// load colors
 				if (chunkUpdateFlags & vboSet::UPDATE_COLORS)
@@ -5734,17 +5933,21 @@ bool ccPointCloud::updateVBOs(const CC_DRAW_CONTEXT& context, const glDrawParams
 
 	m_vboManager.state       = vboSet::INITIALIZED;
 	m_vboManager.updateFlags = 0;
+	m_vboManager.colorChunksToUpdate.clear();
 
 	return true;
 }
 
-int ccPointCloud::VBO::init(int count, bool withColors, bool withNormals, bool* reallocated /*=nullptr*/)
+int ccPointCloud::VBO::init(int count, bool compactCoords, bool withColors, bool withNormals, bool* reallocated /*=nullptr*/)
 {
 	// required memory
-	int totalSizeBytes = sizeof(PointCoordinateType) * count * 3;
+	compact            = compactCoords;
+	int totalSizeBytes = (compact ? sizeof(GLshort) : sizeof(PointCoordinateType)) * count * 3;
 	if (withColors)
 	{
-		rgbShift = totalSizeBytes;
+		// keep the colors 4-bytes aligned
+		totalSizeBytes = ((totalSizeBytes + 3) / 4) * 4;
+		rgbShift       = totalSizeBytes;
 		totalSizeBytes += sizeof(ColorCompType) * count * 4;
 	}
 	if (withNormals)
@@ -5828,8 +6031,10 @@ void ccPointCloud::releaseVBOs()
 	m_vboManager.hasColors         = false;
 	m_vboManager.hasNormals        = false;
 	m_vboManager.colorIsSF         = false;
+	m_vboManager.compactCoords     = false;
 	m_vboManager.sourceSF          = nullptr;
 	m_vboManager.totalMemSizeBytes = 0;
+	m_vboManager.colorChunksToUpdate.clear();
 	m_vboManager.state             = vboSet::NEW;
 }
 
@@ -5844,6 +6049,207 @@ void ccPointCloud::removeFromDisplay(const ccGenericGLDisplay* win)
 	ccGenericPointCloud::removeFromDisplay(win);
 }
 
+//! Approximate number of cells per band when processing the scan grids in parallel
+static const unsigned s_gridBandCellCount = (1 << 16); //~ 64K
+
+//! Band of rows of a scan grid (see SplitGridsInBands)
+struct GridBand
+{
+	size_t   gridIndex;
+	unsigned firstRow;
+	unsigned lastRow; // excluded
+};
+
+//! Splits the (valid) scan grids of a cloud in bands of rows, so as to process them in parallel
+/** \param cloud the cloud
+    \param rowCountDelta number of rows to process in each grid, relatively to its height (e.g. -1 to process the grid cells)
+    \param methodName name of the calling method (for warnings)
+    \param[out] bands the bands of rows
+    \return false if there's not enough memory
+**/
+static bool SplitGridsInBands(const ccPointCloud& cloud, int rowCountDelta, const char* methodName, std::vector<GridBand>& bands)
+{
+	try
+	{
+		for (size_t gi = 0; gi < cloud.gridCount(); ++gi)
+		{
+			const ccPointCloud::Grid::Shared& scanGrid = cloud.grid(gi);
+			if (scanGrid && scanGrid->indexes.empty())
+			{
+				// empty grid, we skip it
+				continue;
+			}
+			if (!scanGrid || scanGrid->h == 0 || scanGrid->w == 0 || scanGrid->indexes.size() != static_cast<size_t>(scanGrid->h) * scanGrid->w)
+			{
+				// invalid grid
+				ccLog::Warning(QString("[%1] Grid structure #%2 is invalid").arg(methodName).arg(gi + 1));
+				continue;
+			}
+
+			int gridRowCount = static_cast<int>(scanGrid->h) + rowCountDelta;
+			if (gridRowCount <= 0)
+			{
+				continue;
+			}
+
+			unsigned bandRowCount = std::max(1u, s_gridBandCellCount / scanGrid->w);
+			for (unsigned j = 0; j < static_cast<unsigned>(gridRowCount); j += bandRowCount)
+			{
+				bands.push_back({gi, j, std::min(j + bandRowCount, static_cast<unsigned>(gridRowCount))});
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning(QString("[%1] Not enough memory").arg(methodName));
+		return false;
+	}
+
+	return true;
+}
+
+//! Triangulates a scan grid cell (i.e. the 4 grid vertices (i, j), (i+1, j), (i, j+1) and (i+1, j+1))
+/** The code below has been kindly provided by Romain Janvier
+    \param cloud the cloud
+    \param grid the scan grid
+    \param i cell column
+    \param j cell row
+    \param sensorOrigin sensor origin
+    \param minTriangleAngle_deg minimum triangle angle (in degrees - the angles are not checked if <= 0)
+    \param minAngleCos cosine of the minimum triangle angle
+    \param[out] triangles the triangles
+    \return the number of triangles (0, 1 or 2)
+**/
+static int TriangulateGridCell(const ccPointCloud&       cloud,
+                               const ccPointCloud::Grid& grid,
+                               int                       i,
+                               int                       j,
+                               const CCVector3&          sensorOrigin,
+                               double                    minTriangleAngle_deg,
+                               PointCoordinateType       minAngleCos,
+                               Tuple3i                   triangles[2])
+{
+	const int& v0 = grid.indexes[j * grid.w + i];
+	const int& v1 = grid.indexes[j * grid.w + (i + 1)];
+	const int& v2 = grid.indexes[(j + 1) * grid.w + i];
+	const int& v3 = grid.indexes[(j + 1) * grid.w + (i + 1)];
+
+	bool topo[4]{v0 >= 0, v1 >= 0, v2 >= 0, v3 >= 0};
+
+	int mask   = 0;
+	int pixels = 0;
+
+	for (int k = 0; k < 4; ++k)
+	{
+		if (topo[k])
+		{
+			mask |= 1 << k;
+			pixels += 1;
+		}
+	}
+
+	if (pixels < 3)
+	{
+		return 0;
+	}
+
+	Tuple3i tris[4]{
+	    {v0, v2, v1},
+	    {v0, v3, v1},
+	    {v0, v2, v3},
+	    {v1, v2, v3}};
+
+	int tri[2]{-1, -1};
+
+	switch (mask)
+	{
+	case 7:
+		tri[0] = 0;
+		break;
+	case 11:
+		tri[0] = 1;
+		break;
+	case 13:
+		tri[0] = 2;
+		break;
+	case 14:
+		tri[0] = 3;
+		break;
+	case 15:
+	{
+		/* Choose the triangulation with smaller diagonal. */
+		double d0     = (*cloud.getPoint(v0) - sensorOrigin).normd();
+		double d1     = (*cloud.getPoint(v1) - sensorOrigin).normd();
+		double d2     = (*cloud.getPoint(v2) - sensorOrigin).normd();
+		double d3     = (*cloud.getPoint(v3) - sensorOrigin).normd();
+		float  ddiff1 = std::abs(d0 - d3);
+		float  ddiff2 = std::abs(d1 - d2);
+		if (ddiff1 < ddiff2)
+		{
+			tri[0] = 1;
+			tri[1] = 2;
+		}
+		else
+		{
+			tri[0] = 0;
+			tri[1] = 3;
+		}
+		break;
+	}
+
+	default:
+		return 0;
+	}
+
+	int triangleCount = 0;
+	for (int trCount = 0; trCount < 2; ++trCount)
+	{
+		int idx = tri[trCount];
+		if (idx < 0)
+		{
+			continue;
+		}
+		const Tuple3i& t = tris[idx];
+
+		// now check the triangle angles
+		if (minTriangleAngle_deg > 0)
+		{
+			const CCVector3* A = cloud.getPoint(t.u[0]);
+			const CCVector3* B = cloud.getPoint(t.u[1]);
+			const CCVector3* C = cloud.getPoint(t.u[2]);
+
+			CCVector3 uAB = (*B - *A);
+			uAB.normalize();
+			CCVector3 uCA = (*A - *C);
+			uCA.normalize();
+
+			PointCoordinateType cosA = -uCA.dot(uAB);
+			if (cosA > minAngleCos)
+			{
+				continue;
+			}
+
+			CCVector3 uBC = (*C - *B);
+			uBC.normalize();
+			PointCoordinateType cosB = -uAB.dot(uBC);
+			if (cosB > minAngleCos)
+			{
+				continue;
+			}
+
+			PointCoordinateType cosC = -uBC.dot(uCA);
+			if (cosC > minAngleCos)
+			{
+				continue;
+			}
+		}
+
+		triangles[triangleCount++] = t;
+	}
+
+	return triangleCount;
+}
+
 bool ccPointCloud::computeNormalsWithGrids(double                       minTriangleAngle_deg /*=1.0*/,
                                            ccProgressDialog*            pDlg /*=nullptr*/,
                                            ccNormalVectors::Orientation preferredOrientation /*=ccNormalVectors::Orientation::UNDEFINED*/)
@@ -5878,13 +6284,43 @@ bool ccPointCloud::computeNormalsWithGrids(double                       minTrian
 		}
 	}
 
+	// the grids cells are processed by bands of rows, in parallel
+	std::vector<GridBand> bands;
+	if (!SplitGridsInBands(*this, -1, "computeNormalsWithGrids", bands))
+	{
+		return false;
+	}
+
+	// The first vertices row of each band is shared with the previous band (if any).
+	// The normals of the triangles incident to these vertices are stored and only
+	// accumulated afterwards, so that all the normals are summed in the same order
+	// as if the grids were processed sequentially.
+	// (we assume that each point is referenced by at most one grid cell)
+	struct SeamNormal
+	{
+		int       pointIndex;
+		CCVector3 N;
+	};
+	std::vector<std::vector<SeamNormal>> seamNormals;
+	try
+	{
+		seamNormals.resize(bands.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[computeNormalsWithGrids] Not enough memory");
+		return false;
+	}
+
 	// we hide normals during process
 	showNormals(false);
 
 	// progress dialog
+	CCCoreLib::NormalizedProgress nProgress(pDlg, static_cast<unsigned>(bands.size()));
 	if (pDlg)
 	{
 		pDlg->setWindowTitle(QObject::tr("Normals computation"));
+		pDlg->setLabelText(QObject::tr("Grids: %1").arg(gridCount()));
 		pDlg->setAutoClose(false);
 		pDlg->show();
 		QCoreApplication::processEvents();
@@ -5893,179 +6329,105 @@ bool ccPointCloud::computeNormalsWithGrids(double                       minTrian
 	PointCoordinateType minAngleCos = static_cast<PointCoordinateType>(cos(CCCoreLib::DegreesToRadians(minTriangleAngle_deg)));
 	// double minTriangleAngle_rad = CCCoreLib::DegreesToRadians(minTriangleAngle_deg);
 
-	// for each grid cell
-	for (size_t gi = 0; gi < gridCount(); ++gi)
+	std::atomic<bool> notEnoughMemory(false);
+	std::atomic<bool> cancelled(false);
+
+	auto processBand = [&](int bandIndex)
 	{
-		const Grid::Shared& scanGrid = grid(gi);
-		if (scanGrid && scanGrid->indexes.empty())
+		if (notEnoughMemory || cancelled)
 		{
-			// empty grid, we skip it
-			continue;
-		}
-		if (!scanGrid || scanGrid->h == 0 || scanGrid->w == 0 || scanGrid->indexes.size() != static_cast<size_t>(scanGrid->h) * scanGrid->w)
-		{
-			// invalid grid
-			ccLog::Warning(QString("[computeNormalsWithGrids] Grid structure #%i is invalid").arg(gi + 1));
-			continue;
+			return;
 		}
 
-		// progress dialog
-		if (pDlg)
-		{
-			pDlg->setLabelText(QObject::tr("Grid: %1 x %2").arg(scanGrid->w).arg(scanGrid->h));
-			pDlg->setValue(0);
-			pDlg->setRange(0, static_cast<int>(scanGrid->indexes.size()));
-			QCoreApplication::processEvents();
-		}
+		const GridBand&     band     = bands[bandIndex];
+		const Grid::Shared& scanGrid = grid(band.gridIndex);
 
-		// the code below has been kindly provided by Romain Janvier
 		CCVector3 sensorOrigin = (scanGrid->sensorPosition.getTranslationAsVec3D() /* + m_globalShift*/).toPC();
 
-		for (int j = 0; j < static_cast<int>(scanGrid->h) - 1; ++j)
+		std::vector<SeamNormal>& bandSeamNormals = seamNormals[bandIndex];
+
+		try
 		{
-			for (int i = 0; i < static_cast<int>(scanGrid->w) - 1; ++i)
+			for (int j = static_cast<int>(band.firstRow); j < static_cast<int>(band.lastRow); ++j)
 			{
-				// form the triangles with the nearest neighbors
-				// and accumulate the corresponding normals
-				const int& v0 = scanGrid->indexes[j * scanGrid->w + i];
-				const int& v1 = scanGrid->indexes[j * scanGrid->w + (i + 1)];
-				const int& v2 = scanGrid->indexes[(j + 1) * scanGrid->w + i];
-				const int& v3 = scanGrid->indexes[(j + 1) * scanGrid->w + (i + 1)];
-
-				bool topo[4]{v0 >= 0, v1 >= 0, v2 >= 0, v3 >= 0};
-
-				int mask   = 0;
-				int pixels = 0;
-
-				for (int j = 0; j < 4; ++j)
-				{
-					if (topo[j])
-					{
-						mask |= 1 << j;
-						pixels += 1;
-					}
-				}
-
-				if (pixels < 3)
-				{
-					continue;
-				}
-
-				Tuple3i tris[4]{
-				    {v0, v2, v1},
-				    {v0, v3, v1},
-				    {v0, v2, v3},
-				    {v1, v2, v3}};
-
-				int tri[2]{-1, -1};
-
-				switch (mask)
-				{
-				case 7:
-					tri[0] = 0;
-					break;
-				case 11:
-					tri[0] = 1;
-					break;
-				case 13:
-					tri[0] = 2;
-					break;
-				case 14:
-					tri[0] = 3;
-					break;
-				case 15:
-				{
-					/* Choose the triangulation with smaller diagonal. */
-					double d0     = (*getPoint(v0) - sensorOrigin).normd();
-					double d1     = (*getPoint(v1) - sensorOrigin).normd();
-					double d2     = (*getPoint(v2) - sensorOrigin).normd();
-					double d3     = (*getPoint(v3) - sensorOrigin).normd();
-					float  ddiff1 = std::abs(d0 - d3);
-					float  ddiff2 = std::abs(d1 - d2);
-					if (ddiff1 < ddiff2)
-					{
-						tri[0] = 1;
-						tri[1] = 2;
-					}
-					else
-					{
-						tri[0] = 0;
-						tri[1] = 3;
-					}
-					break;
-				}
-
-				default:
-					continue;
-				}
+				bool seamRow = (band.firstRow != 0 && j == static_cast<int>(band.firstRow));
 
-				for (int trCount = 0; trCount < 2; ++trCount)
+				for (int i = 0; i < static_cast<int>(scanGrid->w) - 1; ++i)
 				{
-					int idx = tri[trCount];
-					if (idx < 0)
-					{
-						continue;
-					}
-					const Tuple3i& t = tris[idx];
-
-					const CCVector3* A = getPoint(t.u[0]);
-					const CCVector3* B = getPoint(t.u[1]);
-					const CCVector3* C = getPoint(t.u[2]);
+					// form the triangles with the nearest neighbors
+					// and accumulate the corresponding normals
+					Tuple3i triangles[2];
+					int     triangleCount = TriangulateGridCell(*this, *scanGrid, i, j, sensorOrigin, minTriangleAngle_deg, minAngleCos, triangles);
 
-					// now check the triangle angles
-					if (minTriangleAngle_deg > 0)
+					for (int k = 0; k < triangleCount; ++k)
 					{
-						CCVector3 uAB = (*B - *A);
-						uAB.normalize();
-						CCVector3 uCA = (*A - *C);
-						uCA.normalize();
+						const Tuple3i& t = triangles[k];
 
-						PointCoordinateType cosA = -uCA.dot(uAB);
-						if (cosA > minAngleCos)
-						{
-							continue;
-						}
+						const CCVector3* A = getPoint(t.u[0]);
+						const CCVector3* B = getPoint(t.u[1]);
+						const CCVector3* C = getPoint(t.u[2]);
 
-						CCVector3 uBC = (*C - *B);
-						uBC.normalize();
-						PointCoordinateType cosB = -uAB.dot(uBC);
-						if (cosB > minAngleCos)
-						{
-							continue;
-						}
+						// compute face normal (right hand rule)
+						CCVector3 N = (*B - *A).cross(*C - *A);
 
-						PointCoordinateType cosC = -uBC.dot(uCA);
-						if (cosC > minAngleCos)
+						// we add this normal to all triangle vertices
+						for (int pointIndex : t.u)
 						{
-							continue;
+							if (seamRow && (pointIndex == scanGrid->indexes[j * scanGrid->w + i] || pointIndex == scanGrid->indexes[j * scanGrid->w + (i + 1)]))
+							{
+								bandSeamNormals.push_back({pointIndex, N});
+							}
+							else
+							{
+								theNorms[pointIndex] += N;
+							}
 						}
 					}
-
-					// compute face normal (right hand rule)
-					CCVector3 N = (*B - *A).cross(*C - *A);
-
-					// we add this normal to all triangle vertices
-					theNorms[t.u[0]] += N;
-					theNorms[t.u[1]] += N;
-					theNorms[t.u[2]] += N;
 				}
 			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+			return;
+		}
 
-			if (pDlg)
-			{
-				// update progress dialog
-				if (pDlg->wasCanceled())
-				{
-					unallocateNorms();
-					ccLog::Warning("[computeNormalsWithGrids] Process cancelled by user");
-					return false;
-				}
-				else
-				{
-					pDlg->setValue(static_cast<unsigned>(j + 1) * scanGrid->w);
-				}
-			}
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	};
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, static_cast<int>(bands.size()), processBand);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+	for (int bandIndex = 0; bandIndex < static_cast<int>(bands.size()); ++bandIndex)
+	{
+		processBand(bandIndex);
+	}
+#endif
+
+	if (notEnoughMemory || cancelled)
+	{
+		unallocateNorms();
+		if (cancelled)
+			ccLog::Warning("[computeNormalsWithGrids] Process cancelled by user");
+		else
+			ccLog::Warning("[computeNormalsWithGrids] Not enough memory");
+		return false;
+	}
+
+	// now we can accumulate the seam normals (in the right order)
+	for (std::vector<SeamNormal>& bandSeamNormals : seamNormals)
+	{
+		for (const SeamNormal& seamNormal : bandSeamNormals)
+		{
+			theNorms[seamNormal.pointIndex] += seamNormal.N;
 		}
+		bandSeamNormals = std::vector<SeamNormal>(); // release memory
 	}
 
 	// preferred orientation
@@ -6075,7 +6437,11 @@ bool ccPointCloud::computeNormalsWithGrids(double                       minTrian
 	{
 		return false;
 	}
-	for (unsigned i = 0; i < pointCount; i++)
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(omp_get_max_threads())
+#endif
+	for (int i = 0; i < static_cast<int>(pointCount); i++)
 	{
 		CCVector3& N = theNorms[i];
 		// normalize the 'mean' normal
@@ -6123,40 +6489,42 @@ bool ccPointCloud::orientNormalsWithGrids(ccProgressDialog* pDlg /*=nullptr*/)
 		return false;
 	}
 
+	// the grids are processed by bands of rows, in parallel
+	std::vector<GridBand> bands;
+	if (!SplitGridsInBands(*this, 0, "orientNormalsWithGrids", bands))
+	{
+		return false;
+	}
+
 	// progress dialog
+	CCCoreLib::NormalizedProgress nProgress(pDlg, static_cast<unsigned>(bands.size()));
 	if (pDlg)
 	{
 		pDlg->setWindowTitle(QObject::tr("Orienting normals"));
 		pDlg->setLabelText(QObject::tr("Points: %L1").arg(pointCount));
-		pDlg->setRange(0, static_cast<int>(pointCount));
 		pDlg->show();
 		QCoreApplication::processEvents();
 	}
 
-	// for each grid cell
-	int progressIndex = 0;
-	for (size_t gi = 0; gi < gridCount(); ++gi)
+	std::atomic<bool> cancelled(false);
+
+	auto processBand = [&](int bandIndex)
 	{
-		const ccPointCloud::Grid::Shared& scanGrid = grid(gi);
-		if (scanGrid && scanGrid->indexes.empty())
-		{
-			// empty grid, we skip it
-			continue;
-		}
-		if (!scanGrid || scanGrid->h == 0 || scanGrid->w == 0 || scanGrid->indexes.size() != static_cast<size_t>(scanGrid->h) * scanGrid->w)
+		if (cancelled)
 		{
-			// invalid grid
-			ccLog::Warning(QString("[orientNormalsWithGrids] Grid structure #%i is invalid").arg(gi + 1));
-			continue;
+			return;
 		}
 
+		const GridBand&                   band     = bands[bandIndex];
+		const ccPointCloud::Grid::Shared& scanGrid = grid(band.gridIndex);
+
 		// ccGLMatrixd toSensorCS = scanGrid->sensorPosition.inverse();
 		CCVector3 sensorOrigin = (scanGrid->sensorPosition.getTranslationAsVec3D() /* + m_globalShift*/).toPC();
 
-		const int* _indexGrid = scanGrid->indexes.data();
-		for (int j = 0; j < static_cast<int>(scanGrid->h); ++j)
+		const int* _indexGrid = scanGrid->indexes.data() + static_cast<size_t>(band.firstRow) * scanGrid->w;
+		for (unsigned j = band.firstRow; j < band.lastRow; ++j)
 		{
-			for (int i = 0; i < static_cast<int>(scanGrid->w); ++i, ++_indexGrid)
+			for (unsigned i = 0; i < scanGrid->w; ++i, ++_indexGrid)
 			{
 				if (*_indexGrid >= 0)
 				{
@@ -6178,24 +6546,33 @@ bool ccPointCloud::orientNormalsWithGrids(ccProgressDialog* pDlg /*=nullptr*/)
 						N = -N;
 						setPointNormalIndex(pointIndex, ccNormalVectors::GetNormIndex(N));
 					}
-
-					if (pDlg)
-					{
-						// update progress dialog
-						if (pDlg->wasCanceled())
-						{
-							unallocateNorms();
-							ccLog::Warning("[orientNormalsWithGrids] Process cancelled by user");
-							return false;
-						}
-						else
-						{
-							pDlg->setValue(++progressIndex);
-						}
-					}
 				}
 			}
 		}
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	};
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, static_cast<int>(bands.size()), processBand);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+	for (int bandIndex = 0; bandIndex < static_cast<int>(bands.size()); ++bandIndex)
+	{
+		processBand(bandIndex);
+	}
+#endif
+
+	if (cancelled)
+	{
+		unallocateNorms();
+		ccLog::Warning("[orientNormalsWithGrids] Process cancelled by user");
+		return false;
 	}
 
 	return true;
@@ -6297,9 +6674,10 @@ bool ccPointCloud::computeNormalsWithOctree(CCCoreLib::LOCAL_MODEL_TYPES model,
 }
 
 bool ccPointCloud::orientNormalsWithMST(unsigned          kNN /*=6*/,
-                                        ccProgressDialog* pDlg /*=nullptr*/)
+                                        ccProgressDialog* pDlg /*=nullptr*/,
+                                        int               maxThreadCount /*=0*/)
 {
-	return ccMinimumSpanningTreeForNormsDirection::OrientNormals(this, kNN, pDlg);
+	return ccMinimumSpanningTreeForNormsDirection::OrientNormals(this, kNN, pDlg, maxThreadCount);
 }
 
 bool ccPointCloud::orientNormalsWithFM(unsigned char     level,
@@ -6628,137 +7006,87 @@ ccMesh* ccPointCloud::triangulateGrid(const Grid& grid, double minTriangleAngle_
 
 	ccMesh* mesh = new ccMesh(const_cast<ccPointCloud*>(this));
 	mesh->setName("Grid mesh");
-	if (!mesh->reserve((static_cast<size_t>(grid.h) * grid.w) * 2))
+
+	unsigned cellRowCount    = (grid.h > 1 ? grid.h - 1 : 0);
+	unsigned cellColumnCount = (grid.w > 1 ? grid.w - 1 : 0);
+	// max number of triangles per row of cells
+	size_t rowTriangleCount = static_cast<size_t>(cellColumnCount) * 2;
+
+	// the triangles are directly written in the (preallocated) mesh buffer
+	if (!mesh->resize(cellRowCount * rowTriangleCount))
 	{
 		ccLog::Warning("[ccPointCloud::triangulateGrid] Not enough memory");
+		delete mesh;
 		return nullptr;
 	}
 
 	PointCoordinateType minAngleCos = static_cast<PointCoordinateType>(cos(CCCoreLib::DegreesToRadians(minTriangleAngle_deg)));
 	// double minTriangleAngle_rad = CCCoreLib::DegreesToRadians(minTriangleAngle_deg);
 
-	for (int j = 0; j < static_cast<int>(grid.h) - 1; ++j)
+	// the rows of cells are processed in parallel (by bands)
+	unsigned                    bandRowCount = std::max(1u, s_gridBandCellCount / std::max(1u, grid.w));
+	unsigned                    bandCount    = (cellRowCount + bandRowCount - 1) / bandRowCount;
+	CCCoreLib::VerticesIndexes* triangles    = (mesh->size() != 0 ? mesh->getTriangleVertIndexes(0) : nullptr);
+	std::vector<size_t>         bandTriangleCount;
+	try
 	{
-		for (int i = 0; i < static_cast<int>(grid.w) - 1; ++i)
-		{
-			const int& v0 = grid.indexes[j * grid.w + i];
-			const int& v1 = grid.indexes[j * grid.w + (i + 1)];
-			const int& v2 = grid.indexes[(j + 1) * grid.w + i];
-			const int& v3 = grid.indexes[(j + 1) * grid.w + (i + 1)];
-
-			bool topo[4] = {v0 >= 0, v1 >= 0, v2 >= 0, v3 >= 0};
-
-			int mask   = 0;
-			int pixels = 0;
-
-			for (int j = 0; j < 4; ++j)
-			{
-				if (topo[j])
-				{
-					mask |= 1 << j;
-					pixels += 1;
-				}
-			}
-
-			if (pixels < 3)
-			{
-				continue;
-			}
+		bandTriangleCount.resize(bandCount, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccPointCloud::triangulateGrid] Not enough memory");
+		delete mesh;
+		return nullptr;
+	}
 
-			Tuple3i tris[4]{
-			    {v0, v2, v1},
-			    {v0, v3, v1},
-			    {v0, v2, v3},
-			    {v1, v2, v3}};
+	auto processBand = [&](int bandIndex)
+	{
+		unsigned firstRow = bandIndex * bandRowCount;
+		unsigned lastRow  = std::min(firstRow + bandRowCount, cellRowCount);
 
-			int tri[2]{-1, -1};
+		// each band writes its triangles at the beginning of its own part of the buffer
+		CCCoreLib::VerticesIndexes* bandTriangles = triangles + firstRow * rowTriangleCount;
+		size_t&                     triangleCount = bandTriangleCount[bandIndex];
 
-			switch (mask)
+		for (int j = static_cast<int>(firstRow); j < static_cast<int>(lastRow); ++j)
+		{
+			for (int i = 0; i < static_cast<int>(cellColumnCount); ++i)
 			{
-			case 7:
-				tri[0] = 0;
-				break;
-			case 11:
-				tri[0] = 1;
-				break;
-			case 13:
-				tri[0] = 2;
-				break;
-			case 14:
-				tri[0] = 3;
-				break;
-			case 15:
-			{
-				/* Choose the triangulation with smaller diagonal. */
-				double d0     = (*getPoint(v0) - sensorOrigin).normd();
-				double d1     = (*getPoint(v1) - sensorOrigin).normd();
-				double d2     = (*getPoint(v2) - sensorOrigin).normd();
-				double d3     = (*getPoint(v3) - sensorOrigin).normd();
-				float  ddiff1 = std::abs(d0 - d3);
-				float  ddiff2 = std::abs(d1 - d2);
-				if (ddiff1 < ddiff2)
-				{
-					tri[0] = 1;
-					tri[1] = 2;
-				}
-				else
+				Tuple3i cellTriangles[2];
+				int     cellTriangleCount = TriangulateGridCell(*this, grid, i, j, sensorOrigin, minTriangleAngle_deg, minAngleCos, cellTriangles);
+				for (int k = 0; k < cellTriangleCount; ++k)
 				{
-					tri[0] = 0;
-					tri[1] = 3;
+					const Tuple3i& t = cellTriangles[k];
+					bandTriangles[triangleCount++] = CCCoreLib::VerticesIndexes(t.u[0], t.u[1], t.u[2]);
 				}
-				break;
-			}
-
-			default:
-				continue;
 			}
+		}
+	};
 
-			for (int trCount = 0; trCount < 2; ++trCount)
-			{
-				int idx = tri[trCount];
-				if (idx < 0)
-				{
-					continue;
-				}
-				const Tuple3i& t = tris[idx];
-
-				// now check the triangle angles
-				if (minTriangleAngle_deg > 0)
-				{
-					const CCVector3* A = getPoint(t.u[0]);
-					const CCVector3* B = getPoint(t.u[1]);
-					const CCVector3* C = getPoint(t.u[2]);
-
-					CCVector3 uAB = (*B - *A);
-					uAB.normalize();
-					CCVector3 uCA = (*A - *C);
-					uCA.normalize();
-
-					PointCoordinateType cosA = -uCA.dot(uAB);
-					if (cosA > minAngleCos)
-					{
-						continue;
-					}
-
-					CCVector3 uBC = (*C - *B);
-					uBC.normalize();
-					PointCoordinateType cosB = -uAB.dot(uBC);
-					if (cosB > minAngleCos)
-					{
-						continue;
-					}
-
-					PointCoordinateType cosC = -uBC.dot(uCA);
-					if (cosC > minAngleCos)
-					{
-						continue;
-					}
-				}
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_for(0, static_cast<int>(bandCount), processBand);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(omp_get_max_threads())
+#endif
+	for (int bandIndex = 0; bandIndex < static_cast<int>(bandCount); ++bandIndex)
+	{
+		processBand(bandIndex);
+	}
+#endif
 
-				mesh->addTriangle(t.u[0], t.u[1], t.u[2]);
-			}
+	// now we can compact the buffer (in the bands order)
+	size_t triangleCount = 0;
+	for (unsigned bandIndex = 0; bandIndex < bandCount; ++bandIndex)
+	{
+		size_t firstTriangle = static_cast<size_t>(bandIndex) * bandRowCount * rowTriangleCount;
+		if (triangleCount != firstTriangle && bandTriangleCount[bandIndex] != 0)
+		{
+			memmove(triangles + triangleCount, triangles + firstTriangle, bandTriangleCount[bandIndex] * sizeof(CCCoreLib::VerticesIndexes));
 		}
+		triangleCount += bandTriangleCount[bandIndex];
 	}
+	mesh->resize(triangleCount);
 
 	if (mesh->size() == 0)
 	{
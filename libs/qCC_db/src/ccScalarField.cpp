@@ -25,6 +25,7 @@
 
 // system
 #include <algorithm>
+#include <cmath>
 
 using namespace CCCoreLib;
 
@@ -33,6 +34,36 @@ static const unsigned MAX_HISTOGRAM_SIZE = 512;
 //! Max SF name size (when saved to a file)
 static const size_t MaxSFNameLength = 1023;
 
+//! Returns the range of an integer storage type
+static bool GetIntegerStorageTypeRange(ccScalarField::StorageType type, double& minValue, double& maxValue)
+{
+	switch (type)
+	{
+	case ccScalarField::StorageType::UInt8:
+		minValue = 0.0;
+		maxValue = 255.0;
+		return true;
+	case ccScalarField::StorageType::Int8:
+		minValue = -128.0;
+		maxValue = 127.0;
+		return true;
+	case ccScalarField::StorageType::UInt16:
+		minValue = 0.0;
+		maxValue = 65535.0;
+		return true;
+	case ccScalarField::StorageType::Int16:
+		minValue = -32768.0;
+		maxValue = 32767.0;
+		return true;
+	case ccScalarField::StorageType::Int32:
+		minValue = -2147483648.0;
+		maxValue = 2147483647.0;
+		return true;
+	default:
+		return false;
+	}
+}
+
 ccScalarField::ccScalarField(const std::string& name /*=std::string()*/)
     : ScalarField(name)
     , m_showNaNValuesInGrey(true)
@@ -42,6 +73,7 @@ ccScalarField::ccScalarField(const std::string& name /*=std::string()*/)
     , m_colorScale(nullptr)
     , m_colorRampSteps(0)
     , m_modified(true)
+    , m_storageType(StorageType::Float32)
 {
 	setColorRampSteps(ccColorScale::DEFAULT_STEPS);
 	setColorScale(ccColorScalesManager::GetUniqueInstance()->getDefaultScale(ccColorScalesManager::BGYR));
@@ -60,6 +92,7 @@ ccScalarField::ccScalarField(const ccScalarField& sf)
     , m_colorRampSteps(sf.m_colorRampSteps)
     , m_histogram(sf.m_histogram)
     , m_modified(sf.m_modified)
+    , m_storageType(sf.m_storageType)
 {
 	computeMinAndMax();
 }
@@ -164,6 +197,19 @@ void ccScalarField::computeMinAndMax()
 {
 	ScalarField::computeMinAndMax();
 
+	// the values may have changed since the (integer) storage type was set
+	double typeMin = 0.0;
+	double typeMax = 0.0;
+	if (GetIntegerStorageTypeRange(m_storageType, typeMin, typeMax) && currentSize() != 0)
+	{
+		double rawMin = static_cast<double>(getMin()) - getOffset();
+		double rawMax = static_cast<double>(getMax()) - getOffset();
+		if (rawMin < typeMin || rawMax > typeMax)
+		{
+			m_storageType = StorageType::Float32;
+		}
+	}
+
 	m_displayRange.setBounds(getMin(), getMax());
 
 	// update histogram
@@ -771,3 +817,42 @@ void ccScalarField::importParametersFrom(const ccScalarField* sf)
 	setSaturationStart(sf->saturationRange().start());
 	setSaturationStop(sf->saturationRange().stop());
 }
+
+bool ccScalarField::setStorageType(StorageType type)
+{
+	if (!canBeStoredAs(type))
+	{
+		return false;
+	}
+
+	m_storageType = type;
+	return true;
+}
+
+bool ccScalarField::canBeStoredAs(StorageType type) const
+{
+	if (type == StorageType::Float32)
+	{
+		return true;
+	}
+
+	double typeMin = 0.0;
+	double typeMax = 0.0;
+	if (!GetIntegerStorageTypeRange(type, typeMin, typeMax))
+	{
+		assert(false);
+		return false;
+	}
+
+	const std::vector<float>& values = *this;
+	for (float value : values)
+	{
+		// NaN values are rejected by the comparisons
+		if (!(value >= typeMin && value <= typeMax) || value != std::floor(value))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
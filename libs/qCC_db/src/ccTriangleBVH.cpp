@@ -0,0 +1,486 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_for.h>
+#endif
+
+#include "ccTriangleBVH.h"
+
+// CCCoreLib
+#include <GenericIndexedMesh.h>
+#include <GenericProgressCallback.h>
+
+// Qt
+#include <QString>
+
+// System
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+namespace
+{
+	//! Triangle (used during the hierarchy construction)
+	struct BuildTriangle
+	{
+		CCVector3 bbMin;
+		CCVector3 bbMax;
+		CCVector3 center;
+		unsigned  index;
+	};
+
+	//! Relative tolerance to consider that two triangles are equally close (robust mode)
+	static const PointCoordinateType s_robustTolerance = static_cast<PointCoordinateType>(1.0e-5);
+
+	inline PointCoordinateType Clamp01(PointCoordinateType t)
+	{
+		return std::min<PointCoordinateType>(std::max<PointCoordinateType>(t, 0), 1);
+	}
+} // namespace
+
+ccTriangleBVH::ccTriangleBVH()
+    : m_depth(0)
+{
+}
+
+ccTriangleBVH::Shared ccTriangleBVH::Build(CCCoreLib::GenericIndexedMesh*      mesh,
+                                           int                                 maxThreadCount /*=0*/,
+                                           CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	if (!mesh || mesh->size() == 0)
+	{
+		return {};
+	}
+
+	const unsigned triCount = mesh->size();
+
+	// the tree is deep enough so that each leaf contains at most MAX_LEAF_SIZE triangles
+	unsigned depth = 0;
+	while (((triCount - 1) >> depth) + 1 > MAX_LEAF_SIZE)
+	{
+		++depth;
+	}
+
+	Shared                                     bvh(new ccTriangleBVH);
+	std::vector<BuildTriangle>                 triangles;
+	std::vector<std::pair<unsigned, unsigned>> ranges;
+	std::vector<std::pair<unsigned, unsigned>> nextRanges;
+	try
+	{
+		triangles.resize(triCount);
+		for (std::vector<PointCoordinateType>& data : bvh->m_data)
+		{
+			data.resize(triCount);
+		}
+		bvh->m_indexes.resize(triCount);
+		bvh->m_nodeMin.resize((static_cast<size_t>(2) << depth) - 1);
+		bvh->m_nodeMax.resize(bvh->m_nodeMin.size());
+		ranges.reserve(static_cast<size_t>(1) << depth);
+		nextRanges.reserve(ranges.capacity());
+	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory
+		return {};
+	}
+	bvh->m_depth = depth;
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Triangle hierarchy");
+			progressCb->setInfo(qPrintable(QString("Triangles: %1").arg(triCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	// triangles bounding-boxes
+	for (unsigned i = 0; i < triCount; ++i)
+	{
+		CCVector3 A;
+		CCVector3 B;
+		CCVector3 C;
+		mesh->getTriangleVertices(i, A, B, C);
+
+		BuildTriangle& t = triangles[i];
+		for (unsigned char d = 0; d < 3; ++d)
+		{
+			t.bbMin.u[d] = std::min(A.u[d], std::min(B.u[d], C.u[d]));
+			t.bbMax.u[d] = std::max(A.u[d], std::max(B.u[d], C.u[d]));
+		}
+		t.center = (A + B + C) / 3;
+		t.index  = i;
+	}
+
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#endif
+
+	// split the nodes level by level (the nodes of a given level are independent)
+	ranges.emplace_back(0, triCount);
+	for (unsigned level = 0; level <= depth; ++level)
+	{
+		const int      nodeCount = static_cast<int>(ranges.size());
+		const unsigned firstNode = (1u << level) - 1;
+		const bool     leaves    = (level == depth);
+		if (!leaves)
+		{
+			nextRanges.resize(2 * ranges.size());
+		}
+
+		auto processNode = [&](int j)
+		{
+			const unsigned begin = ranges[j].first;
+			const unsigned end   = ranges[j].second;
+
+			// node bounding-box (and triangle centers bounding-box)
+			CCVector3 bbMin     = triangles[begin].bbMin;
+			CCVector3 bbMax     = triangles[begin].bbMax;
+			CCVector3 centerMin = triangles[begin].center;
+			CCVector3 centerMax = centerMin;
+			for (unsigned i = begin + 1; i < end; ++i)
+			{
+				const BuildTriangle& t = triangles[i];
+				for (unsigned char d = 0; d < 3; ++d)
+				{
+					bbMin.u[d]     = std::min(bbMin.u[d], t.bbMin.u[d]);
+					bbMax.u[d]     = std::max(bbMax.u[d], t.bbMax.u[d]);
+					centerMin.u[d] = std::min(centerMin.u[d], t.center.u[d]);
+					centerMax.u[d] = std::max(centerMax.u[d], t.center.u[d]);
+				}
+			}
+			bvh->m_nodeMin[firstNode + j] = bbMin;
+			bvh->m_nodeMax[firstNode + j] = bbMax;
+
+			if (leaves)
+			{
+				return;
+			}
+
+			// median split along the largest dimension of the triangle centers
+			CCVector3     diag = centerMax - centerMin;
+			unsigned char dim  = (diag.x >= diag.y ? (diag.x >= diag.z ? 0 : 2) : (diag.y >= diag.z ? 1 : 2));
+
+			const unsigned mid = begin + (end - begin) / 2;
+			std::nth_element(triangles.begin() + begin,
+			                 triangles.begin() + mid,
+			                 triangles.begin() + end,
+			                 [dim](const BuildTriangle& a, const BuildTriangle& b) { return a.center.u[dim] < b.center.u[dim]; });
+
+			nextRanges[2 * j]     = {begin, mid};
+			nextRanges[2 * j + 1] = {mid, end};
+		};
+
+#ifdef CC_CORE_LIB_USES_TBB
+		tbb::parallel_for(0, nodeCount, processNode);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int j = 0; j < nodeCount; ++j)
+		{
+			processNode(j);
+		}
+#endif
+
+		if (!leaves)
+		{
+			std::swap(ranges, nextRanges);
+		}
+
+		if (progressCb)
+		{
+			progressCb->update((100.0f * (level + 1)) / (depth + 1));
+			if (progressCb->isCancelRequested())
+			{
+				return {};
+			}
+		}
+	}
+
+	// store the triangles in leaf order
+	for (unsigned i = 0; i < triCount; ++i)
+	{
+		const unsigned triIndex = triangles[i].index;
+
+		CCVector3 A;
+		CCVector3 B;
+		CCVector3 C;
+		mesh->getTriangleVertices(triIndex, A, B, C);
+
+		CCVector3 AB = B - A;
+		CCVector3 AC = C - A;
+		CCVector3 BC = C - B;
+		CCVector3 N  = AB.cross(AC);
+
+		PointCoordinateType normN = N.norm();
+		PointCoordinateType ab2   = AB.norm2();
+		PointCoordinateType ac2   = AC.norm2();
+		PointCoordinateType bc2   = BC.norm2();
+
+		std::vector<PointCoordinateType>* data = bvh->m_data;
+		data[AX][i]                            = A.x;
+		data[AY][i]                            = A.y;
+		data[AZ][i]                            = A.z;
+		data[ABX][i]                           = AB.x;
+		data[ABY][i]                           = AB.y;
+		data[ABZ][i]                           = AB.z;
+		data[ACX][i]                           = AC.x;
+		data[ACY][i]                           = AC.y;
+		data[ACZ][i]                           = AC.z;
+		data[NX][i]                            = N.x;
+		data[NY][i]                            = N.y;
+		data[NZ][i]                            = N.z;
+		data[INV_N][i]                         = (normN > 0 ? 1 / normN : 0);
+		data[INV_AB2][i]                       = (ab2 > 0 ? 1 / ab2 : 0);
+		data[INV_AC2][i]                       = (ac2 > 0 ? 1 / ac2 : 0);
+		data[INV_BC2][i]                       = (bc2 > 0 ? 1 / bc2 : 0);
+		bvh->m_indexes[i]                      = triIndex;
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	return bvh;
+}
+
+PointCoordinateType ccTriangleBVH::boxSquareDist(const CCVector3& P, unsigned nodeIndex) const
+{
+	const CCVector3& bbMin      = m_nodeMin[nodeIndex];
+	const CCVector3& bbMax      = m_nodeMax[nodeIndex];
+	PointCoordinateType squareDist = 0;
+	for (unsigned char d = 0; d < 3; ++d)
+	{
+		PointCoordinateType delta = std::max<PointCoordinateType>(0, std::max(bbMin.u[d] - P.u[d], P.u[d] - bbMax.u[d]));
+		squareDist += delta * delta;
+	}
+	return squareDist;
+}
+
+void ccTriangleBVH::searchNode(const CCVector3& P,
+                               unsigned         nodeIndex,
+                               unsigned         level,
+                               unsigned         begin,
+                               unsigned         end,
+                               bool             robust,
+                               ClosestTriangle& result) const
+{
+	if (level == m_depth)
+	{
+		// leaf: we compute all the point/triangle distances at once (the loop is branch-free, so that it can be vectorized)
+		PointCoordinateType squareDists[MAX_LEAF_SIZE];
+		PointCoordinateType planeDists[MAX_LEAF_SIZE];
+		const unsigned      count = end - begin;
+
+		const PointCoordinateType* ax    = m_data[AX].data() + begin;
+		const PointCoordinateType* ay    = m_data[AY].data() + begin;
+		const PointCoordinateType* az    = m_data[AZ].data() + begin;
+		const PointCoordinateType* abx   = m_data[ABX].data() + begin;
+		const PointCoordinateType* aby   = m_data[ABY].data() + begin;
+		const PointCoordinateType* abz   = m_data[ABZ].data() + begin;
+		const PointCoordinateType* acx   = m_data[ACX].data() + begin;
+		const PointCoordinateType* acy   = m_data[ACY].data() + begin;
+		const PointCoordinateType* acz   = m_data[ACZ].data() + begin;
+		const PointCoordinateType* nx    = m_data[NX].data() + begin;
+		const PointCoordinateType* ny    = m_data[NY].data() + begin;
+		const PointCoordinateType* nz    = m_data[NZ].data() + begin;
+		const PointCoordinateType* invN  = m_data[INV_N].data() + begin;
+		const PointCoordinateType* invAB = m_data[INV_AB2].data() + begin;
+		const PointCoordinateType* invAC = m_data[INV_AC2].data() + begin;
+		const PointCoordinateType* invBC = m_data[INV_BC2].data() + begin;
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			// AP
+			PointCoordinateType px = P.x - ax[i];
+			PointCoordinateType py = P.y - ay[i];
+			PointCoordinateType pz = P.z - az[i];
+			// BP = AP - AB
+			PointCoordinateType qx = px - abx[i];
+			PointCoordinateType qy = py - aby[i];
+			PointCoordinateType qz = pz - abz[i];
+			// BC = AC - AB
+			PointCoordinateType bcx = acx[i] - abx[i];
+			PointCoordinateType bcy = acy[i] - aby[i];
+			PointCoordinateType bcz = acz[i] - abz[i];
+
+			// distance to the triangle plane
+			PointCoordinateType planeDist = (nx[i] * px + ny[i] * py + nz[i] * pz) * invN[i];
+
+			// is the projection inside the triangle? (sign of the 3 edge functions)
+			PointCoordinateType e0 = nx[i] * (aby[i] * pz - abz[i] * py) + ny[i] * (abz[i] * px - abx[i] * pz) + nz[i] * (abx[i] * py - aby[i] * px);
+			PointCoordinateType e1 = nx[i] * (bcy * qz - bcz * qy) + ny[i] * (bcz * qx - bcx * qz) + nz[i] * (bcx * qy - bcy * qx);
+			PointCoordinateType e2 = nx[i] * (py * acz[i] - pz * acy[i]) + ny[i] * (pz * acx[i] - px * acz[i]) + nz[i] * (px * acy[i] - py * acx[i]);
+			bool                inside = (e0 >= 0 && e1 >= 0 && e2 >= 0 && invN[i] > 0);
+
+			// otherwise the closest point lies on one of the edges
+			PointCoordinateType t0  = Clamp01((px * abx[i] + py * aby[i] + pz * abz[i]) * invAB[i]);
+			PointCoordinateType d0x = px - t0 * abx[i];
+			PointCoordinateType d0y = py - t0 * aby[i];
+			PointCoordinateType d0z = pz - t0 * abz[i];
+			PointCoordinateType t1  = Clamp01((qx * bcx + qy * bcy + qz * bcz) * invBC[i]);
+			PointCoordinateType d1x = qx - t1 * bcx;
+			PointCoordinateType d1y = qy - t1 * bcy;
+			PointCoordinateType d1z = qz - t1 * bcz;
+			PointCoordinateType t2  = Clamp01((px * acx[i] + py * acy[i] + pz * acz[i]) * invAC[i]);
+			PointCoordinateType d2x = px - t2 * acx[i];
+			PointCoordinateType d2y = py - t2 * acy[i];
+			PointCoordinateType d2z = pz - t2 * acz[i];
+
+			PointCoordinateType edgeSquareDist = std::min(d0x * d0x + d0y * d0y + d0z * d0z,
+			                                              std::min(d1x * d1x + d1y * d1y + d1z * d1z,
+			                                                       d2x * d2x + d2y * d2y + d2z * d2z));
+
+			squareDists[i] = (inside ? planeDist * planeDist : edgeSquareDist);
+			planeDists[i]  = planeDist;
+		}
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			const PointCoordinateType squareDist = squareDists[i];
+			if (result.triangleIndex < 0)
+			{
+				if (squareDist < result.squareDist)
+				{
+					result.triangleIndex = static_cast<int>(m_indexes[begin + i]);
+					result.squareDist    = squareDist;
+					result.planeDist     = planeDists[i];
+				}
+			}
+			else if (squareDist < result.squareDist * (1 - s_robustTolerance))
+			{
+				result.triangleIndex = static_cast<int>(m_indexes[begin + i]);
+				result.squareDist    = squareDist;
+				result.planeDist     = planeDists[i];
+			}
+			else if (robust
+			         && squareDist <= result.squareDist * (1 + s_robustTolerance)
+			         && std::abs(planeDists[i]) > std::abs(result.planeDist))
+			{
+				// (almost) equally close triangles: we keep the one that faces the point the most
+				result.triangleIndex = static_cast<int>(m_indexes[begin + i]);
+				result.squareDist    = std::min(result.squareDist, squareDist);
+				result.planeDist     = planeDists[i];
+			}
+			else if (squareDist < result.squareDist)
+			{
+				result.squareDist = squareDist;
+			}
+		}
+		return;
+	}
+
+	const unsigned left  = 2 * nodeIndex + 1;
+	const unsigned right = left + 1;
+	const unsigned mid   = begin + (end - begin) / 2;
+
+	PointCoordinateType leftSquareDist  = boxSquareDist(P, left);
+	PointCoordinateType rightSquareDist = boxSquareDist(P, right);
+
+	// we visit the closest child first
+	bool leftFirst = (leftSquareDist <= rightSquareDist);
+	for (unsigned k = 0; k < 2; ++k)
+	{
+		const bool                visitLeft  = (leftFirst == (k == 0));
+		const PointCoordinateType squareDist = (visitLeft ? leftSquareDist : rightSquareDist);
+
+		PointCoordinateType maxSquareDist = result.squareDist;
+		if (result.triangleIndex >= 0 && robust)
+		{
+			maxSquareDist *= (1 + s_robustTolerance);
+		}
+
+		if (squareDist <= maxSquareDist)
+		{
+			if (visitLeft)
+				searchNode(P, left, level + 1, begin, mid, robust, result);
+			else
+				searchNode(P, right, level + 1, mid, end, robust, result);
+		}
+	}
+}
+
+bool ccTriangleBVH::findClosestTriangle(const CCVector3& P, PointCoordinateType maxSquareDist, bool robust, ClosestTriangle& result) const
+{
+	result               = ClosestTriangle();
+	result.squareDist    = (maxSquareDist >= 0 ? maxSquareDist : std::numeric_limits<PointCoordinateType>::max());
+	result.triangleIndex = -1;
+
+	if (!m_indexes.empty() && boxSquareDist(P, 0) < result.squareDist)
+	{
+		searchNode(P, 0, 0, 0, size(), robust, result);
+	}
+
+	return result.triangleIndex >= 0;
+}
+
+CCVector3 ccTriangleBVH::ClosestPointOnTriangle(const CCVector3& P, const CCVector3& A, const CCVector3& B, const CCVector3& C)
+{
+	// see 'Real-Time Collision Detection' (C. Ericson), section 5.1.5
+	CCVector3 AB = B - A;
+	CCVector3 AC = C - A;
+	CCVector3 AP = P - A;
+
+	PointCoordinateType d1 = AB.dot(AP);
+	PointCoordinateType d2 = AC.dot(AP);
+	if (d1 <= 0 && d2 <= 0)
+		return A;
+
+	CCVector3           BP = P - B;
+	PointCoordinateType d3 = AB.dot(BP);
+	PointCoordinateType d4 = AC.dot(BP);
+	if (d3 >= 0 && d4 <= d3)
+		return B;
+
+	PointCoordinateType vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		return A + AB * (d1 / (d1 - d3));
+
+	CCVector3           CP = P - C;
+	PointCoordinateType d5 = AB.dot(CP);
+	PointCoordinateType d6 = AC.dot(CP);
+	if (d6 >= 0 && d5 <= d6)
+		return C;
+
+	PointCoordinateType vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		return A + AC * (d2 / (d2 - d6));
+
+	PointCoordinateType va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+		return B + (C - B) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	PointCoordinateType denom = va + vb + vc;
+	if (denom == 0)
+	{
+		// degenerate triangle
+		return A;
+	}
+	PointCoordinateType v = vb / denom;
+	PointCoordinateType w = vc / denom;
+	return A + AB * v + AC * w;
+}
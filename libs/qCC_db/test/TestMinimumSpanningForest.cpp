@@ -0,0 +1,233 @@
+#include "TestMinimumSpanningForest.h"
+
+#include "ccMinimumSpanningTreeForNormsDirection.h"
+
+#include <CCGeom.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+using KNNGraph  = ccMinimumSpanningTreeForNormsDirection::KNNGraph;
+using TreeEdges = std::vector<std::pair<unsigned, unsigned>>;
+
+//! Builds the kNN graph of a set of points (brute force), with a custom edge weight
+static KNNGraph BuildKNNGraph(const std::vector<CCVector3>& points, unsigned kNN, const std::function<float(unsigned, unsigned)>& edgeWeight)
+{
+	KNNGraph graph;
+	graph.firstEdge.push_back(0);
+	for (unsigned i = 0; i < points.size(); ++i)
+	{
+		std::vector<std::pair<float, unsigned>> neighbors;
+		for (unsigned j = 0; j < points.size(); ++j)
+		{
+			if (j != i)
+			{
+				neighbors.emplace_back((points[j] - points[i]).norm2(), j);
+			}
+		}
+		size_t count = std::min<size_t>(kNN, neighbors.size());
+		std::partial_sort(neighbors.begin(), neighbors.begin() + count, neighbors.end());
+		for (size_t n = 0; n < count; ++n)
+		{
+			graph.targets.push_back(neighbors[n].second);
+			graph.weights.push_back(edgeWeight(i, neighbors[n].second));
+		}
+		graph.firstEdge.push_back(static_cast<unsigned>(graph.targets.size()));
+	}
+	return graph;
+}
+
+//! Weight of an (undirected) edge of the graph (the lightest one if it appears in both directions)
+static float EdgeWeight(const KNNGraph& graph, unsigned v1, unsigned v2)
+{
+	float weight = -1.0f;
+	for (unsigned e = graph.firstEdge[v1]; e < graph.firstEdge[v1 + 1]; ++e)
+	{
+		if (graph.targets[e] == v2 && (weight < 0 || graph.weights[e] < weight))
+			weight = graph.weights[e];
+	}
+	for (unsigned e = graph.firstEdge[v2]; e < graph.firstEdge[v2 + 1]; ++e)
+	{
+		if (graph.targets[e] == v1 && (weight < 0 || graph.weights[e] < weight))
+			weight = graph.weights[e];
+	}
+	return weight;
+}
+
+//! Reference Minimum Spanning Forest (Prim's algorithm, on the undirected graph)
+/** \return the total weight
+**/
+static double PrimForestWeight(const KNNGraph& graph, size_t& treeEdgeCount)
+{
+	const unsigned vertexCount = static_cast<unsigned>(graph.firstEdge.size() - 1);
+
+	// undirected adjacency lists
+	std::vector<std::vector<std::pair<float, unsigned>>> adjacency(vertexCount);
+	for (unsigned v = 0; v < vertexCount; ++v)
+	{
+		for (unsigned e = graph.firstEdge[v]; e < graph.firstEdge[v + 1]; ++e)
+		{
+			adjacency[v].emplace_back(graph.weights[e], graph.targets[e]);
+			adjacency[graph.targets[e]].emplace_back(graph.weights[e], v);
+		}
+	}
+
+	using QueueItem = std::pair<float, unsigned>;
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+	std::vector<bool> visited(vertexCount, false);
+	double            totalWeight = 0.0;
+	treeEdgeCount                 = 0;
+
+	for (unsigned root = 0; root < vertexCount; ++root)
+	{
+		if (visited[root])
+			continue;
+
+		queue.emplace(0.0f, root);
+		bool isRoot = true;
+		while (!queue.empty())
+		{
+			QueueItem item = queue.top();
+			queue.pop();
+			if (visited[item.second])
+				continue;
+
+			visited[item.second] = true;
+			if (!isRoot)
+			{
+				totalWeight += item.first;
+				++treeEdgeCount;
+			}
+			isRoot = false;
+
+			for (const QueueItem& neighbor : adjacency[item.second])
+			{
+				if (!visited[neighbor.second])
+					queue.push(neighbor);
+			}
+		}
+	}
+
+	return totalWeight;
+}
+
+//! Checks that the forest has no cycle, and returns its total weight
+static double CheckForest(const KNNGraph& graph, const TreeEdges& treeEdges)
+{
+	std::vector<unsigned> parents(graph.firstEdge.size() - 1);
+	for (unsigned i = 0; i < parents.size(); ++i)
+		parents[i] = i;
+
+	auto findRoot = [&](unsigned v)
+	{
+		while (parents[v] != v)
+			v = parents[v];
+		return v;
+	};
+
+	double totalWeight = 0.0;
+	for (const std::pair<unsigned, unsigned>& edge : treeEdges)
+	{
+		unsigned root1 = findRoot(edge.first);
+		unsigned root2 = findRoot(edge.second);
+		if (root1 == root2)
+		{
+			// cycle
+			return -1.0;
+		}
+		parents[root2] = root1;
+
+		float weight = EdgeWeight(graph, edge.first, edge.second);
+		if (weight < 0)
+		{
+			// not an edge of the graph
+			return -1.0;
+		}
+		totalWeight += weight;
+	}
+
+	return totalWeight;
+}
+
+static void CompareWithPrim(const KNNGraph& graph)
+{
+	TreeEdges treeEdges;
+	ccMinimumSpanningTreeForNormsDirection::ComputeMinimumSpanningForest(graph, 0, treeEdges);
+
+	size_t primEdgeCount = 0;
+	double primWeight    = PrimForestWeight(graph, primEdgeCount);
+
+	double boruvkaWeight = CheckForest(graph, treeEdges);
+	QVERIFY(boruvkaWeight >= 0);
+	QCOMPARE(treeEdges.size(), primEdgeCount);
+	QVERIFY(std::abs(boruvkaWeight - primWeight) <= 1.0e-5 * std::max(1.0, primWeight));
+}
+
+static std::vector<CCVector3> RandomPoints(unsigned count, unsigned seed, const CCVector3& offset = CCVector3(0, 0, 0))
+{
+	std::mt19937                          generator(seed);
+	std::uniform_real_distribution<float> coord(0.0f, 1.0f);
+	std::vector<CCVector3>                points(count);
+	for (CCVector3& P : points)
+	{
+		P = CCVector3(coord(generator), coord(generator), coord(generator)) + offset;
+	}
+	return points;
+}
+
+void TestMinimumSpanningForest::testForestWeight() const
+{
+	for (unsigned seed = 1; seed <= 3; ++seed)
+	{
+		std::vector<CCVector3> points = RandomPoints(2000, seed);
+
+		// same weight as the normals orientation (from random normals)
+		std::mt19937                          generator(seed + 100);
+		std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+		std::vector<CCVector3>                normals(points.size());
+		for (CCVector3& N : normals)
+		{
+			N = CCVector3(coord(generator), coord(generator), coord(generator));
+			N.normalize();
+		}
+
+		KNNGraph graph = BuildKNNGraph(points,
+		                               6,
+		                               [&](unsigned i, unsigned j)
+		                               { return std::max(0.0f, 1.0f - std::abs(normals[i].dot(normals[j]))); });
+		CompareWithPrim(graph);
+	}
+}
+
+void TestMinimumSpanningForest::testDisconnectedGraph() const
+{
+	// two distant clusters: the kNN graph has (at least) two connected components
+	std::vector<CCVector3> points  = RandomPoints(500, 4);
+	std::vector<CCVector3> points2 = RandomPoints(500, 5, CCVector3(100, 0, 0));
+	points.insert(points.end(), points2.begin(), points2.end());
+
+	KNNGraph graph = BuildKNNGraph(points,
+	                               4,
+	                               [&](unsigned i, unsigned j)
+	                               { return (points[i] - points[j]).norm(); });
+	CompareWithPrim(graph);
+}
+
+void TestMinimumSpanningForest::testEqualWeights() const
+{
+	// many edges with the same weight: the ties must be broken consistently (no cycle)
+	std::vector<CCVector3> points = RandomPoints(2000, 6);
+
+	KNNGraph graph = BuildKNNGraph(points,
+	                               8,
+	                               [&](unsigned i, unsigned j)
+	                               { return static_cast<float>((i + j) % 3); });
+	CompareWithPrim(graph);
+}
+
+QTEST_MAIN(TestMinimumSpanningForest)
@@ -0,0 +1,19 @@
+#ifndef CC_TEST_MINIMUM_SPANNING_FOREST_HEADER
+#define CC_TEST_MINIMUM_SPANNING_FOREST_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestMinimumSpanningForest : public QObject
+{
+	Q_OBJECT
+  private Q_SLOTS:
+	/* Boruvka's forest is compared with the forest computed with Prim's algorithm */
+	void testForestWeight() const;
+
+	void testDisconnectedGraph() const;
+
+	void testEqualWeights() const;
+};
+
+#endif // CC_TEST_MINIMUM_SPANNING_FOREST_HEADER
@@ -0,0 +1,253 @@
+#include "TestNearestNeighbourIndex.h"
+
+#include "ccNearestNeighbourIndex.h"
+#include "ccPointCloud.h"
+
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+//! Creates a cloud with uniform points, a dense cluster and duplicated points
+static ccPointCloud* CreateCloud(unsigned count, unsigned seed)
+{
+	ccPointCloud* cloud = new ccPointCloud("cloud");
+	if (!cloud->reserve(count))
+	{
+		delete cloud;
+		return nullptr;
+	}
+
+	std::mt19937                                       gen(seed);
+	std::uniform_real_distribution<PointCoordinateType> uniform(-10, 10);
+	std::normal_distribution<PointCoordinateType>       cluster(0, static_cast<PointCoordinateType>(0.01));
+	for (unsigned i = 0; i < count; ++i)
+	{
+		if (i % 10 == 0 && i != 0)
+		{
+			// duplicated point
+			cloud->addPoint(*cloud->getPoint(i / 2));
+		}
+		else if (i % 3 == 0)
+		{
+			cloud->addPoint(CCVector3(cluster(gen) + 5, cluster(gen), cluster(gen) - 5));
+		}
+		else
+		{
+			cloud->addPoint(CCVector3(uniform(gen), uniform(gen), uniform(gen) / 10)); // flat cloud
+		}
+	}
+
+	return cloud;
+}
+
+static std::vector<CCVector3> CreateQueries(unsigned count, unsigned seed)
+{
+	std::mt19937                                       gen(seed);
+	std::uniform_real_distribution<PointCoordinateType> uniform(-12, 12);
+	std::vector<CCVector3>                              queries;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		queries.emplace_back(uniform(gen), uniform(gen), uniform(gen));
+	}
+	// the query points may also be cloud points
+	queries.emplace_back(5, 0, -5);
+	return queries;
+}
+
+static std::vector<PointCoordinateType> BruteForceSquareDistances(const ccPointCloud& cloud, const CCVector3& P)
+{
+	std::vector<PointCoordinateType> squareDists(cloud.size());
+	for (unsigned i = 0; i < cloud.size(); ++i)
+	{
+		squareDists[i] = (*cloud.getPoint(i) - P).norm2();
+	}
+	return squareDists;
+}
+
+void TestNearestNeighbourIndex::testNearestNeighbour() const
+{
+	QScopedPointer<ccPointCloud> cloud(CreateCloud(20000, 1));
+	QVERIFY(cloud);
+
+	ccNearestNeighbourIndex::Shared index = ccNearestNeighbourIndex::Build(cloud.data());
+	QVERIFY(index);
+	QCOMPARE(index->size(), cloud->size());
+
+	for (const CCVector3& P : CreateQueries(500, 2))
+	{
+		std::vector<PointCoordinateType> squareDists = BruteForceSquareDistances(*cloud, P);
+		PointCoordinateType              minSquareDist = *std::min_element(squareDists.begin(), squareDists.end());
+
+		PointCoordinateType squareDist = -1;
+		int                 nnIndex    = index->findNearestNeighbour(P, -1, squareDist);
+		QVERIFY(nnIndex >= 0 && nnIndex < static_cast<int>(cloud->size()));
+		QCOMPARE(squareDist, minSquareDist);
+		// there may be several points at the same distance
+		QCOMPARE(squareDists[nnIndex], minSquareDist);
+	}
+}
+
+void TestNearestNeighbourIndex::testNearestNeighbourMaxDistance() const
+{
+	QScopedPointer<ccPointCloud> cloud(CreateCloud(5000, 3));
+	QVERIFY(cloud);
+
+	ccNearestNeighbourIndex::Shared index = ccNearestNeighbourIndex::Build(cloud.data());
+	QVERIFY(index);
+
+	const PointCoordinateType maxSquareDist = static_cast<PointCoordinateType>(0.25);
+	for (const CCVector3& P : CreateQueries(500, 4))
+	{
+		std::vector<PointCoordinateType> squareDists   = BruteForceSquareDistances(*cloud, P);
+		PointCoordinateType              minSquareDist = *std::min_element(squareDists.begin(), squareDists.end());
+
+		PointCoordinateType squareDist = -1;
+		int                 nnIndex    = index->findNearestNeighbour(P, maxSquareDist, squareDist);
+		if (minSquareDist <= maxSquareDist)
+		{
+			QVERIFY(nnIndex >= 0);
+			QCOMPARE(squareDist, minSquareDist);
+		}
+		else
+		{
+			QCOMPARE(nnIndex, -1);
+		}
+	}
+}
+
+void TestNearestNeighbourIndex::testKNearestNeighbours() const
+{
+	QScopedPointer<ccPointCloud> cloud(CreateCloud(10000, 5));
+	QVERIFY(cloud);
+
+	ccNearestNeighbourIndex::Shared index = ccNearestNeighbourIndex::Build(cloud.data());
+	QVERIFY(index);
+
+	ccNearestNeighbourIndex::KNNBuffer buffer;
+	for (unsigned k : {1u, 6u, 17u, 64u})
+	{
+		for (const CCVector3& P : CreateQueries(100, 6 + k))
+		{
+			std::vector<PointCoordinateType> squareDists = BruteForceSquareDistances(*cloud, P);
+			std::sort(squareDists.begin(), squareDists.end());
+
+			unsigned found = index->findKNearestNeighbours(P, k, buffer);
+			QCOMPARE(found, k);
+			QVERIFY(buffer.neighbours.size() >= found);
+			for (unsigned i = 0; i < found; ++i)
+			{
+				// sorted by increasing distance
+				QCOMPARE(buffer.neighbours[i].first, squareDists[i]);
+				QCOMPARE((*cloud->getPoint(buffer.neighbours[i].second) - P).norm2(), squareDists[i]);
+			}
+		}
+	}
+
+	// max distance
+	const PointCoordinateType maxSquareDist = 1;
+	for (const CCVector3& P : CreateQueries(100, 7))
+	{
+		std::vector<PointCoordinateType> squareDists = BruteForceSquareDistances(*cloud, P);
+		unsigned expectedCount = static_cast<unsigned>(std::count_if(squareDists.begin(), squareDists.end(), [&](PointCoordinateType d2)
+		                                                             { return d2 <= maxSquareDist; }));
+
+		unsigned found = index->findKNearestNeighbours(P, 32, buffer, maxSquareDist);
+		QCOMPARE(found, std::min(32u, expectedCount));
+	}
+}
+
+void TestNearestNeighbourIndex::testNeighboursInSphere() const
+{
+	QScopedPointer<ccPointCloud> cloud(CreateCloud(10000, 9));
+	QVERIFY(cloud);
+
+	ccNearestNeighbourIndex::Shared index = ccNearestNeighbourIndex::Build(cloud.data());
+	QVERIFY(index);
+
+	ccNearestNeighbourIndex::KNNBuffer buffer;
+	for (PointCoordinateType radius : {static_cast<PointCoordinateType>(0.05), static_cast<PointCoordinateType>(0.5), static_cast<PointCoordinateType>(2)})
+	{
+		for (const CCVector3& P : CreateQueries(100, 10))
+		{
+			std::vector<PointCoordinateType> squareDists = BruteForceSquareDistances(*cloud, P);
+			unsigned expectedCount = static_cast<unsigned>(std::count_if(squareDists.begin(), squareDists.end(), [&](PointCoordinateType d2)
+			                                                             { return d2 <= radius * radius; }));
+
+			unsigned found = index->findNeighboursInSphere(P, radius, buffer);
+			QCOMPARE(found, expectedCount);
+			for (unsigned i = 0; i < found; ++i)
+			{
+				QCOMPARE(buffer.neighbours[i].first, squareDists[buffer.neighbours[i].second]);
+			}
+		}
+	}
+}
+
+void TestNearestNeighbourIndex::testDegenerateClouds() const
+{
+	// single point
+	{
+		ccPointCloud cloud;
+		QVERIFY(cloud.reserve(1));
+		cloud.addPoint(CCVector3(1, 2, 3));
+
+		ccNearestNeighbourIndex::Shared index = ccNearestNeighbourIndex::Build(&cloud);
+		QVERIFY(index);
+		PointCoordinateType squareDist = -1;
+		QCOMPARE(index->findNearestNeighbour(CCVector3(0, 0, 0), -1, squareDist), 0);
+		QCOMPARE(squareDist, static_cast<PointCoordinateType>(14));
+	}
+
+	// all points at the same position
+	{
+		ccPointCloud cloud;
+		QVERIFY(cloud.reserve(100));
+		for (unsigned i = 0; i < 100; ++i)
+		{
+			cloud.addPoint(CCVector3(1, 1, 1));
+		}
+
+		ccNearestNeighbourIndex::Shared index = ccNearestNeighbourIndex::Build(&cloud);
+		QVERIFY(index);
+
+		ccNearestNeighbourIndex::KNNBuffer buffer;
+		QCOMPARE(index->findKNearestNeighbours(CCVector3(0, 0, 0), 10, buffer), 10u);
+		QCOMPARE(buffer.neighbours[9].first, static_cast<PointCoordinateType>(3));
+	}
+
+	// empty cloud
+	{
+		ccPointCloud cloud;
+		QVERIFY(!ccNearestNeighbourIndex::Build(&cloud));
+	}
+}
+
+void TestNearestNeighbourIndex::testSharedIndex() const
+{
+	QScopedPointer<ccPointCloud> cloud(CreateCloud(50000, 8));
+	QVERIFY(cloud);
+
+	std::vector<ccNearestNeighbourIndex::Shared> indexes(16);
+	QtConcurrent::blockingMap(indexes, [&](ccNearestNeighbourIndex::Shared& index)
+	                          { index = cloud->getNearestNeighbourIndex(); });
+
+	// the index is only built once
+	QVERIFY(indexes.front());
+	for (const ccNearestNeighbourIndex::Shared& index : indexes)
+	{
+		QCOMPARE(index.data(), indexes.front().data());
+	}
+
+	// and released when the geometry changes
+	QVERIFY(cloud->reserve(cloud->size() + 1));
+	cloud->addPoint(CCVector3(0, 0, 0));
+	cloud->notifyGeometryUpdate();
+	ccNearestNeighbourIndex::Shared newIndex = cloud->getNearestNeighbourIndex();
+	QVERIFY(newIndex);
+	QVERIFY(newIndex.data() != indexes.front().data());
+	QCOMPARE(newIndex->size(), cloud->size());
+}
+
+QTEST_MAIN(TestNearestNeighbourIndex)
@@ -0,0 +1,26 @@
+#ifndef CC_TEST_NEAREST_NEIGHBOUR_INDEX_HEADER
+#define CC_TEST_NEAREST_NEIGHBOUR_INDEX_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestNearestNeighbourIndex : public QObject
+{
+	Q_OBJECT
+  private Q_SLOTS:
+	/* Queries are compared with a brute force search */
+	void testNearestNeighbour() const;
+
+	void testNearestNeighbourMaxDistance() const;
+
+	void testKNearestNeighbours() const;
+
+	void testNeighboursInSphere() const;
+
+	void testDegenerateClouds() const;
+
+	//! Concurrent calls to ccGenericPointCloud::getNearestNeighbourIndex
+	void testSharedIndex() const;
+};
+
+#endif // CC_TEST_NEAREST_NEIGHBOUR_INDEX_HEADER
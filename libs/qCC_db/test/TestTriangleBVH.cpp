@@ -0,0 +1,252 @@
+#include "TestTriangleBVH.h"
+
+#include "ccMesh.h"
+#include "ccPointCloud.h"
+#include "ccTriangleBVH.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+//! Reference closest point on a triangle (see 'Real-Time Collision Detection', C. Ericson), in double precision
+static CCVector3d ReferenceClosestPoint(const CCVector3d& P, const CCVector3d& A, const CCVector3d& B, const CCVector3d& C)
+{
+	CCVector3d AB = B - A;
+	CCVector3d AC = C - A;
+	CCVector3d AP = P - A;
+	double     d1 = AB.dot(AP);
+	double     d2 = AC.dot(AP);
+	if (d1 <= 0 && d2 <= 0)
+		return A;
+
+	CCVector3d BP = P - B;
+	double     d3 = AB.dot(BP);
+	double     d4 = AC.dot(BP);
+	if (d3 >= 0 && d4 <= d3)
+		return B;
+
+	double vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		return A + AB * (d1 / (d1 - d3));
+
+	CCVector3d CP = P - C;
+	double     d5 = AB.dot(CP);
+	double     d6 = AC.dot(CP);
+	if (d6 >= 0 && d5 <= d6)
+		return C;
+
+	double vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		return A + AC * (d2 / (d2 - d6));
+
+	double va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+		return B + (C - B) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	double denom = va + vb + vc;
+	if (denom == 0)
+	{
+		// degenerate triangle (all the vertices are aligned): closest point on the 3 edges
+		CCVector3d best;
+		double     bestDist2 = std::numeric_limits<double>::max();
+		const CCVector3d* V[3] = {&A, &B, &C};
+		for (unsigned i = 0; i < 3; ++i)
+		{
+			const CCVector3d& S = *V[i];
+			const CCVector3d& E = *V[(i + 1) % 3];
+			CCVector3d        SE = E - S;
+			double            t  = (SE.norm2() > 0 ? std::max(0.0, std::min(1.0, (P - S).dot(SE) / SE.norm2())) : 0.0);
+			CCVector3d        Q  = S + SE * t;
+			if ((P - Q).norm2() < bestDist2)
+			{
+				bestDist2 = (P - Q).norm2();
+				best      = Q;
+			}
+		}
+		return best;
+	}
+
+	double v = vb / denom;
+	double w = vc / denom;
+	return A + AB * v + AC * w;
+}
+
+static double ReferenceSquareDist(const CCVector3& P, const CCVector3& A, const CCVector3& B, const CCVector3& C)
+{
+	CCVector3d Pd = P.toDouble();
+	return (ReferenceClosestPoint(Pd, A.toDouble(), B.toDouble(), C.toDouble()) - Pd).norm2();
+}
+
+static bool FuzzyEqual(double a, double b)
+{
+	return std::abs(a - b) <= 1.0e-4 * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+//! Creates a triangle soup (with a few degenerate triangles)
+static ccMesh* CreateMesh(unsigned triangleCount, unsigned seed)
+{
+	ccPointCloud* vertices = new ccPointCloud("vertices");
+	ccMesh*       mesh     = new ccMesh(vertices);
+	mesh->addChild(vertices);
+	if (!vertices->reserve(3 * triangleCount) || !mesh->reserve(triangleCount))
+	{
+		delete mesh;
+		return nullptr;
+	}
+
+	std::mt19937                                       gen(seed);
+	std::uniform_real_distribution<PointCoordinateType> position(-10, 10);
+	std::uniform_real_distribution<PointCoordinateType> offset(-1, 1);
+	for (unsigned i = 0; i < triangleCount; ++i)
+	{
+		CCVector3 A(position(gen), position(gen), position(gen));
+		CCVector3 B = A + CCVector3(offset(gen), offset(gen), offset(gen));
+		CCVector3 C = A + CCVector3(offset(gen), offset(gen), offset(gen));
+		if (i % 50 == 0)
+		{
+			C = A + (B - A) * static_cast<PointCoordinateType>(0.5); // flat triangle
+		}
+		else if (i % 77 == 0)
+		{
+			B = C = A; // single point
+		}
+		vertices->addPoint(A);
+		vertices->addPoint(B);
+		vertices->addPoint(C);
+		mesh->addTriangle(3 * i, 3 * i + 1, 3 * i + 2);
+	}
+
+	return mesh;
+}
+
+static std::vector<CCVector3> CreateQueries(unsigned count, unsigned seed)
+{
+	std::mt19937                                       gen(seed);
+	std::uniform_real_distribution<PointCoordinateType> uniform(-12, 12);
+	std::vector<CCVector3>                              queries;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		queries.emplace_back(uniform(gen), uniform(gen), uniform(gen));
+	}
+	return queries;
+}
+
+//! Returns the (brute force) min squared distance between a point and the triangles of a mesh
+static double BruteForceSquareDist(ccMesh& mesh, const CCVector3& P)
+{
+	double minSquareDist = std::numeric_limits<double>::max();
+	for (unsigned i = 0; i < mesh.size(); ++i)
+	{
+		CCCoreLib::GenericTriangle* tri = mesh._getTriangle(i);
+		minSquareDist                   = std::min(minSquareDist, ReferenceSquareDist(P, *tri->_getA(), *tri->_getB(), *tri->_getC()));
+	}
+	return minSquareDist;
+}
+
+void TestTriangleBVH::testClosestPointOnTriangle() const
+{
+	std::mt19937                                       gen(1);
+	std::uniform_real_distribution<PointCoordinateType> uniform(-2, 2);
+	for (unsigned i = 0; i < 10000; ++i)
+	{
+		CCVector3 P(uniform(gen), uniform(gen), uniform(gen));
+		CCVector3 A(uniform(gen), uniform(gen), uniform(gen));
+		CCVector3 B(uniform(gen), uniform(gen), uniform(gen));
+		CCVector3 C(uniform(gen), uniform(gen), uniform(gen));
+
+		CCVector3 Q = ccTriangleBVH::ClosestPointOnTriangle(P, A, B, C);
+		QVERIFY(FuzzyEqual((Q - P).norm2(), ReferenceSquareDist(P, A, B, C)));
+	}
+}
+
+void TestTriangleBVH::testClosestTriangle() const
+{
+	QScopedPointer<ccMesh> mesh(CreateMesh(5000, 2));
+	QVERIFY(mesh);
+
+	ccTriangleBVH::Shared bvh = ccTriangleBVH::Build(mesh.data());
+	QVERIFY(bvh);
+	QCOMPARE(bvh->size(), mesh->size());
+
+	for (bool robust : {false, true})
+	{
+		for (const CCVector3& P : CreateQueries(300, 3))
+		{
+			ccTriangleBVH::ClosestTriangle result;
+			QVERIFY(bvh->findClosestTriangle(P, -1, robust, result));
+			QVERIFY(result.triangleIndex >= 0 && result.triangleIndex < static_cast<int>(mesh->size()));
+
+			double minSquareDist = BruteForceSquareDist(*mesh, P);
+			QVERIFY(FuzzyEqual(result.squareDist, minSquareDist));
+
+			// the returned triangle is (one of) the closest
+			CCCoreLib::GenericTriangle* tri = mesh->_getTriangle(static_cast<unsigned>(result.triangleIndex));
+			QVERIFY(FuzzyEqual(ReferenceSquareDist(P, *tri->_getA(), *tri->_getB(), *tri->_getC()), minSquareDist));
+		}
+	}
+}
+
+void TestTriangleBVH::testClosestTriangleMaxDistance() const
+{
+	QScopedPointer<ccMesh> mesh(CreateMesh(2000, 4));
+	QVERIFY(mesh);
+
+	ccTriangleBVH::Shared bvh = ccTriangleBVH::Build(mesh.data());
+	QVERIFY(bvh);
+
+	const PointCoordinateType maxSquareDist = 1;
+	for (const CCVector3& P : CreateQueries(300, 5))
+	{
+		double minSquareDist = BruteForceSquareDist(*mesh, P);
+		if (FuzzyEqual(minSquareDist, maxSquareDist))
+		{
+			// ambiguous case
+			continue;
+		}
+
+		ccTriangleBVH::ClosestTriangle result;
+		bool                           found = bvh->findClosestTriangle(P, maxSquareDist, false, result);
+		QCOMPARE(found, minSquareDist < maxSquareDist);
+		if (found)
+		{
+			QVERIFY(FuzzyEqual(result.squareDist, minSquareDist));
+		}
+	}
+}
+
+void TestTriangleBVH::testSignedDistance() const
+{
+	// horizontal square (2 triangles, normals pointing upwards)
+	ccPointCloud* vertices = new ccPointCloud("vertices");
+	ccMesh        mesh(vertices);
+	mesh.addChild(vertices);
+	QVERIFY(vertices->reserve(4) && mesh.reserve(2));
+	vertices->addPoint(CCVector3(0, 0, 0));
+	vertices->addPoint(CCVector3(1, 0, 0));
+	vertices->addPoint(CCVector3(1, 1, 0));
+	vertices->addPoint(CCVector3(0, 1, 0));
+	mesh.addTriangle(0, 1, 2);
+	mesh.addTriangle(0, 2, 3);
+
+	ccTriangleBVH::Shared bvh = ccTriangleBVH::Build(&mesh);
+	QVERIFY(bvh);
+
+	ccTriangleBVH::ClosestTriangle result;
+	QVERIFY(bvh->findClosestTriangle(CCVector3(0.75f, 0.25f, 2.0f), -1, true, result));
+	QCOMPARE(result.triangleIndex, 0);
+	QVERIFY(FuzzyEqual(result.squareDist, 4.0));
+	QVERIFY(FuzzyEqual(result.planeDist, 2.0));
+
+	QVERIFY(bvh->findClosestTriangle(CCVector3(0.25f, 0.75f, -3.0f), -1, true, result));
+	QCOMPARE(result.triangleIndex, 1);
+	QVERIFY(FuzzyEqual(result.squareDist, 9.0));
+	QVERIFY(FuzzyEqual(result.planeDist, -3.0));
+
+	// on the shared edge (both triangles are equally close)
+	QVERIFY(bvh->findClosestTriangle(CCVector3(0.5f, 0.5f, 1.0f), -1, true, result));
+	QVERIFY(result.triangleIndex == 0 || result.triangleIndex == 1);
+	QVERIFY(FuzzyEqual(result.planeDist, 1.0));
+}
+
+QTEST_MAIN(TestTriangleBVH)
@@ -0,0 +1,21 @@
+#ifndef CC_TEST_TRIANGLE_BVH_HEADER
+#define CC_TEST_TRIANGLE_BVH_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestTriangleBVH : public QObject
+{
+	Q_OBJECT
+  private Q_SLOTS:
+	/* Queries are compared with a brute force search */
+	void testClosestPointOnTriangle() const;
+
+	void testClosestTriangle() const;
+
+	void testClosestTriangleMaxDistance() const;
+
+	void testSignedDistance() const;
+};
+
+#endif // CC_TEST_TRIANGLE_BVH_HEADER
@@ -82,6 +82,8 @@ class CCGLWINDOW_LIB_API ccGui
 		bool displayCross;
 		//! Whether to use VBOs for faster display
 		bool useVBOs;
+		//! Whether to store the cloud coordinates in a compact (quantized) format in the VBOs
+		bool useCompactVBOs;
 
 		//! Label marker size
 		unsigned labelMarkerSize;
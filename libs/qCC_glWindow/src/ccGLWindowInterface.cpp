@@ -24,6 +24,7 @@
 #include <cc2DLabel.h>
 #include <ccClipBox.h>
 #include <ccColorRampShader.h>
+#include <ccFrustum.h>
 #include <ccHObjectCaster.h>
 #include <ccMesh.h>
 #include <ccPointCloud.h>
@@ -1836,7 +1837,8 @@ void ccGLWindowInterface::getContext(CC_DRAW_CONTEXT& CONTEXT)
 	CONTEXT.bbDefaultCol          = guiParams.bbDefaultCol;
 
 	// display acceleration
-	CONTEXT.useVBOs = guiParams.useVBOs;
+	CONTEXT.useVBOs        = guiParams.useVBOs;
+	CONTEXT.useCompactVBOs = guiParams.useCompactVBOs;
 
 	// other options
 	CONTEXT.drawRoundedPoints = guiParams.drawRoundedPoints;
@@ -4570,6 +4572,8 @@ static QTimer         s_frameRateTimer;
 static QElapsedTimer  s_frameRateElapsedTimer;
 static qint64         s_frameRateElapsedTime_ms = 0; // i.e. not initialized
 static unsigned       s_frameRateCurrentFrame   = 0;
+static qint64         s_frameRateDrawnEntities  = 0; // cumulated number of drawn entities (3D pass)
+static qint64         s_frameRateCulledEntities = 0; // cumulated number of culled entities (3D pass)
 
 void ccGLWindowInterface::startFrameRateTest()
 {
@@ -4597,6 +4601,8 @@ void ccGLWindowInterface::startFrameRateTest()
 	// let's start
 	s_frameRateCurrentFrame   = 0;
 	s_frameRateElapsedTime_ms = 0;
+	s_frameRateDrawnEntities  = 0;
+	s_frameRateCulledEntities = 0;
 	s_frameRateElapsedTimer.start();
 	s_frameRateTimer.start(0);
 };
@@ -4618,6 +4624,12 @@ void ccGLWindowInterface::stopFrameRateTest()
 	if (s_frameRateElapsedTime_ms > 0)
 	{
 		QString message = QString("Framerate: %1 fps").arg((s_frameRateCurrentFrame * 1.0e3) / s_frameRateElapsedTime_ms, 0, 'f', 3);
+		if (s_frameRateCurrentFrame != 0)
+		{
+			message += QString(" - entities per frame: %1 drawn / %2 culled")
+			               .arg(static_cast<double>(s_frameRateDrawnEntities) / s_frameRateCurrentFrame, 0, 'f', 1)
+			               .arg(static_cast<double>(s_frameRateCulledEntities) / s_frameRateCurrentFrame, 0, 'f', 1);
+		}
 		displayNewMessage(message, ccGLWindow::LOWER_LEFT_MESSAGE, true);
 		ccLog::Print(message);
 	}
@@ -4978,7 +4990,13 @@ void ccGLWindowInterface::draw3D(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& rend
 		}
 	}
 
-	// we draw 3D entities
+	// we draw 3D entities (the ones outside of the view frustum are skipped)
+	Frustum viewFrustum(modelViewMat, projectionMat);
+	CONTEXT.viewFrustum       = &viewFrustum;
+	CONTEXT.viewFrustumTrans  = nullptr;
+	CONTEXT.drawnEntityCount  = 0;
+	CONTEXT.culledEntityCount = 0;
+
 	if (m_globalDBRoot)
 	{
 		m_globalDBRoot->draw(CONTEXT);
@@ -4989,6 +5007,13 @@ void ccGLWindowInterface::draw3D(CC_DRAW_CONTEXT& CONTEXT, RenderingParams& rend
 		m_winDBRoot->draw(CONTEXT);
 	}
 
+	CONTEXT.viewFrustum = nullptr;
+	if (isFrameRateTestInProgress())
+	{
+		s_frameRateDrawnEntities += CONTEXT.drawnEntityCount;
+		s_frameRateCulledEntities += CONTEXT.culledEntityCount;
+	}
+
 	glFunc->glPopAttrib(); // GL_ENABLE_BIT
 
 	// do this before drawing the pivot!
@@ -85,6 +85,7 @@ void ccGui::ParamStruct::reset()
 	decimateCloudOnMove    = true;
 	minLoDCloudSize        = 50000000;
 	useVBOs                = true;
+	useCompactVBOs         = false;
 	displayCross           = true;
 	pickingCursorShape     = Qt::CrossCursor;
 	logVerbosityLevel      = ccLog::LOG_STANDARD;
@@ -143,6 +144,7 @@ void ccGui::ParamStruct::fromPersistentSettings()
 	decimateCloudOnMove     = settings.value("cloudDecimation", true).toBool();
 	minLoDCloudSize         = settings.value("minLoDCloudSize", 50000000).toUInt();
 	useVBOs                 = settings.value("useVBOs", true).toBool();
+	useCompactVBOs          = settings.value("useCompactVBOs", false).toBool();
 	displayCross            = settings.value("crossDisplayed", true).toBool();
 	labelMarkerSize         = static_cast<unsigned>(std::max(0, settings.value("labelMarkerSize", 5).toInt()));
 	colorScaleShowHistogram = settings.value("colorScaleShowHistogram", true).toBool();
@@ -186,6 +188,7 @@ void ccGui::ParamStruct::toPersistentSettings() const
 	settings.setValue("cloudDecimation", decimateCloudOnMove);
 	settings.setValue("minLoDCloudSize", minLoDCloudSize);
 	settings.setValue("useVBOs", useVBOs);
+	settings.setValue("useCompactVBOs", useCompactVBOs);
 	settings.setValue("crossDisplayed", displayCross);
 	settings.setValue("labelMarkerSize", labelMarkerSize);
 	settings.setValue("colorScaleShowHistogram", colorScaleShowHistogram);
@@ -56,6 +56,51 @@ static bool IsFloat(e_ply_type type)
 	return (type == PLY_FLOAT32) || (type == PLY_FLOAT64) || (type == PLY_FLOAT) || (type == PLY_DOUBLE);
 }
 
+//! Returns the scalar field storage type corresponding to a PLY (scalar) type
+static ccScalarField::StorageType StorageTypeFromPlyType(e_ply_type type)
+{
+	switch (type)
+	{
+	case PLY_INT8:
+	case PLY_CHAR:
+		return ccScalarField::StorageType::Int8;
+	case PLY_UINT8:
+	case PLY_UCHAR:
+		return ccScalarField::StorageType::UInt8;
+	case PLY_INT16:
+	case PLY_SHORT:
+		return ccScalarField::StorageType::Int16;
+	case PLY_UINT16:
+	case PLY_USHORT:
+		return ccScalarField::StorageType::UInt16;
+	case PLY_INT32:
+	case PLY_INT:
+		return ccScalarField::StorageType::Int32;
+	default:
+		return ccScalarField::StorageType::Float32;
+	}
+}
+
+//! Returns the PLY (scalar) type corresponding to a scalar field storage type
+static e_ply_type PlyTypeFromStorageType(ccScalarField::StorageType type)
+{
+	switch (type)
+	{
+	case ccScalarField::StorageType::UInt8:
+		return PLY_UCHAR;
+	case ccScalarField::StorageType::Int8:
+		return PLY_CHAR;
+	case ccScalarField::StorageType::UInt16:
+		return PLY_USHORT;
+	case ccScalarField::StorageType::Int16:
+		return PLY_SHORT;
+	case ccScalarField::StorageType::Int32:
+		return PLY_INT;
+	default:
+		return PLY_FLOAT;
+	}
+}
+
 PlyFilter::PlyFilter()
     : FileIOFilter({"_PLY Filter",
                     7.0f, // priority
@@ -376,6 +421,15 @@ CC_FILE_ERROR PlyFilter::saveToFile(ccHObject* entity, QString filename, e_ply_s
 				ScalarType maxValue = std::max(std::abs(scalarFields[i]->getMin()), std::abs(scalarFields[i]->getMax()));
 
 				e_ply_type scalarType = (maxValue < ccGlobalShiftManager::MaxBoundgBoxDiagonal() ? PLY_FLOAT : PLY_DOUBLE);
+				if (scalarFields[i]->getStorageType() != ccScalarField::StorageType::Float32 && scalarFields[i]->getOffset() == 0.0)
+				{
+					// integer fields are saved with the corresponding integer type (if the values still fit)
+					e_ply_type storageType = PlyTypeFromStorageType(scalarFields[i]->getStorageType());
+					if (storageType != PLY_FLOAT && scalarFields[i]->canBeStoredAs(scalarFields[i]->getStorageType()))
+					{
+						scalarType = storageType;
+					}
+				}
 				if (scalarType == PLY_DOUBLE)
 				{
 					ccLog::Warning(QString("[PLY] Scalar field '%1' has large values and will be saved as double values instead of float values").arg(QString::fromStdString(scalarFields[i]->getName())));
@@ -1640,6 +1694,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 	}
 
 	/* SCALAR FIELDS (SF) */
+	std::vector<std::pair<CCCoreLib::ScalarField*, e_ply_type>> sfPlyTypes;
 	{
 		for (size_t i = 0; i < sfPropIndexes.size(); ++i)
 		{
@@ -1671,6 +1726,7 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 					if (sf->resizeSafe(numberOfScalars))
 					{
 						ply_set_read_cb(ply, pointElements[pp.elemIndex].elementName, pp.propName, scalar_cb, sf, 1);
+						sfPlyTypes.emplace_back(sf, pp.type);
 					}
 					else
 					{
@@ -1873,6 +1929,17 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 			CCCoreLib::ScalarField* sf = cloud->getScalarField(i);
 			assert(sf);
 			sf->computeMinAndMax();
+
+			// integer properties get the corresponding (compact) storage type
+			for (const auto& sfPlyType : sfPlyTypes)
+			{
+				if (sfPlyType.first == sf)
+				{
+					static_cast<ccScalarField*>(sf)->setStorageType(StorageTypeFromPlyType(sfPlyType.second));
+					break;
+				}
+			}
+
 			if (i == 0)
 			{
 				cloud->setCurrentDisplayedScalarField(0);
@@ -0,0 +1,160 @@
+#include "TestScalarFieldStorage.h"
+
+#include "FileIOFilter.h"
+#include "PlyFilter.h"
+#include "ccPointCloud.h"
+#include "ccScalarField.h"
+
+#include <ReferenceCloud.h>
+
+#include <memory>
+
+using StorageType = ccScalarField::StorageType;
+
+static const unsigned PointCount = 100;
+
+//! Creates a cloud with a few (typed) scalar fields
+static ccPointCloud* CreateTypedCloud()
+{
+	ccPointCloud* cloud = new ccPointCloud("typed");
+	if (!cloud->reserve(PointCount))
+	{
+		delete cloud;
+		return nullptr;
+	}
+
+	struct SFDescription
+	{
+		const char* name;
+		StorageType type;
+		ScalarType (*value)(unsigned);
+	};
+	static const SFDescription Descriptions[] {
+	    {"Flag", StorageType::UInt8, [](unsigned i) { return static_cast<ScalarType>(i % 2); }},
+	    {"Classification", StorageType::UInt16, [](unsigned i) { return static_cast<ScalarType>(i % 20); }},
+	    {"Signed", StorageType::Int16, [](unsigned i) { return static_cast<ScalarType>(static_cast<int>(i) * 20 - 1000); }},
+	    {"Real", StorageType::Float32, [](unsigned i) { return static_cast<ScalarType>(i) / 3; }},
+	};
+
+	for (unsigned i = 0; i < PointCount; ++i)
+	{
+		cloud->addPoint(CCVector3(static_cast<PointCoordinateType>(i), 0, 0));
+	}
+
+	for (const SFDescription& description : Descriptions)
+	{
+		ccScalarField* sf = new ccScalarField(description.name);
+		if (!sf->resizeSafe(PointCount))
+		{
+			sf->release();
+			delete cloud;
+			return nullptr;
+		}
+		sf->setOffset(0.0); // the integer types are only kept for the fields without offset when saved as PLY
+		for (unsigned i = 0; i < PointCount; ++i)
+		{
+			sf->setValue(i, description.value(i));
+		}
+		sf->computeMinAndMax();
+		if (!sf->setStorageType(description.type))
+		{
+			sf->release();
+			delete cloud;
+			return nullptr;
+		}
+		cloud->addScalarField(sf);
+	}
+
+	return cloud;
+}
+
+static ccScalarField* GetSF(const ccPointCloud* cloud, const char* name)
+{
+	int sfIdx = cloud->getScalarFieldIndexByName(name);
+	return (sfIdx >= 0 ? static_cast<ccScalarField*>(cloud->getScalarField(sfIdx)) : nullptr);
+}
+
+void TestScalarFieldStorage::testStorageTypeCheck() const
+{
+	std::unique_ptr<ccPointCloud> cloud(CreateTypedCloud());
+	QVERIFY(cloud);
+
+	// a type that can't store the values is rejected
+	ccScalarField* sf = GetSF(cloud.get(), "Signed");
+	QVERIFY(!sf->setStorageType(StorageType::UInt8));
+	QCOMPARE(sf->getStorageType(), StorageType::Int16);
+	QVERIFY(!GetSF(cloud.get(), "Real")->setStorageType(StorageType::Int32));
+	QVERIFY(GetSF(cloud.get(), "Flag")->setStorageType(StorageType::Int8));
+
+	// the type is dropped when the values don't fit anymore
+	sf->setValue(0, static_cast<ScalarType>(1.0e6));
+	sf->computeMinAndMax();
+	QCOMPARE(sf->getStorageType(), StorageType::Float32);
+}
+
+void TestScalarFieldStorage::testPartialClone() const
+{
+	std::unique_ptr<ccPointCloud> cloud(CreateTypedCloud());
+	QVERIFY(cloud);
+
+	CCCoreLib::ReferenceCloud selection(cloud.get());
+	QVERIFY(selection.reserve(PointCount / 2));
+	for (unsigned i = 0; i < PointCount; i += 2)
+	{
+		selection.addPointIndex(i);
+	}
+
+	std::unique_ptr<ccPointCloud> subset(cloud->partialClone(&selection));
+	QVERIFY(subset);
+	QCOMPARE(subset->size(), PointCount / 2);
+
+	// the subset values still fit the source storage types
+	QCOMPARE(GetSF(subset.get(), "Flag")->getStorageType(), StorageType::UInt8);
+	QCOMPARE(GetSF(subset.get(), "Classification")->getStorageType(), StorageType::UInt16);
+	QCOMPARE(GetSF(subset.get(), "Signed")->getStorageType(), StorageType::Int16);
+	QCOMPARE(GetSF(subset.get(), "Real")->getStorageType(), StorageType::Float32);
+}
+
+void TestScalarFieldStorage::testPlyRoundTrip() const
+{
+	std::unique_ptr<ccPointCloud> cloud(CreateTypedCloud());
+	QVERIFY(cloud);
+
+	QTemporaryDir tmpDir;
+	QVERIFY(tmpDir.isValid());
+	QString                      filename = tmpDir.path() + "/typed.ply";
+	PlyFilter                    filter;
+	FileIOFilter::SaveParameters saveParams;
+	saveParams.alwaysDisplaySaveDialog = false;
+	PlyFilter::SetDefaultOutputFormat(PLY_LITTLE_ENDIAN);
+	QVERIFY(filter.saveToFile(cloud.get(), filename, saveParams) == CC_FERR_NO_ERROR);
+
+	ccHObject                    container;
+	FileIOFilter::LoadParameters params;
+	params.alwaysDisplayLoadDialog = false;
+	params.shiftHandlingMode       = ccGlobalShiftManager::Mode::NO_DIALOG;
+	QVERIFY(filter.loadFile(filename, container, params) == CC_FERR_NO_ERROR);
+	QCOMPARE(container.getChildrenNumber(), 1u);
+	QVERIFY(container.getChild(0)->isA(CC_TYPES::POINT_CLOUD));
+
+	const ccPointCloud* loadedCloud = static_cast<ccPointCloud*>(container.getChild(0));
+	QCOMPARE(loadedCloud->size(), PointCount);
+	QCOMPARE(loadedCloud->getNumberOfScalarFields(), cloud->getNumberOfScalarFields());
+
+	for (const char* name : {"Flag", "Classification", "Signed", "Real"})
+	{
+		const ccScalarField* sf       = GetSF(cloud.get(), name);
+		const ccScalarField* loadedSF = GetSF(loadedCloud, name);
+		QVERIFY(loadedSF);
+
+		// the integer fields are saved (and loaded back) with their integer type
+		QCOMPARE(loadedSF->getStorageType(), sf->getStorageType());
+
+		for (unsigned i = 0; i < PointCount; ++i)
+		{
+			QCOMPARE(loadedSF->getValue(i), sf->getValue(i));
+		}
+	}
+}
+
+QTEST_MAIN(TestScalarFieldStorage)
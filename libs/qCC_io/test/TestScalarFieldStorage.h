@@ -0,0 +1,19 @@
+#ifndef CC_TEST_SCALAR_FIELD_STORAGE_HEADER
+#define CC_TEST_SCALAR_FIELD_STORAGE_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestScalarFieldStorage : public QObject
+{
+	Q_OBJECT
+  private Q_SLOTS:
+	void testStorageTypeCheck() const;
+
+	void testPartialClone() const;
+
+	/* Round-trip tests */
+	void testPlyRoundTrip() const;
+};
+
+#endif // CC_TEST_SCALAR_FIELD_STORAGE_HEADER
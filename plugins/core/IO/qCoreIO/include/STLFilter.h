@@ -53,6 +53,9 @@ class STLFilter : public FileIOFilter
 	                            LoadParameters& parameters);
 
 	//! Custom load method for binary files
+	/** The facet records are memory-mapped (or read by large blocks) and parsed
+	    in parallel. Vertices with the exact same coordinates are welded on the fly.
+	**/
 	CC_FILE_ERROR loadBinaryFile(QFile&          fp,
 	                             ccMesh*         mesh,
 	                             ccPointCloud*   vertices,
@@ -26,6 +26,8 @@
 #include <QString>
 #include <QStringList>
 #include <QTextStream>
+#include <QThread>
+#include <QtConcurrentMap>
 
 // qCC_db
 #include <ccChunk.h>
@@ -44,7 +46,10 @@
 #include <Delaunay2dMesh.h>
 
 // System
+#include <algorithm>
 #include <cstring>
+#include <limits>
+#include <string>
 
 ObjFilter::ObjFilter()
     : FileIOFilter({"_OBJ Filter",
@@ -538,6 +543,558 @@ struct facetElement
 	}
 };
 
+namespace
+{
+	//! Size of the blocks of lines parsed concurrently
+	constexpr qint64 s_objBlockSize = (8 << 20);
+
+	//! Span of characters in the file buffer (no allocation)
+	struct ObjToken
+	{
+		const char* begin = nullptr;
+		const char* end   = nullptr;
+
+		inline int size() const
+		{
+			return static_cast<int>(end - begin);
+		}
+		inline bool startsWith(char c) const
+		{
+			return begin != end && *begin == c;
+		}
+		inline bool equals(const char* str) const
+		{
+			size_t length = strlen(str);
+			return static_cast<size_t>(end - begin) == length && memcmp(begin, str, length) == 0;
+		}
+	};
+
+	inline bool IsObjSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	//! Splits a line into whitespace-separated tokens (equivalent to 'simplified().split(' ')')
+	void TokenizeObjLine(const char* begin, const char* end, std::vector<ObjToken>& tokens)
+	{
+		tokens.clear();
+		const char* c = begin;
+		while (c != end)
+		{
+			while (c != end && IsObjSpace(*c))
+			{
+				++c;
+			}
+			if (c == end)
+			{
+				break;
+			}
+			ObjToken token;
+			token.begin = c;
+			while (c != end && !IsObjSpace(*c))
+			{
+				++c;
+			}
+			token.end = c;
+			tokens.push_back(token);
+		}
+	}
+
+	//! Parses an integer (returns 0 if the token is not a valid integer, as QString::toInt)
+	int ParseObjInt(const ObjToken& token)
+	{
+		const char* c        = token.begin;
+		bool        negative = false;
+		if (c != token.end && (*c == '-' || *c == '+'))
+		{
+			negative = (*c == '-');
+			++c;
+		}
+		if (c == token.end)
+		{
+			return 0;
+		}
+
+		int64_t value = 0;
+		for (; c != token.end; ++c)
+		{
+			if (*c < '0' || *c > '9')
+			{
+				return 0;
+			}
+			value = value * 10 + (*c - '0');
+			if (value > std::numeric_limits<int>::max())
+			{
+				return 0;
+			}
+		}
+
+		return static_cast<int>(negative ? -value : value);
+	}
+
+	//! Parses a floating point value (returns 0 if the token is not a valid number, as QString::toDouble)
+	/** Most values are exactly converted with the 'fast path' (mantissa < 2^53 and small power of 10).
+	    The other ones (long mantissas, large exponents, nan, inf, etc.) are handed over to Qt.
+	**/
+	double ParseObjDouble(const ObjToken& token)
+	{
+		static const double s_pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+		const char* c        = token.begin;
+		bool        negative = false;
+		if (c != token.end && (*c == '-' || *c == '+'))
+		{
+			negative = (*c == '-');
+			++c;
+		}
+
+		uint64_t mantissa   = 0;
+		int      digitCount = 0; // significant digits
+		int      exponent   = 0;
+		bool     hasDigits  = false;
+		bool     fastPath   = true;
+
+		// integer part
+		for (; c != token.end && *c >= '0' && *c <= '9'; ++c)
+		{
+			hasDigits = true;
+			if (mantissa != 0 || *c != '0')
+			{
+				mantissa = mantissa * 10 + (*c - '0');
+				if (++digitCount > 18)
+				{
+					fastPath = false;
+				}
+			}
+		}
+		// decimal part
+		if (c != token.end && *c == '.')
+		{
+			++c;
+			for (; c != token.end && *c >= '0' && *c <= '9'; ++c)
+			{
+				hasDigits = true;
+				if (mantissa != 0 || *c != '0')
+				{
+					mantissa = mantissa * 10 + (*c - '0');
+					if (++digitCount > 18)
+					{
+						fastPath = false;
+					}
+				}
+				--exponent;
+			}
+		}
+		// exponent
+		if (hasDigits && c != token.end && (*c == 'e' || *c == 'E'))
+		{
+			++c;
+			bool negativeExp = false;
+			if (c != token.end && (*c == '-' || *c == '+'))
+			{
+				negativeExp = (*c == '-');
+				++c;
+			}
+			if (c == token.end)
+			{
+				fastPath = false;
+			}
+			int expValue = 0;
+			for (; c != token.end && *c >= '0' && *c <= '9'; ++c)
+			{
+				if (expValue < 10000)
+				{
+					expValue = expValue * 10 + (*c - '0');
+				}
+			}
+			exponent += (negativeExp ? -expValue : expValue);
+		}
+
+		if (!hasDigits || c != token.end || mantissa > (1ULL << 53) || exponent < -22 || exponent > 22)
+		{
+			fastPath = false;
+		}
+
+		if (!fastPath)
+		{
+			return QByteArray::fromRawData(token.begin, token.size()).toDouble();
+		}
+
+		double value = static_cast<double>(mantissa);
+		value        = (exponent < 0 ? value / s_pow10[-exponent] : value * s_pow10[exponent]);
+		return negative ? -value : value;
+	}
+
+	//! Parses a face or polyline element ('v', 'v/vt', 'v/vt/vn' or 'v//vn')
+	/** \return false if the vertex index is missing
+	**/
+	bool ParseObjFacetElement(const ObjToken& token, facetElement& fe)
+	{
+		ObjToken    parts[3];
+		int         partCount = 0;
+		const char* start     = token.begin;
+		for (const char* c = token.begin; c != token.end && partCount < 3; ++c)
+		{
+			if (*c == '/')
+			{
+				parts[partCount].begin = start;
+				parts[partCount].end   = c;
+				++partCount;
+				start = c + 1;
+			}
+		}
+		if (partCount < 3)
+		{
+			parts[partCount].begin = start;
+			parts[partCount].end   = token.end;
+			++partCount;
+		}
+
+		if (parts[0].begin == parts[0].end)
+		{
+			return false;
+		}
+
+		fe.vIndex = ParseObjInt(parts[0]);
+		if (partCount > 1 && parts[1].begin != parts[1].end)
+			fe.tcIndex = ParseObjInt(parts[1]);
+		if (partCount > 2 && parts[2].begin != parts[2].end)
+			fe.nIndex = ParseObjInt(parts[2]);
+
+		return true;
+	}
+
+	//! OBJ statement that must be processed in the file order (i.e. anything but 'v', 'vt' and 'vn')
+	struct ObjStatement
+	{
+		enum Type : unsigned char
+		{
+			FACE,
+			POLYLINE,
+			GROUP,
+			USE_MTL,
+			MTL_LIB,
+		};
+
+		Type     type;
+		unsigned vCount;  //!< number of vertices read in the block before this statement
+		unsigned vtCount; //!< number of tex. coords read in the block before this statement
+		unsigned vnCount; //!< number of normals read in the block before this statement
+		unsigned first;   //!< first element (faces and polylines) or first character (names)
+		unsigned count;   //!< number of elements (faces and polylines) or characters (names)
+	};
+
+	//! Content of a block of consecutive lines (parsed independently from the others)
+	struct ObjBlock
+	{
+		const char* begin = nullptr;
+		const char* end   = nullptr;
+
+		std::vector<CCVector3d>         vertices;
+		std::vector<TexCoords2D>        texCoords;
+		std::vector<CompressedNormType> normals;
+		std::vector<facetElement>       elements;
+		std::vector<ObjStatement>       statements;
+		std::string                     names;
+
+		bool invalidNormals  = false; //!< some normals were not normalized
+		bool invalidLine     = false; //!< some lines were malformed
+		bool fatalError      = false; //!< a malformed line stopped the parsing process
+		bool notEnoughMemory = false;
+
+		inline ObjStatement& addStatement(ObjStatement::Type type)
+		{
+			ObjStatement st;
+			st.type    = type;
+			st.vCount  = static_cast<unsigned>(vertices.size());
+			st.vtCount = static_cast<unsigned>(texCoords.size());
+			st.vnCount = static_cast<unsigned>(normals.size());
+			st.first   = 0;
+			st.count   = 0;
+			statements.push_back(st);
+			return statements.back();
+		}
+
+		inline ObjStatement& addNameStatement(ObjStatement::Type type, const char* begin, const char* end)
+		{
+			ObjStatement& st = addStatement(type);
+			st.first         = static_cast<unsigned>(names.size());
+			if (end > begin)
+			{
+				st.count = static_cast<unsigned>(end - begin);
+				names.append(begin, end);
+			}
+			return st;
+		}
+
+		inline QString name(const ObjStatement& st) const
+		{
+			return QString::fromLocal8Bit(names.data() + st.first, static_cast<int>(st.count));
+		}
+
+		//! Releases the parsed data
+		void clear()
+		{
+			std::vector<CCVector3d>().swap(vertices);
+			std::vector<TexCoords2D>().swap(texCoords);
+			std::vector<CompressedNormType>().swap(normals);
+			std::vector<facetElement>().swap(elements);
+			std::vector<ObjStatement>().swap(statements);
+			std::string().swap(names);
+		}
+	};
+
+	//! Parses a single (logical) line
+	/** \return false if a fatal error occurred
+	**/
+	bool ParseObjLine(ObjBlock& block, const char* lineBegin, const char* lineEnd, std::vector<ObjToken>& tokens)
+	{
+		TokenizeObjLine(lineBegin, lineEnd, tokens);
+
+		// skip comments & empty lines
+		if (tokens.empty() || tokens.front().startsWith('/') || tokens.front().startsWith('#'))
+		{
+			return true;
+		}
+
+		const ObjToken& key = tokens.front();
+
+		/*** new vertex ***/
+		if (key.equals("v"))
+		{
+			// malformed line?
+			if (tokens.size() < 4)
+			{
+				block.invalidLine = true;
+				return false;
+			}
+			block.vertices.emplace_back(ParseObjDouble(tokens[1]), ParseObjDouble(tokens[2]), ParseObjDouble(tokens[3]));
+		}
+		/*** new vertex texture coordinates ***/
+		else if (key.equals("vt"))
+		{
+			// malformed line?
+			if (tokens.size() < 2)
+			{
+				block.invalidLine = true;
+				return false;
+			}
+
+			TexCoords2D T(static_cast<float>(ParseObjDouble(tokens[1])), 0);
+			if (tokens.size() > 2) // OBJ specification allows for only one value!!!
+			{
+				T.ty = static_cast<float>(ParseObjDouble(tokens[2]));
+			}
+			block.texCoords.push_back(T);
+		}
+		/*** new vertex normal ***/
+		else if (key.equals("vn")) //--> in fact it can also be a facet normal!!!
+		{
+			// malformed line?
+			if (tokens.size() < 4)
+			{
+				block.invalidLine = true;
+				return false;
+			}
+
+			CCVector3 N(static_cast<PointCoordinateType>(ParseObjDouble(tokens[1])),
+			            static_cast<PointCoordinateType>(ParseObjDouble(tokens[2])),
+			            static_cast<PointCoordinateType>(ParseObjDouble(tokens[3])));
+
+			if (std::abs(N.norm2d() - 1.0) > 0.005)
+			{
+				block.invalidNormals = true;
+				N.normalize();
+			}
+			block.normals.push_back(ccNormalVectors::GetNormIndex(N.u));
+		}
+		/*** new group ***/
+		else if (key.equals("g") || key.equals("o"))
+		{
+			block.addNameStatement(ObjStatement::GROUP, tokens.size() > 1 ? tokens[1].begin : key.end, tokens.back().end);
+		}
+		/*** new face ***/
+		else if (key.startsWith('f'))
+		{
+			// malformed line?
+			if (tokens.size() < 4)
+			{
+				block.invalidLine = true;
+				return true;
+			}
+
+			ObjStatement& st = block.addStatement(ObjStatement::FACE);
+			st.first         = static_cast<unsigned>(block.elements.size());
+			for (size_t i = 1; i < tokens.size(); ++i)
+			{
+				facetElement fe; //(0,0,0) by default
+				if (!ParseObjFacetElement(tokens[i], fe))
+				{
+					block.invalidLine = true;
+					return false;
+				}
+				block.elements.push_back(fe);
+			}
+			st.count = static_cast<unsigned>(tokens.size() - 1);
+		}
+		/*** polyline ***/
+		else if (key.startsWith('l'))
+		{
+			// malformed line?
+			if (tokens.size() < 3)
+			{
+				block.invalidLine = true;
+				return true;
+			}
+
+			ObjStatement& st = block.addStatement(ObjStatement::POLYLINE);
+			st.first         = static_cast<unsigned>(block.elements.size());
+			for (size_t i = 1; i < tokens.size(); ++i)
+			{
+				facetElement fe; // we ignore tex. coord. and normal indexes (if any!)
+				if (!ParseObjFacetElement(tokens[i], fe))
+				{
+					block.invalidLine = true;
+					return false;
+				}
+				block.elements.push_back(fe);
+			}
+			st.count = static_cast<unsigned>(tokens.size() - 1);
+		}
+		/*** material ***/
+		else if (key.equals("usemtl"))
+		{
+			// DGM: in case there's space characters in the material name, we must read it from the original line buffer
+			block.addNameStatement(ObjStatement::USE_MTL, lineBegin + 7, lineEnd);
+		}
+		/*** material file (MTL) ***/
+		else if (key.equals("mtllib"))
+		{
+			// malformed line?
+			if (tokens.size() < 2)
+			{
+				block.invalidLine = true;
+			}
+			else
+			{
+				// DGM: in case there's space characters in the filename, we must read it from the original line buffer
+				block.addNameStatement(ObjStatement::MTL_LIB, lineBegin + 7, lineEnd);
+			}
+		}
+		///*** shading group ***/
+		// else if (key.equals("s"))
+		//{
+		//	//ignored!
+		// }
+
+		return true;
+	}
+
+	//! Returns the next physical line (without its end-of-line characters)
+	inline void NextObjLine(const char*& cursor, const char* end, const char*& lineBegin, const char*& lineEnd)
+	{
+		lineBegin       = cursor;
+		const char* eol = static_cast<const char*>(memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+		lineEnd         = (eol ? eol : end);
+		cursor          = (eol ? eol + 1 : end);
+		if (lineEnd != lineBegin && lineEnd[-1] == '\r')
+		{
+			--lineEnd;
+		}
+	}
+
+	//! Parses a whole block of lines (can be called concurrently on different blocks)
+	void ParseObjBlock(ObjBlock& block)
+	{
+		try
+		{
+			std::vector<ObjToken> tokens;
+			std::string           joinedLine;
+
+			const char* cursor = block.begin;
+			while (cursor < block.end)
+			{
+				const char* lineBegin = nullptr;
+				const char* lineEnd   = nullptr;
+				NextObjLine(cursor, block.end, lineBegin, lineEnd);
+
+				// specific case for weird files
+				if (lineEnd != lineBegin && lineEnd[-1] == '\\')
+				{
+					joinedLine.assign(lineBegin, lineEnd);
+					while (!joinedLine.empty() && joinedLine.back() == '\\')
+					{
+						joinedLine.pop_back();
+						if (cursor < block.end)
+						{
+							NextObjLine(cursor, block.end, lineBegin, lineEnd);
+							joinedLine.append(lineBegin, lineEnd);
+						}
+					}
+					lineBegin = joinedLine.data();
+					lineEnd   = joinedLine.data() + joinedLine.size();
+				}
+
+				if (!ParseObjLine(block, lineBegin, lineEnd, tokens))
+				{
+					block.fatalError = true;
+					break;
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			block.notEnoughMemory = true;
+			block.fatalError      = true;
+		}
+	}
+
+	//! Splits a buffer in blocks of complete (logical) lines
+	std::vector<ObjBlock> SplitObjBuffer(const char* data, qint64 size)
+	{
+		std::vector<ObjBlock> blocks;
+
+		const char* dataEnd = data + size;
+		const char* cursor  = data;
+		while (cursor < dataEnd)
+		{
+			const char* blockEnd = (dataEnd - cursor > s_objBlockSize ? cursor + s_objBlockSize : dataEnd);
+
+			// extend the block up to the end of the current line (and of its continuation lines, if any)
+			while (blockEnd < dataEnd)
+			{
+				const char* eol = static_cast<const char*>(memchr(blockEnd, '\n', static_cast<size_t>(dataEnd - blockEnd)));
+				if (!eol)
+				{
+					blockEnd = dataEnd;
+					break;
+				}
+				blockEnd = eol + 1;
+
+				const char* lineEnd = eol;
+				if (lineEnd > cursor && lineEnd[-1] == '\r')
+				{
+					--lineEnd;
+				}
+				if (lineEnd == cursor || lineEnd[-1] != '\\')
+				{
+					break;
+				}
+			}
+
+			ObjBlock block;
+			block.begin = cursor;
+			block.end   = blockEnd;
+			blocks.push_back(std::move(block));
+
+			cursor = blockEnd;
+		}
+
+		return blocks;
+	}
+} // namespace
+
 CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container, LoadParameters& parameters)
 {
 	ccLog::Print(QString("[OBJ] Loading ") + filename);
@@ -548,7 +1105,37 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 	{
 		return CC_FERR_READING;
 	}
-	QTextStream stream(&file);
+
+	// file content (memory mapped if possible)
+	qint64      dataSize = file.size();
+	const char* data     = (dataSize > 0 ? reinterpret_cast<const char*>(file.map(0, dataSize)) : nullptr);
+	QByteArray  fileContent;
+	if (!data)
+	{
+		fileContent = file.readAll();
+		data        = fileContent.constData();
+		dataSize    = fileContent.size();
+	}
+	if (dataSize >= 2
+	    && ((static_cast<uchar>(data[0]) == 0xFF && static_cast<uchar>(data[1]) == 0xFE)
+	        || (static_cast<uchar>(data[0]) == 0xFE && static_cast<uchar>(data[1]) == 0xFF)))
+	{
+		// UTF-16 files are converted to the local 8-bit encoding first
+		file.seek(0);
+		QTextStream stream(&file);
+		fileContent = stream.readAll().toLocal8Bit();
+		data        = fileContent.constData();
+		dataSize    = fileContent.size();
+	}
+	else if (dataSize >= 3
+	         && static_cast<uchar>(data[0]) == 0xEF
+	         && static_cast<uchar>(data[1]) == 0xBB
+	         && static_cast<uchar>(data[2]) == 0xBF)
+	{
+		// skip the UTF-8 BOM
+		data += 3;
+		dataSize -= 3;
+	}
 
 	// current vertex shift
 	CCVector3d Pshift(0, 0, 0);
@@ -594,6 +1181,20 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 	bool                   normalsPerFacet = false;
 	int                    maxTriNormIndex = -1;
 
+	// the file is parsed by blocks of lines (concurrently), then the
+	// blocks are processed in the file order to resolve the indexes
+	std::vector<ObjBlock> blocks;
+	try
+	{
+		blocks = SplitObjBuffer(data, dataSize);
+	}
+	catch (const std::bad_alloc&)
+	{
+		delete baseMesh;
+		delete vertices;
+		return CC_FERR_NOT_ENOUGH_MEMORY;
+	}
+
 	// progress dialog
 	QScopedPointer<ccProgressDialog> pDlg(nullptr);
 	if (parameters.parentWidget)
@@ -601,7 +1202,7 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 		pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
 		pDlg->setMethodTitle(QObject::tr("OBJ file"));
 		pDlg->setInfo(QObject::tr("Loading in progress..."));
-		pDlg->setRange(0, static_cast<int>(file.size()));
+		pDlg->setRange(0, static_cast<int>(blocks.size()));
 		pDlg->show();
 		QApplication::processEvents();
 	}
@@ -611,634 +1212,540 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 	{
 		INVALID_NORMALS   = 0,
 		INVALID_INDEX     = 1,
-		NOT_ENOUGH_MEMORY = 2,
-		INVALID_LINE      = 3,
-		CANCELLED_BY_USER = 4,
-	};
-	bool objWarnings[5]{false, false, false, false, false};
-	bool error = false;
-
-	try
-	{
-		unsigned lineCount   = 0;
-		unsigned polyCount   = 0;
-		QString  currentLine = stream.readLine();
-
-		while (!currentLine.isNull())
-		{
-			++lineCount;
-			if (pDlg && ((lineCount % 2048) == 0))
-			{
-				if (pDlg->wasCanceled())
-				{
-					error                          = true;
-					objWarnings[CANCELLED_BY_USER] = true;
-					break;
-				}
-				pDlg->setValue(static_cast<int>(file.pos()));
-				QApplication::processEvents();
-			}
-
-			// specific case for weird files
-			while (currentLine.endsWith('\\'))
-			{
-				currentLine.resize(currentLine.length() - 1);
-				currentLine += stream.readLine();
-				++lineCount;
-				if (pDlg && ((lineCount % 2048) == 0))
-				{
-					if (pDlg->wasCanceled())
-					{
-						error                          = true;
-						objWarnings[CANCELLED_BY_USER] = true;
-						break;
-					}
-					pDlg->setValue(static_cast<int>(file.pos()));
-					QApplication::processEvents();
-				}
-			}
-
-			const QStringList tokens = currentLine.simplified().split(QChar(' '), QString::SkipEmptyParts);
-
-			// skip comments & empty lines
-			if (tokens.empty() || tokens.front().startsWith('/', Qt::CaseInsensitive) || tokens.front().startsWith('#', Qt::CaseInsensitive))
-			{
-				currentLine = stream.readLine();
-				continue;
-			}
-
-			/*** new vertex ***/
-			if (tokens.front() == "v")
-			{
-				// reserve more memory if necessary
-				if (vertices->size() == vertices->capacity())
-				{
-					if (!vertices->reserve(vertices->capacity() + ccChunk::SIZE))
-					{
-						objWarnings[NOT_ENOUGH_MEMORY] = true;
-						error                          = true;
-						break;
-					}
-				}
-
-				// malformed line?
-				if (tokens.size() < 4)
-				{
-					objWarnings[INVALID_LINE] = true;
-					error                     = true;
-					break;
-				}
-
-				CCVector3d Pd(tokens[1].toDouble(), tokens[2].toDouble(), tokens[3].toDouble());
-
-				// first point: check for 'big' coordinates
-				if (pointsRead == 0)
-				{
-					bool preserveCoordinateShift = true;
-					if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
-					{
-						if (preserveCoordinateShift)
-						{
-							vertices->setGlobalShift(Pshift);
-						}
-						ccLog::Warning("[OBJ] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
-					}
-				}
-
-				// shifted point
-				CCVector3 P = (Pd + Pshift).toPC();
-				vertices->addPoint(P);
-				++pointsRead;
-			}
-			/*** new vertex texture coordinates ***/
-			else if (tokens.front() == "vt")
-			{
-				// create and reserve memory for tex. coords container if necessary
-				if (!texCoords)
-				{
-					texCoords = new TextureCoordsContainer();
-					texCoords->link();
-				}
-				if (texCoords->currentSize() == texCoords->capacity())
-				{
-					if (!texCoords->reserveSafe(texCoords->capacity() + ccChunk::SIZE))
-					{
-						objWarnings[NOT_ENOUGH_MEMORY] = true;
-						error                          = true;
-						break;
-					}
-				}
+		NOT_ENOUGH_MEMORY = 2,
+		INVALID_LINE      = 3,
+		CANCELLED_BY_USER = 4,
+	};
+	bool objWarnings[5]{false, false, false, false, false};
+	bool error = false;
 
-				// malformed line?
-				if (tokens.size() < 2)
-				{
-					objWarnings[INVALID_LINE] = true;
-					error                     = true;
-					break;
-				}
+	try
+	{
+		unsigned                  polyCount = 0;
+		std::vector<facetElement> currentFace;
 
-				TexCoords2D T(tokens[1].toFloat(), 0);
+		// number of blocks parsed at the same time (to keep the memory consumption under control)
+		const size_t waveSize = static_cast<size_t>(std::max(1, QThread::idealThreadCount())) * 2;
 
-				if (tokens.size() > 2) // OBJ specification allows for only one value!!!
-				{
-					T.ty = tokens[2].toFloat();
-				}
+		for (size_t waveStart = 0; waveStart < blocks.size() && !error; waveStart += waveSize)
+		{
+			const size_t waveEnd = std::min(waveStart + waveSize, blocks.size());
 
-				texCoords->addElement(T);
-				++texCoordsRead;
-			}
-			/*** new vertex normal ***/
-			else if (tokens.front() == "vn") //--> in fact it can also be a facet normal!!!
+			// parse the blocks of the current wave concurrently
 			{
-				// create and reserve memory for normals container if necessary
-				if (!normals)
+				std::vector<ObjBlock*> wave;
+				wave.reserve(waveEnd - waveStart);
+				for (size_t b = waveStart; b < waveEnd; ++b)
 				{
-					normals = new NormsIndexesTableType;
-					normals->link();
+					wave.push_back(&blocks[b]);
 				}
-				if (normals->currentSize() == normals->capacity())
+				QtConcurrent::blockingMap(wave, [](ObjBlock* block)
+				                          { ParseObjBlock(*block); });
+			}
+
+			// then process them in the file order
+			for (size_t b = waveStart; b < waveEnd && !error; ++b)
+			{
+				ObjBlock& block = blocks[b];
+
+				if (pDlg)
 				{
-					if (!normals->reserveSafe(normals->capacity() + ccChunk::SIZE))
+					if (pDlg->wasCanceled())
 					{
-						objWarnings[NOT_ENOUGH_MEMORY] = true;
 						error                          = true;
+						objWarnings[CANCELLED_BY_USER] = true;
 						break;
 					}
+					pDlg->setValue(static_cast<int>(b));
+					QApplication::processEvents();
 				}
 
-				// malformed line?
-				if (tokens.size() < 4)
-				{
-					objWarnings[INVALID_LINE] = true;
-					error                     = true;
-					break;
-				}
-
-				CCVector3 N(static_cast<PointCoordinateType>(tokens[1].toDouble()),
-				            static_cast<PointCoordinateType>(tokens[2].toDouble()),
-				            static_cast<PointCoordinateType>(tokens[3].toDouble()));
-
-				if (std::abs(N.norm2d() - 1.0) > 0.005)
+				if (block.invalidNormals)
 				{
 					objWarnings[INVALID_NORMALS] = true;
-					N.normalize();
 				}
-				CompressedNormType nIndex = ccNormalVectors::GetNormIndex(N.u);
-
-				normals->addElement(nIndex); // we don't know yet if it's per-vertex or per-triangle normal...
-				++normsRead;
-			}
-			/*** new group ***/
-			else if (tokens.front() == "g" || tokens.front() == "o")
-			{
-				// update new group index
-				facesRead = 0;
-				// get the group name
-				QString groupName = (tokens.size() > 1 && !tokens[1].isEmpty() ? tokens[1] : "default");
-				for (int i = 2; i < tokens.size(); ++i) // multiple parts?
-					groupName.append(QString(" ") + tokens[i]);
-				// push previous group descriptor (if none was pushed)
-				if (groups.empty() && totalFacesRead > 0)
-					groups.emplace_back(0, "default");
-				// push new group descriptor
-				if (!groups.empty() && groups.back().first == totalFacesRead)
-					groups.back().second = groupName; // simply replace the group name if the previous group was empty!
-				else
-					groups.emplace_back(totalFacesRead, groupName);
-				polyCount = 0; // restart polyline count at 0!
-			}
-			/*** new face ***/
-			else if (tokens.front().startsWith('f'))
-			{
-				// malformed line?
-				if (tokens.size() < 4)
+				if (block.invalidLine)
 				{
 					objWarnings[INVALID_LINE] = true;
-					currentLine               = stream.readLine();
-					continue;
-					// error = true;
-					// break;
 				}
-
-				// read the face elements (singleton, pair or triplet)
-				std::vector<facetElement> currentFace;
+				if (block.fatalError)
 				{
-					currentFace.reserve(tokens.size() - 1);
-					for (int i = 1; i < tokens.size(); ++i)
+					if (block.notEnoughMemory)
 					{
-						QStringList vertexTokens = tokens[i].split('/');
-						if (vertexTokens.empty() || vertexTokens[0].isEmpty())
-						{
-							objWarnings[INVALID_LINE] = true;
-							error                     = true;
-							break;
-						}
-						else
-						{
-							// new vertex
-							facetElement fe; //(0,0,0) by default
-
-							fe.vIndex = vertexTokens[0].toInt();
-							if (vertexTokens.size() > 1 && !vertexTokens[1].isEmpty())
-								fe.tcIndex = vertexTokens[1].toInt();
-							if (vertexTokens.size() > 2 && !vertexTokens[2].isEmpty())
-								fe.nIndex = vertexTokens[2].toInt();
-
-							currentFace.push_back(fe);
-						}
+						objWarnings[NOT_ENOUGH_MEMORY] = true;
 					}
-				}
-
-				if (error)
-					break;
-
-				if (currentFace.size() < 3)
-				{
-					ccLog::Warning("[OBJ] Malformed file: polygon on line %1 has less than 3 vertices!", lineCount);
 					error = true;
 					break;
 				}
 
-				// first vertex
-				std::vector<facetElement>::iterator A = currentFace.begin();
+				// indexes are relative to the number of elements read before each statement
+				const int vertexOffset   = pointsRead;
+				const int texCoordOffset = texCoordsRead;
+				const int normalOffset   = normsRead;
 
-				// the very first vertex of the group tells us about the whole sequence
-				if (facesRead == 0)
+				/*** new vertices ***/
+				if (!block.vertices.empty())
 				{
-					// we have a tex. coord index as second vertex element!
-					if (!hasTexCoords && A->tcIndex != 0 && !materialsLoadFailed)
+					// reserve more memory if necessary
+					unsigned requiredCount = vertices->size() + static_cast<unsigned>(block.vertices.size());
+					if (requiredCount > vertices->capacity())
 					{
-						if (!baseMesh->reservePerTriangleTexCoordIndexes())
+						if (!vertices->reserve(std::max(requiredCount, vertices->capacity() + vertices->capacity() / 2)))
 						{
 							objWarnings[NOT_ENOUGH_MEMORY] = true;
 							error                          = true;
 							break;
 						}
-						for (unsigned int i = 0; i < totalFacesRead; ++i)
-							baseMesh->addTriangleTexCoordIndexes(-1, -1, -1);
-
-						hasTexCoords = true;
 					}
 
-					// we have a normal index as third vertex element!
-					if (!normalsPerFacet && A->nIndex != 0)
+					for (const CCVector3d& Pd : block.vertices)
 					{
-						// so the normals are 'per-facet'
-						if (!baseMesh->reservePerTriangleNormalIndexes())
+						// first point: check for 'big' coordinates
+						if (pointsRead == 0)
 						{
-							objWarnings[NOT_ENOUGH_MEMORY] = true;
-							error                          = true;
-							break;
+							bool preserveCoordinateShift = true;
+							if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
+							{
+								if (preserveCoordinateShift)
+								{
+									vertices->setGlobalShift(Pshift);
+								}
+								ccLog::Warning("[OBJ] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+							}
 						}
-						for (unsigned int i = 0; i < totalFacesRead; ++i)
-							baseMesh->addTriangleNormalIndexes(-1, -1, -1);
-						normalsPerFacet = true;
+
+						// shifted point
+						CCVector3 P = (Pd + Pshift).toPC();
+						vertices->addPoint(P);
+						++pointsRead;
 					}
 				}
 
-				// we process all vertices accordingly
-				for (facetElement& vertex : currentFace)
+				/*** new vertex texture coordinates ***/
+				if (!block.texCoords.empty())
 				{
-					// vertex index
+					if (!texCoords)
 					{
-						if (!vertex.updatePointIndex(pointsRead))
-						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
-							break;
-						}
-						if (vertex.vIndex > maxVertexIndex)
-							maxVertexIndex = vertex.vIndex;
+						texCoords = new TextureCoordsContainer();
+						texCoords->link();
 					}
-					// should we have a tex. coord index as second vertex element?
-					if (hasTexCoords && currentMaterialDefined)
+					texCoords->insert(texCoords->end(), block.texCoords.begin(), block.texCoords.end());
+					texCoordsRead += static_cast<int>(block.texCoords.size());
+				}
+
+				/*** new vertex normals ***/
+				if (!block.normals.empty())
+				{
+					if (!normals)
 					{
-						if (!vertex.updateTexCoordIndex(texCoordsRead))
-						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
-							break;
-						}
-						if (vertex.tcIndex > maxTexCoordIndex)
-							maxTexCoordIndex = vertex.tcIndex;
+						normals = new NormsIndexesTableType;
+						normals->link();
 					}
+					normals->insert(normals->end(), block.normals.begin(), block.normals.end()); // we don't know yet if it's per-vertex or per-triangle normal...
+					normsRead += static_cast<int>(block.normals.size());
+				}
 
-					// should we have a normal index as third vertex element?
-					if (normalsPerFacet)
+				// reserve the memory for the triangles of this block (at once)
+				{
+					unsigned blockTriangleCount = 0;
+					for (const ObjStatement& st : block.statements)
 					{
-						if (!vertex.updateNormalIndex(normsRead))
+						if (st.type == ObjStatement::FACE)
 						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
-							break;
+							blockTriangleCount += st.count - 2;
 						}
-						if (vertex.nIndex > maxTriNormIndex)
-							maxTriNormIndex = vertex.nIndex;
 					}
-				}
-
-				// don't forget material (common for all vertices)
-				if (currentMaterialDefined && !materialsLoadFailed)
-				{
-					if (!hasMaterial)
+					unsigned requiredCount = baseMesh->size() + blockTriangleCount;
+					if (requiredCount > baseMesh->capacity())
 					{
-						if (!baseMesh->reservePerTriangleMtlIndexes())
+						if (!baseMesh->reserve(std::max(requiredCount, baseMesh->capacity() + baseMesh->capacity() / 2)))
 						{
 							objWarnings[NOT_ENOUGH_MEMORY] = true;
 							error                          = true;
 							break;
 						}
-						for (unsigned int i = 0; i < totalFacesRead; ++i)
-							baseMesh->addTriangleMtlIndex(-1);
-
-						hasMaterial = true;
 					}
 				}
 
-				if (error)
-					break;
-
-				// Now, let's tesselate the whole polygon
-				bool shouldTesselate = (currentFace.size() > 4 && vertices);
-				if (shouldTesselate)
+				for (const ObjStatement& st : block.statements)
 				{
-					for (const facetElement& fe : currentFace)
+					/*** new group ***/
+					if (st.type == ObjStatement::GROUP)
 					{
-						if (fe.vIndex < 0 || vertices->size() <= static_cast<unsigned>(fe.vIndex))
-						{
-							// we haven't loaded all the vertices?! Too bad, we can't tesselate properly :(
-							ccLog::Warning("[OBJ] Failed to tesselate face");
-							shouldTesselate = false;
-							break;
-						}
+						// update new group index
+						facesRead = 0;
+						// get the group name
+						QString groupName = block.name(st).simplified();
+						if (groupName.isEmpty())
+							groupName = "default";
+						// push previous group descriptor (if none was pushed)
+						if (groups.empty() && totalFacesRead > 0)
+							groups.emplace_back(0, "default");
+						// push new group descriptor
+						if (!groups.empty() && groups.back().first == totalFacesRead)
+							groups.back().second = groupName; // simply replace the group name if the previous group was empty!
+						else
+							groups.emplace_back(totalFacesRead, groupName);
+						polyCount = 0; // restart polyline count at 0!
 					}
-				}
-				if (shouldTesselate)
-				{
-					try
+					/*** new face ***/
+					else if (st.type == ObjStatement::FACE)
 					{
-						CCCoreLib::PointCloud contour;
-						contour.reserve(static_cast<unsigned>(currentFace.size()));
+						const int pointCount    = vertexOffset + static_cast<int>(st.vCount);
+						const int texCoordCount = texCoordOffset + static_cast<int>(st.vtCount);
+						const int normalCount   = normalOffset + static_cast<int>(st.vnCount);
+
+						// the face elements (singleton, pair or triplet)
+						currentFace.assign(block.elements.begin() + st.first, block.elements.begin() + (st.first + st.count));
+
+						// first vertex
+						std::vector<facetElement>::iterator A = currentFace.begin();
+
+						// the very first vertex of the group tells us about the whole sequence
+						if (facesRead == 0)
+						{
+							// we have a tex. coord index as second vertex element!
+							if (!hasTexCoords && A->tcIndex != 0 && !materialsLoadFailed)
+							{
+								if (!baseMesh->reservePerTriangleTexCoordIndexes())
+								{
+									objWarnings[NOT_ENOUGH_MEMORY] = true;
+									error                          = true;
+									break;
+								}
+								for (unsigned int i = 0; i < totalFacesRead; ++i)
+									baseMesh->addTriangleTexCoordIndexes(-1, -1, -1);
+
+								hasTexCoords = true;
+							}
+
+							// we have a normal index as third vertex element!
+							if (!normalsPerFacet && A->nIndex != 0)
+							{
+								// so the normals are 'per-facet'
+								if (!baseMesh->reservePerTriangleNormalIndexes())
+								{
+									objWarnings[NOT_ENOUGH_MEMORY] = true;
+									error                          = true;
+									break;
+								}
+								for (unsigned int i = 0; i < totalFacesRead; ++i)
+									baseMesh->addTriangleNormalIndexes(-1, -1, -1);
+								normalsPerFacet = true;
+							}
+						}
 
-						for (const facetElement& fe : currentFace)
+						// we process all vertices accordingly
+						for (facetElement& vertex : currentFace)
 						{
-							contour.addPoint(*vertices->getPoint(fe.vIndex));
+							// vertex index
+							{
+								if (!vertex.updatePointIndex(pointCount))
+								{
+									objWarnings[INVALID_INDEX] = true;
+									error                      = true;
+									break;
+								}
+								if (vertex.vIndex > maxVertexIndex)
+									maxVertexIndex = vertex.vIndex;
+							}
+							// should we have a tex. coord index as second vertex element?
+							if (hasTexCoords && currentMaterialDefined)
+							{
+								if (!vertex.updateTexCoordIndex(texCoordCount))
+								{
+									objWarnings[INVALID_INDEX] = true;
+									error                      = true;
+									break;
+								}
+								if (vertex.tcIndex > maxTexCoordIndex)
+									maxTexCoordIndex = vertex.tcIndex;
+							}
+
+							// should we have a normal index as third vertex element?
+							if (normalsPerFacet)
+							{
+								if (!vertex.updateNormalIndex(normalCount))
+								{
+									objWarnings[INVALID_INDEX] = true;
+									error                      = true;
+									break;
+								}
+								if (vertex.nIndex > maxTriNormIndex)
+									maxTriNormIndex = vertex.nIndex;
+							}
 						}
-						CCCoreLib::Delaunay2dMesh* dMesh = CCCoreLib::Delaunay2dMesh::TesselateContour(&contour);
-						if (dMesh)
+
+						// don't forget material (common for all vertices)
+						if (currentMaterialDefined && !materialsLoadFailed)
 						{
-							// need more space?
-							unsigned triCount = dMesh->size();
-							if (baseMesh->size() + triCount >= baseMesh->capacity())
+							if (!hasMaterial)
 							{
-								if (!baseMesh->reserve(baseMesh->size() + std::max(triCount, 4096u)))
+								if (!baseMesh->reservePerTriangleMtlIndexes())
 								{
 									objWarnings[NOT_ENOUGH_MEMORY] = true;
 									error                          = true;
 									break;
 								}
+								for (unsigned int i = 0; i < totalFacesRead; ++i)
+									baseMesh->addTriangleMtlIndex(-1);
+
+								hasMaterial = true;
 							}
+						}
+
+						if (error)
+							break;
 
-							// push new triangle
-							const int* _triIndexes = dMesh->getTriangleVertIndexesArray();
-							// determine if the triangles must be flipped or not
-							bool flip = false;
+						// Now, let's tesselate the whole polygon
+						bool shouldTesselate = (currentFace.size() > 4);
+						if (shouldTesselate)
+						{
+							for (const facetElement& fe : currentFace)
 							{
-								for (unsigned i = 0; i < triCount; ++i, _triIndexes += 3)
+								if (fe.vIndex < 0 || pointCount <= fe.vIndex)
 								{
-									int i1 = _triIndexes[0];
-									int i2 = _triIndexes[1];
-									int i3 = _triIndexes[2];
-									// by definition the first edge of the original polygon
-									// should be in the same 'direction' of the triangle that uses it
-									if ((i1 == 0 || i2 == 0 || i3 == 0)
-									    && (i1 == 1 || i2 == 1 || i3 == 1))
+									// we haven't loaded all the vertices?! Too bad, we can't tesselate properly :(
+									ccLog::Warning("[OBJ] Failed to tesselate face");
+									shouldTesselate = false;
+									break;
+								}
+							}
+						}
+						if (shouldTesselate)
+						{
+							try
+							{
+								CCCoreLib::PointCloud contour;
+								contour.reserve(static_cast<unsigned>(currentFace.size()));
+
+								for (const facetElement& fe : currentFace)
+								{
+									contour.addPoint(*vertices->getPoint(fe.vIndex));
+								}
+								CCCoreLib::Delaunay2dMesh* dMesh = CCCoreLib::Delaunay2dMesh::TesselateContour(&contour);
+								if (dMesh)
+								{
+									// need more space?
+									unsigned triCount = dMesh->size();
+									if (baseMesh->size() + triCount >= baseMesh->capacity())
 									{
-										if ((i1 == 1 && i2 == 0)
-										    || (i2 == 1 && i3 == 0)
-										    || (i3 == 1 && i1 == 0))
+										if (!baseMesh->reserve(baseMesh->size() + std::max(triCount, 4096u)))
 										{
-											flip = true;
+											objWarnings[NOT_ENOUGH_MEMORY] = true;
+											error                          = true;
+											break;
+										}
+									}
+
+									// push new triangle
+									const int* _triIndexes = dMesh->getTriangleVertIndexesArray();
+									// determine if the triangles must be flipped or not
+									bool flip = false;
+									{
+										for (unsigned i = 0; i < triCount; ++i, _triIndexes += 3)
+										{
+											int i1 = _triIndexes[0];
+											int i2 = _triIndexes[1];
+											int i3 = _triIndexes[2];
+											// by definition the first edge of the original polygon
+											// should be in the same 'direction' of the triangle that uses it
+											if ((i1 == 0 || i2 == 0 || i3 == 0)
+											    && (i1 == 1 || i2 == 1 || i3 == 1))
+											{
+												if ((i1 == 1 && i2 == 0)
+												    || (i2 == 1 && i3 == 0)
+												    || (i3 == 1 && i1 == 0))
+												{
+													flip = true;
+												}
+												break;
+											}
 										}
-										break;
 									}
+
+									_triIndexes = dMesh->getTriangleVertIndexesArray();
+									for (unsigned i = 0; i < triCount; ++i, _triIndexes += 3)
+									{
+										const facetElement& f1 = currentFace[_triIndexes[0]];
+										facetElement        f2 = currentFace[_triIndexes[1]];
+										facetElement        f3 = currentFace[_triIndexes[2]];
+
+										if (flip)
+											std::swap(f2, f3);
+
+										baseMesh->addTriangle(f1.vIndex, f2.vIndex, f3.vIndex);
+
+										if (hasMaterial)
+											baseMesh->addTriangleMtlIndex(currentMaterial);
+
+										if (hasTexCoords)
+											baseMesh->addTriangleTexCoordIndexes(f1.tcIndex, f2.tcIndex, f3.tcIndex);
+
+										if (normalsPerFacet)
+											baseMesh->addTriangleNormalIndexes(f1.nIndex, f2.nIndex, f3.nIndex);
+
+										++facesRead;
+										++totalFacesRead;
+									}
+
+									delete dMesh;
+									dMesh = nullptr;
+								}
+								else
+								{
+									ccLog::Warning("[OBJ] Failed to tesselate face");
+									shouldTesselate = false;
 								}
 							}
-
-							_triIndexes = dMesh->getTriangleVertIndexesArray();
-							for (unsigned i = 0; i < triCount; ++i, _triIndexes += 3)
+							catch (const std::bad_alloc&)
 							{
-								const facetElement& f1 = currentFace[_triIndexes[0]];
-								facetElement        f2 = currentFace[_triIndexes[1]];
-								facetElement        f3 = currentFace[_triIndexes[2]];
+								// not enough memory to tesselate!
+								shouldTesselate = false;
+							}
+						}
 
-								if (flip)
-									std::swap(f2, f3);
+						if (!shouldTesselate)
+						{
+							std::vector<facetElement>::const_iterator B = A + 1;
+							std::vector<facetElement>::const_iterator C = B + 1;
+							for (; C != currentFace.end(); ++B, ++C)
+							{
+								// need more space?
+								if (baseMesh->size() == baseMesh->capacity())
+								{
+									if (!baseMesh->reserve(baseMesh->size() + 4096))
+									{
+										objWarnings[NOT_ENOUGH_MEMORY] = true;
+										error                          = true;
+										break;
+									}
+								}
 
-								baseMesh->addTriangle(f1.vIndex, f2.vIndex, f3.vIndex);
+								// push new triangle
+								baseMesh->addTriangle(A->vIndex, B->vIndex, C->vIndex);
+								++facesRead;
+								++totalFacesRead;
 
 								if (hasMaterial)
 									baseMesh->addTriangleMtlIndex(currentMaterial);
 
 								if (hasTexCoords)
-									baseMesh->addTriangleTexCoordIndexes(f1.tcIndex, f2.tcIndex, f3.tcIndex);
+									baseMesh->addTriangleTexCoordIndexes(A->tcIndex, B->tcIndex, C->tcIndex);
 
 								if (normalsPerFacet)
-									baseMesh->addTriangleNormalIndexes(f1.nIndex, f2.nIndex, f3.nIndex);
-
-								++facesRead;
-								++totalFacesRead;
+									baseMesh->addTriangleNormalIndexes(A->nIndex, B->nIndex, C->nIndex);
 							}
-
-							delete dMesh;
-							dMesh = nullptr;
-						}
-						else
-						{
-							ccLog::Warning("[OBJ] Failed to tesselate face");
-							shouldTesselate = false;
 						}
 					}
-					catch (const std::bad_alloc&)
+					/*** polyline ***/
+					else if (st.type == ObjStatement::POLYLINE)
 					{
-						// not enough memory to tesselate!
-						shouldTesselate = false;
-					}
-				}
+						const int pointCount = vertexOffset + static_cast<int>(st.vCount);
 
-				if (!shouldTesselate)
-				{
-					std::vector<facetElement>::const_iterator B = A + 1;
-					std::vector<facetElement>::const_iterator C = B + 1;
-					for (; C != currentFace.end(); ++B, ++C)
-					{
-						// need more space?
-						if (baseMesh->size() == baseMesh->capacity())
+						ccPolyline* polyline = new ccPolyline(vertices);
+						if (!polyline->reserve(st.count))
+						{
+							// not enough memory
+							objWarnings[NOT_ENOUGH_MEMORY] = true;
+							delete polyline;
+							polyline = nullptr;
+							continue;
+						}
+
+						for (unsigned i = 0; i < st.count; ++i)
 						{
-							if (!baseMesh->reserve(baseMesh->size() + 4096))
+							// get next polyline's vertex index
+							int index = block.elements[st.first + i].vIndex; // we ignore normal index (if any!)
+							if (!UpdatePointIndex(index, pointCount))
 							{
-								objWarnings[NOT_ENOUGH_MEMORY] = true;
-								error                          = true;
+								objWarnings[INVALID_INDEX] = true;
+								error                      = true;
 								break;
 							}
-						}
-
-						// push new triangle
-						baseMesh->addTriangle(A->vIndex, B->vIndex, C->vIndex);
-						++facesRead;
-						++totalFacesRead;
-
-						if (hasMaterial)
-							baseMesh->addTriangleMtlIndex(currentMaterial);
-
-						if (hasTexCoords)
-							baseMesh->addTriangleTexCoordIndexes(A->tcIndex, B->tcIndex, C->tcIndex);
-
-						if (normalsPerFacet)
-							baseMesh->addTriangleNormalIndexes(A->nIndex, B->nIndex, C->nIndex);
-					}
-				}
-			}
-			/*** polyline ***/
-			else if (tokens.front().startsWith('l'))
-			{
-				// malformed line?
-				if (tokens.size() < 3)
-				{
-					objWarnings[INVALID_LINE] = true;
-					currentLine               = stream.readLine();
-					continue;
-				}
 
-				// read the face elements (singleton, pair or triplet)
-				ccPolyline* polyline = new ccPolyline(vertices);
-				if (!polyline->reserve(static_cast<unsigned>(tokens.size() - 1)))
-				{
-					// not enough memory
-					objWarnings[NOT_ENOUGH_MEMORY] = true;
-					delete polyline;
-					polyline    = nullptr;
-					currentLine = stream.readLine();
-					continue;
-				}
+							polyline->addPointIndex(index);
+						}
 
-				for (int i = 1; i < tokens.size(); ++i)
-				{
-					// get next polyline's vertex index
-					QStringList vertexTokens = tokens[i].split('/');
-					if (vertexTokens.empty() || vertexTokens[0].isEmpty())
-					{
-						objWarnings[INVALID_LINE] = true;
-						error                     = true;
-						break;
-					}
-					else
-					{
-						int index = vertexTokens[0].toInt(); // we ignore normal index (if any!)
-						if (!UpdatePointIndex(index, pointsRead))
+						if (error)
 						{
-							objWarnings[INVALID_INDEX] = true;
-							error                      = true;
+							delete polyline;
+							polyline = nullptr;
 							break;
 						}
 
-						polyline->addPointIndex(index);
+						polyline->setVisible(true);
+						QString name = groups.empty() ? QString("Line") : groups.back().second + QString(".line");
+						polyline->setName(QString("%1 %2").arg(name).arg(++polyCount));
+						vertices->addChild(polyline);
 					}
-				}
-
-				if (error)
-				{
-					delete polyline;
-					polyline = nullptr;
-					break;
-				}
-
-				polyline->setVisible(true);
-				QString name = groups.empty() ? QString("Line") : groups.back().second + QString(".line");
-				polyline->setName(QString("%1 %2").arg(name).arg(++polyCount));
-				vertices->addChild(polyline);
-			}
-			/*** material ***/
-			else if (tokens.front() == "usemtl") // see 'MTL file' below
-			{
-				if (materials) // otherwise we have failed to load MTL file!!!
-				{
-					QString mtlName = currentLine.mid(7).trimmed();
-					// DGM: in case there's space characters in the material name, we must read it again from the original line buffer
-					// QString mtlName = (tokens.size() > 1 && !tokens[1].isEmpty() ? tokens[1] : "");
-					currentMaterial        = (!mtlName.isEmpty() ? materials->findMaterialByName(mtlName) : -1);
-					currentMaterialDefined = true;
-				}
-			}
-			/*** material file (MTL) ***/
-			else if (tokens.front() == "mtllib")
-			{
-				// malformed line?
-				if (tokens.size() < 2 || tokens[1].isEmpty())
-				{
-					objWarnings[INVALID_LINE] = true;
-				}
-				else
-				{
-					// we build the whole MTL filename + path
-					// DGM: in case there's space characters in the filename, we must read it again from the original line buffer
-					// QString mtlFilename = tokens[1];
-					QString mtlFilename = currentLine.mid(7).trimmed();
-					// remove any quotes around the filename (Photoscan 1.4 bug)
-					if (mtlFilename.startsWith("\""))
+					/*** material ***/
+					else if (st.type == ObjStatement::USE_MTL) // see 'MTL file' below
 					{
-						mtlFilename = mtlFilename.right(mtlFilename.size() - 1);
+						if (materials) // otherwise we have failed to load MTL file!!!
+						{
+							QString mtlName        = block.name(st).trimmed();
+							currentMaterial        = (!mtlName.isEmpty() ? materials->findMaterialByName(mtlName) : -1);
+							currentMaterialDefined = true;
+						}
 					}
-					if (mtlFilename.endsWith("\""))
+					/*** material file (MTL) ***/
+					else if (st.type == ObjStatement::MTL_LIB)
 					{
-						mtlFilename = mtlFilename.left(mtlFilename.size() - 1);
-					}
-					ccLog::Print(QString("[OBJ] Material file: ") + mtlFilename);
+						// we build the whole MTL filename + path
+						QString mtlFilename = block.name(st).trimmed();
+						// remove any quotes around the filename (Photoscan 1.4 bug)
+						if (mtlFilename.startsWith("\""))
+						{
+							mtlFilename = mtlFilename.right(mtlFilename.size() - 1);
+						}
+						if (mtlFilename.endsWith("\""))
+						{
+							mtlFilename = mtlFilename.left(mtlFilename.size() - 1);
+						}
+						ccLog::Print(QString("[OBJ] Material file: ") + mtlFilename);
 
-					// we try to load it
-					if (!materials)
-					{
-						materials = new ccMaterialSet("materials");
-						materials->link();
-					}
-					size_t oldSize = materials->size();
+						// we try to load it
+						if (!materials)
+						{
+							materials = new ccMaterialSet("materials");
+							materials->link();
+						}
+						size_t oldSize = materials->size();
 
-					QStringList errors;
-					QString     mtlPath = QFileInfo(filename).absolutePath();
-					if (ccMaterialSet::ParseMTL(mtlPath, mtlFilename, *materials, errors))
-					{
-						ccLog::Print("[OBJ] %zu materials loaded", materials->size() - oldSize);
-						materialsLoadFailed = false;
-					}
-					else
-					{
-						ccLog::Error(QString("[OBJ] Failed to load material file! (should be in '%1')").arg(mtlPath + '/' + QString(mtlFilename)));
-						materialsLoadFailed = true;
-					}
+						QStringList errors;
+						QString     mtlPath = QFileInfo(filename).absolutePath();
+						if (ccMaterialSet::ParseMTL(mtlPath, mtlFilename, *materials, errors))
+						{
+							ccLog::Print("[OBJ] %zu materials loaded", materials->size() - oldSize);
+							materialsLoadFailed = false;
+						}
+						else
+						{
+							ccLog::Error(QString("[OBJ] Failed to load material file! (should be in '%1')").arg(mtlPath + '/' + QString(mtlFilename)));
+							materialsLoadFailed = true;
+						}
 
-					if (!errors.empty())
-					{
-						for (int i = 0; i < errors.size(); ++i)
-							ccLog::Warning(QString("[OBJ::Load::MTL parser] ") + errors[i]);
-					}
-					if (materials->empty())
-					{
-						materials->release();
-						materials           = nullptr;
-						materialsLoadFailed = true;
+						if (!errors.empty())
+						{
+							for (int i = 0; i < errors.size(); ++i)
+								ccLog::Warning(QString("[OBJ::Load::MTL parser] ") + errors[i]);
+						}
+						if (materials->empty())
+						{
+							materials->release();
+							materials           = nullptr;
+							materialsLoadFailed = true;
+						}
 					}
-				}
-			}
-			///*** shading group ***/
-			// else if (tokens.front() == "s")
-			//{
-			//	//ignored!
-			// }
 
-			if (error)
-				break;
+					if (error)
+						break;
+				}
 
-			currentLine = stream.readLine();
+				// the parsed data is not needed anymore
+				block.clear();
+			}
 		}
 	}
 	catch (const std::bad_alloc&)
@@ -1248,6 +1755,7 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 		error                          = true;
 	}
 
+	blocks.clear();
 	file.close();
 
 	// 1st check
@@ -26,6 +26,8 @@
 #include <QString>
 #include <QStringList>
 #include <QTextStream>
+#include <QThread>
+#include <QtConcurrentMap>
 
 // qCC_db
 #include <ccHObjectCaster.h>
@@ -37,7 +39,10 @@
 #include <ccProgressDialog.h>
 
 // System
+#include <algorithm>
 #include <cstring>
+#include <limits>
+#include <unordered_map>
 
 STLFilter::STLFilter()
     : FileIOFilter({"_STL Filter",
@@ -355,9 +360,12 @@ CC_FILE_ERROR STLFilter::loadFile(const QString& filename, ccHObject& container,
 		}
 	}
 
-	// remove duplicated vertices
-	mesh->mergeDuplicatedVertices(ccMesh::DefaultMergeDuplicateVerticesLevel, parameters.parentWidget);
-	vertices = nullptr; // warning, after this point, 'vertices' is not valid anymore
+	// remove duplicated vertices (binary files are already welded while loading)
+	if (ascii)
+	{
+		mesh->mergeDuplicatedVertices(ccMesh::DefaultMergeDuplicateVerticesLevel, parameters.parentWidget);
+		vertices = nullptr; // warning, after this point, 'vertices' is not valid anymore
+	}
 
 	ccGenericPointCloud* meshVertices = mesh->getAssociatedCloud();
 	if (mesh->size() != 0 && meshVertices) // their might not remain anymore triangle after 'mergeDuplicatedVertices'
@@ -704,6 +712,67 @@ CC_FILE_ERROR STLFilter::loadASCIIFile(QFile&          fp,
 	return result;
 }
 
+namespace
+{
+	//! Size of a binary STL facet record (REAL32[3] normal + 3 x REAL32[3] vertices + UINT16 attribute)
+	constexpr qint64 s_binaryRecordSize = 50;
+	//! Number of facets per parallel parsing task
+	constexpr unsigned s_binaryFacetBlockSize = (1 << 16);
+
+	//! Exact (bitwise) coordinates of a binary STL vertex
+	struct BinaryVertexKey
+	{
+		uint32_t bits[3];
+
+		inline bool operator==(const BinaryVertexKey& other) const
+		{
+			return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+		}
+	};
+
+	struct BinaryVertexKeyHash
+	{
+		inline size_t operator()(const BinaryVertexKey& key) const
+		{
+			uint64_t h = key.bits[0];
+			h          = (h * 0x9E3779B97F4A7C15ULL) ^ key.bits[1];
+			h          = (h * 0x9E3779B97F4A7C15ULL) ^ key.bits[2];
+			h          = (h * 0x9E3779B97F4A7C15ULL);
+			return static_cast<size_t>(h ^ (h >> 32));
+		}
+	};
+
+	//! Returns the key of the k-th vertex of a binary STL facet record
+	inline BinaryVertexKey ReadBinaryVertexKey(const char* record, unsigned k)
+	{
+		BinaryVertexKey key;
+		memcpy(key.bits, record + 12 * (k + 1), 12);
+		for (uint32_t& b : key.bits)
+		{
+			// -0.0 and +0.0 are the same coordinate
+			if (b == 0x80000000u)
+			{
+				b = 0;
+			}
+		}
+		return key;
+	}
+
+	inline CCVector3d BinaryVertexKeyToVector(const BinaryVertexKey& key)
+	{
+		float Pf[3];
+		memcpy(Pf, key.bits, 12);
+		return CCVector3d(Pf[0], Pf[1], Pf[2]);
+	}
+
+	//! Range of consecutive facets
+	struct BinaryFacetBlock
+	{
+		unsigned start;
+		unsigned count;
+	};
+} // namespace
+
 CC_FILE_ERROR STLFilter::loadBinaryFile(QFile&          fp,
                                         ccMesh*         mesh,
                                         ccPointCloud*   vertices,
@@ -711,8 +780,7 @@ CC_FILE_ERROR STLFilter::loadBinaryFile(QFile&          fp,
 {
 	assert(fp.isOpen() && mesh && vertices);
 
-	unsigned pointCount = 0;
-	unsigned faceCount  = 0;
+	unsigned faceCount = 0;
 
 	// UINT8[80] Header (we skip it)
 	fp.seek(80);
@@ -720,22 +788,85 @@ CC_FILE_ERROR STLFilter::loadBinaryFile(QFile&          fp,
 
 	// UINT32 Number of triangles
 	{
-		unsigned tmpInt32;
+		uint32_t tmpInt32 = 0;
 		if (fp.read((char*)&tmpInt32, 4) < 4)
 			return CC_FERR_READING;
 		faceCount = tmpInt32;
 	}
 
-	if (!mesh->reserve(faceCount))
+	// check that the file really contains all the announced facets
+	{
+		qint64 availableCount = (fp.size() - 84) / s_binaryRecordSize;
+		if (availableCount < static_cast<qint64>(faceCount))
+		{
+			ccLog::Warning(QString("[STL] File is truncated: only %1 facet(s) out of %2 can be read").arg(availableCount).arg(faceCount));
+			faceCount = static_cast<unsigned>(std::max<qint64>(availableCount, 0));
+		}
+	}
+	if (faceCount == 0)
+	{
+		return CC_FERR_NO_ERROR;
+	}
+
+	// each facet has 3 vertex 'slots' (before welding)
+	if (static_cast<uint64_t>(faceCount) * 3 > std::numeric_limits<unsigned>::max())
+	{
+		ccLog::Warning("[STL] Too many facets");
 		return CC_FERR_NOT_ENOUGH_MEMORY;
-	if (!vertices->reserve(3 * faceCount))
+	}
+	const unsigned slotCount = 3 * faceCount;
+
+	// access to the facet records (memory mapped if possible, read by large blocks otherwise)
+	const qint64      payloadSize = static_cast<qint64>(faceCount) * s_binaryRecordSize;
+	std::vector<char> payloadBuffer;
+	const char*       payload = reinterpret_cast<const char*>(fp.map(84, payloadSize));
+	if (!payload)
+	{
+		try
+		{
+			payloadBuffer.resize(static_cast<size_t>(payloadSize));
+		}
+		catch (const std::bad_alloc&)
+		{
+			return CC_FERR_NOT_ENOUGH_MEMORY;
+		}
+
+		static const qint64 s_readBlockSize = s_binaryFacetBlockSize * s_binaryRecordSize;
+		fp.seek(84);
+		for (qint64 pos = 0; pos < payloadSize; pos += s_readBlockSize)
+		{
+			qint64 toRead = std::min(s_readBlockSize, payloadSize - pos);
+			if (fp.read(payloadBuffer.data() + pos, toRead) < toRead)
+				return CC_FERR_READING;
+		}
+		payload = payloadBuffer.data();
+	}
+
+	if (!mesh->reserve(faceCount))
 		return CC_FERR_NOT_ENOUGH_MEMORY;
 	NormsIndexesTableType* normals = mesh->getTriNormsTable();
-	if (normals && (!normals->reserveSafe(faceCount) || !mesh->reservePerTriangleNormalIndexes()))
+	if (normals && (!normals->resizeSafe(faceCount) || !mesh->reservePerTriangleNormalIndexes()))
 	{
 		ccLog::Warning("[STL] Not enough memory: can't store normals!");
 		mesh->removePerTriangleNormalIndexes();
 		mesh->setTriNormsTable(nullptr);
+		normals = nullptr;
+	}
+
+	// the slots are dispatched in several hash maps (shards) that can be filled concurrently
+	const int      threadCount = std::max(1, QThread::idealThreadCount());
+	const unsigned shardCount  = static_cast<unsigned>(std::min(threadCount * 4, 256));
+
+	std::vector<unsigned char> slotShards;
+	std::vector<unsigned>      slotToVertex;
+	try
+	{
+		slotShards.resize(slotCount);
+		slotToVertex.resize(slotCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CC_FERR_NOT_ENOUGH_MEMORY;
 	}
 
 	// progress dialog
@@ -748,78 +879,228 @@ CC_FILE_ERROR STLFilter::loadBinaryFile(QFile&          fp,
 		pDlg->start();
 		QApplication::processEvents();
 	}
-	CCCoreLib::NormalizedProgress nProgress(pDlg.data(), faceCount);
 
 	// current vertex shift
 	CCVector3d Pshift(0, 0, 0);
+	{
+		// first point: check for 'big' coordinates
+		CCVector3d Pd                      = BinaryVertexKeyToVector(ReadBinaryVertexKey(payload, 0));
+		bool       preserveCoordinateShift = true;
+		if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
+		{
+			if (preserveCoordinateShift)
+			{
+				vertices->setGlobalShift(Pshift);
+			}
+			ccLog::Warning("[STLFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+		}
+	}
 
-	for (unsigned f = 0; f < faceCount; ++f)
+	// 1st pass (parallel): per-facet normals and vertex shards
 	{
-		// REAL32[3] Normal vector
-		assert(sizeof(float) == 4);
-		CCVector3 N;
-		if (fp.read((char*)N.u, 12) < 12)
-			return CC_FERR_READING;
+		std::vector<BinaryFacetBlock> blocks;
+		blocks.reserve(faceCount / s_binaryFacetBlockSize + 1);
+		for (unsigned start = 0; start < faceCount; start += s_binaryFacetBlockSize)
+		{
+			blocks.push_back({start, std::min(s_binaryFacetBlockSize, faceCount - start)});
+		}
 
-		// 3 vertices
-		unsigned vertIndexes[3];
-		for (unsigned i = 0; i < 3; ++i)
+		BinaryVertexKeyHash hasher;
+		QtConcurrent::blockingMap(blocks, [&](const BinaryFacetBlock& block)
+		                          {
+			for (unsigned f = block.start; f < block.start + block.count; ++f)
+			{
+				const char* record = payload + f * s_binaryRecordSize;
+
+				if (normals)
+				{
+					// REAL32[3] Normal vector
+					float Nf[3];
+					memcpy(Nf, record, 12);
+					CCVector3 N(static_cast<PointCoordinateType>(Nf[0]),
+					            static_cast<PointCoordinateType>(Nf[1]),
+					            static_cast<PointCoordinateType>(Nf[2]));
+					normals->setValue(f, ccNormalVectors::GetNormIndex(N.u));
+				}
+
+				// REAL32[3] Vertex 1,2 & 3
+				for (unsigned k = 0; k < 3; ++k)
+				{
+					size_t h = hasher(ReadBinaryVertexKey(record, k));
+					slotShards[3 * f + k] = static_cast<unsigned char>((h >> 24) % shardCount);
+				}
+			} });
+
+		if (pDlg)
 		{
-			// REAL32[3] Vertex 1,2 & 3
-			float Pf[3];
-			if (fp.read((char*)Pf, 12) < 0)
-				return CC_FERR_READING;
+			pDlg->update(30.0f);
+			if (pDlg->wasCanceled())
+			{
+				return CC_FERR_NO_ERROR;
+			}
+		}
+	}
 
-			// first point: check for 'big' coordinates
-			CCVector3d Pd(Pf[0], Pf[1], Pf[2]);
-			if (pointCount == 0)
+	// 2nd pass (parallel): weld the vertices sharing the exact same coordinates
+	// (each slot points to the first slot with the same coordinates)
+	{
+		// group the slots by shard (counting sort, so that the slots remain in increasing order in each shard)
+		std::vector<unsigned> shardStart(shardCount + 1, 0);
+		std::vector<unsigned> shardSlots;
+		try
+		{
+			shardSlots.resize(slotCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return CC_FERR_NOT_ENOUGH_MEMORY;
+		}
+		for (unsigned s = 0; s < slotCount; ++s)
+		{
+			++shardStart[slotShards[s] + 1];
+		}
+		for (unsigned i = 0; i < shardCount; ++i)
+		{
+			shardStart[i + 1] += shardStart[i];
+		}
+		{
+			std::vector<unsigned> fillPos(shardStart.begin(), shardStart.end() - 1);
+			for (unsigned s = 0; s < slotCount; ++s)
 			{
-				bool preserveCoordinateShift = true;
-				if (HandleGlobalShift(Pd, Pshift, preserveCoordinateShift, parameters))
+				shardSlots[fillPos[slotShards[s]]++] = s;
+			}
+		}
+
+		std::vector<unsigned> shards(shardCount);
+		for (unsigned i = 0; i < shardCount; ++i)
+		{
+			shards[i] = i;
+		}
+
+		QAtomicInt memoryError(0);
+		QtConcurrent::blockingMap(shards, [&](unsigned shard)
+		                          {
+			try
+			{
+				const unsigned* slotIt  = shardSlots.data() + shardStart[shard];
+				const unsigned* slotEnd = shardSlots.data() + shardStart[shard + 1];
+
+				std::unordered_map<BinaryVertexKey, unsigned, BinaryVertexKeyHash> firstSlots;
+				// on a closed mesh, each vertex is shared by ~6 triangles
+				firstSlots.reserve(static_cast<size_t>(slotEnd - slotIt) / 6 + 1);
+
+				for (; slotIt != slotEnd; ++slotIt)
 				{
-					if (preserveCoordinateShift)
-					{
-						vertices->setGlobalShift(Pshift);
-					}
-					ccLog::Warning("[STLFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", Pshift.x, Pshift.y, Pshift.z);
+					unsigned        s      = *slotIt;
+					const char*     record = payload + (s / 3) * s_binaryRecordSize;
+					BinaryVertexKey key    = ReadBinaryVertexKey(record, s % 3);
+					// slots are visited in increasing order: the first one always wins
+					slotToVertex[s]        = firstSlots.emplace(key, s).first->second;
 				}
 			}
+			catch (const std::bad_alloc&)
+			{
+				memoryError.storeRelease(1);
+			} });
 
-			CCVector3 P = (Pd + Pshift).toPC();
+		if (memoryError.loadAcquire() != 0)
+		{
+			return CC_FERR_NOT_ENOUGH_MEMORY;
+		}
 
-			// insert new point
-			vertIndexes[i] = pointCount++;
-			vertices->addPoint(P);
+		slotShards.clear();
+		slotShards.shrink_to_fit();
+		shardSlots.clear();
+		shardSlots.shrink_to_fit();
+
+		if (pDlg)
+		{
+			pDlg->update(70.0f);
+			if (pDlg->wasCanceled())
+			{
+				return CC_FERR_NO_ERROR;
+			}
 		}
+	}
 
-		// UINT16 Attribute byte count (not used)
+	// 3rd pass: create the welded vertices (in order of first appearance)
+	{
+		unsigned vertCount = 0;
+		for (unsigned s = 0; s < slotCount; ++s)
 		{
-			char a[2];
-			if (fp.read(a, 2) < 0)
-				return CC_FERR_READING;
+			if (slotToVertex[s] == s)
+			{
+				++vertCount;
+			}
+		}
+		if (!vertices->reserve(vertCount))
+		{
+			return CC_FERR_NOT_ENOUGH_MEMORY;
 		}
 
-		// we have successfully read the 3 vertices
-		// let's add a new triangle
+		vertCount = 0;
+		for (unsigned s = 0; s < slotCount; ++s)
 		{
-			mesh->addTriangle(vertIndexes[0], vertIndexes[1], vertIndexes[2]);
+			unsigned firstSlot = slotToVertex[s];
+			if (firstSlot == s)
+			{
+				const char* record = payload + (s / 3) * s_binaryRecordSize;
+				CCVector3d  Pd     = BinaryVertexKeyToVector(ReadBinaryVertexKey(record, s % 3));
+				vertices->addPoint((Pd + Pshift).toPC());
+				slotToVertex[s] = vertCount++;
+			}
+			else
+			{
+				// the first slot has already been replaced by its vertex index
+				assert(firstSlot < s);
+				slotToVertex[s] = slotToVertex[firstSlot];
+			}
 		}
 
-		// and a new normal?
-		if (normals)
+		if (pDlg)
 		{
-			// compress normal
-			int                index  = static_cast<int>(normals->currentSize());
-			CompressedNormType nIndex = ccNormalVectors::GetNormIndex(N.u);
-			normals->addElement(nIndex);
-			mesh->addTriangleNormalIndexes(index, index, index);
+			pDlg->update(85.0f);
 		}
+	}
 
-		// progress
-		if (pDlg && !nProgress.oneStep())
+	// 4th pass: create the triangles
+	{
+		unsigned collapsedCount = 0;
+		for (unsigned f = 0; f < faceCount; ++f)
 		{
-			break;
+			unsigned i1 = slotToVertex[3 * f];
+			unsigned i2 = slotToVertex[3 * f + 1];
+			unsigned i3 = slotToVertex[3 * f + 2];
+
+			// very small triangles (or flat ones) are implicitly removed by vertex fusion!
+			if (i1 == i2 || i1 == i3 || i2 == i3)
+			{
+				++collapsedCount;
+				continue;
+			}
+
+			mesh->addTriangle(i1, i2, i3);
+			if (normals)
+			{
+				int index = static_cast<int>(f);
+				mesh->addTriangleNormalIndexes(index, index, index);
+			}
 		}
+
+		if (collapsedCount != 0)
+		{
+			ccLog::Print(QString("[STL] %1 degenerate facet(s) removed").arg(collapsedCount));
+		}
+	}
+
+	if (!payloadBuffer.empty())
+	{
+		payloadBuffer.clear();
+		payloadBuffer.shrink_to_fit();
+	}
+	else
+	{
+		fp.unmap(reinterpret_cast<uchar*>(const_cast<char*>(payload)));
 	}
 
 	if (pDlg)
@@ -0,0 +1,257 @@
+#include "TestObjFilter.h"
+
+#include "ObjFilter.h"
+#include "ccHObject.h"
+#include "ccHObjectCaster.h"
+#include "ccMesh.h"
+#include "ccPointCloud.h"
+#include "ccPolyline.h"
+#include "ccSubMesh.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+static void SetDefaultLoadParameters(FileIOFilter::LoadParameters& params, CCVector3d& shift, bool& shiftEnabled)
+{
+	params.alwaysDisplayLoadDialog  = false;
+	params.shiftHandlingMode        = ccGlobalShiftManager::Mode::NO_DIALOG;
+	params._coordinatesShiftEnabled = &shiftEnabled;
+	params._coordinatesShift        = &shift;
+	params.preserveShiftOnSave      = true;
+}
+
+static CC_FILE_ERROR LoadObj(const QByteArray& content, ccHObject& container)
+{
+	QTemporaryDir tmpDir;
+	if (!tmpDir.isValid())
+		return CC_FERR_WRITING;
+
+	QString filePath = tmpDir.filePath("test.obj");
+	{
+		QFile file(filePath);
+		if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size())
+			return CC_FERR_WRITING;
+	}
+
+	CCVector3d shift(0, 0, 0);
+	bool       shiftEnabled = false;
+
+	FileIOFilter::LoadParameters params;
+	SetDefaultLoadParameters(params, shift, shiftEnabled);
+	ObjFilter filter;
+
+	return filter.loadFile(filePath, container, params);
+}
+
+static void CheckTriangle(ccMesh* mesh, unsigned triIndex, unsigned i1, unsigned i2, unsigned i3)
+{
+	QVERIFY(triIndex < mesh->size());
+	const CCCoreLib::VerticesIndexes* tri = mesh->getTriangleVertIndexes(triIndex);
+	QCOMPARE(tri->i1, i1);
+	QCOMPARE(tri->i2, i2);
+	QCOMPARE(tri->i3, i3);
+}
+
+void TestObjFilter::testTrianglesWithNormals() const
+{
+	// comments, blank lines, tabs, CRLF line endings and per-facet normals
+	QByteArray content = "# test file\r\n"
+	                     "\r\n"
+	                     "v 0 0 0\r\n"
+	                     "v\t1.5 0 0\r\n"
+	                     "v 0 2.5 0\r\n"
+	                     "v 1.5   2.5 -1\r\n"
+	                     "vn 0 0 1\r\n"
+	                     "f 1//1 2//1 3//1\r\n"
+	                     "f 2//1 4//1 3//1\r\n";
+
+	ccHObject container;
+	QVERIFY(LoadObj(content, container) == CC_FERR_NO_ERROR);
+	QCOMPARE(container.getChildrenNumber(), 1u);
+
+	ccMesh* mesh = ccHObjectCaster::ToMesh(container.getFirstChild());
+	QVERIFY(mesh);
+	ccGenericPointCloud* vertices = mesh->getAssociatedCloud();
+	QVERIFY(vertices);
+	QCOMPARE(vertices->size(), 4u);
+	QCOMPARE(mesh->size(), 2u);
+
+	const CCVector3* P = vertices->getPoint(3);
+	QCOMPARE(P->x, static_cast<PointCoordinateType>(1.5));
+	QCOMPARE(P->y, static_cast<PointCoordinateType>(2.5));
+	QCOMPARE(P->z, static_cast<PointCoordinateType>(-1));
+
+	CheckTriangle(mesh, 0, 0, 1, 2);
+	CheckTriangle(mesh, 1, 1, 3, 2);
+
+	QVERIFY(mesh->hasTriNormals());
+	int n1 = -1;
+	int n2 = -1;
+	int n3 = -1;
+	mesh->getTriangleNormalIndexes(1, n1, n2, n3);
+	QCOMPARE(n1, 0);
+	QCOMPARE(n2, 0);
+	QCOMPARE(n3, 0);
+}
+
+void TestObjFilter::testPolygonFan() const
+{
+	// quads are split as a fan
+	QByteArray content = "v 0 0 0\n"
+	                     "v 1 0 0\n"
+	                     "v 1 1 0\n"
+	                     "v 0 1 0\n"
+	                     "f 1 2 3 4\n";
+
+	ccHObject container;
+	QVERIFY(LoadObj(content, container) == CC_FERR_NO_ERROR);
+
+	ccMesh* mesh = ccHObjectCaster::ToMesh(container.getFirstChild());
+	QVERIFY(mesh);
+	QCOMPARE(mesh->size(), 2u);
+	CheckTriangle(mesh, 0, 0, 1, 2);
+	CheckTriangle(mesh, 1, 0, 2, 3);
+}
+
+void TestObjFilter::testGroupsAndRelativeIndexes() const
+{
+	// negative indexes are relative to the vertices read so far
+	QByteArray content = "g first\n"
+	                     "v 0 0 0\n"
+	                     "v 1 0 0\n"
+	                     "v 0 1 0\n"
+	                     "f -3 -2 -1\n"
+	                     "g second\n"
+	                     "v 1 1 0\n"
+	                     "f -3 -1 -2\n"
+	                     "f 1 2 4\n";
+
+	ccHObject container;
+	QVERIFY(LoadObj(content, container) == CC_FERR_NO_ERROR);
+
+	ccMesh* mesh = ccHObjectCaster::ToMesh(container.getFirstChild());
+	QVERIFY(mesh);
+	QCOMPARE(mesh->getAssociatedCloud()->size(), 4u);
+	QCOMPARE(mesh->size(), 3u);
+	CheckTriangle(mesh, 0, 0, 1, 2);
+	CheckTriangle(mesh, 1, 1, 3, 2);
+	CheckTriangle(mesh, 2, 0, 1, 3);
+
+	// one sub-mesh per group
+	ccHObject::Container subMeshes;
+	mesh->filterChildren(subMeshes, false, CC_TYPES::SUB_MESH);
+	QCOMPARE(subMeshes.size(), static_cast<size_t>(2));
+	QCOMPARE(subMeshes[0]->getName(), QString("first"));
+	QCOMPARE(static_cast<ccSubMesh*>(subMeshes[0])->size(), 1u);
+	QCOMPARE(subMeshes[1]->getName(), QString("second"));
+	QCOMPARE(static_cast<ccSubMesh*>(subMeshes[1])->size(), 2u);
+}
+
+void TestObjFilter::testPolylines() const
+{
+	QByteArray content = "v 0 0 0\n"
+	                     "v 1 0 0\n"
+	                     "v 1 1 0\n"
+	                     "l 1 2 3\n"
+	                     "l -1 -3\n";
+
+	ccHObject container;
+	QVERIFY(LoadObj(content, container) == CC_FERR_NO_ERROR);
+
+	// no mesh: the vertices are the root entity
+	ccPointCloud* vertices = ccHObjectCaster::ToPointCloud(container.getFirstChild());
+	QVERIFY(vertices);
+	QCOMPARE(vertices->size(), 3u);
+	QCOMPARE(vertices->getChildrenNumber(), 2u);
+
+	ccPolyline* poly1 = ccHObjectCaster::ToPolyline(vertices->getChild(0));
+	QVERIFY(poly1);
+	QCOMPARE(poly1->size(), 3u);
+	QCOMPARE(poly1->getPointGlobalIndex(2), 2u);
+
+	ccPolyline* poly2 = ccHObjectCaster::ToPolyline(vertices->getChild(1));
+	QVERIFY(poly2);
+	QCOMPARE(poly2->size(), 2u);
+	QCOMPARE(poly2->getPointGlobalIndex(0), 2u);
+	QCOMPARE(poly2->getPointGlobalIndex(1), 0u);
+}
+
+void TestObjFilter::testInvalidIndex() const
+{
+	QByteArray content = "v 0 0 0\n"
+	                     "v 1 0 0\n"
+	                     "v 1 1 0\n"
+	                     "f 1 2 5\n";
+
+	ccHObject container;
+	QVERIFY(LoadObj(content, container) != CC_FERR_NO_ERROR);
+}
+
+void TestObjFilter::testMultipleBlocks() const
+{
+	// regular grid, with relative indexes (written interleaved with the vertices)
+	static const unsigned n = 400;
+
+	QByteArray content;
+	content.reserve(16 << 20);
+	for (unsigned i = 0; i <= n; ++i)
+	{
+		content += QByteArray("v ") + QByteArray::number(i) + " 0 0\n";
+	}
+	for (unsigned j = 1; j <= n; ++j)
+	{
+		// new row of vertices
+		for (unsigned i = 0; i <= n; ++i)
+		{
+			content += QByteArray("v ") + QByteArray::number(i) + ' ' + QByteArray::number(j) + " 0.25\n";
+		}
+		// faces between the previous row and the new one
+		const int rowSize = static_cast<int>(n + 1);
+		for (unsigned i = 0; i < n; ++i)
+		{
+			int a = -2 * rowSize + static_cast<int>(i); // previous row
+			int b = a + 1;
+			int d = a + rowSize; // current row
+			int c = d + 1;
+			content += QByteArray("f ") + QByteArray::number(a) + ' ' + QByteArray::number(b) + ' ' + QByteArray::number(c) + '\n';
+			content += QByteArray("f ") + QByteArray::number(a) + ' ' + QByteArray::number(c) + ' ' + QByteArray::number(d) + '\n';
+		}
+	}
+	QVERIFY(content.size() > (8 << 20)); // several blocks
+
+	ccHObject container;
+	QVERIFY(LoadObj(content, container) == CC_FERR_NO_ERROR);
+
+	ccMesh* mesh = ccHObjectCaster::ToMesh(container.getFirstChild());
+	QVERIFY(mesh);
+	ccGenericPointCloud* vertices = mesh->getAssociatedCloud();
+	QCOMPARE(vertices->size(), (n + 1) * (n + 1));
+	QCOMPARE(mesh->size(), 2 * n * n);
+
+	for (unsigned j = 0; j <= n; ++j)
+	{
+		for (unsigned i = 0; i <= n; ++i)
+		{
+			const CCVector3* P = vertices->getPoint(j * (n + 1) + i);
+			QCOMPARE(P->x, static_cast<PointCoordinateType>(i));
+			QCOMPARE(P->y, static_cast<PointCoordinateType>(j));
+			QCOMPARE(P->z, static_cast<PointCoordinateType>(j == 0 ? 0 : 0.25));
+		}
+	}
+
+	for (unsigned j = 0; j < n; ++j)
+	{
+		for (unsigned i = 0; i < n; ++i)
+		{
+			unsigned a = j * (n + 1) + i;
+			unsigned b = a + 1;
+			unsigned d = a + (n + 1);
+			unsigned c = d + 1;
+			unsigned t = 2 * (j * n + i);
+			CheckTriangle(mesh, t, a, b, c);
+			CheckTriangle(mesh, t + 1, a, c, d);
+		}
+	}
+}
+
+QTEST_MAIN(TestObjFilter)
@@ -0,0 +1,25 @@
+#ifndef CC_TEST_OBJ_FILTER_HEADER
+#define CC_TEST_OBJ_FILTER_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestObjFilter : public QObject
+{
+	Q_OBJECT
+  private Q_SLOTS:
+	void testTrianglesWithNormals() const;
+
+	void testPolygonFan() const;
+
+	void testGroupsAndRelativeIndexes() const;
+
+	void testPolylines() const;
+
+	void testInvalidIndex() const;
+
+	//! File larger than a parsing block (the blocks are parsed concurrently)
+	void testMultipleBlocks() const;
+};
+
+#endif // CC_TEST_OBJ_FILTER_HEADER
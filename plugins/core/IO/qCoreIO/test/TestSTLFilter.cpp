@@ -0,0 +1,237 @@
+#include "TestSTLFilter.h"
+
+#include "STLFilter.h"
+#include "ccHObject.h"
+#include "ccMesh.h"
+#include "ccPointCloud.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using Facet = std::array<CCVector3, 3>;
+
+static void SetDefaultLoadParameters(FileIOFilter::LoadParameters& params, CCVector3d& shift, bool& shiftEnabled)
+{
+	params.alwaysDisplayLoadDialog  = false;
+	params.shiftHandlingMode        = ccGlobalShiftManager::Mode::NO_DIALOG;
+	params._coordinatesShiftEnabled = &shiftEnabled;
+	params._coordinatesShift        = &shift;
+	params.preserveShiftOnSave      = true;
+}
+
+static bool SamePoint(const CCVector3& A, const CCVector3& B)
+{
+	return A.x == B.x && A.y == B.y && A.z == B.z;
+}
+
+static bool WriteBinarySTL(const QString& filePath, const std::vector<Facet>& facets)
+{
+	QFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	char header[80] = {0};
+	memcpy(header, "binary test file", 16);
+	file.write(header, 80);
+
+	uint32_t count = static_cast<uint32_t>(facets.size());
+	file.write(reinterpret_cast<const char*>(&count), 4);
+
+	for (const Facet& facet : facets)
+	{
+		CCVector3 N = (facet[1] - facet[0]).cross(facet[2] - facet[0]);
+		N.normalize();
+		float record[12] = {static_cast<float>(N.x), static_cast<float>(N.y), static_cast<float>(N.z)};
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			record[3 + 3 * k]     = static_cast<float>(facet[k].x);
+			record[3 + 3 * k + 1] = static_cast<float>(facet[k].y);
+			record[3 + 3 * k + 2] = static_cast<float>(facet[k].z);
+		}
+		file.write(reinterpret_cast<const char*>(record), 48);
+		uint16_t attributes = 0;
+		file.write(reinterpret_cast<const char*>(&attributes), 2);
+	}
+
+	return file.error() == QFile::NoError;
+}
+
+static ccMesh* LoadMesh(const QString& filePath, ccHObject& container)
+{
+	CCVector3d shift(0, 0, 0);
+	bool       shiftEnabled = false;
+
+	FileIOFilter::LoadParameters params;
+	SetDefaultLoadParameters(params, shift, shiftEnabled);
+	STLFilter filter;
+
+	CC_FILE_ERROR error = filter.loadFile(filePath, container, params);
+	if (error != CC_FERR_NO_ERROR || container.getChildrenNumber() != 1 || !container.getFirstChild()->isA(CC_TYPES::MESH))
+	{
+		return nullptr;
+	}
+
+	return static_cast<ccMesh*>(container.getFirstChild());
+}
+
+//! Checks that each loaded triangle has the same corners as the corresponding (non degenerate) input facet
+static void CheckTriangles(ccMesh* mesh, const std::vector<Facet>& facets)
+{
+	ccGenericPointCloud* vertices = mesh->getAssociatedCloud();
+	QVERIFY(vertices);
+
+	unsigned triIndex = 0;
+	for (const Facet& facet : facets)
+	{
+		if (SamePoint(facet[0], facet[1]) || SamePoint(facet[0], facet[2]) || SamePoint(facet[1], facet[2]))
+		{
+			continue;
+		}
+		QVERIFY(triIndex < mesh->size());
+
+		const CCCoreLib::VerticesIndexes* tri = mesh->getTriangleVertIndexes(triIndex++);
+		for (unsigned k = 0; k < 3; ++k)
+		{
+			QVERIFY(tri->i[k] < vertices->size());
+			QVERIFY(SamePoint(*vertices->getPoint(tri->i[k]), facet[k]));
+		}
+	}
+	QCOMPARE(mesh->size(), triIndex);
+}
+
+//! Checks that the vertices are all different (i.e. properly welded)
+static void CheckUniqueVertices(ccGenericPointCloud* vertices)
+{
+	std::set<std::tuple<PointCoordinateType, PointCoordinateType, PointCoordinateType>> uniquePoints;
+	for (unsigned i = 0; i < vertices->size(); ++i)
+	{
+		const CCVector3* P = vertices->getPoint(i);
+		QVERIFY(uniquePoints.emplace(P->x, P->y, P->z).second);
+	}
+}
+
+void TestSTLFilter::testBinaryCubeWelding() const
+{
+	const CCVector3 C[8] = {CCVector3(0, 0, 0),
+	                        CCVector3(1, 0, 0),
+	                        CCVector3(1, 1, 0),
+	                        CCVector3(0, 1, 0),
+	                        CCVector3(0, 0, 1),
+	                        CCVector3(1, 0, 1),
+	                        CCVector3(1, 1, 1),
+	                        CCVector3(0, 1, 1)};
+	const unsigned T[12][3] = {{0, 2, 1}, {0, 3, 2}, {4, 5, 6}, {4, 6, 7}, {0, 1, 5}, {0, 5, 4}, {1, 2, 6}, {1, 6, 5}, {2, 3, 7}, {2, 7, 6}, {3, 0, 4}, {3, 4, 7}};
+
+	std::vector<Facet> facets;
+	for (const auto& t : T)
+	{
+		facets.push_back(Facet{C[t[0]], C[t[1]], C[t[2]]});
+	}
+
+	QTemporaryDir tmpDir;
+	QVERIFY(tmpDir.isValid());
+	QString filePath = tmpDir.filePath("cube.stl");
+	QVERIFY(WriteBinarySTL(filePath, facets));
+
+	ccHObject container;
+	ccMesh*   mesh = LoadMesh(filePath, container);
+	QVERIFY(mesh);
+	QCOMPARE(mesh->getAssociatedCloud()->size(), 8u);
+	QCOMPARE(mesh->size(), 12u);
+	CheckTriangles(mesh, facets);
+	CheckUniqueVertices(mesh->getAssociatedCloud());
+}
+
+void TestSTLFilter::testBinaryGridWelding() const
+{
+	// regular grid (large enough to be dispatched in all the shards)
+	static const unsigned n = 200;
+
+	std::vector<Facet> facets;
+	facets.reserve(2 * n * n);
+	for (unsigned j = 0; j < n; ++j)
+	{
+		for (unsigned i = 0; i < n; ++i)
+		{
+			CCVector3 A(static_cast<PointCoordinateType>(i), static_cast<PointCoordinateType>(j), 0);
+			CCVector3 B(static_cast<PointCoordinateType>(i + 1), static_cast<PointCoordinateType>(j), 0);
+			CCVector3 C(static_cast<PointCoordinateType>(i + 1), static_cast<PointCoordinateType>(j + 1), 0);
+			CCVector3 D(static_cast<PointCoordinateType>(i), static_cast<PointCoordinateType>(j + 1), 0);
+			facets.push_back(Facet{A, B, C});
+			facets.push_back(Facet{A, C, D});
+		}
+	}
+
+	QTemporaryDir tmpDir;
+	QVERIFY(tmpDir.isValid());
+	QString filePath = tmpDir.filePath("grid.stl");
+	QVERIFY(WriteBinarySTL(filePath, facets));
+
+	ccHObject container;
+	ccMesh*   mesh = LoadMesh(filePath, container);
+	QVERIFY(mesh);
+	QCOMPARE(mesh->getAssociatedCloud()->size(), (n + 1) * (n + 1));
+	QCOMPARE(mesh->size(), 2 * n * n);
+	CheckTriangles(mesh, facets);
+	CheckUniqueVertices(mesh->getAssociatedCloud());
+
+	// the vertices are created in order of first appearance
+	QVERIFY(SamePoint(*mesh->getAssociatedCloud()->getPoint(0), facets[0][0]));
+	QVERIFY(SamePoint(*mesh->getAssociatedCloud()->getPoint(1), facets[0][1]));
+	QVERIFY(SamePoint(*mesh->getAssociatedCloud()->getPoint(2), facets[0][2]));
+	QVERIFY(SamePoint(*mesh->getAssociatedCloud()->getPoint(3), facets[1][2]));
+}
+
+void TestSTLFilter::testBinaryDegenerateFacets() const
+{
+	const CCVector3 A(0, 0, 0);
+	const CCVector3 B(1, 0, 0);
+	const CCVector3 C(0, 1, 0);
+	const CCVector3 D(1, 1, 0);
+
+	std::vector<Facet> facets{Facet{A, B, C}, Facet{B, B, C}, Facet{B, D, C}, Facet{A, A, A}};
+
+	QTemporaryDir tmpDir;
+	QVERIFY(tmpDir.isValid());
+	QString filePath = tmpDir.filePath("degenerate.stl");
+	QVERIFY(WriteBinarySTL(filePath, facets));
+
+	ccHObject container;
+	ccMesh*   mesh = LoadMesh(filePath, container);
+	QVERIFY(mesh);
+	QCOMPARE(mesh->getAssociatedCloud()->size(), 4u);
+	QCOMPARE(mesh->size(), 2u);
+	CheckTriangles(mesh, facets);
+}
+
+void TestSTLFilter::testBinaryExactWelding() const
+{
+	// vertices are only welded if they have exactly the same coordinates
+	const CCVector3 A(1.0f, 0, 0);
+	const CCVector3 A2(std::nextafter(1.0f, 2.0f), 0, 0);
+	const CCVector3 B(2, 0, 0);
+	const CCVector3 C(1, 1, 0);
+
+	std::vector<Facet> facets{Facet{A, B, C}, Facet{A2, C, B}};
+
+	QTemporaryDir tmpDir;
+	QVERIFY(tmpDir.isValid());
+	QString filePath = tmpDir.filePath("exact.stl");
+	QVERIFY(WriteBinarySTL(filePath, facets));
+
+	ccHObject container;
+	ccMesh*   mesh = LoadMesh(filePath, container);
+	QVERIFY(mesh);
+	QCOMPARE(mesh->getAssociatedCloud()->size(), 4u);
+	QCOMPARE(mesh->size(), 2u);
+	CheckTriangles(mesh, facets);
+}
+
+QTEST_MAIN(TestSTLFilter)
@@ -0,0 +1,21 @@
+#ifndef CC_TEST_STL_FILTER_HEADER
+#define CC_TEST_STL_FILTER_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestSTLFilter : public QObject
+{
+	Q_OBJECT
+  private Q_SLOTS:
+	/* Binary files (vertices welded while loading) */
+	void testBinaryCubeWelding() const;
+
+	void testBinaryGridWelding() const;
+
+	void testBinaryDegenerateFacets() const;
+
+	void testBinaryExactWelding() const;
+};
+
+#endif // CC_TEST_STL_FILTER_HEADER
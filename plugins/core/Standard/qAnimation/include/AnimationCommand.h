@@ -0,0 +1,39 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#      COPYRIGHT: Daniel Girardeau-Montaut, CloudCompare project         #
+//#                                                                        #
+//##########################################################################
+
+//CloudCompare
+#include "ccCommandLineInterface.h"
+
+//! Headless animation rendering (command line)
+/** Syntax: -ANIMATION -VIEWPORTS {file} [options] -OUTPUT {filename}
+	The viewports (at least 2) are read from a file (typically a BIN file saved
+	from the GUI). The loaded clouds and meshes, as well as the other entities of
+	the viewports file, are rendered in an offscreen 3D view (e.g. on render nodes
+	without display, with the 'offscreen' Qt platform).
+**/
+class AnimationCommand : public ccCommandLineInterface::Command
+{
+public:
+
+	AnimationCommand();
+
+	~AnimationCommand() override = default;
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#      COPYRIGHT: Daniel Girardeau-Montaut, CloudCompare project         #
+//#                                                                        #
+//##########################################################################
+
+//Local
+#include "ExtendedViewport.h"
+
+//Qt
+#include <QString>
+
+//System
+#include <vector>
+
+class ccGLWindowInterface;
+class QProgressDialog;
+
+//! Animation renderer (shared by the dialog and the command line)
+/** The frames are rendered (and read back) by the calling thread, which must
+	be the one of the 3D view (GL) context. The frames are then handed over to a
+	bounded queue: worker threads take care of the (super resolution) downscaling,
+	of the images writing and of the video encoding (in the frames order). Hence,
+	the rendering of the next frames overlaps with the processing of the previous ones.
+**/
+class AnimationRenderer
+{
+public:
+
+	//! Key frame (viewport + duration of the transition to the next key frame)
+	struct KeyFrame
+	{
+		ExtendedViewportParameters viewport;
+		double duration_sec = 0.0;
+	};
+
+	//! Rendering parameters
+	struct Parameters
+	{
+		//! Output filename (video file or any file in the output directory for separate frames)
+		QString outputFilename;
+		//! Whether to save the frames as separate images (PNG) or as a video file
+		bool asSeparateFrames = false;
+		//! Video format (short name - empty = automatic)
+		QString outputFormat;
+		//! Frame rate
+		int fps = 25;
+		//! Video bitrate (in kbps)
+		int bitrate_kbps = 10000;
+		//! Super resolution factor
+		int superResolution = 1;
+		//! Whether the video itself has the super resolution size (zoom mode) or if the frames are downscaled
+		bool zoomMode = false;
+		//! Max number of worker threads (0 = all available cores but one)
+		int maxThreadCount = 0;
+		//! Max number of frames waiting to be processed (0 = automatic)
+		int maxQueuedFrames = 0;
+	};
+
+	//! Interpolates the viewports of all the frames of an animation
+	/** \param keyFrames key frames
+		\param loop whether the animation loops (i.e. goes back to the first key frame)
+		\param fps frame rate
+		\param[out] frames viewports of all the frames
+		\return success
+	**/
+	static bool InterpolateFrames(	const std::vector<KeyFrame>& keyFrames,
+									bool loop,
+									int fps,
+									std::vector<ExtendedViewportParameters>& frames);
+
+	//! Renders the frames of an animation
+	/** \param view3d 3D view (its viewport parameters are modified)
+		\param frames viewports of all the frames
+		\param params rendering parameters
+		\param[out] errorMessage error message (if any)
+		\param progressDialog optional progress dialog
+		\return success
+	**/
+	static bool Render(	ccGLWindowInterface* view3d,
+						const std::vector<ExtendedViewportParameters>& frames,
+						const Parameters& params,
+						QString& errorMessage,
+						QProgressDialog* progressDialog = nullptr);
+};
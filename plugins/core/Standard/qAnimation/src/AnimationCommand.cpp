@@ -0,0 +1,315 @@
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#      COPYRIGHT: Daniel Girardeau-Montaut, CloudCompare project         #
+//#                                                                        #
+//##########################################################################
+
+#include "AnimationCommand.h"
+
+//Local
+#include "AnimationRenderer.h"
+#include "ExtendedViewport.h"
+
+//qCC_db
+#include <cc2DViewportObject.h>
+#include <ccProgressDialog.h>
+
+//qCC_io
+#include <FileIOFilter.h>
+
+//qCC_gl
+#include <ccGLWindowInterface.h>
+
+//Qt
+#include <QApplication>
+#include <QScopedPointer>
+#include <QWidget>
+
+constexpr char COMMAND_ANIMATION[] = "ANIMATION";
+constexpr char COMMAND_ANIMATION_VIEWPORTS[] = "VIEWPORTS";
+constexpr char COMMAND_ANIMATION_OUTPUT[] = "OUTPUT";
+constexpr char COMMAND_ANIMATION_FPS[] = "FPS";
+constexpr char COMMAND_ANIMATION_STEP_DURATION[] = "STEP_DURATION";
+constexpr char COMMAND_ANIMATION_LOOP[] = "LOOP";
+constexpr char COMMAND_ANIMATION_WIDTH[] = "WIDTH";
+constexpr char COMMAND_ANIMATION_HEIGHT[] = "HEIGHT";
+constexpr char COMMAND_ANIMATION_SUPER_RES[] = "SUPER_RES";
+constexpr char COMMAND_ANIMATION_ZOOM[] = "ZOOM";
+constexpr char COMMAND_ANIMATION_FRAMES[] = "FRAMES";
+constexpr char COMMAND_ANIMATION_FORMAT[] = "FORMAT";
+constexpr char COMMAND_ANIMATION_BITRATE[] = "BITRATE";
+constexpr char COMMAND_ANIMATION_MAX_THREAD_COUNT[] = "MAX_THREAD_COUNT";
+constexpr char COMMAND_ANIMATION_QUEUE_SIZE[] = "QUEUE_SIZE";
+
+//reads a (strictly positive) integer value after an option
+static bool ReadPositiveInt(ccCommandLineInterface& cmd, const char* option, int& value)
+{
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: value after \"-%1\"").arg(option));
+	}
+	bool ok = false;
+	value = cmd.arguments().takeFirst().toInt(&ok);
+	if (!ok || value <= 0)
+	{
+		return cmd.error(QObject::tr("Invalid value after \"-%1\" (strictly positive integer expected)").arg(option));
+	}
+	return true;
+}
+
+AnimationCommand::AnimationCommand()
+	: Command("Animation", COMMAND_ANIMATION)
+{
+}
+
+bool AnimationCommand::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[ANIMATION]");
+
+	QString viewportsFilename;
+	int width = 1920;
+	int height = 1080;
+	double stepDuration_sec = 2.0;
+	bool loop = false;
+	AnimationRenderer::Parameters params;
+
+	//look for local options
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_VIEWPORTS))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: filename after \"-%1\"").arg(COMMAND_ANIMATION_VIEWPORTS));
+			}
+			viewportsFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_OUTPUT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: filename after \"-%1\"").arg(COMMAND_ANIMATION_OUTPUT));
+			}
+			params.outputFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_FPS))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_FPS, params.fps))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_STEP_DURATION))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: duration after \"-%1\"").arg(COMMAND_ANIMATION_STEP_DURATION));
+			}
+			bool ok = false;
+			stepDuration_sec = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || stepDuration_sec <= 0.0)
+			{
+				return cmd.error(QObject::tr("Invalid step duration"));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_LOOP))
+		{
+			cmd.arguments().pop_front();
+			loop = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_WIDTH))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_WIDTH, width))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_HEIGHT))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_HEIGHT, height))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_SUPER_RES))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_SUPER_RES, params.superResolution))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_ZOOM))
+		{
+			cmd.arguments().pop_front();
+			params.zoomMode = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_FRAMES))
+		{
+			cmd.arguments().pop_front();
+			params.asSeparateFrames = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_FORMAT))
+		{
+			cmd.arguments().pop_front();
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: format short name after \"-%1\"").arg(COMMAND_ANIMATION_FORMAT));
+			}
+			params.outputFormat = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_BITRATE))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_BITRATE, params.bitrate_kbps))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_MAX_THREAD_COUNT))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_MAX_THREAD_COUNT, params.maxThreadCount))
+			{
+				return false;
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ANIMATION_QUEUE_SIZE))
+		{
+			cmd.arguments().pop_front();
+			if (!ReadPositiveInt(cmd, COMMAND_ANIMATION_QUEUE_SIZE, params.maxQueuedFrames))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (viewportsFilename.isEmpty())
+	{
+		return cmd.error(QObject::tr("Missing viewports file (use \"-%1 {file}\")").arg(COMMAND_ANIMATION_VIEWPORTS));
+	}
+	if (params.outputFilename.isEmpty())
+	{
+		return cmd.error(QObject::tr("Missing output filename (use \"-%1 {filename}\")").arg(COMMAND_ANIMATION_OUTPUT));
+	}
+
+	//load the viewports
+	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+	QScopedPointer<ccHObject> viewportsFile(FileIOFilter::LoadFromFile(viewportsFilename, cmd.fileLoadingParams(), result));
+	if (!viewportsFile || result != CC_FERR_NO_ERROR)
+	{
+		return cmd.error(QObject::tr("Failed to load the viewports file '%1'").arg(viewportsFilename));
+	}
+
+	std::vector<AnimationRenderer::KeyFrame> keyFrames;
+	{
+		ccHObject::Container viewports;
+		viewportsFile->filterChildren(viewports, true, CC_TYPES::VIEWPORT_2D_OBJECT, true);
+		for (ccHObject* object : viewports)
+		{
+			AnimationRenderer::KeyFrame keyFrame;
+			keyFrame.viewport = ExtendedViewport(static_cast<cc2DViewportObject*>(object)).toExtendedViewportParameters();
+			keyFrame.duration_sec = stepDuration_sec;
+			keyFrames.push_back(keyFrame);
+		}
+	}
+	if (keyFrames.size() < 2)
+	{
+		return cmd.error(QObject::tr("At least 2 viewports are required (%1 found in '%2')").arg(static_cast<qulonglong>(keyFrames.size())).arg(viewportsFilename));
+	}
+	cmd.print(QObject::tr("Viewports: %1").arg(static_cast<qulonglong>(keyFrames.size())));
+
+	std::vector<ExtendedViewportParameters> frames;
+	if (!AnimationRenderer::InterpolateFrames(keyFrames, loop, params.fps, frames))
+	{
+		return cmd.error(QObject::tr("Not enough memory"));
+	}
+	cmd.print(QObject::tr("Frames: %1 (%2 x %3)").arg(static_cast<qulonglong>(frames.size())).arg(width).arg(height));
+
+	//offscreen 3D view
+	ccGLWindowInterface* glWindow = nullptr;
+	QWidget* glWidget = nullptr;
+	ccGLWindowInterface::Create(glWindow, glWidget, false, true);
+	if (!glWindow || !glWidget)
+	{
+		return cmd.error(QObject::tr("Failed to create the 3D view"));
+	}
+	glWidget->setAttribute(Qt::WA_DontShowOnScreen);
+	glWidget->resize(width, height);
+	glWidget->show();
+	QApplication::processEvents(); //to initialize the OpenGL context
+
+	//the scene
+	std::vector<ccHObject*> sceneEntities;
+	for (CLCloudDesc& desc : cmd.clouds())
+	{
+		sceneEntities.push_back(desc.getEntity());
+	}
+	for (CLMeshDesc& desc : cmd.meshes())
+	{
+		sceneEntities.push_back(desc.getEntity());
+	}
+	sceneEntities.push_back(viewportsFile.data());
+	for (ccHObject* entity : sceneEntities)
+	{
+		glWindow->addToOwnDB(entity, true);
+	}
+
+	ccProgressDialog* progressDialog = cmd.progressDialog();
+	if (progressDialog)
+	{
+		progressDialog->setRange(0, static_cast<int>(frames.size()));
+		progressDialog->setLabelText(QObject::tr("Frames: %1").arg(static_cast<qulonglong>(frames.size())));
+		progressDialog->show();
+		QApplication::processEvents();
+	}
+
+	QString errorMessage;
+	bool success = AnimationRenderer::Render(glWindow, frames, params, errorMessage, progressDialog);
+
+	if (progressDialog)
+	{
+		progressDialog->hide();
+	}
+
+	for (ccHObject* entity : sceneEntities)
+	{
+		glWindow->removeFromOwnDB(entity);
+		entity->setDisplay_recursive(nullptr);
+	}
+	delete glWidget;
+	glWidget = nullptr;
+	glWindow = nullptr;
+
+	if (!success)
+	{
+		return cmd.error(errorMessage);
+	}
+
+	cmd.print(QObject::tr("Animation saved: %1").arg(params.outputFilename));
+
+	return true;
+}
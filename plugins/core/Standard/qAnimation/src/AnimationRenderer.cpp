@@ -0,0 +1,497 @@
+//##########################################################################
+//#                                                                        #
+//#                   CLOUDCOMPARE PLUGIN: qAnimation                      #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#      COPYRIGHT: Daniel Girardeau-Montaut, CloudCompare project         #
+//#                                                                        #
+//##########################################################################
+
+#include "AnimationRenderer.h"
+
+//Local
+#include "ViewInterpolate.h"
+
+//qCC_db
+#include <ccLog.h>
+
+//qCC_gl
+#include <ccGLWindowInterface.h>
+
+//Qt
+#include <QApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QProgressDialog>
+#include <QScopedPointer>
+
+#ifdef QFFMPEG_SUPPORT
+//QTFFMpeg
+#include <QVideoEncoder.h>
+#else
+class QVideoEncoder;
+#endif
+
+//System
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+//! Bounded frame queue processed by worker threads
+/** Each frame is downscaled (if necessary) then either saved as a PNG image
+	or encoded in the video stream. As the encoder requires the frames to be
+	sent in order, the converted frames are buffered until their turn comes
+	(and encoded by one worker at a time).
+**/
+class FramePipeline
+{
+public:
+
+	FramePipeline(	const AnimationRenderer::Parameters& params,
+					const QDir& outputDir,
+					QVideoEncoder* encoder)
+		: m_params(params)
+		, m_outputDir(outputDir)
+		, m_encoder(encoder)
+		, m_capacity(0)
+		, m_pendingCount(0)
+		, m_completedCount(0)
+		, m_nextFrameToEncode(0)
+		, m_encoderBusy(false)
+		, m_finished(false)
+		, m_failed(false)
+	{
+		int threadCount = params.maxThreadCount;
+		if (threadCount <= 0)
+		{
+			//the calling thread is busy rendering
+			threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+		}
+
+		m_capacity = (params.maxQueuedFrames > 0 ? params.maxQueuedFrames : 2 * threadCount);
+
+		for (int i = 0; i < threadCount; ++i)
+		{
+			m_workers.emplace_back(&FramePipeline::process, this);
+		}
+	}
+
+	~FramePipeline()
+	{
+		finish();
+	}
+
+	//! Adds a frame to the queue (waits if the queue is full)
+	/** \return false if an error occurred (the frame is not queued then)
+	**/
+	bool push(QImage&& image, int frameIndex)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_frameDone.wait(lock, [this] { return m_pendingCount < m_capacity || m_failed; });
+		if (m_failed)
+		{
+			return false;
+		}
+
+		m_queue.emplace_back(frameIndex, std::move(image));
+		++m_pendingCount;
+		m_frameQueued.notify_one();
+
+		return true;
+	}
+
+	//! Cancels the remaining frames
+	void cancel()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		fail("Process has been cancelled");
+	}
+
+	//! Waits for all the queued frames to be processed
+	/** \return success
+	**/
+	bool finish()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finished = true;
+		}
+		m_frameQueued.notify_all();
+
+		for (std::thread& worker : m_workers)
+		{
+			worker.join();
+		}
+		m_workers.clear();
+
+		return !m_failed;
+	}
+
+	//! Returns the (first) error message
+	QString errorMessage()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_errorMessage;
+	}
+
+protected:
+
+	//! Frame (index + image)
+	typedef std::pair<int, QImage> Frame;
+
+	//! Records an error (the mutex must be locked)
+	void fail(const QString& errorMessage)
+	{
+		if (!m_failed)
+		{
+			m_failed = true;
+			m_errorMessage = errorMessage;
+		}
+		//the remaining frames are dropped
+		m_queue.clear();
+		m_frameDone.notify_all();
+	}
+
+	//! Worker thread main loop
+	void process()
+	{
+		while (true)
+		{
+			Frame frame;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_frameQueued.wait(lock, [this] { return !m_queue.empty() || m_finished || m_failed; });
+				if (m_queue.empty())
+				{
+					return;
+				}
+				frame = std::move(m_queue.front());
+				m_queue.pop_front();
+			}
+
+			//color conversion (super resolution downscaling)
+			if (!m_params.zoomMode && m_params.superResolution > 1)
+			{
+				frame.second = frame.second.scaled(	frame.second.width() / m_params.superResolution,
+													frame.second.height() / m_params.superResolution,
+													Qt::IgnoreAspectRatio,
+													Qt::SmoothTransformation);
+			}
+
+			if (m_params.asSeparateFrames)
+			{
+				QString filename = QString("frame_%1.png").arg(frame.first, 6, 10, QChar('0'));
+				bool saved = frame.second.save(m_outputDir.filePath(filename));
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!saved)
+				{
+					fail(QString("Failed to save frame #%1").arg(frame.first + 1));
+					return;
+				}
+				++m_completedCount;
+				--m_pendingCount;
+				m_frameDone.notify_all();
+			}
+			else
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_convertedFrames[frame.first] = std::move(frame.second);
+				if (m_encoderBusy)
+				{
+					//another worker is already encoding (it will take care of this frame)
+					continue;
+				}
+
+				//encode all the frames that are ready (in order)
+				m_encoderBusy = true;
+				while (!m_failed && !m_convertedFrames.empty() && m_convertedFrames.begin()->first == m_nextFrameToEncode)
+				{
+					int frameIndex = m_convertedFrames.begin()->first;
+					QImage image = std::move(m_convertedFrames.begin()->second);
+					m_convertedFrames.erase(m_convertedFrames.begin());
+					lock.unlock();
+
+					QString errorString;
+					bool encoded = encodeImage(image, frameIndex, errorString);
+
+					lock.lock();
+					if (!encoded)
+					{
+						fail(QString("Failed to encode frame #%1: %2").arg(frameIndex + 1).arg(errorString));
+						break;
+					}
+					++m_nextFrameToEncode;
+					++m_completedCount;
+					--m_pendingCount;
+					m_frameDone.notify_all();
+				}
+				m_encoderBusy = false;
+			}
+		}
+	}
+
+	//! Encodes an image in the video stream
+	bool encodeImage(const QImage& image, int frameIndex, QString& errorString)
+	{
+#ifdef QFFMPEG_SUPPORT
+		if (m_encoder)
+		{
+			return m_encoder->encodeImage(image, frameIndex, &errorString);
+		}
+#endif
+		errorString = "no encoder";
+		return false;
+	}
+
+	const AnimationRenderer::Parameters& m_params;
+	QDir m_outputDir;
+	QVideoEncoder* m_encoder;
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	//! Signaled when a frame is added to the queue
+	std::condition_variable m_frameQueued;
+	//! Signaled when a frame has been processed (or if an error occurred)
+	std::condition_variable m_frameDone;
+
+	//! Frames waiting to be processed
+	std::deque<Frame> m_queue;
+	//! Converted frames waiting to be encoded
+	std::map<int, QImage> m_convertedFrames;
+	//! Max number of pending frames (queued, being processed or waiting to be encoded)
+	int m_capacity;
+	int m_pendingCount;
+	int m_completedCount;
+	int m_nextFrameToEncode;
+	bool m_encoderBusy;
+	bool m_finished;
+	bool m_failed;
+	QString m_errorMessage;
+};
+
+bool AnimationRenderer::InterpolateFrames(	const std::vector<KeyFrame>& keyFrames,
+											bool loop,
+											int fps,
+											std::vector<ExtendedViewportParameters>& frames)
+{
+	frames.clear();
+	if (keyFrames.size() < 2 || fps <= 0)
+	{
+		return false;
+	}
+
+	bool openPoly = !loop;
+	size_t segmentCount = keyFrames.size();
+	if (openPoly)
+	{
+		--segmentCount;
+	}
+
+	double totalTime = 0;
+	for (size_t i = 0; i < segmentCount; ++i)
+	{
+		totalTime += keyFrames[i].duration_sec;
+	}
+
+	//count the total number of frames
+	int frameCount = static_cast<int>(fps * totalTime);
+	try
+	{
+		frames.reserve(frameCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	double currentTime = 0.0;
+	double currentStepStartTime = 0.0;
+	double timeStep = 1.0 / fps;
+	size_t vp1Index = 0;
+	for (int frameIndex = 0; frameIndex < frameCount; )
+	{
+		size_t vp2Index = vp1Index + 1;
+		if (vp2Index == keyFrames.size())
+		{
+			assert(!openPoly);
+			vp2Index = 0;
+		}
+
+		const KeyFrame& step1 = keyFrames[vp1Index];
+		double deltaTime = currentTime - currentStepStartTime;
+		if (deltaTime <= step1.duration_sec)
+		{
+			const KeyFrame& step2 = keyFrames[vp2Index];
+			ViewInterpolate interpolator(step1.viewport, step2.viewport);
+
+			ExtendedViewportParameters currentViewport;
+			interpolator.interpolate(currentViewport, deltaTime / step1.duration_sec);
+			frames.push_back(currentViewport);
+
+			//next frame
+			currentTime += timeStep;
+			++frameIndex;
+		}
+		else
+		{
+			//we'll try the next step
+			++vp1Index;
+			currentStepStartTime += step1.duration_sec;
+
+			if (vp1Index == segmentCount)
+			{
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool AnimationRenderer::Render(	ccGLWindowInterface* view3d,
+								const std::vector<ExtendedViewportParameters>& frames,
+								const Parameters& params,
+								QString& errorMessage,
+								QProgressDialog* progressDialog/*=nullptr*/)
+{
+	errorMessage.clear();
+
+	if (!view3d)
+	{
+		assert(false);
+		errorMessage = "No 3D view";
+		return false;
+	}
+
+	int superRes = std::max(1, params.superResolution);
+
+#ifdef QFFMPEG_SUPPORT
+	QScopedPointer<QVideoEncoder> encoder(nullptr);
+	QSize originalViewSize;
+	if (!params.asSeparateFrames)
+	{
+		//get original viewport size
+		originalViewSize = view3d->qtSize();
+
+		//hack: as the encoder requires that the video dimensions are multiples of 8, we resize the window a little bit...
+		{
+			//find the nearest multiples of 8
+			QSize customSize = originalViewSize;
+			if (originalViewSize.width() % 8 || originalViewSize.height() % 8)
+			{
+				if (originalViewSize.width() % 8)
+					customSize.setWidth((originalViewSize.width() / 8 + 1) * 8);
+				if (originalViewSize.height() % 8)
+					customSize.setHeight((originalViewSize.height() / 8 + 1) * 8);
+				view3d->doResize(customSize);
+				QApplication::processEvents();
+			}
+		}
+
+		int animScale = (params.zoomMode ? superRes : 1);
+		encoder.reset(new QVideoEncoder(params.outputFilename, view3d->glWidth() * animScale, view3d->glHeight() * animScale, params.bitrate_kbps * 1024, params.fps, params.fps));
+		QStringList errors;
+		bool success = encoder->open(params.outputFormat, errors);
+		for (const QString& e : errors)
+		{
+			ccLog::Warning(e);
+		}
+
+		if (!success)
+		{
+			errorMessage = QString("Failed to open file for output: %1").arg(errors.empty() ? QString() : errors.back()); //the last error message
+			view3d->doResize(originalViewSize);
+			return false;
+		}
+	}
+	QVideoEncoder* encoderPtr = encoder.data();
+#else
+	if (!params.asSeparateFrames)
+	{
+		errorMessage = "Animation mode is not supported (no FFMPEG support)";
+		return false;
+	}
+	QVideoEncoder* encoderPtr = nullptr;
+#endif
+
+	bool lodWasEnabled = view3d->isLODEnabled();
+	view3d->setLODEnabled(false);
+
+	QDir outputDir(QFileInfo(params.outputFilename).absolutePath());
+
+	bool success = true;
+	{
+		FramePipeline pipeline(params, outputDir, encoderPtr);
+
+		int frameCount = static_cast<int>(frames.size());
+		for (int frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+		{
+			const ExtendedViewportParameters& viewport = frames[frameIndex];
+			view3d->setViewportParameters(viewport.params);
+			view3d->setCustomLight(viewport.customLightEnabled);
+			view3d->setCustomLightPosition(viewport.customLightPos);
+
+			//render to image (GPU rendering and read back, on the GL thread)
+			QImage image = view3d->renderToImage(superRes, params.zoomMode, false, true);
+			if (image.isNull())
+			{
+				pipeline.cancel();
+				errorMessage = "Failed to grab the screen!";
+				success = false;
+				break;
+			}
+
+			//the rest is done by the workers
+			if (!pipeline.push(std::move(image), frameIndex))
+			{
+				break;
+			}
+
+			if (progressDialog)
+			{
+				progressDialog->setValue(frameIndex + 1);
+				QApplication::processEvents();
+				if (progressDialog->wasCanceled())
+				{
+					pipeline.cancel();
+					break;
+				}
+			}
+		}
+
+		if (!pipeline.finish() && success)
+		{
+			errorMessage = pipeline.errorMessage();
+			success = false;
+		}
+	}
+
+	view3d->setLODEnabled(lodWasEnabled);
+
+#ifdef QFFMPEG_SUPPORT
+	if (encoder)
+	{
+		encoder->close();
+
+		//hack: restore original size
+		view3d->doResize(originalViewSize);
+		QApplication::processEvents();
+	}
+#endif
+
+	return success;
+}
@@ -18,6 +18,7 @@
 #include "qAnimation.h"
 
 //Local
+#include "AnimationCommand.h"
 #include "qAnimationDlg.h"
 #include "ExtendedViewport.h"
 
@@ -93,6 +94,16 @@ QList<QAction *> qAnimation::getActions()
 	return QList<QAction *>{ m_action };
 }
 
+void qAnimation::registerCommands(ccCommandLineInterface* cmd)
+{
+	if (!cmd)
+	{
+		assert(false);
+		return;
+	}
+	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new AnimationCommand));
+}
+
 //what to do when clicked.
 void qAnimation::doAction()
 {
@@ -18,6 +18,7 @@
 #include "qAnimationDlg.h"
 
 //Local
+#include "AnimationRenderer.h"
 #include "ViewInterpolate.h"
 
 //qCC_db
@@ -1267,199 +1268,57 @@ void qAnimationDlg::render(bool asSeparateFrames)
 	}
 	assert(trajectory);
 
-	bool openPoly = !loopCheckBox->isChecked();
-	size_t segmentCount = trajectory->size();
-	if (openPoly)
-	{
-		--segmentCount;
-	}
-
-	double totalTime = 0;
-	for (size_t i = 0; i < segmentCount; ++i)
-	{
-		totalTime += trajectory->at(i).duration_sec;
-	}
-
-	//count the total number of frames
-	int fps = fpsSpinBox->value();
-	int frameCount = static_cast<int>(fps * totalTime);
-
-	//super resolution
-	int superRes = superResolutionSpinBox->value();
-	const int SUPER_RESOLUTION = 0;
-	const int ZOOM = 1;
-	int renderingMode = renderingModeComboBox->currentIndex();
-	assert(renderingMode == SUPER_RESOLUTION || renderingMode == ZOOM);
-
-	//show progress dialog
-	QProgressDialog progressDialog(tr("Frames: %1").arg(frameCount), "Cancel", 0, frameCount, this);
-	progressDialog.setWindowTitle("Render");
-	progressDialog.show();
-	QApplication::processEvents();
-
-#ifdef QFFMPEG_SUPPORT
-	QScopedPointer<QVideoEncoder> encoder(0);
-	QSize originalViewSize;
-	if (!asSeparateFrames)
+	//interpolate all the frames viewports
+	std::vector<ExtendedViewportParameters> frames;
 	{
-		//get original viewport size
-		originalViewSize = m_view3d->qtSize();
-
-		//hack: as the encoder requires that the video dimensions are multiples of 8, we resize the window a little bit...
+		std::vector<AnimationRenderer::KeyFrame> keyFrames;
+		try
 		{
-			//find the nearest multiples of 8
-			QSize customSize = originalViewSize;
-			if (originalViewSize.width() % 8 || originalViewSize.height() % 8)
-			{
-				if (originalViewSize.width() % 8)
-					customSize.setWidth((originalViewSize.width() / 8 + 1) * 8);
-				if (originalViewSize.height() % 8)
-					customSize.setHeight((originalViewSize.height() / 8 + 1) * 8);
-				m_view3d->doResize(customSize);
-				QApplication::processEvents();
-			}
+			keyFrames.resize(trajectory->size());
 		}
-
-		int bitrate = bitrateSpinBox->value() * 1024;
-		int gop = fps;
-		int animScale = 1;
-		if (renderingMode == ZOOM)
+		catch (const std::bad_alloc&)
 		{
-			animScale = superRes;
+			ccLog::Error("Not enough memory");
+			setEnabled(true);
+			return;
 		}
-
-		encoder.reset(new QVideoEncoder(outputFilename, m_view3d->glWidth() * animScale, m_view3d->glHeight() * animScale, bitrate, gop, static_cast<unsigned>(fpsSpinBox->value())));
-		QStringList errors;
-		QString outputFormat = outputFormatComboBox->currentData().toString();
-		bool success = encoder->open(outputFormat, errors);
-		for (QString e : errors)
+		for (size_t i = 0; i < trajectory->size(); ++i)
 		{
-			ccLog::Warning(e);
+			keyFrames[i].viewport = trajectory->at(i);
+			keyFrames[i].duration_sec = trajectory->at(i).duration_sec;
 		}
 
-		if (!success)
+		if (!AnimationRenderer::InterpolateFrames(keyFrames, loopCheckBox->isChecked(), fpsSpinBox->value(), frames))
 		{
-			QMessageBox::critical(this, "Error", QString("Failed to open file for output: %1").arg(errors.back())); //display the last error message
+			ccLog::Error("Not enough memory");
 			setEnabled(true);
 			return;
 		}
 	}
-#else
-	if (!asSeparateFrames)
-	{
-		QMessageBox::critical(this, "Error", QString("Animation mode is not supported (no FFMPEG support)"));
-		return;
-	}
-#endif
-
-	bool lodWasEnabled = m_view3d->isLODEnabled();
-	m_view3d->setLODEnabled(false);
-
-	QDir outputDir(QFileInfo(outputFilename).absolutePath());
-
-	bool success = true;
-	double currentTime = 0.0;
-	double currentStepStartTime = 0.0;
-	double timeStep = 1.0 / fps;
-	size_t vp1Index = 0;
-	for (int frameIndex = 0; frameIndex < frameCount; )
-	{
-		size_t vp2Index = vp1Index + 1;
-		if (vp2Index == trajectory->size())
-		{
-			assert(!openPoly);
-			vp2Index = 0;
-		}
-
-		const Step& step1 = trajectory->at(vp1Index);
-		double deltaTime = currentTime - currentStepStartTime;
-		if (deltaTime <= step1.duration_sec)
-		{
-			const Step& step2 = trajectory->at(vp2Index);
-			ViewInterpolate interpolator(step1, step2);
-
-			ExtendedViewportParameters currentViewport;
-			interpolator.interpolate(currentViewport, deltaTime / step1.duration_sec);
+	int frameCount = static_cast<int>(frames.size());
 
-			applyViewport(currentViewport);
-
-			//render to image
-			QImage image = m_view3d->renderToImage(superRes, renderingMode == ZOOM, false, true);
-
-			if (image.isNull())
-			{
-				QMessageBox::critical(this, "Error", "Failed to grab the screen!");
-				success = false;
-				break;
-			}
-
-			if (renderingMode == SUPER_RESOLUTION && superRes > 1)
-			{
-				image = image.scaled(image.width() / superRes, image.height() / superRes, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-			}
-
-			if (asSeparateFrames)
-			{
-				QString filename = QString("frame_%1.png").arg(frameIndex, 6, 10, QChar('0'));
-				QString fullPath = outputDir.filePath(filename);
-				if (!image.save(fullPath))
-				{
-					QMessageBox::critical(this, "Error", QString("Failed to save frame #%1").arg(frameIndex + 1));
-					success = false;
-					break;
-				}
-			}
-			else
-			{
-#ifdef QFFMPEG_SUPPORT
-				QString errorString;
-				if (!encoder->encodeImage(image, frameIndex, &errorString))
-				{
-					QMessageBox::critical(this, "Error", QString("Failed to encode frame #%1: %2").arg(frameIndex + 1).arg(errorString));
-					success = false;
-					break;
-				}
-#endif
-			}
-			
-			//next frame
-			currentTime += timeStep;
-			++frameIndex;
-
-			progressDialog.setValue(frameIndex);
-			QApplication::processEvents();
-			if (progressDialog.wasCanceled())
-			{
-				QMessageBox::warning(this, "Warning", QString("Process has been cancelled"));
-				success = false;
-				break;
-			}
-		}
-		else
-		{
-			//we'll try the next step
-			++vp1Index;
-			currentStepStartTime += step1.duration_sec;
-
-			if (vp1Index == segmentCount)
-			{
-				break;
-			}
-		}
-	}
+	const int SUPER_RESOLUTION = 0;
+	const int ZOOM = 1;
+	int renderingMode = renderingModeComboBox->currentIndex();
+	assert(renderingMode == SUPER_RESOLUTION || renderingMode == ZOOM);
 
-	m_view3d->setLODEnabled(lodWasEnabled);
+	AnimationRenderer::Parameters params;
+	params.outputFilename = outputFilename;
+	params.asSeparateFrames = asSeparateFrames;
+	params.outputFormat = outputFormatComboBox->currentData().toString();
+	params.fps = fpsSpinBox->value();
+	params.bitrate_kbps = bitrateSpinBox->value();
+	params.superResolution = superResolutionSpinBox->value();
+	params.zoomMode = (renderingMode == ZOOM);
 
-#ifdef QFFMPEG_SUPPORT
-	if (encoder)
-	{
-		encoder->close();
+	//show progress dialog
+	QProgressDialog progressDialog(tr("Frames: %1").arg(frameCount), "Cancel", 0, frameCount, this);
+	progressDialog.setWindowTitle("Render");
+	progressDialog.show();
+	QApplication::processEvents();
 
-		//hack: restore original size
-		m_view3d->doResize(originalViewSize);
-		QApplication::processEvents();
-	}
-#endif
+	QString errorMessage;
+	bool success = AnimationRenderer::Render(m_view3d, frames, params, errorMessage, &progressDialog);
 
 	progressDialog.hide();
 	QApplication::processEvents();
@@ -1468,6 +1327,14 @@ void qAnimationDlg::render(bool asSeparateFrames)
 	{
 		QMessageBox::information(this, "Job done", "The animation has been saved successfully");
 	}
+	else if (progressDialog.wasCanceled())
+	{
+		QMessageBox::warning(this, "Warning", QString("Process has been cancelled"));
+	}
+	else
+	{
+		QMessageBox::critical(this, "Error", errorMessage);
+	}
 
 	setEnabled(true);
 }
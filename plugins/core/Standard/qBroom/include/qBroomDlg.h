@@ -24,6 +24,7 @@
 #include <CCGeom.h>
 
 //qCC_db
+#include <ccColorTypes.h>
 #include <ccGLMatrix.h>
 
 //system
@@ -43,6 +44,11 @@ class ccGenericGLDisplay;
 class ccMainAppInterface;
 class RGBAColorsTableType;
 
+namespace CCCoreLib
+{
+	class DgmOctree;
+}
+
 //! Dialog for the qBroom plugin
 class qBroomDlg : public QDialog, public Ui::BroomDialog
 {
@@ -145,16 +151,43 @@ protected: //methods
 	//! Updates the cleaning are representation
 	void updateSelectionBox();
 
-	//! Selects a given point
-	/** \return whether the point has been actually selected
+	//! Oriented box (used to select the points)
+	struct SelectionBox
+	{
+		CCVector3 center;
+		CCVector3 axes[3];
+		CCVector3 halfDims;
+
+		//! Returns whether a point lies inside the box
+		bool contains(const CCVector3& P) const;
+		//! Returns whether an (axis-aligned) octree cell lies entirely inside the box
+		bool containsCell(const CCVector3& cellMin, const CCVector3& cellMax) const;
+	};
+
+	//! Collects the non-selected points inside a given box
+	/** The octree cells entirely inside the box are not tested point by point,
+		and the ones already covered by the previous selection boxes are skipped.
+		\param octree cloud octree
+		\param level subdivision level
+		\param box selection box
+		\param pointIndexes the new points are pushed at the end of this vector
+		\param hasPoints set to true if at least one point (selected or not) lies inside the box
 	**/
-	bool selectPoint(unsigned index);
+	void collectBoxPoints(	const CCCoreLib::DgmOctree& octree,
+							unsigned char level,
+							const SelectionBox& box,
+							std::vector<unsigned>& pointIndexes,
+							bool& hasPoints) const;
 
 	//! Undoes a given number of steps
 	void undo(uint32_t count);
 
-	//! Prepares a new 'undo' step
-	uint32_t addUndoStep(const ccGLMatrix& broomPos);
+	//! Adds a new 'undo' step and selects the corresponding points
+	/** \param broomPos broom position
+		\param pointIndexes indexes of the points to select (sorted on output)
+		\return the number of undo steps (or 0 if there's not enough memory - nothing is selected then)
+	**/
+	uint32_t addUndoStep(const ccGLMatrix& broomPos, std::vector<unsigned>& pointIndexes);
 
 	//! Displays an error message
 	void displayError(QString message);
@@ -287,11 +320,35 @@ protected: //members
 	SelectionModes m_selectionMode;
 
 	//! Selection table
-	std::vector<uint32_t> m_selectionTable;
+	std::vector<bool> m_selectionTable;
 
 	//! Positions of the broom (for undo)
 	std::vector<ccGLMatrix> m_undoPositions;
 
+	//! Undo step (points selected at a given broom position)
+	struct UndoStep
+	{
+		//! Offset of the step point indexes in 'm_undoIndexes'
+		size_t byteOffset = 0;
+		//! Offset of the step point colors in 'm_undoColors'
+		size_t colorOffset = 0;
+		//! Number of points selected at this step
+		unsigned pointCount = 0;
+	};
+
+	//! Undo steps (same size as m_undoPositions)
+	std::vector<UndoStep> m_undoSteps;
+	//! Indexes of the points selected at each step (sorted and delta-encoded as variable-length integers)
+	std::vector<unsigned char> m_undoIndexes;
+	//! Colors of the points selected at each step (before their selection)
+	std::vector<ccColor::Rgba> m_undoColors;
+
+	//! Boxes of the last selection step
+	/** Only used to skip the octree cells that have already been swept.
+		Cleared as soon as the selection is modified by another way.
+	**/
+	std::vector<SelectionBox> m_lastSelectionBoxes;
+
 	//! Associated application
 	ccMainAppInterface* m_app;
 
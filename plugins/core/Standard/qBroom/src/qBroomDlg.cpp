@@ -45,6 +45,34 @@
 #include <QSettings>
 #include <QCloseEvent>
 
+//system
+#include <algorithm>
+
+//appends an index delta to an 'undo' buffer (variable-length encoding: 7 bits per byte)
+static void EncodeIndexDelta(std::vector<unsigned char>& buffer, unsigned delta)
+{
+	while (delta >= 0x80)
+	{
+		buffer.push_back(static_cast<unsigned char>(delta | 0x80));
+		delta >>= 7;
+	}
+	buffer.push_back(static_cast<unsigned char>(delta));
+}
+
+//reads an index delta from an 'undo' buffer (see EncodeIndexDelta)
+static unsigned DecodeIndexDelta(const unsigned char*& ptr)
+{
+	unsigned delta = 0;
+	unsigned shift = 0;
+	while (*ptr & 0x80)
+	{
+		delta |= (static_cast<unsigned>(*ptr++ & 0x7F) << shift);
+		shift += 7;
+	}
+	delta |= (static_cast<unsigned>(*ptr++) << shift);
+	return delta;
+}
+
 //intersection between a plane (the broom plane) and a line (represented by two points)
 static bool Intersection(const ccGLMatrix& broomTrans, const CCVector3& A, const CCVector3& B, CCVector3& I)
 {
@@ -418,9 +446,13 @@ bool qBroomDlg::setCloud(ccPointCloud* cloud, bool ownCloud/*=false*/, bool auto
 		try
 		{
 			m_selectionTable.clear();
-			m_selectionTable.resize(pointCount, 0);
+			m_selectionTable.resize(pointCount, false);
 			m_undoPositions.resize(0);
 			m_undoPositions.reserve(1);
+			m_undoSteps.resize(0);
+			m_undoIndexes.resize(0);
+			m_undoColors.resize(0);
+			m_lastSelectionBoxes.clear();
 		}
 		catch (const std::bad_alloc&)
 		{
@@ -1090,11 +1122,12 @@ bool qBroomDlg::positionBroom(const CCVector3& P0, const CCVector3& P1)
 #if 0
 	{
 		//new selection
-		addUndoStep(cn.center);
+		std::vector<unsigned> pointIndexes;
 		for (size_t i=0; i<count; ++i)
 		{
-			selectPoint(cn.neighbours[i].pointIndex);
+			pointIndexes.push_back(nn.neighbours[i].pointIndex);
 		}
+		addUndoStep(trans, pointIndexes);
 	}
 #endif
 
@@ -1597,24 +1630,31 @@ bool qBroomDlg::selectPoints(const ccGLMatrix& broomTrans, BroomDimensions* _bro
 	}
 
 	//extract the points inside the selection area
-	CCCoreLib::DgmOctree::BoxNeighbourhood bn;
+	std::vector<SelectionBox> boxes;
+	unsigned char level = 0;
 	{
+		SelectionBox box;
+		box.axes[0] = broomTrans.getColumnAsVec3D(0);
+		box.axes[1] = broomTrans.getColumnAsVec3D(1);
+		box.axes[2] = broomNormal;
+
+		CCVector3 dimensions(0, 0, 0);
 		CCVector3 centerShift(0, 0, 0);
 
 		switch (m_selectionMode)
 		{
 		case INSIDE:
-			bn.dimensions = CCVector3(broom.length, broom.width, broom.thick);
+			dimensions = CCVector3(broom.length, broom.width, broom.thick);
 			break;
 
 		case ABOVE:
 		case ABOVE_AND_BELOW: //we start by ABOVE and we'll treat BELOW later
-			bn.dimensions = CCVector3(broom.length, broom.width, broom.height);
+			dimensions = CCVector3(broom.length, broom.width, broom.height);
 			centerShift = ((broom.thick + broom.height) / 2) * broomNormal;
 			break;
 
 		case BELOW:
-			bn.dimensions = CCVector3(broom.length, broom.width, broom.height);
+			dimensions = CCVector3(broom.length, broom.width, broom.height);
 			centerShift = (-(broom.thick + broom.height) / 2) * broomNormal;
 			break;
 
@@ -1623,53 +1663,59 @@ bool qBroomDlg::selectPoints(const ccGLMatrix& broomTrans, BroomDimensions* _bro
 			break;
 		}
 
-		bn.center = broomCenter + centerShift;
-		bn.axes = new CCVector3[3];
+		box.center = broomCenter + centerShift;
+		box.halfDims = dimensions / 2;
+		boxes.push_back(box);
+
+		if (m_selectionMode == ABOVE_AND_BELOW)
 		{
-			bn.axes[0] = broomTrans.getColumnAsVec3D(0);
-			bn.axes[1] = broomTrans.getColumnAsVec3D(1);
-			bn.axes[2] = broomNormal;
+			box.center = broomCenter - centerShift;
+			boxes.push_back(box);
 		}
 
-		PointCoordinateType radius = std::max(bn.dimensions.x, std::max(bn.dimensions.y, bn.dimensions.z)) / 5; //emprirical ;)
-		bn.level = octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(radius);
+		PointCoordinateType radius = std::max(dimensions.x, std::max(dimensions.y, dimensions.z)) / 5; //emprirical ;)
+		level = octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(radius);
 	}
 
-	if (m_selectionMode == ABOVE_AND_BELOW)
+	//only the points that have not already been swept by the previous step are collected
+	std::vector<unsigned> newPointIndexes;
+	bool hasPoints = false;
+	try
 	{
-		//extract the first half
-		octree->getPointsInBoxNeighbourhood(bn);
-		//and prepare the next one
-		bn.center = broomCenter - ((broom.thick + broom.height) / 2) * broomNormal;
+		for (const SelectionBox& box : boxes)
+		{
+			collectBoxPoints(*octree, level, box, newPointIndexes, hasPoints);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[qBroom] Not enough memory");
+		m_lastSelectionBoxes.clear();
+		return false;
 	}
 
-	size_t count = octree->getPointsInBoxNeighbourhood(bn);
-
-	delete[] bn.axes;
-	bn.axes = nullptr;
-
-	if (count)
+	if (hasPoints)
 	{
 		//new selection
-		addUndoStep(broomTrans);
-		size_t selectedCount = 0;
-		for (size_t i=0; i<count; ++i)
+		if (addUndoStep(broomTrans, newPointIndexes) == 0)
 		{
-			if (selectPoint(bn.neighbours[i].pointIndex))
-			{
-				++selectedCount;
-			}
+			//the points couldn't be selected
+			m_lastSelectionBoxes.clear();
+			return false;
 		}
 
-		//if (selectedCount == 0)
-		//{
-		//	//no point were selected! auto undo
-		//	undo(1);
-		//}
-
 		m_cloud.ref->showSF(false); //just in case!
 	}
 
+	try
+	{
+		m_lastSelectionBoxes = boxes;
+	}
+	catch (const std::bad_alloc&)
+	{
+		m_lastSelectionBoxes.clear();
+	}
+
 	return true;
 }
 
@@ -1790,53 +1836,203 @@ void qBroomDlg::onDimensionChanged(double)
 	}
 }
 
-bool qBroomDlg::selectPoint(unsigned index)
+bool qBroomDlg::SelectionBox::contains(const CCVector3& P) const
 {
-	if (!m_cloud.ref)
+	CCVector3 CP = P - center;
+	return	std::abs(CP.dot(axes[0])) <= halfDims.x
+		&&	std::abs(CP.dot(axes[1])) <= halfDims.y
+		&&	std::abs(CP.dot(axes[2])) <= halfDims.z;
+}
+
+bool qBroomDlg::SelectionBox::containsCell(const CCVector3& cellMin, const CCVector3& cellMax) const
+{
+	//the box is convex: the cell is inside if its 8 corners are
+	for (unsigned i = 0; i < 8; ++i)
 	{
-		assert(false);
-		return false;
+		CCVector3 corner(	(i & 1) ? cellMax.x : cellMin.x,
+							(i & 2) ? cellMax.y : cellMin.y,
+							(i & 4) ? cellMax.z : cellMin.z);
+		if (!contains(corner))
+		{
+			return false;
+		}
 	}
+	return true;
+}
 
-	assert(index < m_selectionTable.size());
-	if (m_selectionTable[index] != 0)
-	{
-		//already selected
-		return false;
+void qBroomDlg::collectBoxPoints(	const CCCoreLib::DgmOctree& octree,
+									unsigned char level,
+									const SelectionBox& box,
+									std::vector<unsigned>& pointIndexes,
+									bool& hasPoints) const
+{
+	//bounding box of the (oriented) selection box
+	CCVector3 halfExtents;
+	for (unsigned d = 0; d < 3; ++d)
+	{
+		halfExtents.u[d] =	std::abs(box.axes[0].u[d]) * box.halfDims.x
+						+	std::abs(box.axes[1].u[d]) * box.halfDims.y
+						+	std::abs(box.axes[2].u[d]) * box.halfDims.z;
+	}
+	CCVector3 bbMin = box.center - halfExtents;
+	CCVector3 bbMax = box.center + halfExtents;
+
+	//corresponding range of cells (restricted to the non empty part of the octree)
+	Tuple3i minPos;
+	Tuple3i maxPos;
+	octree.getTheCellPosWhichIncludesThePoint(&bbMin, minPos, level);
+	octree.getTheCellPosWhichIncludesThePoint(&bbMax, maxPos, level);
+	{
+		const int* minFillIndexes = octree.getMinFillIndexes(level);
+		const int* maxFillIndexes = octree.getMaxFillIndexes(level);
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			minPos.u[d] = std::max(minPos.u[d], minFillIndexes[d]);
+			maxPos.u[d] = std::min(maxPos.u[d], maxFillIndexes[d]);
+			if (minPos.u[d] > maxPos.u[d])
+			{
+				//no intersection with the octree
+				return;
+			}
+		}
 	}
 
-	m_cloud.ref->setPointColor(index, ccColor::red);
+	CCVector3 octreeMin;
+	CCVector3 octreeMax;
+	octree.getBoundingBox(octreeMin, octreeMax);
+	const PointCoordinateType cellSize = octree.getCellSize(level);
+	const unsigned char bitShift = CCCoreLib::DgmOctree::GET_BIT_SHIFT(level);
+	const CCCoreLib::DgmOctree::cellsContainer& cellCodes = octree.pointsAndTheirCellCodes();
 
-	assert(!m_undoPositions.empty());
-	m_selectionTable[index] = static_cast<uint32_t>(m_undoPositions.size());
+	Tuple3i cellPos;
+	for (cellPos.z = minPos.z; cellPos.z <= maxPos.z; ++cellPos.z)
+	{
+		for (cellPos.y = minPos.y; cellPos.y <= maxPos.y; ++cellPos.y)
+		{
+			for (cellPos.x = minPos.x; cellPos.x <= maxPos.x; ++cellPos.x)
+			{
+				CCCoreLib::DgmOctree::CellCode truncatedCode = CCCoreLib::DgmOctree::GenerateTruncatedCellCode(cellPos, level);
+				unsigned cellIndex = octree.getCellIndex(truncatedCode, bitShift);
+				if (cellIndex >= cellCodes.size())
+				{
+					//empty cell
+					continue;
+				}
 
-	return true;
+				CCVector3 cellMin(	octreeMin.x + cellPos.x * cellSize,
+									octreeMin.y + cellPos.y * cellSize,
+									octreeMin.z + cellPos.z * cellSize);
+				CCVector3 cellMax = cellMin + CCVector3(cellSize, cellSize, cellSize);
+
+				bool insideCell = box.containsCell(cellMin, cellMax);
+				if (insideCell)
+				{
+					hasPoints = true;
+
+					//if the cell was entirely inside the previous boxes, its points are already selected
+					bool alreadySwept = false;
+					for (const SelectionBox& lastBox : m_lastSelectionBoxes)
+					{
+						if (lastBox.containsCell(cellMin, cellMax))
+						{
+							alreadySwept = true;
+							break;
+						}
+					}
+					if (alreadySwept)
+					{
+						continue;
+					}
+				}
+
+				for (unsigned i = cellIndex; i < cellCodes.size() && (cellCodes[i].theCode >> bitShift) == truncatedCode; ++i)
+				{
+					unsigned pointIndex = cellCodes[i].theIndex;
+					bool selected = m_selectionTable[pointIndex];
+					if (selected && hasPoints)
+					{
+						//nothing to learn from this point
+						continue;
+					}
+					if (insideCell || box.contains(*m_cloud.ref->getPoint(pointIndex)))
+					{
+						hasPoints = true;
+						if (!selected)
+						{
+							pointIndexes.push_back(pointIndex);
+						}
+					}
+				}
+			}
+		}
+	}
 }
 
-uint32_t qBroomDlg::addUndoStep(const ccGLMatrix& broomPos)
+uint32_t qBroomDlg::addUndoStep(const ccGLMatrix& broomPos, std::vector<unsigned>& pointIndexes)
 {
-	applyPushButton->setEnabled(true);
-	validatePushButton->setEnabled(true);
+	RGBAColorsTableType* colors = m_cloud.ref ? m_cloud.ref->rgbaColors() : nullptr;
+	if (!colors)
+	{
+		assert(false);
+		return 0;
+	}
+
+	//the indexes are sorted so as to store (small) deltas
+	std::sort(pointIndexes.begin(), pointIndexes.end());
+	pointIndexes.erase(std::unique(pointIndexes.begin(), pointIndexes.end()), pointIndexes.end());
+
+	UndoStep step;
+	step.byteOffset = m_undoIndexes.size();
+	step.colorOffset = m_undoColors.size();
+	step.pointCount = static_cast<unsigned>(pointIndexes.size());
 
-	//new selection
 	try
 	{
+		m_undoColors.reserve(step.colorOffset + pointIndexes.size());
+		unsigned previousIndex = 0;
+		for (unsigned pointIndex : pointIndexes)
+		{
+			EncodeIndexDelta(m_undoIndexes, pointIndex - previousIndex);
+			previousIndex = pointIndex;
+			m_undoColors.push_back(colors->getValue(pointIndex));
+		}
+
+		m_undoSteps.push_back(step);
 		m_undoPositions.push_back(broomPos);
-		undoPushButton->setEnabled(true);
-		undo10PushButton->setEnabled(true);
 	}
 	catch (const std::bad_alloc&)
 	{
-		//not enough memory (undo will be broken)
+		//not enough memory (the points are not selected, as it couldn't be undone)
+		m_undoIndexes.resize(step.byteOffset);
+		m_undoColors.resize(step.colorOffset);
+		m_undoSteps.resize(m_undoPositions.size());
+		ccLog::Warning("[qBroom] Not enough memory to store the undo step");
+		return 0;
 	}
 
+	//new selection (only the VBO chunks of the modified points will be updated)
+	for (unsigned pointIndex : pointIndexes)
+	{
+		assert(!m_selectionTable[pointIndex]);
+		m_selectionTable[pointIndex] = true;
+		colors->setValue(pointIndex, ccColor::red);
+		m_cloud.ref->colorsHaveChanged(pointIndex, pointIndex);
+	}
+
+	applyPushButton->setEnabled(true);
+	validatePushButton->setEnabled(true);
+	undoPushButton->setEnabled(true);
+	undo10PushButton->setEnabled(true);
+
 	return static_cast<uint32_t>(m_undoPositions.size());
 }
 
 void qBroomDlg::undo(uint32_t undoCount)
 {
 	if (	!m_cloud.ref
-		||	m_selectionTable.size() != m_cloud.ref->size())
+		||	!m_cloud.ref->hasColors()
+		||	m_selectionTable.size() != m_cloud.ref->size()
+		||	m_undoSteps.size() != m_undoPositions.size())
 	{
 		assert(false);
 		return;
@@ -1861,25 +2057,30 @@ void qBroomDlg::undo(uint32_t undoCount)
 		newPosition = m_undoPositions[newCursor];
 	}
 
-	for (unsigned i=0; i<m_cloud.ref->size(); ++i)
+	//only the points of the undone steps are restored
+	RGBAColorsTableType* colors = m_cloud.ref->rgbaColors();
+	for (size_t stepIndex = newCursor; stepIndex < m_undoSteps.size(); ++stepIndex)
 	{
-		if (m_selectionTable[i] > newCursor)
+		const UndoStep& step = m_undoSteps[stepIndex];
+		const unsigned char* ptr = m_undoIndexes.data() + step.byteOffset;
+		unsigned pointIndex = 0;
+		for (unsigned j = 0; j < step.pointCount; ++j)
 		{
-			m_selectionTable[i] = 0;
+			pointIndex += DecodeIndexDelta(ptr);
+			m_selectionTable[pointIndex] = false;
 
 			//restore the point color
-			if (m_cloud.colors)
-			{
-				m_cloud.ref->setPointColor(i, m_cloud.colors->getValue(i));
-			}
-			else
-			{
-				assert(false);
-			}
+			colors->setValue(pointIndex, m_undoColors[step.colorOffset + j]);
+			m_cloud.ref->colorsHaveChanged(pointIndex, pointIndex);
 		}
 	}
 
+	m_undoIndexes.resize(m_undoSteps[newCursor].byteOffset);
+	m_undoColors.resize(m_undoSteps[newCursor].colorOffset);
+	m_undoSteps.resize(newCursor);
 	m_undoPositions.resize(newCursor);
+	m_lastSelectionBoxes.clear();
+
 	undoPushButton->setEnabled(newCursor != 0);
 	undo10PushButton->setEnabled(newCursor != 0);
 	applyPushButton->setEnabled(newCursor != 0);
@@ -1924,11 +2125,9 @@ ccPointCloud* qBroomDlg::createSegmentedCloud(ccPointCloud* cloud, bool removeSe
 		return nullptr;
 	}
 
-	unsigned selectedCount = 0;
+	//each selected point is stored once in the undo steps
+	unsigned selectedCount = static_cast<unsigned>(m_undoColors.size());
 	{
-		for (unsigned i=0; i<cloud->size(); ++i)
-			if (m_selectionTable[i] != 0)
-				++selectedCount;
 
 		if (!removeSelected)
 		{
@@ -1955,8 +2154,7 @@ ccPointCloud* qBroomDlg::createSegmentedCloud(ccPointCloud* cloud, bool removeSe
 
 		for (unsigned i=0; i<cloud->size(); ++i)
 		{
-			if (	( removeSelected && m_selectionTable[i] == 0) //keep non selected
-				||	(!removeSelected && m_selectionTable[i] != 0) //keep selected
+			if (m_selectionTable[i] != removeSelected) //keep non selected (or selected)
 				)
 			{
 				selection.addPointIndex(i);
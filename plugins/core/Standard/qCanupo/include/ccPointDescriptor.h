@@ -24,6 +24,7 @@
 
 //CCCoreLib
 #include <ReferenceCloud.h>
+#include <SquareMatrix.h>
 
 //system
 #include <vector>
@@ -62,6 +63,11 @@ public:
 
 public:
 	virtual ~ScaleParamsComputer() = default;
+
+	//! Returns a new (independent) instance of this computer
+	/** Computers have an internal state (see reset) so each thread must use its own instance.
+	**/
+	virtual ScaleParamsComputer* clone() const = 0;
 	
 	//! Returns the associated descriptor ID
 	virtual unsigned getID() const = 0;
@@ -87,6 +93,22 @@ public:
 	**/
 	virtual void computeScaleParams(CCCoreLib::ReferenceCloud& neighbors, double radius, float params[], bool& invalidScale) = 0;
 
+	//! Returns whether the parameters only depend on the covariance matrix of the neighbors
+	/** In this case computeScaleParamsFromCovariance is called instead of computeScaleParams
+		(the covariance matrices of all the scales are then computed in a single pass).
+	**/
+	virtual bool usesCovarianceOnly() const { return false; }
+
+	//! Computes the parameters at a given scale from the covariance matrix of the neighbors
+	/** See usesCovarianceOnly. Scales are always called in decreasing order.
+		\param[in] covarianceMatrix covariance matrix of the neighbors at the current scale
+		\param[in] neighborCount number of neighbors at the current scale
+		\param[in] radius current radius (half scale) value
+		\param[out] params the computed parameters
+		\param[out] invalidScale whether this scale is 'invalid' (i.e. parameters couldn't be computed, default one have been returned instead)
+	**/
+	virtual void computeScaleParamsFromCovariance(const CCCoreLib::SquareMatrixd& covarianceMatrix, unsigned neighborCount, double radius, float params[], bool& invalidScale) { /* must be reimplemented if usesCovarianceOnly returns true */ }
+
 protected:
 };
 
@@ -50,6 +50,9 @@ public:
 	//! Default constructor
 	DimensionalityScaleParamsComputer() : m_firstScale(true) {}
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new DimensionalityScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	unsigned getID() const override { return DESC_DIMENSIONALITY; }
 
@@ -80,10 +83,27 @@ public:
 		if (neighbors.size() >= 3)
 		{
 			CCCoreLib::Neighbourhood Z(&neighbors);
+			computeScaleParamsFromCovariance(Z.computeCovarianceMatrix(), neighbors.size(), radius, params, invalidScale);
+		}
+		else if (m_firstScale) //less than 3 points at the biggest scale?!
+		{
+			invalidScale = true;
+			params[0] = m_defaultParams[0];
+			params[1] = m_defaultParams[1];
+		}
+	}
+
+	//inherited from ScaleParamsComputer
+	bool usesCovarianceOnly() const override { return true; }
 
+	//inherited from ScaleParamsComputer
+	void computeScaleParamsFromCovariance(const CCCoreLib::SquareMatrixd& covarianceMatrix, unsigned neighborCount, double radius, float params[], bool& invalidScale) override
+	{
+		//PCA analysis
+		if (neighborCount >= 3)
+		{
 			CCCoreLib::SquareMatrixd eigVectors;
 			std::vector<double> eigValues;
-			CCCoreLib::SquareMatrixd covarianceMatrix = Z.computeCovarianceMatrix();
 			if (CCCoreLib::Jacobi<double>::ComputeEigenValuesAndVectors(covarianceMatrix, eigVectors, eigValues, true))
 			{
 				CCCoreLib::Jacobi<double>::SortEigenValuesAndVectors(eigVectors, eigValues); //decreasing order of their associated eigenvalues
@@ -154,6 +174,9 @@ public:
 	//! Default constructor
 	DimensionalityAndSFScaleParamsComputer() : m_firstScale(true) {}
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new DimensionalityAndSFScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	unsigned getID() const override { return DESC_DIMENSIONALITY_SF; }
 
@@ -286,6 +309,9 @@ public:
 	//! Default constructor
 	CurvatureScaleParamsComputer() : m_firstScale(true) {}
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new CurvatureScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	unsigned getID() const override { return DESC_CURVATURE; }
 
@@ -338,6 +364,9 @@ public:
 	//! Default constructor
 	CustomScaleParamsComputer() : m_firstScale(true) {}
 
+	//inherited from ScaleParamsComputer
+	ScaleParamsComputer* clone() const override { return new CustomScaleParamsComputer(*this); }
+
 	//inherited from ScaleParamsComputer
 	unsigned getID() const override { return DESC_CUSTOM; }
 
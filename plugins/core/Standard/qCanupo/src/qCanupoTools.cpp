@@ -40,161 +40,263 @@
 #include <QMainWindow>
 #include <QtConcurrentMap>
 
-//ComputeCorePointsDescriptors parameters
-static struct
-{
-	CCCoreLib::GenericIndexedCloud* corePoints;
-	ccGenericPointCloud* sourceCloud;
-	CCCoreLib::DgmOctree* octree;
-	unsigned char octreeLevel;
-	CorePointDescSet* descriptors;
-	bool invalidDescriptors;
-
-	CCCoreLib::NormalizedProgress* nProgress;
-	bool processCanceled;
-	bool errorOccurred;
-
-	ScaleParamsComputer* computer; //the per-scale parameters computer 
-
-	std::vector<ccScalarField*>* roughnessSFs; //for test
-
+//system
+#include <algorithm>
+#include <atomic>
+#include <memory>
 
-} s_computeCorePointsDescParams;
-
-//! Per-point descriptor computer (all the parameters are stored in s_computeCorePointsDescParams)
-void ComputeCorePointDescriptor(unsigned index)
+namespace
 {
-	if (s_computeCorePointsDescParams.processCanceled)
-		return;
-
-	const CCVector3* P = s_computeCorePointsDescParams.corePoints->getPoint(index);
-	CCCoreLib::DgmOctree::NeighboursSet neighbours;
-
-	//extract the neighbors (maximum radius)
-	float maxRadius = s_computeCorePointsDescParams.descriptors->scales().front() / 2;
-	int n = s_computeCorePointsDescParams.octree->getPointsInSphericalNeighbourhood(*P,
-																				maxRadius,
-																				neighbours,
-																				s_computeCorePointsDescParams.octreeLevel);
-
-	if (n != 0)
+	//! Shared parameters and status of a descriptors computation
+	struct DescriptorsComputationContext
 	{
-		size_t scaleCount = s_computeCorePointsDescParams.descriptors->scales().size();
-
-		//get reference on corresponding descriptor
-		assert(s_computeCorePointsDescParams.descriptors->size() > index);
-		CorePointDesc& desc = s_computeCorePointsDescParams.descriptors->at(index);
+		CCCoreLib::GenericIndexedCloud* corePoints = nullptr;
+		ccGenericPointCloud* sourceCloud = nullptr;
+		CCCoreLib::DgmOctree* octree = nullptr;
+		unsigned char octreeLevel = 0;
+		CorePointDescSet* descriptors = nullptr;
+		const ScaleParamsComputer* computer = nullptr; //the per-scale parameters computer (prototype)
+		std::vector<ccScalarField*>* roughnessSFs = nullptr; //for test
+
+		CCCoreLib::NormalizedProgress* nProgress = nullptr;
+		std::atomic<bool> invalidDescriptors{ false };
+		std::atomic<bool> processCanceled{ false };
+		std::atomic<bool> errorOccurred{ false };
+	};
+
+	//! Multi-scale descriptors engine (re-entrant: one instance per thread/task)
+	/** The neighbors are extracted once (at the biggest scale) and sorted by increasing distance.
+		If the descriptor only depends on the covariance matrix of the neighbors, the covariance
+		matrices of all the scales are then computed in a single pass over the sorted neighbors
+		(running sums). Otherwise the neighbors subset is trimmed from one scale to the next.
+	**/
+	class CorePointDescriptorEngine
+	{
+	public:
 
-		unsigned dimPerScale = s_computeCorePointsDescParams.descriptors->dimPerScale();
-		assert(desc.params.size() == scaleCount * dimPerScale);
+		explicit CorePointDescriptorEngine(DescriptorsComputationContext& context)
+			: m_context(context)
+			, m_computer(context.computer->clone())
+			, m_subset(context.sourceCloud)
+		{
+			const size_t scaleCount = context.descriptors->scales().size();
+			m_scaleCounts.resize(scaleCount);
+			m_covariances.resize(scaleCount, CCCoreLib::SquareMatrixd(3));
+		}
 
-		//init the whole neighborhood subset (we will prune it each time)
-		CCCoreLib::ReferenceCloud subset(s_computeCorePointsDescParams.sourceCloud);
+		//! Computes the descriptor of a given core point
+		void compute(unsigned index)
 		{
-			if (!subset.reserve(n))
+			if (m_context.processCanceled)
+				return;
+
+			try
+			{
+				computeDescriptor(index);
+			}
+			catch (const std::bad_alloc&)
 			{
 				//not enough memory!
-				s_computeCorePointsDescParams.errorOccurred = true;
-				s_computeCorePointsDescParams.processCanceled = true; //to make the loop stop!
+				m_context.errorOccurred = true;
+				m_context.processCanceled = true; //to make the loop stop!
 				return;
 			}
 
-			//sort the neighbors by increasing distance
-			ParallelSort(neighbours.begin(), neighbours.end(), CCCoreLib::DgmOctree::PointDescriptor::distComp);
-
-			for (int j = 0; j < n; ++j)
+			//progress notification
+			if (m_context.nProgress && !m_context.nProgress->oneStep())
 			{
-				subset.addPointIndex(neighbours[j].pointIndex);
+				m_context.processCanceled = true;
 			}
 		}
 
-		s_computeCorePointsDescParams.computer->reset();
+	protected:
 
-		for (size_t i = 0; i < scaleCount; ++i)
+		void computeDescriptor(unsigned index)
 		{
-			const double radius = s_computeCorePointsDescParams.descriptors->scales()[i] / 2; //we start from the biggest
+			const CCVector3 P = *m_context.corePoints->getPoint(index);
+
+			//extract the neighbors (maximum radius)
+			const std::vector<float>& scales = m_context.descriptors->scales();
+			float maxRadius = scales.front() / 2;
+			m_neighbours.clear();
+			int n = m_context.octree->getPointsInSphericalNeighbourhood(P, maxRadius, m_neighbours, m_context.octreeLevel);
+			if (n == 0)
+			{
+				//if the widest neighborhood has less than 3 points, we can't compute a valid descriptor!
+				m_context.invalidDescriptors = true;
+				return;
+			}
+
+			//sort the neighbors by increasing distance
+			std::sort(m_neighbours.begin(), m_neighbours.begin() + n, CCCoreLib::DgmOctree::PointDescriptor::distComp);
 
-			if (i != 0)
+			//number of neighbors at each scale (we start from the biggest)
+			const size_t scaleCount = scales.size();
+			m_scaleCounts[0] = static_cast<unsigned>(n);
+			for (size_t i = 1; i < scaleCount; ++i)
 			{
-				//trim the points that don't fall in the current neighborhood
-				double squareRadius = radius * radius;
-				CCCoreLib::DgmOctree::PointDescriptor fakeDesc(nullptr, 0, squareRadius);
-				CCCoreLib::DgmOctree::NeighboursSet::iterator up = std::upper_bound(neighbours.begin(), neighbours.end(), fakeDesc, CCCoreLib::DgmOctree::PointDescriptor::distComp);
-				if (up != neighbours.end())
+				const double radius = scales[i] / 2;
+				CCCoreLib::DgmOctree::PointDescriptor fakeDesc(nullptr, 0, radius * radius);
+				size_t count = std::upper_bound(m_neighbours.begin(), m_neighbours.begin() + m_scaleCounts[i - 1], fakeDesc, CCCoreLib::DgmOctree::PointDescriptor::distComp) - m_neighbours.begin();
+				if (count != m_scaleCounts[i - 1])
 				{
-					size_t count = std::max<size_t>(1, up - neighbours.begin());
+					count = std::max<size_t>(1, count);
+				}
+				m_scaleCounts[i] = static_cast<unsigned>(count);
+			}
+
+			//get reference on corresponding descriptor
+			assert(m_context.descriptors->size() > index);
+			CorePointDesc& desc = m_context.descriptors->at(index);
+			const unsigned dimPerScale = m_context.descriptors->dimPerScale();
+			assert(desc.params.size() == scaleCount * dimPerScale);
 
-					neighbours.resize(count);
-					subset.resize(static_cast<unsigned>(count));
+			const bool useCovariance = (m_computer->usesCovarianceOnly() && !m_context.roughnessSFs);
+			if (useCovariance)
+			{
+				computeCovarianceMatrices(P);
+			}
+			else
+			{
+				//init the whole neighborhood subset (we will prune it each time)
+				m_subset.clear(false);
+				if (!m_subset.reserve(static_cast<unsigned>(n)))
+				{
+					throw std::bad_alloc();
+				}
+				for (int j = 0; j < n; ++j)
+				{
+					m_subset.addPointIndex(m_neighbours[j].pointIndex);
 				}
 			}
 
-			//optional: compute per-level roughness
-			if (s_computeCorePointsDescParams.roughnessSFs)
+			m_computer->reset();
+
+			for (size_t i = 0; i < scaleCount; ++i)
 			{
-				ScalarType roughness = CCCoreLib::NAN_VALUE;
+				const double radius = scales[i] / 2; //we start from the biggest
+				bool invalidScale = false;
 
-				if (subset.size() >= 3)
+				if (useCovariance)
+				{
+					m_computer->computeScaleParamsFromCovariance(m_covariances[i], m_scaleCounts[i], radius, &(desc.params[i*dimPerScale]), invalidScale);
+				}
+				else
 				{
-					//to compute we take the nearest point to the query point as 'central' point
-					//warning: it should work in most of the cases, apart if the core points have nothing to do
-					//with the global cloud!!!
-					unsigned lastIndex = subset.size() - 1;
-					subset.swap(0, lastIndex);
-
-					//temporarily remove the central point (now at the end)
-					unsigned globalIndex = subset.getPointGlobalIndex(lastIndex);
-					subset.resize(lastIndex);
-
-					CCCoreLib::Neighbourhood Z(&subset);
-					const PointCoordinateType* lsPlane = Z.getLSPlane();
-					if (lsPlane)
+					//trim the points that don't fall in the current neighborhood
+					m_subset.resize(m_scaleCounts[i]);
+
+					//optional: compute per-level roughness
+					if (m_context.roughnessSFs)
 					{
-						//distance to the LS plane fitted on the nearest neighbors
-						const CCVector3* centralPoint = s_computeCorePointsDescParams.sourceCloud->getPoint(globalIndex);
-						roughness = std::abs(CCCoreLib::DistanceComputationTools::computePoint2PlaneDistance(centralPoint, lsPlane));
+						computeRoughness(index, i);
 					}
 
-					//put back the point at its original place!
-					subset.addPointIndex(globalIndex);
-					subset.swap(0, lastIndex);
+					m_computer->computeScaleParams(m_subset, radius, &(desc.params[i*dimPerScale]), invalidScale);
 				}
 
-				assert(s_computeCorePointsDescParams.roughnessSFs->size() == scaleCount);
-				ccScalarField* sf = s_computeCorePointsDescParams.roughnessSFs->at(i);
-				assert(sf && sf->currentSize() > index);
-				sf->setValue(index, roughness);
+				if (invalidScale)
+				{
+					m_context.invalidDescriptors = true;
+					//no need to compute the remaining scales!
+					for (size_t j = i + 1; j < scaleCount; ++j)
+					{
+						//copy the same parameters for all scales (see CANUPO paper)
+						memcpy(&(desc.params[j*dimPerScale]), &(desc.params[i*dimPerScale]), sizeof(float)*dimPerScale);
+					}
+					break;
+				}
 			}
+		}
 
-			bool invalidScale = false;
-			s_computeCorePointsDescParams.computer->computeScaleParams(subset, radius, &(desc.params[i*dimPerScale]), invalidScale);
+		//! Computes the covariance matrices of all the scales in a single pass over the sorted neighbors
+		void computeCovarianceMatrices(const CCVector3& center)
+		{
+			//running sums (relative to the core point, for a better accuracy)
+			double sum[3] = { 0, 0, 0 };
+			double sum2[6] = { 0, 0, 0, 0, 0, 0 }; //xx, xy, xz, yy, yz, zz
+			unsigned count = 0;
 
-			if (invalidScale)
+			//the smallest scale comes last
+			for (size_t i = m_scaleCounts.size(); i-- != 0; )
 			{
-				s_computeCorePointsDescParams.invalidDescriptors = true;
-				//no need to compute the remaining scales!
-				for (size_t j = i + 1; j < scaleCount; ++j)
+				for (; count < m_scaleCounts[i]; ++count)
 				{
-					//copy the same parameters for all scales (see CANUPO paper)
-					memcpy(&(desc.params[j*dimPerScale]), &(desc.params[i*dimPerScale]), sizeof(float)*dimPerScale);
+					CCVector3d d = CCVector3d::fromArray((*m_neighbours[count].point - center).u);
+					sum[0] += d.x;
+					sum[1] += d.y;
+					sum[2] += d.z;
+					sum2[0] += d.x * d.x;
+					sum2[1] += d.x * d.y;
+					sum2[2] += d.x * d.z;
+					sum2[3] += d.y * d.y;
+					sum2[4] += d.y * d.z;
+					sum2[5] += d.z * d.z;
 				}
-				//neighbours.clear();
-				//subset.clear(true);
-				break;
+
+				//scale boundary: covariance = E[d.d^T] - E[d].E[d]^T
+				CCCoreLib::SquareMatrixd& cov = m_covariances[i];
+				const double mx = sum[0] / count;
+				const double my = sum[1] / count;
+				const double mz = sum[2] / count;
+				cov.m_values[0][0] = sum2[0] / count - mx * mx;
+				cov.m_values[0][1] = cov.m_values[1][0] = sum2[1] / count - mx * my;
+				cov.m_values[0][2] = cov.m_values[2][0] = sum2[2] / count - mx * mz;
+				cov.m_values[1][1] = sum2[3] / count - my * my;
+				cov.m_values[1][2] = cov.m_values[2][1] = sum2[4] / count - my * mz;
+				cov.m_values[2][2] = sum2[5] / count - mz * mz;
 			}
 		}
-	}
-	else
-	{
-		//if the widest neighborhood has less than 3 points, we can't compute a valid descriptor!
-		s_computeCorePointsDescParams.invalidDescriptors = true;
-	}
-	
-	//progress notification
-	if (s_computeCorePointsDescParams.nProgress && !s_computeCorePointsDescParams.nProgress->oneStep())
-	{
-		s_computeCorePointsDescParams.processCanceled = true;
-	}
+
+		//! Computes the roughness at a given scale (test)
+		void computeRoughness(unsigned index, size_t scaleIndex)
+		{
+			ScalarType roughness = CCCoreLib::NAN_VALUE;
+
+			if (m_subset.size() >= 3)
+			{
+				//to compute we take the nearest point to the query point as 'central' point
+				//warning: it should work in most of the cases, apart if the core points have nothing to do
+				//with the global cloud!!!
+				unsigned lastIndex = m_subset.size() - 1;
+				m_subset.swap(0, lastIndex);
+
+				//temporarily remove the central point (now at the end)
+				unsigned globalIndex = m_subset.getPointGlobalIndex(lastIndex);
+				m_subset.resize(lastIndex);
+
+				CCCoreLib::Neighbourhood Z(&m_subset);
+				const PointCoordinateType* lsPlane = Z.getLSPlane();
+				if (lsPlane)
+				{
+					//distance to the LS plane fitted on the nearest neighbors
+					const CCVector3* centralPoint = m_context.sourceCloud->getPoint(globalIndex);
+					roughness = std::abs(CCCoreLib::DistanceComputationTools::computePoint2PlaneDistance(centralPoint, lsPlane));
+				}
+
+				//put back the point at its original place!
+				m_subset.addPointIndex(globalIndex);
+				m_subset.swap(0, lastIndex);
+			}
+
+			assert(m_context.roughnessSFs->size() == m_scaleCounts.size());
+			ccScalarField* sf = m_context.roughnessSFs->at(scaleIndex);
+			assert(sf && sf->currentSize() > index);
+			sf->setValue(index, roughness);
+		}
+
+	private:
+
+		DescriptorsComputationContext& m_context;
+		std::unique_ptr<ScaleParamsComputer> m_computer;
+		CCCoreLib::DgmOctree::NeighboursSet m_neighbours;
+		CCCoreLib::ReferenceCloud m_subset;
+		std::vector<unsigned> m_scaleCounts;
+		std::vector<CCCoreLib::SquareMatrixd> m_covariances;
+	};
+
+	//! Number of core points processed by each task (with the same engine instance)
+	static const unsigned s_corePointsBlockSize = 256;
 }
 
 bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud* corePoints,
@@ -229,20 +331,20 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	}
 
 	//descriptor (computer)
-	s_computeCorePointsDescParams.computer = ScaleParamsComputer::GetByID(descriptorID);
-	if (!s_computeCorePointsDescParams.computer)
+	const ScaleParamsComputer* computer = ScaleParamsComputer::GetByID(descriptorID);
+	if (!computer)
 	{
 		error = QString("Unhandled descriptor ID (%1)!").arg(descriptorID);
 		return false;
 	}
-	if (s_computeCorePointsDescParams.computer->needSF() && !corePoints->enableScalarField())
+	if (computer->needSF() && !corePoints->enableScalarField())
 	{
 		error = "Couldn't allocate a scalar field for core points!";
 		return false;
 	}
 
 	corePointsDescriptors.setDescriptorID(descriptorID);
-	corePointsDescriptors.setDimPerScale(s_computeCorePointsDescParams.computer->dimPerScale());
+	corePointsDescriptors.setDimPerScale(computer->dimPerScale());
 
 	CCCoreLib::DgmOctree* theOctree = inputOctree;
 	if (!theOctree)
@@ -292,16 +394,15 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	PointCoordinateType biggestRadius = sortedScales.front() / 2; //we extract the biggest neighborhood
 	unsigned char octreeLevel = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(biggestRadius);
 
-	s_computeCorePointsDescParams.corePoints = corePoints;
-	s_computeCorePointsDescParams.descriptors = &corePointsDescriptors;
-	s_computeCorePointsDescParams.sourceCloud = sourceCloud;
-	s_computeCorePointsDescParams.octree = theOctree;
-	s_computeCorePointsDescParams.octreeLevel = octreeLevel;
-	s_computeCorePointsDescParams.nProgress = progressCb ? &nProgress : nullptr;
-	s_computeCorePointsDescParams.processCanceled = false;
-	s_computeCorePointsDescParams.errorOccurred = false;
-	s_computeCorePointsDescParams.invalidDescriptors = false;
-	s_computeCorePointsDescParams.roughnessSFs = roughnessSFs;
+	DescriptorsComputationContext context;
+	context.corePoints = corePoints;
+	context.descriptors = &corePointsDescriptors;
+	context.sourceCloud = sourceCloud;
+	context.octree = theOctree;
+	context.octreeLevel = octreeLevel;
+	context.computer = computer;
+	context.nProgress = progressCb ? &nProgress : nullptr;
+	context.roughnessSFs = roughnessSFs;
 
 	//we try the parallel way (if we have enough memory)
 	bool useParallelStrategy = true;
@@ -309,12 +410,13 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 	useParallelStrategy = false;
 #endif
 
-	std::vector<unsigned> corePointsIndexes;
+	//the core points are processed by blocks (each block with its own engine and buffers)
+	std::vector<unsigned> blockStarts;
 	if (useParallelStrategy)
 	{
 		try
 		{
-			corePointsIndexes.resize(corePtsCount);
+			blockStarts.reserve((corePtsCount + s_corePointsBlockSize - 1) / s_corePointsBlockSize);
 		}
 		catch (const std::bad_alloc&)
 		{
@@ -323,11 +425,29 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 		}
 	}
 
+	auto processRange = [&context](unsigned firstIndex, unsigned lastIndex)
+	{
+		try
+		{
+			CorePointDescriptorEngine engine(context);
+			for (unsigned i = firstIndex; i < lastIndex && !context.processCanceled; ++i)
+			{
+				engine.compute(i);
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			context.errorOccurred = true;
+			context.processCanceled = true;
+		}
+	};
+
 	if (useParallelStrategy)
 	{
-		for (unsigned i = 0; i < corePtsCount; ++i)
+		for (unsigned i = 0; i < corePtsCount; i += s_corePointsBlockSize)
 		{
-			corePointsIndexes[i] = i;
+			blockStarts.push_back(i);
 		}
 
 		if (maxThreadCount == 0)
@@ -336,37 +456,25 @@ bool qCanupoTools::ComputeCorePointsDescriptors(CCCoreLib::GenericIndexedCloud*
 		}
 		assert(maxThreadCount <= QThread::idealThreadCount());
 		QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
-		QtConcurrent::blockingMap(corePointsIndexes, ComputeCorePointDescriptor);
+		QtConcurrent::blockingMap(blockStarts, [&](unsigned blockStart)
+		{
+			processRange(blockStart, std::min(blockStart + s_corePointsBlockSize, corePtsCount));
+		});
 	}
 	else
 	{
-		//manually call the static per-point method!
-		for (unsigned i = 0; i < corePtsCount; ++i)
-		{
-			ComputeCorePointDescriptor(i);
-		}
+		//a single engine for all the points
+		processRange(0, corePtsCount);
 	}
 
 	//output flags
-	bool wasCanceled = s_computeCorePointsDescParams.processCanceled;
-	bool errorOccurred = s_computeCorePointsDescParams.errorOccurred;
+	bool wasCanceled = context.processCanceled;
+	bool errorOccurred = context.errorOccurred;
 	if (errorOccurred)
 		error = "An error occurred during descriptors computation!";
 	else if (wasCanceled)
 		error = "Process has been cancelled by the user";
-	invalidDescriptors = s_computeCorePointsDescParams.invalidDescriptors;
-
-	//reset static parameters (just to be clean ;)
-	s_computeCorePointsDescParams.corePoints = nullptr;
-	s_computeCorePointsDescParams.descriptors = nullptr;
-	s_computeCorePointsDescParams.sourceCloud = nullptr;
-	s_computeCorePointsDescParams.octree = nullptr;
-	s_computeCorePointsDescParams.octreeLevel = 0;
-	s_computeCorePointsDescParams.nProgress = nullptr;
-	s_computeCorePointsDescParams.processCanceled = false;
-	s_computeCorePointsDescParams.errorOccurred = false;
-	s_computeCorePointsDescParams.invalidDescriptors = false;
-	s_computeCorePointsDescParams.computer = nullptr;
+	invalidDescriptors = context.invalidDescriptors;
 
 	if (progressCb)
 	{
@@ -29,6 +29,7 @@
 #include <QColor>
 
 //std
+#include <map>
 #include <vector>
 
 class ccPointCloud;
@@ -67,7 +68,15 @@ public:
 	//! Restore original scalar values
 	void restoreCurrentSFValues();
 
+	//! Applies the brush (circle) to the projected points
+	/** Only the points in the screen-space buckets overlapping the circle are tested.
+	    \param center circle center (centered GL coordinates)
+	    \param squareDist circle squared radius (in pixels)
+	    \param[out] affected class count changes (per code)
+	**/
 	void mouseMove(const CCVector2& center, PointCoordinateType squareDist, std::map<ScalarType, int>& affected);
+
+	//! Projects the cloud in 2D (and indexes the projected points in screen-space buckets)
 	bool projectCloud(const ccGLCameraParameters& camera);
 
 	//! Whether the scalar field values (and currently displayed colors) have been modified
@@ -90,6 +99,12 @@ public:
 private: // methods
 	void project(const ccGLCameraParameters& camera, unsigned start, unsigned end);
 
+	//! Indexes the projected points in screen-space buckets
+	bool buildBucketIndex(const ccGLCameraParameters& camera, unsigned threadCount);
+
+	//! Brushes a single point (returns whether the point has been modified)
+	bool brushPoint(unsigned index, const CCVector2& center2D, PointCoordinateType squareDist, ScalarType inputCode, ScalarType outputCode, const ccColor::Rgba& outputColor, std::map<ScalarType, int>& affected);
+
 	//! Save current scalar field values
 	bool saveCurrentSFValues(int sfIndex);
 
@@ -119,5 +134,44 @@ private: // variables
 		bool inFrustum = false;
 	};
 	std::vector<ProjectedPoint> m_projectedPoints;
+
+	//! Screen-space bucket index of the projected points
+	struct BucketIndex
+	{
+		//! Bucket size (in pixels)
+		static constexpr int CellSize = 16;
+
+		//! Grid origin (centered GL coordinates of the viewport lower-left corner)
+		CCVector2 origin;
+		//! Grid dimensions
+		int width = 0, height = 0;
+		//! Index of the first point of each bucket (in 'pointIndexes' - one more element for the end)
+		std::vector<unsigned> cellStart;
+		//! Points indexes (sorted by bucket - only the points inside the frustum)
+		std::vector<unsigned> pointIndexes;
+
+		inline bool isValid() const { return !cellStart.empty(); }
+		inline void clear() { cellStart.clear(); pointIndexes.clear(); }
+		//! Returns the bucket column or row of a 2D coordinate (clamped to the grid)
+		static inline int ToCell(PointCoordinateType v, PointCoordinateType o, int cellCount)
+		{
+			PointCoordinateType c = (v - o) / CellSize;
+			if (!(c > 0))
+				return 0;
+			if (c >= cellCount)
+				return cellCount - 1;
+			return static_cast<int>(c);
+		}
+		inline int cellIndex(const CCVector2& P) const
+		{
+			return ToCell(P.y, origin.y, height) * width + ToCell(P.x, origin.x, width);
+		}
+	};
+	BucketIndex m_buckets;
+
+	//! Class count changes (indexed by class code - integer codes in [0 ; 255] only)
+	std::vector<int> m_classCountDeltas;
+	//! Modified color chunks
+	std::vector<bool> m_modifiedColorChunks;
 };
 
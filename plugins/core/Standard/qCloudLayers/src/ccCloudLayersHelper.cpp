@@ -3,6 +3,7 @@
 
 //CC
 #include <ccPointCloud.h>
+#include <ccChunk.h>
 #include <ccScalarField.h>
 #include <ccMainAppInterface.h>
 
@@ -10,6 +11,9 @@
 #include <QStringList>
 
 //System
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <thread>
 
 ccCloudLayersHelper::ccCloudLayersHelper(ccMainAppInterface* app)
@@ -362,6 +366,64 @@ void ccCloudLayersHelper::project(const ccGLCameraParameters& camera, unsigned s
 	}
 }
 
+bool ccCloudLayersHelper::brushPoint(unsigned index, const CCVector2& center2D, PointCoordinateType squareDist, ScalarType inputCode, ScalarType outputCode, const ccColor::Rgba& outputColor, std::map<ScalarType, int>& affected)
+{
+	const ProjectedPoint& P = m_projectedPoints[index];
+
+	// skip points outside of the frustum
+	if (!P.inFrustum)
+	{
+		return false;
+	}
+
+	// skip the points outside of the circle
+	if ((P.pos2D - center2D).norm2() > squareDist)
+	{
+		return false;
+	}
+
+	RGBAColorsTableType* colors = m_cloud->rgbaColors();
+
+	// skip invisible points
+	if (m_parameters.visiblePoints && colors->getValue(index).a != ccColor::MAX)
+	{
+		return false;
+	}
+
+	CCCoreLib::ScalarField* sf = m_cloud->getScalarField(m_scalarFieldIndex);
+	ScalarType currentCode = sf->getValue(index);
+
+	if (currentCode == outputCode)
+	{
+		// point already has the right code/class
+		return false;
+	}
+
+	// if a specific code/class was input, skip the other codes/classes
+	if (m_parameters.input && currentCode != inputCode)
+	{
+		return false;
+	}
+
+	sf->setValue(index, outputCode);
+	// we don't use setPointColor as it would trigger the update of all the colors
+	colors->setValue(index, outputColor);
+	m_modifiedColorChunks[index >> ccChunk::SIZE_POWER] = true;
+
+	// class counts
+	int code = static_cast<int>(currentCode);
+	if (code == currentCode && code >= 0 && code < static_cast<int>(m_classCountDeltas.size()))
+	{
+		--m_classCountDeltas[code];
+	}
+	else
+	{
+		// rare case (non standard code)
+		--affected[currentCode];
+	}
+	return true;
+}
+
 void ccCloudLayersHelper::mouseMove(const CCVector2& center2D, PointCoordinateType squareDist, std::map<ScalarType, int>& affected)
 {
 	if ( m_parameters.output == nullptr
@@ -372,7 +434,7 @@ void ccCloudLayersHelper::mouseMove(const CCVector2& center2D, PointCoordinateTy
 	}
 
 	CCCoreLib::ScalarField* sf = m_cloud->getScalarField(m_scalarFieldIndex);
-	if (!sf)
+	if (!sf || !m_cloud->rgbaColors())
 	{
 		return;
 	}
@@ -383,56 +445,178 @@ void ccCloudLayersHelper::mouseMove(const CCVector2& center2D, PointCoordinateTy
 	unsigned char alpha = (m_parameters.output->visible ? ccColor::MAX : 0);
 	ccColor::Rgba outputColor = ccColor::Rgba(ccColor::FromQColor(m_parameters.output->color), alpha);
 
+	static const size_t CodeCount = 256;
 	unsigned cloudSize = m_cloud->size();
-	for (unsigned i = 0; i < cloudSize; ++i)
+	try
 	{
-		// skip points outside of the frustum
-		if (!m_projectedPoints[i].inFrustum)
+		m_classCountDeltas.assign(CodeCount, 0);
+		m_modifiedColorChunks.assign(ccChunk::Count(cloudSize), false);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning(QObject::tr("Not enough memory"));
+		return;
+	}
+
+	unsigned modifiedCount = 0;
+	if (m_buckets.isValid())
+	{
+		// only test the points in the buckets overlapping the circle
+		PointCoordinateType radius = std::sqrt(squareDist);
+		int xMin = BucketIndex::ToCell(center2D.x - radius, m_buckets.origin.x, m_buckets.width);
+		int xMax = BucketIndex::ToCell(center2D.x + radius, m_buckets.origin.x, m_buckets.width);
+		int yMin = BucketIndex::ToCell(center2D.y - radius, m_buckets.origin.y, m_buckets.height);
+		int yMax = BucketIndex::ToCell(center2D.y + radius, m_buckets.origin.y, m_buckets.height);
+
+		for (int y = yMin; y <= yMax; ++y)
 		{
-			continue;
+			for (int x = xMin; x <= xMax; ++x)
+			{
+				int cellIndex = y * m_buckets.width + x;
+				for (unsigned j = m_buckets.cellStart[cellIndex]; j < m_buckets.cellStart[cellIndex + 1]; ++j)
+				{
+					if (brushPoint(m_buckets.pointIndexes[j], center2D, squareDist, inputCode, outputCode, outputColor, affected))
+					{
+						++modifiedCount;
+					}
+				}
+			}
 		}
-
-		// skip invisible points
-		if (m_parameters.visiblePoints)
+	}
+	else
+	{
+		// no index (not enough memory): test all the points
+		for (unsigned i = 0; i < cloudSize; ++i)
 		{
-			const auto& color = m_cloud->getPointColor(i);
-			if (color.a != ccColor::MAX)
+			if (brushPoint(i, center2D, squareDist, inputCode, outputCode, outputColor, affected))
 			{
-				continue;
+				++modifiedCount;
 			}
 		}
+	}
 
-		ScalarType currentCode = sf->getValue(i);
+	if (modifiedCount == 0)
+	{
+		return;
+	}
 
-		if (currentCode == outputCode)
+	// gather the class count changes
+	affected[outputCode] += static_cast<int>(modifiedCount);
+	for (size_t code = 0; code < CodeCount; ++code)
+	{
+		if (m_classCountDeltas[code] != 0)
+		{
+			affected[static_cast<ScalarType>(code)] += m_classCountDeltas[code];
+		}
+	}
+
+	// only the modified color chunks have to be updated
+	for (size_t chunkIndex = 0; chunkIndex < m_modifiedColorChunks.size(); ++chunkIndex)
+	{
+		if (m_modifiedColorChunks[chunkIndex])
 		{
-			// point already has the right code/class
-			continue;
+			size_t chunkStart = ccChunk::StartPos(chunkIndex);
+			m_cloud->colorsHaveChanged(static_cast<unsigned>(chunkStart), static_cast<unsigned>(chunkStart + ccChunk::Size(chunkIndex, cloudSize) - 1));
 		}
+	}
+
+	m_modified = true;
+
+	m_cloud->redrawDisplay();
+}
+
+bool ccCloudLayersHelper::buildBucketIndex(const ccGLCameraParameters& camera, unsigned threadCount)
+{
+	m_buckets.clear();
 
+	m_buckets.width = std::max(1, (camera.viewport[2] + BucketIndex::CellSize - 1) / BucketIndex::CellSize);
+	m_buckets.height = std::max(1, (camera.viewport[3] + BucketIndex::CellSize - 1) / BucketIndex::CellSize);
+	m_buckets.origin = CCVector2(static_cast<PointCoordinateType>(-camera.viewport[2] / 2.0), static_cast<PointCoordinateType>(-camera.viewport[3] / 2.0));
+	const size_t cellCount = static_cast<size_t>(m_buckets.width) * m_buckets.height;
 
-		// if a specific code/class was input, skip the other codes/classes
-		if (m_parameters.input && currentCode != inputCode)
+	const unsigned cloudSize = m_cloud->size();
+	const unsigned chunkSize = cloudSize / threadCount;
+
+	// per-thread bucket counts (then offsets)
+	std::vector<std::vector<unsigned>> cellCounts;
+	try
+	{
+		cellCounts.resize(threadCount, std::vector<unsigned>(cellCount, 0));
+		m_buckets.cellStart.resize(cellCount + 1, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		m_buckets.clear();
+		return false;
+	}
+
+	auto runInParallel = [&](void (*job)(ccCloudLayersHelper*, std::vector<unsigned>&, unsigned, unsigned))
+	{
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (unsigned t = 0; t < threadCount; ++t)
 		{
-			continue;
+			unsigned start = t * chunkSize;
+			unsigned end = (t + 1 == threadCount ? cloudSize : start + chunkSize);
+			threads.emplace_back(job, this, std::ref(cellCounts[t]), start, end);
 		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	};
 
-		// skip the points outside of the circle
-		if ((m_projectedPoints[i].pos2D - center2D).norm2() > squareDist)
+	// count the points in each bucket
+	runInParallel([](ccCloudLayersHelper* self, std::vector<unsigned>& counts, unsigned start, unsigned end)
+	{
+		for (unsigned i = start; i < end; ++i)
 		{
-			continue;
+			const ProjectedPoint& P = self->m_projectedPoints[i];
+			if (P.inFrustum)
+			{
+				++counts[self->m_buckets.cellIndex(P.pos2D)];
+			}
 		}
-		
-		sf->setValue(i, outputCode);
-		m_cloud->setPointColor(i, outputColor);
+	});
 
-		--affected[currentCode];
-		++affected[outputCode];
+	// convert the counts to offsets (the points of each bucket remain sorted by index)
+	unsigned pointCount = 0;
+	for (size_t c = 0; c < cellCount; ++c)
+	{
+		m_buckets.cellStart[c] = pointCount;
+		for (unsigned t = 0; t < threadCount; ++t)
+		{
+			unsigned count = cellCounts[t][c];
+			cellCounts[t][c] = pointCount;
+			pointCount += count;
+		}
+	}
+	m_buckets.cellStart[cellCount] = pointCount;
 
-		m_modified = true;
+	try
+	{
+		m_buckets.pointIndexes.resize(pointCount);
 	}
-	
-	m_cloud->redrawDisplay();
+	catch (const std::bad_alloc&)
+	{
+		m_buckets.clear();
+		return false;
+	}
+
+	// fill the buckets
+	runInParallel([](ccCloudLayersHelper* self, std::vector<unsigned>& offsets, unsigned start, unsigned end)
+	{
+		for (unsigned i = start; i < end; ++i)
+		{
+			const ProjectedPoint& P = self->m_projectedPoints[i];
+			if (P.inFrustum)
+			{
+				self->m_buckets.pointIndexes[offsets[self->m_buckets.cellIndex(P.pos2D)]++] = i;
+			}
+		}
+	});
+
+	return true;
 }
 
 bool ccCloudLayersHelper::projectCloud(const ccGLCameraParameters& camera)
@@ -483,6 +667,12 @@ bool ccCloudLayersHelper::projectCloud(const ccGLCameraParameters& camera)
 		thread = nullptr;
 	}
 
+	// index the projected points so that the brush only has to test the points below it
+	if (!buildBucketIndex(camera, processorCount))
+	{
+		ccLog::Warning(QObject::tr("Not enough memory to index the projected points (the brush will be slower)"));
+	}
+
 	return true;
 }
 
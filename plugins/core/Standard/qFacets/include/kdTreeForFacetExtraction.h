@@ -46,6 +46,22 @@ public:
 							bool closestFirst = true,
 							CCCoreLib::GenericProgressCallback* progressCb = nullptr);
 
+	//! Fuses cells (parallel version)
+	/** Same principle and same parameters as FuseCells. The properties of the cells
+		(centroid, point moments for the LS plane fitting and neighborhood) are computed
+		in parallel beforehand, and the fusion candidates are then tested concurrently.
+		The candidates are still accepted in the same order (by decreasing cell size,
+		then by increasing distance) so that the result doesn't depend on the number
+		of threads.
+	**/
+	static bool FuseCellsParallel(	ccKdTree* kdTree,
+									double maxError,
+									CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+									double maxAngle_deg,
+									PointCoordinateType overlapCoef = 1,
+									bool closestFirst = true,
+									CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
 };
 
 #endif //QFACET_KD_TREE_BASED_FACET_EXTRACTION_HEADER
@@ -19,6 +19,7 @@
 
 //CCCoreLib
 #include <GenericProgressCallback.h>
+#include <Jacobi.h>
 #include <Neighbourhood.h>
 #include <ParallelSort.h>
 
@@ -27,6 +28,13 @@
 
 //Qt
 #include <QApplication>
+#include <QThread>
+#include <QtConcurrentMap>
+
+//System
+#include <algorithm>
+#include <atomic>
+#include <numeric>
 
 //static bool AscendingLeafErrorComparison(const ccKdTree::Leaf* a, const ccKdTree::Leaf* b)
 //{
@@ -387,3 +395,546 @@ bool ccKdTreeForFacetExtraction::FuseCells(	ccKdTree* kdTree,
 
 	return !cancelled;
 }
+
+//! Sums of the point coordinates and of their products
+/** Allows to fit the LS plane of any union of cells without visiting their points.
+	Coordinates are expressed relatively to a common origin (to limit numerical errors).
+**/
+struct PlaneMoments
+{
+	unsigned count = 0;
+	double s[3] = { 0, 0, 0 };
+	double ss[6] = { 0, 0, 0, 0, 0, 0 }; //xx, xy, xz, yy, yz, zz
+
+	void add(const CCVector3d& P)
+	{
+		++count;
+		s[0] += P.x; s[1] += P.y; s[2] += P.z;
+		ss[0] += P.x * P.x; ss[1] += P.x * P.y; ss[2] += P.x * P.z;
+		ss[3] += P.y * P.y; ss[4] += P.y * P.z; ss[5] += P.z * P.z;
+	}
+
+	void add(const PlaneMoments& m)
+	{
+		count += m.count;
+		for (unsigned i = 0; i < 3; ++i)
+			s[i] += m.s[i];
+		for (unsigned i = 0; i < 6; ++i)
+			ss[i] += m.ss[i];
+	}
+
+	//! Fits the LS plane
+	/** \param[out] N plane normal (unit)
+		\param[out] G gravity center (relative to the moments origin)
+		\return mean square distance of the points to the plane (or -1 if the fit failed)
+	**/
+	double fitPlane(CCVector3d& N, CCVector3d& G) const
+	{
+		if (count < 3)
+			return -1.0;
+
+		G = CCVector3d(s[0], s[1], s[2]) / count;
+
+		CCCoreLib::SquareMatrixd cov(3);
+		cov.m_values[0][0] = ss[0] / count - G.x * G.x;
+		cov.m_values[0][1] = ss[1] / count - G.x * G.y;
+		cov.m_values[0][2] = ss[2] / count - G.x * G.z;
+		cov.m_values[1][1] = ss[3] / count - G.y * G.y;
+		cov.m_values[1][2] = ss[4] / count - G.y * G.z;
+		cov.m_values[2][2] = ss[5] / count - G.z * G.z;
+		cov.m_values[1][0] = cov.m_values[0][1];
+		cov.m_values[2][0] = cov.m_values[0][2];
+		cov.m_values[2][1] = cov.m_values[1][2];
+
+		CCCoreLib::SquareMatrixd eigVectors;
+		std::vector<double> eigValues;
+		if (!CCCoreLib::Jacobi<double>::ComputeEigenValuesAndVectors(cov, eigVectors, eigValues, true))
+			return -1.0;
+
+		//the smallest eigen vector corresponds to the LS plane normal
+		double minEigValue = 0;
+		CCCoreLib::Jacobi<double>::GetMinEigenValueAndVector(eigVectors, eigValues, minEigValue, N.u);
+		N.normalize();
+
+		//the smallest eigen value is the mean square distance to the plane
+		return std::max(0.0, minEigValue);
+	}
+};
+
+//! Cell properties (computed once, in parallel)
+struct LeafProperties
+{
+	//! Gravity center
+	CCVector3 centroid;
+	//! Largest radius (see CCCoreLib::Neighbourhood::computeLargestRadius)
+	PointCoordinateType radius = 0;
+	//! Exact distance between the gravity center and the farthest point (for pruning)
+	PointCoordinateType boundingRadius = 0;
+	//! Plane normal
+	CCVector3 normal;
+	//! Point moments
+	PlaneMoments moments;
+	//! Neighbor cells (indexes in the sorted leaves vector)
+	std::vector<unsigned> neighbors;
+};
+
+//! Set of fused cells
+struct FusedCellSet
+{
+	//! Fused cells (indexes in the sorted leaves vector)
+	std::vector<unsigned> leafIndexes;
+	//! Moments of all the fused points
+	PlaneMoments moments;
+};
+
+//! Fusion candidate
+struct FusionCandidate
+{
+	unsigned leafIndex;
+	PointCoordinateType dist;
+};
+
+//! Result of the test of a fusion candidate
+struct FusionCandidateTest
+{
+	bool tooFar = false;
+	bool notEnoughMemory = false;
+	double error = -1.0;
+};
+
+//! Computes the minimum distance between a point and a set of fused cells
+static PointCoordinateType MinDistToFusedSet(	const CCVector3& P,
+												const FusedCellSet& fusedSet,
+												const std::vector<ccKdTree::Leaf*>& leaves,
+												const std::vector<LeafProperties>& properties)
+{
+	PointCoordinateType minDist2 = -1;
+	for (unsigned leafIndex : fusedSet.leafIndexes)
+	{
+		//we skip the cells that can't be closer than the current minimum distance
+		const LeafProperties& props = properties[leafIndex];
+		PointCoordinateType lowerBound = (props.centroid - P).norm() - props.boundingRadius;
+		if (minDist2 >= 0 && lowerBound > 0 && lowerBound * lowerBound >= minDist2)
+			continue;
+
+		CCCoreLib::ReferenceCloud* points = leaves[leafIndex]->points;
+		for (unsigned j = 0; j < points->size(); ++j)
+		{
+			PointCoordinateType d2 = (*points->getPoint(j) - P).norm2();
+			if (d2 < minDist2 || minDist2 < 0)
+				minDist2 = d2;
+		}
+	}
+
+	return minDist2 > 0 ? sqrt(minDist2) : 0;
+}
+
+//! Tests the fusion of a candidate cell with a set of fused cells
+static FusionCandidateTest TestFusionCandidate(	const FusedCellSet& fusedSet,
+												unsigned candidateIndex,
+												const std::vector<ccKdTree::Leaf*>& leaves,
+												const std::vector<LeafProperties>& properties,
+												CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+												PointCoordinateType overlapCoef,
+												const CCVector3d& origin,
+												ccPointCloud* pc)
+{
+	FusionCandidateTest result;
+	const LeafProperties& candidate = properties[candidateIndex];
+
+	//if the leaf is too far
+	PointCoordinateType minDistToMainSet = MinDistToFusedSet(candidate.centroid, fusedSet, leaves, properties);
+	if (candidate.radius < minDistToMainSet / overlapCoef)
+	{
+		result.tooFar = true;
+		return result;
+	}
+
+	//fit a plane on the fused set
+	PlaneMoments moments = fusedSet.moments;
+	moments.add(candidate.moments);
+	CCVector3d N;
+	CCVector3d G;
+	double meanSquareDist = moments.fitPlane(N, G);
+	if (meanSquareDist < 0)
+	{
+		return result;
+	}
+
+	if (errorMeasure == CCCoreLib::DistanceComputationTools::RMS)
+	{
+		//no need to visit the points
+		result.error = sqrt(meanSquareDist);
+	}
+	else
+	{
+		CCCoreLib::ReferenceCloud fused(pc);
+		if (!fused.reserve(moments.count))
+		{
+			result.notEnoughMemory = true;
+			return result;
+		}
+		for (unsigned leafIndex : fusedSet.leafIndexes)
+		{
+			fused.add(*leaves[leafIndex]->points);
+		}
+		fused.add(*leaves[candidateIndex]->points);
+
+		const PointCoordinateType planeEquation[4] {	static_cast<PointCoordinateType>(N.x),
+														static_cast<PointCoordinateType>(N.y),
+														static_cast<PointCoordinateType>(N.z),
+														static_cast<PointCoordinateType>(N.dot(G + origin)) };
+		result.error = CCCoreLib::DistanceComputationTools::ComputeCloud2PlaneDistance(&fused, planeEquation, errorMeasure);
+	}
+
+	return result;
+}
+
+bool ccKdTreeForFacetExtraction::FuseCellsParallel(	ccKdTree* kdTree,
+													double maxError,
+													CCCoreLib::DistanceComputationTools::ERROR_MEASURES errorMeasure,
+													double maxAngle_deg,
+													PointCoordinateType overlapCoef/*=1*/,
+													bool closestFirst/*=true*/,
+													CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (!kdTree)
+		return false;
+
+	ccGenericPointCloud* associatedGenericCloud = kdTree->associatedGenericCloud();
+	if (!associatedGenericCloud || !associatedGenericCloud->isA(CC_TYPES::POINT_CLOUD) || maxError < 0.0)
+		return false;
+
+	//get leaves
+	std::vector<ccKdTree::Leaf*> leaves;
+	if (!kdTree->getLeaves(leaves) || leaves.empty())
+		return false;
+
+	ccPointCloud* pc = static_cast<ccPointCloud*>(associatedGenericCloud);
+	const unsigned leafCount = static_cast<unsigned>(leaves.size());
+
+	//progress notification
+	CCCoreLib::NormalizedProgress nProgress(progressCb, leafCount);
+	if (progressCb)
+	{
+		progressCb->update(0);
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Fuse Kd-tree cells");
+			progressCb->setInfo(qPrintable(QString("Cells: %1\nMax error: %2").arg(leafCount).arg(maxError)));
+		}
+		progressCb->start();
+	}
+
+	//sort cells based on their population size (we start by the biggest ones)
+	//(the sort must be stable so that the fusion order is deterministic)
+	std::stable_sort(leaves.begin(), leaves.end(), DescendingLeafSizeComparison);
+
+	std::vector<unsigned> leafIndexes(leafCount);
+	std::iota(leafIndexes.begin(), leafIndexes.end(), 0);
+
+	//common origin for the point moments
+	const CCVector3d origin = pc->getOwnBB().getCenter();
+
+	//compute the cells properties (in parallel)
+	std::vector<LeafProperties> properties;
+	try
+	{
+		properties.resize(leafCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+		return false;
+	}
+	{
+		//'userData' temporarily stores the leaf index (to retrieve the neighbors indexes)
+		for (unsigned i = 0; i < leafCount; ++i)
+		{
+			leaves[i]->userData = static_cast<int>(i);
+			//check by the way that the plane normal is unit!
+			assert(static_cast<double>(std::abs(CCVector3(leaves[i]->planeEq).norm2()) - 1.0) < 1.0e-6);
+		}
+		//the tree bounding-box is computed once and for all before the concurrent neighbors search
+		kdTree->getOwnBB();
+
+		std::atomic<bool> neighborsError{ false };
+
+		QtConcurrent::blockingMap(leafIndexes, [&](unsigned i)
+		{
+			ccKdTree::Leaf* leaf = leaves[i];
+			LeafProperties& props = properties[i];
+			assert(leaf && leaf->points);
+
+			CCCoreLib::Neighbourhood N(leaf->points);
+			props.centroid = *N.getGravityCenter();
+			props.radius = N.computeLargestRadius();
+			props.normal = CCVector3(leaf->planeEq);
+
+			PointCoordinateType maxDist2 = 0;
+			for (unsigned j = 0; j < leaf->points->size(); ++j)
+			{
+				const CCVector3* P = leaf->points->getPoint(j);
+				props.moments.add(CCVector3d::fromArray(P->u) - origin);
+				maxDist2 = std::max(maxDist2, (*P - props.centroid).norm2());
+			}
+			props.boundingRadius = sqrt(maxDist2);
+
+			ccKdTree::LeafSet neighbors;
+			if (!kdTree->getNeighborLeaves(leaf, neighbors))
+			{
+				neighborsError = true;
+				return;
+			}
+			try
+			{
+				props.neighbors.reserve(neighbors.size());
+				for (ccKdTree::Leaf* neighbor : neighbors)
+				{
+					props.neighbors.push_back(static_cast<unsigned>(neighbor->userData));
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				neighborsError = true;
+				return;
+			}
+			std::sort(props.neighbors.begin(), props.neighbors.end());
+		});
+
+		if (neighborsError)
+		{
+			ccLog::Warning("[ccKdTreeForFacetExtraction] Failed to compute the cells neighborhood (not enough memory?)");
+			return false;
+		}
+	}
+
+	// cosine of the max angle between fused 'planes'
+	const double c_minCosNormAngle = cos( CCCoreLib::DegreesToRadians( maxAngle_deg ) );
+	//below this number of fused points, testing the candidates in parallel is not worth it
+	static const unsigned c_minParallelPointCount = 4096;
+	const unsigned batchSize = static_cast<unsigned>(std::max(1, QThread::idealThreadCount()));
+
+	//fusion labels (-1 = unfused, 0 = cells already above the max error, > 0 = fused set index)
+	std::vector<int> labels(leafCount, -1);
+	//last set (label) for which each cell has been visited as a neighbor
+	std::vector<int> visitedBy(leafCount, -1);
+
+	//fuse all cells, starting from the biggest ones
+	bool cancelled = false;
+	int macroIndex = 1; //starts at 1 (0 is reserved for cells already above the max error)
+	for (unsigned seedIndex = 0; seedIndex < leafCount; ++seedIndex)
+	{
+		if (leaves[seedIndex]->error >= maxError)
+			labels[seedIndex] = 0; //0 = special group for cells already above the user defined threshold!
+
+		//already fused?
+		if (labels[seedIndex] != -1)
+		{
+			if (progressCb && !nProgress.oneStep()) //process canceled by user
+			{
+				cancelled = true;
+				break;
+			}
+			continue;
+		}
+
+		//we create a new "macro cell" index
+		const int label = macroIndex++;
+		labels[seedIndex] = label;
+		visitedBy[seedIndex] = label;
+
+		//we init the current set of 'fused' cells with the seed cell
+		FusedCellSet fusedSet;
+		fusedSet.leafIndexes.push_back(seedIndex);
+		fusedSet.moments = properties[seedIndex].moments;
+		//the centroid and the normal of the seed are not updated (otherwise the search would naturally shift along one dimension!)
+		const CCVector3 seedCentroid = properties[seedIndex].centroid;
+		const CCVector3 seedNormal = properties[seedIndex].normal;
+
+		std::vector<FusionCandidate> candidates;
+		std::vector<unsigned> cellsToTest(1, seedIndex);
+		std::vector<FusionCandidateTest> tests;
+		std::vector<unsigned> batchPositions;
+
+		if (progressCb && !nProgress.oneStep()) //process canceled by user
+		{
+			cancelled = true;
+			break;
+		}
+
+		while (!cellsToTest.empty() || !candidates.empty())
+		{
+			//add the unvisited neighbors of the 'waiting' cell(s) to the candidates
+			for (unsigned cellIndex : cellsToTest)
+			{
+				for (unsigned neighborIndex : properties[cellIndex].neighbors)
+				{
+					if (labels[neighborIndex] != -1 || visitedBy[neighborIndex] == label)
+						continue;
+					visitedBy[neighborIndex] = label;
+
+					//if the leaf orientation is too different, it will never be fused to this set
+					if (std::abs(properties[neighborIndex].normal.dot(seedNormal)) < c_minCosNormAngle)
+						continue;
+
+					candidates.push_back({ neighborIndex, (properties[neighborIndex].centroid - seedCentroid).norm2() });
+				}
+			}
+			cellsToTest.clear();
+
+			//is there remaining candidates?
+			if (candidates.empty())
+				break;
+
+			//sort candidates by their distance
+			if (closestFirst && candidates.size() > 1)
+			{
+				std::stable_sort(candidates.begin(), candidates.end(), [](const FusionCandidate& a, const FusionCandidate& b) { return a.dist < b.dist; });
+			}
+
+			//test the candidates by batches (only the first acceptable one is kept in 'closest first' mode)
+			size_t bestPos = candidates.size();
+			double bestError = -1.0;
+			unsigned skipCount = 0;
+			std::vector<bool> toRemove(candidates.size(), false);
+			const bool parallel = (fusedSet.moments.count >= c_minParallelPointCount);
+
+			for (size_t batchStart = 0; batchStart < candidates.size(); )
+			{
+				size_t batchEnd = (closestFirst ? std::min(candidates.size(), batchStart + batchSize) : candidates.size());
+
+				tests.resize(batchEnd - batchStart);
+				batchPositions.resize(tests.size());
+				std::iota(batchPositions.begin(), batchPositions.end(), 0);
+
+				auto testCandidate = [&](unsigned pos)
+				{
+					tests[pos] = TestFusionCandidate(fusedSet, candidates[batchStart + pos].leafIndex, leaves, properties, errorMeasure, overlapCoef, origin, pc);
+				};
+				if (parallel && tests.size() > 1)
+				{
+					QtConcurrent::blockingMap(batchPositions, testCandidate);
+				}
+				else
+				{
+					for (unsigned pos : batchPositions)
+						testCandidate(pos);
+				}
+
+				//process the results in order
+				for (size_t i = batchStart; i < batchEnd; ++i)
+				{
+					const FusionCandidateTest& test = tests[i - batchStart];
+					if (test.notEnoughMemory)
+					{
+						ccLog::Warning("[ccKdTreeForFacetExtraction] Not enough memory!");
+						return false;
+					}
+
+					if (test.tooFar)
+					{
+						++skipCount;
+					}
+					else if (test.error < 0.0 || test.error > maxError)
+					{
+						//candidate is rejected
+						toRemove[i] = true;
+					}
+					else if (bestError < 0.0 || test.error < bestError)
+					{
+						//otherwise we keep track of the best one!
+						bestPos = i;
+						bestError = test.error;
+						if (closestFirst)
+							break; //if we have found a good candidate, we stop here (closest first ;)
+					}
+				}
+
+				if (closestFirst && bestPos != candidates.size())
+					break;
+				batchStart = batchEnd;
+			}
+
+			//we have a (best) candidate for this pass?
+			if (bestPos != candidates.size())
+			{
+				unsigned bestIndex = candidates[bestPos].leafIndex;
+				labels[bestIndex] = label;
+				fusedSet.leafIndexes.push_back(bestIndex);
+				fusedSet.moments.add(properties[bestIndex].moments);
+
+				//we will test this cell's neighbors as well
+				cellsToTest.push_back(bestIndex);
+				//we also remove it from the candidates list
+				toRemove[bestPos] = true;
+
+				if (progressCb && !nProgress.oneStep()) //process canceled by user
+				{
+					cancelled = true;
+					break;
+				}
+				QApplication::processEvents();
+			}
+
+			//remove the rejected (and fused) candidates
+			{
+				size_t pos = 0;
+				candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](const FusionCandidate&) { return toRemove[pos++]; }), candidates.end());
+			}
+
+			if (skipCount == candidates.size() && cellsToTest.empty())
+			{
+				//only far leaves remain...
+				candidates.clear();
+			}
+
+		} //no more candidates or cells to test
+
+		if (cancelled)
+			break;
+	}
+
+	//convert fused indexes to SF
+	if (!cancelled)
+	{
+		if (!pc->enableScalarField())
+		{
+			ccLog::Error("Not enough memory");
+			return false;
+		}
+
+		std::vector<ScalarType> leafScalars(leafCount);
+		for (unsigned i = 0; i < leafCount; ++i)
+		{
+			leaves[i]->userData = labels[i];
+			leafScalars[i] = static_cast<ScalarType>(labels[i]);
+			if (labels[i] <= 0) //for unfused cells, we create new individual groups
+			{
+				leafScalars[i] = static_cast<ScalarType>(macroIndex++);
+			}
+		}
+
+		//the cells don't share any point
+		QtConcurrent::blockingMap(leafIndexes, [&](unsigned i)
+		{
+			CCCoreLib::ReferenceCloud* subset = leaves[i]->points;
+			if (subset)
+			{
+				for (unsigned j = 0; j < subset->size(); ++j)
+				{
+					subset->setPointScalarValue(j, leafScalars[i]);
+				}
+			}
+		});
+	}
+	else
+	{
+		for (unsigned i = 0; i < leafCount; ++i)
+		{
+			leaves[i]->userData = labels[i];
+		}
+	}
+
+	return !cancelled;
+}
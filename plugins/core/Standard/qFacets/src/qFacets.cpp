@@ -33,6 +33,8 @@
 #include <QSettings>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QThread>
+#include <QtConcurrentMap>
 
 //CCCoreLib
 #include <Neighbourhood.h>
@@ -49,6 +51,9 @@
 //qCC_io
 #include <ShpFilter.h>
 
+//System
+#include <atomic>
+
 
 //semi-persistent dialog values
 static unsigned s_octreeLevel = 8;
@@ -61,6 +66,7 @@ static double	s_maxEdgeLength = 1.0;
 
 static double	s_kdTreeFusionMaxAngle_deg = 20.0;
 static double	s_kdTreeFusionMaxRelativeDistance = 1.0;
+static bool		s_kdTreeParallelFusion = true;
 
 static double	s_classifAngleStep = 30.0;
 static double	s_classifMaxDist = 1.0;
@@ -222,6 +228,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	fusionDlg.maxRMSDoubleSpinBox->setValue(s_errorMaxPerFacet);
 	fusionDlg.maxAngleDoubleSpinBox->setValue(s_kdTreeFusionMaxAngle_deg);
 	fusionDlg.maxRelativeDistDoubleSpinBox->setValue(s_kdTreeFusionMaxRelativeDistance);
+	fusionDlg.parallelFusionCheckBox->setChecked(s_kdTreeParallelFusion);
 	fusionDlg.maxEdgeLengthDoubleSpinBox->setValue(s_maxEdgeLength);
 	//"no normal" warning
 	fusionDlg.noNormalWarningLabel->setVisible(!pc->hasNormals());
@@ -236,6 +243,7 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 	s_errorMaxPerFacet = fusionDlg.maxRMSDoubleSpinBox->value();
 	s_kdTreeFusionMaxAngle_deg = fusionDlg.maxAngleDoubleSpinBox->value();
 	s_kdTreeFusionMaxRelativeDistance = fusionDlg.maxRelativeDistDoubleSpinBox->value();
+	s_kdTreeParallelFusion = fusionDlg.parallelFusionCheckBox->isChecked();
 	s_maxEdgeLength = fusionDlg.maxEdgeLengthDoubleSpinBox->value();
 
 	//convert 'errorMeasureComboBox' index to enum
@@ -292,7 +300,8 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 			qint64 elapsedTime_ms = eTimer.elapsed();
 			m_app->dispToConsole(QString("[qFacets] Kd-tree construction timing: %1 s").arg(static_cast<double>(elapsedTime_ms) / 1.0e3, 0, 'f', 3), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
-			success = ccKdTreeForFacetExtraction::FuseCells(
+			eTimer.restart();
+			success = (s_kdTreeParallelFusion ? ccKdTreeForFacetExtraction::FuseCellsParallel : ccKdTreeForFacetExtraction::FuseCells)(
 				&kdtree,
 				s_errorMaxPerFacet,
 				errorMeasure,
@@ -300,6 +309,12 @@ void qFacets::extractFacets(CellsFusionDlg::Algorithm algo)
 				static_cast<PointCoordinateType>(s_kdTreeFusionMaxRelativeDistance),
 				true,
 				&pDlg);
+
+			if (success)
+			{
+				elapsedTime_ms = eTimer.elapsed();
+				m_app->dispToConsole(QString("[qFacets] Cells fusion timing: %1 s").arg(static_cast<double>(elapsedTime_ms) / 1.0e3, 0, 'f', 3), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+			}
 		}
 		else
 		{
@@ -435,91 +450,129 @@ ccHObject* qFacets::createFacets(	ccPointCloud* cloud,
 	pDlg.show();
 	QApplication::processEvents();
 
-	//for each component
+	//select the components with enough points (in the same order as before: starting from the last one)
+	struct FacetJob
+	{
+		CCCoreLib::ReferenceCloud* indexes = nullptr;
+		ccPointCloud* facetCloud = nullptr;
+		ccFacet* facet = nullptr;
+	};
+	std::vector<FacetJob> jobs;
 	error = false;
+	try
+	{
+		jobs.reserve(componentCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		error = true;
+	}
 	while (!components.empty())
 	{
 		CCCoreLib::ReferenceCloud* compIndexes = components.back();
 		components.pop_back();
 
-		//if it has enough points
-		if (compIndexes && compIndexes->size() >= minPointsPerComponent)
+		if (!error && compIndexes && compIndexes->size() >= minPointsPerComponent)
+		{
+			FacetJob job;
+			job.indexes = compIndexes;
+			jobs.push_back(job);
+		}
+		else
+		{
+			delete compIndexes;
+		}
+	}
+
+	//the facets (polygons and contours) are computed in parallel
+	std::atomic<int> processedCount{ 0 };
+	QFuture<void> future = QtConcurrent::map(jobs, [&](FacetJob& job)
+	{
+		job.facetCloud = cloud->partialClone(job.indexes);
+		if (job.facetCloud)
+		{
+			job.facet = ccFacet::Create(job.facetCloud, static_cast<PointCoordinateType>(maxEdgeLength), true);
+
+			//check the facet normal sign
+			if (job.facet && cloudHasNormal)
+			{
+				CCVector3 N = ccOctree::ComputeAverageNorm(job.indexes, cloud);
+
+				if (N.dot(job.facet->getNormal()) < 0)
+					job.facet->invertNormal();
+			}
+		}
+		++processedCount;
+	});
+
+	//wait until the process is finished!
+	while (!future.isFinished())
+	{
+		QThread::msleep(50);
+		pDlg.setValue(static_cast<int>(componentCount - jobs.size()) + processedCount);
+		QApplication::processEvents();
+	}
+
+	//for each component
+	for (FacetJob& job : jobs)
+	{
+		if (!job.facetCloud)
+		{
+			//not enough  memory!
+			error = true;
+		}
+		else if (job.facet)
 		{
-			ccPointCloud* facetCloud = cloud->partialClone(compIndexes);
-			if (!facetCloud)
+			ccFacet* facet = job.facet;
+			QString facetName = QString("facet %1 (RMS=%2)").arg(ccGroup->getChildrenNumber()).arg(facet->getRMS());
+			facet->setName(facetName);
+			if (facet->getPolygon())
 			{
-				//not enough  memory!
-				error = true;
-				delete facetCloud;
-				facetCloud = nullptr;
+				facet->getPolygon()->enableStippling(false);
+				facet->getPolygon()->showNormals(false);
 			}
-			else
+			if (facet->getContour())
 			{
-				ccFacet* facet = ccFacet::Create(facetCloud, static_cast<PointCoordinateType>(maxEdgeLength), true);
-				if (facet)
-				{
-					QString facetName = QString("facet %1 (RMS=%2)").arg(ccGroup->getChildrenNumber()).arg(facet->getRMS());
-					facet->setName(facetName);
-					if (facet->getPolygon())
-					{
-						facet->getPolygon()->enableStippling(false);
-						facet->getPolygon()->showNormals(false);
-					}
-					if (facet->getContour())
-					{
-						facet->getContour()->copyGlobalShiftAndScale(*facetCloud);
-					}
-
-					//check the facet normal sign
-					if (cloudHasNormal)
-					{
-						CCVector3 N = ccOctree::ComputeAverageNorm(compIndexes, cloud);
-
-						if (N.dot(facet->getNormal()) < 0)
-							facet->invertNormal();
-					}
+				facet->getContour()->copyGlobalShiftAndScale(*job.facetCloud);
+			}
 
 #ifdef _DEBUG
-					facet->showNormalVector(true);
+			facet->showNormalVector(true);
 #endif
 
-					//shall we colorize it with a random color?
-					ccColor::Rgb col;
-					ccColor::Rgb darkCol;
-					if (randomColors)
-					{
-						col = ccColor::Generator::Random();
-						assert(c_darkColorRatio <= 1.0);
-						darkCol.r = static_cast<ColorCompType>(static_cast<double>(col.r) * c_darkColorRatio);
-						darkCol.g = static_cast<ColorCompType>(static_cast<double>(col.g) * c_darkColorRatio);
-						darkCol.b = static_cast<ColorCompType>(static_cast<double>(col.b) * c_darkColorRatio);
-					}
-					else
-					{
-						//use normal-based HSV coloring
-						CCVector3 N = facet->getNormal();
-						PointCoordinateType dip = 0;
-						PointCoordinateType dipDir = 0;
-						ccNormalVectors::ConvertNormalToDipAndDipDir(N, dip, dipDir);
-						FacetsClassifier::GenerateSubfamilyColor(col, dip, dipDir, 0, 1, &darkCol);
-					}
-					facet->setColor(col);
-					if (facet->getContour())
-					{
-						facet->getContour()->setColor(darkCol);
-						facet->getContour()->setWidth(2);
-					}
-					ccGroup->addChild(facet);
-				}
+			//shall we colorize it with a random color?
+			ccColor::Rgb col;
+			ccColor::Rgb darkCol;
+			if (randomColors)
+			{
+				col = ccColor::Generator::Random();
+				assert(c_darkColorRatio <= 1.0);
+				darkCol.r = static_cast<ColorCompType>(static_cast<double>(col.r) * c_darkColorRatio);
+				darkCol.g = static_cast<ColorCompType>(static_cast<double>(col.g) * c_darkColorRatio);
+				darkCol.b = static_cast<ColorCompType>(static_cast<double>(col.b) * c_darkColorRatio);
 			}
-
-			delete compIndexes;
-			compIndexes = nullptr;
+			else
+			{
+				//use normal-based HSV coloring
+				CCVector3 N = facet->getNormal();
+				PointCoordinateType dip = 0;
+				PointCoordinateType dipDir = 0;
+				ccNormalVectors::ConvertNormalToDipAndDipDir(N, dip, dipDir);
+				FacetsClassifier::GenerateSubfamilyColor(col, dip, dipDir, 0, 1, &darkCol);
+			}
+			facet->setColor(col);
+			if (facet->getContour())
+			{
+				facet->getContour()->setColor(darkCol);
+				facet->getContour()->setWidth(2);
+			}
+			ccGroup->addChild(facet);
 		}
 
-		pDlg.setValue(static_cast<int>(componentCount - components.size()));
-		//QApplication::processEvents();
+		delete job.indexes;
+		job.indexes = nullptr;
 	}
+	pDlg.setValue(static_cast<int>(componentCount));
 
 	if (ccGroup->getChildrenNumber() == 0)
 	{
@@ -39,6 +39,14 @@
 #include <ccScalarField.h>
 
 //System
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #if defined(CC_WINDOWS)
 #include "Windows.h"
 #else
@@ -291,6 +299,585 @@ bool doReconstruct()
 	return true;
 }
 
+/*** TILED RECONSTRUCTION ***/
+
+//! Cloud wrapper restricted to a subset of points (the points are read on the fly, without any copy)
+template <typename Real>
+class PointSubsetWrapper : public PoissonReconLib::ICloud<Real>
+{
+public:
+	PointSubsetWrapper(const ccPointCloud& cloud, const std::vector<unsigned>& indexes)
+		: m_wrapper(cloud)
+		, m_indexes(indexes)
+	{}
+
+	virtual size_t size() const { return m_indexes.size(); }
+	virtual bool hasNormals() const { return m_wrapper.hasNormals(); }
+	virtual bool hasColors() const { return m_wrapper.hasColors(); }
+	virtual void getPoint(size_t index, Real* coords) const { m_wrapper.getPoint(m_indexes[index], coords); }
+	virtual void getNormal(size_t index, Real* coords) const { m_wrapper.getNormal(m_indexes[index], coords); }
+	virtual void getColor(size_t index, Real* rgb) const { m_wrapper.getColor(m_indexes[index], rgb); }
+
+protected:
+	PointCloudWrapper<Real> m_wrapper;
+	const std::vector<unsigned>& m_indexes;
+};
+
+//! Tiled reconstruction parameters
+struct TiledReconParameters
+{
+	//! Whether the tiled reconstruction mode is enabled
+	bool enabled = false;
+	//! Block (cube) size
+	double blockSize = 0.0;
+	//! Overlap between neighboring blocks (relative to the block size)
+	double overlapRatio = 0.1;
+	//! Number of blocks processed concurrently (the PoissonRecon calls themselves are serialized)
+	int parallelBlocks = 1;
+	//! Max memory (in MB) used by the blocks processed concurrently (0 = unlimited)
+	unsigned memoryBudget_mb = 0;
+};
+
+//! Block of a tiled reconstruction
+struct ReconBlock
+{
+	//! Block coordinates
+	int i = 0, j = 0, k = 0;
+	//! Block core (i.e. without the overlapping areas)
+	CCVector3d coreMin, coreMax;
+	//! Points of the block (including the overlapping areas)
+	std::vector<unsigned> pointIndexes;
+	//! Whether the block reconstruction succeeded
+	bool done = false;
+};
+
+//! Rough estimate of the memory used per input point by a block reconstruction (depends a lot on the octree depth)
+static const size_t s_blockBytesPerPoint = 1024;
+
+//! Tiled reconstruction context
+struct TiledReconContext
+{
+	const ccPointCloud* cloud = nullptr;
+	//! Reconstruction parameters (shared by all blocks)
+	PoissonReconLib::Parameters params;
+	//! Tiled reconstruction parameters
+	TiledReconParameters tiledParams;
+
+	//! Blocks grid
+	CCVector3d bbMin;
+	int countX = 0, countY = 0, countZ = 0;
+	std::vector<ReconBlock> blocks;
+	//! Finest cell width (same for all blocks)
+	double cellWidth = 0.0;
+
+	//! Output mesh
+	ccMesh* mesh = nullptr;
+	//! Output vertices
+	ccPointCloud* vertices = nullptr;
+	//! Output density (optional)
+	CCCoreLib::ScalarField* densitySF = nullptr;
+	//! Protects the output
+	std::mutex outputMutex;
+
+	//! Vertices close to the blocks borders (to weld the neighboring blocks meshes)
+	/** Key: quantized position (see seamKey) / Value: (vertex index, block index)
+	**/
+	std::unordered_map< uint64_t, std::vector< std::pair<unsigned, unsigned> > > seamVertices;
+
+	inline double blockSize() const { return tiledParams.blockSize; }
+	inline double seamMargin() const { return 2.0 * cellWidth; }
+	inline double weldTolerance() const { return 0.5 * cellWidth; }
+
+	//! Returns the block coordinate (along one dimension) of a given coordinate
+	inline int blockCoord(double v, double origin, int count) const
+	{
+		double c = (v - origin) / blockSize();
+		if (!(c > 0))
+			return 0;
+		return (c < count ? static_cast<int>(c) : count - 1);
+	}
+
+	//! Returns the index of the block whose core contains a given point
+	inline size_t blockIndex(const CCVector3d& P) const
+	{
+		int i = blockCoord(P.x, bbMin.x, countX);
+		int j = blockCoord(P.y, bbMin.y, countY);
+		int k = blockCoord(P.z, bbMin.z, countZ);
+		return (static_cast<size_t>(k) * countY + j) * countX + i;
+	}
+
+	//! Returns the quantized position (cell of size 'weldTolerance') of a point
+	inline void seamCell(const CCVector3d& P, int64_t cell[3]) const
+	{
+		double tol = weldTolerance();
+		cell[0] = static_cast<int64_t>(std::floor((P.x - bbMin.x) / tol));
+		cell[1] = static_cast<int64_t>(std::floor((P.y - bbMin.y) / tol));
+		cell[2] = static_cast<int64_t>(std::floor((P.z - bbMin.z) / tol));
+	}
+
+	static inline uint64_t seamKey(int64_t x, int64_t y, int64_t z)
+	{
+		return ((static_cast<uint64_t>(x) & 0x1FFFFF) << 42) | ((static_cast<uint64_t>(y) & 0x1FFFFF) << 21) | (static_cast<uint64_t>(z) & 0x1FFFFF);
+	}
+
+	//! Whether a point is close to one of the core faces of a block
+	inline bool isNearBlockBorder(const ReconBlock& block, const CCVector3d& P) const
+	{
+		double margin = seamMargin();
+		for (unsigned char d = 0; d < 3; ++d)
+		{
+			if (std::abs(P.u[d] - block.coreMin.u[d]) < margin || std::abs(P.u[d] - block.coreMax.u[d]) < margin)
+				return true;
+		}
+		return false;
+	}
+
+	//! Splits the cloud in overlapping blocks (may throw std::bad_alloc)
+	void buildBlocks()
+	{
+		CCVector3 bbMinf, bbMaxf;
+		cloud->getBoundingBox(bbMinf, bbMaxf);
+		bbMin = CCVector3d::fromArray(bbMinf.u);
+		CCVector3d diag = CCVector3d::fromArray(bbMaxf.u) - bbMin;
+
+		countX = std::max(1, static_cast<int>(std::ceil(diag.x / blockSize())));
+		countY = std::max(1, static_cast<int>(std::ceil(diag.y / blockSize())));
+		countZ = std::max(1, static_cast<int>(std::ceil(diag.z / blockSize())));
+
+		blocks.clear();
+		blocks.resize(static_cast<size_t>(countX) * countY * countZ);
+		for (int k = 0; k < countZ; ++k)
+		{
+			for (int j = 0; j < countY; ++j)
+			{
+				for (int i = 0; i < countX; ++i)
+				{
+					ReconBlock& block = blocks[(static_cast<size_t>(k) * countY + j) * countX + i];
+					block.i = i;
+					block.j = j;
+					block.k = k;
+					block.coreMin = bbMin + CCVector3d(i, j, k) * blockSize();
+					block.coreMax = block.coreMin + CCVector3d(1, 1, 1) * blockSize();
+				}
+			}
+		}
+
+		//each point is added to all the (extended) blocks that contain it
+		const double overlap = tiledParams.overlapRatio * blockSize();
+		auto forEachBlock = [&](const CCVector3* P, const std::function<void(ReconBlock&)>& f)
+		{
+			int iMin = blockCoord(P->x - overlap, bbMin.x, countX), iMax = blockCoord(P->x + overlap, bbMin.x, countX);
+			int jMin = blockCoord(P->y - overlap, bbMin.y, countY), jMax = blockCoord(P->y + overlap, bbMin.y, countY);
+			int kMin = blockCoord(P->z - overlap, bbMin.z, countZ), kMax = blockCoord(P->z + overlap, bbMin.z, countZ);
+			for (int k = kMin; k <= kMax; ++k)
+				for (int j = jMin; j <= jMax; ++j)
+					for (int i = iMin; i <= iMax; ++i)
+						f(blocks[(static_cast<size_t>(k) * countY + j) * countX + i]);
+		};
+
+		//count the points first (to avoid reallocations)
+		std::vector<size_t> blockCounts(blocks.size(), 0);
+		std::vector<bool> blockHasCorePoints(blocks.size(), false);
+		for (unsigned n = 0; n < cloud->size(); ++n)
+		{
+			const CCVector3* P = cloud->getPoint(n);
+			forEachBlock(P, [&](ReconBlock& block) { ++blockCounts[&block - blocks.data()]; });
+			blockHasCorePoints[blockIndex(CCVector3d::fromArray(P->u))] = true;
+		}
+		for (size_t b = 0; b < blocks.size(); ++b)
+		{
+			//blocks without any point in their core are skipped (their reconstruction would only produce
+			//the closing parts of the surface in the overlapping areas)
+			if (blockHasCorePoints[b])
+			{
+				blocks[b].pointIndexes.reserve(blockCounts[b]);
+			}
+			else
+			{
+				blockCounts[b] = 0;
+			}
+		}
+		for (unsigned n = 0; n < cloud->size(); ++n)
+		{
+			forEachBlock(cloud->getPoint(n), [&](ReconBlock& block)
+			{
+				if (blockCounts[&block - blocks.data()] != 0)
+				{
+					block.pointIndexes.push_back(n);
+				}
+			});
+		}
+	}
+
+	//! Trims the mesh of a block (only the triangles with their center in the block core are kept) and appends it to the output mesh
+	/** The vertices close to the block borders are welded with the ones of the neighboring blocks.
+		\return false if there's not enough memory
+	**/
+	bool appendBlockMesh(size_t blockIndex, const ccMesh& blockMesh, const ccPointCloud& blockVertices, const CCCoreLib::ScalarField* blockDensity)
+	{
+		static const unsigned c_unused = std::numeric_limits<unsigned>::max();
+		const ReconBlock& block = blocks[blockIndex];
+
+		std::vector<unsigned> vertexMap;
+		std::vector<unsigned> keptTriangles;
+		try
+		{
+			vertexMap.resize(blockVertices.size(), c_unused);
+			keptTriangles.reserve(blockMesh.size());
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+
+		unsigned keptVertexCount = 0;
+		for (unsigned t = 0; t < blockMesh.size(); ++t)
+		{
+			const CCCoreLib::VerticesIndexes* tsi = blockMesh.getTriangleVertIndexes(t);
+			CCVector3d C = (	CCVector3d::fromArray(blockVertices.getPoint(tsi->i1)->u)
+							+	CCVector3d::fromArray(blockVertices.getPoint(tsi->i2)->u)
+							+	CCVector3d::fromArray(blockVertices.getPoint(tsi->i3)->u)) / 3.0;
+			if (this->blockIndex(C) != blockIndex)
+			{
+				continue;
+			}
+			keptTriangles.push_back(t);
+			for (unsigned v : { tsi->i1, tsi->i2, tsi->i3 })
+			{
+				if (vertexMap[v] == c_unused)
+				{
+					vertexMap[v] = 0; //used
+					++keptVertexCount;
+				}
+			}
+		}
+		if (keptTriangles.empty())
+		{
+			return true;
+		}
+
+		std::lock_guard<std::mutex> lock(outputMutex);
+
+		//reserve memory (with some margin to avoid too many reallocations)
+		unsigned vertexCapacity = vertices->size() + keptVertexCount;
+		if (vertices->capacity() < vertexCapacity)
+		{
+			vertexCapacity = std::max(vertexCapacity, vertices->capacity() + vertices->capacity() / 2);
+			if (!vertices->reserve(vertexCapacity))
+			{
+				return false;
+			}
+		}
+		if (vertices->size() == 0 && blockVertices.hasColors() && !vertices->reserveTheRGBTable())
+		{
+			return false;
+		}
+		if (densitySF && densitySF->capacity() < vertexCapacity && !densitySF->reserveSafe(vertexCapacity))
+		{
+			return false;
+		}
+		unsigned triangleCapacity = mesh->size() + static_cast<unsigned>(keptTriangles.size());
+		if (mesh->capacity() < triangleCapacity)
+		{
+			triangleCapacity = std::max(triangleCapacity, mesh->capacity() + mesh->capacity() / 2);
+			if (!mesh->reserve(triangleCapacity))
+			{
+				return false;
+			}
+		}
+
+		try
+		{
+			const double tol2 = weldTolerance() * weldTolerance();
+			for (unsigned v = 0; v < vertexMap.size(); ++v)
+			{
+				if (vertexMap[v] == c_unused)
+				{
+					continue;
+				}
+
+				const CCVector3* P = blockVertices.getPoint(v);
+				CCVector3d Pd = CCVector3d::fromArray(P->u);
+				bool nearBorder = isNearBlockBorder(block, Pd);
+				int64_t cell[3];
+				if (nearBorder)
+				{
+					//look for a vertex of another block close enough
+					seamCell(Pd, cell);
+					unsigned weldIndex = c_unused;
+					double minDist2 = tol2;
+					for (int64_t dz = -1; dz <= 1; ++dz)
+						for (int64_t dy = -1; dy <= 1; ++dy)
+							for (int64_t dx = -1; dx <= 1; ++dx)
+							{
+								auto it = seamVertices.find(seamKey(cell[0] + dx, cell[1] + dy, cell[2] + dz));
+								if (it == seamVertices.end())
+									continue;
+								for (const auto& candidate : it->second)
+								{
+									if (candidate.second == blockIndex)
+										continue;
+									double dist2 = (CCVector3d::fromArray(vertices->getPoint(candidate.first)->u) - Pd).norm2d();
+									if (dist2 <= minDist2)
+									{
+										minDist2 = dist2;
+										weldIndex = candidate.first;
+									}
+								}
+							}
+
+					if (weldIndex != c_unused)
+					{
+						vertexMap[v] = weldIndex;
+						continue;
+					}
+				}
+
+				vertexMap[v] = vertices->size();
+				vertices->addPoint(*P);
+				if (vertices->hasColors())
+				{
+					vertices->addColor(blockVertices.hasColors() ? blockVertices.getPointColor(v) : ccColor::whiteRGB);
+				}
+				if (densitySF)
+				{
+					densitySF->addElement(blockDensity && v < blockDensity->size() ? blockDensity->getValue(v) : CCCoreLib::NAN_VALUE);
+				}
+
+				if (nearBorder)
+				{
+					seamVertices[seamKey(cell[0], cell[1], cell[2])].emplace_back(vertexMap[v], static_cast<unsigned>(blockIndex));
+				}
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+
+		for (unsigned t : keptTriangles)
+		{
+			const CCCoreLib::VerticesIndexes* tsi = blockMesh.getTriangleVertIndexes(t);
+			unsigned i1 = vertexMap[tsi->i1];
+			unsigned i2 = vertexMap[tsi->i2];
+			unsigned i3 = vertexMap[tsi->i3];
+			//welding may produce degenerate triangles
+			if (i1 != i2 && i2 != i3 && i3 != i1)
+			{
+				mesh->addTriangle(i1, i2, i3);
+			}
+		}
+
+		return true;
+	}
+
+	//! Serializes the calls to PoissonReconLib::Reconstruct
+	/** The PoissonRecon library relies on global state (static allocators, thread pool
+	    parameters, etc.) that is not safe to share between concurrent reconstructions.
+	    Therefore only one block is reconstructed at a time (with all the threads), and
+	    only the trimming/welding/appending of the other blocks runs concurrently.
+	**/
+	static std::mutex& ReconstructMutex()
+	{
+		static std::mutex s_mutex;
+		return s_mutex;
+	}
+
+	//! Reconstructs a single block and appends the result to the output mesh
+	bool reconstructBlock(size_t blockIndex, int threadCount)
+	{
+		ReconBlock& block = blocks[blockIndex];
+
+		PoissonReconLib::Parameters blockParams = params;
+		blockParams.threads = threadCount;
+		//same resolution for all blocks
+		blockParams.depth = 0;
+		blockParams.finestCellWidth = static_cast<float>(cellWidth);
+
+		ccPointCloud* blockVertices = new ccPointCloud("vertices");
+		ccMesh* blockMesh = new ccMesh(blockVertices);
+		blockMesh->addChild(blockVertices);
+		ccScalarField* blockDensity = (params.density ? new ccScalarField("Density") : nullptr);
+
+		bool success = false;
+		try
+		{
+			MeshWrapper<PointCoordinateType> meshWrapper(*blockMesh, *blockVertices, blockDensity);
+			PointSubsetWrapper<PointCoordinateType> cloudWrapper(*cloud, block.pointIndexes);
+
+			std::lock_guard<std::mutex> lock(ReconstructMutex());
+			success = PoissonReconLib::Reconstruct(blockParams, cloudWrapper, meshWrapper) && !meshWrapper.isInErrorState();
+		}
+		catch (const std::bad_alloc&)
+		{
+			success = false;
+		}
+
+		if (success)
+		{
+			success = appendBlockMesh(blockIndex, *blockMesh, *blockVertices, blockDensity);
+		}
+
+		if (blockDensity)
+		{
+			blockDensity->release();
+			blockDensity = nullptr;
+		}
+		delete blockMesh;
+		blockMesh = nullptr;
+
+		block.done = success;
+		return success;
+	}
+};
+
+static TiledReconParameters s_tiledParams;
+static std::atomic<unsigned> s_processedBlocks{ 0 };
+static std::atomic<unsigned> s_blockCount{ 0 };
+
+bool doTiledReconstruct()
+{
+	//invalid parameters
+	if (!s_cloud || !s_mesh || !s_meshVertices || s_tiledParams.blockSize <= 0)
+	{
+		return false;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	TiledReconContext context;
+	context.cloud = s_cloud;
+	context.params = s_params;
+	context.tiledParams = s_tiledParams;
+	context.mesh = s_mesh;
+	context.vertices = s_meshVertices;
+	context.densitySF = s_densitySF;
+
+	if (s_params.depth > 0)
+	{
+		//equivalent resolution for the whole cloud
+		CCVector3 bbMin, bbMax;
+		s_cloud->getBoundingBox(bbMin, bbMax);
+		CCVector3 diag = bbMax - bbMin;
+		context.cellWidth = std::max(std::max(diag.x, diag.y), diag.z) / static_cast<double>(1 << s_params.depth);
+	}
+	else
+	{
+		context.cellWidth = s_params.finestCellWidth;
+	}
+	if (context.cellWidth <= 0)
+	{
+		return false;
+	}
+
+	try
+	{
+		context.buildBlocks();
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[PoissonRecon] Not enough memory to split the cloud in blocks");
+		return false;
+	}
+
+	//process the biggest blocks first
+	std::vector<size_t> blockOrder;
+	for (size_t b = 0; b < context.blocks.size(); ++b)
+	{
+		if (!context.blocks[b].pointIndexes.empty())
+		{
+			blockOrder.push_back(b);
+		}
+	}
+	std::sort(blockOrder.begin(), blockOrder.end(), [&](size_t a, size_t b) { return context.blocks[a].pointIndexes.size() > context.blocks[b].pointIndexes.size(); });
+
+	s_blockCount = static_cast<unsigned>(blockOrder.size());
+	s_processedBlocks = 0;
+
+	//the reconstructions are serialized (see TiledReconContext::ReconstructMutex), so each one gets all the threads
+	const unsigned parallelBlocks = static_cast<unsigned>(std::max(1, std::min(s_tiledParams.parallelBlocks, static_cast<int>(blockOrder.size()))));
+	const size_t budgetBytes = s_tiledParams.memoryBudget_mb * (size_t(1) << 20);
+
+	ccLog::Print(QString("[PoissonRecon] Tiled reconstruction: %1 blocks (%2 x %3 x %4) - %5 block(s) in flight, reconstructed one at a time with %6 thread(s)")
+					.arg(blockOrder.size()).arg(context.countX).arg(context.countY).arg(context.countZ).arg(parallelBlocks).arg(s_params.threads));
+
+	{
+		std::mutex budgetMutex;
+		std::condition_variable budgetCondition;
+		size_t usedBytes = 0;
+		std::atomic<size_t> nextBlock{ 0 };
+
+		auto worker = [&]()
+		{
+			for (size_t n = nextBlock++; n < blockOrder.size(); n = nextBlock++)
+			{
+				size_t blockIndex = blockOrder[n];
+
+				//wait for enough memory to be available (a single block can always be processed)
+				size_t blockBytes = context.blocks[blockIndex].pointIndexes.size() * s_blockBytesPerPoint;
+				{
+					std::unique_lock<std::mutex> lock(budgetMutex);
+					budgetCondition.wait(lock, [&]() { return budgetBytes == 0 || usedBytes == 0 || usedBytes + blockBytes <= budgetBytes; });
+					usedBytes += blockBytes;
+				}
+
+				context.reconstructBlock(blockIndex, s_params.threads);
+				++s_processedBlocks;
+
+				{
+					std::lock_guard<std::mutex> lock(budgetMutex);
+					usedBytes -= blockBytes;
+				}
+				budgetCondition.notify_all();
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < parallelBlocks; ++t)
+		{
+			threads.emplace_back(worker);
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	//retry the failed blocks (e.g. by lack of memory) without any other block in flight
+	std::vector<size_t> failedBlocks;
+	for (size_t blockIndex : blockOrder)
+	{
+		if (!context.blocks[blockIndex].done)
+		{
+			failedBlocks.push_back(blockIndex);
+		}
+	}
+	if (!failedBlocks.empty() && parallelBlocks > 1)
+	{
+		ccLog::Warning(QString("[PoissonRecon] Retrying %1 failed block(s) one at a time").arg(failedBlocks.size()));
+		s_processedBlocks = s_blockCount - static_cast<unsigned>(failedBlocks.size());
+		for (size_t blockIndex : failedBlocks)
+		{
+			context.reconstructBlock(blockIndex, s_params.threads);
+			++s_processedBlocks;
+		}
+	}
+	for (size_t blockIndex : failedBlocks)
+	{
+		const ReconBlock& block = context.blocks[blockIndex];
+		if (!block.done)
+		{
+			ccLog::Warning(QString("[PoissonRecon] Failed to reconstruct block (%1, %2, %3) - %4 points: the mesh will have a hole there").arg(block.i).arg(block.j).arg(block.k).arg(block.pointIndexes.size()));
+		}
+	}
+
+	qint64 elpased_msec = timer.elapsed();
+	ccLog::Print(QString("[PoissonRecon] Duration: %1 s").arg(elpased_msec / 1000.0, 0, 'f', 1));
+
+	return s_mesh->size() != 0;
+}
+
 void qPoissonRecon::doAction()
 {
 	assert(m_app);
@@ -330,6 +917,7 @@ void qPoissonRecon::doAction()
 	if (s_defaultResolution == 0.0 || s_lastEntityID != pc->getUniqueID())
 	{
 		s_defaultResolution = pc->getOwnBB().getDiagNormd() / 200.0;
+		s_tiledParams.blockSize = pc->getOwnBB().getMaxBoxDim() / 4.0;
 		s_lastEntityID = pc->getUniqueID();
 	}
 	
@@ -350,6 +938,11 @@ void qPoissonRecon::doAction()
 	prpDlg.weightDoubleSpinBox->setValue(s_params.pointWeight);
 	prpDlg.threadSpinBox->setValue(s_params.threads);
 	prpDlg.linearFitCheckBox->setChecked(s_params.linearFit);
+	prpDlg.tiledGroupBox->setChecked(s_tiledParams.enabled);
+	prpDlg.blockSizeDoubleSpinBox->setValue(s_tiledParams.blockSize);
+	prpDlg.overlapSpinBox->setValue(static_cast<int>(s_tiledParams.overlapRatio * 100.0));
+	prpDlg.parallelBlocksSpinBox->setValue(s_tiledParams.parallelBlocks);
+	prpDlg.memoryBudgetSpinBox->setValue(static_cast<int>(s_tiledParams.memoryBudget_mb));
 	switch (s_params.boundary)
 	{
 	case PoissonReconLib::Parameters::FREE:
@@ -381,6 +974,11 @@ void qPoissonRecon::doAction()
 	s_params.pointWeight = static_cast<float>(prpDlg.weightDoubleSpinBox->value());
 	s_params.threads = prpDlg.threadSpinBox->value();
 	s_params.linearFit = prpDlg.linearFitCheckBox->isChecked();
+	s_tiledParams.enabled = prpDlg.tiledGroupBox->isChecked() && prpDlg.blockSizeDoubleSpinBox->value() > 0;
+	s_tiledParams.blockSize = prpDlg.blockSizeDoubleSpinBox->value();
+	s_tiledParams.overlapRatio = prpDlg.overlapSpinBox->value() / 100.0;
+	s_tiledParams.parallelBlocks = prpDlg.parallelBlocksSpinBox->value();
+	s_tiledParams.memoryBudget_mb = static_cast<unsigned>(prpDlg.memoryBudgetSpinBox->value());
 	switch (prpDlg.boundaryComboBox->currentIndex())
 	{
 	case 0:
@@ -427,6 +1025,8 @@ void qPoissonRecon::doAction()
 		else
 			progressLabel += QString("resolution: %1").arg(s_params.finestCellWidth);
 		progressLabel += QString(" [%1 thread(s)]").arg(s_params.threads);
+		if (s_tiledParams.enabled)
+			progressLabel += QString("\ntiled (block size: %1)").arg(s_tiledParams.blockSize);
 
 		pDlg.setLabelText(progressLabel);
 		QApplication::processEvents();
@@ -441,7 +1041,7 @@ void qPoissonRecon::doAction()
 			s_densitySF = (densitySF = new ccScalarField("Density"));
 		}
 
-		QFuture<bool> future = QtConcurrent::run(doReconstruct);
+		QFuture<bool> future = QtConcurrent::run(s_tiledParams.enabled ? doTiledReconstruct : doReconstruct);
 
 		//wait until process is finished!
 		while (!future.isFinished())
@@ -453,6 +1053,10 @@ void qPoissonRecon::doAction()
 #endif
 
 			pDlg.setValue(pDlg.value() + 1);
+			if (s_tiledParams.enabled && s_blockCount != 0)
+			{
+				pDlg.setLabelText(progressLabel + QString("\nblocks: %1/%2").arg(s_processedBlocks.load()).arg(s_blockCount.load()));
+			}
 			QApplication::processEvents();
 		}
 
@@ -482,7 +1086,7 @@ void qPoissonRecon::doAction()
 	//success message
 	m_app->dispToConsole(QString("[PoissonRecon] Job finished (%1 triangles, %2 vertices)").arg(newMesh->size()).arg(newPC->size()), ccMainAppInterface::STD_CONSOLE_MESSAGE);
 
-	newMesh->setName(QString("Mesh[%1] (level %2)").arg(pc->getName()).arg(s_params.depth));
+	newMesh->setName(QString("Mesh[%1] (level %2%3)").arg(pc->getName()).arg(s_params.depth).arg(s_tiledParams.enabled ? " - tiled" : ""));
 	newPC->setEnabled(false);
 	newMesh->setVisible(true);
 	newMesh->computeNormals(true);
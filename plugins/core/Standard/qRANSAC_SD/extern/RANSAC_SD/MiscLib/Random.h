@@ -13,8 +13,8 @@
 
 namespace MiscLib
 {
-	extern size_t rn_buf[];
-	extern size_t rn_point;
+	extern thread_local size_t rn_buf[];
+	extern thread_local size_t rn_point;
 	void rn_setseed(size_t);
 	size_t rn_refresh(void);
 	inline size_t rn_rand()
@@ -67,6 +67,10 @@ public:
 		float minTorusMajorRadius;
 		float maxTorusMinorRadius;
 		float maxTorusMajorRadius;
+		float tileSize; // horizontal (XY) tile size for tiled detection (0 = no tiling)
+		float tileOverlap; // overlap between neighboring tiles (negative = 5% of the tile size)
+		unsigned tileMemoryBudget_mb; // max memory used by the tiles processed concurrently (0 = unlimited)
+		int maxThreadCount; // max number of tiles processed concurrently (0 = all threads)
 
 		RansacParams() : epsilon(0.005f)
 			, bitmapEpsilon(0.001f)
@@ -89,6 +93,10 @@ public:
 			, minTorusMajorRadius(0)
 			, maxTorusMinorRadius(std::numeric_limits<float>::max())
 			, maxTorusMajorRadius(std::numeric_limits<float>::max())
+			, tileSize(0)
+			, tileOverlap(-1.0f)
+			, tileMemoryBudget_mb(0)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
@@ -118,6 +126,10 @@ public:
 			, minTorusMajorRadius(0)
 			, maxTorusMinorRadius(std::numeric_limits<float>::max())
 			, maxTorusMajorRadius(std::numeric_limits<float>::max())
+			, tileSize(0)
+			, tileOverlap(-1.0f)
+			, tileMemoryBudget_mb(0)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
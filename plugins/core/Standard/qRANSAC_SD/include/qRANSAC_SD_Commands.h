@@ -46,6 +46,10 @@ constexpr char OUTPUT_INDIVIDUAL_PRIMITIVES[] = "OUTPUT_INDIVIDUAL_PRIMITIVES";
 constexpr char OUTPUT_INDIVIDUAL_SUBCLOUDS[] = "OUTPUT_INDIVIDUAL_SUBCLOUDS";
 constexpr char OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE[] = "OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE";
 constexpr char OUTPUT_GROUPED[] = "OUTPUT_GROUPED";
+constexpr char TILE_SIZE[] = "TILE_SIZE";
+constexpr char TILE_OVERLAP[] = "TILE_OVERLAP";
+constexpr char TILE_MEMORY_MB[] = "TILE_MEMORY_MB";
+constexpr char MAX_THREAD_COUNT[] = "MAX_TCOUNT";
 
 constexpr char PRIM_PLANE[] = "PLANE";
 constexpr char PRIM_SPHERE[] = "SPHERE";
@@ -69,7 +73,8 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 			BITMAP_EPSILON_PERCENTAGE_OF_SCALE << BITMAP_EPSILON_ABSOLUTE <<
 			SUPPORT_POINTS << MAX_NORMAL_DEV << PROBABILITY << ENABLE_PRIMITIVE <<
 			OUT_CLOUD_DIR << OUT_MESH_DIR << OUT_GROUP_DIR << OUT_PAIR_DIR << OUT_RANDOM_COLOR << OUTPUT_INDIVIDUAL_PRIMITIVES <<
-			OUTPUT_INDIVIDUAL_SUBCLOUDS << OUTPUT_GROUPED << OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE;
+			OUTPUT_INDIVIDUAL_SUBCLOUDS << OUTPUT_GROUPED << OUTPUT_INDIVIDUAL_PAIRED_CLOUD_PRIMITIVE <<
+			TILE_SIZE << TILE_OVERLAP << TILE_MEMORY_MB << MAX_THREAD_COUNT;
 		QStringList primitiveNames = QStringList() << PRIM_PLANE << PRIM_SPHERE << PRIM_CYLINDER << PRIM_CONE << PRIM_TORUS;
 		QString outputCloudsDir;
 		QString outputMeshesDir;
@@ -253,6 +258,66 @@ struct CommandRANSAC : public ccCommandLineInterface::Command
 				{
 					outputGrouped = true;
 				}
+				else if (param == TILE_SIZE)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, TILE_SIZE));
+					}
+					bool ok;
+					float val = cmd.arguments().takeFirst().toFloat(&ok);
+					if (!ok || val < 0.0f)
+					{
+						return cmd.error("Invalid tile size (must be positive, or 0 to disable tiling)!");
+					}
+					cmd.print(QObject::tr("\tTile size: %1").arg(val));
+					params.tileSize = val;
+				}
+				else if (param == TILE_OVERLAP)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, TILE_OVERLAP));
+					}
+					bool ok;
+					float val = cmd.arguments().takeFirst().toFloat(&ok);
+					if (!ok || val < 0.0f)
+					{
+						return cmd.error("Invalid tile overlap (must be positive)!");
+					}
+					cmd.print(QObject::tr("\tTile overlap: %1").arg(val));
+					params.tileOverlap = val;
+				}
+				else if (param == TILE_MEMORY_MB)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, TILE_MEMORY_MB));
+					}
+					bool ok;
+					unsigned val = cmd.arguments().takeFirst().toUInt(&ok);
+					if (!ok)
+					{
+						return cmd.error("Invalid tiles memory budget (in MB - 0 = unlimited)!");
+					}
+					cmd.print(QObject::tr("\tTiles memory budget: %1 MB").arg(val));
+					params.tileMemoryBudget_mb = val;
+				}
+				else if (param == MAX_THREAD_COUNT)
+				{
+					if (cmd.arguments().empty())
+					{
+						return cmd.error(QObject::tr("Missing parameter: number after \"-%1 %2\"").arg(COMMAND_RANSAC, MAX_THREAD_COUNT));
+					}
+					bool ok;
+					int val = cmd.arguments().takeFirst().toInt(&ok);
+					if (!ok || val < 0)
+					{
+						return cmd.error("Invalid max thread count (0 = all)!");
+					}
+					cmd.print(QObject::tr("\tMax thread count: %1").arg(val));
+					params.maxThreadCount = val;
+				}
 				else if (param == ENABLE_PRIMITIVE)
 				{
 					if (cmd.arguments().empty())
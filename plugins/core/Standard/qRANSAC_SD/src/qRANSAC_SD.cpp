@@ -50,6 +50,7 @@
 #include <ccCylinder.h>
 #include <ccCone.h>
 #include <ccTorus.h>
+#include <ccNormalVectors.h>
 #include <ccProgressDialog.h>
 
 //CCCoreLib
@@ -58,6 +59,13 @@
 
 //System
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 #if defined(CC_WINDOWS)
 #include "windows.h"
 #else
@@ -320,6 +328,1075 @@ void qRansacSD::doAction()
 }
 
 
+//! Returns the detector options corresponding to the plugin parameters
+static RansacShapeDetector::Options GetDetectorOptions(const qRansacSD::RansacParams& params)
+{
+	RansacShapeDetector::Options ransacOptions;
+	{
+		ransacOptions.m_epsilon = params.epsilon;
+		ransacOptions.m_bitmapEpsilon = params.bitmapEpsilon;
+		ransacOptions.m_normalThresh = static_cast<float>(cos( CCCoreLib::DegreesToRadians( params.maxNormalDev_deg ) ));
+		assert(ransacOptions.m_normalThresh >= 0);
+		ransacOptions.m_probability = params.probability;
+		ransacOptions.m_minSupport = params.supportPoints;
+		ransacOptions.m_allowSimplification = params.allowSimplification;
+		ransacOptions.m_fitting = params.allowFitting ? RansacShapeDetector::Options::LS_FITTING : RansacShapeDetector::Options::NO_FITTING;
+	}
+	return ransacOptions;
+}
+
+//! Adds the constructors of the enabled primitive types to a detector
+static void AddShapeConstructors(RansacShapeDetector& detector, const qRansacSD::RansacParams& params)
+{
+	if (params.primEnabled[qRansacSD::RPT_PLANE])
+		detector.Add(new PlanePrimitiveShapeConstructor());
+	if (params.primEnabled[qRansacSD::RPT_SPHERE])
+		detector.Add(new SpherePrimitiveShapeConstructor(params.minSphereRadius, params.maxSphereRadius));
+	if (params.primEnabled[qRansacSD::RPT_CYLINDER])
+		detector.Add(new CylinderPrimitiveShapeConstructor(params.minCylinderRadius, params.maxCylinderRadius, params.maxCylinderLength));
+	if (params.primEnabled[qRansacSD::RPT_CONE])
+		detector.Add(new ConePrimitiveShapeConstructor(params.maxConeRadius, CCCoreLib::DegreesToRadians(params.maxConeAngle_deg), params.maxConeLength));
+	if (params.primEnabled[qRansacSD::RPT_TORUS])
+		detector.Add(new TorusPrimitiveShapeConstructor(false, params.minTorusMinorRadius, params.minTorusMajorRadius, params.maxTorusMinorRadius, params.maxTorusMajorRadius)); // Do not allow apple shaped torus
+}
+
+//! Converts a detected shape into a cloud (the shape points) with the corresponding CC primitive as child
+/** The shape points are cloud[shapeCloudIndex - j] for j in [0 ; shapePointsCount[.
+	\param shapeCounts number of shapes created so far (per primitive type, starting at 1 - used for naming)
+	\param error set to true if the process should be stopped (not enough memory)
+	\return the shape cloud (or nullptr if the shape couldn't be converted)
+**/
+static ccPointCloud* CreateShapeEntities(	const PrimitiveShape* shape,
+											const PointCloud& cloud,
+											size_t shapeCloudIndex,
+											unsigned shapePointsCount,
+											ccPointCloud* ccPC,
+											const qRansacSD::RansacParams& params,
+											unsigned shapeCounts[5],
+											bool& error)
+{
+	std::string desc;
+	shape->Description(&desc);
+
+	//new cloud for sub-part
+	ccPointCloud* pcShape = nullptr;
+	bool saveNormals = true;
+	{
+#ifdef POINTSWITHINDEX
+		CCCoreLib::ReferenceCloud refPcShape(ccPC);
+		//we fill cloud with sub-part points
+		if (!refPcShape.reserve(static_cast<unsigned>(shapePointsCount)))
+		{
+			ccLog::Error("[qRansacSD] Not enough memory!");
+			error = true;
+			return nullptr;
+		}
+
+		for (unsigned j = 0; j < shapePointsCount; ++j)
+		{
+			refPcShape.addPointIndex(cloud[shapeCloudIndex - j].index);
+		}
+		int warnings = 0;
+		pcShape = ccPC->partialClone(&refPcShape, &warnings);
+		if (!pcShape)
+		{
+			ccLog::Error("[qRansacSD] Not enough memory!");
+			error = true;
+			return nullptr;
+		}
+		if (warnings != 0)
+		{
+			if ((warnings & ccPointCloud::WRN_OUT_OF_MEM_FOR_NORMALS) == ccPointCloud::WRN_OUT_OF_MEM_FOR_NORMALS)
+			{
+				saveNormals = false;
+			}
+		}
+
+#else
+		pcShape = new ccPointCloud(desc.c_str());
+		if (!pcShape->reserve(static_cast<unsigned>(shapePointsCount)))
+		{
+			ccLog::Error("[qRansacSD] Not enough memory!");
+			delete pcShape;
+			error = true;
+			return nullptr;
+		}
+		saveNormals = pcShape->reserveTheNormsTable();
+
+		for (unsigned j = 0; j < shapePointsCount; ++j)
+		{
+			pcShape->addPoint(CCVector3::fromArray(cloud[shapeCloudIndex - j].pos));
+			if (saveNormals)
+			{
+				pcShape->addNorm(CCVector3::fromArray(cloud[shapeCloudIndex - j].normal));
+			}
+
+		}
+		pcShape->setGlobalShift(ccPC->getGlobalShift());
+		pcShape->setGlobalScale(ccPC->getGlobalScale());
+#endif
+	}
+	//random color
+	ccColor::Rgb col = ccColor::Generator::Random();
+	if (params.randomColor)
+	{
+		pcShape->setColor(col);
+		pcShape->showSF(false);
+		pcShape->showColors(true);
+	}
+	pcShape->showNormals(saveNormals);
+	pcShape->setVisible(true);
+
+
+	//convert detected primitive into a CC primitive type
+	ccGenericPrimitive* prim = nullptr;
+	switch (shape->Identifier())
+	{
+	case qRansacSD::RPT_PLANE: //plane
+	{
+		const PlanePrimitiveShape* plane = static_cast<const PlanePrimitiveShape*>(shape);
+		Vec3f G = plane->Internal().getPosition();
+		Vec3f N = plane->Internal().getNormal();
+		Vec3f X = plane->getXDim();
+		Vec3f Y = plane->getYDim();
+
+		//we look for real plane extents
+		float minX, maxX, minY, maxY;
+		for (unsigned j = 0; j < shapePointsCount; ++j)
+		{
+			std::pair<float, float> param;
+			plane->Parameters(cloud[shapeCloudIndex - j].pos, &param);
+			if (j != 0)
+			{
+				if (minX < param.first)
+					minX = param.first;
+				else if (maxX > param.first)
+					maxX = param.first;
+				if (minY < param.second)
+					minY = param.second;
+				else if (maxY > param.second)
+					maxY = param.second;
+			}
+			else
+			{
+				minX = maxX = param.first;
+				minY = maxY = param.second;
+			}
+		}
+
+		//we recenter plane (as it is not always the case!)
+		float dX = maxX - minX;
+		float dY = maxY - minY;
+		G += X * (minX + dX / 2);
+		G += Y * (minY + dY / 2);
+
+		//we build matrix from these vectors
+		ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
+		    CCVector3::fromArray(Y.getValue()),
+		    CCVector3::fromArray(N.getValue()),
+		    CCVector3::fromArray(G.getValue()));
+
+		//plane primitive
+		//ccLog::Print(QString("dX: %1, dY: %2").arg(dX).arg(dY));
+		prim = new ccPlane(std::abs(dX), std::abs(dY), &glMat);
+		prim->setSelectionBehavior(ccHObject::SELECTION_FIT_BBOX);
+		prim->enableStippling(true);
+		PointCoordinateType dip = 0.0f;
+		PointCoordinateType dipDir = 0.0f;
+		ccNormalVectors::ConvertNormalToDipAndDipDir(CCVector3::fromArray(N.getValue()), dip, dipDir);
+		QString dipAndDipDirStr = ccNormalVectors::ConvertDipAndDipDirToString(dip, dipDir);
+		prim->setName(dipAndDipDirStr);
+		pcShape->setName(QString("Plane_%1").arg(shapeCounts[qRansacSD::RPT_PLANE], 4, 10, QChar('0')));
+		++shapeCounts[qRansacSD::RPT_PLANE];
+	}
+	break;
+
+	case qRansacSD::RPT_SPHERE: //sphere
+	{
+		const SpherePrimitiveShape* sphere = static_cast<const SpherePrimitiveShape*>(shape);
+		float radius = sphere->Internal().Radius();
+		Vec3f CC = sphere->Internal().Center();
+
+		//we build matrix from these vecctors
+		ccGLMatrix glMat;
+		glMat.setTranslation(CC.getValue());
+		//sphere primitive
+		prim = new ccSphere(radius, &glMat);
+		prim->setEnabled(false);
+		prim->setName(QString("Sphere (r=%1)").arg(radius, 0, 'f'));
+		pcShape->setName(QString("Sphere_%1").arg(shapeCounts[qRansacSD::RPT_SPHERE], 4, 10, QChar('0')));
+		++shapeCounts[qRansacSD::RPT_SPHERE];
+	}
+	break;
+
+	case qRansacSD::RPT_CYLINDER: //cylinder
+	{
+		const CylinderPrimitiveShape* cyl = static_cast<const CylinderPrimitiveShape*>(shape);
+		Vec3f G = cyl->Internal().AxisPosition();
+		Vec3f N = cyl->Internal().AxisDirection();
+		Vec3f X = cyl->Internal().AngularDirection();
+		Vec3f Y = N.cross(X);
+		float r = cyl->Internal().Radius();
+		float hMin = cyl->MinHeight();
+		float hMax = cyl->MaxHeight();
+		float h = hMax - hMin;
+		G += N * (hMin + h / 2);
+
+		//we build matrix from these vecctors
+		ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
+		    CCVector3::fromArray(Y.getValue()),
+		    CCVector3::fromArray(N.getValue()),
+		    CCVector3::fromArray(G.getValue()));
+
+		//cylinder primitive
+		prim = new ccCylinder(r, h, &glMat);
+		prim->setEnabled(false);
+		prim->setName(QString("Cylinder (r=%1/h=%2)").arg(r, 0, 'f').arg(h, 0, 'f'));
+		pcShape->setName(QString("Cylinder_%1").arg(shapeCounts[qRansacSD::RPT_CYLINDER], 4, 10, QChar('0')));
+		++shapeCounts[qRansacSD::RPT_CYLINDER];
+	}
+	break;
+
+	case qRansacSD::RPT_CONE: //cone
+	{
+		const ConePrimitiveShape* cone = static_cast<const ConePrimitiveShape*>(shape);
+		Vec3f CC = cone->Internal().Center();
+		Vec3f CA = cone->Internal().AxisDirection();
+		float alpha_rad = cone->Internal().Angle();
+
+		//compute max height
+		Vec3f minP, maxP;
+		float minHeight, maxHeight;
+		minP = maxP = cloud[shapeCloudIndex].pos;
+		minHeight = maxHeight = cone->Internal().Height(cloud[shapeCloudIndex].pos);
+		for (size_t j = 1; j < shapePointsCount; ++j)
+		{
+			float h = cone->Internal().Height(cloud[shapeCloudIndex - j].pos);
+			if (h < minHeight)
+			{
+				minHeight = h;
+				minP = cloud[shapeCloudIndex - j].pos;
+			}
+			else if (h > maxHeight)
+			{
+				maxHeight = h;
+				maxP = cloud[shapeCloudIndex - j].pos;
+			}
+
+		}
+
+
+		float minRadius = tan(alpha_rad) * minHeight;
+		float maxRadius = tan(alpha_rad) * maxHeight;
+
+		//let's build the cone primitive
+		{
+			//the bottom should be the largest part so we inverse the axis direction
+			CCVector3 Z = -CCVector3::fromArray(CA.getValue());
+			Z.normalize();
+
+			//the center is halfway between the min and max height
+			float midHeight = (minHeight + maxHeight) / 2;
+			CCVector3 C = CCVector3::fromArray((CC + CA * midHeight).getValue());
+
+			//radial axis
+			CCVector3 X = CCVector3::fromArray((maxP - (CC + maxHeight * CA)).getValue());
+			X.normalize();
+
+			//orthogonal radial axis
+			CCVector3 Y = Z * X;
+
+			//we build the transformation matrix from these vecctors
+			ccGLMatrix glMat(X, Y, Z, C);
+
+			//eventually create the cone primitive
+			prim = new ccCone(maxRadius, minRadius, maxHeight - minHeight, 0, 0, &glMat);
+			prim->setEnabled(false);
+			prim->setName(QString("Cone (alpha=%1 deg / h=%2)").arg(CCCoreLib::RadiansToDegrees(alpha_rad), 0, 'f').arg(static_cast<double>(maxHeight) - minHeight, 0, 'f'));
+			pcShape->setName(QString("Cone_%1").arg(shapeCounts[qRansacSD::RPT_CONE], 4, 10, QChar('0')));
+			++shapeCounts[qRansacSD::RPT_CONE];
+		}
+
+	}
+	break;
+
+	case qRansacSD::RPT_TORUS: //torus
+	{
+		const TorusPrimitiveShape* torus = static_cast<const TorusPrimitiveShape*>(shape);
+		if (torus->Internal().IsAppleShaped())
+		{
+			ccLog::Warning("[qRansacSD] Apple-shaped torus are not handled by CloudCompare!");
+		}
+		else
+		{
+			Vec3f CC = torus->Internal().Center();
+			Vec3f CA = torus->Internal().AxisDirection();
+			float minRadius = torus->Internal().MinorRadius();
+			float maxRadius = torus->Internal().MajorRadius();
+
+			CCVector3 Z = CCVector3::fromArray(CA.getValue());
+			CCVector3 C = CCVector3::fromArray(CC.getValue());
+			//construct remaining of base
+			CCVector3 X = Z.orthogonal();
+			CCVector3 Y = Z * X;
+
+			//we build matrix from these vecctors
+			ccGLMatrix glMat(X, Y, Z, C);
+
+			//torus primitive
+			prim = new ccTorus(maxRadius - minRadius, maxRadius + minRadius, M_PI * 2.0, false, 0, &glMat);
+			prim->setEnabled(false);
+			prim->setName(QString("Torus (r=%1/R=%2)").arg(minRadius, 0, 'f').arg(maxRadius, 0, 'f'));
+			pcShape->setName(QString("Torus_%1").arg(shapeCounts[qRansacSD::RPT_TORUS], 4, 10, QChar('0')));
+			++shapeCounts[qRansacSD::RPT_TORUS];
+		}
+
+	}
+	break;
+	}
+
+	//is there a primitive to add to part cloud?
+	if (!prim)
+	{
+		delete pcShape;
+		return nullptr;
+	}
+
+	prim->copyGlobalShiftAndScale(*ccPC);
+	prim->applyGLTransformation_recursive();
+	pcShape->addChild(prim);
+	prim->setDisplay(pcShape->getDisplay());
+	if (params.randomColor)
+	{
+		prim->setColor(col);
+	}
+	prim->showColors(true);
+	prim->setVisible(true);
+
+	return pcShape;
+}
+
+/**** TILED DETECTION ****/
+
+typedef std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > DetectedShape;
+
+//! Rough estimate of the memory used per point by a detection (library point, octrees, bitmaps, etc.)
+static const size_t s_tileBytesPerPoint = 128;
+//! Number of points (and normals) kept per tile shape to compare it with the neighboring tiles' shapes
+static const size_t s_tileShapeSampleCount = 64;
+//! Min ratio of samples of a shape that must fit another shape for both to be considered the same
+static const double s_minSampleFitRatio = 0.8;
+//! Min ratio of shared inliers (in the common area of two tiles) for two shapes to be merged
+static const double s_minInlierOverlapRatio = 0.5;
+
+//! Horizontal (XY) tiling of a cloud (with overlapping tiles)
+struct CloudTiling
+{
+	CCVector3 bbMin, bbMax;
+	PointCoordinateType tileSize = 0;
+	PointCoordinateType overlap = 0;
+	int countX = 0, countY = 0;
+	//! Index of the first point of each tile (in 'pointIndexes' - one more element for the end)
+	std::vector<size_t> tileStart;
+	//! Points of each tile (including the overlapping areas)
+	std::vector<unsigned> pointIndexes;
+
+	inline size_t tileCount() const { return static_cast<size_t>(countX) * countY; }
+	inline size_t tilePointCount(size_t tileIndex) const { return tileStart[tileIndex + 1] - tileStart[tileIndex]; }
+
+	//! Returns the tile coordinate (along one dimension) of a given coordinate
+	inline int tileCoord(PointCoordinateType v, PointCoordinateType origin, int count) const
+	{
+		PointCoordinateType c = (v - origin) / tileSize;
+		if (!(c > 0))
+			return 0;
+		return (c < count ? static_cast<int>(c) : count - 1);
+	}
+
+	//! Whether a point belongs to the core (i.e. non overlapping) part of a tile
+	inline bool isInCore(const CCVector3& P, int tx, int ty) const
+	{
+		return tileCoord(P.x, bbMin.x, countX) == tx && tileCoord(P.y, bbMin.y, countY) == ty;
+	}
+
+	//! Returns the extended (i.e. with overlap) tile rectangle
+	inline void extendedRect(int tx, int ty, CCVector2& rMin, CCVector2& rMax) const
+	{
+		rMin = CCVector2(bbMin.x + tx * tileSize - overlap, bbMin.y + ty * tileSize - overlap);
+		rMax = CCVector2(bbMin.x + (tx + 1) * tileSize + overlap, bbMin.y + (ty + 1) * tileSize + overlap);
+	}
+
+	//! Splits the cloud in tiles (may throw std::bad_alloc)
+	void build(const ccPointCloud& cloud)
+	{
+		countX = std::max(1, static_cast<int>(std::ceil((bbMax.x - bbMin.x) / tileSize)));
+		countY = std::max(1, static_cast<int>(std::ceil((bbMax.y - bbMin.y) / tileSize)));
+		tileStart.clear();
+		tileStart.resize(tileCount() + 1, 0);
+
+		//each point is added to all the (extended) tiles that contain it
+		auto forEachTile = [&](const CCVector3& P, const std::function<void(size_t)>& f)
+		{
+			int xMin = tileCoord(P.x - overlap, bbMin.x, countX);
+			int xMax = tileCoord(P.x + overlap, bbMin.x, countX);
+			int yMin = tileCoord(P.y - overlap, bbMin.y, countY);
+			int yMax = tileCoord(P.y + overlap, bbMin.y, countY);
+			for (int ty = yMin; ty <= yMax; ++ty)
+				for (int tx = xMin; tx <= xMax; ++tx)
+					f(static_cast<size_t>(ty) * countX + tx);
+		};
+
+		unsigned pointCount = cloud.size();
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			forEachTile(*cloud.getPoint(i), [&](size_t t) { ++tileStart[t + 1]; });
+		}
+		for (size_t t = 0; t < tileCount(); ++t)
+		{
+			tileStart[t + 1] += tileStart[t];
+		}
+
+		pointIndexes.resize(tileStart.back());
+		std::vector<size_t> fillPos(tileStart.begin(), tileStart.end() - 1);
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			forEachTile(*cloud.getPoint(i), [&](size_t t) { pointIndexes[fillPos[t]++] = i; });
+		}
+	}
+};
+
+//! Shape detected in a tile
+struct TileShape
+{
+	//! Detected shape
+	MiscLib::RefCountPtr<PrimitiveShape> shape;
+	//! Tile coordinates
+	int tileX = 0, tileY = 0;
+	//! Indexes of the shape points in the input cloud (sorted)
+	std::vector<unsigned> pointIndexes;
+	//! A few points (and their normals) to compare the shape with the shapes of the neighboring tiles
+	std::vector< std::pair<Vec3f, Vec3f> > samples;
+};
+
+//! Detects the shapes in a single tile (may throw std::bad_alloc)
+/** Only the shapes with at least one point in the tile core are output (the others
+	should be detected by the neighboring tiles). If 'outputNormals' is set, the normals
+	are computed and the ones of the tile core points are stored in 'outputNormals'.
+**/
+static void DetectShapesInTile(	const ccPointCloud& ccPC,
+								const CloudTiling& tiling,
+								size_t tileIndex,
+								const qRansacSD::RansacParams& params,
+								NormsIndexesTableType* outputNormals,
+								float normalsRadius,
+								std::vector<TileShape>& tileShapes)
+{
+	const int tx = static_cast<int>(tileIndex % tiling.countX);
+	const int ty = static_cast<int>(tileIndex / tiling.countX);
+	const size_t firstPos = tiling.tileStart[tileIndex];
+	const size_t count = tiling.tilePointCount(tileIndex);
+
+	PointCloud cloud;
+	cloud.reserve(count);
+	{
+		//default point & normal
+		Point Pt;
+		Pt.normal[0] = 0.0;
+		Pt.normal[1] = 0.0;
+		Pt.normal[2] = 0.0;
+		for (size_t k = 0; k < count; ++k)
+		{
+			unsigned index = tiling.pointIndexes[firstPos + k];
+			const CCVector3* P = ccPC.getPoint(index);
+			Pt.pos[0] = static_cast<float>(P->x);
+			Pt.pos[1] = static_cast<float>(P->y);
+			Pt.pos[2] = static_cast<float>(P->z);
+			if (!outputNormals)
+			{
+				const CCVector3& N = ccPC.getPointNormal(index);
+				Pt.normal[0] = static_cast<float>(N.x);
+				Pt.normal[1] = static_cast<float>(N.y);
+				Pt.normal[2] = static_cast<float>(N.z);
+			}
+			Pt.index = index;
+			cloud.push_back(Pt);
+		}
+
+		//manually set bounding box (the tile extents)
+		CCVector2 rMin, rMax;
+		tiling.extendedRect(tx, ty, rMin, rMax);
+		Vec3f cbbMin, cbbMax;
+		cbbMin[0] = static_cast<float>(std::max(rMin.x, tiling.bbMin.x));
+		cbbMin[1] = static_cast<float>(std::max(rMin.y, tiling.bbMin.y));
+		cbbMin[2] = static_cast<float>(tiling.bbMin.z);
+		cbbMax[0] = static_cast<float>(std::min(rMax.x, tiling.bbMax.x));
+		cbbMax[1] = static_cast<float>(std::min(rMax.y, tiling.bbMax.y));
+		cbbMax[2] = static_cast<float>(tiling.bbMax.z);
+		cloud.setBBox(cbbMin, cbbMax);
+	}
+
+	if (outputNormals)
+	{
+		cloud.calcNormals(normalsRadius);
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			unsigned index = cloud[k].index;
+			if (tiling.isInCore(*ccPC.getPoint(index), tx, ty))
+			{
+				CCVector3 N = CCVector3::fromArray(cloud[k].normal);
+				//normalize the vector in case of
+				N.normalize();
+				outputNormals->setValue(index, ccNormalVectors::GetNormIndex(N));
+			}
+		}
+	}
+
+	if (count < params.supportPoints)
+	{
+		//not enough points to detect anything
+		return;
+	}
+
+	RansacShapeDetector detector(GetDetectorOptions(params));
+	AddShapeConstructors(detector, params);
+
+	MiscLib::Vector< DetectedShape > shapes;
+	detector.Detect(cloud, 0, cloud.size(), &shapes);
+
+	//the points of each shape are sorted to the end of the cloud (see executeRANSAC)
+	size_t end = cloud.size();
+	for (MiscLib::Vector<DetectedShape>::const_iterator it = shapes.begin(); it != shapes.end(); ++it)
+	{
+		size_t shapePointsCount = it->second;
+		if (shapePointsCount > end)
+		{
+			//inconsistent result
+			assert(false);
+			break;
+		}
+		size_t begin = end - shapePointsCount;
+
+		TileShape tileShape;
+		tileShape.shape = it->first;
+		tileShape.tileX = tx;
+		tileShape.tileY = ty;
+		tileShape.pointIndexes.reserve(shapePointsCount);
+		bool inCore = false;
+		for (size_t j = begin; j < end; ++j)
+		{
+			unsigned index = cloud[j].index;
+			tileShape.pointIndexes.push_back(index);
+			inCore = inCore || tiling.isInCore(*ccPC.getPoint(index), tx, ty);
+		}
+		if (inCore)
+		{
+			size_t step = std::max<size_t>(1, shapePointsCount / s_tileShapeSampleCount);
+			for (size_t j = begin; j < end; j += step)
+			{
+				tileShape.samples.emplace_back(cloud[j].pos, cloud[j].normal);
+			}
+			std::sort(tileShape.pointIndexes.begin(), tileShape.pointIndexes.end());
+			tileShapes.push_back(tileShape);
+		}
+
+		end = begin;
+	}
+}
+
+//! Runs the detection on all the tiles concurrently (under a memory budget)
+/** \return false if there's not enough memory
+**/
+static bool DetectShapesInTiles(const ccPointCloud& ccPC,
+								const CloudTiling& tiling,
+								const qRansacSD::RansacParams& params,
+								NormsIndexesTableType* outputNormals,
+								float normalsRadius,
+								std::vector<TileShape>& shapes,
+								std::atomic<size_t>& processedTiles)
+{
+	//process the biggest tiles first
+	std::vector<size_t> tileOrder;
+	tileOrder.reserve(tiling.tileCount());
+	for (size_t t = 0; t < tiling.tileCount(); ++t)
+	{
+		if (tiling.tilePointCount(t) != 0)
+		{
+			tileOrder.push_back(t);
+		}
+	}
+	std::sort(tileOrder.begin(), tileOrder.end(), [&](size_t a, size_t b) { return tiling.tilePointCount(a) > tiling.tilePointCount(b); });
+
+	std::vector< std::vector<TileShape> > shapesPerTile(tiling.tileCount());
+
+	unsigned threadCount = (params.maxThreadCount > 0 ? static_cast<unsigned>(params.maxThreadCount) : std::thread::hardware_concurrency());
+	threadCount = std::max(1u, std::min(threadCount, static_cast<unsigned>(tileOrder.size())));
+	const size_t budgetBytes = params.tileMemoryBudget_mb * (size_t(1) << 20);
+
+	std::mutex budgetMutex;
+	std::condition_variable budgetCondition;
+	size_t usedBytes = 0;
+	std::atomic<size_t> nextTile{ 0 };
+	std::atomic<bool> notEnoughMemory{ false };
+
+	auto worker = [&]()
+	{
+		while (!notEnoughMemory)
+		{
+			size_t k = nextTile++;
+			if (k >= tileOrder.size())
+			{
+				break;
+			}
+			size_t tileIndex = tileOrder[k];
+
+			//wait for enough memory to be available (a single tile can always be processed)
+			size_t tileBytes = tiling.tilePointCount(tileIndex) * s_tileBytesPerPoint;
+			{
+				std::unique_lock<std::mutex> lock(budgetMutex);
+				budgetCondition.wait(lock, [&]() { return budgetBytes == 0 || usedBytes == 0 || usedBytes + tileBytes <= budgetBytes || notEnoughMemory; });
+				usedBytes += tileBytes;
+			}
+
+			try
+			{
+				DetectShapesInTile(ccPC, tiling, tileIndex, params, outputNormals, normalsRadius, shapesPerTile[tileIndex]);
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+			++processedTiles;
+
+			{
+				std::lock_guard<std::mutex> lock(budgetMutex);
+				usedBytes -= tileBytes;
+			}
+			budgetCondition.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	if (notEnoughMemory)
+	{
+		return false;
+	}
+
+	//gather the shapes (in the tiles order)
+	for (std::vector<TileShape>& tileShapes : shapesPerTile)
+	{
+		for (TileShape& tileShape : tileShapes)
+		{
+			shapes.push_back(std::move(tileShape));
+		}
+		tileShapes.clear();
+	}
+
+	return true;
+}
+
+//! Whether two shapes (detected in two neighboring tiles) have compatible parameters
+/** The samples of each shape must fit the other shape (distance and normal deviation).
+**/
+static bool ShapeParametersMatch(const TileShape& A, const TileShape& B, float epsilon, float normalThresh)
+{
+	if (A.shape->Identifier() != B.shape->Identifier())
+	{
+		return false;
+	}
+
+	auto fits = [=](const TileShape& S, const TileShape& T)
+	{
+		size_t fitCount = 0;
+		for (const auto& sample : T.samples)
+		{
+			std::pair<float, float> dn;
+			S.shape->DistanceAndNormalDeviation(sample.first, sample.second, &dn);
+			if (dn.first <= epsilon && std::abs(dn.second) >= normalThresh)
+			{
+				++fitCount;
+			}
+		}
+		return fitCount >= s_minSampleFitRatio * T.samples.size();
+	};
+
+	return fits(A, B) && fits(B, A);
+}
+
+//! Whether two shapes (detected in two neighboring tiles) share most of their inliers in the common area of the tiles
+static bool ShapeInliersOverlap(const TileShape& A, const TileShape& B, const ccPointCloud& ccPC, const CloudTiling& tiling)
+{
+	//common area of both (extended) tiles
+	CCVector2 aMin, aMax, bMin, bMax;
+	tiling.extendedRect(A.tileX, A.tileY, aMin, aMax);
+	tiling.extendedRect(B.tileX, B.tileY, bMin, bMax);
+	CCVector2 cMin(std::max(aMin.x, bMin.x), std::max(aMin.y, bMin.y));
+	CCVector2 cMax(std::min(aMax.x, bMax.x), std::min(aMax.y, bMax.y));
+
+	auto countInCommonArea = [&](const TileShape& S)
+	{
+		size_t count = 0;
+		for (unsigned index : S.pointIndexes)
+		{
+			const CCVector3* P = ccPC.getPoint(index);
+			if (P->x >= cMin.x && P->x <= cMax.x && P->y >= cMin.y && P->y <= cMax.y)
+			{
+				++count;
+			}
+		}
+		return count;
+	};
+	size_t minCount = std::min(countInCommonArea(A), countInCommonArea(B));
+	if (minCount == 0)
+	{
+		return false;
+	}
+
+	//count the shared inliers (both lists are sorted)
+	size_t sharedCount = 0;
+	for (auto itA = A.pointIndexes.begin(), itB = B.pointIndexes.begin(); itA != A.pointIndexes.end() && itB != B.pointIndexes.end(); )
+	{
+		if (*itA < *itB)
+			++itA;
+		else if (*itB < *itA)
+			++itB;
+		else
+		{
+			++sharedCount;
+			++itA;
+			++itB;
+		}
+	}
+
+	return sharedCount >= s_minInlierOverlapRatio * minCount;
+}
+
+//! Shapes merged across the tiles borders
+struct MergedShape
+{
+	//! Representative shape (the biggest part)
+	size_t representative = 0;
+	//! Points of all the parts (sorted, without duplicates)
+	std::vector<unsigned> pointIndexes;
+};
+
+//! Merges the shapes detected in neighboring tiles (may throw std::bad_alloc)
+static void MergeTileShapes(const std::vector<TileShape>& shapes,
+							const ccPointCloud& ccPC,
+							const CloudTiling& tiling,
+							const qRansacSD::RansacParams& params,
+							std::vector<MergedShape>& mergedShapes)
+{
+	const float normalThresh = GetDetectorOptions(params).m_normalThresh;
+
+	//shapes per tile
+	std::vector< std::vector<size_t> > tileShapeIndexes(tiling.tileCount());
+	for (size_t i = 0; i < shapes.size(); ++i)
+	{
+		tileShapeIndexes[static_cast<size_t>(shapes[i].tileY) * tiling.countX + shapes[i].tileX].push_back(i);
+	}
+
+	//union-find
+	std::vector<size_t> parent(shapes.size());
+	for (size_t i = 0; i < parent.size(); ++i)
+	{
+		parent[i] = i;
+	}
+	auto findRoot = [&](size_t i)
+	{
+		while (parent[i] != i)
+		{
+			i = parent[i] = parent[parent[i]];
+		}
+		return i;
+	};
+
+	//compare the shapes of each tile with the shapes of its neighbors (each pair of tiles is tested once)
+	for (int ty = 0; ty < tiling.countY; ++ty)
+	{
+		for (int tx = 0; tx < tiling.countX; ++tx)
+		{
+			const std::vector<size_t>& currentShapes = tileShapeIndexes[static_cast<size_t>(ty) * tiling.countX + tx];
+			const int neighbors[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+			for (const auto& d : neighbors)
+			{
+				int nx = tx + d[0];
+				int ny = ty + d[1];
+				if (nx < 0 || nx >= tiling.countX || ny >= tiling.countY)
+				{
+					continue;
+				}
+				for (size_t i : currentShapes)
+				{
+					for (size_t j : tileShapeIndexes[static_cast<size_t>(ny) * tiling.countX + nx])
+					{
+						if (	findRoot(i) != findRoot(j)
+							&&	ShapeParametersMatch(shapes[i], shapes[j], params.epsilon, normalThresh)
+							&&	ShapeInliersOverlap(shapes[i], shapes[j], ccPC, tiling))
+						{
+							parent[findRoot(j)] = findRoot(i);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//gather the merged shapes
+	std::vector<size_t> mergedIndex(shapes.size(), shapes.size());
+	for (size_t i = 0; i < shapes.size(); ++i)
+	{
+		size_t root = findRoot(i);
+		if (mergedIndex[root] == shapes.size())
+		{
+			mergedIndex[root] = mergedShapes.size();
+			mergedShapes.emplace_back();
+			mergedShapes.back().representative = i;
+		}
+		MergedShape& merged = mergedShapes[mergedIndex[root]];
+		if (shapes[i].pointIndexes.size() > shapes[merged.representative].pointIndexes.size())
+		{
+			merged.representative = i;
+		}
+		size_t previousSize = merged.pointIndexes.size();
+		merged.pointIndexes.insert(merged.pointIndexes.end(), shapes[i].pointIndexes.begin(), shapes[i].pointIndexes.end());
+		std::inplace_merge(merged.pointIndexes.begin(), merged.pointIndexes.begin() + previousSize, merged.pointIndexes.end());
+		merged.pointIndexes.erase(std::unique(merged.pointIndexes.begin(), merged.pointIndexes.end()), merged.pointIndexes.end());
+	}
+}
+
+//! Tiled version of qRansacSD::executeRANSAC (see RansacParams::tileSize)
+static ccHObject* ExecuteTiledRANSAC(ccPointCloud* ccPC, const qRansacSD::RansacParams& params, bool silent)
+{
+	CloudTiling tiling;
+	ccPC->getBoundingBox(tiling.bbMin, tiling.bbMax);
+	tiling.tileSize = params.tileSize;
+	tiling.overlap = (params.tileOverlap >= 0 ? params.tileOverlap : params.tileSize / 20);
+	tiling.overlap = std::min(tiling.overlap, params.tileSize * 0.45f); //the overlapping areas must not exceed the neighboring tiles
+
+	//same radius as the non-tiled version
+	CCVector3 diag = tiling.bbMax - tiling.bbMin;
+	const float normalsRadius = 0.01f * std::max(std::max(diag.x, diag.y), diag.z);
+
+	bool computeNormals = !ccPC->hasNormals();
+	if (computeNormals && !ccPC->resizeTheNormsTable())
+	{
+		ccLog::Error("[qRansacSD] Not enough memory to compute normals!");
+		return nullptr;
+	}
+
+	//progress dialog
+	ccProgressDialog* pDlg = nullptr;
+	if (!silent)
+	{
+		pDlg = new ccProgressDialog(false, s_app ? s_app->getMainWindow() : nullptr);
+		pDlg->setWindowTitle("Ransac Shape Detection");
+		pDlg->setMethodTitle(QObject::tr("Tiled detection in progress (please wait)"));
+		pDlg->setRange(0, 0); // infinite progress
+		pDlg->show();
+	}
+
+	std::vector<TileShape> tileShapes;
+	std::vector<MergedShape> mergedShapes;
+	std::atomic<size_t> processedTiles{ 0 };
+	bool success = false;
+	QElapsedTimer eTimer;
+	eTimer.start();
+	{
+		//run in a separate thread
+		QFuture<void> future = QtConcurrent::run([&]()
+		{
+			try
+			{
+				tiling.build(*ccPC);
+				if (DetectShapesInTiles(*ccPC, tiling, params, computeNormals ? ccPC->normals() : nullptr, normalsRadius, tileShapes, processedTiles))
+				{
+					MergeTileShapes(tileShapes, *ccPC, tiling, params, mergedShapes);
+					success = true;
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				success = false;
+			}
+		});
+
+		while (!future.isFinished())
+		{
+#if defined(CC_WINDOWS)
+			::Sleep(500);
+#else
+			usleep(500 * 1000);
+#endif
+			if (!silent && pDlg)
+			{
+				pDlg->setValue(pDlg->value() + 1);
+				if (tiling.tileCount() != 0)
+				{
+					pDlg->setInfo(QObject::tr("Processed tiles: %1/%2").arg(static_cast<qulonglong>(processedTiles.load())).arg(static_cast<qulonglong>(tiling.tileCount())));
+				}
+			}
+			QApplication::processEvents();
+		}
+	}
+
+	if (pDlg)
+	{
+		pDlg->hide();
+		delete pDlg;
+		pDlg = nullptr;
+	}
+
+	if (!success)
+	{
+		ccLog::Error("[qRansacSD] Not enough memory!");
+		if (computeNormals)
+		{
+			ccPC->unallocateNorms();
+		}
+		return nullptr;
+	}
+
+	ccLog::Print("[qRANSAC] Search Timing: %2.3f s", static_cast<double>(eTimer.elapsed()) / 1.0e3);
+	ccLog::Print(QString("[qRansacSD] Tiled detection: %1 tiles (%2 x %3 - overlap: %4), %5 shapes detected, %6 after merging")
+					.arg(static_cast<qulonglong>(tiling.tileCount())).arg(tiling.countX).arg(tiling.countY).arg(tiling.overlap)
+					.arg(static_cast<qulonglong>(tileShapes.size())).arg(static_cast<qulonglong>(mergedShapes.size())));
+
+	if (computeNormals)
+	{
+		ccPC->normalsHaveChanged();
+		ccPC->showNormals(true);
+
+		//currently selected entities appearance may have changed!
+		ccPC->prepareDisplayForRefresh_recursive();
+	}
+
+	//release the tiling memory
+	tiling.pointIndexes = std::vector<unsigned>();
+
+	//each point is eventually assigned to a single shape (the biggest shapes come first)
+	std::sort(mergedShapes.begin(), mergedShapes.end(), [](const MergedShape& a, const MergedShape& b) { return a.pointIndexes.size() > b.pointIndexes.size(); });
+	std::vector<bool> assigned;
+	try
+	{
+		assigned.resize(ccPC->size(), false);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[qRansacSD] Not enough memory!");
+		return nullptr;
+	}
+
+	unsigned shapeCounts[5] = { 1, 1, 1, 1, 1 };
+	ccHObject* group = nullptr;
+	for (const MergedShape& merged : mergedShapes)
+	{
+		//temporary cloud with the (not yet assigned) points of the shape
+		PointCloud shapeCloud;
+		try
+		{
+			shapeCloud.reserve(merged.pointIndexes.size());
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Error("[qRansacSD] Not enough memory!");
+			break;
+		}
+		for (unsigned index : merged.pointIndexes)
+		{
+			if (!assigned[index])
+			{
+				const CCVector3* P = ccPC->getPoint(index);
+				Point Pt;
+				Pt.pos[0] = static_cast<float>(P->x);
+				Pt.pos[1] = static_cast<float>(P->y);
+				Pt.pos[2] = static_cast<float>(P->z);
+				const CCVector3& N = ccPC->getPointNormal(index);
+				Pt.normal[0] = static_cast<float>(N.x);
+				Pt.normal[1] = static_cast<float>(N.y);
+				Pt.normal[2] = static_cast<float>(N.z);
+				Pt.index = index;
+				shapeCloud.push_back(Pt);
+			}
+		}
+
+		if (shapeCloud.size() < params.supportPoints)
+		{
+			ccLog::Warning("[qRansacSD] Skipping shape, did not meet minimum point requirement");
+			continue;
+		}
+
+		bool error = false;
+		ccPointCloud* pcShape = CreateShapeEntities(tileShapes[merged.representative].shape, shapeCloud, shapeCloud.size() - 1, static_cast<unsigned>(shapeCloud.size()), ccPC, params, shapeCounts, error);
+		if (error)
+		{
+			break;
+		}
+		if (pcShape)
+		{
+			for (size_t j = 0; j < shapeCloud.size(); ++j)
+			{
+				assigned[shapeCloud[j].index] = true;
+			}
+			if (!group)
+			{
+				group = new ccHObject(QString("Ransac Detected Shapes (%1)").arg(ccPC->getName()));
+			}
+			group->addChild(pcShape);
+		}
+
+		QApplication::processEvents();
+	}
+
+	if (!group)
+	{
+		ccLog::Error("[qRansacSD] Segmentation failed...");
+		return nullptr;
+	}
+
+	//we hide input cloud
+	ccPC->setEnabled(false);
+	ccLog::Warning("[qRansacSD] Input cloud has been automtically hidden!");
+
+	group->setVisible(true);
+	group->setDisplay_recursive(ccPC->getDisplay());
+
+	if (params.createCloudFromLeftOverPoints)
+	{
+		//new cloud for left overs
+		CCCoreLib::ReferenceCloud refPcLO(ccPC);
+		for (unsigned i = 0; i < ccPC->size(); ++i)
+		{
+			if (!assigned[i] && !refPcLO.addPointIndex(i))
+			{
+				ccLog::Error("[qRansacSD] Not enough memory!");
+				break;
+			}
+		}
+		if (refPcLO.size() != 0)
+		{
+			ccPointCloud* pcLeftOvers = ccPC->partialClone(&refPcLO);
+			if (pcLeftOvers)
+			{
+				pcLeftOvers->setName("Leftovers");
+				group->addChild(pcLeftOvers);
+			}
+		}
+	}
+
+	return group;
+}
+
 ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& params, bool silent)
 {
 	//consistency check
@@ -344,12 +1421,16 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 	s_proba = params.probability;
 	s_createCloudFromLeftOverPoints = params.createCloudFromLeftOverPoints;
 	s_allowSimplification = params.allowSimplification;
+
+	if (params.tileSize > 0)
+	{
+		return ExecuteTiledRANSAC(ccPC, params, silent);
+	}
+
 	unsigned count = ccPC->size();
 	bool hasNorms = ccPC->hasNormals();
 	CCVector3 bbMin, bbMax;
 	ccPC->getBoundingBox(bbMin, bbMax);
-	const CCVector3d& globalShift = ccPC->getGlobalShift();
-	double globalScale = ccPC->getGlobalScale();
 	PointCloud cloud;
 	{
 		try
@@ -397,17 +1478,6 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		cloud.setBBox(cbbMin, cbbMax);
 	}
 
-	RansacShapeDetector::Options ransacOptions;
-	{
-		ransacOptions.m_epsilon = params.epsilon;
-		ransacOptions.m_bitmapEpsilon = params.bitmapEpsilon;
-		ransacOptions.m_normalThresh = static_cast<float>(cos( CCCoreLib::DegreesToRadians( params.maxNormalDev_deg ) ));
-		assert(ransacOptions.m_normalThresh >= 0);
-		ransacOptions.m_probability = params.probability;
-		ransacOptions.m_minSupport = params.supportPoints;
-		ransacOptions.m_allowSimplification = params.allowSimplification;
-		ransacOptions.m_fitting = params.allowFitting ? RansacShapeDetector::Options::LS_FITTING : RansacShapeDetector::Options::NO_FITTING;
-	}
 	const float scale = cloud.getScale();
 
 	if (!hasNorms)
@@ -457,22 +1527,11 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		}
 	}
 
-	RansacShapeDetector detector(ransacOptions); // the detector object
-
-	if (params.primEnabled[RPT_PLANE])
-		detector.Add(new PlanePrimitiveShapeConstructor());
-	if (params.primEnabled[RPT_SPHERE])
-		detector.Add(new SpherePrimitiveShapeConstructor(params.minSphereRadius, params.maxSphereRadius));
-	if (params.primEnabled[RPT_CYLINDER])
-		detector.Add(new CylinderPrimitiveShapeConstructor(params.minCylinderRadius, params.maxCylinderRadius, params.maxCylinderLength));
-	if (params.primEnabled[RPT_CONE])
-		detector.Add(new ConePrimitiveShapeConstructor(params.maxConeRadius, CCCoreLib::DegreesToRadians(params.maxConeAngle_deg), params.maxConeLength));
-	if (params.primEnabled[RPT_TORUS])
-		detector.Add(new TorusPrimitiveShapeConstructor(false, params.minTorusMinorRadius, params.minTorusMajorRadius, params.maxTorusMinorRadius, params.maxTorusMajorRadius)); // Do not allow apple shaped torus
+	RansacShapeDetector detector(GetDetectorOptions(params)); // the detector object
+	AddShapeConstructors(detector, params);
 
 
 	unsigned remaining = count;
-	typedef std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > DetectedShape;
 	MiscLib::Vector< DetectedShape > shapes; // stores the detected shapes
 
 	// run detection
@@ -534,11 +1593,11 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 	FILE* fp = fopen("RANS_SD_trace.txt", "wt");
 
 	fprintf(fp, "[Options]\n");
-	fprintf(fp, "epsilon=%f\n", ransacOptions.m_epsilon);
-	fprintf(fp, "bitmap epsilon=%f\n", ransacOptions.m_bitmapEpsilon);
-	fprintf(fp, "normal thresh=%f\n", ransacOptions.m_normalThresh);
-	fprintf(fp, "min support=%i\n", ransacOptions.m_minSupport);
-	fprintf(fp, "probability=%f\n", ransacOptions.m_probability);
+	fprintf(fp, "epsilon=%f\n", detector.GetOptions().m_epsilon);
+	fprintf(fp, "bitmap epsilon=%f\n", detector.GetOptions().m_bitmapEpsilon);
+	fprintf(fp, "normal thresh=%f\n", detector.GetOptions().m_normalThresh);
+	fprintf(fp, "min support=%i\n", detector.GetOptions().m_minSupport);
+	fprintf(fp, "probability=%f\n", detector.GetOptions().m_probability);
 
 	fprintf(fp, "\n[Statistics]\n");
 	fprintf(fp, "input points=%i\n", count);
@@ -570,11 +1629,7 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 
 	if (shapes.size() > 0)
 	{
-		unsigned planeCount = 1;
-		unsigned sphereCount = 1;
-		unsigned cylinderCount = 1;
-		unsigned coneCount = 1;
-		unsigned torusCount = 1;
+		unsigned shapeCounts[5] = { 1, 1, 1, 1, 1 };
 		ccHObject* group = nullptr;
 		for (MiscLib::Vector<DetectedShape>::const_iterator it = shapes.begin(); it != shapes.end(); ++it)
 		{
@@ -595,294 +1650,17 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 				continue;
 			}
 
-			std::string desc;
-			shape->Description(&desc);
-
 			// points to current shapes last point in cloud
-			const auto shapeCloudIndex = count - 1;
+			const size_t shapeCloudIndex = count - 1;
 
-			//new cloud for sub-part
-			ccPointCloud* pcShape = nullptr;
-			bool saveNormals = true;
+			bool error = false;
+			ccPointCloud* pcShape = CreateShapeEntities(shape, cloud, shapeCloudIndex, shapePointsCount, ccPC, params, shapeCounts, error);
+			if (error)
 			{
-#ifdef POINTSWITHINDEX
-				CCCoreLib::ReferenceCloud refPcShape(ccPC);
-				//we fill cloud with sub-part points
-				if (!refPcShape.reserve(static_cast<unsigned>(shapePointsCount)))
-				{
-					ccLog::Error("[qRansacSD] Not enough memory!");
-					break;
-				}
-
-				for (unsigned j = 0; j < shapePointsCount; ++j)
-				{
-					refPcShape.addPointIndex(cloud[shapeCloudIndex - j].index);
-				}
-				int warnings = 0;
-				pcShape = ccPC->partialClone(&refPcShape, &warnings);
-				if (warnings != 0)
-				{
-					if ((warnings & ccPointCloud::WRN_OUT_OF_MEM_FOR_NORMALS) == ccPointCloud::WRN_OUT_OF_MEM_FOR_NORMALS)
-					{
-						saveNormals = false;
-					}
-				}
-
-#else
-				pcShape = new ccPointCloud(desc.c_str());
-				if (!pcShape->reserve(static_cast<unsigned>(shapePointsCount)))
-				{
-					ccLog::Error("[qRansacSD] Not enough memory!");
-					delete pcShape;
-					break;
-				}
-				saveNormals = pcShape->reserveTheNormsTable();
-
-				for (unsigned j = 0; j < shapePointsCount; ++j)
-				{
-					pcShape->addPoint(CCVector3::fromArray(cloud[shapeCloudIndex - j].pos));
-					if (saveNormals)
-					{
-						pcShape->addNorm(CCVector3::fromArray(cloud[shapeCloudIndex - j].normal));
-					}
-
-				}
-				pcShape->setGlobalShift(globalShift);
-				pcShape->setGlobalScale(globalScale);
-#endif
-			}
-			//random color
-			ccColor::Rgb col = ccColor::Generator::Random();
-			if (params.randomColor)
-			{
-				pcShape->setColor(col);
-				pcShape->showSF(false);
-				pcShape->showColors(true);
-			}
-			pcShape->showNormals(saveNormals);
-			pcShape->setVisible(true);
-
-
-			//convert detected primitive into a CC primitive type
-			ccGenericPrimitive* prim = nullptr;
-			switch (shape->Identifier())
-			{
-			case RPT_PLANE: //plane
-			{
-				const PlanePrimitiveShape* plane = static_cast<const PlanePrimitiveShape*>(shape);
-				Vec3f G = plane->Internal().getPosition();
-				Vec3f N = plane->Internal().getNormal();
-				Vec3f X = plane->getXDim();
-				Vec3f Y = plane->getYDim();
-
-				//we look for real plane extents
-				float minX, maxX, minY, maxY;
-				for (unsigned j = 0; j < shapePointsCount; ++j)
-				{
-					std::pair<float, float> param;
-					plane->Parameters(cloud[shapeCloudIndex - j].pos, &param);
-					if (j != 0)
-					{
-						if (minX < param.first)
-							minX = param.first;
-						else if (maxX > param.first)
-							maxX = param.first;
-						if (minY < param.second)
-							minY = param.second;
-						else if (maxY > param.second)
-							maxY = param.second;
-					}
-					else
-					{
-						minX = maxX = param.first;
-						minY = maxY = param.second;
-					}
-				}
-
-				//we recenter plane (as it is not always the case!)
-				float dX = maxX - minX;
-				float dY = maxY - minY;
-				G += X * (minX + dX / 2);
-				G += Y * (minY + dY / 2);
-
-				//we build matrix from these vectors
-				ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
-				    CCVector3::fromArray(Y.getValue()),
-				    CCVector3::fromArray(N.getValue()),
-				    CCVector3::fromArray(G.getValue()));
-
-				//plane primitive
-				//ccLog::Print(QString("dX: %1, dY: %2").arg(dX).arg(dY));
-				prim = new ccPlane(std::abs(dX), std::abs(dY), &glMat);
-				prim->setSelectionBehavior(ccHObject::SELECTION_FIT_BBOX);
-				prim->enableStippling(true);
-				PointCoordinateType dip = 0.0f;
-				PointCoordinateType dipDir = 0.0f;
-				ccNormalVectors::ConvertNormalToDipAndDipDir(CCVector3::fromArray(N.getValue()), dip, dipDir);
-				QString dipAndDipDirStr = ccNormalVectors::ConvertDipAndDipDirToString(dip, dipDir);
-				prim->setName(dipAndDipDirStr);
-				pcShape->setName(QString("Plane_%1").arg(planeCount, 4, 10, QChar('0')));
-				planeCount++;
-			}
-			break;
-
-			case RPT_SPHERE: //sphere
-			{
-				const SpherePrimitiveShape* sphere = static_cast<const SpherePrimitiveShape*>(shape);
-				float radius = sphere->Internal().Radius();
-				Vec3f CC = sphere->Internal().Center();
-
-				//we build matrix from these vecctors
-				ccGLMatrix glMat;
-				glMat.setTranslation(CC.getValue());
-				//sphere primitive
-				prim = new ccSphere(radius, &glMat);
-				prim->setEnabled(false);
-				prim->setName(QString("Sphere (r=%1)").arg(radius, 0, 'f'));
-				pcShape->setName(QString("Sphere_%1").arg(sphereCount, 4, 10, QChar('0')));
-				sphereCount++;
-			}
-			break;
-
-			case RPT_CYLINDER: //cylinder
-			{
-				const CylinderPrimitiveShape* cyl = static_cast<const CylinderPrimitiveShape*>(shape);
-				Vec3f G = cyl->Internal().AxisPosition();
-				Vec3f N = cyl->Internal().AxisDirection();
-				Vec3f X = cyl->Internal().AngularDirection();
-				Vec3f Y = N.cross(X);
-				float r = cyl->Internal().Radius();
-				float hMin = cyl->MinHeight();
-				float hMax = cyl->MaxHeight();
-				float h = hMax - hMin;
-				G += N * (hMin + h / 2);
-
-				//we build matrix from these vecctors
-				ccGLMatrix glMat(CCVector3::fromArray(X.getValue()),
-				    CCVector3::fromArray(Y.getValue()),
-				    CCVector3::fromArray(N.getValue()),
-				    CCVector3::fromArray(G.getValue()));
-
-				//cylinder primitive
-				prim = new ccCylinder(r, h, &glMat);
-				prim->setEnabled(false);
-				prim->setName(QString("Cylinder (r=%1/h=%2)").arg(r, 0, 'f').arg(h, 0, 'f'));
-				pcShape->setName(QString("Cylinder_%1").arg(cylinderCount, 4, 10, QChar('0')));
-				cylinderCount++;
-			}
-			break;
-
-			case RPT_CONE: //cone
-			{
-				const ConePrimitiveShape* cone = static_cast<const ConePrimitiveShape*>(shape);
-				Vec3f CC = cone->Internal().Center();
-				Vec3f CA = cone->Internal().AxisDirection();
-				float alpha_rad = cone->Internal().Angle();
-
-				//compute max height
-				Vec3f minP, maxP;
-				float minHeight, maxHeight;
-				minP = maxP = cloud[shapeCloudIndex].pos;
-				minHeight = maxHeight = cone->Internal().Height(cloud[shapeCloudIndex].pos);
-				for (size_t j = 1; j < shapePointsCount; ++j)
-				{
-					float h = cone->Internal().Height(cloud[shapeCloudIndex - j].pos);
-					if (h < minHeight)
-					{
-						minHeight = h;
-						minP = cloud[shapeCloudIndex - j].pos;
-					}
-					else if (h > maxHeight)
-					{
-						maxHeight = h;
-						maxP = cloud[shapeCloudIndex - j].pos;
-					}
-
-				}
-
-
-				float minRadius = tan(alpha_rad) * minHeight;
-				float maxRadius = tan(alpha_rad) * maxHeight;
-
-				//let's build the cone primitive
-				{
-					//the bottom should be the largest part so we inverse the axis direction
-					CCVector3 Z = -CCVector3::fromArray(CA.getValue());
-					Z.normalize();
-
-					//the center is halfway between the min and max height
-					float midHeight = (minHeight + maxHeight) / 2;
-					CCVector3 C = CCVector3::fromArray((CC + CA * midHeight).getValue());
-
-					//radial axis
-					CCVector3 X = CCVector3::fromArray((maxP - (CC + maxHeight * CA)).getValue());
-					X.normalize();
-
-					//orthogonal radial axis
-					CCVector3 Y = Z * X;
-
-					//we build the transformation matrix from these vecctors
-					ccGLMatrix glMat(X, Y, Z, C);
-
-					//eventually create the cone primitive
-					prim = new ccCone(maxRadius, minRadius, maxHeight - minHeight, 0, 0, &glMat);
-					prim->setEnabled(false);
-					prim->setName(QString("Cone (alpha=%1 deg / h=%2)").arg(CCCoreLib::RadiansToDegrees(alpha_rad), 0, 'f').arg(static_cast<double>(maxHeight) - minHeight, 0, 'f'));
-					pcShape->setName(QString("Cone_%1").arg(coneCount, 4, 10, QChar('0')));
-					coneCount++;
-				}
-
-			}
-			break;
-
-			case RPT_TORUS: //torus
-			{
-				const TorusPrimitiveShape* torus = static_cast<const TorusPrimitiveShape*>(shape);
-				if (torus->Internal().IsAppleShaped())
-				{
-					ccLog::Warning("[qRansacSD] Apple-shaped torus are not handled by CloudCompare!");
-				}
-				else
-				{
-					Vec3f CC = torus->Internal().Center();
-					Vec3f CA = torus->Internal().AxisDirection();
-					float minRadius = torus->Internal().MinorRadius();
-					float maxRadius = torus->Internal().MajorRadius();
-
-					CCVector3 Z = CCVector3::fromArray(CA.getValue());
-					CCVector3 C = CCVector3::fromArray(CC.getValue());
-					//construct remaining of base
-					CCVector3 X = Z.orthogonal();
-					CCVector3 Y = Z * X;
-
-					//we build matrix from these vecctors
-					ccGLMatrix glMat(X, Y, Z, C);
-
-					//torus primitive
-					prim = new ccTorus(maxRadius - minRadius, maxRadius + minRadius, M_PI * 2.0, false, 0, &glMat);
-					prim->setEnabled(false);
-					prim->setName(QString("Torus (r=%1/R=%2)").arg(minRadius, 0, 'f').arg(maxRadius, 0, 'f'));
-					pcShape->setName(QString("Torus_%1").arg(torusCount, 4, 10, QChar('0')));
-					torusCount++;
-				}
-
-			}
-			break;
+				break;
 			}
-
-			//is there a primitive to add to part cloud?
-			if (prim)
+			if (pcShape)
 			{
-				prim->copyGlobalShiftAndScale(*ccPC);
-				prim->applyGLTransformation_recursive();
-				pcShape->addChild(prim);
-				prim->setDisplay(pcShape->getDisplay());
-				if (params.randomColor)
-				{
-					prim->setColor(col);
-				}
-				prim->showColors(true);
-				prim->setVisible(true);
 				if (!group)
 				{
 					group = new ccHObject(QString("Ransac Detected Shapes (%1)").arg(ccPC->getName()));
@@ -890,7 +1668,6 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 				group->addChild(pcShape);
 			}
 
-
 			count -= shapePointsCount;
 
 			QApplication::processEvents();
@@ -123,6 +123,16 @@ public:
 									bool storeRadiiAsSF = false,
 									ccMainAppInterface* app = nullptr);
 
+	//! Computes radial distance between several clouds and the same profile
+	/** The profile lookup table is only built once. The clouds are processed
+		one after the other (and the points of each cloud in parallel).
+		\return false if one of the clouds couldn't be processed (or if the process was cancelled)
+	**/
+	static bool ComputeRadialDist(	const std::vector<ccPointCloud*>& clouds,
+									ccPolyline* profile,
+									bool storeRadiiAsSF = false,
+									ccMainAppInterface* app = nullptr);
+
 	//! "Distance" map cell
 	struct MapCell
 	{
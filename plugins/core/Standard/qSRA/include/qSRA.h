@@ -57,8 +57,8 @@ protected:
 	//! Projects the cloud distances into a 2D grid (needs the revolution profile)
 	void doProjectCloudDistsInGrid(ccPointCloud* cloud, ccPolyline* polyline) const;
 
-	//! Computes cloud-to-profile radial distances
-	bool doComputeRadialDists(ccPointCloud* cloud, ccPolyline* polyline) const;
+	//! Computes cloud-to-profile radial distances (for one or several clouds)
+	bool doComputeRadialDists(const std::vector<ccPointCloud*>& clouds, ccPolyline* polyline) const;
 
 	//! Associated action
 	QAction* m_doLoadProfile;
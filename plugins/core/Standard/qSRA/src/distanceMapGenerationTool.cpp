@@ -35,6 +35,13 @@
 #include <QFile>
 #include <QTextStream>
 #include <QMainWindow>
+#include <QThread>
+#include <QtConcurrentMap>
+
+//system
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 //Meta-data key for profile (polyline) origin
 const char PROFILE_ORIGIN_KEY[] = "ProfileOrigin";
@@ -237,6 +244,193 @@ bool DistanceMapGenerationTool::GetPoylineMetaData(const ccPolyline* polyline, P
 	return true;
 }
 
+//! Number of points processed by each parallel task
+static const unsigned s_pointsPerTask = 65536;
+
+//helper: returns the starting index of each parallel task
+static std::vector<unsigned> GetTaskStarts(unsigned count)
+{
+	std::vector<unsigned> taskStarts;
+	taskStarts.reserve(count / s_pointsPerTask + 1);
+	for (unsigned start = 0; start < count; start += s_pointsPerTask)
+	{
+		taskStarts.push_back(start);
+	}
+	return taskStarts;
+}
+
+//! Profile lookup table (height --> facing segments)
+/** The profile segments (polyline: X = radius, Y = height) are binned by height,
+	so that only the few segments that may face a given height are tested. The
+	results are the same as when testing all the segments (in the same order).
+**/
+class ProfileLookup
+{
+public:
+
+	//! Builds the table (may throw std::bad_alloc)
+	void init(const CCCoreLib::GenericIndexedCloudPersist* vertices)
+	{
+		unsigned vertexCount = vertices->size();
+		m_vertices.resize(vertexCount);
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			const CCVector3* P = vertices->getPoint(i);
+			m_vertices[i] = CCVector2(P->x, P->y);
+		}
+
+		m_hMin = m_hMax = (vertexCount ? m_vertices.front().y : 0.0);
+		for (const CCVector2& V : m_vertices)
+		{
+			m_hMin = std::min<double>(m_hMin, V.y);
+			m_hMax = std::max<double>(m_hMax, V.y);
+		}
+
+		unsigned segmentCount = (vertexCount > 1 ? vertexCount - 1 : 0);
+		m_binCount = std::max(1u, std::min(2 * segmentCount, 65536u));
+		m_binSize = (m_hMax - m_hMin) / m_binCount;
+		if (!(m_binSize > 0))
+		{
+			m_binCount = 1;
+			m_binSize = 1.0;
+		}
+
+		//count the segments per bin
+		m_binStart.clear();
+		m_binStart.resize(m_binCount + 1, 0);
+		for (unsigned j = 1; j < vertexCount; ++j)
+		{
+			unsigned b0 = 0, b1 = 0;
+			segmentBins(j, b0, b1);
+			for (unsigned b = b0; b <= b1; ++b)
+				++m_binStart[b + 1];
+		}
+		for (unsigned b = 0; b < m_binCount; ++b)
+		{
+			m_binStart[b + 1] += m_binStart[b];
+		}
+
+		//fill the bins (the segments remain sorted)
+		m_binSegments.resize(m_binStart.back());
+		std::vector<unsigned> fillPos(m_binStart.begin(), m_binStart.end() - 1);
+		for (unsigned j = 1; j < vertexCount; ++j)
+		{
+			unsigned b0 = 0, b1 = 0;
+			segmentBins(j, b0, b1);
+			for (unsigned b = b0; b <= b1; ++b)
+				m_binSegments[fillPos[b]++] = j;
+		}
+	}
+
+	//! Returns the distance between a point and the closest profile segment facing it (or NaN if none)
+	/** See ComputeRadialDist.
+	**/
+	inline ScalarType radialDist(double height, double radius) const
+	{
+		ScalarType minDist = CCCoreLib::NAN_VALUE;
+
+		unsigned begin = 0, end = 0;
+		if (!candidates(height, begin, end))
+		{
+			return minDist;
+		}
+
+		for (unsigned k = begin; k < end; ++k)
+		{
+			const CCVector2& A = m_vertices[m_binSegments[k] - 1];
+			const CCVector2& B = m_vertices[m_binSegments[k]];
+
+			double alpha = (height - A.y) / (B.y - A.y);
+			if (alpha >= 0.0 && alpha <= 1.0)
+			{
+				//we deduce the right radius by linear interpolation
+				double radius_th = A.x + alpha * (B.x - A.x);
+				double dist = radius - radius_th;
+
+				//we look at the closest segment (if the polyline is concave!)
+				if (	!CCCoreLib::ScalarField::ValidValue(minDist)
+					||	(dist * dist) < (static_cast<double>(minDist) * minDist))
+				{
+					minDist = static_cast<ScalarType>(dist);
+				}
+			}
+		}
+
+		return minDist;
+	}
+
+	//! Returns the first profile segment facing a given height
+	/** \return the index of the segment end vertex (or 0 if none)
+	**/
+	inline unsigned firstFacingSegment(double height) const
+	{
+		unsigned begin = 0, end = 0;
+		if (candidates(height, begin, end))
+		{
+			for (unsigned k = begin; k < end; ++k)
+			{
+				const CCVector2& A = m_vertices[m_binSegments[k] - 1];
+				const CCVector2& B = m_vertices[m_binSegments[k]];
+
+				double alpha = (height - A.y) / (B.y - A.y);
+				if (alpha >= 0.0 && alpha <= 1.0)
+				{
+					return m_binSegments[k];
+				}
+			}
+		}
+		return 0;
+	}
+
+	//! Returns a profile vertex (X = radius, Y = height)
+	inline const CCVector2& vertex(unsigned index) const { return m_vertices[index]; }
+
+protected:
+
+	inline unsigned bin(double height) const
+	{
+		double b = (height - m_hMin) / m_binSize;
+		if (!(b > 0))
+			return 0;
+		return (b < m_binCount ? static_cast<unsigned>(b) : m_binCount - 1);
+	}
+
+	//! Returns the bins a segment may face
+	/** One more bin is taken on each side, as the segment extents are slightly
+		enlarged by the rounding errors when computing the interpolation factor.
+	**/
+	inline void segmentBins(unsigned j, unsigned& b0, unsigned& b1) const
+	{
+		b0 = bin(std::min(m_vertices[j - 1].y, m_vertices[j].y));
+		b1 = bin(std::max(m_vertices[j - 1].y, m_vertices[j].y));
+		if (b0 > 0)
+			--b0;
+		if (b1 + 1 < m_binCount)
+			++b1;
+	}
+
+	inline bool candidates(double height, unsigned& begin, unsigned& end) const
+	{
+		if (!(height >= m_hMin - m_binSize && height <= m_hMax + m_binSize))
+		{
+			//no segment can face this height
+			return false;
+		}
+		unsigned b = bin(height);
+		begin = m_binStart[b];
+		end = m_binStart[b + 1];
+		return true;
+	}
+
+	std::vector<CCVector2> m_vertices;
+	double m_hMin = 0.0;
+	double m_hMax = 0.0;
+	unsigned m_binCount = 1;
+	double m_binSize = 1.0;
+	std::vector<unsigned> m_binStart;
+	std::vector<unsigned> m_binSegments;
+};
+
 bool DistanceMapGenerationTool::ComputeRadialDist(	ccPointCloud* cloud,
 													ccPolyline* profile,
 													bool storeRadiiAsSF/*=false*/,
@@ -249,7 +443,22 @@ bool DistanceMapGenerationTool::ComputeRadialDist(	ccPointCloud* cloud,
 			app->dispToConsole(QString("Internal error: invalid input parameters"), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
 		return false;
 	}
-	assert(cloud && profile);
+
+	return ComputeRadialDist(std::vector<ccPointCloud*>{ cloud }, profile, storeRadiiAsSF, app);
+}
+
+bool DistanceMapGenerationTool::ComputeRadialDist(	const std::vector<ccPointCloud*>& clouds,
+													ccPolyline* profile,
+													bool storeRadiiAsSF/*=false*/,
+													ccMainAppInterface* app/*=nullptr*/)
+{
+	//check input clouds and profile/polyline
+	if (clouds.empty() || !profile || std::find(clouds.begin(), clouds.end(), nullptr) != clouds.end())
+	{
+		if (app)
+			app->dispToConsole(QString("Internal error: invalid input parameters"), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+		return false;
+	}
 
 	//number of vertices for the profile
 	CCCoreLib::GenericIndexedCloudPersist* vertices = profile->getAssociatedCloud();
@@ -270,121 +479,133 @@ bool DistanceMapGenerationTool::ComputeRadialDist(	ccPointCloud* cloud,
 		return false;
 	}
 
-	//reserve a new scalar field (or take the old one if it already exists)
-	int sfIdx = cloud->getScalarFieldIndexByName(RADIAL_DIST_SF_NAME);
-	if (sfIdx < 0)
-		sfIdx = cloud->addScalarField(RADIAL_DIST_SF_NAME);
-	if (sfIdx < 0)
+	//the profile lookup table is shared by all the clouds
+	ProfileLookup lookup;
+	try
+	{
+		lookup.init(vertices);
+	}
+	catch (const std::bad_alloc&)
 	{
 		if (app)
-			app->dispToConsole(QString("Failed to allocate a new scalar field for computing distances! Try to free some memory ..."), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			app->dispToConsole(QString("Not enough memory!"), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
 		return false;
 	}
-	ccScalarField* sf = static_cast<ccScalarField*>(cloud->getScalarField(sfIdx));
-	unsigned pointCount = cloud->size();
-	sf->resizeSafe(pointCount); //should always be ok
-	assert(sf);
 
-	ccScalarField* radiiSf = nullptr;
-	if (storeRadiiAsSF)
-	{
-		int sfIdxRadii = cloud->getScalarFieldIndexByName(RADII_SF_NAME);
-		if (sfIdxRadii < 0)
-			sfIdxRadii = cloud->addScalarField(RADII_SF_NAME);
-		if (sfIdxRadii < 0)
-		{
-			if (app)
-				app->dispToConsole(QString("Failed to allocate a new scalar field for storing radii! You should try to free some memory ..."), ccMainAppInterface::WRN_CONSOLE_MESSAGE);
-			//return false;
-		}
-		else
-		{
-			radiiSf = static_cast<ccScalarField*>(cloud->getScalarField(sfIdxRadii));
-			radiiSf->resizeSafe(pointCount); //should always be ok
-		}
-	}
+	ccGLMatrix cloudToProfile = profileDesc.computeCloudToProfileOriginTrans();
 
-	bool success = true;
+	//we deduce the horizontal dimensions from the revolution axis
+	const unsigned char dim1 = static_cast<unsigned char>(profileDesc.revolDim < 2 ? profileDesc.revolDim + 1 : 0);
+	const unsigned char dim2 = (dim1 < 2 ? dim1 + 1 : 0);
 
-	//now compute the distance between the cloud and the (implicit) surface of revolution
-	{
-		ccGLMatrix cloudToProfile = profileDesc.computeCloudToProfileOriginTrans();
+	ccProgressDialog dlg(true, app ? app->getMainWindow() : nullptr);
+	dlg.setMethodTitle(QObject::tr("Cloud to profile radial distance"));
 
-		//we deduce the horizontal dimensions from the revolution axis
-		const unsigned char dim1 = static_cast<unsigned char>(profileDesc.revolDim < 2 ? profileDesc.revolDim + 1 : 0);
-		const unsigned char dim2 = (dim1 < 2 ? dim1 + 1 : 0);
+	bool success = true;
 
-		ccProgressDialog dlg(true, app ? app->getMainWindow() : nullptr);
-		dlg.setMethodTitle(QObject::tr("Cloud to profile radial distance"));
-		dlg.setInfo(QObject::tr("Polyline: %1 vertices\nCloud: %2 points").arg(vertexCount).arg(pointCount));
-		dlg.start();
-		CCCoreLib::NormalizedProgress nProgress(static_cast<CCCoreLib::GenericProgressCallback*>(&dlg), pointCount);
+	for (size_t cloudIndex = 0; cloudIndex < clouds.size() && success; ++cloudIndex)
+	{
+		ccPointCloud* cloud = clouds[cloudIndex];
 
-		for (unsigned i = 0; i < pointCount; ++i)
+		//reserve a new scalar field (or take the old one if it already exists)
+		int sfIdx = cloud->getScalarFieldIndexByName(RADIAL_DIST_SF_NAME);
+		if (sfIdx < 0)
+			sfIdx = cloud->addScalarField(RADIAL_DIST_SF_NAME);
+		if (sfIdx < 0)
 		{
-			const CCVector3* P = cloud->getPoint(i);
-
-			//relative point position
-			CCVector3 Prel = cloudToProfile * (*P);
-
-			//deduce point height and radius (i.e. in profile 2D coordinate system)
-			double height = Prel.u[profileDesc.revolDim];
-			//TODO FIXME: we assume the surface of revolution is smooth!
-			double radius = sqrt(Prel.u[dim1] * Prel.u[dim1] + Prel.u[dim2] * Prel.u[dim2]);
+			if (app)
+				app->dispToConsole(QString("Failed to allocate a new scalar field for computing distances! Try to free some memory ..."), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return false;
+		}
+		ccScalarField* sf = static_cast<ccScalarField*>(cloud->getScalarField(sfIdx));
+		unsigned pointCount = cloud->size();
+		sf->resizeSafe(pointCount); //should always be ok
+		assert(sf);
 
-			if (radiiSf)
+		ccScalarField* radiiSf = nullptr;
+		if (storeRadiiAsSF)
+		{
+			int sfIdxRadii = cloud->getScalarFieldIndexByName(RADII_SF_NAME);
+			if (sfIdxRadii < 0)
+				sfIdxRadii = cloud->addScalarField(RADII_SF_NAME);
+			if (sfIdxRadii < 0)
 			{
-				ScalarType radiusVal = static_cast<ScalarType>(radius);
-				radiiSf->setValue(i, radiusVal);
+				if (app)
+					app->dispToConsole(QString("Failed to allocate a new scalar field for storing radii! You should try to free some memory ..."), ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+				//return false;
 			}
+			else
+			{
+				radiiSf = static_cast<ccScalarField*>(cloud->getScalarField(sfIdxRadii));
+				radiiSf->resizeSafe(pointCount); //should always be ok
+			}
+		}
 
-			//search nearest "segment" in polyline
-			ScalarType minDist = CCCoreLib::NAN_VALUE;
-			for (unsigned j = 1; j < vertexCount; ++j)
+		//now compute the distance between the cloud and the (implicit) surface of revolution
+		{
+			QString info = QObject::tr("Polyline: %1 vertices\nCloud: %2 points").arg(vertexCount).arg(pointCount);
+			if (clouds.size() > 1)
 			{
-				const CCVector3* A = vertices->getPoint(j - 1);
-				const CCVector3* B = vertices->getPoint(j);
+				info += QObject::tr(" (%1/%2)").arg(cloudIndex + 1).arg(clouds.size());
+			}
+			dlg.setInfo(info);
+			dlg.start();
+			CCCoreLib::NormalizedProgress nProgress(static_cast<CCCoreLib::GenericProgressCallback*>(&dlg), pointCount);
+			std::mutex progressMutex;
+			std::atomic<bool> cancelled{ false };
+
+			std::vector<unsigned> taskStarts = GetTaskStarts(pointCount);
+			QtConcurrent::blockingMap(taskStarts, [&](unsigned start)
+			{
+				unsigned end = std::min(start + s_pointsPerTask, pointCount);
+				if (cancelled)
+				{
+					for (unsigned i = start; i < end; ++i)
+						sf->setValue(i, CCCoreLib::NAN_VALUE);
+					return;
+				}
 
-				double alpha = (height - A->y) / (B->y - A->y);
-				if (alpha >= 0.0 && alpha <= 1.0)
+				for (unsigned i = start; i < end; ++i)
 				{
-					//we deduce the right radius by linear interpolation
-					double radius_th = A->x + alpha * (B->x - A->x);
-					double dist = radius - radius_th;
+					const CCVector3* P = cloud->getPoint(i);
+
+					//relative point position
+					CCVector3 Prel = cloudToProfile * (*P);
 
-					//we look at the closest segment (if the polyline is concave!)
-					if (	!CCCoreLib::ScalarField::ValidValue(minDist)
-						||	(dist * dist) < (static_cast<double>(minDist) * minDist) )
+					//deduce point height and radius (i.e. in profile 2D coordinate system)
+					double height = Prel.u[profileDesc.revolDim];
+					//TODO FIXME: we assume the surface of revolution is smooth!
+					double radius = sqrt(Prel.u[dim1] * Prel.u[dim1] + Prel.u[dim2] * Prel.u[dim2]);
+
+					if (radiiSf)
 					{
-						minDist = static_cast<ScalarType>(dist);
+						ScalarType radiusVal = static_cast<ScalarType>(radius);
+						radiiSf->setValue(i, radiusVal);
 					}
+
+					//search nearest "segment" in polyline
+					sf->setValue(i, lookup.radialDist(height, radius));
 				}
-			}
 
-			sf->setValue(i, minDist);
+				std::lock_guard<std::mutex> lock(progressMutex);
+				if (!nProgress.steps(end - start))
+				{
+					//cancelled by user
+					cancelled = true;
+				}
+			});
 
-			if (!nProgress.oneStep())
+			if (cancelled)
 			{
-				//cancelled by user
-				for (unsigned j = i; j < pointCount; ++j)
-					sf->setValue(j, CCCoreLib::NAN_VALUE);
-
 				success = false;
-				break;
 			}
-
-			//TEST
-			//*const_cast<CCVector3*>(P) = Prel;
 		}
 
-		//TEST
-		//cloud->invalidateBoundingBox();
+		sf->computeMinAndMax();
+		cloud->setCurrentDisplayedScalarField(sfIdx);
+		cloud->showSF(true);
 	}
 
-	sf->computeMinAndMax();
-	cloud->setCurrentDisplayedScalarField(sfIdx);
-	cloud->showSF(true);
-
 	return success;
 }
 
@@ -560,83 +781,148 @@ QSharedPointer<DistanceMapGenerationTool::Map> DistanceMapGenerationTool::Create
 	grid->counterclockwise = counterclockwise;
 	double ccw = (counterclockwise ? -1.0 : 1.0);
 
-	for (unsigned n = 0; n < count; ++n)
+	//projects a range of points in a map
+	auto projectPoints = [&](unsigned start, unsigned end, MapCell* cells)
 	{
-		//we skip invalid values
-		const ScalarType& val = sf->getValue(n);
-		if (!CCCoreLib::ScalarField::ValidValue(val))
-			continue;
+		for (unsigned n = start; n < end; ++n)
+		{
+			//we skip invalid values
+			const ScalarType& val = sf->getValue(n);
+			if (!CCCoreLib::ScalarField::ValidValue(val))
+				continue;
 
-		const CCVector3* P = cloud->getPoint(n);
-		CCVector3 relativePos = cloudToSurface * (*P);
+			const CCVector3* P = cloud->getPoint(n);
+			CCVector3 relativePos = cloudToSurface * (*P);
 
-		//convert to cylindrical or conical (spherical) coordinates
-		double x = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
-		if (x < 0.0)
-		{
-			x += 2 * M_PI;
-		}
+			//convert to cylindrical or conical (spherical) coordinates
+			double x = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
+			if (x < 0.0)
+			{
+				x += 2 * M_PI;
+			}
 
-		double y = 0.0;
-		if (conical)
-		{
-			y = ComputeLatitude_rad(relativePos.u[X], relativePos.u[Y], relativePos.u[Z]); //latitude between 0 and pi/2
-		}
-		else
-		{
-			y = relativePos.u[Z]; //height
-		}
+			double y = 0.0;
+			if (conical)
+			{
+				y = ComputeLatitude_rad(relativePos.u[X], relativePos.u[Y], relativePos.u[Z]); //latitude between 0 and pi/2
+			}
+			else
+			{
+				y = relativePos.u[Z]; //height
+			}
 
-		int i = static_cast<int>((x - grid->xMin) / grid->xStep);
-		int j = static_cast<int>((y - grid->yMin) / grid->yStep);
+			int i = static_cast<int>((x - grid->xMin) / grid->xStep);
+			int j = static_cast<int>((y - grid->yMin) / grid->yStep);
 
-		//if we fall exactly on the max corner of the grid box
-		if (i == static_cast<int>(grid->xSteps))
-			--i;
-		if (j == static_cast<int>(grid->ySteps))
-			--j;
+			//if we fall exactly on the max corner of the grid box
+			if (i == static_cast<int>(grid->xSteps))
+				--i;
+			if (j == static_cast<int>(grid->ySteps))
+				--j;
 
-		//we skip points outside the box!
-		if (	i < 0 || i >= static_cast<int>(grid->xSteps)
-			||	j < 0 || j >= static_cast<int>(grid->ySteps) )
-		{
-			continue;
-		}
-		assert(i >= 0 && j >= 0);
+			//we skip points outside the box!
+			if (	i < 0 || i >= static_cast<int>(grid->xSteps)
+				||	j < 0 || j >= static_cast<int>(grid->ySteps) )
+			{
+				continue;
+			}
+			assert(i >= 0 && j >= 0);
 
-		MapCell& cell = (*grid)[j*static_cast<int>(grid->xSteps) + i];
-		if (cell.count) //if there's already values projected in this cell
-		{
-			switch (fillStrategy)
+			MapCell& cell = cells[j*static_cast<int>(grid->xSteps) + i];
+			if (cell.count) //if there's already values projected in this cell
+			{
+				switch (fillStrategy)
+				{
+				case FILL_STRAT_MIN_DIST:
+					// Set the minimum SF value
+					if (val < cell.value)
+						cell.value = val;
+					break;
+				case FILL_STRAT_AVG_DIST:
+					// Sum the values
+					cell.value += static_cast<double>(val);
+					break;
+				case FILL_STRAT_MAX_DIST:
+					// Set the maximum SF value
+					if (val > cell.value)
+						cell.value = val;
+					break;
+				default:
+					assert(false);
+					break;
+				}
+			}
+			else
 			{
-			case FILL_STRAT_MIN_DIST:
-				// Set the minimum SF value
-				if (val < cell.value)
-					cell.value = val;
-				break;
-			case FILL_STRAT_AVG_DIST:
-				// Sum the values
-				cell.value += static_cast<double>(val);
-				break;
-			case FILL_STRAT_MAX_DIST:
-				// Set the maximum SF value
-				if (val > cell.value)
-					cell.value = val;
-				break;
-			default:
-				assert(false);
-				break;
+				//for the first point, we simply have to store its associated value (whatever the case)
+				cell.value = val;
 			}
+			++cell.count;
 		}
-		else
+	};
+
+	//the points are split in ranges (one per thread) projected in their own map, and the maps are merged afterwards
+	unsigned rangeCount = std::max(1u, std::min(static_cast<unsigned>(std::max(1, QThread::idealThreadCount())), count / s_pointsPerTask));
+	std::vector< std::vector<MapCell> > partialMaps;
+	try
+	{
+		partialMaps.resize(rangeCount - 1, std::vector<MapCell>(cellCount));
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory for the partial maps: we'll use a single thread
+		partialMaps.clear();
+		rangeCount = 1;
+	}
+
+	std::vector<unsigned> ranges(rangeCount);
+	for (unsigned r = 0; r < rangeCount; ++r)
+	{
+		ranges[r] = r;
+	}
+	QtConcurrent::blockingMap(ranges, [&](unsigned r)
+	{
+		unsigned start = static_cast<unsigned>((static_cast<uint64_t>(count) * r) / rangeCount);
+		unsigned end = static_cast<unsigned>((static_cast<uint64_t>(count) * (r + 1)) / rangeCount);
+		projectPoints(start, end, r == 0 ? grid->data() : partialMaps[r - 1].data());
+	});
+
+	//merge the partial maps
+	for (const std::vector<MapCell>& partialMap : partialMaps)
+	{
+		for (unsigned i = 0; i < cellCount; ++i)
 		{
-			//for the first point, we simply have to store its associated value (whatever the case)
-			cell.value = val;
-		}
-		++cell.count;
+			const MapCell& src = partialMap[i];
+			if (src.count == 0)
+				continue;
 
-		//if (progressCb)
-		//	progressCb->update(30.0 * (float)n / (float)cloud->size());
+			MapCell& dest = (*grid)[i];
+			if (dest.count)
+			{
+				switch (fillStrategy)
+				{
+				case FILL_STRAT_MIN_DIST:
+					if (src.value < dest.value)
+						dest.value = src.value;
+					break;
+				case FILL_STRAT_AVG_DIST:
+					dest.value += src.value;
+					break;
+				case FILL_STRAT_MAX_DIST:
+					if (src.value > dest.value)
+						dest.value = src.value;
+					break;
+				default:
+					assert(false);
+					break;
+				}
+			}
+			else
+			{
+				dest.value = src.value;
+			}
+			dest.count += src.count;
+		}
 	}
 
 	//we need to finish the average values computation
@@ -1066,10 +1352,31 @@ bool DistanceMapGenerationTool::ComputeSurfacesAndVolumes(	const QSharedPointer<
 	const double surfPart = map->xStep / 2.0;				//perimeter of a portion of circle of angle alpha = alpha * r (* height to get the external surface)
 	const double volPart = map->yStep * map->xStep / 6.0;	//area of a portion of circle of angle alpha = alpha/2 * r^2 (* height to get the volume)
 
-	const MapCell* cell = &map->at(0);
-	//for each row
+	//profile lookup table
+	ProfileLookup lookup;
+	std::vector< std::pair<Measures, Measures> > rowMeasures; //surface and volume measures per row
+	try
+	{
+		lookup.init(vertices);
+		rowMeasures.resize(map->ySteps);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	//the rows are processed in parallel
+	std::vector<unsigned> rows(map->ySteps);
 	for (unsigned j = 0; j < map->ySteps; ++j)
 	{
+		rows[j] = j;
+	}
+	QtConcurrent::blockingMap(rows, [&](unsigned j)
+	{
+		Measures& rowSurface = rowMeasures[j].first;
+		Measures& rowVolume = rowMeasures[j].second;
+
 		//corresponding heights
 		double height1 = map->yMin + j * map->yStep;
 		double height2 = height1 + map->yStep;
@@ -1078,22 +1385,18 @@ bool DistanceMapGenerationTool::ComputeSurfacesAndVolumes(	const QSharedPointer<
 
 		//search nearest "segment" in polyline
 		double height_middle = (height1 + height2) / 2.0;
-		for (unsigned k = 1; k < vertexCount; ++k)
+		unsigned k = lookup.firstFacingSegment(height_middle); //FIXME: we hope that there's only one segment facing this particular height?!
+		if (k != 0)
 		{
-			const CCVector3* A = vertices->getPoint(k - 1);
-			const CCVector3* B = vertices->getPoint(k);
-
-			double alpha = (height_middle - A->y) / (B->y - A->y);
-			if (alpha >= 0.0 && alpha <= 1.0)
-			{
-				r_th1 = A->x + (height1 - A->y) / (B->y - A->y) * (B->x - A->x);
-				r_th2 = A->x + (height2 - A->y) / (B->y - A->y) * (B->x - A->x);
-				break; //FIXME: we hope that there's only one segment facing this particular height?!
-			}
+			const CCVector2& A = lookup.vertex(k - 1);
+			const CCVector2& B = lookup.vertex(k);
+			r_th1 = A.x + (height1 - A.y) / (B.y - A.y) * (B.x - A.x);
+			r_th2 = A.x + (height2 - A.y) / (B.y - A.y) * (B.x - A.x);
 		}
 
 		if (r_th1 >= 0.0 /* && r_th2 >= 0.0*/)
 		{
+			const MapCell* cell = &map->at(j * map->xSteps);
 			//for each column
 			for (unsigned i = 0; i < map->xSteps; ++i, ++cell)
 			{
@@ -1108,30 +1411,38 @@ bool DistanceMapGenerationTool::ComputeSurfacesAndVolumes(	const QSharedPointer<
 				{
 					double s = sqrt((r2 - r1) * (r2 - r1) + map->yStep * map->yStep);
 					double externalSurface = /*surfPart * */(r1 + r2) * s;
-					surface.total += externalSurface;
+					rowSurface.total += externalSurface;
 					//dispatch in 'positive' and 'negative' surface
 					if (d >= 0.0)
-						surface.positive += externalSurface;
+						rowSurface.positive += externalSurface;
 					else
-						surface.negative += externalSurface;
+						rowSurface.negative += externalSurface;
 				}
 
 				//volume of the element
 				{
-					volume.total += /*volPart * */(r1*r1 + r2*r2 + r1*r2);
+					rowVolume.total += /*volPart * */(r1*r1 + r2*r2 + r1*r2);
 					//volume of the gain (or loss) of matter
 					double diffVolume = /*volPart * */std::abs(3.0*d * (r_th1 + r_th2 + d)); // = (r*r) * part - (r_th*r_th) * part = [(r_th+d)*(r_th+d)-r_th*r_th] * part
 					if (d >= 0.0)
-						volume.positive += diffVolume;
+						rowVolume.positive += diffVolume;
 					else
-						volume.negative += diffVolume;
+						rowVolume.negative += diffVolume;
 				}
 			}
 		}
-		else
-		{
-			cell += map->xSteps;
-		}
+	});
+
+	//sum the rows measures (in the rows order)
+	for (const std::pair<Measures, Measures>& measures : rowMeasures)
+	{
+		surface.total += measures.first.total;
+		surface.positive += measures.first.positive;
+		surface.negative += measures.first.negative;
+
+		volume.total += measures.second.total;
+		volume.positive += measures.second.positive;
+		volume.negative += measures.second.negative;
 	}
 
 	//don't forget to mult. by constants
@@ -1165,24 +1476,30 @@ bool DistanceMapGenerationTool::ConvertCloudToCylindrical(	ccPointCloud* cloud,
 	PointCoordinateType ccw = (counterclockwise ? -CCCoreLib::PC_ONE : CCCoreLib::PC_ONE);
 
 	//get projection height
-	for (unsigned n = 0; n < cloud->size(); ++n)
+	const unsigned count = cloud->size();
+	std::vector<unsigned> taskStarts = GetTaskStarts(count);
+	QtConcurrent::blockingMap(taskStarts, [&](unsigned start)
 	{
-		CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
-		CCVector3 relativePos = cloudToSurface * (*P);
-
-		//convert to cylindrical coordinates
-		double lon_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
-		if (lon_rad < 0.0)
+		unsigned end = std::min(start + s_pointsPerTask, count);
+		for (unsigned n = start; n < end; ++n)
 		{
-			lon_rad += 2 * M_PI;
-		}
-		
-		PointCoordinateType height = relativePos.u[Z];
+			CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
+			CCVector3 relativePos = cloudToSurface * (*P);
 
-		P->x = static_cast<PointCoordinateType>(lon_rad);
-		P->y = height;
-		P->z = 0;
-	}
+			//convert to cylindrical coordinates
+			double lon_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]); //longitude
+			if (lon_rad < 0.0)
+			{
+				lon_rad += 2 * M_PI;
+			}
+
+			PointCoordinateType height = relativePos.u[Z];
+
+			P->x = static_cast<PointCoordinateType>(lon_rad);
+			P->y = height;
+			P->z = 0;
+		}
+	});
 
 	cloud->refreshBB();
 	if (cloud->getOctree())
@@ -1218,22 +1535,28 @@ bool DistanceMapGenerationTool::ConvertCloudToConical(	ccPointCloud* cloud,
 	double nProj = ConicalProjectN(latMin_rad, latMax_rad) * conicalSpanRatio;
 
 	//get projection height
-	for (unsigned n = 0; n < cloud->size(); ++n)
+	const unsigned count = cloud->size();
+	std::vector<unsigned> taskStarts = GetTaskStarts(count);
+	QtConcurrent::blockingMap(taskStarts, [&](unsigned start)
 	{
-		CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
-		CCVector3 relativePos = cloudToSurface * (*P);
+		unsigned end = std::min(start + s_pointsPerTask, count);
+		for (unsigned n = start; n < end; ++n)
+		{
+			CCVector3* P = const_cast<CCVector3*>(cloud->getPoint(n));
+			CCVector3 relativePos = cloudToSurface * (*P);
 
-		//convert to cylindrical coordinates
-		PointCoordinateType ang_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]);
-		if (ang_rad < 0.0)
-			ang_rad += static_cast<PointCoordinateType>(2 * M_PI);
+			//convert to cylindrical coordinates
+			PointCoordinateType ang_rad = ccw * atan2(relativePos.u[X], relativePos.u[Y]);
+			if (ang_rad < 0.0)
+				ang_rad += static_cast<PointCoordinateType>(2 * M_PI);
 
-		double lat_rad = ComputeLatitude_rad(	relativePos.u[X],
-												relativePos.u[Y],
-												relativePos.u[Z] ); //between 0 and pi/2
+			double lat_rad = ComputeLatitude_rad(	relativePos.u[X],
+													relativePos.u[Y],
+													relativePos.u[Z] ); //between 0 and pi/2
 
-		*P = ProjectPointOnCone(ang_rad, lat_rad, latMin_rad, nProj, counterclockwise);
-	}
+			*P = ProjectPointOnCone(ang_rad, lat_rad, latMin_rad, nProj, counterclockwise);
+		}
+	});
 
 	cloud->refreshBB();
 	if (cloud->getOctree())
@@ -68,7 +68,7 @@ QList<QAction *> qSRA::getActions()
 	if (!m_doCompareCloudToProfile)
 	{
 		m_doCompareCloudToProfile = new QAction("Cloud-SurfRev radial distance",this);
-		m_doCompareCloudToProfile->setToolTip("Computes the radial distances between a cloud and a Surface of Revolution (polyline/profile, cone or cylinder)");
+		m_doCompareCloudToProfile->setToolTip("Computes the radial distances between one or several clouds and a Surface of Revolution (polyline/profile, cone or cylinder)");
 		m_doCompareCloudToProfile->setIcon(QIcon(QString::fromUtf8(":/CC/plugin/qSRA/images/distToProfileIcon.png")));
 		//connect signal
 		connect(m_doCompareCloudToProfile, &QAction::triggered, this, &qSRA::computeCloud2ProfileRadialDist);
@@ -97,21 +97,27 @@ void qSRA::onNewSelection(const ccHObject::Container& selectedEntities)
 		//always active
 	}
 
-	bool validSelection = false;
-	if (selectedEntities.size() == 2)
+	//we expect one or several clouds...
+	size_t cloudCount = 0;
+	size_t profileCount = 0;
+	for (ccHObject* entity : selectedEntities)
 	{
-		//we expect a cloud...
-		int cloudIndex = selectedEntities[0]->isA(CC_TYPES::POINT_CLOUD) ? 0 : selectedEntities[1]->isA(CC_TYPES::POINT_CLOUD) ? 1 : -1;
-		if (cloudIndex != -1)
+		if (entity->isA(CC_TYPES::POINT_CLOUD))
 		{
-			//... and either a polyline or a cone/cylinder
-			validSelection = (selectedEntities[1 - cloudIndex]->isA(CC_TYPES::POLY_LINE) || selectedEntities[1 - cloudIndex]->isKindOf(CC_TYPES::CONE));
+			++cloudCount;
+		}
+		//... and either a polyline or a cone/cylinder
+		else if (entity->isA(CC_TYPES::POLY_LINE) || entity->isKindOf(CC_TYPES::CONE))
+		{
+			++profileCount;
 		}
 	}
+	bool validBatchSelection = (cloudCount != 0 && profileCount == 1 && cloudCount + profileCount == selectedEntities.size());
+	bool validSelection = (validBatchSelection && cloudCount == 1);
 
 	if (m_doCompareCloudToProfile)
 	{
-		m_doCompareCloudToProfile->setEnabled(validSelection);
+		m_doCompareCloudToProfile->setEnabled(validBatchSelection);
 	}
 
 	if (m_doProjectCloudDists)
@@ -315,22 +321,22 @@ void qSRA::computeCloud2ProfileRadialDist() const
 	}
 
 	const ccHObject::Container& selectedEntities = m_app->getSelectedEntities();
-	if (selectedEntities.size() != 2)
+	if (selectedEntities.size() < 2)
 	{
 		assert(false);
 		return;
 	}
 
-	//retrieve input cloud and polyline
-	ccPointCloud* cloud = nullptr;
+	//retrieve input cloud(s) and polyline
+	std::vector<ccPointCloud*> clouds;
 	ccPolyline* polyline = nullptr;
 	bool tempPolyline = false;
 	{
-		for (unsigned i = 0; i < 2; ++i)
+		for (size_t i = 0; i < selectedEntities.size(); ++i)
 		{
 			if (selectedEntities[i]->isA(CC_TYPES::POINT_CLOUD))
 			{
-				cloud = static_cast<ccPointCloud*>(selectedEntities[i]);
+				clouds.push_back(static_cast<ccPointCloud*>(selectedEntities[i]));
 			}
 			else if (selectedEntities[i]->isA(CC_TYPES::POLY_LINE))
 			{
@@ -365,9 +371,9 @@ void qSRA::computeCloud2ProfileRadialDist() const
 		}
 	}
 
-	if (cloud && polyline)
+	if (!clouds.empty() && polyline)
 	{
-		if (doComputeRadialDists(cloud, polyline))
+		if (doComputeRadialDists(clouds, polyline) && clouds.size() == 1)
 		{
 			//automatically ask the user if he wants to generate a 2D map
 			if (QMessageBox::question(	m_app ? m_app->getMainWindow() : nullptr,
@@ -376,14 +382,14 @@ void qSRA::computeCloud2ProfileRadialDist() const
 										QMessageBox::Yes,
 										QMessageBox::No) == QMessageBox::Yes)
 			{
-				doProjectCloudDistsInGrid(cloud, polyline);
+				doProjectCloudDistsInGrid(clouds.front(), polyline);
 			}
 		}
 	}
 	else
 	{
 		if (m_app)
-			m_app->dispToConsole(QString("Select exactly one cloud and one Surface of Revolution (polyline/profile, cone or cylinder)"), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			m_app->dispToConsole(QString("Select one or several clouds and one Surface of Revolution (polyline/profile, cone or cylinder)"), ccMainAppInterface::ERR_CONSOLE_MESSAGE);
 	}
 
 	if (polyline && tempPolyline)
@@ -393,17 +399,20 @@ void qSRA::computeCloud2ProfileRadialDist() const
 	}
 }
 
-bool qSRA::doComputeRadialDists(ccPointCloud* cloud, ccPolyline* polyline) const
+bool qSRA::doComputeRadialDists(const std::vector<ccPointCloud*>& clouds, ccPolyline* polyline) const
 {
-	if (!cloud || !polyline)
+	if (clouds.empty() || !polyline)
 	{
 		assert(false);
 		return false;
 	}
 
-	if (DistanceMapGenerationTool::ComputeRadialDist(cloud, polyline, false, m_app))
+	if (DistanceMapGenerationTool::ComputeRadialDist(clouds, polyline, false, m_app))
 	{
-		cloud->prepareDisplayForRefresh();
+		for (ccPointCloud* cloud : clouds)
+		{
+			cloud->prepareDisplayForRefresh();
+		}
 		if (m_app)
 		{
 			m_app->updateUI();
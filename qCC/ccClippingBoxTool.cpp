@@ -29,13 +29,19 @@
 
 // qCC_db
 #include <ccClipBox.h>
+#include <ccHObjectCaster.h>
+#include <ccMesh.h>
 #include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 #include <ccRasterGrid.h>
+#include <ccSubMesh.h>
 
 // Qt
 #include <QMessageBox>
 
+// System
+#include <atomic>
+
 namespace
 {
 	// Last envelope or contour unique ID
@@ -552,6 +558,671 @@ static unsigned ComputeGridDimensions(const ccBBox&    localBox,
 	return cellCount;
 }
 
+namespace
+{
+	//! Repeat grid (in the local clipping box coordinate system)
+	struct RepeatGrid
+	{
+		CCVector3           origin;
+		CCVector3           cellSize;
+		CCVector3           cellSizePlusGap;
+		PointCoordinateType gap = 0;
+		int                 indexMins[3]{0, 0, 0};
+		int                 indexMaxs[3]{0, 0, 0};
+		int                 gridDim[3]{0, 0, 0};
+		unsigned            cellCount = 0;
+
+		//! Returns the (linear) index of a cell
+		inline int cellIndex(int i, int j, int k) const
+		{
+			return ((k - indexMins[2]) * gridDim[1] + (j - indexMins[1])) * gridDim[0] + (i - indexMins[0]);
+		}
+
+		//! Returns the origin (min corner) of a cell
+		inline CCVector3 cellOrigin(int i, int j, int k) const
+		{
+			return CCVector3(origin.x + i * cellSizePlusGap.x,
+			                 origin.y + j * cellSizePlusGap.y,
+			                 origin.z + k * cellSizePlusGap.z);
+		}
+	};
+
+	//! Number of triangles binned by each parallel task
+	constexpr unsigned s_trianglesPerBinningTask = 65536;
+} // namespace
+
+static void SetSliceMetaData(ccHObject* slice, const ccHObject* origin, const QString& slicePosStr, const CCVector3& cellOrigin)
+{
+	slice->setMetaData(s_originEntityUUID, origin->getUniqueID());
+	slice->setMetaData(s_sliceID, slicePosStr);
+	slice->setMetaData("slice.origin.dim(0)", cellOrigin.x);
+	slice->setMetaData("slice.origin.dim(1)", cellOrigin.y);
+	slice->setMetaData("slice.origin.dim(2)", cellOrigin.z);
+}
+
+static void CopySliceMetaData(ccHObject* poly, const ccHObject* slice)
+{
+	poly->setMetaData(s_originEntityUUID, slice->getMetaData(s_originEntityUUID));
+	poly->setMetaData(s_sliceID, slice->getMetaData(s_sliceID));
+	poly->setMetaData("slice.origin.dim(0)", slice->getMetaData("slice.origin.dim(0)"));
+	poly->setMetaData("slice.origin.dim(1)", slice->getMetaData("slice.origin.dim(1)"));
+	poly->setMetaData("slice.origin.dim(2)", slice->getMetaData("slice.origin.dim(2)"));
+}
+
+//! Extracts the slices of several clouds in repeat mode
+/** All the points are binned in a single (parallel) pass, then the slices are created in parallel.
+    The slices are output in the cells order (X, then Y, then Z - and then clouds).
+**/
+static bool ExtractRepeatedCloudSlices(const std::vector<ccGenericPointCloud*>& clouds,
+                                       const ccGLMatrix&                        localTrans,
+                                       const RepeatGrid&                        grid,
+                                       bool                                     generateRandomColors,
+                                       ccProgressDialog*                        progressDialog,
+                                       std::vector<ccHObject*>&                 outputSlices,
+                                       bool&                                    warningsIssued)
+{
+	if (progressDialog)
+	{
+		progressDialog->setWindowTitle(QObject::tr("Preparing extraction"));
+		progressDialog->start();
+		progressDialog->show();
+		progressDialog->setAutoClose(false);
+	}
+
+	// project the points into the grid, and sort their indexes by cell (in ascending order inside each cell)
+	std::vector<std::vector<unsigned>> cellOffsets(clouds.size()); // for each cloud: position of the first point of each cell in 'cellPoints' (+ total)
+	std::vector<std::vector<unsigned>> cellPoints(clouds.size());
+	{
+		CCCoreLib::NormalizedProgress nProgress(progressDialog, static_cast<unsigned>(clouds.size()));
+
+		for (size_t ci = 0; ci != clouds.size(); ++ci)
+		{
+			ccGenericPointCloud* cloud      = clouds[ci];
+			unsigned             pointCount = cloud->size();
+
+			if (progressDialog)
+			{
+				progressDialog->setInfo(QObject::tr("Cloud '%1'\nPoints: %L2").arg(cloud->getName()).arg(pointCount));
+			}
+			QApplication::processEvents();
+
+			// cell index of each point (or -1 if the point falls in a gap)
+			std::vector<int> pointCells(pointCount, -1);
+			int              count = static_cast<int>(pointCount);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+			for (int i = 0; i < count; ++i)
+			{
+				CCVector3 P = *cloud->getPoint(static_cast<unsigned>(i));
+				localTrans.apply(P);
+
+				// relative coordinates (between 0 and 1)
+				P -= grid.origin;
+				P.x /= grid.cellSizePlusGap.x;
+				P.y /= grid.cellSizePlusGap.y;
+				P.z /= grid.cellSizePlusGap.z;
+
+				int xi = static_cast<int>(floor(P.x));
+				xi     = std::min(std::max(xi, grid.indexMins[0]), grid.indexMaxs[0]);
+				int yi = static_cast<int>(floor(P.y));
+				yi     = std::min(std::max(yi, grid.indexMins[1]), grid.indexMaxs[1]);
+				int zi = static_cast<int>(floor(P.z));
+				zi     = std::min(std::max(zi, grid.indexMins[2]), grid.indexMaxs[2]);
+
+				if (grid.gap == 0 || ((P.x - static_cast<PointCoordinateType>(xi)) * grid.cellSizePlusGap.x <= grid.cellSize.x && (P.y - static_cast<PointCoordinateType>(yi)) * grid.cellSizePlusGap.y <= grid.cellSize.y && (P.z - static_cast<PointCoordinateType>(zi)) * grid.cellSizePlusGap.z <= grid.cellSize.z))
+				{
+					pointCells[i] = grid.cellIndex(xi, yi, zi);
+					assert(pointCells[i] >= 0 && static_cast<unsigned>(pointCells[i]) < grid.cellCount);
+				}
+			}
+
+			// counting sort
+			std::vector<unsigned>& offsets = cellOffsets[ci];
+			offsets.resize(grid.cellCount + 1, 0);
+			for (int c : pointCells)
+			{
+				if (c >= 0)
+					++offsets[c + 1];
+			}
+			for (unsigned c = 0; c < grid.cellCount; ++c)
+			{
+				offsets[c + 1] += offsets[c];
+			}
+
+			std::vector<unsigned>& points = cellPoints[ci];
+			points.resize(offsets.back());
+			std::vector<unsigned> cursors(offsets.begin(), offsets.end() - 1);
+			for (unsigned i = 0; i < pointCount; ++i)
+			{
+				if (pointCells[i] >= 0)
+					points[cursors[pointCells[i]]++] = i;
+			}
+
+			nProgress.oneStep();
+		}
+	}
+
+	// list the (non empty) slices
+	struct SliceTask
+	{
+		int           i, j, k;
+		size_t        cloudIndex;
+		unsigned      firstPoint;
+		unsigned      pointCount;
+		ccPointCloud* slice;
+		int           warnings;
+	};
+	std::vector<SliceTask> tasks;
+	for (int i = grid.indexMins[0]; i <= grid.indexMaxs[0]; ++i)
+	{
+		for (int j = grid.indexMins[1]; j <= grid.indexMaxs[1]; ++j)
+		{
+			for (int k = grid.indexMins[2]; k <= grid.indexMaxs[2]; ++k)
+			{
+				int c = grid.cellIndex(i, j, k);
+				for (size_t ci = 0; ci != clouds.size(); ++ci)
+				{
+					const std::vector<unsigned>& offsets = cellOffsets[ci];
+					if (offsets[c + 1] > offsets[c]) // some slices can be empty!
+					{
+						tasks.push_back({i, j, k, ci, offsets[c], offsets[c + 1] - offsets[c], nullptr, 0});
+					}
+				}
+			}
+		}
+	}
+
+	if (progressDialog)
+	{
+		progressDialog->setWindowTitle(QObject::tr("Section extraction"));
+		progressDialog->setInfo(QObject::tr("Section(s): %L1").arg(tasks.size()));
+		progressDialog->setMaximum(100);
+		progressDialog->setValue(0);
+		QApplication::processEvents();
+	}
+
+	// the child entities (if any) are cloned sequentially
+	bool parallelClone = true;
+	for (ccGenericPointCloud* cloud : clouds)
+	{
+		if (cloud->getChildrenNumber() != 0)
+		{
+			parallelClone = false;
+			break;
+		}
+	}
+
+	// now create the real clouds
+	std::atomic<bool>             cancelled(false);
+	std::atomic<bool>             notEnoughMemory(false);
+	CCCoreLib::NormalizedProgress nProgress(progressDialog, static_cast<unsigned>(tasks.size()));
+	int                           taskCount = static_cast<int>(tasks.size());
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) if (parallelClone)
+#endif
+	for (int t = 0; t < taskCount; ++t)
+	{
+		if (cancelled || notEnoughMemory)
+		{
+			continue;
+		}
+
+		SliceTask&           task  = tasks[t];
+		ccGenericPointCloud* cloud = clouds[task.cloudIndex];
+		try
+		{
+			CCCoreLib::ReferenceCloud selection(cloud);
+			if (selection.reserve(task.pointCount))
+			{
+				const unsigned* pointIndexes = cellPoints[task.cloudIndex].data() + task.firstPoint;
+				for (unsigned n = 0; n < task.pointCount; ++n)
+				{
+					selection.addPointIndex(pointIndexes[n]);
+				}
+
+				// generate slice from the selection
+				task.slice = cloud->isA(CC_TYPES::POINT_CLOUD) ? static_cast<ccPointCloud*>(cloud)->partialClone(&selection, &task.warnings) : ccPointCloud::From(&selection, cloud);
+			}
+			else
+			{
+				notEnoughMemory = true;
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+		}
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	}
+
+	bool success = true;
+	if (notEnoughMemory)
+	{
+		ccLog::Error(QObject::tr("Not enough memory!"));
+		success = false;
+	}
+	else if (cancelled)
+	{
+		ccLog::Warning(QObject::tr("[ExtractSlicesAndContours] Process canceled by user"));
+		success = false;
+	}
+
+	// finalize the slices (sequentially, in the cells order)
+	outputSlices.reserve(outputSlices.size() + tasks.size());
+	for (const SliceTask& task : tasks)
+	{
+		ccPointCloud* sliceCloud = task.slice;
+		if (!sliceCloud)
+		{
+			continue;
+		}
+		// the caller will delete the slices in case of failure
+		outputSlices.push_back(sliceCloud);
+		if (!success)
+		{
+			continue;
+		}
+
+		ccGenericPointCloud* cloud = clouds[task.cloudIndex];
+		warningsIssued |= (task.warnings != 0);
+
+		if (generateRandomColors)
+		{
+			ccColor::Rgb col = ccColor::Generator::Random();
+			if (!sliceCloud->setColor(col))
+			{
+				ccLog::Error(QObject::tr("Not enough memory!"));
+				success = false;
+			}
+			sliceCloud->showColors(true);
+		}
+
+		sliceCloud->setEnabled(true);
+		sliceCloud->setVisible(true);
+		sliceCloud->setDisplay(cloud->getDisplay());
+
+		CCVector3 cellOrigin  = grid.cellOrigin(task.i, task.j, task.k);
+		QString   slicePosStr = QString("(%1 ; %2 ; %3)").arg(cellOrigin.x).arg(cellOrigin.y).arg(cellOrigin.z);
+		sliceCloud->setName(cloud->getName() + QString(".slice @ ") + slicePosStr);
+
+		// set meta-data
+		SetSliceMetaData(sliceCloud, cloud, slicePosStr, cellOrigin);
+	}
+
+	return success;
+}
+
+//! Extracts the slices of several meshes in repeat mode
+/** The triangles are binned in a single (parallel) pass: each triangle is assigned to
+    all the cells its bounding-box intersects. Then each cell is only cropped with the
+    candidate triangles (still clipped at the cell boundaries by ccCropTool), in parallel.
+    The slices are output in the cells order (X, then Y, then Z - and then meshes).
+**/
+static bool ExtractRepeatedMeshSlices(const std::vector<ccGenericMesh*>& meshes,
+                                      const ccGLMatrix*                  meshTransformation,
+                                      const RepeatGrid&                  grid,
+                                      bool                               generateRandomColors,
+                                      ccProgressDialog*                  progressDialog,
+                                      std::vector<ccHObject*>&           outputSlices)
+{
+	// input meshes
+	struct MeshData
+	{
+		ccMesh*               parentMesh      = nullptr; // the mesh itself, or the parent mesh of a sub-mesh
+		ccSubMesh*            inputSubMesh    = nullptr;
+		ccPointCloud*         rotatedVertices = nullptr;
+		std::vector<unsigned> cellOffsets;   // position of the first triangle of each cell in 'cellTriangles' (+ total)
+		std::vector<unsigned> cellTriangles; // triangle global indexes (sorted by cell)
+	};
+	std::vector<MeshData> meshData(meshes.size());
+
+	if (progressDialog)
+	{
+		progressDialog->setWindowTitle(QObject::tr("Preparing extraction"));
+		progressDialog->setInfo(QObject::tr("Up to (%1 x %2 x %3) = %4 section(s)").arg(grid.gridDim[0]).arg(grid.gridDim[1]).arg(grid.gridDim[2]).arg(grid.cellCount));
+		progressDialog->setMaximum(100);
+		progressDialog->setValue(0);
+		progressDialog->show();
+		QApplication::processEvents();
+	}
+
+	// tolerance (relative to the cells size) to determine the cells intersected by a triangle
+	static const PointCoordinateType s_cellTolerance = static_cast<PointCoordinateType>(1.0e-2);
+
+	bool success = true;
+	for (size_t mi = 0; mi != meshes.size() && success; ++mi)
+	{
+		ccGenericMesh* mesh = meshes[mi];
+		MeshData&      data = meshData[mi];
+
+		data.inputSubMesh = ccHObjectCaster::ToSubMesh(mesh);
+		data.parentMesh   = data.inputSubMesh ? data.inputSubMesh->getAssociatedMesh() : ccHObjectCaster::ToMesh(mesh);
+		if (!data.parentMesh)
+		{
+			ccLog::Warning(QObject::tr("[ExtractSlicesAndContours] Unhandled mesh type (%1)").arg(mesh->getName()));
+			continue;
+		}
+
+		// transform the mesh vertices once and for all
+		ccGenericPointCloud* vertices = data.parentMesh->getAssociatedCloud();
+		if (meshTransformation)
+		{
+			data.rotatedVertices = ccPointCloud::From(vertices);
+			if (!data.rotatedVertices)
+			{
+				ccLog::Error(QObject::tr("Not enough memory!"));
+				success = false;
+				break;
+			}
+			data.rotatedVertices->setGLTransformation(*meshTransformation);
+			data.rotatedVertices->applyGLTransformation_recursive();
+			vertices = data.rotatedVertices;
+		}
+
+		// bin the triangles (by chunks, so that the triangles remain in ascending order inside each cell)
+		unsigned triCount   = mesh->size();
+		int      chunkCount = static_cast<int>((triCount + s_trianglesPerBinningTask - 1) / s_trianglesPerBinningTask);
+		std::vector<std::vector<std::pair<unsigned, unsigned>>> chunkPairs(chunkCount); // (cell, triangle global index)
+		std::atomic<bool>                                        notEnoughMemory(false);
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			unsigned firstTri = static_cast<unsigned>(chunk) * s_trianglesPerBinningTask;
+			unsigned lastTri  = std::min(firstTri + s_trianglesPerBinningTask, triCount);
+			try
+			{
+				std::vector<std::pair<unsigned, unsigned>>& pairs = chunkPairs[chunk];
+				pairs.reserve(lastTri - firstTri);
+
+				for (unsigned t = firstTri; t < lastTri; ++t)
+				{
+					unsigned                          globalIndex = data.inputSubMesh ? data.inputSubMesh->getTriGlobalIndex(t) : t;
+					const CCCoreLib::VerticesIndexes* tsi         = data.parentMesh->getTriangleVertIndexes(globalIndex);
+					const CCVector3*                  A           = vertices->getPoint(tsi->i1);
+					const CCVector3*                  B           = vertices->getPoint(tsi->i2);
+					const CCVector3*                  C           = vertices->getPoint(tsi->i3);
+
+					// range of cells intersected by the triangle bounding-box
+					int  cellMins[3];
+					int  cellMaxs[3];
+					bool outside = false;
+					for (unsigned char d = 0; d < 3; ++d)
+					{
+						if (CCCoreLib::LessThanEpsilon(grid.cellSizePlusGap.u[d]))
+						{
+							// flat box: let the cropping process decide
+							cellMins[d] = grid.indexMins[d];
+							cellMaxs[d] = grid.indexMaxs[d];
+							continue;
+						}
+						PointCoordinateType minD = std::min(std::min(A->u[d], B->u[d]), C->u[d]) - grid.origin.u[d];
+						PointCoordinateType maxD = std::max(std::max(A->u[d], B->u[d]), C->u[d]) - grid.origin.u[d];
+						// cell 'c' spans [c * (size + gap) ; c * (size + gap) + size]
+						cellMins[d] = std::max(static_cast<int>(ceil((minD - grid.cellSize.u[d]) / grid.cellSizePlusGap.u[d] - s_cellTolerance)), grid.indexMins[d]);
+						cellMaxs[d] = std::min(static_cast<int>(floor(maxD / grid.cellSizePlusGap.u[d] + s_cellTolerance)), grid.indexMaxs[d]);
+						if (cellMins[d] > cellMaxs[d])
+						{
+							outside = true;
+							break;
+						}
+					}
+					if (outside)
+					{
+						continue;
+					}
+
+					for (int i = cellMins[0]; i <= cellMaxs[0]; ++i)
+						for (int j = cellMins[1]; j <= cellMaxs[1]; ++j)
+							for (int k = cellMins[2]; k <= cellMaxs[2]; ++k)
+								pairs.emplace_back(static_cast<unsigned>(grid.cellIndex(i, j, k)), globalIndex);
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+		}
+
+		if (notEnoughMemory)
+		{
+			ccLog::Error(QObject::tr("Not enough memory!"));
+			success = false;
+			break;
+		}
+
+		// counting sort
+		try
+		{
+			data.cellOffsets.resize(grid.cellCount + 1, 0);
+			for (const auto& pairs : chunkPairs)
+			{
+				for (const auto& pair : pairs)
+				{
+					++data.cellOffsets[pair.first + 1];
+				}
+			}
+			for (unsigned c = 0; c < grid.cellCount; ++c)
+			{
+				data.cellOffsets[c + 1] += data.cellOffsets[c];
+			}
+
+			data.cellTriangles.resize(data.cellOffsets.back());
+			std::vector<unsigned> cursors(data.cellOffsets.begin(), data.cellOffsets.end() - 1);
+			for (auto& pairs : chunkPairs)
+			{
+				for (const auto& pair : pairs)
+				{
+					data.cellTriangles[cursors[pair.first]++] = pair.second;
+				}
+				pairs.clear();
+				pairs.shrink_to_fit();
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Error(QObject::tr("Not enough memory!"));
+			success = false;
+			break;
+		}
+	}
+
+	// list the (non empty) slices, and create the corresponding sub-meshes
+	// (sequentially, as the sub-meshes are registered as dependents of their parent mesh)
+	struct SliceTask
+	{
+		int        i, j, k;
+		size_t     meshIndex;
+		ccSubMesh* candidates;
+		ccMesh*    slice;
+	};
+	std::vector<SliceTask> tasks;
+	for (int i = grid.indexMins[0]; i <= grid.indexMaxs[0] && success; ++i)
+	{
+		for (int j = grid.indexMins[1]; j <= grid.indexMaxs[1] && success; ++j)
+		{
+			for (int k = grid.indexMins[2]; k <= grid.indexMaxs[2] && success; ++k)
+			{
+				int c = grid.cellIndex(i, j, k);
+				for (size_t mi = 0; mi != meshes.size(); ++mi)
+				{
+					const MeshData& data = meshData[mi];
+					if (data.cellOffsets.empty() || data.cellOffsets[c + 1] == data.cellOffsets[c])
+					{
+						// no candidate triangle
+						continue;
+					}
+
+					ccGenericMesh* mesh       = meshes[mi];
+					ccSubMesh*     candidates = new ccSubMesh(data.parentMesh);
+					unsigned       count      = data.cellOffsets[c + 1] - data.cellOffsets[c];
+					if (!candidates->reserve(count))
+					{
+						delete candidates;
+						ccLog::Error(QObject::tr("Not enough memory!"));
+						success = false;
+						break;
+					}
+					for (unsigned n = data.cellOffsets[c]; n < data.cellOffsets[c + 1]; ++n)
+					{
+						candidates->addTriangleIndex(data.cellTriangles[n]);
+					}
+
+					// the cropped mesh parameters are imported from the cropped entity
+					candidates->setName(mesh->getName());
+					candidates->importParametersFrom(mesh);
+					candidates->showColors(mesh->colorsShown());
+					candidates->showSF(mesh->sfShown());
+					candidates->showNormals(mesh->normalsShown());
+					candidates->showMaterials(mesh->materialsShown());
+					candidates->setDisplay(mesh->getDisplay());
+
+					tasks.push_back({i, j, k, mi, candidates, nullptr});
+				}
+			}
+		}
+	}
+
+	if (success && progressDialog)
+	{
+		progressDialog->setWindowTitle(QObject::tr("Section extraction"));
+		progressDialog->setInfo(QObject::tr("Section(s): up to %L1").arg(tasks.size()));
+		progressDialog->setValue(0);
+		QApplication::processEvents();
+	}
+
+	// now crop the candidate triangles of each cell
+	std::atomic<bool>             cancelled(false);
+	std::atomic<bool>             notEnoughMemory(false);
+	CCCoreLib::NormalizedProgress nProgress(progressDialog, static_cast<unsigned>(tasks.size()));
+	int                           taskCount = success ? static_cast<int>(tasks.size()) : 0;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int t = 0; t < taskCount; ++t)
+	{
+		if (cancelled || notEnoughMemory)
+		{
+			continue;
+		}
+
+		SliceTask& task = tasks[t];
+		CCVector3  C    = grid.cellOrigin(task.i, task.j, task.k);
+		ccBBox     cropBox(C, C + grid.cellSize, true);
+		try
+		{
+			task.slice = ccCropTool::CropMesh(task.candidates, cropBox, true, meshTransformation, meshData[task.meshIndex].rotatedVertices);
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+		}
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	}
+
+	if (notEnoughMemory)
+	{
+		ccLog::Error(QObject::tr("Not enough memory!"));
+		success = false;
+	}
+	else if (cancelled)
+	{
+		ccLog::Warning(QObject::tr("[ExtractSlicesAndContours] Process canceled by user"));
+		success = false;
+	}
+
+	// finalize the slices (sequentially, in the cells order)
+	for (const SliceTask& task : tasks)
+	{
+		delete task.candidates;
+
+		ccMesh* croppedMesh = task.slice;
+		if (!croppedMesh)
+		{
+			continue;
+		}
+		// the caller will delete the slices in case of failure
+		outputSlices.push_back(croppedMesh);
+		if (!success)
+		{
+			continue;
+		}
+
+		ccGenericMesh* mesh = meshes[task.meshIndex];
+
+		if (generateRandomColors)
+		{
+			ccPointCloud* croppedVertices = ccHObjectCaster::ToPointCloud(croppedMesh->getAssociatedCloud());
+			if (croppedVertices)
+			{
+				ccColor::Rgb col = ccColor::Generator::Random();
+				if (!croppedVertices->setColor(col))
+				{
+					ccLog::Error(QObject::tr("Not enough memory!"));
+					success = false;
+				}
+				croppedVertices->showColors(true);
+				croppedMesh->showColors(true);
+			}
+		}
+
+		croppedMesh->setEnabled(true);
+		croppedMesh->setVisible(true);
+		croppedMesh->setDisplay(mesh->getDisplay());
+
+		CCVector3 C           = grid.cellOrigin(task.i, task.j, task.k);
+		QString   slicePosStr = QString("(%1 ; %2 ; %3)").arg(C.x).arg(C.y).arg(C.z);
+		croppedMesh->setName(mesh->getName() + QString(".slice @ ") + slicePosStr);
+
+		// set meta-data
+		SetSliceMetaData(croppedMesh, mesh, slicePosStr, C);
+	}
+
+	// release memory
+	for (MeshData& data : meshData)
+	{
+		delete data.rotatedVertices;
+		data.rotatedVertices = nullptr;
+	}
+
+	return success;
+}
+
+//! Releases the (partial) outputs of ExtractSlicesAndContours
+static void ReleaseSlicesAndContours(std::vector<ccHObject*>&  slices,
+                                     std::vector<ccPolyline*>& envelopes,
+                                     std::vector<ccPolyline*>& levelSet)
+{
+	for (ccHObject* slice : slices)
+	{
+		delete slice;
+	}
+	slices.resize(0);
+
+	for (ccPolyline* poly : envelopes)
+	{
+		delete poly;
+	}
+	envelopes.resize(0);
+
+	for (ccPolyline* poly : levelSet)
+	{
+		delete poly;
+	}
+	levelSet.resize(0);
+}
+
 bool ccClippingBoxTool::ExtractSlicesAndContours(
     const std::vector<ccGenericPointCloud*>& clouds,
     const std::vector<ccGenericMesh*>&       meshes,
@@ -652,12 +1323,19 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 			if (outputSlices.empty())
 			{
 				// error message already issued
+				ReleaseSlicesAndContours(outputSlices, outputEnvelopes, levelSet);
 				return false;
 			}
 			cloudSliceCount = outputSlices.size();
 		}
 		else // repeat mode
 		{
+			RepeatGrid grid;
+			grid.origin          = gridOrigin;
+			grid.cellSize        = cellSize;
+			grid.cellSizePlusGap = cellSizePlusGap;
+			grid.gap             = gap;
+
 			if (!clouds.empty()) // extract sections from clouds
 			{
 				// compute 'grid' extents in the local clipping box ref.
@@ -672,190 +1350,25 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 					}
 				}
 
-				int      indexMins[3]{0, 0, 0};
-				int      indexMaxs[3]{0, 0, 0};
-				int      gridDim[3]{0, 0, 0};
-				unsigned cellCount = ComputeGridDimensions(localBox, repeatDimensions, indexMins, indexMaxs, gridDim, gridOrigin, cellSizePlusGap);
-
-				// we'll potentially create up to one (ref.) cloud per input loud and per cell
-				std::vector<CCCoreLib::ReferenceCloud*> refClouds;
-				refClouds.resize(cellCount * clouds.size(), nullptr);
-
-				if (progressDialog)
+				grid.cellCount = ComputeGridDimensions(localBox, repeatDimensions, grid.indexMins, grid.indexMaxs, grid.gridDim, gridOrigin, cellSizePlusGap);
+				if (grid.cellCount == 0)
 				{
-					progressDialog->setWindowTitle(tr("Preparing extraction"));
-					progressDialog->start();
-					progressDialog->show();
-					progressDialog->setAutoClose(false);
+					// error message already issued
+					ReleaseSlicesAndContours(outputSlices, outputEnvelopes, levelSet);
+					return false;
 				}
 
-				unsigned subCloudsCount = 0;
-
-				// project points into grid
-				for (size_t ci = 0; ci != clouds.size(); ++ci)
+				if (!ExtractRepeatedCloudSlices(clouds, localTrans, grid, generateRandomColors, progressDialog, outputSlices, warningsIssued))
 				{
-					ccGenericPointCloud* cloud      = clouds[ci];
-					unsigned             pointCount = cloud->size();
-
-					QString infos = tr("Cloud '%1").arg(cloud->getName());
-					infos += tr("Points: %L1").arg(pointCount);
-					if (progressDialog)
-					{
-						progressDialog->setInfo(infos);
-					}
-					QApplication::processEvents();
-
-					CCCoreLib::NormalizedProgress nProgress(progressDialog, pointCount);
-					for (unsigned i = 0; i < pointCount; ++i)
-					{
-						CCVector3 P = *cloud->getPoint(i);
-						localTrans.apply(P);
-
-						// relative coordinates (between 0 and 1)
-						P -= gridOrigin;
-						P.x /= cellSizePlusGap.x;
-						P.y /= cellSizePlusGap.y;
-						P.z /= cellSizePlusGap.z;
-
-						int xi = static_cast<int>(floor(P.x));
-						xi     = std::min(std::max(xi, indexMins[0]), indexMaxs[0]);
-						int yi = static_cast<int>(floor(P.y));
-						yi     = std::min(std::max(yi, indexMins[1]), indexMaxs[1]);
-						int zi = static_cast<int>(floor(P.z));
-						zi     = std::min(std::max(zi, indexMins[2]), indexMaxs[2]);
-
-						if (gap == 0 || ((P.x - static_cast<PointCoordinateType>(xi)) * cellSizePlusGap.x <= cellSize.x && (P.y - static_cast<PointCoordinateType>(yi)) * cellSizePlusGap.y <= cellSize.y && (P.z - static_cast<PointCoordinateType>(zi)) * cellSizePlusGap.z <= cellSize.z))
-						{
-							int cloudIndex = ((zi - indexMins[2]) * static_cast<int>(gridDim[1]) + (yi - indexMins[1])) * static_cast<int>(gridDim[0]) + (xi - indexMins[0]);
-							assert(cloudIndex >= 0 && static_cast<size_t>(cloudIndex) * clouds.size() + ci < refClouds.size());
-
-							CCCoreLib::ReferenceCloud*& destCloud = refClouds[cloudIndex * clouds.size() + ci];
-							if (!destCloud)
-							{
-								destCloud = new CCCoreLib::ReferenceCloud(cloud);
-								++subCloudsCount;
-							}
-
-							if (!destCloud->addPointIndex(i))
-							{
-								ccLog::Error("Not enough memory!");
-								error = true;
-								break;
-							}
-						}
-					}
-
-					if (!nProgress.oneStep())
-					{
-						// sadly, we can't cancel in the middle of this process!
-					}
-				} // project points into grid
-
-				if (progressDialog)
-				{
-					progressDialog->setWindowTitle(QObject::tr("Section extraction"));
-					progressDialog->setInfo(QObject::tr("Section(s): %L1").arg(subCloudsCount));
-					progressDialog->setMaximum(static_cast<int>(subCloudsCount));
-					progressDialog->setValue(0);
-					QApplication::processEvents();
-				}
-
-				// reset count
-				subCloudsCount = 0;
-
-				// now create the real clouds
-				for (int i = indexMins[0]; i <= indexMaxs[0]; ++i)
-				{
-					for (int j = indexMins[1]; j <= indexMaxs[1]; ++j)
-					{
-						for (int k = indexMins[2]; k <= indexMaxs[2]; ++k)
-						{
-							int cloudIndex = ((k - indexMins[2]) * static_cast<int>(gridDim[1]) + (j - indexMins[1])) * static_cast<int>(gridDim[0]) + (i - indexMins[0]);
-							assert(cloudIndex >= 0 && static_cast<size_t>(cloudIndex) * clouds.size() < refClouds.size());
-
-							for (size_t ci = 0; ci != clouds.size(); ++ci)
-							{
-								ccGenericPointCloud*       cloud     = clouds[ci];
-								CCCoreLib::ReferenceCloud* destCloud = refClouds[cloudIndex * clouds.size() + ci];
-								if (destCloud) // some slices can be empty!
-								{
-									// generate slice from previous selection
-									int           warnings   = 0;
-									ccPointCloud* sliceCloud = cloud->isA(CC_TYPES::POINT_CLOUD) ? static_cast<ccPointCloud*>(cloud)->partialClone(destCloud, &warnings) : ccPointCloud::From(destCloud, cloud);
-									warningsIssued |= (warnings != 0);
-
-									if (sliceCloud)
-									{
-										if (generateRandomColors)
-										{
-											ccColor::Rgb col = ccColor::Generator::Random();
-											if (!sliceCloud->setColor(col))
-											{
-												ccLog::Error("Not enough memory!");
-												error = true;
-												i     = indexMaxs[0];
-												j     = indexMaxs[1];
-												k     = indexMaxs[2];
-											}
-											sliceCloud->showColors(true);
-										}
-
-										sliceCloud->setEnabled(true);
-										sliceCloud->setVisible(true);
-										sliceCloud->setDisplay(cloud->getDisplay());
-
-										CCVector3 cellOrigin(gridOrigin.x + i * cellSizePlusGap.x,
-										                     gridOrigin.y + j * cellSizePlusGap.y,
-										                     gridOrigin.z + k * cellSizePlusGap.z);
-										QString   slicePosStr = QString("(%1 ; %2 ; %3)").arg(cellOrigin.x).arg(cellOrigin.y).arg(cellOrigin.z);
-										sliceCloud->setName(cloud->getName() + QString(".slice @ ") + slicePosStr);
-
-										// set meta-data
-										sliceCloud->setMetaData(s_originEntityUUID, cloud->getUniqueID());
-										sliceCloud->setMetaData(s_sliceID, slicePosStr);
-										sliceCloud->setMetaData("slice.origin.dim(0)", cellOrigin.x);
-										sliceCloud->setMetaData("slice.origin.dim(1)", cellOrigin.y);
-										sliceCloud->setMetaData("slice.origin.dim(2)", cellOrigin.z);
-
-										// add slice to group
-										outputSlices.push_back(sliceCloud);
-										++subCloudsCount;
-
-										if (progressDialog)
-										{
-											progressDialog->setValue(static_cast<int>(subCloudsCount));
-										}
-									}
-
-									if (progressDialog && progressDialog->wasCanceled())
-									{
-										error = true;
-										ccLog::Warning(QString("[ExtractSlicesAndContours] Process canceled by user"));
-										// early stop
-										i = indexMaxs[0];
-										j = indexMaxs[1];
-										k = indexMaxs[2];
-										break;
-									}
-								}
-							}
-						}
-					}
-				} // now create the real clouds
-
-				// release memory
-				{
-					for (size_t i = 0; i < refClouds.size(); ++i)
-						if (refClouds[i])
-							delete refClouds[i];
-					refClouds.clear();
+					// error message already issued
+					error = true;
 				}
 
 				cloudSliceCount = outputSlices.size();
 
 			} // extract sections from clouds
 
-			if (!meshes.empty()) // extract sections from meshes
+			if (!error && !meshes.empty()) // extract sections from meshes
 			{
 				// compute 'grid' extents in the local clipping box ref.
 				ccBBox localBox;
@@ -870,10 +1383,7 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 					}
 				}
 
-				int      indexMins[3]{0, 0, 0};
-				int      indexMaxs[3]{0, 0, 0};
-				int      gridDim[3]{0, 0, 0};
-				unsigned cellCount = ComputeGridDimensions(localBox, repeatDimensions, indexMins, indexMaxs, gridDim, gridOrigin, cellSizePlusGap);
+				grid.cellCount = ComputeGridDimensions(localBox, repeatDimensions, grid.indexMins, grid.indexMaxs, grid.gridDim, gridOrigin, cellSizePlusGap);
 
 				const ccGLMatrix* _transformation = nullptr;
 				ccGLMatrix        transformation;
@@ -883,88 +1393,12 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 					_transformation = &transformation;
 				}
 
-				if (progressDialog)
+				if (grid.cellCount == 0 || !ExtractRepeatedMeshSlices(meshes, _transformation, grid, generateRandomColors, progressDialog, outputSlices))
 				{
-					progressDialog->setWindowTitle("Section extraction");
-					progressDialog->setInfo(QObject::tr("Up to (%1 x %2 x %3) = %4 section(s)").arg(gridDim[0]).arg(gridDim[1]).arg(gridDim[2]).arg(cellCount));
-					progressDialog->setMaximum(static_cast<int>(cellCount * meshes.size()));
-					progressDialog->show();
-					QApplication::processEvents();
+					// error message already issued
+					error = true;
 				}
 
-				// now extract the slices
-				for (int i = indexMins[0]; i <= indexMaxs[0]; ++i)
-				{
-					for (int j = indexMins[1]; j <= indexMaxs[1]; ++j)
-					{
-						for (int k = indexMins[2]; k <= indexMaxs[2]; ++k)
-						{
-							int sliceIndex = ((k - indexMins[2]) * static_cast<int>(gridDim[1]) + (j - indexMins[1])) * static_cast<int>(gridDim[0]) + (i - indexMins[0]);
-
-							CCVector3 C = gridOrigin + CCVector3(i * cellSizePlusGap.x, j * cellSizePlusGap.y, k * cellSizePlusGap.z);
-							ccBBox    cropBox(C, C + cellSize, true);
-
-							for (size_t mi = 0; mi != meshes.size(); ++mi)
-							{
-								ccGenericMesh* mesh       = meshes[mi];
-								ccHObject*     croppedEnt = ccCropTool::Crop(mesh, cropBox, true, _transformation);
-								if (croppedEnt)
-								{
-									if (generateRandomColors)
-									{
-										ccPointCloud* croppedVertices = ccHObjectCaster::ToPointCloud(mesh->getAssociatedCloud());
-										if (croppedVertices)
-										{
-											ccColor::Rgb col = ccColor::Generator::Random();
-											if (!croppedVertices->setColor(col))
-											{
-												ccLog::Error("Not enough memory!");
-												error = true;
-												i     = indexMaxs[0];
-												j     = indexMaxs[1];
-												k     = indexMaxs[2];
-											}
-											croppedVertices->showColors(true);
-											mesh->showColors(true);
-										}
-									}
-
-									croppedEnt->setEnabled(true);
-									croppedEnt->setVisible(true);
-									croppedEnt->setDisplay(mesh->getDisplay());
-
-									QString slicePosStr = QString("(%1 ; %2 ; %3)").arg(C.x).arg(C.y).arg(C.z);
-									croppedEnt->setName(mesh->getName() + QString(".slice @ ") + slicePosStr);
-
-									// set meta-data
-									croppedEnt->setMetaData(s_originEntityUUID, mesh->getUniqueID());
-									croppedEnt->setMetaData(s_sliceID, slicePosStr);
-									croppedEnt->setMetaData("slice.origin.dim(0)", C.x);
-									croppedEnt->setMetaData("slice.origin.dim(1)", C.y);
-									croppedEnt->setMetaData("slice.origin.dim(2)", C.z);
-
-									// add slice to group
-									outputSlices.push_back(croppedEnt);
-								}
-
-								if (progressDialog)
-								{
-									if (progressDialog->wasCanceled())
-									{
-										error = true;
-										ccLog::Warning(QString("[ExtractSlicesAndContours] Process canceled by user"));
-										// early stop
-										i = indexMaxs[0];
-										j = indexMaxs[1];
-										k = indexMaxs[2];
-										break;
-									}
-									progressDialog->setValue(sliceIndex * static_cast<int>(meshes.size()) + static_cast<int>(mi));
-								}
-							}
-						}
-					}
-				}
 			} // extract sections from meshes
 
 		} // repeat mode
@@ -972,59 +1406,76 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 		// extract level set (optionaly)
 		if (!error && extractLevelSet && cloudSliceCount != 0)
 		{
-			for (int iteration = 0; iteration < 1; ++iteration) // fake loop for easy break
+			if (progressDialog)
 			{
-				if (progressDialog)
-				{
-					progressDialog->setWindowTitle("Level set extraction");
-					progressDialog->setInfo(QObject::tr("Level(s): %L1").arg(cloudSliceCount));
-					progressDialog->setMaximum(static_cast<int>(cloudSliceCount));
-					progressDialog->show();
-					QApplication::processEvents();
-				}
+				progressDialog->setWindowTitle("Level set extraction");
+				progressDialog->setInfo(QObject::tr("Level(s): %L1").arg(cloudSliceCount));
+				progressDialog->setMaximum(100);
+				progressDialog->setValue(0);
+				progressDialog->show();
+				QApplication::processEvents();
+			}
 
-				int Z = 2;
-				assert(repeatDimensionsSum == 1);
+			int Z = 2;
+			assert(repeatDimensionsSum == 1);
+			{
+				for (int i = 0; i < 3; ++i)
 				{
-					for (int i = 0; i < 3; ++i)
+					if (repeatDimensions[i])
 					{
-						if (repeatDimensions[i])
-						{
-							Z = i;
-							break;
-						}
+						Z = i;
+						break;
 					}
 				}
-				int X = (Z == 2 ? 0 : Z + 1);
-				int Y = (X == 2 ? 0 : X + 1);
+			}
+			int X = (Z == 2 ? 0 : Z + 1);
+			int Y = (X == 2 ? 0 : X + 1);
 
-				CCVector3  gridOrigin  = clipBox.getOwnBB().minCorner();
-				CCVector3  gridSize    = clipBox.getOwnBB().getDiagVec();
-				ccGLMatrix globalTrans = localTrans.inverse();
+			CCVector3  gridOrigin  = clipBox.getOwnBB().minCorner();
+			CCVector3  gridSize    = clipBox.getOwnBB().getDiagVec();
+			ccGLMatrix globalTrans = localTrans.inverse();
 
-				assert(false == CCCoreLib::LessThanEpsilon(levelSetGridStep));
-				unsigned gridWidth  = 1 + static_cast<unsigned>(gridSize.u[X] / levelSetGridStep + 0.5);
-				unsigned gridHeight = 1 + static_cast<unsigned>(gridSize.u[Y] / levelSetGridStep + 0.5);
+			assert(false == CCCoreLib::LessThanEpsilon(levelSetGridStep));
+			unsigned gridWidth  = 1 + static_cast<unsigned>(gridSize.u[X] / levelSetGridStep + 0.5);
+			unsigned gridHeight = 1 + static_cast<unsigned>(gridSize.u[Y] / levelSetGridStep + 0.5);
 
-				// add a margin to avoid issues in the level set generation
-				gridWidth += 2;
-				gridHeight += 2;
-				gridOrigin.u[X] -= levelSetGridStep;
-				gridOrigin.u[Y] -= levelSetGridStep;
+			// add a margin to avoid issues in the level set generation
+			gridWidth += 2;
+			gridHeight += 2;
+			gridOrigin.u[X] -= levelSetGridStep;
+			gridOrigin.u[Y] -= levelSetGridStep;
 
+			// process all the slices originating from point clouds (in parallel)
+			assert(cloudSliceCount <= outputSlices.size());
+			std::vector<std::vector<ccPolyline*>> sliceContours(cloudSliceCount);
+			std::vector<char>                     sliceFailed(cloudSliceCount, 0);
+			std::atomic<bool>                     cancelled(false);
+			std::atomic<bool>                     notEnoughMemory(false);
+			CCCoreLib::NormalizedProgress         nProgress(progressDialog, static_cast<unsigned>(cloudSliceCount));
+			int                                   sliceCount = static_cast<int>(cloudSliceCount);
+
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+			{
+				// one grid per thread
 				ccRasterGrid grid;
 				if (!grid.init(gridWidth, gridHeight, levelSetGridStep, CCVector3d(0, 0, 0)))
 				{
-					ccLog::Error("Not enough memory!");
-					error = true;
-					break;
+					notEnoughMemory = true;
 				}
 
-				// process all the slices originating from point clouds
-				assert(cloudSliceCount <= outputSlices.size());
-				for (size_t i = 0; i < cloudSliceCount; ++i)
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic)
+#endif
+				for (int si = 0; si < sliceCount; ++si)
 				{
-					ccPointCloud* sliceCloud = ccHObjectCaster::ToPointCloud(outputSlices[i]);
+					if (cancelled || notEnoughMemory)
+					{
+						continue;
+					}
+
+					ccPointCloud* sliceCloud = ccHObjectCaster::ToPointCloud(outputSlices[si]);
 					assert(sliceCloud);
 
 					double sliceZ = sliceCloud->getMetaData(QString("slice.origin.dim(%1)").arg(Z)).toDouble();
@@ -1070,63 +1521,79 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 
 					// now extract the contour lines
 					ccContourLinesGenerator::Parameters params;
-					params.emptyCellsValue = std::numeric_limits<double>::quiet_NaN();
-					params.minVertexCount  = levelSetMinVertCount;
-					params.parentWidget    = progressDialog->parentWidget();
-					params.startAltitude   = 0.0;
-					params.maxAltitude     = 1.0;
-					params.step            = 1.0;
-
-					std::vector<ccPolyline*> contours;
-					if (ccContourLinesGenerator::GenerateContourLines(&grid, CCVector2d(gridOrigin.u[X], gridOrigin.u[Y]), params, contours))
+					params.emptyCellsValue    = std::numeric_limits<double>::quiet_NaN();
+					params.minVertexCount     = levelSetMinVertCount;
+					params.showProgressDialog = false; // we are in a worker thread
+					params.startAltitude      = 0.0;
+					params.maxAltitude        = 1.0;
+					params.step               = 1.0;
+
+					std::vector<ccPolyline*>& contours = sliceContours[si];
+					try
 					{
-						for (size_t k = 0; k < contours.size(); ++k)
+						if (ccContourLinesGenerator::GenerateContourLines(&grid, CCVector2d(gridOrigin.u[X], gridOrigin.u[Y]), params, contours))
 						{
-							ccPolyline*                            poly     = contours[k];
-							CCCoreLib::GenericIndexedCloudPersist* vertices = poly->getAssociatedCloud();
-							for (unsigned pi = 0; pi < vertices->size(); ++pi)
+							for (size_t k = 0; k < contours.size(); ++k)
 							{
-								// convert the vertices from the local coordinate system to the global one
-								const CCVector3* Pconst = vertices->getPoint(pi);
-								CCVector3        P;
-								P.u[X]                          = Pconst->x;
-								P.u[Y]                          = Pconst->y;
-								P.u[Z]                          = sliceZ;
-								*const_cast<CCVector3*>(Pconst) = globalTrans * P;
-							}
-
-							static char s_dimNames[3] = {'X', 'Y', 'Z'};
-							poly->setName(QString("Contour line %1=%2 (#%3)").arg(s_dimNames[Z]).arg(sliceZ).arg(k + 1));
-							poly->copyGlobalShiftAndScale(*sliceCloud);
-							poly->setMetaData(ccPolyline::MetaKeyConstAltitude(), QVariant(sliceZ)); // replace the 'altitude' meta-data by the right value
+								ccPolyline*                            poly     = contours[k];
+								CCCoreLib::GenericIndexedCloudPersist* vertices = poly->getAssociatedCloud();
+								for (unsigned pi = 0; pi < vertices->size(); ++pi)
+								{
+									// convert the vertices from the local coordinate system to the global one
+									const CCVector3* Pconst = vertices->getPoint(pi);
+									CCVector3        P;
+									P.u[X]                          = Pconst->x;
+									P.u[Y]                          = Pconst->y;
+									P.u[Z]                          = sliceZ;
+									*const_cast<CCVector3*>(Pconst) = globalTrans * P;
+								}
 
-							// set meta-data
-							poly->setMetaData(s_originEntityUUID, sliceCloud->getMetaData(s_originEntityUUID));
-							poly->setMetaData(s_sliceID, sliceCloud->getMetaData(s_sliceID));
-							poly->setMetaData("slice.origin.dim(0)", sliceCloud->getMetaData("slice.origin.dim(0)"));
-							poly->setMetaData("slice.origin.dim(1)", sliceCloud->getMetaData("slice.origin.dim(1)"));
-							poly->setMetaData("slice.origin.dim(2)", sliceCloud->getMetaData("slice.origin.dim(2)"));
+								static const char s_dimNames[3] = {'X', 'Y', 'Z'};
+								poly->setName(QString("Contour line %1=%2 (#%3)").arg(s_dimNames[Z]).arg(sliceZ).arg(k + 1));
+								poly->copyGlobalShiftAndScale(*sliceCloud);
+								poly->setMetaData(ccPolyline::MetaKeyConstAltitude(), QVariant(sliceZ)); // replace the 'altitude' meta-data by the right value
 
-							levelSet.push_back(poly);
+								// set meta-data
+								CopySliceMetaData(poly, sliceCloud);
+							}
+						}
+						else
+						{
+							sliceFailed[si] = 1;
 						}
 					}
-					else
+					catch (const std::bad_alloc&)
 					{
-						ccLog::Warning(tr("Failed to generate contour lines for cloud #%1").arg(i + 1));
+						notEnoughMemory = true;
 					}
 
-					if (progressDialog)
+					if (!nProgress.oneStep())
 					{
-						if (progressDialog->wasCanceled())
-						{
-							error = true;
-							ccLog::Warning(tr("[ExtractSlicesAndContours] Process canceled by user"));
-							break;
-						}
-						progressDialog->setValue(static_cast<int>(i) + 1);
+						cancelled = true;
 					}
 				}
 			}
+
+			// gather the contour lines (in the slices order)
+			for (size_t i = 0; i < cloudSliceCount; ++i)
+			{
+				if (sliceFailed[i])
+				{
+					ccLog::Warning(tr("Failed to generate contour lines for cloud #%1").arg(i + 1));
+				}
+				levelSet.insert(levelSet.end(), sliceContours[i].begin(), sliceContours[i].end());
+			}
+
+			if (notEnoughMemory)
+			{
+				ccLog::Error(tr("Not enough memory!"));
+				error = true;
+			}
+			else if (cancelled)
+			{
+				ccLog::Warning(tr("[ExtractSlicesAndContours] Process canceled by user"));
+				error = true;
+			}
 		}
 
 		// extract envelopes as polylines (optionaly)
@@ -1136,7 +1603,8 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 			{
 				progressDialog->setWindowTitle(tr("Envelope extraction"));
 				progressDialog->setInfo(tr("Envelope(s): %L1").arg(cloudSliceCount));
-				progressDialog->setMaximum(static_cast<int>(cloudSliceCount));
+				progressDialog->setMaximum(100);
+				progressDialog->setValue(0);
 				if (!visualDebugMode)
 				{
 					progressDialog->show();
@@ -1147,13 +1615,13 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 			// preferred dimension?
 			PointCoordinateType* preferredNormDir = nullptr;
 			PointCoordinateType* preferredUpDir   = nullptr;
+			ccGLMatrix           invLocalTrans    = localTrans.inverse();
 			if (repeatDimensionsSum == 1)
 			{
 				for (int i = 0; i < 3; ++i)
 				{
 					if (repeatDimensions[i])
 					{
-						ccGLMatrix invLocalTrans = localTrans.inverse();
 						if (!projectOnBestFitPlane) // otherwise the normal will be automatically computed
 							preferredNormDir = invLocalTrans.getColumn(i);
 						preferredUpDir = invLocalTrans.getColumn(i < 2 ? 2 : 0);
@@ -1165,21 +1633,33 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 			assert(cloudSliceCount <= outputSlices.size());
 
 			// process all the slices originating from point clouds
+			// (in parallel, unless the visual debug mode is enabled)
+			std::vector<CCCoreLib::GenericIndexedCloudPersist*> sliceClouds(cloudSliceCount, nullptr);
 			for (size_t i = 0; i < cloudSliceCount; ++i)
 			{
-				ccPointCloud* sliceCloud = ccHObjectCaster::ToPointCloud(outputSlices[i]);
-				assert(sliceCloud);
-
-				std::vector<ccPolyline*> polys;
-				if (ccEnvelopeExtractor::ExtractFlatEnvelope(sliceCloud,
-				                                             multiPass,
-				                                             maxEdgeLength,
-				                                             polys,
-				                                             envelopeType,
-				                                             splitEnvelopes,
-				                                             preferredNormDir,
-				                                             preferredUpDir,
-				                                             visualDebugMode))
+				sliceClouds[i] = ccHObjectCaster::ToPointCloud(outputSlices[i]);
+				assert(sliceClouds[i]);
+			}
+
+			ccEnvelopeExtractor::BatchParameters envelopeParams;
+			envelopeParams.allowMultiPass        = multiPass;
+			envelopeParams.maxEdgeLength         = maxEdgeLength;
+			envelopeParams.envelopeType          = envelopeType;
+			envelopeParams.allowSplitting        = splitEnvelopes;
+			envelopeParams.preferredNormDim      = preferredNormDir;
+			envelopeParams.preferredUpDir        = preferredUpDir;
+			envelopeParams.enableVisualDebugMode = visualDebugMode;
+
+			std::vector<std::vector<ccPolyline*>> slicePolys;
+			std::vector<bool>                     sliceSuccess;
+			ccEnvelopeExtractor::BatchResult      envelopeResult = ccEnvelopeExtractor::ExtractFlatEnvelopes(sliceClouds, envelopeParams, slicePolys, sliceSuccess, progressDialog);
+
+			// finalize the envelopes (in the slices order)
+			for (size_t i = 0; i < slicePolys.size(); ++i)
+			{
+				ccPointCloud*             sliceCloud = ccHObjectCaster::ToPointCloud(outputSlices[i]);
+				std::vector<ccPolyline*>& polys      = slicePolys[i];
+				if (sliceSuccess[i])
 				{
 					if (!polys.empty())
 					{
@@ -1199,11 +1679,7 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 							poly->setName(envelopeName);
 
 							// set meta-data
-							poly->setMetaData(s_originEntityUUID, sliceCloud->getMetaData(s_originEntityUUID));
-							poly->setMetaData(s_sliceID, sliceCloud->getMetaData(s_sliceID));
-							poly->setMetaData("slice.origin.dim(0)", sliceCloud->getMetaData("slice.origin.dim(0)"));
-							poly->setMetaData("slice.origin.dim(1)", sliceCloud->getMetaData("slice.origin.dim(1)"));
-							poly->setMetaData("slice.origin.dim(2)", sliceCloud->getMetaData("slice.origin.dim(2)"));
+							CopySliceMetaData(poly, sliceCloud);
 
 							outputEnvelopes.push_back(poly);
 						}
@@ -1216,21 +1692,24 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 				}
 				else
 				{
+					for (ccPolyline* poly : polys)
+					{
+						delete poly;
+					}
 					ccLog::Warning(tr("%1: envelope extraction failed!").arg(sliceCloud->getName()));
 					warningsIssued = true;
 				}
+			}
 
-				if (progressDialog && !visualDebugMode)
-				{
-					if (progressDialog->wasCanceled())
-					{
-						error = true;
-						ccLog::Warning(tr("[ExtractSlicesAndContours] Process canceled by user"));
-						// early stop
-						break;
-					}
-					progressDialog->setValue(static_cast<int>(i));
-				}
+			if (envelopeResult == ccEnvelopeExtractor::BATCH_NOT_ENOUGH_MEMORY)
+			{
+				ccLog::Error(tr("[ExtractSlicesAndContours] Not enough memory to extract the envelopes!"));
+				error = true;
+			}
+			else if (envelopeResult == ccEnvelopeExtractor::BATCH_CANCELLED)
+			{
+				ccLog::Warning(tr("[ExtractSlicesAndContours] Process canceled by user"));
+				error = true;
 			}
 
 		} // extract envelope polylines
@@ -1238,16 +1717,7 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 		// release memory
 		if (error)
 		{
-			for (ccHObject* slice : outputSlices)
-			{
-				delete slice;
-			}
-			outputSlices.resize(0);
-
-			for (ccPolyline* poly : outputEnvelopes)
-			{
-				delete poly;
-			}
+			ReleaseSlicesAndContours(outputSlices, outputEnvelopes, levelSet);
 			return false;
 		}
 		else if (warningsIssued)
@@ -1258,6 +1728,7 @@ bool ccClippingBoxTool::ExtractSlicesAndContours(
 	catch (const std::bad_alloc&)
 	{
 		ccLog::Error(tr("Not enough memory!"));
+		ReleaseSlicesAndContours(outputSlices, outputEnvelopes, levelSet);
 		return false;
 	}
 
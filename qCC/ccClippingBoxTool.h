@@ -94,6 +94,7 @@ class ccClippingBoxTool : public ccOverlayDialog
 	    \param visualDebugMode displays a 'debugging' window during the envelope extraction process
 	    \param generateRandomColors randomly colors the extracted slices
 	    \param progressDialog optional progress dialog
+	    \return success (on failure, the slices, envelopes and level set lines are released)
 	**/
 	static bool ExtractSlicesAndContours(
 	    const std::vector<ccGenericPointCloud*>& clouds,
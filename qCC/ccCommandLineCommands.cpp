@@ -113,6 +113,7 @@ constexpr char COMMAND_CLOSEST_POINT_SET[]                = "CLOSEST_POINT_SET";
 constexpr char COMMAND_C2C_SPLIT_XYZ[]                    = "SPLIT_XYZ";
 constexpr char COMMAND_C2C_SPLIT_XY_Z[]                   = "SPLIT_XY_Z";
 constexpr char COMMAND_C2C_LOCAL_MODEL[]                  = "MODEL";
+constexpr char COMMAND_C2C_BATCH[]                        = "BATCH";
 constexpr char COMMAND_C2X_MAX_DISTANCE[]                 = "MAX_DIST";
 constexpr char COMMAND_C2X_OCTREE_LEVEL[]                 = "OCTREE_LEVEL";
 constexpr char COMMAND_STAT_TEST[]                        = "STAT_TEST";
@@ -151,6 +152,8 @@ constexpr char COMMAND_ICP_SKIP_TX[]                      = "SKIP_TX";
 constexpr char COMMAND_ICP_SKIP_TY[]                      = "SKIP_TY";
 constexpr char COMMAND_ICP_SKIP_TZ[]                      = "SKIP_TZ";
 constexpr char COMMAND_ICP_C2M_DIST[]                     = "USE_C2M_DIST";
+constexpr char COMMAND_ICP_POINT_TO_PLANE[]               = "POINT_TO_PLANE";
+constexpr char COMMAND_ICP_BATCH[]                        = "BATCH";
 constexpr char COMMAND_PLY_EXPORT_FORMAT[]                = "PLY_EXPORT_FMT";
 constexpr char COMMAND_COMPUTE_GRIDDED_NORMALS[]          = "COMPUTE_NORMALS";
 constexpr char COMMAND_INVERT_NORMALS[]                   = "INVERT_NORMALS";
@@ -4072,6 +4075,33 @@ bool CommandOrientNormalsMST::process(ccCommandLineInterface& cmd)
 		return cmd.error(QObject::tr("Invalid parameter: number of neighbors (%1)").arg(knnStr));
 	}
 
+	// optional parameters
+	int maxThreadCount = 0;
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_MAX_THREAD_COUNT))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max thread count after '%1'").arg(COMMAND_MAX_THREAD_COUNT));
+			}
+
+			maxThreadCount = cmd.arguments().takeFirst().toInt(&ok);
+			if (!ok || maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid thread count! (after %1)").arg(COMMAND_MAX_THREAD_COUNT));
+			}
+		}
+		else
+		{
+			break; // as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
+		}
+	}
+
 	if (cmd.clouds().empty())
 	{
 		return cmd.error(QObject::tr("No cloud available. Be sure to open one first!"));
@@ -4094,7 +4124,7 @@ bool CommandOrientNormalsMST::process(ccCommandLineInterface& cmd)
 		}
 
 		// computation
-		if (desc.pc->orientNormalsWithMST(knn, progressDialog.data()))
+		if (desc.pc->orientNormalsWithMST(knn, progressDialog.data(), maxThreadCount))
 		{
 			desc.basename += QObject::tr("_NORMS_REORIENTED");
 			if (cmd.autoSaveMode())
@@ -5376,10 +5406,6 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 		{
 			return cmd.error(QObject::tr("Only one point cloud available. Be sure to open or generate a second one before performing C2C distance!"));
 		}
-		else if (cmd.clouds().size() > 2)
-		{
-			cmd.warning(QObject::tr("More than 3 point clouds loaded! We take the second one as reference by default"));
-		}
 		refEntity = cmd.clouds()[1].pc;
 	}
 
@@ -5396,6 +5422,7 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 	int    modelIndex = 0;
 	bool   useKNN     = true;
 	double nSize      = 0;
+	bool   batchMode  = false;
 
 	while (!cmd.arguments().empty())
 	{
@@ -5474,11 +5501,6 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 			cmd.arguments().pop_front();
 
 			splitXYZ = true;
-
-			if (m_cloud2meshDist)
-			{
-				cmd.warning(QObject::tr("Parameter \"-%1\" ignored: only for C2C distance!"));
-			}
 		}
 		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_SPLIT_XY_Z))
 		{
@@ -5487,10 +5509,17 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 
 			splitXYZ = true;
 			mergeXY  = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_BATCH))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			batchMode = true;
 
 			if (m_cloud2meshDist)
 			{
-				cmd.warning(QObject::tr("Parameter \"-%1\" ignored: only for C2C distance!"));
+				cmd.warning(QObject::tr("Parameter \"-%1\" ignored: only for C2C distance!").arg(COMMAND_C2C_BATCH));
 			}
 		}
 		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_LOCAL_MODEL))
@@ -5582,6 +5611,24 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 		}
 	}
 
+	// batch mode: all the other clouds are compared to the same reference
+	std::vector<CLEntityDesc*> batchEntities;
+	if (!m_cloud2meshDist && cmd.clouds().size() > 2)
+	{
+		if (batchMode)
+		{
+			for (size_t i = 2; i < cmd.clouds().size(); ++i)
+			{
+				batchEntities.push_back(&(cmd.clouds()[i]));
+			}
+			cmd.print(QObject::tr("[C2C] Batch mode: %1 clouds will be compared to '%2'").arg(batchEntities.size() + 1).arg(refEntity->getName()));
+		}
+		else
+		{
+			cmd.warning(QObject::tr("More than 3 point clouds loaded! We take the second one as reference by default"));
+		}
+	}
+
 	// spawn dialog (virtually) so as to prepare the comparison process
 	ccComparisonDlg compDlg(compCloud,
 	                        refEntity,
@@ -5619,15 +5666,6 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 	else
 	{
 		// C2C-only parameters
-		if (splitXYZ)
-		{
-			// DGM: not true anymore
-			// if (maxDist > 0)
-			//	cmd.warning("'Split XYZ' option is ignored if max distance is defined!");
-			compDlg.split3DCheckBox->setChecked(true);
-		}
-		if (mergeXY)
-			compDlg.compute2DCheckBox->setChecked(true);
 		if (modelIndex != 0)
 		{
 			compDlg.localModelComboBox->setCurrentIndex(modelIndex);
@@ -5644,12 +5682,34 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 		}
 	}
 
+	if (splitXYZ)
+	{
+		// DGM: not true anymore
+		// if (maxDist > 0)
+		//	cmd.warning("'Split XYZ' option is ignored if max distance is defined!");
+		compDlg.split3DCheckBox->setChecked(true);
+	}
+	if (mergeXY)
+	{
+		compDlg.compute2DCheckBox->setChecked(true);
+	}
+
 	if (!compDlg.computeDistances())
 	{
 		compDlg.cancelAndExit();
 		return cmd.error(QObject::tr("An error occurred during distances computation!"));
 	}
 
+	if (!batchEntities.empty())
+	{
+		std::vector<ccHObject*> batchClouds;
+		for (CLEntityDesc* desc : batchEntities)
+		{
+			batchClouds.push_back(desc->getEntity());
+		}
+		compDlg.setBatchEntities(batchClouds);
+	}
+
 	compDlg.applyAndExit();
 
 	QString suffix(m_cloud2meshDist ? "_C2M_DIST" : "_C2C_DIST");
@@ -5658,14 +5718,18 @@ bool CommandDist::process(ccCommandLineInterface& cmd)
 		suffix += QObject::tr("_MAX_DIST_%1").arg(maxDist);
 	}
 
-	compEntity->basename += suffix;
-
-	if (cmd.autoSaveMode())
+	batchEntities.insert(batchEntities.begin(), compEntity);
+	for (CLEntityDesc* desc : batchEntities)
 	{
-		QString errorStr = cmd.exportEntity(*compEntity);
-		if (!errorStr.isEmpty())
+		desc->basename += suffix;
+
+		if (cmd.autoSaveMode())
 		{
-			return cmd.error(errorStr);
+			QString errorStr = cmd.exportEntity(*desc);
+			if (!errorStr.isEmpty())
+			{
+				return cmd.error(errorStr);
+			}
 		}
 	}
 
@@ -6923,6 +6987,8 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 	bool                                              useC2MDistances       = false;
 	bool                                              robustC2MDistances    = true;
 	CCCoreLib::ICPRegistrationTools::NORMALS_MATCHING normalsMatching       = CCCoreLib::ICPRegistrationTools::NO_NORMAL;
+	ccICPEngine::Metric                               metric                = ccICPEngine::POINT_TO_POINT;
+	bool                                              batchMode             = false;
 
 	while (!cmd.arguments().empty())
 	{
@@ -7136,6 +7202,20 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 			// local option confirmed, we can move on
 			cmd.arguments().pop_front();
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_POINT_TO_PLANE))
+		{
+			metric = ccICPEngine::POINT_TO_PLANE;
+			cmd.print(QObject::tr("[ICP] Use point-to-plane metric"));
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_BATCH))
+		{
+			batchMode = true;
+			cmd.print(QObject::tr("[ICP] Batch mode: all the other loaded entities will be registered with the model"));
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+		}
 		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2M_DIST_NON_ROBUST))
 		{
 			robustC2MDistances = false;
@@ -7219,21 +7299,28 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 		std::swap(dataAndModel[0], dataAndModel[1]);
 	}
 
-	// check that the weights (scalar fields) exist
-	if (dataWeightsSFIndex >= 0 || !dataWeightsSFIndexName.isEmpty())
+	// data entities (several in batch mode)
+	std::vector<CLEntityDesc*> dataEntities{dataAndModel[0]};
+	if (batchMode)
 	{
-		ccPointCloud* dataAsCloud = ccHObjectCaster::ToPointCloud(dataAndModel[0]->getEntity());
-		if (dataAsCloud)
+		for (CLCloudDesc& desc : cmd.clouds())
 		{
-			dataWeightsSFIndex = GetScalarFieldIndex(dataAsCloud, dataWeightsSFIndex, dataWeightsSFIndexName, true);
-			if (dataWeightsSFIndex >= 0)
+			if (&desc != dataAndModel[0] && &desc != dataAndModel[1])
 			{
-				cmd.print(QObject::tr("[ICP] SF #%1 (data entity) will be used as weights").arg(dataWeightsSFIndex));
-				dataAsCloud->setCurrentDisplayedScalarField(dataWeightsSFIndex);
+				dataEntities.push_back(&desc);
 			}
 		}
+		for (CLMeshDesc& desc : cmd.meshes())
+		{
+			if (&desc != dataAndModel[0] && &desc != dataAndModel[1])
+			{
+				dataEntities.push_back(&desc);
+			}
+		}
+		cmd.print(QObject::tr("[ICP] %1 entities will be registered with '%2'").arg(dataEntities.size()).arg(dataAndModel[1]->getEntity()->getName()));
 	}
 
+	// check that the model weights (scalar field) exist
 	if (modelWeightsSFIndex >= 0 || !modelWeightsSFIndexName.isEmpty())
 	{
 		ccPointCloud* modelAsCloud = ccHObjectCaster::ToPointCloud(dataAndModel[1]->getEntity());
@@ -7248,11 +7335,6 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 		}
 	}
 
-	ccGLMatrix transMat;
-	double     finalError      = 0.0;
-	double     finalScale      = 1.0;
-	unsigned   finalPointCount = 0;
-
 	CCCoreLib::ICPRegistrationTools::Parameters parameters;
 	{
 		parameters.convType                 = (iterationCount != 0 ? CCCoreLib::ICPRegistrationTools::MAX_ITER_CONVERGENCE : CCCoreLib::ICPRegistrationTools::MAX_ERROR_CONVERGENCE);
@@ -7269,18 +7351,64 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 		parameters.normalsMatching          = normalsMatching;
 	}
 
-	if (ccRegistrationTools::ICP(dataAndModel[0]->getEntity(),
-	                             dataAndModel[1]->getEntity(),
-	                             transMat,
-	                             finalScale,
-	                             finalError,
-	                             finalPointCount,
-	                             parameters,
-	                             dataWeightsSFIndex >= 0,
-	                             modelWeightsSFIndex >= 0,
-	                             cmd.widgetParent()))
+	// the model index is built only once (and shared by all the data entities)
+	ccICPEngine::Model::Shared preparedModel;
+	if (ccICPEngine::CanRegister(parameters))
+	{
+		preparedModel = ccICPEngine::PrepareModel(dataAndModel[1]->getEntity(), maxThreadCount);
+		if (!preparedModel)
+		{
+			return cmd.error(QObject::tr("[ICP] Failed to build the model index (not enough memory?)"));
+		}
+	}
+
+	for (CLEntityDesc* dataDesc : dataEntities)
 	{
-		ccHObject* data = dataAndModel[0]->getEntity();
+		ccHObject* data = dataDesc->getEntity();
+
+		// check that the data weights (scalar field) exist
+		bool useDataWeights = false;
+		if (dataWeightsSFIndex >= 0 || !dataWeightsSFIndexName.isEmpty())
+		{
+			ccPointCloud* dataAsCloud = ccHObjectCaster::ToPointCloud(data);
+			if (dataAsCloud)
+			{
+				int sfIndex = GetScalarFieldIndex(dataAsCloud, dataWeightsSFIndex, dataWeightsSFIndexName, true);
+				if (sfIndex >= 0)
+				{
+					cmd.print(QObject::tr("[ICP] SF #%1 (data entity) will be used as weights").arg(sfIndex));
+					dataAsCloud->setCurrentDisplayedScalarField(sfIndex);
+					useDataWeights = true;
+				}
+			}
+		}
+
+		ccGLMatrix transMat;
+		double     finalError      = 0.0;
+		double     finalScale      = 1.0;
+		unsigned   finalPointCount = 0;
+
+		if (!ccRegistrationTools::ICP(data,
+		                              dataAndModel[1]->getEntity(),
+		                              transMat,
+		                              finalScale,
+		                              finalError,
+		                              finalPointCount,
+		                              parameters,
+		                              useDataWeights,
+		                              modelWeightsSFIndex >= 0,
+		                              cmd.widgetParent(),
+		                              metric,
+		                              preparedModel))
+		{
+			if (batchMode)
+			{
+				cmd.warning(QObject::tr("Failed to register entity '%1'").arg(data->getName()));
+				continue;
+			}
+			return false;
+		}
+
 		data->applyGLTransformation_recursive(&transMat);
 		cmd.print(QObject::tr("Entity '%1' has been registered").arg(data->getName()));
 		cmd.print(QObject::tr("RMS: %1").arg(finalError));
@@ -7288,7 +7416,7 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 
 		// save matrix in a separate text file
 		{
-			QString txtFilename = QObject::tr("%1/%2_REGISTRATION_MATRIX").arg(dataAndModel[0]->path, dataAndModel[0]->basename);
+			QString txtFilename = QObject::tr("%1/%2_REGISTRATION_MATRIX").arg(dataDesc->path, dataDesc->basename);
 			if (cmd.addTimestamp())
 			{
 				QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh'h'mm_ss_zzz");
@@ -7308,20 +7436,16 @@ bool CommandICP::process(ccCommandLineInterface& cmd)
 			}
 		}
 
-		dataAndModel[0]->basename += QObject::tr("_REGISTERED");
+		dataDesc->basename += QObject::tr("_REGISTERED");
 		if (cmd.autoSaveMode())
 		{
-			QString errorStr = cmd.exportEntity(*dataAndModel[0]);
+			QString errorStr = cmd.exportEntity(*dataDesc);
 			if (!errorStr.isEmpty())
 			{
 				return cmd.error(errorStr);
 			}
 		}
 	}
-	else
-	{
-		return false;
-	}
 
 	return true;
 }
@@ -4,6 +4,7 @@
 #include "ccCommandCrossSection.h"
 #include "ccCommandLineCommands.h"
 #include "ccCommandRaster.h"
+#include "ccCommandSectionExtraction.h"
 #include "ccPluginInterface.h"
 
 // qCC_db
@@ -892,6 +893,7 @@ void ccCommandLineParser::registerBuiltInCommands()
 	registerCommand(Command::Shared(new CommandCompressFWF));
 	registerCommand(Command::Shared(new CommandExtractVertices));
 	registerCommand(Command::Shared(new CommandCrossSection));
+	registerCommand(Command::Shared(new CommandSectionExtraction));
 	registerCommand(Command::Shared(new CommandCrop));
 	registerCommand(Command::Shared(new CommandCrop2D));
 	registerCommand(Command::Shared(new CommandCoordToSF));
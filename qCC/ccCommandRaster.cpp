@@ -1,5 +1,6 @@
 
 // local
+#include "ccContourLinesGenerator.h"
 #include "ccRasterizeTool.h"
 
 // Qt
@@ -11,6 +12,7 @@
 
 #include <QDateTime>
 #include <ccMesh.h>
+#include <ccPolyline.h>
 #include <ccProgressDialog.h>
 #include <ccVolumeCalcTool.h>
 
@@ -42,6 +44,9 @@ constexpr char COMMAND_RASTER_PROJ_AVG[]               = "AVG";
 constexpr char COMMAND_RASTER_PROJ_MED[]               = "MED";
 constexpr char COMMAND_RASTER_PROJ_INVERSE_VAR[]       = "INV_VAR";
 constexpr char COMMAND_RASTER_RESAMPLE[]               = "RESAMPLE";
+constexpr char COMMAND_RASTER_CONTOURS[]               = "CONTOURS";
+constexpr char COMMAND_RASTER_CONTOUR_START[]          = "CONTOUR_START";
+constexpr char COMMAND_RASTER_CONTOUR_SIMPLIFY[]       = "CONTOUR_SIMPLIFY";
 
 // 2.5D Volume calculation specific commands
 constexpr char COMMAND_VOLUME[]                 = "VOLUME";
@@ -148,6 +153,9 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 	ccRasterGrid::EmptyCellFillOption         emptyCellFillStrategy = ccRasterGrid::LEAVE_EMPTY;
 	ccRasterGrid::DelaunayInterpolationParams dInterpParams;
 	ccRasterGrid::KrigingParams               krigingParams;
+	double                                    contourStep           = 0;
+	double                                    contourStart          = std::numeric_limits<double>::quiet_NaN();
+	double                                    contourSimplification = 0;
 	{
 		// force auto-guess
 		krigingParams.autoGuess = true;
@@ -244,6 +252,42 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 				return cmd.error(QString("Invalid vert. direction! (after %1)").arg(COMMAND_GRID_VERT_DIR));
 			}
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RASTER_CONTOURS))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok;
+			contourStep = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || contourStep <= 0)
+			{
+				return cmd.error(QString("Invalid contour step value! (after %1)").arg(COMMAND_RASTER_CONTOURS));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RASTER_CONTOUR_START))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok;
+			contourStart = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok)
+			{
+				return cmd.error(QString("Invalid contour start value! (after %1)").arg(COMMAND_RASTER_CONTOUR_START));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RASTER_CONTOUR_SIMPLIFY))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok;
+			contourSimplification = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || contourSimplification < 0)
+			{
+				return cmd.error(QString("Invalid contour simplification tolerance! (after %1)").arg(COMMAND_RASTER_CONTOUR_SIMPLIFY));
+			}
+		}
 		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_RASTER_FILL_EMPTY_CELLS))
 		{
 			// local option confirmed, we can move on
@@ -341,7 +385,7 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 		}
 	}
 
-	if (!outputCloud && !outputMesh && !outputRasterZ && !outputRasterRGB)
+	if (!outputCloud && !outputMesh && !outputRasterZ && !outputRasterRGB && contourStep <= 0)
 	{
 		// if no export target is specified, we chose the cloud by default
 		outputCloud = true;
@@ -461,6 +505,69 @@ bool CommandRasterize::process(ccCommandLineInterface& cmd)
 			}
 		}
 
+		// generate the contour lines
+		if (contourStep > 0)
+		{
+			ccContourLinesGenerator::Parameters contourParams;
+			contourParams.startAltitude           = std::isnan(contourStart) ? grid.minHeight : contourStart;
+			contourParams.maxAltitude             = grid.maxHeight;
+			contourParams.step                    = contourStep;
+			contourParams.emptyCellsValue         = std::min(contourParams.startAltitude, grid.minHeight) - 1.0; // the contour lines are closed around the empty cells
+			contourParams.simplificationTolerance = contourSimplification;
+			contourParams.ignoreBorders           = true;
+			contourParams.parentWidget            = cmd.widgetParent();
+			contourParams.showProgressDialog      = !cmd.silentMode();
+
+			// the contour lines are generated in the grid plane
+			const unsigned char Z = static_cast<unsigned char>(vertDir);
+			const unsigned char X = (Z == 2 ? 0 : Z + 1);
+			const unsigned char Y = (X == 2 ? 0 : X + 1);
+
+			std::vector<ccPolyline*> contourLines;
+			if (contourParams.startAltitude > contourParams.maxAltitude)
+			{
+				cmd.warning("[Rasterize] The contour start value is above the maximum height (no contour line generated)");
+			}
+			else if (!ccContourLinesGenerator::GenerateContourLines(&grid, CCVector2d(grid.minCorner.u[X], grid.minCorner.u[Y]), contourParams, contourLines))
+			{
+				return cmd.error("Failed to generate the contour lines");
+			}
+
+			if (!contourLines.empty())
+			{
+				ccHObject contourGroup(QString("Contour plot(%1) [step=%2]").arg(cloudDesc.pc->getName()).arg(contourStep));
+				for (ccPolyline* poly : contourLines)
+				{
+					// map the polyline coordinates to the right dimensions
+					ccPointCloud* vertices = dynamic_cast<ccPointCloud*>(poly->getAssociatedCloud());
+					if (vertices && Z != 2)
+					{
+						for (unsigned j = 0; j < vertices->size(); ++j)
+						{
+							CCVector3* P = const_cast<CCVector3*>(vertices->getPoint(j));
+							CCVector3  Q = *P;
+							P->u[X]      = Q.x;
+							P->u[Y]      = Q.y;
+							P->u[Z]      = Q.z;
+						}
+						vertices->invalidateBoundingBox();
+						poly->invalidateBoundingBox();
+					}
+					poly->copyGlobalShiftAndScale(*cloudDesc.pc);
+					contourGroup.addChild(poly);
+				}
+
+				cmd.print(QString("[Rasterize] %1 contour line(s) generated").arg(contourLines.size()));
+
+				CLGroupDesc desc(&contourGroup, cloudDesc.basename + QString("_CONTOURS"), cloudDesc.path);
+				QString     errorStr = cmd.exportEntity(desc, QString(), nullptr, ccCommandLineInterface::ExportOption::ForceHierarchy);
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+
 		// generate the result entity (cloud by default)
 		if (outputCloud || outputMesh)
 		{
@@ -0,0 +1,344 @@
+#include "ccCommandSectionExtraction.h"
+
+#include "ccSectionExtractor.h"
+
+#include <QScopedPointer>
+#include <ccPointCloud.h>
+#include <ccPolyline.h>
+#include <ccProgressDialog.h>
+
+constexpr char COMMAND_EXTRACT_SECTIONS[]          = "EXTRACT_SECTIONS";
+constexpr char COMMAND_SECTIONS_THICKNESS[]        = "THICKNESS";
+constexpr char COMMAND_SECTIONS_VERT_DIR[]         = "VERT_DIR";
+constexpr char COMMAND_SECTIONS_ENVELOPE[]         = "ENVELOPE";
+constexpr char COMMAND_SECTIONS_ENVELOPE_LOWER[]   = "LOWER";
+constexpr char COMMAND_SECTIONS_ENVELOPE_UPPER[]   = "UPPER";
+constexpr char COMMAND_SECTIONS_ENVELOPE_FULL[]    = "FULL";
+constexpr char COMMAND_SECTIONS_NO_ENVELOPE[]      = "NO_ENVELOPE";
+constexpr char COMMAND_SECTIONS_MAX_EDGE_LENGTH[]  = "MAX_EDGE_LENGTH";
+constexpr char COMMAND_SECTIONS_MULTI_PASS[]       = "MULTI_PASS";
+constexpr char COMMAND_SECTIONS_SPLIT[]            = "SPLIT";
+constexpr char COMMAND_SECTIONS_CLOUDS[]           = "CLOUDS";
+constexpr char COMMAND_SECTIONS_UNFOLD[]           = "UNFOLD";
+constexpr char COMMAND_SECTIONS_MAX_THREAD_COUNT[] = "MAX_TCOUNT";
+
+CommandSectionExtraction::CommandSectionExtraction()
+    : ccCommandLineInterface::Command("Extract sections", COMMAND_EXTRACT_SECTIONS)
+{
+}
+
+bool CommandSectionExtraction::process(ccCommandLineInterface& cmd)
+{
+	cmd.print("[EXTRACT SECTIONS]");
+
+	// expected argument: polylines file
+	if (cmd.arguments().empty())
+		return cmd.error(QString("Missing parameter: polyline(s) file after \"-%1\"").arg(COMMAND_EXTRACT_SECTIONS));
+	QString polylinesFilename = cmd.arguments().takeFirst();
+
+	ccSectionExtractor::Parameters params;
+	params.thickness = -1;
+	bool unfold      = false;
+
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_THICKNESS))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok = false;
+			if (!cmd.arguments().empty())
+				params.thickness = static_cast<PointCoordinateType>(cmd.arguments().takeFirst().toDouble(&ok));
+			if (!ok || params.thickness <= 0)
+			{
+				return cmd.error(QString("Invalid thickness value! (after %1)").arg(COMMAND_SECTIONS_THICKNESS));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_VERT_DIR))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok      = false;
+			int  vertDir = -1;
+			if (!cmd.arguments().empty())
+				vertDir = cmd.arguments().takeFirst().toInt(&ok);
+			if (!ok || vertDir < 0 || vertDir > 2)
+			{
+				return cmd.error(QString("Invalid vert. direction! (after %1)").arg(COMMAND_SECTIONS_VERT_DIR));
+			}
+			params.vertDim = static_cast<unsigned char>(vertDir);
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_ENVELOPE))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			QString type = (cmd.arguments().empty() ? QString() : cmd.arguments().takeFirst().toUpper());
+			if (type == COMMAND_SECTIONS_ENVELOPE_LOWER)
+			{
+				params.envelopeType = ccEnvelopeExtractor::LOWER;
+			}
+			else if (type == COMMAND_SECTIONS_ENVELOPE_UPPER)
+			{
+				params.envelopeType = ccEnvelopeExtractor::UPPER;
+			}
+			else if (type == COMMAND_SECTIONS_ENVELOPE_FULL)
+			{
+				params.envelopeType = ccEnvelopeExtractor::FULL;
+			}
+			else
+			{
+				return cmd.error(QString("Invalid envelope type! (after %1)").arg(COMMAND_SECTIONS_ENVELOPE));
+			}
+			params.extractEnvelopes = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_NO_ENVELOPE))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			params.extractEnvelopes = false;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_MAX_EDGE_LENGTH))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok = false;
+			if (!cmd.arguments().empty())
+				params.maxEdgeLength = static_cast<PointCoordinateType>(cmd.arguments().takeFirst().toDouble(&ok));
+			if (!ok || params.maxEdgeLength < 0)
+			{
+				return cmd.error(QString("Invalid max edge length value! (after %1)").arg(COMMAND_SECTIONS_MAX_EDGE_LENGTH));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_MULTI_PASS))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			params.multiPass = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_SPLIT))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			params.splitEnvelopes = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_CLOUDS))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			params.extractClouds = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_UNFOLD))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			unfold = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SECTIONS_MAX_THREAD_COUNT))
+		{
+			// local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			bool ok = false;
+			if (!cmd.arguments().empty())
+				params.maxThreadCount = cmd.arguments().takeFirst().toInt(&ok);
+			if (!ok || params.maxThreadCount < 0)
+			{
+				return cmd.error(QString("Invalid thread count! (after %1)").arg(COMMAND_SECTIONS_MAX_THREAD_COUNT));
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QString("No cloud loaded (a cloud must be loaded before \"-%1\")").arg(COMMAND_EXTRACT_SECTIONS));
+	}
+	if (params.thickness <= 0)
+	{
+		return cmd.error(QString("Missing parameter: section thickness (\"-%1\")").arg(COMMAND_SECTIONS_THICKNESS));
+	}
+	if (params.splitEnvelopes && params.maxEdgeLength <= 0)
+	{
+		return cmd.error(QString("A max edge length (\"-%1\") is required to split the envelopes").arg(COMMAND_SECTIONS_MAX_EDGE_LENGTH));
+	}
+
+	// load the polylines
+	ccHObject container("Sections");
+	{
+		CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+		ccHObject*    db     = FileIOFilter::LoadFromFile(polylinesFilename, cmd.fileLoadingParams(), result, QString());
+		if (!db)
+		{
+			return cmd.error(QString("Failed to load file '%1'").arg(polylinesFilename));
+		}
+
+		ccHObject::Container entities;
+		db->filterChildren(entities, true, CC_TYPES::POLY_LINE);
+		for (ccHObject* entity : entities)
+		{
+			ccHObject* parent = entity->getParent();
+			if (parent)
+			{
+				parent->detachChild(entity);
+			}
+			container.addChild(entity);
+		}
+		delete db;
+		db = nullptr;
+	}
+
+	std::vector<ccPolyline*> polylines;
+	for (unsigned i = 0; i < container.getChildrenNumber(); ++i)
+	{
+		ccPolyline* poly = static_cast<ccPolyline*>(container.getChild(i));
+		if (poly->size() < 2)
+		{
+			cmd.warning(QString("Polyline '%1' has less than 2 vertices and will be ignored").arg(poly->getName()));
+		}
+		polylines.push_back(poly);
+	}
+	if (polylines.empty())
+	{
+		return cmd.error(QString("No polyline found in file '%1'").arg(polylinesFilename));
+	}
+	cmd.print(QString("%1 section(s) loaded").arg(polylines.size()));
+
+	std::vector<ccGenericPointCloud*> clouds;
+	std::vector<CLCloudDesc>          cloudDescs = cmd.clouds();
+	ccBBox                            box;
+	for (const CLCloudDesc& desc : cloudDescs)
+	{
+		clouds.push_back(desc.pc);
+		box += desc.pc->getOwnBB();
+	}
+
+	QScopedPointer<ccProgressDialog> pDlg;
+	if (!cmd.silentMode())
+	{
+		pDlg.reset(new ccProgressDialog(true, cmd.widgetParent()));
+	}
+
+	if (unfold)
+	{
+		std::vector<ccPointCloud*> unfoldedClouds;
+		if (!ccSectionExtractor::UnfoldClouds(clouds, polylines, params.thickness, params.vertDim, box.minCorner(), unfoldedClouds, params.maxThreadCount, pDlg.data()))
+		{
+			return cmd.error("Failed to unfold the clouds");
+		}
+
+		for (size_t p = 0; p < polylines.size(); ++p)
+		{
+			for (size_t c = 0; c < cloudDescs.size(); ++c)
+			{
+				ccPointCloud* unfoldedCloud = unfoldedClouds[p * cloudDescs.size() + c];
+				if (!unfoldedCloud)
+				{
+					continue;
+				}
+				const CLCloudDesc& desc = cloudDescs[c];
+				unfoldedCloud->setName(desc.pc->getName() + ".unfolded");
+				unfoldedCloud->copyGlobalShiftAndScale(*desc.pc);
+				unfoldedCloud->shrinkToFit();
+
+				// add the resulting cloud to the main set
+				QString basename = desc.basename + QString("_UNFOLDED");
+				if (polylines.size() > 1)
+					basename += QString("_%1").arg(p + 1);
+				cmd.print(QString("Unfolded cloud created: %1 points").arg(unfoldedCloud->size()));
+				cmd.clouds().emplace_back(unfoldedCloud, basename, desc.path);
+
+				// save it as well
+				if (cmd.autoSaveMode())
+				{
+					QString errorStr = cmd.exportEntity(cmd.clouds().back());
+					if (!errorStr.isEmpty())
+					{
+						return cmd.error(errorStr);
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	std::vector<ccSectionExtractor::Section> sections;
+	if (!ccSectionExtractor::ExtractSections(clouds, polylines, params, sections, pDlg.data()))
+	{
+		return cmd.error("Failed to extract the sections");
+	}
+
+	const CLCloudDesc& firstDesc = cloudDescs.front();
+	ccHObject          envelopes("Section envelopes");
+	for (size_t s = 0; s < sections.size(); ++s)
+	{
+		ccSectionExtractor::Section& section = sections[s];
+
+		for (size_t p = 0; p < section.envelopes.size(); ++p)
+		{
+			ccPolyline* envelopePart = section.envelopes[p];
+			QString     name         = QString("Section envelope #%1").arg(s + 1);
+			if (section.envelopes.size() > 1)
+			{
+				name += QString("(part %1/%2)").arg(p + 1).arg(section.envelopes.size());
+			}
+			envelopePart->setName(name);
+			// copy meta-data
+			{
+				const QVariantMap& metaData = polylines[s]->metaData();
+				for (QVariantMap::const_iterator it = metaData.begin(); it != metaData.end(); ++it)
+				{
+					envelopePart->setMetaData(it.key(), it.value());
+				}
+			}
+			envelopes.addChild(envelopePart);
+		}
+		section.envelopes.clear();
+
+		if (section.cloud)
+		{
+			section.cloud->setName(QString("Section cloud #%1").arg(s + 1));
+
+			// add the resulting cloud to the main set
+			cmd.clouds().emplace_back(section.cloud, firstDesc.basename + QString("_SECTION_%1").arg(s + 1), firstDesc.path);
+			section.cloud = nullptr;
+
+			// save it as well
+			if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cmd.clouds().back());
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+
+	if (envelopes.getChildrenNumber() != 0)
+	{
+		cmd.print(QString("%1 envelope(s) extracted").arg(envelopes.getChildrenNumber()));
+
+		CLGroupDesc desc(&envelopes, firstDesc.basename + QString("_SECTION_ENVELOPES"), firstDesc.path);
+		QString     errorStr = cmd.exportEntity(desc, QString(), nullptr, ccCommandLineInterface::ExportOption::ForceHierarchy);
+		if (!errorStr.isEmpty())
+		{
+			return cmd.error(errorStr);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,14 @@
+#ifndef COMMAND_SECTION_EXTRACTION_HEADER
+#define COMMAND_SECTION_EXTRACTION_HEADER
+
+#include "ccCommandLineInterface.h"
+
+//! Extracts (or unfolds) the sections of the loaded clouds along the polylines of a file (see ccSectionExtractor)
+struct CommandSectionExtraction : public ccCommandLineInterface::Command
+{
+	CommandSectionExtraction();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+#endif // COMMAND_SECTION_EXTRACTION_HEADER
@@ -24,7 +24,6 @@
 // CCCoreLib
 #include <DgmOctree.h>
 #include <DistanceComputationTools.h>
-#include <MeshSamplingTools.h>
 #include <ScalarField.h>
 #include <ScalarFieldTools.h>
 
@@ -32,6 +31,7 @@
 #include <ccGBLSensor.h>
 #include <ccGenericMesh.h>
 #include <ccHObject.h>
+#include <ccHObjectCaster.h>
 #include <ccLog.h>
 #include <ccOctree.h>
 #include <ccPointCloud.h>
@@ -42,6 +42,7 @@
 
 // Local
 #include "ccCommon.h"
+#include "ccDistanceEngine.h"
 #include "ccHistogramWindow.h"
 #include "mainwindow.h"
 
@@ -56,6 +57,88 @@ const unsigned char DEFAULT_OCTREE_LEVEL = 7;
 
 static int s_maxThreadCount = ccQtHelpers::GetMaxThreadCount();
 
+//! Adds the split distances (and optionally the 2D 'XY' distances) to a cloud
+static bool AddSplitDistances(ccPointCloud* cloud, CCCoreLib::ScalarField* const splitDistances[3], const QString& sfName, bool mergeXY)
+{
+	// we add the corresponding scalar fields (one for each dimension)
+	for (unsigned j = 0; j < 3; ++j)
+	{
+		CCCoreLib::ScalarField* sf = splitDistances[j];
+		if (sf)
+		{
+			static const QChar CharDim[3]{'X', 'Y', 'Z'};
+			QString            dimSFName = sfName + QString(" (%1)").arg(CharDim[j]);
+			sf->setName(dimSFName.toStdString());
+			sf->computeMinAndMax();
+			// check that SF doesn't already exist
+			int sfExit = cloud->getScalarFieldIndexByName(sf->getName());
+			if (sfExit >= 0)
+				cloud->deleteScalarField(sfExit);
+			int sfEnter = cloud->addScalarField(static_cast<ccScalarField*>(sf));
+			assert(sfEnter >= 0);
+		}
+	}
+
+	if (mergeXY && splitDistances[0] && splitDistances[1])
+	{
+		QString sfNameXY = sfName + " (XY)";
+		int     sf2D     = cloud->getScalarFieldIndexByName(sfNameXY.toStdString());
+		if (sf2D < 0)
+		{
+			sf2D = cloud->addScalarField(sfNameXY.toStdString());
+		}
+		if (sf2D < 0)
+		{
+			ccLog::Error("[ComputeDistances] impossible to add XY scalar field");
+			return false;
+		}
+		CCCoreLib::ScalarField* sf = cloud->getScalarField(sf2D);
+		for (unsigned idx = 0; idx < cloud->size(); idx++)
+		{
+			float d2D = pow(pow(splitDistances[0]->getValue(idx), 2) + pow(splitDistances[1]->getValue(idx), 2), 0.5);
+			sf->setValue(idx, d2D);
+		}
+		sf->computeMinAndMax();
+	}
+
+	return true;
+}
+
+//! Releases the split distances scalar fields
+static void ReleaseSplitDistances(CCCoreLib::ScalarField* splitDistances[3])
+{
+	for (unsigned j = 0; j < 3; ++j)
+	{
+		if (splitDistances[j])
+		{
+			splitDistances[j]->release();
+			splitDistances[j] = nullptr;
+		}
+	}
+}
+
+//! Allocates the split distances scalar fields
+static bool CreateSplitDistances(unsigned count, CCCoreLib::ScalarField* splitDistances[3])
+{
+	for (unsigned j = 0; j < 3; ++j)
+	{
+		ccScalarField* sfDim = new ccScalarField();
+		if (sfDim->resizeSafe(count))
+		{
+			sfDim->link();
+			splitDistances[j] = sfDim;
+		}
+		else
+		{
+			sfDim->release();
+			ReleaseSplitDistances(splitDistances);
+			return false;
+		}
+	}
+
+	return true;
+}
+
 ccComparisonDlg::ccComparisonDlg(ccHObject*         compEntity,
                                  ccHObject*         refEntity,
                                  CC_COMPARISON_TYPE cpType,
@@ -71,12 +154,11 @@ ccComparisonDlg::ccComparisonDlg(ccHObject*         compEntity,
     , m_refEnt(refEntity)
     , m_refCloud(nullptr)
     , m_refMesh(nullptr)
-    , m_refOctree(nullptr)
-    , m_refOctreeIsPartial(false)
     , m_refVisibility(false)
     , m_compType(cpType)
     , m_noDisplay(noDisplay)
-    , m_bestOctreeLevel(0)
+    , m_batchSplit3D(false)
+    , m_batchMergeXY(false)
 {
 	setupUi(this);
 
@@ -123,6 +205,7 @@ ccComparisonDlg::ccComparisonDlg(ccHObject*         compEntity,
 		localModelingTab->setEnabled(false);
 		signedDistCheckBox->setEnabled(true);
 		signedDistCheckBox->setChecked(true);
+		split3DCheckBox->setEnabled(true);
 		filterVisibilityCheckBox->setEnabled(false);
 		filterVisibilityCheckBox->setVisible(false);
 	}
@@ -138,9 +221,7 @@ ccComparisonDlg::ccComparisonDlg(ccHObject*         compEntity,
 	connect(okButton, &QPushButton::clicked, this, &ccComparisonDlg::applyAndExit);
 	connect(computeButton, &QPushButton::clicked, this, &ccComparisonDlg::computeDistances);
 	connect(histoButton, &QPushButton::clicked, this, &ccComparisonDlg::showHisto);
-	connect(maxDistCheckBox, &QCheckBox::toggled, this, &ccComparisonDlg::maxDistUpdated);
 	connect(localModelComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &ccComparisonDlg::locaModelChanged);
-	connect(maxSearchDistSpinBox, qOverload<double>(&QDoubleSpinBox::valueChanged), this, &ccComparisonDlg::maxDistUpdated);
 	connect(split3DCheckBox, &QCheckBox::toggled, this, &ccComparisonDlg::enableCompute2D);
 }
 
@@ -175,11 +256,15 @@ bool ccComparisonDlg::prepareEntitiesForComparison()
 		m_compCloud = static_cast<ccPointCloud*>(m_compEnt);
 	}
 
-	// whatever the case, we always need the compared cloud's octree
-	m_compOctree = m_compCloud->getOctree();
-	if (!m_compOctree)
+	// the compared cloud's octree is only needed for cloud/mesh distances
+	//(cloud/cloud distances rely on the reference cloud nearest neighbour index)
+	if (m_compType == CLOUDMESH_DIST)
 	{
-		m_compOctree = ccOctree::Shared(new ccOctree(m_compCloud));
+		m_compOctree = m_compCloud->getOctree();
+		if (!m_compOctree)
+		{
+			m_compOctree = ccOctree::Shared(new ccOctree(m_compCloud));
+		}
 	}
 	m_compOctreeIsPartial = false;
 
@@ -202,54 +287,20 @@ bool ccComparisonDlg::prepareEntitiesForComparison()
 	{
 		m_refMesh  = ccHObjectCaster::ToGenericMesh(m_refEnt);
 		m_refCloud = m_refMesh->getAssociatedCloud();
-		m_refOctree.clear();
 	}
 	else /*if (m_compType == CLOUDCLOUD_DIST)*/
 	{
 		m_refCloud = ccHObjectCaster::ToGenericPointCloud(m_refEnt);
-
-		// for computing cloud/cloud distances we need also the reference cloud's octree
-		m_refOctree = m_refCloud->getOctree();
-		if (!m_refOctree)
-		{
-			m_refOctree = ccOctree::Shared(new ccOctree(m_refCloud));
-		}
 	}
-	m_refOctreeIsPartial = false;
 
 	return true;
 }
 
-void ccComparisonDlg::maxDistUpdated()
-{
-	// the current 'best octree level' is depreacted
-	m_bestOctreeLevel = 0;
-}
-
 void ccComparisonDlg::enableCompute2D(bool state)
 {
 	compute2DCheckBox->setEnabled(state);
 }
 
-int ccComparisonDlg::getBestOctreeLevel()
-{
-	if (m_bestOctreeLevel == 0)
-	{
-		double maxDistance = (maxDistCheckBox->isChecked() ? maxSearchDistSpinBox->value() : 0);
-
-		int bestOctreeLevel = determineBestOctreeLevel(maxDistance);
-		if (bestOctreeLevel <= 0)
-		{
-			ccLog::Error("Can't evaluate best octree level! Try to set it manually ...");
-			return -1;
-		}
-
-		m_bestOctreeLevel = bestOctreeLevel;
-	}
-
-	return m_bestOctreeLevel;
-}
-
 void ccComparisonDlg::locaModelChanged(int index)
 {
 	localModelParamsFrame->setEnabled(index != 0);
@@ -268,12 +319,6 @@ void ccComparisonDlg::releaseOctrees()
 		m_compOctree.clear();
 		m_compOctreeIsPartial = false;
 	}
-
-	if (m_refOctree && m_refCloud)
-	{
-		m_refOctree.clear();
-		m_refOctreeIsPartial = false;
-	}
 }
 
 void ccComparisonDlg::updateDisplay(bool showSF, bool showRef)
@@ -302,9 +347,8 @@ void ccComparisonDlg::updateDisplay(bool showSF, bool showRef)
 bool ccComparisonDlg::isValid()
 {
 	if (!m_compCloud
-	    || !m_compOctree
-	    || (!m_refMesh && !m_refCloud)
-	    || (!m_refMesh && !m_refOctree))
+	    || (m_refMesh && !m_compOctree)
+	    || (!m_refMesh && !m_refCloud))
 	{
 		ccLog::Error("Dialog initialization error! (void entity)");
 		return false;
@@ -337,7 +381,6 @@ bool ccComparisonDlg::computeApproxDistances()
 	CCCoreLib::ScalarField* sf = m_compCloud->getCurrentInScalarField();
 	assert(sf);
 
-	// prepare the octree structures
 	QScopedPointer<ccProgressDialog> progressDlg;
 	if (parentWidget())
 	{
@@ -352,13 +395,18 @@ bool ccComparisonDlg::computeApproxDistances()
 	{
 	case CLOUDCLOUD_DIST: // cloud-cloud
 	{
-		approxResult = CCCoreLib::DistanceComputationTools::computeApproxCloud2CloudDistance(m_compCloud,
-		                                                                                     m_refCloud,
-		                                                                                     DEFAULT_OCTREE_LEVEL,
-		                                                                                     0,
-		                                                                                     progressDlg.data(),
-		                                                                                     m_compOctree.data(),
-		                                                                                     m_refOctree.data());
+		// the reference cloud index is built once and reused by the precise computation
+		//(the 'approximate' distances are therefore the exact nearest neighbour distances)
+		ccDistanceEngine::Cloud2CloudParams c2cParams;
+		{
+			c2cParams.maxSearchDist  = 0;
+			c2cParams.multiThread    = multiThreadedCheckBox->isChecked();
+			c2cParams.maxThreadCount = maxThreadCountSpinBox->value();
+		}
+		approxResult = ccDistanceEngine::ComputeCloud2CloudDistances(m_compCloud,
+		                                                             m_refCloud,
+		                                                             c2cParams,
+		                                                             progressDlg.data());
 	}
 	break;
 
@@ -432,8 +480,7 @@ bool ccComparisonDlg::computeApproxDistances()
 		approxStats->setItem(curRow++, 1, new QTableWidgetItem(QString("%1").arg(variance >= 0.0 ? sqrt(variance) : variance)));
 
 		// Max relative error
-		PointCoordinateType cs = m_compOctree->getCellSize(DEFAULT_OCTREE_LEVEL);
-		double              e  = cs / 2.0;
+		double e = (m_compOctree ? m_compOctree->getCellSize(DEFAULT_OCTREE_LEVEL) / 2.0 : 0.0);
 		approxStats->setItem(curRow, 0, new QTableWidgetItem("Max error"));
 		approxStats->setItem(curRow++, 1, new QTableWidgetItem(QString("%1").arg(e)));
 
@@ -466,217 +513,6 @@ bool ccComparisonDlg::computeApproxDistances()
 	return true;
 }
 
-int ccComparisonDlg::determineBestOctreeLevel(double maxSearchDist)
-{
-	if (!isValid())
-	{
-		return -1;
-	}
-
-	// make sure a the temporary dist. SF is activated
-	int sfIdx = m_compCloud->getScalarFieldIndexByName(CC_TEMP_APPROX_DISTANCES_DEFAULT_SF_NAME);
-	if (sfIdx < 0)
-	{
-		// we must compute approx. results again
-		if (!computeApproxDistances())
-		{
-			// failed to compute approx distances?!
-			return -1;
-		}
-		sfIdx = m_compCloud->getScalarFieldIndexByName(CC_TEMP_APPROX_DISTANCES_DEFAULT_SF_NAME);
-	}
-
-	const CCCoreLib::ScalarField* approxDistances = m_compCloud->getScalarField(sfIdx);
-	if (!approxDistances)
-	{
-		assert(sfIdx >= 0);
-		return -1;
-	}
-
-	// evalutate the theoretical time for each octree level
-	const int           MAX_OCTREE_LEVEL = m_refMesh ? 9 : CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL; // DGM: can't go higher than level 9 with a mesh as the grid is 'plain' and would take too much memory!
-	std::vector<double> timings;
-	try
-	{
-		timings.resize(MAX_OCTREE_LEVEL, 0);
-	}
-	catch (const std::bad_alloc&)
-	{
-		ccLog::Warning("Can't determine best octree level: not enough memory!");
-		return -1;
-	}
-
-	// if the reference is a mesh
-	double                         meanTriangleSurface = 1.0;
-	CCCoreLib::GenericIndexedMesh* mesh                = nullptr;
-	if (!m_refOctree)
-	{
-		if (!m_refMesh)
-		{
-			ccLog::Error("Internal error: reference entity should be a mesh!");
-			return -1;
-		}
-		mesh = static_cast<CCCoreLib::GenericIndexedMesh*>(m_refMesh);
-		if (!mesh || mesh->size() == 0)
-		{
-			ccLog::Warning("Can't determine best octree level: mesh is empty!");
-			return -1;
-		}
-		// total mesh surface
-		double meshSurface = CCCoreLib::MeshSamplingTools::computeMeshArea(mesh);
-		// average triangle surface
-		if (meshSurface > 0)
-		{
-			meanTriangleSurface = meshSurface / mesh->size();
-		}
-	}
-
-	// we skip the lowest subdivision levels (useless + incompatible with below formulas ;)
-	static const int s_minOctreeLevel   = 6;
-	int              theBestOctreeLevel = s_minOctreeLevel;
-
-	// we don't test the very first and very last level
-	QScopedPointer<ccProgressDialog> progressDlg;
-	if (parentWidget())
-	{
-		progressDlg.reset(new ccProgressDialog(false, this));
-		progressDlg->setMethodTitle(tr("Determining optimal octree level"));
-		progressDlg->setInfo(tr("Testing %1 levels...").arg(MAX_OCTREE_LEVEL)); // we lie here ;)
-		progressDlg->start();
-	}
-	CCCoreLib::NormalizedProgress nProgress(progressDlg.data(), MAX_OCTREE_LEVEL - 2);
-	QApplication::processEvents();
-
-	bool                maxDistanceDefined = maxDistCheckBox->isChecked();
-	PointCoordinateType maxDistance        = static_cast<PointCoordinateType>(maxDistanceDefined ? maxSearchDistSpinBox->value() : 0);
-
-	uint64_t maxNeighbourhoodVolume = static_cast<uint64_t>(1) << (3 * MAX_OCTREE_LEVEL);
-
-	// for each level
-	for (int level = s_minOctreeLevel; level < MAX_OCTREE_LEVEL; ++level)
-	{
-		const unsigned char bitDec               = CCCoreLib::DgmOctree::GET_BIT_SHIFT(level);
-		unsigned            numberOfPointsInCell = 0;
-		unsigned            index                = 0;
-		double              cellDist             = -1;
-		// unsigned skippedCells = 0;
-
-		// we compute a 'correction factor' that converts an approximate distance into an
-		// approximate size of the neighborhood (in terms of cells)
-		PointCoordinateType cellSize = m_compOctree->getCellSize(static_cast<unsigned char>(level));
-
-		// we also use the reference cloud density (points/cell) if we have the info
-		double refListDensity = 1.0;
-		if (m_refOctree)
-		{
-			refListDensity = m_refOctree->computeMeanOctreeDensity(static_cast<unsigned char>(level));
-		}
-
-		CCCoreLib::DgmOctree::CellCode tempCode = 0xFFFFFFFF;
-
-		// scan the octree structure
-		const CCCoreLib::DgmOctree::cellsContainer& compCodes = m_compOctree->pointsAndTheirCellCodes();
-		for (CCCoreLib::DgmOctree::cellsContainer::const_iterator c = compCodes.begin(); c != compCodes.end(); ++c)
-		{
-			CCCoreLib::DgmOctree::CellCode truncatedCode = (c->theCode >> bitDec);
-
-			// new cell?
-			if (truncatedCode != tempCode)
-			{
-				// if it's a real cell
-				if (numberOfPointsInCell != 0)
-				{
-					// if 'maxSearchDist' has been defined by the user, we must take it into account!
-					//(in this case we skip the cell if its approx. distance is superior)
-					if (maxSearchDist <= 0 || cellDist <= maxSearchDist)
-					{
-						// approx. neighborhood radius
-						cellDist /= cellSize;
-
-						// approx. neighborhood width (in terms of cells)
-						double neighbourSize = 2.0 * cellDist + 1.0;
-
-						// if the reference is a mesh
-						if (mesh)
-						{
-							//(integer) approximation of the neighborhood size (in terms of cells)
-							int nCell = static_cast<int>(ceil(cellDist));
-
-							// Probable mesh surface in this neighborhood
-							double crossingMeshSurface = (2.0 * nCell + 1.0) * cellSize;
-							// squared surface!
-							crossingMeshSurface *= crossingMeshSurface;
-
-							// neighborhood "volume" (in terms of cells)
-							double neighbourSize3 = (neighbourSize * neighbourSize * neighbourSize) / maxNeighbourhoodVolume;
-
-							// TIME = NEIGHBORS SEARCH + proportional factor * POINTS/TRIANGLES COMPARISONS
-							timings[level] += neighbourSize3 + ((0.5 * numberOfPointsInCell) / maxNeighbourhoodVolume) * (crossingMeshSurface / meanTriangleSurface);
-						}
-						else
-						{
-							// we ignore the "central" cell
-							neighbourSize -= 1.0;
-							// neighborhood "volume" (in terms of cells)
-							double neighbourSize3 = (neighbourSize * neighbourSize * neighbourSize) / maxNeighbourhoodVolume;
-							// volume of the last "slice" (in terms of cells)
-							//=V(n)-V(n-1) = (2*n+1)^3 - (2*n-1)^3 = 24 * n^2 + 2 (if n > 0)
-							double lastSliceCellCount = (cellDist > 0 ? cellDist * cellDist * 24.0 + 2.0 : 1.0);
-							// TIME = NEIGHBORS SEARCH + proportional factor * POINTS/TRIANGLES COMPARISONS
-							//(we admit that the filled cells roughly correspond to the sqrt of the total number of cells)
-							timings[level] += neighbourSize3 + 0.1 * ((numberOfPointsInCell * sqrt(lastSliceCellCount) * refListDensity) / maxNeighbourhoodVolume);
-						}
-					}
-					// else
-					//{
-					//	++skippedCells;
-					// }
-				}
-
-				numberOfPointsInCell = 0;
-				cellDist             = 0;
-				tempCode             = truncatedCode;
-			}
-
-			ScalarType pointDist = approxDistances->getValue(index);
-			if (maxDistanceDefined && pointDist > maxDistance)
-			{
-				pointDist = maxDistance;
-			}
-
-			// cellDist += pointDist;
-			cellDist = std::max<double>(cellDist, pointDist);
-			++index;
-			++numberOfPointsInCell;
-		}
-
-		////very high levels are unlikely (levelModifier ~ 0.85 @ level 20)
-		//{
-		//	double levelModifier = level < 12 ? 1.0 : exp(-pow(level-12,2)/(20*20));
-		//	timings[level] /= levelModifier;
-
-		//	ccLog::PrintDebug(QString("[Distances] Level %1 - timing = %2 (modifier = %3)").arg(level).arg(timings[level]).arg(levelModifier));
-		//}
-
-		// ccLog::Print("[Timing] Level %i --> %2.12f", level, timings[level]);
-
-		if (timings[level] * 1.05 < timings[theBestOctreeLevel]) // avoid increasing the octree level for super small differences (which is generally counter productive)
-
-		{
-			theBestOctreeLevel = level;
-		}
-
-		if (!nProgress.oneStep())
-		{
-			break;
-		}
-	}
-
-	ccLog::PrintDebug("[Distances] Best level: %i (maxSearchDist = %f)", theBestOctreeLevel, maxSearchDist);
-
-	return theBestOctreeLevel;
-}
-
 bool ccComparisonDlg::computeDistances()
 {
 	if (!isValid())
@@ -685,17 +521,8 @@ bool ccComparisonDlg::computeDistances()
 	int octreeLevel = octreeLevelComboBox->currentIndex();
 	assert(octreeLevel <= CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL);
 
-	if (octreeLevel == 0)
-	{
-		// we'll try to guess the best octree level
-		octreeLevel = getBestOctreeLevel();
-		if (octreeLevel <= 0)
-		{
-			// best octree level computation failed?!
-			return false;
-		}
-		ccLog::Print(QString("[Distances] Octree level (auto): %1").arg(octreeLevel));
-	}
+	// cloud-to-cloud distances (local models included) are computed with the reference cloud index
+	// and cloud-to-mesh distances with the mesh triangle hierarchy (no octree involved)
 
 	// options
 	bool signedDistances = signedDistCheckBox->isEnabled() && signedDistCheckBox->isChecked();
@@ -738,46 +565,25 @@ bool ccComparisonDlg::computeDistances()
 		progressDlg.reset(new ccProgressDialog(true, this));
 	}
 
+	CCCoreLib::ScalarField* splitDistances[3]{nullptr, nullptr, nullptr};
+	if (split3D)
+	{
+		// we create 3 new scalar fields, one for each dimension
+		if (!CreateSplitDistances(m_compCloud->size(), splitDistances))
+		{
+			ccLog::Error("[ComputeDistances] Not enough memory to generate 3D split fields!");
+		}
+	}
+
 	QElapsedTimer eTimer;
 	eTimer.start();
 	switch (m_compType)
 	{
 	case CLOUDCLOUD_DIST: // cloud-cloud
 
-		if (split3D)
+		for (unsigned j = 0; j < 3; ++j)
 		{
-			// we create 3 new scalar fields, one for each dimension
-			unsigned count = m_compCloud->size();
-
-			bool success = true;
-			for (unsigned j = 0; j < 3; ++j)
-			{
-				ccScalarField* sfDim = new ccScalarField();
-				if (sfDim->resizeSafe(count))
-				{
-					sfDim->link();
-					c2cParams.splitDistances[j] = sfDim;
-				}
-				else
-				{
-					success = false;
-					break;
-				}
-			}
-
-			if (!success)
-			{
-				ccLog::Error("[ComputeDistances] Not enough memory to generate 3D split fields!");
-
-				for (unsigned j = 0; j < 3; ++j)
-				{
-					if (c2cParams.splitDistances[j])
-					{
-						c2cParams.splitDistances[j]->release();
-						c2cParams.splitDistances[j] = nullptr;
-					}
-				}
-			}
+			c2cParams.splitDistances[j] = splitDistances[j];
 		}
 
 		if (m_refCloud->isA(CC_TYPES::POINT_CLOUD))
@@ -852,12 +658,20 @@ bool ccComparisonDlg::computeDistances()
 			c2cParams.CPSet         = nullptr;
 		}
 
-		result = CCCoreLib::DistanceComputationTools::computeCloud2CloudDistances(m_compCloud,
-		                                                                          m_refCloud,
-		                                                                          c2cParams,
-		                                                                          progressDlg.data(),
-		                                                                          m_compOctree.data(),
-		                                                                          m_refOctree.data());
+		assert(ccDistanceEngine::CanComputeCloud2CloudDistances(c2cParams));
+		result = ccDistanceEngine::ComputeCloud2CloudDistances(m_compCloud,
+		                                                       m_refCloud,
+		                                                       c2cParams,
+		                                                       progressDlg.data());
+
+		// backup the parameters for the batch entities (if any)
+		m_batchParams = c2cParams;
+		for (unsigned j = 0; j < 3; ++j)
+		{
+			m_batchParams.splitDistances[j] = nullptr;
+		}
+		m_batchSplit3D = (splitDistances[0] != nullptr);
+		m_batchMergeXY = mergeXY;
 		break;
 
 	case CLOUDMESH_DIST: // cloud-mesh
@@ -873,11 +687,22 @@ bool ccComparisonDlg::computeDistances()
 			c2mParams.robust          = robust;
 		}
 
-		result = CCCoreLib::DistanceComputationTools::computeCloud2MeshDistances(m_compCloud,
-		                                                                         m_refMesh,
-		                                                                         c2mParams,
-		                                                                         progressDlg.data(),
-		                                                                         m_compOctree.data());
+		if (ccDistanceEngine::CanComputeCloud2MeshDistances(c2mParams))
+		{
+			result = ccDistanceEngine::ComputeCloud2MeshDistances(m_compCloud,
+			                                                      m_refMesh,
+			                                                      c2mParams,
+			                                                      splitDistances,
+			                                                      progressDlg.data());
+		}
+		else
+		{
+			result = CCCoreLib::DistanceComputationTools::computeCloud2MeshDistances(m_compCloud,
+			                                                                         m_refMesh,
+			                                                                         c2mParams,
+			                                                                         progressDlg.data(),
+			                                                                         m_compOctree.data());
+		}
 		break;
 	}
 	qint64 elapsedTime_ms = eTimer.elapsed();
@@ -936,48 +761,17 @@ bool ccComparisonDlg::computeDistances()
 			m_sfName += QString("[<%1]").arg(maxSearchDist);
 		}
 
-		if (split3D)
+		if (split3D && splitDistances[0])
 		{
-			// we add the corresponding scalar fields (one for each dimension)
-			for (unsigned j = 0; j < 3; ++j)
-			{
-				CCCoreLib::ScalarField* sf = c2cParams.splitDistances[j];
-				if (sf)
-				{
-					static const QChar CharDim[3]{'X', 'Y', 'Z'};
-					QString            dimSFName = m_sfName + QString(" (%1)").arg(CharDim[j]);
-					sf->setName(dimSFName.toStdString());
-					sf->computeMinAndMax();
-					// check that SF doesn't already exist
-					int sfExit = m_compCloud->getScalarFieldIndexByName(sf->getName());
-					if (sfExit >= 0)
-						m_compCloud->deleteScalarField(sfExit);
-					int sfEnter = m_compCloud->addScalarField(static_cast<ccScalarField*>(sf));
-					assert(sfEnter >= 0);
-				}
-			}
 			ccLog::Warning("[ComputeDistances] Result has been split along each dimension (check the 3 other scalar fields with '_X', '_Y' and '_Z' suffix!)");
 			if (mergeXY)
 			{
 				ccLog::Warning("[ComputeDistances] compute 2D distances (xy plane)");
-				QString sfNameXY = m_sfName + " (XY)";
-				int     sf2D     = m_compCloud->getScalarFieldIndexByName(sfNameXY.toStdString());
-				if (sf2D < 0)
-				{
-					sf2D = m_compCloud->addScalarField(sfNameXY.toStdString());
-				}
-				if (sf2D < 0)
-				{
-					ccLog::Error("[ComputeDistances] impossible to add XY scalar field");
-					return 0;
-				}
-				CCCoreLib::ScalarField* sf = m_compCloud->getScalarField(sf2D);
-				for (unsigned idx = 0; idx < m_compCloud->size(); idx++)
-				{
-					float d2D = pow(pow(c2cParams.splitDistances[0]->getValue(idx), 2) + pow(c2cParams.splitDistances[1]->getValue(idx), 2), 0.5);
-					sf->setValue(idx, d2D);
-				}
-				sf->computeMinAndMax();
+			}
+			if (!AddSplitDistances(m_compCloud, splitDistances, m_sfName, mergeXY))
+			{
+				ReleaseSplitDistances(splitDistances);
+				return 0;
 			}
 		}
 	}
@@ -990,19 +784,130 @@ bool ccComparisonDlg::computeDistances()
 		sfIdx = -1;
 	}
 
-	for (unsigned j = 0; j < 3; ++j)
+	ReleaseSplitDistances(splitDistances);
+
+	updateDisplay(sfIdx >= 0, false);
+
+	return result >= 0;
+}
+
+bool ccComparisonDlg::computeBatchDistances()
+{
+	if (m_compType != CLOUDCLOUD_DIST || !m_refCloud)
 	{
-		CCCoreLib::ScalarField*& sf = c2cParams.splitDistances[j];
-		if (sf)
+		ccLog::Warning("[ComputeDistances] Batch mode is only available for cloud-to-cloud distances");
+		return false;
+	}
+
+	// prepare the compared clouds
+	std::vector<ccPointCloud*>            clouds;
+	std::vector<ccDistanceEngine::C2CJob> jobs;
+	try
+	{
+		clouds.reserve(m_batchEntities.size());
+		jobs.reserve(m_batchEntities.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("Not enough memory");
+		return false;
+	}
+
+	bool success = true;
+	for (ccHObject* entity : m_batchEntities)
+	{
+		ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(entity);
+		if (!cloud || cloud == m_compCloud || cloud == m_refCloud)
+		{
+			ccLog::Warning(QString("[ComputeDistances] Entity '%1' skipped (batch mode)").arg(entity ? entity->getName() : QString()));
+			continue;
+		}
+
+		// we delete any existing scalar field with the exact same name
+		int sfIdx = cloud->getScalarFieldIndexByName(m_sfName.toStdString());
+		if (sfIdx >= 0)
+		{
+			cloud->deleteScalarField(sfIdx);
+		}
+		sfIdx = cloud->addScalarField(m_sfName.toStdString());
+		if (sfIdx < 0)
 		{
-			sf->release();
-			sf = nullptr;
+			ccLog::Error("Couldn't allocate a new scalar field for computing distances! Try to free some memory ...");
+			success = false;
+			break;
 		}
+		cloud->setCurrentScalarField(sfIdx);
+		clouds.push_back(cloud);
+
+		ccDistanceEngine::C2CJob job;
+		job.comparedCloud = cloud;
+		if (m_batchSplit3D && !CreateSplitDistances(cloud->size(), job.splitDistances))
+		{
+			ccLog::Error("[ComputeDistances] Not enough memory to generate 3D split fields!");
+			success = false;
+			break;
+		}
+		jobs.push_back(job);
 	}
 
-	updateDisplay(sfIdx >= 0, false);
+	if (success && !jobs.empty())
+	{
+		QScopedPointer<ccProgressDialog> progressDlg;
+		if (parentWidget())
+		{
+			progressDlg.reset(new ccProgressDialog(true, this));
+		}
 
-	return result >= 0;
+		QElapsedTimer eTimer;
+		eTimer.start();
+		// all the clouds are processed at once (the reference index is built only once)
+		assert(ccDistanceEngine::CanComputeCloud2CloudDistances(m_batchParams));
+		int result = ccDistanceEngine::ComputeCloud2CloudDistances(jobs, m_refCloud, m_batchParams, progressDlg.data());
+
+		if (result >= 0)
+		{
+			ccLog::Print(QString("[ComputeDistances] Batch mode: %1 cloud(s) processed in %2 s.").arg(jobs.size()).arg(eTimer.elapsed() / 1.0e3, 0, 'f', 2));
+
+			for (size_t i = 0; i < clouds.size(); ++i)
+			{
+				ccPointCloud* cloud = clouds[i];
+				int           sfIdx = cloud->getScalarFieldIndexByName(m_sfName.toStdString());
+				cloud->getScalarField(sfIdx)->computeMinAndMax();
+				if (m_batchSplit3D)
+				{
+					AddSplitDistances(cloud, jobs[i].splitDistances, m_sfName, m_batchMergeXY);
+				}
+				cloud->setCurrentDisplayedScalarField(sfIdx);
+				cloud->showSF(true);
+				cloud->prepareDisplayForRefresh();
+			}
+		}
+		else
+		{
+			ccLog::Error("[ComputeDistances] Batch mode: error (%i)", result);
+			success = false;
+		}
+	}
+
+	if (!success)
+	{
+		// remove the (incomplete) scalar fields
+		for (ccPointCloud* cloud : clouds)
+		{
+			int sfIdx = cloud->getScalarFieldIndexByName(m_sfName.toStdString());
+			if (sfIdx >= 0)
+			{
+				cloud->deleteScalarField(sfIdx);
+			}
+		}
+	}
+
+	for (ccDistanceEngine::C2CJob& job : jobs)
+	{
+		ReleaseSplitDistances(job.splitDistances);
+	}
+
+	return success;
 }
 
 void ccComparisonDlg::showHisto()
@@ -1074,6 +979,11 @@ void ccComparisonDlg::applyAndExit()
 		// m_compCloud->showSF(false);
 	}
 
+	if (!m_batchEntities.empty() && !m_sfName.isEmpty())
+	{
+		computeBatchDistances();
+	}
+
 	updateDisplay(true, m_refVisibility);
 
 	releaseOctrees();
@@ -18,6 +18,9 @@
 #ifndef CC_COMPARISON_DIALOG_HEADER
 #define CC_COMPARISON_DIALOG_HEADER
 
+// CCCoreLib
+#include <DistanceComputationTools.h>
+
 // qCC_db
 #include <ccOctree.h>
 
@@ -72,6 +75,20 @@ class ccComparisonDlg : public QDialog
 		return m_refEnt;
 	}
 
+	//! Sets additional compared entities (cloud-to-cloud 'batch' mode)
+	/** When the user validates the result (see applyAndExit), the distances are
+	    also computed for these entities, with the same reference and parameters.
+	**/
+	void setBatchEntities(const std::vector<ccHObject*>& entities)
+	{
+		m_batchEntities = entities;
+	}
+	//! Returns the additional compared entities (batch mode)
+	const std::vector<ccHObject*>& getBatchEntities() const
+	{
+		return m_batchEntities;
+	}
+
   public:
 	bool computeDistances();
 	void applyAndExit();
@@ -80,17 +97,15 @@ class ccComparisonDlg : public QDialog
   protected:
 	void showHisto();
 	void locaModelChanged(int);
-	void maxDistUpdated();
 	void enableCompute2D(bool);
 
   protected:
 	bool isValid();
 	bool prepareEntitiesForComparison();
 	bool computeApproxDistances();
-	int  getBestOctreeLevel();
-	int  determineBestOctreeLevel(double);
 	void updateDisplay(bool showSF, bool hideRef);
 	void releaseOctrees();
+	bool computeBatchDistances();
 
 	//! Compared entity
 	ccHObject* m_compEnt;
@@ -109,10 +124,6 @@ class ccComparisonDlg : public QDialog
 	ccGenericPointCloud* m_refCloud;
 	//! Reference entity equivalent mesh (if any)
 	ccGenericMesh* m_refMesh;
-	//! Reference entity's octree
-	ccOctree::Shared m_refOctree;
-	//! Whether the reference entity octree is partial or not
-	bool m_refOctreeIsPartial;
 	//! Initial reference entity visibility
 	bool m_refVisibility;
 
@@ -128,8 +139,14 @@ class ccComparisonDlg : public QDialog
 	//! Whether a display is active (and should be refreshed) or not
 	bool m_noDisplay;
 
-	//! Best octree level (or 0 if none has been guessed already)
-	int m_bestOctreeLevel;
+	//! Additional compared entities (batch mode)
+	std::vector<ccHObject*> m_batchEntities;
+	//! Last cloud-to-cloud parameters (applied to the batch entities)
+	CCCoreLib::DistanceComputationTools::Cloud2CloudDistancesComputationParams m_batchParams;
+	//! Whether the last cloud-to-cloud distances were split along each dimension
+	bool m_batchSplit3D;
+	//! Whether the last cloud-to-cloud distances were also computed in the XY plane
+	bool m_batchMergeXY;
 };
 
 #endif
@@ -24,8 +24,23 @@
 #include <ccRasterGrid.h>
 #include <ccScalarField.h>
 
+// Qt
+#include <QCoreApplication>
+#include <QScopedPointer>
+
 // System
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+//! Size of the (square) tiles processed by each parallel task (in cells)
+static const unsigned s_contourTileSize = 256;
 
 static QString GetPolylineName(double value, unsigned mainIndex, unsigned partNumber)
 {
@@ -42,167 +57,396 @@ static QString GetPolylineName(double value, unsigned mainIndex, unsigned partNu
 	return contourLineName;
 }
 
-#ifndef CC_GDAL_SUPPORT
+namespace
+{
+	//! Contour line piece (in grid coordinates)
+	/** The pieces are chained by the grid edges they start and end on.
+	**/
+	struct ContourPiece
+	{
+		unsigned               level     = 0;
+		uint64_t               firstEdge = 0;
+		uint64_t               lastEdge  = 0;
+		bool                   closed    = false;
+		std::vector<CCVector2d> points;
+	};
+
+	//! Oriented contour segment (from one grid edge to another - the higher values are on its left)
+	struct ContourSegment
+	{
+		unsigned level;
+		uint64_t from;
+		uint64_t to;
 
-#include "ccIsolines.h" //old alternative code to generate contour lines (doesn't work very well :( )
+		inline bool operator<(const ContourSegment& other) const
+		{
+			return level < other.level || (level == other.level && from < other.from);
+		}
+	};
+
+	//! Marching squares on a grid of samples
+	/** The grid edges are identified by a global index (so that the contour pieces
+	    extracted from the different tiles can be stitched together):
+	    - edge between samples (i, j) and (i + 1, j): 2 * (j * width + i)
+	    - edge between samples (i, j) and (i, j + 1): 2 * (j * width + i) + 1
+	**/
+	class MarchingSquares
+	{
+	  public:
+		MarchingSquares(const std::vector<double>& values, unsigned width, const std::vector<double>& levels)
+		    : m_values(values)
+		    , m_width(width)
+		    , m_levels(levels)
+		{
+		}
 
-// Qt
-#include <QCoreApplication>
+		//! Returns the crossing point of a level on a grid edge
+		inline CCVector2d crossingPoint(uint64_t edge, unsigned level) const
+		{
+			const uint64_t sampleIndex = edge >> 1;
+			const unsigned i           = static_cast<unsigned>(sampleIndex % m_width);
+			const unsigned j           = static_cast<unsigned>(sampleIndex / m_width);
+			const bool     vertical    = (edge & 1) != 0;
 
-#else
+			double vA = m_values[sampleIndex];
+			double vB = m_values[vertical ? sampleIndex + m_width : sampleIndex + 1];
+			double t  = (m_levels[level] - vA) / (vB - vA);
 
-// GDAL
-#include <cpl_string.h>
-#include <gdal.h>
-#include <gdal_alg.h>
+			return vertical ? CCVector2d(i, j + t) : CCVector2d(i + t, j);
+		}
 
-struct ContourGenerationParameters
-{
-	QMultiMap<double, ccPolyline*> contourLines;
-	QMap<double, unsigned>         contourLinesMainCount;
-	const ccRasterGrid*            grid                      = nullptr;
-	bool                           projectContourOnAltitudes = false;
-};
-
-static CPLErr ContourWriter(double  dfLevel,
-                            int     nPoints,
-                            double* padfX,
-                            double* padfY,
-                            void*   userData)
-{
-	if (nPoints < 2)
+		//! Extracts the contour segments of a tile (all levels at once)
+		void extractSegments(unsigned x0, unsigned y0, unsigned x1, unsigned y1, std::vector<ContourSegment>& segments) const
+		{
+			for (unsigned j = y0; j < y1; ++j)
+			{
+				for (unsigned i = x0; i < x1; ++i)
+				{
+					// corners (in CCW order)
+					const size_t index = static_cast<size_t>(j) * m_width + i;
+					const double v[4]{m_values[index], m_values[index + 1], m_values[index + 1 + m_width], m_values[index + m_width]};
+					if (!std::isfinite(v[0]) || !std::isfinite(v[1]) || !std::isfinite(v[2]) || !std::isfinite(v[3]))
+					{
+						// no data
+						continue;
+					}
+
+					// levels crossing the cell (i.e. such that minValue < level <= maxValue)
+					const double minValue = std::min(std::min(v[0], v[1]), std::min(v[2], v[3]));
+					const double maxValue = std::max(std::max(v[0], v[1]), std::max(v[2], v[3]));
+					const size_t firstLevel = std::upper_bound(m_levels.begin(), m_levels.end(), minValue) - m_levels.begin();
+					const size_t lastLevel  = std::upper_bound(m_levels.begin(), m_levels.end(), maxValue) - m_levels.begin();
+					if (firstLevel >= lastLevel)
+					{
+						continue;
+					}
+
+					// cell edges (in CCW order: edge k goes from corner k to corner k+1)
+					const uint64_t edges[4]{2 * static_cast<uint64_t>(index),
+					                        2 * static_cast<uint64_t>(index + 1) + 1,
+					                        2 * static_cast<uint64_t>(index + m_width),
+					                        2 * static_cast<uint64_t>(index) + 1};
+
+					for (size_t l = firstLevel; l < lastLevel; ++l)
+					{
+						const double level = m_levels[l];
+						bool         high[4];
+						for (unsigned k = 0; k < 4; ++k)
+						{
+							high[k] = (v[k] >= level);
+						}
+
+						// crossed edges
+						unsigned crossed[4];
+						unsigned crossedCount = 0;
+						for (unsigned k = 0; k < 4; ++k)
+						{
+							if (high[k] != high[(k + 1) & 3])
+							{
+								crossed[crossedCount++] = k;
+							}
+						}
+						assert(crossedCount == 2 || crossedCount == 4);
+
+						// each segment goes from a 'high to low' edge to the next crossed edge (if the
+						// cell center is high) or to the previous one (otherwise - saddle points only)
+						bool centerIsHigh = (crossedCount == 2 || (v[0] + v[1] + v[2] + v[3]) / 4 >= level);
+						for (unsigned c = 0; c < crossedCount; ++c)
+						{
+							unsigned k = crossed[c];
+							if (high[k]) // 'high to low' edge
+							{
+								unsigned next = crossed[centerIsHigh ? (c + 1) % crossedCount : (c + crossedCount - 1) % crossedCount];
+								segments.push_back({static_cast<unsigned>(l), edges[k], edges[next]});
+							}
+						}
+					}
+				}
+			}
+		}
+
+	  protected:
+		const std::vector<double>& m_values;
+		unsigned                   m_width;
+		const std::vector<double>& m_levels;
+	};
+
+	//! Douglas-Peucker simplification (the first and last points are kept)
+	void Simplify(const std::vector<CCVector2d>& points, size_t first, size_t last, double squareTolerance, std::vector<bool>& keep)
 	{
-		// nothing to do
-		assert(false);
-		return CE_None;
+		if (last <= first + 1)
+		{
+			return;
+		}
+
+		const CCVector2d& A         = points[first];
+		CCVector2d        AB        = points[last] - A;
+		double            squareLAB = AB.norm2();
+
+		size_t farthest      = first;
+		double maxSquareDist = -1.0;
+		for (size_t i = first + 1; i < last; ++i)
+		{
+			CCVector2d AP         = points[i] - A;
+			double     squareDist = 0;
+			if (squareLAB > 0)
+			{
+				double cross = AB.x * AP.y - AB.y * AP.x;
+				squareDist   = (cross * cross) / squareLAB;
+			}
+			else
+			{
+				squareDist = AP.norm2();
+			}
+			if (squareDist > maxSquareDist)
+			{
+				maxSquareDist = squareDist;
+				farthest      = i;
+			}
+		}
+
+		if (maxSquareDist > squareTolerance)
+		{
+			keep[farthest] = true;
+			Simplify(points, first, farthest, squareTolerance, keep);
+			Simplify(points, farthest, last, squareTolerance, keep);
+		}
 	}
 
-	ContourGenerationParameters* params = reinterpret_cast<ContourGenerationParameters*>(userData);
-	if (!params || !params->grid)
+	//! Simplifies a contour line piece
+	void SimplifyPiece(ContourPiece& piece, double tolerance)
 	{
-		assert(false);
-		return CE_Failure;
-	}
+		if (tolerance <= 0 || piece.points.size() < 4)
+		{
+			return;
+		}
 
-	ccPointCloud*            vertices = nullptr;
-	ccPolyline*              poly     = nullptr;
-	std::vector<ccPolyline*> previousPolylines;
+		std::vector<bool> keep(piece.points.size(), false);
+		keep.front() = true;
+		keep.back()  = true;
+		if (piece.closed)
+		{
+			// we split the loop at the farthest point from the first one
+			size_t farthest      = 1;
+			double maxSquareDist = -1.0;
+			for (size_t i = 1; i < piece.points.size(); ++i)
+			{
+				double squareDist = (piece.points[i] - piece.points.front()).norm2();
+				if (squareDist > maxSquareDist)
+				{
+					maxSquareDist = squareDist;
+					farthest      = i;
+				}
+			}
+			keep[farthest] = true;
+			Simplify(piece.points, 0, farthest, tolerance * tolerance, keep);
+			Simplify(piece.points, farthest, piece.points.size() - 1, tolerance * tolerance, keep);
+		}
+		else
+		{
+			Simplify(piece.points, 0, piece.points.size() - 1, tolerance * tolerance, keep);
+		}
 
-	unsigned contourIndex = 1;
-	if (params->contourLinesMainCount.contains(dfLevel))
-	{
-		contourIndex = params->contourLinesMainCount[dfLevel] + 1;
+		size_t count = 0;
+		for (size_t i = 0; i < piece.points.size(); ++i)
+		{
+			if (keep[i])
+			{
+				piece.points[count++] = piece.points[i];
+			}
+		}
+		piece.points.resize(count);
 	}
-	params->contourLinesMainCount[dfLevel] = contourIndex;
 
-	unsigned partCount = 0;
+	//! Appends the crossing point of a segment to a piece (duplicate points are skipped)
+	inline void AddPoint(std::vector<CCVector2d>& points, const CCVector2d& P)
+	{
+		if (points.empty() || points.back().x != P.x || points.back().y != P.y)
+		{
+			points.push_back(P);
+		}
+	}
 
-	for (int i = 0; i < nPoints; ++i)
+	//! Chains the segments of a tile into pieces (the segments must be sorted by level and starting edge)
+	void ChainSegments(const MarchingSquares& ms, const std::vector<ContourSegment>& segments, double tolerance, std::vector<ContourPiece>& pieces)
 	{
-		CCVector3 P(padfX[i], padfY[i], dfLevel);
+		std::vector<bool>     visited(segments.size(), false);
+		std::vector<uint64_t> ends;
 
-		// detect potential loops
-		if (i + 1 == nPoints && poly)
+		for (size_t levelStart = 0; levelStart < segments.size();)
 		{
-			const CCVector3* firstPoint = poly->getPoint(0);
-			if (firstPoint->x == P.x && firstPoint->y == P.y)
+			const unsigned level    = segments[levelStart].level;
+			size_t         levelEnd = levelStart + 1;
+			while (levelEnd < segments.size() && segments[levelEnd].level == level)
 			{
-				poly->setClosed(true);
-				break;
+				++levelEnd;
 			}
-		}
 
-		if (params->projectContourOnAltitudes)
-		{
-			int    xi = std::min(std::max(static_cast<int>(padfX[i]), 0), static_cast<int>(params->grid->width) - 1);
-			int    yi = std::min(std::max(static_cast<int>(padfY[i]), 0), static_cast<int>(params->grid->height) - 1);
-			double h  = params->grid->rows[yi][xi].h;
-			if (std::isfinite(h))
+			auto begin = segments.begin() + levelStart;
+			auto end   = segments.begin() + levelEnd;
+
+			// edges on which a segment ends
+			ends.clear();
+			for (auto it = begin; it != end; ++it)
 			{
-				P.z = static_cast<PointCoordinateType>(h);
+				ends.push_back(it->to);
 			}
-			else
+			std::sort(ends.begin(), ends.end());
+
+			// open chains first (they start on edges where no other segment ends), then loops
+			for (int pass = 0; pass < 2; ++pass)
 			{
-				// we end the current polyline and start a new one
-				if (poly)
+				for (size_t s = levelStart; s < levelEnd; ++s)
 				{
-					if (poly->size() < 2)
+					if (visited[s] || (pass == 0 && std::binary_search(ends.begin(), ends.end(), segments[s].from)))
 					{
-						// we discard isolated points
-						delete poly;
-						poly = nullptr;
+						continue;
 					}
-					else
-					{
-						poly->shrinkToFit();
-						vertices->shrinkToFit();
 
-						++partCount;
-						poly->setName(GetPolylineName(dfLevel, contourIndex, partCount == 1 && i + 2 >= nPoints ? 0 : partCount)); // if not enough points to add another polyline, we don't need to add the sub-part index
+					ContourPiece piece;
+					piece.level     = level;
+					piece.firstEdge = segments[s].from;
+					AddPoint(piece.points, ms.crossingPoint(segments[s].from, level));
 
-						if (params->contourLines.insert(dfLevel, poly) == params->contourLines.end())
+					size_t current = s;
+					while (true)
+					{
+						visited[current] = true;
+						piece.lastEdge   = segments[current].to;
+						if (piece.lastEdge == piece.firstEdge)
 						{
-							// not enough memory?
-							delete poly;
-							return CE_Failure;
+							piece.closed = true;
+							break;
+						}
+						AddPoint(piece.points, ms.crossingPoint(piece.lastEdge, level));
+
+						// look for the next segment
+						ContourSegment key{level, piece.lastEdge, 0};
+						auto           next = std::lower_bound(begin, end, key);
+						if (next == end || next->from != piece.lastEdge || visited[next - segments.begin()])
+						{
+							break;
 						}
+						current = next - segments.begin();
+					}
+
+					if (piece.points.size() > 1)
+					{
+						SimplifyPiece(piece, tolerance);
+						pieces.push_back(std::move(piece));
 					}
-					poly     = nullptr;
-					vertices = nullptr;
 				}
-				continue;
 			}
+
+			levelStart = levelEnd;
 		}
+	}
 
-		if (!poly)
+	//! Contour line (in grid coordinates)
+	struct ContourLine
+	{
+		bool                    closed = false;
+		std::vector<CCVector2d> points;
+	};
+
+	//! Stitches the pieces of a given level (coming from the different tiles)
+	void StitchPieces(std::vector<ContourPiece*>& pieces, std::vector<ContourLine>& lines)
+	{
+		// closed pieces are complete lines already
+		std::vector<ContourPiece*> openPieces;
+		for (ContourPiece* piece : pieces)
 		{
-			if (nPoints < i + 2)
+			if (piece->closed)
 			{
-				// a single point left? Nothing we can do...
-				// ccLog::Warning("An isolated point was discarded");
-				break;
+				lines.emplace_back();
+				lines.back().closed = true;
+				lines.back().points.swap(piece->points);
 			}
-			// we need to instantiate a new polyline
-			vertices = new ccPointCloud("vertices");
-			vertices->setEnabled(false);
-			poly = new ccPolyline(vertices);
-			poly->addChild(vertices);
-			poly->setClosed(false);
-
-			// add the 'const altitude' meta-data as well
-			poly->setMetaData(ccPolyline::MetaKeyConstAltitude(), QVariant(dfLevel));
-
-			if (!vertices->reserve(nPoints - i) || !poly->reserve(nPoints - i))
+			else
 			{
-				// not enough memory
-				delete poly;
-				poly = nullptr;
-				return CE_Failure;
+				openPieces.push_back(piece);
 			}
 		}
 
-		assert(vertices);
-		poly->addPointIndex(vertices->size());
-		vertices->addPoint(P);
-	}
-
-	if (poly)
-	{
-		poly->shrinkToFit();
-		vertices->shrinkToFit();
-		poly->setName(GetPolylineName(dfLevel, contourIndex, partCount == 0 ? 0 : partCount + 1));
-		if (params->contourLines.insert(dfLevel, poly) == params->contourLines.end())
+		std::sort(openPieces.begin(), openPieces.end(), [](const ContourPiece* a, const ContourPiece* b) { return a->firstEdge < b->firstEdge; });
+		std::vector<uint64_t> ends;
+		ends.reserve(openPieces.size());
+		for (const ContourPiece* piece : openPieces)
 		{
-			// not enough memory?
-			delete poly;
-			return CE_Failure;
+			ends.push_back(piece->lastEdge);
 		}
-	}
+		std::sort(ends.begin(), ends.end());
 
-	return CE_None;
-}
+		std::vector<bool> visited(openPieces.size(), false);
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (size_t p = 0; p < openPieces.size(); ++p)
+			{
+				if (visited[p] || (pass == 0 && std::binary_search(ends.begin(), ends.end(), openPieces[p]->firstEdge)))
+				{
+					continue;
+				}
+
+				ContourLine line;
+				size_t      current = p;
+				while (true)
+				{
+					visited[current]    = true;
+					ContourPiece* piece = openPieces[current];
+					// the first point of the piece is the last point of the previous one
+					line.points.insert(line.points.end(), line.points.empty() ? piece->points.begin() : piece->points.begin() + 1, piece->points.end());
+					std::vector<CCVector2d>().swap(piece->points);
+
+					auto next = std::lower_bound(openPieces.begin(),
+					                             openPieces.end(),
+					                             piece->lastEdge,
+					                             [](const ContourPiece* a, uint64_t edge) { return a->firstEdge < edge; });
+					if (next == openPieces.end() || (*next)->firstEdge != piece->lastEdge)
+					{
+						break;
+					}
+					size_t nextIndex = next - openPieces.begin();
+					if (visited[nextIndex])
+					{
+						line.closed = (nextIndex == p);
+						if (line.closed)
+						{
+							// the last point is the same as the first one
+							line.points.pop_back();
+						}
+						break;
+					}
+					current = nextIndex;
+				}
 
-#endif // CC_GDAL_SUPPORT
+				if (line.points.size() > 1)
+				{
+					lines.push_back(std::move(line));
+				}
+			}
+		}
+	}
+} // namespace
 
 bool ccContourLinesGenerator::GenerateContourLines(ccRasterGrid*             rasterGrid,
                                                    const CCVector2d&         gridMinCornerXY,
@@ -248,111 +492,20 @@ bool ccContourLinesGenerator::GenerateContourLines(ccRasterGrid*             ras
 		levelCount += static_cast<unsigned>((params.maxAltitude - params.startAltitude) / params.step); // static_cast is equivalent to floor if value >= 0
 	}
 
+#if defined(_OPENMP)
+	const int threadCount = (params.maxThreadCount > 0 ? params.maxThreadCount : omp_get_max_threads());
+#endif
+
+	size_t firstContourLine = contourLines.size();
+	bool   success          = true;
 	try
 	{
-#ifdef CC_GDAL_SUPPORT // use GDAL (more robust) - otherwise we will use an old code found on the Internet (with a strange behavior)
-
-		// invoke the GDAL 'Contour Generator'
-		ContourGenerationParameters gdalParams;
-		gdalParams.grid                      = rasterGrid;
-		gdalParams.projectContourOnAltitudes = params.projectContourOnAltitudes;
-		GDALContourGeneratorH hCG            = GDAL_CG_Create(rasterGrid->width,
-                                                   rasterGrid->height,
-                                                   std::isnan(params.emptyCellsValue) ? FALSE : TRUE,
-                                                   params.emptyCellsValue,
-                                                   params.step,
-                                                   params.startAltitude,
-                                                   ContourWriter,
-                                                   &gdalParams);
-		if (!hCG)
+		std::vector<double> levels(levelCount);
+		for (unsigned l = 0; l < levelCount; ++l)
 		{
-			ccLog::Error("[GDAL] Failed to create contour generator");
-			return false;
+			levels[l] = params.startAltitude + l * params.step;
 		}
 
-		// feed the scan lines
-		{
-			double* scanline = static_cast<double*>(CPLMalloc(sizeof(double) * rasterGrid->width));
-			if (!scanline)
-			{
-				ccLog::Error("[GDAL] Not enough memory");
-				return false;
-			}
-
-			unsigned layerIndex = 0;
-
-			for (unsigned j = 0; j < rasterGrid->height; ++j)
-			{
-				const ccRasterGrid::Row& cellRow = rasterGrid->rows[j];
-				for (unsigned i = 0; i < rasterGrid->width; ++i)
-				{
-					if (cellRow[i].nbPoints || !sparseLayer)
-					{
-						if (params.altitudes)
-						{
-							ScalarType value = params.altitudes->getValue(layerIndex++);
-							scanline[i]      = ccScalarField::ValidValue(value) ? value : params.emptyCellsValue;
-						}
-						else
-						{
-							scanline[i] = std::isfinite(cellRow[i].h) ? cellRow[i].h : params.emptyCellsValue;
-						}
-					}
-					else
-					{
-						scanline[i] = params.emptyCellsValue;
-					}
-				}
-
-				CPLErr error = GDAL_CG_FeedLine(hCG, scanline);
-				if (error != CE_None)
-				{
-					ccLog::Error("[GDAL] An error occurred during contour lines generation");
-					break;
-				}
-			}
-
-			if (scanline)
-			{
-				CPLFree(scanline);
-			}
-			scanline = nullptr;
-
-			// reproject contour lines from raster C.S. to the cloud C.S.
-			auto levels = gdalParams.contourLines.uniqueKeys();
-			for (double level : levels)
-			{
-				const auto polylinesAtLevel = gdalParams.contourLines.values(level);
-				for (int i = polylinesAtLevel.size() - 1; i >= 0; --i)
-				{
-					ccPolyline* poly = polylinesAtLevel[i];
-					if (static_cast<int>(poly->size()) < params.minVertexCount)
-					{
-						delete poly;
-						poly = nullptr;
-						continue;
-					}
-
-					for (unsigned i = 0; i < poly->size(); ++i)
-					{
-						CCVector3* P2D = const_cast<CCVector3*>(poly->getAssociatedCloud()->getPoint(i));
-
-						CCVector3 P(static_cast<PointCoordinateType>((P2D->x - 0.5) * rasterGrid->gridStep + gridMinCornerXY.x),
-						            static_cast<PointCoordinateType>((P2D->y - 0.5) * rasterGrid->gridStep + gridMinCornerXY.y),
-						            P2D->z);
-						*P2D = P;
-					}
-
-					// add contour
-					contourLines.push_back(poly);
-				}
-			}
-
-			gdalParams.contourLines.clear(); // just in case
-		}
-
-		GDAL_CG_Destroy(hCG);
-#else
 		unsigned xDim = rasterGrid->width;
 		unsigned yDim = rasterGrid->height;
 
@@ -363,9 +516,9 @@ bool ccContourLinesGenerator::GenerateContourLines(ccRasterGrid*             ras
 			xDim += 2;
 			yDim += 2;
 		}
-		std::vector<double> grid(static_cast<size_t>(xDim) * yDim, 0);
 
-		// fill grid
+		// fill grid (the border, if any, is below all the levels so that the contour lines are closed)
+		std::vector<double> grid(static_cast<size_t>(xDim) * yDim, params.startAltitude - 1.0);
 		{
 			unsigned layerIndex = 0;
 			for (unsigned j = 0; j < rasterGrid->height; ++j)
@@ -394,140 +547,239 @@ bool ccContourLinesGenerator::GenerateContourLines(ccRasterGrid*             ras
 			}
 		}
 
-		// generate contour lines
+		if (xDim < 2 || yDim < 2)
+		{
+			ccLog::Warning("[ccContourLinesGenerator] Grid is too small");
+			return true;
+		}
+
+		// tiles (of cells)
+		const unsigned tileCountX = (xDim - 1 + s_contourTileSize - 1) / s_contourTileSize;
+		const unsigned tileCountY = (yDim - 1 + s_contourTileSize - 1) / s_contourTileSize;
+		const int      tileCount  = static_cast<int>(tileCountX * tileCountY);
+
+		QScopedPointer<ccProgressDialog> pDlg;
+		if (params.showProgressDialog)
+		{
+			pDlg.reset(new ccProgressDialog(true, params.parentWidget));
+			pDlg->setMethodTitle(QObject::tr("Contour plot"));
+			pDlg->setInfo(QObject::tr("Levels: %1\nCells: %2 x %3").arg(levelCount).arg(rasterGrid->width).arg(rasterGrid->height));
+			pDlg->start();
+			pDlg->show();
+			QCoreApplication::processEvents();
+		}
+		CCCoreLib::NormalizedProgress nProgress(pDlg.data(), static_cast<unsigned>(tileCount) + levelCount);
+
+		std::atomic<bool> cancelled(false);
+		std::atomic<bool> notEnoughMemory(false);
+
+		// 1) marching squares on each tile (all the levels at once)
+		MarchingSquares                        ms(grid, xDim, levels);
+		std::vector<std::vector<ContourPiece>> tilePieces(tileCount);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int t = 0; t < tileCount; ++t)
 		{
-			Isolines<double> iso(static_cast<int>(xDim), static_cast<int>(yDim));
-			if (!params.ignoreBorders)
+			if (cancelled || notEnoughMemory)
 			{
-				iso.createOnePixelBorder(grid.data(), params.startAltitude - 1.0);
+				continue;
 			}
 
-			ccProgressDialog pDlg(true, params.parentWidget);
-			pDlg.setMethodTitle(QObject::tr("Contour plot"));
-			pDlg.setInfo(QObject::tr("Levels: %1\nCells: %2 x %3").arg(levelCount).arg(rasterGrid->width).arg(rasterGrid->height));
-			pDlg.start();
-			pDlg.show();
-			QCoreApplication::processEvents();
-			CCCoreLib::NormalizedProgress nProgress(&pDlg, levelCount);
+			const unsigned x0 = (t % tileCountX) * s_contourTileSize;
+			const unsigned y0 = (t / tileCountX) * s_contourTileSize;
+			const unsigned x1 = std::min(x0 + s_contourTileSize, xDim - 1);
+			const unsigned y1 = std::min(y0 + s_contourTileSize, yDim - 1);
+			try
+			{
+				std::vector<ContourSegment> segments;
+				ms.extractSegments(x0, y0, x1, y1, segments);
+				std::sort(segments.begin(), segments.end());
+				ChainSegments(ms, segments, params.simplificationTolerance, tilePieces[t]);
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
 
-			for (double v = params.startAltitude; v <= params.maxAltitude; v += params.step)
+			if (!nProgress.oneStep())
 			{
-				// extract contour lines for the current level
-				iso.setThreshold(v);
-				int lineCount = iso.find(grid.data());
+				cancelled = true;
+			}
+		}
 
-				ccLog::PrintDebug(QString("[Rasterize][Isolines] value=%1 : %2 lines").arg(v).arg(lineCount));
+		// 2) stitch the pieces across the tiles borders (each level independently)
+		std::vector<std::vector<ContourPiece*>> levelPieces(levelCount);
+		if (!cancelled && !notEnoughMemory)
+		{
+			for (std::vector<ContourPiece>& pieces : tilePieces)
+			{
+				for (ContourPiece& piece : pieces)
+				{
+					levelPieces[piece.level].push_back(&piece);
+				}
+			}
+		}
 
-				// convert them to poylines
-				for (int i = 0; i < lineCount; ++i)
+		std::vector<std::vector<ccPolyline*>> levelLines(levelCount);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int l = 0; l < static_cast<int>(levelCount); ++l)
+		{
+			if (cancelled || notEnoughMemory)
+			{
+				continue;
+			}
+
+			const double v = levels[l];
+			try
+			{
+				std::vector<ContourLine> lines;
+				StitchPieces(levelPieces[l], lines);
+
+				// convert them to polylines
+				unsigned lineIndex = 0;
+				for (const ContourLine& line : lines)
 				{
-					int      vertCount    = iso.getContourLength(i);
-					unsigned subPartCount = 0;
-					if (vertCount >= params.minVertexCount)
+					if (static_cast<int>(line.points.size()) < params.minVertexCount)
+					{
+						continue;
+					}
+					++lineIndex;
+
+					unsigned partCount = 0;
+					size_t   startVi   = 0; // we may have to split the polyline in multiple chunks
+					while (startVi < line.points.size())
 					{
-						int startVi = 0; // we may have to split the polyline in multiple chunks
-						while (startVi < vertCount)
+						ccPointCloud* vertices = new ccPointCloud("vertices");
+						ccPolyline*   poly     = new ccPolyline(vertices);
+						poly->addChild(vertices);
+						bool isClosed = (startVi == 0 ? line.closed : false);
+						if (!poly->reserve(static_cast<unsigned>(line.points.size() - startVi)) || !vertices->reserve(static_cast<unsigned>(line.points.size() - startVi)))
 						{
-							ccPointCloud* vertices = new ccPointCloud("vertices");
-							ccPolyline*   poly     = new ccPolyline(vertices);
-							poly->addChild(vertices);
-							bool isClosed = (startVi == 0 ? iso.isContourClosed(i) : false);
-							if (poly->reserve(vertCount - startVi) && vertices->reserve(vertCount - startVi))
-							{
-								unsigned localIndex = 0;
-								for (int vi = startVi; vi < vertCount; ++vi)
-								{
-									++startVi;
-
-									double x = iso.getContourX(i, vi) - margin;
-									double y = iso.getContourY(i, vi) - margin;
-
-									CCVector3 P;
-									// DGM: we will only do the dimension mapping at export time
-									//(otherwise the contour lines appear in the wrong orientation compared to the grid/raster which
-									//  is in the XY plane by default!)
-									/*P.u[X] = */ P.x = static_cast<PointCoordinateType>((x + 0.5) * rasterGrid->gridStep + gridMinCornerXY.x);
-									/*P.u[Y] = */ P.y = static_cast<PointCoordinateType>((y + 0.5) * rasterGrid->gridStep + gridMinCornerXY.y);
-									if (params.projectContourOnAltitudes)
-									{
-										int    xi = std::min(std::max(static_cast<int>(x), 0), static_cast<int>(rasterGrid->width) - 1);
-										int    yi = std::min(std::max(static_cast<int>(y), 0), static_cast<int>(rasterGrid->height) - 1);
-										double h  = rasterGrid->rows[yi][xi].h;
-										if (std::isfinite(h))
-										{
-											/*P.u[Z] = */ P.z = static_cast<PointCoordinateType>(h);
-										}
-										else
-										{
-											// DGM: we stop the current polyline
-											isClosed = false;
-											break;
-										}
-									}
-									else
-									{
-										/*P.u[Z] = */ P.z = static_cast<PointCoordinateType>(v);
-									}
-
-									vertices->addPoint(P);
-									assert(localIndex < vertices->size());
-									poly->addPointIndex(localIndex++);
-								}
+							delete poly;
+							throw std::bad_alloc();
+						}
 
-								assert(poly);
-								if (poly->size() > 1)
+						unsigned localIndex = 0;
+						for (size_t vi = startVi; vi < line.points.size(); ++vi)
+						{
+							++startVi;
+
+							double x = line.points[vi].x - margin;
+							double y = line.points[vi].y - margin;
+
+							CCVector3 P;
+							// DGM: we will only do the dimension mapping at export time
+							//(otherwise the contour lines appear in the wrong orientation compared to the grid/raster which
+							//  is in the XY plane by default!)
+							P.x = static_cast<PointCoordinateType>((x + 0.5) * rasterGrid->gridStep + gridMinCornerXY.x);
+							P.y = static_cast<PointCoordinateType>((y + 0.5) * rasterGrid->gridStep + gridMinCornerXY.y);
+							if (params.projectContourOnAltitudes)
+							{
+								int    xi = std::min(std::max(static_cast<int>(x), 0), static_cast<int>(rasterGrid->width) - 1);
+								int    yi = std::min(std::max(static_cast<int>(y), 0), static_cast<int>(rasterGrid->height) - 1);
+								double h  = rasterGrid->rows[yi][xi].h;
+								if (std::isfinite(h))
 								{
-									poly->setClosed(isClosed); // if we have less vertices, it means we have 'chopped' the original contour
-									vertices->setEnabled(false);
-
-									// add the 'const altitude' meta-data as well
-									poly->setMetaData(ccPolyline::MetaKeyConstAltitude(), QVariant(v));
-
-									// add contour
-									++subPartCount;
-									poly->setName(GetPolylineName(v, static_cast<unsigned>(lineCount + 1), isClosed ? 0 : subPartCount));
-									try
-									{
-										contourLines.push_back(poly);
-									}
-									catch (const std::bad_alloc&)
-									{
-										ccLog::Warning("[ccContourLinesGenerator] Not enough memory");
-										return false;
-									}
+									P.z = static_cast<PointCoordinateType>(h);
 								}
 								else
 								{
-									delete poly;
-									poly = nullptr;
+									// DGM: we stop the current polyline
+									isClosed = false;
+									break;
 								}
 							}
 							else
 							{
-								delete poly;
-								poly = nullptr;
-								ccLog::Warning("Not enough memory!");
-								return false;
+								P.z = static_cast<PointCoordinateType>(v);
 							}
+
+							vertices->addPoint(P);
+							poly->addPointIndex(localIndex++);
+						}
+
+						if (poly->size() > 1)
+						{
+							poly->setClosed(isClosed); // if we have less vertices, it means we have 'chopped' the original contour
+							vertices->setEnabled(false);
+
+							// add the 'const altitude' meta-data as well
+							poly->setMetaData(ccPolyline::MetaKeyConstAltitude(), QVariant(v));
+
+							// add contour
+							++partCount;
+							poly->setName(GetPolylineName(v, lineIndex, isClosed ? 0 : partCount));
+							levelLines[l].push_back(poly);
+						}
+						else
+						{
+							delete poly;
+							poly = nullptr;
 						}
 					}
 				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+
+			if (!nProgress.oneStep())
+			{
+				cancelled = true;
+			}
+		}
 
-				if (!nProgress.oneStep())
+		// gather the lines (sorted by level)
+		for (std::vector<ccPolyline*>& lines : levelLines)
+		{
+			if (!notEnoughMemory)
+			{
+				try
 				{
-					// process cancelled by user
-					break;
+					contourLines.insert(contourLines.end(), lines.begin(), lines.end());
+					lines.clear();
 				}
+				catch (const std::bad_alloc&)
+				{
+					notEnoughMemory = true;
+				}
+			}
+			for (ccPolyline* poly : lines)
+			{
+				delete poly;
 			}
 		}
-#endif
+
+		if (notEnoughMemory)
+		{
+			throw std::bad_alloc();
+		}
+		if (cancelled)
+		{
+			// process cancelled by user (we keep the lines generated so far)
+			ccLog::Warning("[ccContourLinesGenerator] Process cancelled by the user");
+		}
 	}
 	catch (const std::bad_alloc&)
 	{
 		ccLog::Warning("[ccContourLinesGenerator] Not enough memory");
+		success = false;
+	}
+
+	if (!success)
+	{
+		for (size_t i = firstContourLine; i < contourLines.size(); ++i)
+		{
+			delete contourLines[i];
+		}
+		contourLines.resize(firstContourLine);
 		return false;
 	}
 
-	ccLog::Print(QString("[ccContourLinesGenerator] %1 iso-lines generated (%2 levels)").arg(contourLines.size()).arg(levelCount));
+	ccLog::Print(QString("[ccContourLinesGenerator] %1 iso-lines generated (%2 levels)").arg(contourLines.size() - firstContourLine).arg(levelCount));
 	return true;
 }
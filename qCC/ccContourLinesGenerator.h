@@ -29,6 +29,10 @@ class QWidget;
 #include <vector>
 
 //! Contour lines generator
+/** The grid is processed by tiles, in parallel: all the levels are extracted in a
+    single marching squares pass over each tile, and the contour line pieces are
+    then stitched across the tiles borders (each level independently).
+**/
 class ccContourLinesGenerator
 {
   public:
@@ -41,11 +45,13 @@ class ccContourLinesGenerator
 		ccScalarField* altitudes                 = nullptr; // optional scalar field that stores the 'altitudes' (may be null, in which case the grid 'h' values are used directly)
 		int            minVertexCount            = 3;       // minimum number of vertices per contour line
 		bool           projectContourOnAltitudes = false;
-		double         emptyCellsValue           = std::numeric_limits<double>::quiet_NaN();
+		double         emptyCellsValue           = std::numeric_limits<double>::quiet_NaN(); // NaN = no data (the contour lines are interrupted)
+		double         simplificationTolerance   = 0.0;     // max. deviation of the simplified contour lines, relative to the grid step (0 = no simplification)
+		int            maxThreadCount            = 0;       // max number of threads (0 = all)
 
-		/* The parameters below are only required if GDAL is not required */
-		QWidget* parentWidget  = nullptr; // for progress dialog
-		bool     ignoreBorders = false;
+		QWidget* parentWidget       = nullptr; // for progress dialog
+		bool     showProgressDialog = true;    // must be false if the lines are generated from a worker thread
+		bool     ignoreBorders      = false;   // if false, the contour lines are closed along the grid borders
 	};
 
 	//! Generates contour lines
@@ -23,6 +23,9 @@
 
 class ccHObject;
 class ccGLMatrix;
+class ccGenericMesh;
+class ccGenericPointCloud;
+class ccMesh;
 
 //! Cropping tool
 /** Handles clouds and meshes for now
@@ -38,6 +41,23 @@ class ccCropTool
 	    \return cropped entity (if any)
 	**/
 	static ccHObject* Crop(ccHObject* entity, const ccBBox& box, bool inside = true, const ccGLMatrix* meshRotation = nullptr);
+
+	//! Crops a mesh
+	/** Same as Crop, except that the transformed vertices can be provided by the caller
+	    (so as to crop the same mesh with several boxes without transforming all its vertices each time).
+	    It doesn't interact with the GUI (it can be called from a worker thread).
+	    \param mesh mesh to be cropped
+	    \param box cropping box
+	    \param inside whether to keep the triangles inside or outside the input box
+	    \param meshRotation optional rotation
+	    \param rotatedVertices optional mesh vertices, already transformed by 'meshRotation' (same order as the mesh associated cloud)
+	    \return cropped mesh (if any)
+	**/
+	static ccMesh* CropMesh(ccGenericMesh*       mesh,
+	                        const ccBBox&        box,
+	                        bool                 inside          = true,
+	                        const ccGLMatrix*    meshRotation    = nullptr,
+	                        ccGenericPointCloud* rotatedVertices = nullptr);
 };
 
 #endif // CC_CROP_TOOL_HEADER
@@ -0,0 +1,429 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccDistanceEngine.h"
+
+// CCCoreLib
+#include <GenericIndexedCloudPersist.h>
+#include <GenericIndexedMesh.h>
+#include <GenericProgressCallback.h>
+#include <LocalModel.h>
+#include <Neighbourhood.h>
+#include <ReferenceCloud.h>
+#include <ScalarField.h>
+
+// qCC_db
+#include <ccGenericPointCloud.h>
+#include <ccLog.h>
+#include <ccTriangleBVH.h>
+
+// Qt
+#include <QString>
+
+// System
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+//! Number of compared points processed by each parallel task (cloud-to-cloud)
+static const unsigned s_c2cChunkSize = 4096;
+//! Number of compared points processed by each parallel task (cloud-to-mesh)
+static const unsigned s_c2mChunkSize = 1024;
+
+bool ccDistanceEngine::CanComputeCloud2CloudDistances(const Cloud2CloudParams& params)
+{
+	return params.CPSet == nullptr;
+}
+
+//! Builds the local model of the reference cloud around one of its points (see Cloud2CloudParams::localModel)
+/** \return the model or a null pointer if the neighbourhood is too small
+**/
+static CCCoreLib::LocalModel* ComputeLocalModel(const ccNearestNeighbourIndex&             index,
+                                                const ccDistanceEngine::Cloud2CloudParams& params,
+                                                const CCVector3&                           center,
+                                                ccNearestNeighbourIndex::KNNBuffer&        buffer,
+                                                CCCoreLib::ReferenceCloud&                 neighbours)
+{
+	unsigned            count        = 0;
+	PointCoordinateType squareRadius = 0;
+	if (params.useSphericalSearchForLocalModel)
+	{
+		count        = index.findNeighboursInSphere(center, static_cast<PointCoordinateType>(params.radiusForLocalModel), buffer);
+		squareRadius = static_cast<PointCoordinateType>(params.radiusForLocalModel) * params.radiusForLocalModel;
+	}
+	else
+	{
+		// the neighbours are sorted by increasing distance
+		count        = index.findKNearestNeighbours(center, params.kNNForLocalModel, buffer);
+		squareRadius = (count != 0 ? buffer.neighbours[count - 1].first : 0);
+	}
+
+	if (count < CCCoreLib::CC_LOCAL_MODEL_MIN_SIZE[params.localModel])
+	{
+		return nullptr;
+	}
+
+	neighbours.clear(false);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		if (!neighbours.addPointIndex(buffer.neighbours[i].second))
+		{
+			// not enough memory
+			return nullptr;
+		}
+	}
+
+	CCCoreLib::Neighbourhood Z(&neighbours);
+	return CCCoreLib::LocalModel::New(params.localModel, Z, center, squareRadius);
+}
+
+int ccDistanceEngine::ComputeCloud2CloudDistances(CCCoreLib::GenericIndexedCloudPersist* comparedCloud,
+                                                  ccGenericPointCloud*                   referenceCloud,
+                                                  const Cloud2CloudParams&               params,
+                                                  CCCoreLib::GenericProgressCallback*    progressCb /*=nullptr*/)
+{
+	C2CJob job;
+	job.comparedCloud = comparedCloud;
+	for (unsigned d = 0; d < 3; ++d)
+	{
+		job.splitDistances[d] = params.splitDistances[d];
+	}
+
+	return ComputeCloud2CloudDistances(std::vector<C2CJob>{job}, referenceCloud, params, progressCb);
+}
+
+int ccDistanceEngine::ComputeCloud2CloudDistances(const std::vector<C2CJob>&          jobs,
+                                                  ccGenericPointCloud*                referenceCloud,
+                                                  const Cloud2CloudParams&            params,
+                                                  CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	if (!referenceCloud || referenceCloud->size() == 0 || jobs.empty())
+	{
+		return -1;
+	}
+
+	// the reference index is built only once (and kept for later calls)
+	ccNearestNeighbourIndex::Shared index = referenceCloud->getNearestNeighbourIndex(true, progressCb);
+	if (!index)
+	{
+		if (progressCb && progressCb->isCancelRequested())
+		{
+			return -3;
+		}
+		ccLog::Warning("[ccDistanceEngine] Failed to build the reference cloud index (not enough memory?)");
+		return -2;
+	}
+
+	// prepare the compared clouds (and split the work in chunks)
+	struct Chunk
+	{
+		size_t   jobIndex;
+		unsigned begin;
+		unsigned end;
+	};
+	std::vector<Chunk> chunks;
+	for (size_t j = 0; j < jobs.size(); ++j)
+	{
+		const C2CJob& job = jobs[j];
+		if (!job.comparedCloud)
+		{
+			return -1;
+		}
+		if (!job.comparedCloud->enableScalarField())
+		{
+			return -2;
+		}
+
+		unsigned pointCount = job.comparedCloud->size();
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			if (job.splitDistances[d] && job.splitDistances[d]->currentSize() < pointCount)
+			{
+				return -1;
+			}
+		}
+
+		try
+		{
+			for (unsigned begin = 0; begin < pointCount; begin += s_c2cChunkSize)
+			{
+				chunks.push_back({j, begin, std::min(begin + s_c2cChunkSize, pointCount)});
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			return -2;
+		}
+	}
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Cloud-cloud distance");
+			progressCb->setInfo(qPrintable(QString("Compared clouds: %1\nReference: %2 points").arg(jobs.size()).arg(referenceCloud->size())));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(chunks.size()));
+
+	const PointCoordinateType maxSquareDist = (params.maxSearchDist > 0 ? static_cast<PointCoordinateType>(params.maxSearchDist) * params.maxSearchDist : -1);
+	const bool                localModel    = (params.localModel != CCCoreLib::NO_MODEL);
+	std::atomic<bool>         cancelled(false);
+
+#if defined(_OPENMP)
+	const int threadCount = (params.multiThread ? (params.maxThreadCount > 0 ? params.maxThreadCount : omp_get_max_threads()) : 1);
+#endif
+
+	const int chunkCount = static_cast<int>(chunks.size());
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+	for (int c = 0; c < chunkCount; ++c)
+	{
+		if (cancelled)
+		{
+			continue;
+		}
+
+		const Chunk&                           chunk         = chunks[c];
+		const C2CJob&                          job           = jobs[chunk.jobIndex];
+		CCCoreLib::GenericIndexedCloudPersist* comparedCloud = job.comparedCloud;
+		const bool                             split         = (job.splitDistances[0] || job.splitDistances[1] || job.splitDistances[2]);
+
+		// local model neighbourhood (searched in the same index)
+		ccNearestNeighbourIndex::KNNBuffer     modelBuffer;
+		CCCoreLib::ReferenceCloud              modelNeighbours(referenceCloud);
+		std::unique_ptr<CCCoreLib::LocalModel> model;
+
+		for (unsigned i = chunk.begin; i < chunk.end; ++i)
+		{
+			const CCVector3* P = comparedCloud->getPoint(i);
+
+			ScalarType dist       = CCCoreLib::NAN_VALUE;
+			CCVector3  splitDists(CCCoreLib::NAN_VALUE, CCCoreLib::NAN_VALUE, CCCoreLib::NAN_VALUE);
+			if (referenceCloud->testVisibility(*P) == CCCoreLib::POINT_VISIBLE)
+			{
+				PointCoordinateType squareDist   = 0;
+				int                 nearestIndex = index->findNearestNeighbour(*P, maxSquareDist, squareDist);
+				if (nearestIndex >= 0)
+				{
+					const CCVector3* nearestPoint = referenceCloud->getPoint(static_cast<unsigned>(nearestIndex));
+
+					dist = static_cast<ScalarType>(std::sqrt(squareDist));
+					if (split)
+					{
+						splitDists = *P - *nearestPoint;
+					}
+
+					if (localModel)
+					{
+						// the last model is reused if the nearest point lies inside its neighbourhood
+						if (!params.reuseExistingLocalModels || !model || (*nearestPoint - model->getCenter()).norm2() > model->getSquareSize())
+						{
+							model.reset(ComputeLocalModel(*index, params, *nearestPoint, modelBuffer, modelNeighbours));
+						}
+
+						if (model)
+						{
+							CCVector3  modelPoint;
+							ScalarType modelDist = model->computeDistanceFromModelToPoint(P, split ? &modelPoint : nullptr);
+							if (modelDist < dist)
+							{
+								dist = modelDist;
+								if (split)
+								{
+									splitDists = *P - modelPoint;
+								}
+							}
+						}
+					}
+				}
+				else
+				{
+					// no neighbour closer than the max search distance
+					dist = params.maxSearchDist;
+				}
+			}
+
+			comparedCloud->setPointScalarValue(i, dist);
+			for (unsigned d = 0; d < 3; ++d)
+			{
+				if (job.splitDistances[d])
+				{
+					job.splitDistances[d]->setValue(i, static_cast<ScalarType>(splitDists.u[d]));
+				}
+			}
+		}
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	return cancelled ? -3 : 0;
+}
+
+bool ccDistanceEngine::CanComputeCloud2MeshDistances(const Cloud2MeshParams& params)
+{
+	return !params.useDistanceMap
+	       && params.CPSet == nullptr;
+}
+
+int ccDistanceEngine::ComputeCloud2MeshDistances(CCCoreLib::GenericIndexedCloudPersist* comparedCloud,
+                                                 CCCoreLib::GenericIndexedMesh*         mesh,
+                                                 const Cloud2MeshParams&                params,
+                                                 CCCoreLib::ScalarField*                splitDistances[3] /*=nullptr*/,
+                                                 CCCoreLib::GenericProgressCallback*    progressCb /*=nullptr*/)
+{
+	if (!comparedCloud || !mesh || mesh->size() == 0)
+	{
+		return -1;
+	}
+
+	const unsigned pointCount = comparedCloud->size();
+	bool           split      = false;
+	if (splitDistances)
+	{
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			if (splitDistances[d])
+			{
+				if (splitDistances[d]->currentSize() < pointCount)
+				{
+					return -1;
+				}
+				split = true;
+			}
+		}
+	}
+
+	if (!comparedCloud->enableScalarField())
+	{
+		return -2;
+	}
+
+	// the triangle hierarchy is built only once for all the points
+	const int             maxThreadCount = (params.multiThread ? params.maxThreadCount : 1);
+	ccTriangleBVH::Shared bvh            = ccTriangleBVH::Build(mesh, maxThreadCount, progressCb);
+	if (!bvh)
+	{
+		if (progressCb && progressCb->isCancelRequested())
+		{
+			return -3;
+		}
+		ccLog::Warning("[ccDistanceEngine] Failed to build the mesh triangle hierarchy (not enough memory?)");
+		return -2;
+	}
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Cloud-mesh distance");
+			progressCb->setInfo(qPrintable(QString("Points: %1\nTriangles: %2").arg(pointCount).arg(mesh->size())));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	const int                     chunkCount = static_cast<int>((pointCount + s_c2mChunkSize - 1) / s_c2mChunkSize);
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(chunkCount));
+
+	const PointCoordinateType maxSquareDist = (params.maxSearchDist > 0 ? static_cast<PointCoordinateType>(params.maxSearchDist) * params.maxSearchDist : -1);
+	const bool                robust        = (params.signedDistances && params.robust);
+	std::atomic<bool>         cancelled(false);
+
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+	for (int c = 0; c < chunkCount; ++c)
+	{
+		if (cancelled)
+		{
+			continue;
+		}
+
+		const unsigned begin = static_cast<unsigned>(c) * s_c2mChunkSize;
+		const unsigned end   = std::min(begin + s_c2mChunkSize, pointCount);
+		for (unsigned i = begin; i < end; ++i)
+		{
+			const CCVector3* P = comparedCloud->getPoint(i);
+
+			ScalarType dist       = params.maxSearchDist;
+			CCVector3  splitDists(CCCoreLib::NAN_VALUE, CCCoreLib::NAN_VALUE, CCCoreLib::NAN_VALUE);
+
+			ccTriangleBVH::ClosestTriangle closest;
+			if (bvh->findClosestTriangle(*P, maxSquareDist, robust, closest))
+			{
+				dist = static_cast<ScalarType>(std::sqrt(closest.squareDist));
+				if (params.signedDistances && (closest.planeDist < 0) != params.flipNormals)
+				{
+					dist = -dist;
+				}
+
+				if (split)
+				{
+					CCVector3 A;
+					CCVector3 B;
+					CCVector3 C;
+					mesh->getTriangleVertices(static_cast<unsigned>(closest.triangleIndex), A, B, C);
+					splitDists = *P - ccTriangleBVH::ClosestPointOnTriangle(*P, A, B, C);
+				}
+			}
+			// else: no triangle closer than the max search distance
+
+			comparedCloud->setPointScalarValue(i, dist);
+			if (split)
+			{
+				for (unsigned d = 0; d < 3; ++d)
+				{
+					if (splitDistances[d])
+					{
+						splitDistances[d]->setValue(i, static_cast<ScalarType>(splitDists.u[d]));
+					}
+				}
+			}
+		}
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	return cancelled ? -3 : 0;
+}
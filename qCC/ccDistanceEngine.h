@@ -0,0 +1,128 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#ifndef CC_DISTANCE_ENGINE_HEADER
+#define CC_DISTANCE_ENGINE_HEADER
+
+// CCCoreLib
+#include <DistanceComputationTools.h>
+
+// System
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericIndexedCloudPersist;
+	class GenericIndexedMesh;
+	class GenericProgressCallback;
+	class ScalarField;
+} // namespace CCCoreLib
+
+class ccGenericPointCloud;
+
+//! Index-based distances computation
+/** Cloud-to-cloud distances rely on the persistent kd-tree of the reference
+    cloud (see ccGenericPointCloud::getNearestNeighbourIndex) instead of a pair
+    of octrees. The index is only built once, so that repeated or batch
+    comparisons against the same reference are much faster. The neighbourhoods
+    of the local models are searched in the same index.
+    Cloud-to-mesh distances rely on a bounding volume hierarchy of the mesh
+    triangles (see ccTriangleBVH), built once per call.
+**/
+class ccDistanceEngine
+{
+  public:
+	//! Cloud-to-cloud distances parameters
+	using Cloud2CloudParams = CCCoreLib::DistanceComputationTools::Cloud2CloudDistancesComputationParams;
+
+	//! Cloud-to-mesh distances parameters
+	using Cloud2MeshParams = CCCoreLib::DistanceComputationTools::Cloud2MeshDistancesComputationParams;
+
+	//! Cloud-to-cloud distances job (one per compared cloud)
+	struct C2CJob
+	{
+		//! Compared cloud (the distances are stored with setPointScalarValue)
+		CCCoreLib::GenericIndexedCloudPersist* comparedCloud = nullptr;
+		//! Optional split distances (one scalar field per dimension, same size as the compared cloud)
+		CCCoreLib::ScalarField* splitDistances[3]{nullptr, nullptr, nullptr};
+	};
+
+	//! Returns whether the engine can handle the given cloud-to-cloud parameters
+	/** The 'Closest Point Set' output is not supported
+	    (CCCoreLib::DistanceComputationTools::computeCloud2CloudDistances should be used instead).
+	**/
+	static bool CanComputeCloud2CloudDistances(const Cloud2CloudParams& params);
+
+	//! Computes the nearest neighbour distances between one or several clouds and a reference cloud
+	/** Same conventions as CCCoreLib: if a max search distance is defined, points
+	    without any neighbour closer than this distance get the max search distance
+	    as distance (and NaN as split distances). Points that are not visible from
+	    the reference cloud sensor(s) (see ccPointCloud::enableVisibilityCheck) get NaN.
+	    If a local model is defined, it is built around the nearest reference point
+	    and the distance to the model is used if it is smaller (the last model is
+	    reused if params.reuseExistingLocalModels is set and if the nearest point
+	    lies inside its neighbourhood).
+	    Only params.maxSearchDist, the local model parameters, params.multiThread
+	    and params.maxThreadCount are used.
+	    \param jobs compared clouds
+	    \param referenceCloud reference cloud
+	    \param params parameters
+	    \param progressCb the caller can get some notification of the process progress through this callback mechanism (see CCCoreLib documentation)
+	    \return 0 on success, a negative value otherwise (-1: invalid input, -2: not enough memory, -3: process cancelled)
+	**/
+	static int ComputeCloud2CloudDistances(const std::vector<C2CJob>&          jobs,
+	                                       ccGenericPointCloud*                referenceCloud,
+	                                       const Cloud2CloudParams&            params,
+	                                       CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Computes the nearest neighbour distances between a cloud and a reference cloud
+	/** Same as the batch version (the split distances are taken from params.splitDistances).
+	 **/
+	static int ComputeCloud2CloudDistances(CCCoreLib::GenericIndexedCloudPersist* comparedCloud,
+	                                       ccGenericPointCloud*                   referenceCloud,
+	                                       const Cloud2CloudParams&               params,
+	                                       CCCoreLib::GenericProgressCallback*    progressCb = nullptr);
+
+	//! Returns whether the engine can handle the given cloud-to-mesh parameters
+	/** The distance map approximation and the 'Closest Point Set' output are not supported
+	    (CCCoreLib::DistanceComputationTools::computeCloud2MeshDistances should be used instead).
+	**/
+	static bool CanComputeCloud2MeshDistances(const Cloud2MeshParams& params);
+
+	//! Computes the distances between a cloud and a mesh
+	/** Same conventions as CCCoreLib: if a max search distance is defined, points
+	    without any triangle closer than this distance get the max search distance
+	    as distance (and NaN as split distances). If signed distances are requested,
+	    the sign is given by the normal of the closest triangle (see params.flipNormals
+	    and params.robust).
+	    Only params.maxSearchDist, params.signedDistances, params.flipNormals, params.robust,
+	    params.multiThread and params.maxThreadCount are used.
+	    \param comparedCloud compared cloud (the distances are stored with setPointScalarValue)
+	    \param mesh reference mesh
+	    \param params parameters
+	    \param splitDistances optional split distances (one scalar field per dimension, same size as the compared cloud)
+	    \param progressCb the caller can get some notification of the process progress through this callback mechanism (see CCCoreLib documentation)
+	    \return 0 on success, a negative value otherwise (-1: invalid input, -2: not enough memory, -3: process cancelled)
+	**/
+	static int ComputeCloud2MeshDistances(CCCoreLib::GenericIndexedCloudPersist* comparedCloud,
+	                                      CCCoreLib::GenericIndexedMesh*         mesh,
+	                                      const Cloud2MeshParams&                params,
+	                                      CCCoreLib::ScalarField*                splitDistances[3] = nullptr,
+	                                      CCCoreLib::GenericProgressCallback*    progressCb        = nullptr);
+};
+
+#endif // CC_DISTANCE_ENGINE_HEADER
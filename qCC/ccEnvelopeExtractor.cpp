@@ -27,6 +27,7 @@
 
 // CCCoreLib
 #include <DistanceComputationTools.h>
+#include <GenericProgressCallback.h>
 #include <Neighbourhood.h>
 #include <PointProjectionTools.h>
 
@@ -42,9 +43,19 @@
 #endif // Q_MOC_RUN
 #endif
 
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
 // System
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <queue>
 #include <set>
 
 // list of already used point to avoid hull's inner loops
@@ -220,13 +231,616 @@ static PointCoordinateType FindNearestCandidate(unsigned&
 	return (minDist2 < 0 ? minDist2 : minDist2 / squareLengthAB);
 }
 
+namespace
+{
+	//! Uniform 2D grid (fast mode)
+	class Grid2D
+	{
+	  public:
+		//! Initializes the grid so that it contains all the input points (~4 points per cell on average)
+		/** \return false if all the points are at the same location
+		**/
+		bool init(const std::vector<Vertex2D>& points)
+		{
+			if (points.empty())
+			{
+				return false;
+			}
+
+			double minX = points.front().x;
+			double minY = points.front().y;
+			double maxX = minX;
+			double maxY = minY;
+			for (const Vertex2D& P : points)
+			{
+				minX = std::min(minX, static_cast<double>(P.x));
+				minY = std::min(minY, static_cast<double>(P.y));
+				maxX = std::max(maxX, static_cast<double>(P.x));
+				maxY = std::max(maxY, static_cast<double>(P.y));
+			}
+
+			const double dx              = maxX - minX;
+			const double dy              = maxY - minY;
+			const double targetCellCount = std::max(1.0, points.size() / 4.0);
+			const double maxDimCellCount = 4096.0;
+			double       cellSize        = (dx > 0 && dy > 0 ? std::sqrt(dx * dy / targetCellCount) : std::max(dx, dy) / targetCellCount);
+			cellSize                     = std::max(cellSize, std::max(dx, dy) / maxDimCellCount);
+			if (!(cellSize > 0))
+			{
+				return false;
+			}
+
+			m_minX     = minX;
+			m_minY     = minY;
+			m_cellSize = cellSize;
+			m_diagonal = std::sqrt(dx * dx + dy * dy);
+			m_dimX     = static_cast<int>(dx / cellSize) + 1;
+			m_dimY     = static_cast<int>(dy / cellSize) + 1;
+
+			return true;
+		}
+
+		//! Returns the number of cells
+		inline size_t cellCount() const { return static_cast<size_t>(m_dimX) * m_dimY; }
+		//! Returns the cell size
+		inline double cellSize() const { return m_cellSize; }
+		//! Returns the length of the diagonal of the points bounding rectangle
+		inline double diagonal() const { return m_diagonal; }
+
+		//! Returns the index of the cell containing a point
+		inline unsigned cellIndex(const Vertex2D& P) const
+		{
+			const int i = std::min(std::max(static_cast<int>(std::floor((P.x - m_minX) / m_cellSize)), 0), m_dimX - 1);
+			const int j = std::min(std::max(static_cast<int>(std::floor((P.y - m_minY) / m_cellSize)), 0), m_dimY - 1);
+			return static_cast<unsigned>(j * m_dimX + i);
+		}
+
+		//! Calls 'visitor' for each cell intersecting a convex quadrilateral
+		template <typename Visitor>
+		void visitCells(const CCVector2d corners[4], Visitor&& visitor) const
+		{
+			double minY = corners[0].y;
+			double maxY = minY;
+			for (unsigned k = 1; k < 4; ++k)
+			{
+				minY = std::min(minY, corners[k].y);
+				maxY = std::max(maxY, corners[k].y);
+			}
+
+			const int j0 = std::max(static_cast<int>(std::floor((minY - m_minY) / m_cellSize)), 0);
+			const int j1 = std::min(static_cast<int>(std::floor((maxY - m_minY) / m_cellSize)), m_dimY - 1);
+			for (int j = j0; j <= j1; ++j)
+			{
+				// horizontal extent of the quadrilateral inside the row
+				const double y0   = m_minY + j * m_cellSize;
+				const double y1   = y0 + m_cellSize;
+				double       xMin = std::numeric_limits<double>::max();
+				double       xMax = -xMin;
+				for (unsigned k = 0; k < 4; ++k)
+				{
+					const CCVector2d& P = corners[k];
+					const CCVector2d& Q = corners[(k + 1) & 3];
+					if (P.y >= y0 && P.y <= y1)
+					{
+						xMin = std::min(xMin, P.x);
+						xMax = std::max(xMax, P.x);
+					}
+					for (double y : {y0, y1})
+					{
+						if ((P.y < y) != (Q.y < y))
+						{
+							const double x = P.x + (y - P.y) * (Q.x - P.x) / (Q.y - P.y);
+							xMin           = std::min(xMin, x);
+							xMax           = std::max(xMax, x);
+						}
+					}
+				}
+				if (xMin > xMax)
+				{
+					continue;
+				}
+
+				const int i0 = std::max(static_cast<int>(std::floor((xMin - m_minX) / m_cellSize)), 0);
+				const int i1 = std::min(static_cast<int>(std::floor((xMax - m_minX) / m_cellSize)), m_dimX - 1);
+				for (int i = i0; i <= i1; ++i)
+				{
+					visitor(static_cast<unsigned>(j * m_dimX + i));
+				}
+			}
+		}
+
+		//! Calls 'visitor' for each cell intersecting a segment
+		template <typename Visitor>
+		void visitCells(const Vertex2D& A, const Vertex2D& B, Visitor&& visitor) const
+		{
+			// we use a thin rectangle around the segment
+			const CCVector2d a(A.x, A.y);
+			const CCVector2d b(B.x, B.y);
+			const double     length = (b - a).norm();
+			const double     margin = m_cellSize * 1.0e-3;
+			const CCVector2d u      = (length > 0 ? (b - a) / length : CCVector2d(1, 0)) * margin;
+			const CCVector2d n(-u.y, u.x);
+
+			const CCVector2d corners[4]{a - u - n, b + u - n, b + u + n, a - u + n};
+			visitCells(corners, visitor);
+		}
+
+	  protected:
+		double m_minX     = 0;
+		double m_minY     = 0;
+		double m_cellSize = 0;
+		double m_diagonal = 0;
+		int    m_dimX     = 0;
+		int    m_dimY     = 0;
+	};
+
+	//! Grid of the (projected) points (fast mode)
+	class PointGrid : public Grid2D
+	{
+	  public:
+		//! Initializes the grid and bins the points
+		/** \warning May throw std::bad_alloc
+		**/
+		bool init(const std::vector<Vertex2D>& points)
+		{
+			if (!Grid2D::init(points))
+			{
+				return false;
+			}
+
+			const size_t cellCount = Grid2D::cellCount();
+			cellStart.assign(cellCount + 1, 0);
+			cellStamps.assign(cellCount, 0);
+			pointIndexes.resize(points.size());
+
+			// counting sort of the points by cell
+			std::vector<unsigned> pointCells(points.size());
+			for (size_t i = 0; i < points.size(); ++i)
+			{
+				pointCells[i] = cellIndex(points[i]);
+				++cellStart[pointCells[i] + 1];
+			}
+			for (size_t c = 0; c < cellCount; ++c)
+			{
+				cellStart[c + 1] += cellStart[c];
+			}
+			std::vector<unsigned> cellFill(cellStart.begin(), cellStart.end() - 1);
+			for (size_t i = 0; i < points.size(); ++i)
+			{
+				pointIndexes[cellFill[pointCells[i]]++] = static_cast<unsigned>(i);
+			}
+
+			return true;
+		}
+
+		//! Returns a new stamp (so as to visit each cell only once per query)
+		unsigned newStamp()
+		{
+			if (++currentStamp == 0)
+			{
+				std::fill(cellStamps.begin(), cellStamps.end(), 0);
+				currentStamp = 1;
+			}
+			return currentStamp;
+		}
+
+		//! Index of the first point of each cell (in 'pointIndexes')
+		std::vector<unsigned> cellStart;
+		//! Points indexes (sorted by cell)
+		std::vector<unsigned> pointIndexes;
+		//! Cells stamps
+		std::vector<unsigned> cellStamps;
+		//! Current stamp
+		unsigned currentStamp = 0;
+	};
+
+	//! Grid of the envelope edges (fast mode)
+	class EdgeGrid
+	{
+	  public:
+		explicit EdgeGrid(const Grid2D& grid)
+		    : m_grid(grid)
+		{
+		}
+
+		//! Removes all the edges
+		/** \warning May throw std::bad_alloc
+		**/
+		void clear()
+		{
+			m_cells.clear();
+			m_cells.resize(m_grid.cellCount());
+			m_edges.clear();
+			m_currentStamp = 0;
+		}
+
+		//! Adds an edge
+		/** \warning May throw std::bad_alloc
+		    \return the edge index
+		**/
+		unsigned add(const Vertex2D* A, const Vertex2D* B)
+		{
+			const unsigned edgeIndex = static_cast<unsigned>(m_edges.size());
+			m_edges.push_back({A, B, true, 0});
+			m_grid.visitCells(*A, *B, [&](unsigned cellIndex)
+			                  { m_cells[cellIndex].push_back(edgeIndex); });
+			return edgeIndex;
+		}
+
+		//! Removes an edge
+		inline void remove(unsigned edgeIndex) { m_edges[edgeIndex].valid = false; }
+
+		//! Returns whether a segment intersects one of the edges (except the ones sharing a given vertex)
+		bool intersect(const Vertex2D& P, const Vertex2D& Q, unsigned sharedVertexIndex)
+		{
+			if (++m_currentStamp == 0)
+			{
+				for (EdgeInfo& edge : m_edges)
+				{
+					edge.stamp = 0;
+				}
+				m_currentStamp = 1;
+			}
+
+			bool intersect = false;
+			m_grid.visitCells(P, Q, [&](unsigned cellIndex)
+			                  {
+				if (intersect)
+				{
+					return;
+				}
+				for (unsigned edgeIndex : m_cells[cellIndex])
+				{
+					EdgeInfo& edge = m_edges[edgeIndex];
+					if (!edge.valid || edge.stamp == m_currentStamp)
+					{
+						continue;
+					}
+					edge.stamp = m_currentStamp;
+
+					if (edge.A->index != sharedVertexIndex && edge.B->index != sharedVertexIndex && CCCoreLib::PointProjectionTools::segmentIntersect(*edge.A, *edge.B, P, Q))
+					{
+						intersect = true;
+						return;
+					}
+				} });
+
+			return intersect;
+		}
+
+	  protected:
+		struct EdgeInfo
+		{
+			const Vertex2D* A;
+			const Vertex2D* B;
+			bool            valid;
+			unsigned        stamp;
+		};
+
+		const Grid2D&                      m_grid;
+		std::vector<std::vector<unsigned>> m_cells;
+		std::vector<EdgeInfo>              m_edges;
+		unsigned                           m_currentStamp = 0;
+	};
+
+	//! Edge in the priority queue (fast mode)
+	struct QueuedEdge
+	{
+		VertexIterator      itA;
+		unsigned            nearestPointIndex;
+		PointCoordinateType nearestPointSquareDist;
+		unsigned            order;
+
+		// std::priority_queue puts the 'largest' element on top: we want the nearest candidate first (and FIFO order for ties)
+		inline bool operator<(const QueuedEdge& e) const
+		{
+			return nearestPointSquareDist > e.nearestPointSquareDist || (nearestPointSquareDist == e.nearestPointSquareDist && order > e.order);
+		}
+	};
+
+	//! Returns the square distance between a candidate point and an edge (same criteria as FindNearestCandidate)
+	/** \return the square distance (or -1 if the point is not a valid candidate)
+	**/
+	inline PointCoordinateType CandidateSquareDist(const Vertex2D&     P,
+	                                               const Vertex2D&     A,
+	                                               const Vertex2D&     B,
+	                                               const CCVector2&    AB,
+	                                               PointCoordinateType squareLengthAB,
+	                                               PointCoordinateType minSquareEdgeLength,
+	                                               bool                allowLongerChunks,
+	                                               double              minCosAngle)
+	{
+		// skip the edge vertices!
+		if (P.index == A.index || P.index == B.index)
+		{
+			return -1;
+		}
+
+		// we only consider 'inner' points
+		const CCVector2 AP = P - A;
+		if (AB.x * AP.y - AB.y * AP.x < 0)
+		{
+			return -1;
+		}
+
+		// check the angle
+		if (minCosAngle > -1.0)
+		{
+			const CCVector2           PB         = B - P;
+			const PointCoordinateType dotProd    = AP.x * PB.x + AP.y * PB.y;
+			const PointCoordinateType minDotProd = static_cast<PointCoordinateType>(minCosAngle * std::sqrt(AP.norm2() * PB.norm2()));
+			if (dotProd < minDotProd)
+			{
+				return -1;
+			}
+		}
+
+		const PointCoordinateType dot = AB.dot(AP); // = cos(PAB) * ||AP|| * ||AB||
+		if (dot < 0 || dot > squareLengthAB)
+		{
+			return -1;
+		}
+
+		// at least one of the created edges must be smaller than the original one and we don't create too small edges!
+		const PointCoordinateType squareLengthAP = AP.norm2();
+		const PointCoordinateType squareLengthBP = (P - B).norm2();
+		if (squareLengthAP < minSquareEdgeLength
+		    || squareLengthBP < minSquareEdgeLength
+		    || (!allowLongerChunks && squareLengthAP >= squareLengthAB && squareLengthBP >= squareLengthAB))
+		{
+			return -1;
+		}
+
+		const CCVector2 HP = AP - AB * (dot / squareLengthAB);
+		return HP.norm2();
+	}
+
+	//! Finds the nearest (available) point to an edge with the points grid
+	/** Same result as FindNearestCandidate: the cells are visited by bands of
+	    increasing distance to the edge (on its inner side), until no closer point
+	    can be found.
+	    \return The nearest point (relative) distance (or -1 if no point was found!)
+	**/
+	PointCoordinateType FindNearestCandidateInGrid(unsigned&                          minIndex,
+	                                               const Vertex2D&                    A,
+	                                               const Vertex2D&                    B,
+	                                               const std::vector<Vertex2D>&       points,
+	                                               const std::vector<HullPointFlags>& pointFlags,
+	                                               PointGrid&                         grid,
+	                                               PointCoordinateType                minSquareEdgeLength,
+	                                               bool                               allowLongerChunks,
+	                                               double                             minCosAngle)
+	{
+		const CCVector2           AB             = B - A;
+		const PointCoordinateType squareLengthAB = AB.norm2();
+		const double              lengthAB       = std::sqrt(static_cast<double>(squareLengthAB));
+		if (lengthAB == 0)
+		{
+			return -1;
+		}
+
+		const CCVector2d a(A.x, A.y);
+		const CCVector2d b(B.x, B.y);
+		const CCVector2d u(AB.x / lengthAB, AB.y / lengthAB);
+		const CCVector2d n(-u.y, u.x); // towards the inner side
+		const double     cellSize = grid.cellSize();
+		const double     margin   = cellSize * 1.0e-3;
+		const CCVector2d uMargin  = u * margin;
+
+		// the points farther than ||AB|| from the edge can't create a smaller edge
+		const double maxDist = (allowLongerChunks ? grid.diagonal() : std::min(grid.diagonal(), lengthAB));
+
+		const unsigned      stamp    = grid.newStamp();
+		PointCoordinateType minDist2 = -1;
+		for (double dMin = 0; dMin <= maxDist; dMin += cellSize)
+		{
+			const double     dMax = dMin + cellSize;
+			const CCVector2d corners[4]{a - uMargin + n * (dMin - margin),
+			                            b + uMargin + n * (dMin - margin),
+			                            b + uMargin + n * (dMax + margin),
+			                            a - uMargin + n * (dMax + margin)};
+
+			grid.visitCells(corners, [&](unsigned cellIndex)
+			                {
+				if (grid.cellStamps[cellIndex] == stamp)
+				{
+					return;
+				}
+				grid.cellStamps[cellIndex] = stamp;
+
+				for (unsigned k = grid.cellStart[cellIndex]; k < grid.cellStart[cellIndex + 1]; ++k)
+				{
+					const unsigned  i = grid.pointIndexes[k];
+					const Vertex2D& P = points[i];
+					if (pointFlags[P.index] != POINT_NOT_USED)
+					{
+						continue;
+					}
+
+					const PointCoordinateType dist2 = CandidateSquareDist(P, A, B, AB, squareLengthAB, minSquareEdgeLength, allowLongerChunks, minCosAngle);
+					if (dist2 >= 0 && (minDist2 < 0 || dist2 < minDist2 || (dist2 == minDist2 && i < minIndex)))
+					{
+						minDist2 = dist2;
+						minIndex = i;
+					}
+				} });
+
+			// all the points closer than dMax have been tested
+			if (minDist2 >= 0 && minDist2 < dMax * dMax)
+			{
+				break;
+			}
+		}
+
+		return (minDist2 < 0 ? minDist2 : minDist2 / squareLengthAB);
+	}
+
+	//! Refines the (convex) hull with the 'fast' mode (see ccEnvelopeExtractor::ExtractionMode)
+	/** Same process as ccEnvelopeExtractor::ExtractConcaveHull2D, except that the
+	    edges having lost their candidate point are only updated when they reach the
+	    top of the queue.
+	**/
+	bool RefineConcaveHullFast(std::vector<Vertex2D>&       points,
+	                           std::list<Vertex2D*>&        hullPoints,
+	                           std::vector<HullPointFlags>& pointFlags,
+	                           bool                         closed,
+	                           bool                         allowMultiPass,
+	                           PointCoordinateType          maxSquareEdgeLength,
+	                           PointCoordinateType          minSquareEdgeLength,
+	                           double                       minCosAngle)
+	{
+		try
+		{
+			PointGrid pointGrid;
+			if (!pointGrid.init(points))
+			{
+				// all the points are at the same location
+				return true;
+			}
+			EdgeGrid edgeGrid(pointGrid);
+
+			// index of the envelope edge starting at each vertex
+			std::vector<unsigned> vertexEdge(points.size(), 0);
+
+			auto next = [&](VertexIterator it)
+			{
+				++it;
+				return (it == hullPoints.end() ? hullPoints.begin() : it);
+			};
+			auto position = [&](const Vertex2D* P)
+			{
+				return static_cast<size_t>(P - points.data());
+			};
+
+			std::priority_queue<QueuedEdge> edges;
+			unsigned                        edgeOrder = 0;
+			auto                            pushEdge  = [&](const VertexIterator& itA, bool allowLongerChunks)
+			{
+				unsigned                  nearestPointIndex = 0;
+				const PointCoordinateType minSquareDist     = FindNearestCandidateInGrid(nearestPointIndex,
+                                                                                     **itA,
+                                                                                     **next(itA),
+                                                                                     points,
+                                                                                     pointFlags,
+                                                                                     pointGrid,
+                                                                                     minSquareEdgeLength,
+                                                                                     allowLongerChunks,
+                                                                                     minCosAngle);
+				if (minSquareDist >= 0)
+				{
+					edges.push({itA, nearestPointIndex, minSquareDist, edgeOrder++});
+				}
+			};
+
+			unsigned step                = 0;
+			bool     somethingHasChanged = true;
+			while (somethingHasChanged)
+			{
+				somethingHasChanged = false;
+				++step;
+
+				// flag the envelope vertices and index its edges
+				assert(hullPoints.size() >= 2);
+				size_t initEdgeCount = hullPoints.size();
+				if (!closed)
+					--initEdgeCount;
+
+				for (Vertex2D* P : hullPoints)
+				{
+					pointFlags[P->index] = POINT_USED;
+				}
+
+				edgeGrid.clear();
+				{
+					VertexIterator itA = hullPoints.begin();
+					for (size_t i = 0; i < initEdgeCount; ++i, ++itA)
+					{
+						vertexEdge[position(*itA)] = edgeGrid.add(*itA, *next(itA));
+					}
+				}
+
+				// build the initial edge queue
+				// (we will only process the edges that are longer than the maximum specified length)
+				{
+					VertexIterator itA = hullPoints.begin();
+					for (size_t i = 0; i < initEdgeCount; ++i, ++itA)
+					{
+						if ((**next(itA) - **itA).norm2() > maxSquareEdgeLength)
+						{
+							pushEdge(itA, step > 1);
+						}
+					}
+				}
+
+				while (!edges.empty())
+				{
+					// current edge (AB): the one with the nearest 'candidate'
+					const QueuedEdge e = edges.top();
+					edges.pop();
+
+					VertexIterator itA = e.itA;
+					VertexIterator itB = next(itA);
+					Vertex2D&      P   = points[e.nearestPointIndex];
+
+					if (pointFlags[P.index] != POINT_NOT_USED)
+					{
+						// the candidate has been used by another edge in the meantime
+						pushEdge(itA, false);
+						continue;
+					}
+
+					// the new segments must not intersect with the actual hull!
+					if (edgeGrid.intersect(**itA, P, (*itA)->index) || edgeGrid.intersect(P, **itB, (*itB)->index))
+					{
+						continue;
+					}
+
+					// add point to concave hull
+					VertexIterator itP = hullPoints.insert(itB == hullPoints.begin() ? hullPoints.end() : itB, &P);
+
+					// we won't use P anymore!
+					pointFlags[P.index] = POINT_USED;
+
+					somethingHasChanged = true;
+
+					// update the edges index
+					edgeGrid.remove(vertexEdge[position(*itA)]);
+					vertexEdge[position(*itA)] = edgeGrid.add(*itA, &P);
+					vertexEdge[position(&P)]   = edgeGrid.add(&P, *itB);
+
+					// we'll inspect the two new segments later (if necessary)
+					if ((P - **itA).norm2() > maxSquareEdgeLength)
+					{
+						pushEdge(itA, false);
+					}
+					if ((**itB - P).norm2() > maxSquareEdgeLength)
+					{
+						pushEdge(itP, false);
+					}
+				}
+
+				if (!allowMultiPass)
+					break;
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			// not enough memory
+			return false;
+		}
+
+		return true;
+	}
+} // namespace
+
 bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
                                                std::list<Vertex2D*>&  hullPoints,
                                                EnvelopeType           envelopeType,
                                                bool                   allowMultiPass,
                                                PointCoordinateType    maxSquareEdgeLength /*=0*/,
                                                bool                   enableVisualDebugMode /*=false*/,
-                                               double                 maxAngleDeg /*=0.0*/)
+                                               double                 maxAngleDeg /*=0.0*/,
+                                               ExtractionMode         mode /*=STANDARD*/)
 {
 	// first compute the Convex hull
 	if (!CCCoreLib::PointProjectionTools::extractConvexHull2D(points, hullPoints))
@@ -362,17 +976,31 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 		}
 	}
 
+	if (mode == FAST && !enableVisualDebugMode)
+	{
+		return RefineConcaveHullFast(points,
+		                             hullPoints,
+		                             pointFlags,
+		                             envelopeType == FULL,
+		                             allowMultiPass,
+		                             maxSquareEdgeLength,
+		                             minSquareEdgeLength,
+		                             minCosAngle);
+	}
+
 	// DEBUG MECHANISM
-	ccEnvelopeExtractorDlg debugDialog;
-	ccPointCloud*          debugCloud            = nullptr;
-	ccPolyline*            debugEnvelope         = nullptr;
-	ccPointCloud*          debugEnvelopeVertices = nullptr;
+	// (the dialog is only created if necessary, so that the extraction can be run from a worker thread otherwise)
+	std::unique_ptr<ccEnvelopeExtractorDlg> debugDialog;
+	ccPointCloud*                           debugCloud            = nullptr;
+	ccPolyline*                             debugEnvelope         = nullptr;
+	ccPointCloud*                           debugEnvelopeVertices = nullptr;
 
 	if (enableVisualDebugMode)
 	{
-		debugDialog.init();
-		debugDialog.setGeometry(50, 50, 800, 600);
-		debugDialog.show();
+		debugDialog.reset(new ccEnvelopeExtractorDlg);
+		debugDialog->init();
+		debugDialog->setGeometry(50, 50, 800, 600);
+		debugDialog->show();
 		QCoreApplication::processEvents(); // make sure the dialog is visible or the call to zoomOn below won't be effective!
 
 		// create point cloud with all (2D) input points
@@ -385,7 +1013,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				debugCloud->addPoint(CCVector3(P.x, P.y, 0));
 			}
 			debugCloud->setPointSize(3);
-			debugDialog.addToDisplay(debugCloud, false); // the window will take care of deleting this entity!
+			debugDialog->addToDisplay(debugCloud, false); // the window will take care of deleting this entity!
 		}
 
 		// create polyline
@@ -407,7 +1035,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				debugEnvelope->setColor(ccColor::red);
 				debugEnvelopeVertices->setEnabled(false);
 				debugEnvelope->setClosed(envelopeType == FULL);
-				debugDialog.addToDisplay(debugEnvelope, false); // the window will take care of deleting this entity!
+				debugDialog->addToDisplay(debugEnvelope, false); // the window will take care of deleting this entity!
 			}
 			else
 			{
@@ -421,9 +1049,9 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 		// set zoom
 		{
 			ccBBox box = debugCloud->getOwnBB();
-			debugDialog.zoomOn(box);
+			debugDialog->zoomOn(box);
 		}
-		debugDialog.refresh();
+		debugDialog->refresh();
 	}
 
 	// Warning: high STL containers usage ahead ;)
@@ -511,7 +1139,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				cc2DLabel* edgeLabel = nullptr;
 				cc2DLabel* label     = nullptr;
 
-				if (enableVisualDebugMode && !debugDialog.isSkipped())
+				if (enableVisualDebugMode && !debugDialog->isSkipped())
 				{
 					edgeLabel       = new cc2DLabel("edge");
 					unsigned indexA = 0;
@@ -528,15 +1156,15 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 					edgeLabel->addPickedPoint(debugCloud, indexB);
 					edgeLabel->setVisible(true);
 					edgeLabel->setDisplayedIn2D(false);
-					debugDialog.addToDisplay(edgeLabel);
-					debugDialog.refresh();
+					debugDialog->addToDisplay(edgeLabel);
+					debugDialog->refresh();
 
 					label = new cc2DLabel("nearest point");
 					label->addPickedPoint(debugCloud, e.nearestPointIndex);
 					label->setVisible(true);
 					label->setSelected(true);
-					debugDialog.addToDisplay(label);
-					debugDialog.displayMessage(QString("nearest point found index #%1 (dist = %2)").arg(e.nearestPointIndex).arg(sqrt(e.nearestPointSquareDist)), true);
+					debugDialog->addToDisplay(label);
+					debugDialog->displayMessage(QString("nearest point found index #%1 (dist = %2)").arg(e.nearestPointIndex).arg(sqrt(e.nearestPointSquareDist)), true);
 				}
 
 				// check that we don't create too small edges!
@@ -551,7 +1179,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				//	pointFlags[P.index] = POINT_IGNORED;
 				//	edges.push(e); //retest the edge!
 				//	if (enableVisualDebugMode)
-				//		debugDialog.displayMessage("nearest point is too close!",true);
+				//		debugDialog->displayMessage("nearest point is too close!",true);
 				// }
 
 				// last check: the new segments must not intersect with the actual hull!
@@ -586,7 +1214,7 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 
 					somethingHasChanged = true;
 
-					if (enableVisualDebugMode && !debugDialog.isSkipped())
+					if (enableVisualDebugMode && !debugDialog->isSkipped())
 					{
 						if (debugEnvelope && debugEnvelopeVertices)
 						{
@@ -601,9 +1229,9 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 							}
 							debugEnvelope->reserve(hullSize);
 							debugEnvelope->addPointIndex(hullSize - 1);
-							debugDialog.refresh();
+							debugDialog->refresh();
 						}
-						debugDialog.displayMessage("point has been added to envelope", true);
+						debugDialog->displayMessage("point has been added to envelope", true);
 					}
 
 					// update all edges that were having 'P' as their nearest candidate as well
@@ -703,26 +1331,26 @@ bool ccEnvelopeExtractor::ExtractConcaveHull2D(std::vector<Vertex2D>& points,
 				else
 				{
 					if (enableVisualDebugMode)
-						debugDialog.displayMessage("[rejected] new edge would intersect the current envelope!", true);
+						debugDialog->displayMessage("[rejected] new edge would intersect the current envelope!", true);
 				}
 
 				// remove labels
 				if (label)
 				{
 					assert(enableVisualDebugMode);
-					debugDialog.removFromDisplay(label);
+					debugDialog->removFromDisplay(label);
 					delete label;
 					label = nullptr;
-					// debugDialog.refresh();
+					// debugDialog->refresh();
 				}
 
 				if (edgeLabel)
 				{
 					assert(enableVisualDebugMode);
-					debugDialog.removFromDisplay(edgeLabel);
+					debugDialog->removFromDisplay(edgeLabel);
 					delete edgeLabel;
 					edgeLabel = nullptr;
-					// debugDialog.refresh();
+					// debugDialog->refresh();
 				}
 			}
 		}
@@ -749,7 +1377,8 @@ ccPolyline* ccEnvelopeExtractor::ExtractFlatEnvelope(CCCoreLib::GenericIndexedCl
                                                      EnvelopeType                           envelopeType /*=FULL*/,
                                                      std::vector<unsigned>*                 originalPointIndexes /*=nullptr*/,
                                                      bool                                   enableVisualDebugMode /*=false*/,
-                                                     double                                 maxAngleDeg /*=0.0*/)
+                                                     double                                 maxAngleDeg /*=0.0*/,
+                                                     ExtractionMode                         mode /*=STANDARD*/)
 {
 	assert(points);
 
@@ -824,7 +1453,8 @@ ccPolyline* ccEnvelopeExtractor::ExtractFlatEnvelope(CCCoreLib::GenericIndexedCl
 	                          allowMultiPass,
 	                          maxEdgeLength * maxEdgeLength,
 	                          enableVisualDebugMode,
-	                          maxAngleDeg))
+	                          maxAngleDeg,
+	                          mode))
 	{
 		ccLog::Warning("[ExtractFlatEnvelope] Failed to compute the convex hull of the input points!");
 		return nullptr;
@@ -901,12 +1531,13 @@ bool ccEnvelopeExtractor::ExtractFlatEnvelope(CCCoreLib::GenericIndexedCloudPers
                                               bool                                   allowSplitting /*=true*/,
                                               const PointCoordinateType*             preferredNormDir /*=nullptr*/,
                                               const PointCoordinateType*             preferredUpDir /*=nullptr*/,
-                                              bool                                   enableVisualDebugMode /*=false*/)
+                                              bool                                   enableVisualDebugMode /*=false*/,
+                                              ExtractionMode                         mode /*=STANDARD*/)
 {
 	parts.clear();
 
 	// extract whole envelope
-	ccPolyline* basePoly = ExtractFlatEnvelope(points, allowMultiPass, maxEdgeLength, preferredNormDir, preferredUpDir, envelopeType, nullptr, enableVisualDebugMode);
+	ccPolyline* basePoly = ExtractFlatEnvelope(points, allowMultiPass, maxEdgeLength, preferredNormDir, preferredUpDir, envelopeType, nullptr, enableVisualDebugMode, 0.0, mode);
 	if (!basePoly)
 	{
 		return false;
@@ -925,3 +1556,83 @@ bool ccEnvelopeExtractor::ExtractFlatEnvelope(CCCoreLib::GenericIndexedCloudPers
 
 	return success;
 }
+
+ccEnvelopeExtractor::BatchResult ccEnvelopeExtractor::ExtractFlatEnvelopes(const std::vector<CCCoreLib::GenericIndexedCloudPersist*>& clouds,
+                                                                          const BatchParameters&                                     params,
+                                                                          std::vector<std::vector<ccPolyline*>>&                     envelopes,
+                                                                          std::vector<bool>&                                         success,
+                                                                          CCCoreLib::GenericProgressCallback*                        progressCb /*=nullptr*/)
+{
+	envelopes.clear();
+	success.clear();
+
+	std::vector<char> cloudSuccess;
+	try
+	{
+		envelopes.resize(clouds.size());
+		cloudSuccess.resize(clouds.size(), 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		// not enough memory
+		envelopes.clear();
+		return BATCH_NOT_ENOUGH_MEMORY;
+	}
+
+	std::atomic<bool>             cancelled(false);
+	std::atomic<bool>             notEnoughMemory(false);
+	CCCoreLib::NormalizedProgress nProgress(params.enableVisualDebugMode ? nullptr : progressCb, static_cast<unsigned>(clouds.size()));
+	const int                     cloudCount = static_cast<int>(clouds.size());
+
+#if defined(_OPENMP)
+	const int threadCount = (params.maxThreadCount > 0 ? params.maxThreadCount : omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount) if (!params.enableVisualDebugMode)
+#endif
+	for (int i = 0; i < cloudCount; ++i)
+	{
+		if (cancelled || notEnoughMemory)
+		{
+			continue;
+		}
+
+		try
+		{
+			cloudSuccess[i] = ExtractFlatEnvelope(clouds[i],
+			                                      params.allowMultiPass,
+			                                      params.maxEdgeLength,
+			                                      envelopes[i],
+			                                      params.envelopeType,
+			                                      params.allowSplitting,
+			                                      params.preferredNormDim,
+			                                      params.preferredUpDir,
+			                                      params.enableVisualDebugMode,
+			                                      params.mode);
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+		}
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	}
+
+	if (cancelled || notEnoughMemory)
+	{
+		for (std::vector<ccPolyline*>& parts : envelopes)
+		{
+			for (ccPolyline* poly : parts)
+			{
+				delete poly;
+			}
+		}
+		envelopes.clear();
+		return (notEnoughMemory ? BATCH_NOT_ENOUGH_MEMORY : BATCH_CANCELLED);
+	}
+
+	success.assign(cloudSuccess.begin(), cloudSuccess.end());
+
+	return BATCH_SUCCESS;
+}
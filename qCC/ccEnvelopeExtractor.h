@@ -23,6 +23,11 @@
 // CCCoreLib
 #include <PointProjectionTools.h>
 
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+}
+
 //! Envelope extractor (with debug GUI)
 class ccEnvelopeExtractor
 {
@@ -35,6 +40,50 @@ class ccEnvelopeExtractor
 		FULL
 	};
 
+	//! Extraction mode
+	/** Both modes select the same points (in the same order), the 'fast' mode
+	    simply looks for the candidate points with a uniform 2D grid over the
+	    projected points, and for the intersections with the current envelope
+	    with a grid of its edges (instead of scanning all the points and edges).
+	    The visual debug mode is only supported by the standard mode.
+	**/
+	enum ExtractionMode
+	{
+		STANDARD,
+		FAST
+	};
+
+	//! Batch extraction result (see ExtractFlatEnvelopes)
+	enum BatchResult
+	{
+		BATCH_SUCCESS,
+		BATCH_NOT_ENOUGH_MEMORY,
+		BATCH_CANCELLED
+	};
+
+	//! Batch extraction parameters (see ExtractFlatEnvelopes)
+	struct BatchParameters
+	{
+		//! Whether to allow multi-pass process
+		bool allowMultiPass = false;
+		//! Max edge length (ignored if 0, in which case the envelopes are the convex hulls)
+		PointCoordinateType maxEdgeLength = 0;
+		//! Envelope type
+		EnvelopeType envelopeType = FULL;
+		//! Whether the envelopes can be split or not
+		bool allowSplitting = true;
+		//! Preferred (normal) direction (optional)
+		const PointCoordinateType* preferredNormDim = nullptr;
+		//! Preferred up direction (optional)
+		const PointCoordinateType* preferredUpDir = nullptr;
+		//! Extraction mode
+		ExtractionMode mode = FAST;
+		//! Visual debug mode (the clouds are then processed sequentially)
+		bool enableVisualDebugMode = false;
+		//! Max number of threads (0 = all)
+		int maxThreadCount = 0;
+	};
+
 	//! Extracts a unique closed (2D) envelope polyline of a point cloud
 	/** Projects the cloud on its best fitting LS plane first.
 	    \param points point cloud
@@ -46,6 +95,7 @@ class ccEnvelopeExtractor
 	    \param[out] originalPointIndexes to get the indexes (relatively to the input cloud) of the output polyline vertices
 	    \param enableVisualDebugMode whether to display a (debug) window to represent the algorithm process
 	    \param maxAngleDeg max angle between segments (angle between 0 and 180, in degrees)
+	    \param mode extraction mode
 	    \return envelope polyline (or 0 if an error occurred)
 	**/
 	static ccPolyline* ExtractFlatEnvelope(CCCoreLib::GenericIndexedCloudPersist* points,
@@ -56,7 +106,8 @@ class ccEnvelopeExtractor
 	                                       EnvelopeType                           envelopeType          = FULL,
 	                                       std::vector<unsigned>*                 originalPointIndexes  = nullptr,
 	                                       bool                                   enableVisualDebugMode = false,
-	                                       double                                 maxAngleDeg           = 0.0);
+	                                       double                                 maxAngleDeg           = 0.0,
+	                                       ExtractionMode                         mode                  = STANDARD);
 
 	//! Extracts one or several parts of the (2D) envelope polyline of a point cloud
 	/** Projects the cloud on its best fitting LS plane first.
@@ -70,6 +121,7 @@ class ccEnvelopeExtractor
 	    \param preferredNormDim to specifiy a preferred (normal) direction for the polyline extraction
 	    \param preferredUpDir to specifiy a preferred up direction for the polyline extraction (preferredNormDim must be defined as well and must be normal to this 'up' direction)
 	    \param enableVisualDebugMode whether to display a (debug) window to represent the algorithm process
+	    \param mode extraction mode
 	    \return success
 	**/
 	static bool ExtractFlatEnvelope(CCCoreLib::GenericIndexedCloudPersist* points,
@@ -80,7 +132,23 @@ class ccEnvelopeExtractor
 	                                bool                                   allowSplitting        = true,
 	                                const PointCoordinateType*             preferredNormDim      = nullptr,
 	                                const PointCoordinateType*             preferredUpDir        = nullptr,
-	                                bool                                   enableVisualDebugMode = false);
+	                                bool                                   enableVisualDebugMode = false,
+	                                ExtractionMode                         mode                  = STANDARD);
+
+	//! Extracts the (2D) envelopes of several clouds in parallel
+	/** Same as the above method, applied to each cloud independently.
+	    \param clouds input clouds
+	    \param params extraction parameters
+	    \param[out] envelopes output polyline parts (one set per cloud - may be empty, see above)
+	    \param[out] success whether the extraction succeeded or not (for each cloud)
+	    \param progressCb optional progress callback (one step per cloud)
+	    \return BATCH_SUCCESS, or the reason why the process failed (nothing is output then)
+	**/
+	static BatchResult ExtractFlatEnvelopes(const std::vector<CCCoreLib::GenericIndexedCloudPersist*>& clouds,
+	                                 const BatchParameters&                                     params,
+	                                 std::vector<std::vector<ccPolyline*>>&                     envelopes,
+	                                 std::vector<bool>&                                         success,
+	                                 CCCoreLib::GenericProgressCallback*                        progressCb = nullptr);
 
   protected:
 	//! Determines the 'concave' hull of a set of points
@@ -96,6 +164,7 @@ class ccEnvelopeExtractor
 	    \param maxSquareLength maximum square length (ignored if <= 0, in which case the method simply returns the convex hull!)
 	    \param enableVisualDebugMode whether to display a (debug) window to represent the algorithm process
 	    \param maxAngleDeg max angle between segments (angle between 0 and 180, in degrees)
+	    \param mode extraction mode
 	    \return success
 	**/
 	static bool ExtractConcaveHull2D(std::vector<CCCoreLib::PointProjectionTools::IndexedCCVector2>& points,
@@ -104,5 +173,6 @@ class ccEnvelopeExtractor
 	                                 bool                                                            allowMultiPass,
 	                                 PointCoordinateType                                             maxSquareLength       = 0,
 	                                 bool                                                            enableVisualDebugMode = false,
-	                                 double                                                          maxAngleDeg           = 90.0);
+	                                 double                                                          maxAngleDeg           = 90.0,
+	                                 ExtractionMode                                                  mode                  = STANDARD);
 };
@@ -0,0 +1,816 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccICPEngine.h"
+
+// CCCoreLib
+#include <GenericIndexedCloudPersist.h>
+#include <GenericIndexedMesh.h>
+#include <GenericProgressCallback.h>
+#include <Jacobi.h>
+#include <ScalarField.h>
+
+// qCC_db
+#include <ccGenericMesh.h>
+#include <ccGenericPointCloud.h>
+#include <ccHObjectCaster.h>
+#include <ccLog.h>
+
+// Qt
+#include <QString>
+
+// System
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+//! Number of data points processed by each parallel task
+static const unsigned s_icpChunkSize = 1024;
+
+namespace
+{
+	//! Rigid (+ scale) transformation: P' = s.R.P + T
+	struct Pose
+	{
+		double R[3][3]{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+		double T[3]{0, 0, 0};
+		double s = 1.0;
+
+		inline CCVector3d apply(const CCVector3& P) const
+		{
+			return {s * (R[0][0] * P.x + R[0][1] * P.y + R[0][2] * P.z) + T[0],
+			        s * (R[1][0] * P.x + R[1][1] * P.y + R[1][2] * P.z) + T[1],
+			        s * (R[2][0] * P.x + R[2][1] * P.y + R[2][2] * P.z) + T[2]};
+		}
+
+		//! Returns inc o this
+		Pose composedWith(const Pose& inc) const
+		{
+			Pose result;
+			for (unsigned i = 0; i < 3; ++i)
+			{
+				for (unsigned j = 0; j < 3; ++j)
+				{
+					result.R[i][j] = inc.R[i][0] * R[0][j] + inc.R[i][1] * R[1][j] + inc.R[i][2] * R[2][j];
+				}
+				result.T[i] = inc.s * (inc.R[i][0] * T[0] + inc.R[i][1] * T[1] + inc.R[i][2] * T[2]) + inc.T[i];
+			}
+			result.s = inc.s * s;
+			return result;
+		}
+
+		//! Converts the pose to a CCCoreLib transformation
+		ccICPEngine::Transformation toTransformation() const
+		{
+			ccICPEngine::Transformation trans;
+			trans.R = CCCoreLib::SquareMatrix(3);
+			for (unsigned i = 0; i < 3; ++i)
+			{
+				for (unsigned j = 0; j < 3; ++j)
+				{
+					trans.R.setValue(i, j, static_cast<PointCoordinateType>(R[i][j]));
+				}
+				trans.T.u[i] = static_cast<PointCoordinateType>(T[i]);
+			}
+			trans.s = static_cast<PointCoordinateType>(s);
+			return trans;
+		}
+
+		//! Sets the pose from a CCCoreLib transformation
+		void fromTransformation(const ccICPEngine::Transformation& trans)
+		{
+			for (unsigned i = 0; i < 3; ++i)
+			{
+				for (unsigned j = 0; j < 3; ++j)
+				{
+					R[i][j] = (trans.R.isValid() ? trans.R.getValue(i, j) : (i == j ? 1.0 : 0.0));
+				}
+				T[i] = trans.T.u[i];
+			}
+			s = trans.s;
+		}
+	};
+
+	//! Per-task partial sums (point-to-point metric)
+	struct PointToPointSums
+	{
+		double     w = 0;
+		double     squareDist = 0;
+		unsigned   count      = 0;
+		CCVector3d P{0, 0, 0};
+		CCVector3d Q{0, 0, 0};
+		double     PQ[3][3]{{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+		double     PP = 0;
+	};
+
+	//! Per-task partial sums (point-to-plane metric)
+	struct PointToPlaneSums
+	{
+		double A[6][6]{};
+		double b[6]{};
+	};
+
+	//! Solves a (symmetric, positive semi-definite) 6x6 system with Gaussian elimination
+	/** A small regularization is added so that under-constrained motions are simply discarded.
+	 **/
+	bool Solve6x6(double A[6][6], double b[6], double x[6])
+	{
+		double trace = 0;
+		for (unsigned i = 0; i < 6; ++i)
+		{
+			trace += A[i][i];
+		}
+		if (!(trace > 0))
+		{
+			return false;
+		}
+		for (unsigned i = 0; i < 6; ++i)
+		{
+			A[i][i] += 1.0e-9 * trace;
+		}
+
+		for (unsigned c = 0; c < 6; ++c)
+		{
+			// partial pivoting
+			unsigned pivot = c;
+			for (unsigned r = c + 1; r < 6; ++r)
+			{
+				if (std::abs(A[r][c]) > std::abs(A[pivot][c]))
+				{
+					pivot = r;
+				}
+			}
+			if (A[pivot][c] == 0)
+			{
+				return false;
+			}
+			if (pivot != c)
+			{
+				std::swap(A[pivot], A[c]);
+				std::swap(b[pivot], b[c]);
+			}
+
+			for (unsigned r = c + 1; r < 6; ++r)
+			{
+				double f = A[r][c] / A[c][c];
+				for (unsigned k = c; k < 6; ++k)
+				{
+					A[r][k] -= f * A[c][k];
+				}
+				b[r] -= f * b[c];
+			}
+		}
+
+		for (int r = 5; r >= 0; --r)
+		{
+			double sum = b[r];
+			for (unsigned k = r + 1; k < 6; ++k)
+			{
+				sum -= A[r][k] * x[k];
+			}
+			x[r] = sum / A[r][r];
+		}
+
+		return true;
+	}
+} // namespace
+
+bool ccICPEngine::Model::hasNormals() const
+{
+	return (meshIndex != nullptr) || (cloud && cloud->hasNormals());
+}
+
+ccICPEngine::Model::Shared ccICPEngine::PrepareModel(ccHObject*                          model,
+                                                     int                                 maxThreadCount /*=0*/,
+                                                     CCCoreLib::GenericProgressCallback* progressCb /*=nullptr*/)
+{
+	if (!model)
+	{
+		return {};
+	}
+
+	Model::Shared preparedModel(new Model);
+	if (model->isKindOf(CC_TYPES::MESH))
+	{
+		ccGenericMesh* mesh  = ccHObjectCaster::ToGenericMesh(model);
+		preparedModel->mesh  = mesh;
+		preparedModel->meshIndex = ccTriangleBVH::Build(mesh, maxThreadCount, progressCb);
+		if (!preparedModel->meshIndex)
+		{
+			return {};
+		}
+	}
+	else
+	{
+		ccGenericPointCloud* cloud = ccHObjectCaster::ToGenericPointCloud(model);
+		if (!cloud)
+		{
+			return {};
+		}
+		preparedModel->cloud = cloud;
+		// the cloud index is persistent (it will be reused by the next registrations as well)
+		preparedModel->cloudIndex = cloud->getNearestNeighbourIndex(true, progressCb);
+		if (!preparedModel->cloudIndex)
+		{
+			return {};
+		}
+	}
+
+	return preparedModel;
+}
+
+bool ccICPEngine::CanRegister(const Parameters& params)
+{
+	return !params.useC2MSignedDistances
+	       && params.normalsMatching == CCCoreLib::ICPRegistrationTools::NO_NORMAL;
+}
+
+ccICPEngine::RESULT_TYPE ccICPEngine::Register(const Model&                           model,
+                                               CCCoreLib::GenericIndexedCloudPersist* dataCloud,
+                                               const Parameters&                      params,
+                                               Metric                                 metric,
+                                               Transformation&                        transform,
+                                               double&                                finalRMS,
+                                               unsigned&                              finalPointCount,
+                                               CCCoreLib::GenericProgressCallback*    progressCb /*=nullptr*/)
+{
+	if (!dataCloud || dataCloud->size() == 0 || (!model.cloudIndex && !model.meshIndex))
+	{
+		return CCCoreLib::ICPRegistrationTools::ICP_ERROR_INVALID_INPUT;
+	}
+
+	if (metric == POINT_TO_PLANE && !model.hasNormals())
+	{
+		ccLog::Warning("[ICP] The point-to-plane metric requires model normals: point-to-point metric will be used instead");
+		metric = POINT_TO_POINT;
+	}
+	const bool pointToPlane = (metric == POINT_TO_PLANE);
+	const bool adjustScale  = (params.adjustScale && !pointToPlane);
+	if (params.adjustScale && pointToPlane)
+	{
+		ccLog::Warning("[ICP] The scale can't be adjusted with the point-to-plane metric");
+	}
+
+	const CCCoreLib::ScalarField* modelWeights = (model.cloud ? params.modelWeights : nullptr);
+	if (modelWeights && modelWeights->currentSize() < model.cloud->size())
+	{
+		return CCCoreLib::ICPRegistrationTools::ICP_ERROR_INVALID_INPUT;
+	}
+	if (params.dataWeights && params.dataWeights->currentSize() < dataCloud->size())
+	{
+		return CCCoreLib::ICPRegistrationTools::ICP_ERROR_INVALID_INPUT;
+	}
+
+	// data points (randomly sampled if necessary) and per-point buffers
+	std::vector<CCVector3>           dataPoints;
+	std::vector<PointCoordinateType> dataWeights;
+	std::vector<CCVector3>           modelPoints;
+	std::vector<CCVector3>           modelNormals;
+	std::vector<PointCoordinateType> squareDists;
+	std::vector<PointCoordinateType> baseWeights;
+	std::vector<PointCoordinateType> weights;
+	std::vector<PointCoordinateType> sortedSquareDists;
+	try
+	{
+		std::vector<unsigned> indexes(dataCloud->size());
+		std::iota(indexes.begin(), indexes.end(), 0);
+		if (params.samplingLimit > 0 && indexes.size() > params.samplingLimit)
+		{
+			// partial Fisher-Yates shuffle (with a constant seed, so that the results are reproducible)
+			std::mt19937 generator(0);
+			for (unsigned i = 0; i < params.samplingLimit; ++i)
+			{
+				std::uniform_int_distribution<size_t> distribution(i, indexes.size() - 1);
+				std::swap(indexes[i], indexes[distribution(generator)]);
+			}
+			indexes.resize(params.samplingLimit);
+			// restore the original order (for a better memory coherence)
+			std::sort(indexes.begin(), indexes.end());
+		}
+
+		const size_t count = indexes.size();
+		dataPoints.resize(count);
+		dataWeights.resize(count, 1);
+		for (size_t i = 0; i < count; ++i)
+		{
+			dataPoints[i] = *dataCloud->getPoint(indexes[i]);
+			if (params.dataWeights)
+			{
+				// absolute values (NaN values are ignored)
+				ScalarType w   = params.dataWeights->getValue(indexes[i]);
+				dataWeights[i] = (std::isfinite(w) ? std::abs(w) : 0);
+			}
+		}
+
+		modelPoints.resize(count);
+		if (pointToPlane)
+		{
+			modelNormals.resize(count);
+		}
+		squareDists.resize(count);
+		baseWeights.resize(count);
+		weights.resize(count);
+		sortedSquareDists.reserve(count);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CCCoreLib::ICPRegistrationTools::ICP_ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	const unsigned count      = static_cast<unsigned>(dataPoints.size());
+	const int      chunkCount = static_cast<int>((count + s_icpChunkSize - 1) / s_icpChunkSize);
+
+	std::vector<PointToPointSums> pointSums;
+	std::vector<PointToPlaneSums> planeSums;
+	try
+	{
+		pointSums.resize(chunkCount);
+		if (pointToPlane)
+		{
+			planeSums.resize(chunkCount);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return CCCoreLib::ICPRegistrationTools::ICP_ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+#if defined(_OPENMP)
+	const int threadCount = (params.maxThreadCount > 0 ? params.maxThreadCount : omp_get_max_threads());
+#endif
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("ICP");
+			progressCb->setInfo(qPrintable(QString("Points: %1").arg(count)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	Pose     pose;
+	Pose     previousPose;
+	double   rms           = -1.0;
+	double   previousRMS   = -1.0;
+	unsigned pointCount    = 0;
+	unsigned previousCount = 0;
+
+	for (unsigned iteration = 0;; ++iteration)
+	{
+		// 1) correspondences
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			const unsigned begin = static_cast<unsigned>(c) * s_icpChunkSize;
+			const unsigned end   = std::min(begin + s_icpChunkSize, count);
+			for (unsigned i = begin; i < end; ++i)
+			{
+				CCVector3 P = pose.apply(dataPoints[i]).toPC();
+
+				PointCoordinateType squareDist  = 0;
+				PointCoordinateType modelWeight = 1;
+				bool                found       = false;
+				if (model.cloudIndex)
+				{
+					int nearestIndex = model.cloudIndex->findNearestNeighbour(P, -1, squareDist);
+					if (nearestIndex >= 0)
+					{
+						found          = true;
+						modelPoints[i] = *model.cloud->getPoint(static_cast<unsigned>(nearestIndex));
+						if (pointToPlane)
+						{
+							modelNormals[i] = model.cloud->getPointNormal(static_cast<unsigned>(nearestIndex));
+						}
+						if (modelWeights)
+						{
+							ScalarType w = modelWeights->getValue(static_cast<unsigned>(nearestIndex));
+							modelWeight  = (std::isfinite(w) ? std::abs(w) : 0);
+						}
+					}
+				}
+				else
+				{
+					ccTriangleBVH::ClosestTriangle closest;
+					if (model.meshIndex->findClosestTriangle(P, -1, false, closest))
+					{
+						found = true;
+
+						CCVector3 A;
+						CCVector3 B;
+						CCVector3 C;
+						model.mesh->getTriangleVertices(static_cast<unsigned>(closest.triangleIndex), A, B, C);
+						modelPoints[i] = ccTriangleBVH::ClosestPointOnTriangle(P, A, B, C);
+						squareDist     = (P - modelPoints[i]).norm2();
+						if (pointToPlane)
+						{
+							modelNormals[i] = (B - A).cross(C - A);
+							modelNormals[i].normalize();
+						}
+					}
+				}
+
+				squareDists[i] = squareDist;
+				baseWeights[i] = (found ? dataWeights[i] * modelWeight : 0);
+			}
+		}
+
+		if (progressCb && progressCb->isCancelRequested())
+		{
+			return CCCoreLib::ICPRegistrationTools::ICP_ERROR_CANCELED_BY_USER;
+		}
+
+		// 2) trimming
+		PointCoordinateType maxSquareDist = std::numeric_limits<PointCoordinateType>::max();
+		{
+			sortedSquareDists.clear();
+			double sumDist       = 0;
+			double sumSquareDist = 0;
+			for (unsigned i = 0; i < count; ++i)
+			{
+				if (baseWeights[i] > 0)
+				{
+					sortedSquareDists.push_back(squareDists[i]);
+					sumDist += std::sqrt(squareDists[i]);
+					sumSquareDist += squareDists[i];
+				}
+			}
+			if (sortedSquareDists.size() < 3)
+			{
+				ccLog::Warning("[ICP] Not enough valid correspondences");
+				return CCCoreLib::ICPRegistrationTools::ICP_ERROR_REGISTRATION_STEP;
+			}
+
+			if (params.finalOverlapRatio < 1.0)
+			{
+				// we only keep the closest correspondences
+				size_t keptCount = std::max<size_t>(3, static_cast<size_t>(std::ceil(sortedSquareDists.size() * params.finalOverlapRatio)));
+				if (keptCount < sortedSquareDists.size())
+				{
+					std::nth_element(sortedSquareDists.begin(), sortedSquareDists.begin() + (keptCount - 1), sortedSquareDists.end());
+					maxSquareDist = sortedSquareDists[keptCount - 1];
+				}
+			}
+
+			if (params.filterOutFarthestPoints)
+			{
+				// we discard the correspondences farther than mean + 3 * std. dev.
+				double n        = static_cast<double>(sortedSquareDists.size());
+				double mean     = sumDist / n;
+				double variance = std::max(0.0, sumSquareDist / n - mean * mean);
+				double maxDist  = mean + 3.0 * std::sqrt(variance);
+				maxSquareDist   = std::min(maxSquareDist, static_cast<PointCoordinateType>(maxDist * maxDist));
+			}
+		}
+
+		// 3) weighting (branch-free pass)
+		{
+			const PointCoordinateType* _squareDists = squareDists.data();
+			const PointCoordinateType* _baseWeights = baseWeights.data();
+			PointCoordinateType*       _weights     = weights.data();
+			for (unsigned i = 0; i < count; ++i)
+			{
+				_weights[i] = (_squareDists[i] <= maxSquareDist ? _baseWeights[i] : 0);
+			}
+		}
+
+		// 4) partial sums (one set per chunk, so that the result doesn't depend on the number of threads)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(threadCount)
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			PointToPointSums sums;
+			const unsigned   begin = static_cast<unsigned>(c) * s_icpChunkSize;
+			const unsigned   end   = std::min(begin + s_icpChunkSize, count);
+			for (unsigned i = begin; i < end; ++i)
+			{
+				const double w = weights[i];
+				if (w > 0)
+				{
+					sums.w += w;
+					sums.squareDist += w * squareDists[i];
+					++sums.count;
+					sums.P += pose.apply(dataPoints[i]) * w;
+					sums.Q += modelPoints[i].toDouble() * w;
+				}
+			}
+			pointSums[c] = sums;
+		}
+
+		PointToPointSums total;
+		for (const PointToPointSums& sums : pointSums)
+		{
+			total.w += sums.w;
+			total.squareDist += sums.squareDist;
+			total.count += sums.count;
+			total.P += sums.P;
+			total.Q += sums.Q;
+		}
+		if (total.count < 3 || !(total.w > 0))
+		{
+			ccLog::Warning("[ICP] Not enough valid correspondences");
+			return CCCoreLib::ICPRegistrationTools::ICP_ERROR_REGISTRATION_STEP;
+		}
+
+		rms        = std::sqrt(total.squareDist / total.w);
+		pointCount = total.count;
+
+		if (progressCb)
+		{
+			if (progressCb->textCanBeEdited())
+			{
+				progressCb->setInfo(qPrintable(QString("Iteration %1\nRMS = %2 (%3 points)").arg(iteration + 1).arg(rms).arg(pointCount)));
+			}
+			if (params.convType == CCCoreLib::ICPRegistrationTools::MAX_ITER_CONVERGENCE && params.nbMaxIterations != 0)
+			{
+				progressCb->update((100.0f * iteration) / params.nbMaxIterations);
+			}
+		}
+
+		// 5) convergence
+		if (previousRMS >= 0)
+		{
+			if (rms > previousRMS)
+			{
+				// the error increases: we keep the previous step
+				pose       = previousPose;
+				rms        = previousRMS;
+				pointCount = previousCount;
+				break;
+			}
+			if (params.convType == CCCoreLib::ICPRegistrationTools::MAX_ERROR_CONVERGENCE && previousRMS - rms < params.minRMSDecrease)
+			{
+				break;
+			}
+		}
+		if (params.convType == CCCoreLib::ICPRegistrationTools::MAX_ITER_CONVERGENCE && iteration >= params.nbMaxIterations)
+		{
+			break;
+		}
+		previousPose  = pose;
+		previousRMS   = rms;
+		previousCount = pointCount;
+
+		// 6) registration step (between the currently transformed data points and their correspondences)
+		const CCVector3d Gp = total.P / total.w;
+		const CCVector3d Gq = total.Q / total.w;
+
+		Pose increment;
+		if (pointToPlane)
+		{
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(threadCount)
+#endif
+			for (int c = 0; c < chunkCount; ++c)
+			{
+				PointToPlaneSums sums;
+				const unsigned   begin = static_cast<unsigned>(c) * s_icpChunkSize;
+				const unsigned   end   = std::min(begin + s_icpChunkSize, count);
+				for (unsigned i = begin; i < end; ++i)
+				{
+					const double w = weights[i];
+					if (w > 0)
+					{
+						// coordinates relative to the model gravity center (better conditioning)
+						CCVector3d X = pose.apply(dataPoints[i]) - Gq;
+						CCVector3d Y = modelPoints[i].toDouble() - Gq;
+						CCVector3d N = modelNormals[i].toDouble();
+
+						CCVector3d XxN = X.cross(N);
+						double     a[6]{XxN.x, XxN.y, XxN.z, N.x, N.y, N.z};
+						double     r = (Y - X).dot(N);
+						for (unsigned k = 0; k < 6; ++k)
+						{
+							for (unsigned l = k; l < 6; ++l)
+							{
+								sums.A[k][l] += w * a[k] * a[l];
+							}
+							sums.b[k] += w * a[k] * r;
+						}
+					}
+				}
+				planeSums[c] = sums;
+			}
+
+			double A[6][6]{};
+			double b[6]{};
+			for (const PointToPlaneSums& sums : planeSums)
+			{
+				for (unsigned k = 0; k < 6; ++k)
+				{
+					for (unsigned l = k; l < 6; ++l)
+					{
+						A[k][l] += sums.A[k][l];
+					}
+					b[k] += sums.b[k];
+				}
+			}
+			for (unsigned k = 0; k < 6; ++k)
+			{
+				for (unsigned l = 0; l < k; ++l)
+				{
+					A[k][l] = A[l][k];
+				}
+			}
+
+			double x[6];
+			if (!Solve6x6(A, b, x))
+			{
+				ccLog::Warning("[ICP] Failed to solve the point-to-plane system");
+				return CCCoreLib::ICPRegistrationTools::ICP_ERROR_REGISTRATION_STEP;
+			}
+
+			// R = Rz(gamma).Ry(beta).Rx(alpha)
+			const double ca = std::cos(x[0]);
+			const double sa = std::sin(x[0]);
+			const double cb = std::cos(x[1]);
+			const double sb = std::sin(x[1]);
+			const double cg = std::cos(x[2]);
+			const double sg = std::sin(x[2]);
+
+			increment.R[0][0] = cg * cb;
+			increment.R[0][1] = cg * sb * sa - sg * ca;
+			increment.R[0][2] = cg * sb * ca + sg * sa;
+			increment.R[1][0] = sg * cb;
+			increment.R[1][1] = sg * sb * sa + cg * ca;
+			increment.R[1][2] = sg * sb * ca - cg * sa;
+			increment.R[2][0] = -sb;
+			increment.R[2][1] = cb * sa;
+			increment.R[2][2] = cb * ca;
+
+			// X' = R.(X - Gq) + Gq + t
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				increment.T[k] = Gq.u[k] + x[3 + k] - (increment.R[k][0] * Gq.x + increment.R[k][1] * Gq.y + increment.R[k][2] * Gq.z);
+			}
+		}
+		else
+		{
+			// weighted cross-covariance matrix (and variance of the data points)
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(threadCount)
+#endif
+			for (int c = 0; c < chunkCount; ++c)
+			{
+				PointToPointSums& sums  = pointSums[c];
+				const unsigned    begin = static_cast<unsigned>(c) * s_icpChunkSize;
+				const unsigned    end   = std::min(begin + s_icpChunkSize, count);
+				for (unsigned i = begin; i < end; ++i)
+				{
+					const double w = weights[i];
+					if (w > 0)
+					{
+						CCVector3d X = pose.apply(dataPoints[i]) - Gp;
+						CCVector3d Y = modelPoints[i].toDouble() - Gq;
+						for (unsigned k = 0; k < 3; ++k)
+						{
+							for (unsigned l = 0; l < 3; ++l)
+							{
+								sums.PQ[k][l] += w * X.u[k] * Y.u[l];
+							}
+						}
+						sums.PP += w * X.norm2();
+					}
+				}
+			}
+
+			double S[3][3]{};
+			double PP = 0;
+			for (const PointToPointSums& sums : pointSums)
+			{
+				for (unsigned k = 0; k < 3; ++k)
+				{
+					for (unsigned l = 0; l < 3; ++l)
+					{
+						S[k][l] += sums.PQ[k][l];
+					}
+				}
+				PP += sums.PP;
+			}
+
+			// Horn's method: the rotation corresponds to the eigenvector (quaternion) associated to the largest eigenvalue of N
+			CCCoreLib::SquareMatrixd N(4);
+			N.setValue(0, 0, S[0][0] + S[1][1] + S[2][2]);
+			N.setValue(0, 1, S[1][2] - S[2][1]);
+			N.setValue(0, 2, S[2][0] - S[0][2]);
+			N.setValue(0, 3, S[0][1] - S[1][0]);
+			N.setValue(1, 1, S[0][0] - S[1][1] - S[2][2]);
+			N.setValue(1, 2, S[0][1] + S[1][0]);
+			N.setValue(1, 3, S[2][0] + S[0][2]);
+			N.setValue(2, 2, -S[0][0] + S[1][1] - S[2][2]);
+			N.setValue(2, 3, S[1][2] + S[2][1]);
+			N.setValue(3, 3, -S[0][0] - S[1][1] + S[2][2]);
+			for (unsigned k = 0; k < 4; ++k)
+			{
+				for (unsigned l = 0; l < k; ++l)
+				{
+					N.setValue(k, l, N.getValue(l, k));
+				}
+			}
+
+			CCCoreLib::SquareMatrixd eigVectors;
+			std::vector<double>      eigValues;
+			if (!CCCoreLib::Jacobi<double>::ComputeEigenValuesAndVectors(N, eigVectors, eigValues, false))
+			{
+				ccLog::Warning("[ICP] Failed to compute the rotation");
+				return CCCoreLib::ICPRegistrationTools::ICP_ERROR_REGISTRATION_STEP;
+			}
+			double q[4];
+			double maxEigValue = 0;
+			CCCoreLib::Jacobi<double>::GetMaxEigenValueAndVector(eigVectors, eigValues, maxEigValue, q);
+
+			double qNorm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			if (!(qNorm > 0))
+			{
+				ccLog::Warning("[ICP] Failed to compute the rotation");
+				return CCCoreLib::ICPRegistrationTools::ICP_ERROR_REGISTRATION_STEP;
+			}
+			const double q0 = q[0] / qNorm;
+			const double qx = q[1] / qNorm;
+			const double qy = q[2] / qNorm;
+			const double qz = q[3] / qNorm;
+
+			increment.R[0][0] = q0 * q0 + qx * qx - qy * qy - qz * qz;
+			increment.R[0][1] = 2 * (qx * qy - q0 * qz);
+			increment.R[0][2] = 2 * (qx * qz + q0 * qy);
+			increment.R[1][0] = 2 * (qy * qx + q0 * qz);
+			increment.R[1][1] = q0 * q0 - qx * qx + qy * qy - qz * qz;
+			increment.R[1][2] = 2 * (qy * qz - q0 * qx);
+			increment.R[2][0] = 2 * (qz * qx - q0 * qy);
+			increment.R[2][1] = 2 * (qz * qy + q0 * qx);
+			increment.R[2][2] = q0 * q0 - qx * qx - qy * qy + qz * qz;
+
+			if (adjustScale && PP > 0)
+			{
+				// s = sum(w.Y.R(X)) / sum(w.|X|^2)
+				double YRX = 0;
+				for (unsigned k = 0; k < 3; ++k)
+				{
+					for (unsigned l = 0; l < 3; ++l)
+					{
+						YRX += increment.R[k][l] * S[l][k];
+					}
+				}
+				if (YRX > 0)
+				{
+					increment.s = YRX / PP;
+				}
+			}
+
+			for (unsigned k = 0; k < 3; ++k)
+			{
+				increment.T[k] = Gq.u[k] - increment.s * (increment.R[k][0] * Gp.x + increment.R[k][1] * Gp.y + increment.R[k][2] * Gp.z);
+			}
+		}
+
+		// apply the transformation filters (if any)
+		if (params.transformationFilters != CCCoreLib::RegistrationTools::SKIP_NONE)
+		{
+			Transformation trans = increment.toTransformation();
+			CCCoreLib::RegistrationTools::FilterTransformation(trans,
+			                                                   params.transformationFilters,
+			                                                   Gp.toPC(),
+			                                                   Gq.toPC(),
+			                                                   trans);
+			increment.fromTransformation(trans);
+		}
+
+		pose = pose.composedWith(increment);
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	transform       = pose.toTransformation();
+	finalRMS        = rms;
+	finalPointCount = pointCount;
+
+	return CCCoreLib::ICPRegistrationTools::ICP_APPLY_TRANSFO;
+}
@@ -0,0 +1,129 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#ifndef CC_ICP_ENGINE_HEADER
+#define CC_ICP_ENGINE_HEADER
+
+// CCCoreLib
+#include <RegistrationTools.h>
+
+// qCC_db
+#include <ccNearestNeighbourIndex.h>
+#include <ccTriangleBVH.h>
+
+// Qt
+#include <QSharedPointer>
+
+namespace CCCoreLib
+{
+	class GenericIndexedCloudPersist;
+	class GenericIndexedMesh;
+	class GenericProgressCallback;
+} // namespace CCCoreLib
+
+class ccGenericPointCloud;
+class ccHObject;
+
+//! Index-based ICP registration
+/** The closest points are looked for with a spatial index of the model entity
+    (the kd-tree of the model cloud, see ccGenericPointCloud::getNearestNeighbourIndex,
+    or a hierarchy of the model mesh triangles, see ccTriangleBVH) that is built only
+    once and reused by all the iterations (and by several registrations against the
+    same model, see PrepareModel).
+    Correspondences are computed in parallel. The partial overlap is handled by
+    trimming the farthest correspondences at each iteration (instead of pre-selecting
+    the data points once).
+**/
+class ccICPEngine
+{
+  public:
+	//! ICP parameters
+	using Parameters = CCCoreLib::ICPRegistrationTools::Parameters;
+	//! Resulting transformation
+	using Transformation = CCCoreLib::PointProjectionTools::Transformation;
+	//! Registration result
+	using RESULT_TYPE = CCCoreLib::ICPRegistrationTools::RESULT_TYPE;
+
+	//! Error metric
+	enum Metric
+	{
+		POINT_TO_POINT, //!< distance between the data points and their closest model points
+		POINT_TO_PLANE  //!< distance between the data points and the tangent planes at their closest model points (requires model normals)
+	};
+
+	//! Model entity with its spatial index
+	struct Model
+	{
+		//! Shared pointer
+		typedef QSharedPointer<Model> Shared;
+
+		//! Model cloud (if the model is a cloud)
+		ccGenericPointCloud* cloud = nullptr;
+		//! Model cloud index
+		ccNearestNeighbourIndex::Shared cloudIndex;
+		//! Model mesh (if the model is a mesh)
+		CCCoreLib::GenericIndexedMesh* mesh = nullptr;
+		//! Model mesh index
+		ccTriangleBVH::Shared meshIndex;
+
+		//! Returns whether normals are available (i.e. whether the point-to-plane metric can be used)
+		bool hasNormals() const;
+	};
+
+	//! Prepares a model entity (i.e. builds its spatial index)
+	/** \param model model entity (cloud or mesh)
+	    \param maxThreadCount max number of threads (0 = all)
+	    \param progressCb optional progress callback
+	    \return the prepared model (or a null pointer if the entity is invalid, if there's not enough memory or if the process was cancelled)
+	**/
+	static Model::Shared PrepareModel(ccHObject*                          model,
+	                                  int                                 maxThreadCount = 0,
+	                                  CCCoreLib::GenericProgressCallback* progressCb     = nullptr);
+
+	//! Returns whether the engine can handle the given parameters
+	/** C2M signed distances and normals matching are not supported
+	    (CCCoreLib::ICPRegistrationTools::Register should be used instead).
+	**/
+	static bool CanRegister(const Parameters& params);
+
+	//! Registers a cloud with a model
+	/** Same parameters as CCCoreLib::ICPRegistrationTools::Register, except that
+	    params.finalOverlapRatio is the ratio of correspondences kept at each iteration
+	    (the farthest ones are discarded). The data weights (if any) must have the same
+	    size as the data cloud, and the model weights (if any) the same size as the model
+	    cloud. The scale can't be adjusted with the point-to-plane metric.
+	    \param model prepared model (see PrepareModel)
+	    \param dataCloud cloud to register
+	    \param params ICP parameters
+	    \param metric error metric
+	    \param[out] transform resulting transformation (to be applied to the data cloud)
+	    \param[out] finalRMS final (potentially weighted) RMS
+	    \param[out] finalPointCount number of points used for the final step
+	    \param progressCb the caller can get some notification of the process progress through this callback mechanism (see CCCoreLib documentation)
+	    \return the registration result (same codes as CCCoreLib)
+	**/
+	static RESULT_TYPE Register(const Model&                           model,
+	                            CCCoreLib::GenericIndexedCloudPersist* dataCloud,
+	                            const Parameters&                      params,
+	                            Metric                                 metric,
+	                            Transformation&                        transform,
+	                            double&                                finalRMS,
+	                            unsigned&                              finalPointCount,
+	                            CCCoreLib::GenericProgressCallback*    progressCb = nullptr);
+};
+
+#endif // CC_ICP_ENGINE_HEADER
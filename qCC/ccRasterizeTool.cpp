@@ -93,9 +93,7 @@ ccRasterizeTool::ccRasterizeTool(ccGenericPointCloud* cloud, QWidget* parent)
 {
 	m_UI->setupUi(this);
 
-#ifdef CC_GDAL_SUPPORT
-	m_UI->ignoreContourBordersCheckBox->setVisible(false);
-#else
+#ifndef CC_GDAL_SUPPORT
 	m_UI->generateRasterPushButton->setDisabled(true);
 	m_UI->generateRasterPushButton->setChecked(false);
 #endif
@@ -527,6 +525,7 @@ void ccRasterizeTool::loadSettings()
 	bool   resampleCloud                 = settings.value("ResampleOrigCloud", m_UI->resampleCloudCheckBox->isChecked()).toBool();
 	int    minVertexCount                = settings.value("MinVertexCount", m_UI->minVertexCountSpinBox->value()).toInt();
 	bool   ignoreBorders                 = settings.value("IgnoreBorders", m_UI->ignoreContourBordersCheckBox->isChecked()).toBool();
+	bool   simplifyContours              = settings.value("SimplifyContours", m_UI->simplifyContoursCheckBox->isChecked()).toBool();
 	bool   projectContoursOnAlt          = settings.value("projectContoursOnAlt", m_UI->projectContoursOnAltCheckBox->isChecked()).toBool();
 
 	// Statistics checkboxes
@@ -555,6 +554,7 @@ void ccRasterizeTool::loadSettings()
 	m_UI->resampleCloudCheckBox->setChecked(resampleCloud);
 	m_UI->minVertexCountSpinBox->setValue(minVertexCount);
 	m_UI->ignoreContourBordersCheckBox->setChecked(ignoreBorders);
+	m_UI->simplifyContoursCheckBox->setChecked(simplifyContours);
 	m_UI->projectContoursOnAltCheckBox->setChecked(projectContoursOnAlt);
 
 	// SF Statistics checkboxes
@@ -621,6 +621,7 @@ void ccRasterizeTool::saveSettings()
 	settings.setValue("ResampleOrigCloud", m_UI->resampleCloudCheckBox->isChecked());
 	settings.setValue("MinVertexCount", m_UI->minVertexCountSpinBox->value());
 	settings.setValue("IgnoreBorders", m_UI->ignoreContourBordersCheckBox->isChecked());
+	settings.setValue("SimplifyContours", m_UI->simplifyContoursCheckBox->isChecked());
 	settings.setValue("projectContoursOnAlt", m_UI->projectContoursOnAltCheckBox->isChecked());
 
 	// SF Statistics checkboxes
@@ -1890,9 +1891,9 @@ void ccRasterizeTool::generateContours()
 		params.minVertexCount = m_UI->minVertexCountSpinBox->value();
 		assert(params.minVertexCount >= 3);
 
-		// the parameters below are only required if GDAL is not supported (but we can set them anyway)
-		params.ignoreBorders = m_UI->ignoreContourBordersCheckBox->isChecked();
-		params.parentWidget  = this;
+		params.ignoreBorders           = m_UI->ignoreContourBordersCheckBox->isChecked();
+		params.simplificationTolerance = m_UI->simplifyContoursCheckBox->isChecked() ? 0.25 : 0.0; // 1/4 of the grid step
+		params.parentWidget            = this;
 	}
 
 	removeContourLines();
@@ -56,6 +56,7 @@ static bool     s_useModelSFAsWeights         = false;
 static bool     s_useC2MSignedDistances       = false;
 static bool     s_robustC2MSignedDistances    = true;
 static int      s_normalsMatchingOption       = CCCoreLib::ICPRegistrationTools::NO_NORMAL;
+static bool     s_pointToPlane                = false;
 
 ccRegistrationDlg::ccRegistrationDlg(ccHObject* data, ccHObject* model, QWidget* parent /*=nullptr*/)
     : QDialog(parent, Qt::Tool)
@@ -104,6 +105,7 @@ ccRegistrationDlg::ccRegistrationDlg(ccHObject* data, ccHObject* model, QWidget*
 		useC2MSignedDistancesCheckBox->setChecked(s_useC2MSignedDistances);
 		robustC2MDistsCheckBox->setChecked(s_robustC2MSignedDistances);
 		normalsComboBox->setCurrentIndex(s_normalsMatchingOption);
+		pointToPlaneCheckBox->setChecked(s_pointToPlane);
 	}
 
 	connect(swapButton, &QAbstractButton::clicked, this, &ccRegistrationDlg::swapModelAndData);
@@ -144,6 +146,7 @@ void ccRegistrationDlg::saveParameters() const
 	s_useC2MSignedDistances       = useC2MSignedDistancesCheckBox->isChecked();
 	s_robustC2MSignedDistances    = robustC2MDistsCheckBox->isChecked();
 	s_normalsMatchingOption       = normalsComboBox->currentIndex();
+	s_pointToPlane                = pointToPlaneCheckBox->isChecked();
 }
 
 ccHObject* ccRegistrationDlg::getDataEntity()
@@ -185,6 +188,11 @@ CCCoreLib::ICPRegistrationTools::NORMALS_MATCHING ccRegistrationDlg::normalsMatc
 	}
 }
 
+bool ccRegistrationDlg::usePointToPlaneMetric() const
+{
+	return pointToPlaneCheckBox->isEnabled() && pointToPlaneCheckBox->isChecked();
+}
+
 bool ccRegistrationDlg::adjustScale() const
 {
 	return adjustScaleCheckBox->isChecked();
@@ -308,6 +316,7 @@ void ccRegistrationDlg::updateGUI()
 	useC2MSignedDistancesCheckBox->setEnabled(hasRefMesh); // only supported if a mesh is the reference cloud
 	robustC2MDistsCheckBox->setEnabled(hasRefMesh);
 	normalsComboBox->setEnabled(dataEntity->hasNormals() && modelEntity->hasNormals()); // only supported if both the to-be-aligned and the reference entities have normals
+	pointToPlaneCheckBox->setEnabled(hasRefMesh || modelEntity->hasNormals());           // only supported if the reference entity has normals (or is a mesh)
 
 	MainWindow::RefreshAllGLWindow(false);
 }
@@ -93,6 +93,9 @@ class ccRegistrationDlg : public QDialog
 	//! Method to take normals into account
 	CCCoreLib::ICPRegistrationTools::NORMALS_MATCHING normalsMatchingOption() const;
 
+	//! Whether to use the point-to-plane metric (see ccICPEngine)
+	bool usePointToPlaneMetric() const;
+
 	//! Returns whether to adjust the scale during optimization
 	/** This is useful for co-registration of lidar and photogrammetric clouds
 	for instance.
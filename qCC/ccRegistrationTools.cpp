@@ -55,7 +55,9 @@ bool ccRegistrationTools::ICP(ccHObject*
                               const CCCoreLib::ICPRegistrationTools::Parameters& inputParameters,
                               bool                                               useDataSFAsWeights /*=false*/,
                               bool                                               useModelSFAsWeights /*=false*/,
-                              QWidget*                                           parent /*=nullptr*/)
+                              QWidget*                                           parent /*=nullptr*/,
+                              ccICPEngine::Metric                                metric /*=ccICPEngine::POINT_TO_POINT*/,
+                              ccICPEngine::Model::Shared                         preparedModel /*={}*/)
 {
 	QElapsedTimer timer;
 	timer.start();
@@ -103,6 +105,26 @@ bool ccRegistrationTools::ICP(ccHObject*
 		dataCloud = ccHObjectCaster::ToGenericPointCloud(data);
 	}
 
+	// the ICP engine uses a persistent index of the model, and it trims the correspondences at each
+	// iteration (no need for a temporary scalar field nor for a pre-selection of the overlapping points)
+	const bool useEngine = ccICPEngine::CanRegister(params);
+	if (useEngine)
+	{
+		if (!preparedModel)
+		{
+			preparedModel = ccICPEngine::PrepareModel(model, params.maxThreadCount, progressDlg.data());
+			if (!preparedModel)
+			{
+				ccLog::Error("[ICP] Failed to build the model index (not enough memory?)");
+				return false;
+			}
+		}
+	}
+	else if (metric == ccICPEngine::POINT_TO_PLANE)
+	{
+		ccLog::Warning("[ICP] The point-to-plane metric is not supported with C2M signed distances or normals matching (point-to-point metric will be used instead)");
+	}
+
 	// we activate a temporary scalar field for registration distances computation
 	CCCoreLib::ScalarField* dataDisplayedSF = nullptr;
 	int                     oldDataSfIdx    = -1;
@@ -115,19 +137,22 @@ bool ccRegistrationTools::ICP(ccHObject*
 		restoreColorState = pc->colorsShown();
 		restoreSFState    = pc->sfShown();
 		dataDisplayedSF   = pc->getCurrentDisplayedScalarField();
-		oldDataSfIdx      = pc->getCurrentInScalarFieldIndex();
-		dataSfIdx         = pc->getScalarFieldIndexByName(REGISTRATION_DISTS_SF);
-		if (dataSfIdx < 0)
-			dataSfIdx = pc->addScalarField(REGISTRATION_DISTS_SF);
-		if (dataSfIdx >= 0)
-			pc->setCurrentScalarField(dataSfIdx);
-		else
+		if (!useEngine)
 		{
-			ccLog::Error("[ICP] Couldn't create temporary scalar field! Not enough memory?");
-			return false;
+			oldDataSfIdx = pc->getCurrentInScalarFieldIndex();
+			dataSfIdx    = pc->getScalarFieldIndexByName(REGISTRATION_DISTS_SF);
+			if (dataSfIdx < 0)
+				dataSfIdx = pc->addScalarField(REGISTRATION_DISTS_SF);
+			if (dataSfIdx >= 0)
+				pc->setCurrentScalarField(dataSfIdx);
+			else
+			{
+				ccLog::Error("[ICP] Couldn't create temporary scalar field! Not enough memory?");
+				return false;
+			}
 		}
 	}
-	else
+	else if (!useEngine)
 	{
 		if (!dataCloud->enableScalarField())
 		{
@@ -142,7 +167,7 @@ bool ccRegistrationTools::ICP(ccHObject*
 	// do we need to reduce the input point cloud (so as to be close
 	// to the theoretical number of overlapping points - but not too
 	// low so as we are not registered yet ;)
-	if (params.finalOverlapRatio < 1.0 - s_overlapMarginRatio)
+	if (!useEngine && params.finalOverlapRatio < 1.0 - s_overlapMarginRatio)
 	{
 		// DGM we can now use 'approximate' distances as SAITO algorithm is exact (but with a coarse resolution)
 		// level = 7 if < 1.000.000
@@ -278,14 +303,28 @@ bool ccRegistrationTools::ICP(ccHObject*
 	CCCoreLib::ICPRegistrationTools::RESULT_TYPE    result;
 	CCCoreLib::PointProjectionTools::Transformation transform;
 
-	result = CCCoreLib::ICPRegistrationTools::Register(modelCloud,
-	                                                   modelMesh,
-	                                                   dataCloud,
-	                                                   params,
-	                                                   transform,
-	                                                   finalRMS,
-	                                                   finalPointCount,
-	                                                   static_cast<CCCoreLib::GenericProgressCallback*>(progressDlg.data()));
+	if (useEngine)
+	{
+		result = ccICPEngine::Register(*preparedModel,
+		                               dataCloud,
+		                               params,
+		                               metric,
+		                               transform,
+		                               finalRMS,
+		                               finalPointCount,
+		                               static_cast<CCCoreLib::GenericProgressCallback*>(progressDlg.data()));
+	}
+	else
+	{
+		result = CCCoreLib::ICPRegistrationTools::Register(modelCloud,
+		                                                   modelMesh,
+		                                                   dataCloud,
+		                                                   params,
+		                                                   transform,
+		                                                   finalRMS,
+		                                                   finalPointCount,
+		                                                   static_cast<CCCoreLib::GenericProgressCallback*>(progressDlg.data()));
+	}
 
 	if (result >= CCCoreLib::ICPRegistrationTools::ICP_ERROR)
 	{
@@ -24,6 +24,9 @@
 // qCC_db
 #include <ccGLMatrix.h>
 
+// Local
+#include "ccICPEngine.h"
+
 class QWidget;
 class QStringList;
 class ccHObject;
@@ -35,6 +38,11 @@ class ccRegistrationTools
   public:
 	//! Applies ICP registration on two entities
 	/** \warning Automatically samples points on meshes if necessary (see code for magic numbers ;)
+	    Unless C2M signed distances or normals matching are requested, the registration is
+	    performed by ccICPEngine (in which case a prepared model can be provided so as to
+	    register several entities against the same model without rebuilding its index).
+	    \param metric error metric (the point-to-plane metric is only supported by ccICPEngine)
+	    \param preparedModel optional prepared model (see ccICPEngine::PrepareModel - must correspond to 'model')
 	 **/
 	static bool ICP(ccHObject*                                         data,
 	                ccHObject*                                         model,
@@ -45,7 +53,9 @@ class ccRegistrationTools
 	                const CCCoreLib::ICPRegistrationTools::Parameters& inputParameters,
 	                bool                                               useDataSFAsWeights  = false,
 	                bool                                               useModelSFAsWeights = false,
-	                QWidget*                                           parent              = nullptr);
+	                QWidget*                                           parent              = nullptr,
+	                ccICPEngine::Metric                                metric              = ccICPEngine::POINT_TO_POINT,
+	                ccICPEngine::Model::Shared                         preparedModel       = {});
 };
 
 #endif // CC_REGISTRATION_TOOLS_HEADER
@@ -22,6 +22,7 @@
 #include "ccItemSelectionDlg.h"
 #include "ccOrthoSectionGenerationDlg.h"
 #include "ccSectionExtractionSubDlg.h"
+#include "ccSectionExtractor.h"
 #include "mainwindow.h"
 
 // qCC_db
@@ -35,14 +36,11 @@
 // qCC_gl
 #include <ccGLWindowInterface.h>
 
-// CCCoreLib
-#include <ReferenceCloud.h>
-
 // Qt
-#include <QCoreApplication>
 #include <QInputDialog>
 #include <QMdiSubWindow>
 #include <QMessageBox>
+#include <QScopedPointer>
 
 // GUI
 #include <ui_sectionExtractionDlg.h>
@@ -1276,259 +1274,6 @@ void ccSectionExtractionTool::exportSections()
 	// m_associatedWin->redraw();
 }
 
-bool ccSectionExtractionTool::extractSectionEnvelope(const ccPolyline*                 originalSection,
-                                                     const ccPointCloud*               originalSectionCloud,
-                                                     ccPointCloud*                     unrolledSectionCloud,
-                                                     unsigned                          sectionIndex,
-                                                     ccEnvelopeExtractor::EnvelopeType envelopeType,
-                                                     PointCoordinateType               maxEdgeLength,
-                                                     bool                              multiPass,
-                                                     bool                              splitEnvelope,
-                                                     bool&                             envelopeGenerated,
-                                                     bool                              visualDebugMode /*=false*/)
-{
-	envelopeGenerated = false;
-
-	if (!originalSectionCloud || !unrolledSectionCloud)
-	{
-		ccLog::Warning("[ccSectionExtractionTool][extract envelope] Internal error: invalid input parameter(s)");
-		return false;
-	}
-
-	if (originalSectionCloud->size() < 2)
-	{
-		// nothing to do
-		ccLog::Warning(QString("[ccSectionExtractionTool][extract envelope] Section #%1 contains less than 2 points and will be ignored").arg(sectionIndex));
-		return true;
-	}
-
-	// by default, the points in 'unrolledSectionCloud' are 2D (X = curvilinear coordinate, Y = height, Z = 0)
-	CCVector3 N(0, 0, 1);
-	CCVector3 Y(0, 1, 0);
-
-	std::vector<unsigned> vertIndexes;
-	ccPolyline*           envelope = ccEnvelopeExtractor::ExtractFlatEnvelope(unrolledSectionCloud,
-                                                                    multiPass,
-                                                                    maxEdgeLength,
-                                                                    N.u,
-                                                                    Y.u,
-                                                                    envelopeType,
-                                                                    &vertIndexes,
-                                                                    visualDebugMode);
-
-	if (envelope)
-	{
-		// update vertices (to replace 'unrolled' points by 'original' ones
-		{
-			CCCoreLib::GenericIndexedCloud* vertices = envelope->getAssociatedCloud();
-			if (vertIndexes.size() == static_cast<size_t>(vertices->size()))
-			{
-				for (unsigned i = 0; i < vertices->size(); ++i)
-				{
-					const CCVector3* P = vertices->getPoint(i);
-					assert(vertIndexes[i] < originalSectionCloud->size());
-					*const_cast<CCVector3*>(P) = *originalSectionCloud->getPoint(vertIndexes[i]);
-				}
-
-				ccPointCloud* verticesAsPC = dynamic_cast<ccPointCloud*>(vertices);
-				if (verticesAsPC)
-					verticesAsPC->refreshBB();
-			}
-			else
-			{
-				ccLog::Warning("[ccSectionExtractionTool][extract envelope] Internal error (couldn't fetch original points indexes?!)");
-				delete envelope;
-				return false;
-			}
-		}
-
-		std::vector<ccPolyline*> parts;
-		if (splitEnvelope)
-		{
-#ifdef QT_DEBUG
-			// compute some stats on the envelope
-			{
-				double   minLength = 0;
-				double   maxLength = 0;
-				double   sumLength = 0;
-				unsigned count     = envelope->size();
-				if (!envelope->isClosed())
-					--count;
-				for (unsigned i = 0; i < count; ++i)
-				{
-					const CCVector3* A = envelope->getPoint(i);
-					const CCVector3* B = envelope->getPoint((i + 1) % envelope->size());
-					CCVector3        e = *B - *A;
-					double           l = e.norm();
-					if (i != 0)
-					{
-						minLength = std::min(minLength, l);
-						maxLength = std::max(maxLength, l);
-						sumLength += l;
-					}
-					else
-					{
-						minLength = maxLength = sumLength = l;
-					}
-				}
-				ccLog::PrintDebug(QString("Envelope: min = %1 / avg = %2 / max = %3").arg(minLength).arg(sumLength / count).arg(maxLength));
-			}
-#endif
-
-			/*bool success = */ envelope->split(maxEdgeLength, parts);
-			delete envelope;
-			envelope = nullptr;
-		}
-		else
-		{
-			parts.push_back(envelope);
-		}
-
-		// create output group if necessary
-		ccHObject* destEntity = getExportGroup(s_profileExportGroupID, "Extracted profiles");
-		if (!destEntity)
-		{
-			assert(false);
-			return false;
-		}
-
-		for (size_t p = 0; p < parts.size(); ++p)
-		{
-			ccPolyline* envelopePart = parts[p];
-			QString     name         = QString("Section envelope #%1").arg(sectionIndex);
-			if (parts.size() > 1)
-			{
-				name += QString("(part %1/%2)").arg(p + 1).arg(parts.size());
-			}
-			envelopePart->setName(name);
-			envelopePart->copyGlobalShiftAndScale(*originalSectionCloud);
-			envelopePart->setColor(s_defaultEnvelopeColor);
-			envelopePart->showColors(true);
-			// copy meta-data (import for Mascaret export!)
-			{
-				const QVariantMap& metaData = originalSection->metaData();
-				for (QVariantMap::const_iterator it = metaData.begin(); it != metaData.end(); ++it)
-				{
-					envelopePart->setMetaData(it.key(), it.value());
-				}
-			}
-
-			// add to main DB
-			destEntity->addChild(envelopePart);
-			envelopePart->setDisplay_recursive(destEntity->getDisplay());
-			MainWindow::TheInstance()->addToDB(envelopePart, false, false);
-		}
-
-		envelopeGenerated = true;
-	}
-
-	return true;
-}
-
-bool ccSectionExtractionTool::extractSectionCloud(const std::vector<CCCoreLib::ReferenceCloud*>& refClouds,
-                                                  unsigned                                       sectionIndex,
-                                                  bool&                                          cloudGenerated)
-{
-	cloudGenerated = false;
-
-	ccPointCloud* sectionCloud = nullptr;
-	for (int i = 0; i < static_cast<int>(refClouds.size()); ++i)
-	{
-		if (!refClouds[i])
-			continue;
-		assert(m_clouds[i].entity); // a valid ref. cloud must have a valid counterpart!
-
-		// extract part/section from each cloud
-		ccPointCloud* part = nullptr;
-
-		// if the cloud is a ccPointCloud, we can keep a lot more information
-		// when extracting the section cloud
-		ccPointCloud* pc = dynamic_cast<ccPointCloud*>(m_clouds[i].entity);
-		if (pc)
-		{
-			part = pc->partialClone(refClouds[i]);
-		}
-		else
-		{
-			part = ccPointCloud::From(refClouds[i], m_clouds[i].entity);
-		}
-
-		if (part)
-		{
-			if (i == 0)
-			{
-				// we simply use this 'part' cloud as the section cloud
-				sectionCloud = part;
-			}
-			else
-			{
-				assert(sectionCloud);
-
-				// fuse it with the global cloud
-				unsigned cloudSizeBefore = sectionCloud->size();
-				unsigned partSize        = part->size();
-				sectionCloud->append(part, cloudSizeBefore, true);
-
-				// don't need it anymore
-				delete part;
-				part = nullptr;
-				// check that it actually worked!
-				if (sectionCloud->size() != cloudSizeBefore + partSize)
-				{
-					// not enough memory
-					ccLog::Warning("[ccSectionExtractionTool][extract cloud] Not enough memory");
-					delete sectionCloud;
-					return false;
-				}
-			}
-		}
-		else
-		{
-			// not enough memory
-			ccLog::Warning("[ccSectionExtractionTool][extract cloud] Not enough memory");
-			delete sectionCloud;
-			return false;
-		}
-	}
-
-	if (sectionCloud)
-	{
-		// create output group if necessary
-		ccHObject* destEntity = getExportGroup(s_cloudExportGroupID, "Extracted section clouds");
-		if (!destEntity)
-		{
-			assert(false);
-			return false;
-		}
-
-		sectionCloud->setName(QString("Section cloud #%1").arg(sectionIndex));
-		sectionCloud->setDisplay(destEntity->getDisplay());
-
-		// add to main DB
-		destEntity->addChild(sectionCloud);
-		MainWindow::TheInstance()->addToDB(sectionCloud, false, false);
-
-		cloudGenerated = true;
-	}
-
-	return true;
-}
-
-struct Segment
-{
-	Segment()
-	    : A(0, 0)
-	    , B(0, 0)
-	    , u(0, 0)
-	    , d(0)
-	    , curvPos(0)
-	{
-	}
-
-	CCVector2           A, B, u;
-	PointCoordinateType d, curvPos;
-};
-
 void ccSectionExtractionTool::unfoldPoints()
 {
 	if (!m_selectedPoly)
@@ -1545,45 +1290,24 @@ void ccSectionExtractionTool::unfoldPoints()
 	}
 
 	// compute loaded clouds bounding-box
-	ccBBox   box;
-	unsigned totalPointCount = 0;
+	ccBBox                            box;
+	std::vector<ccGenericPointCloud*> clouds;
+	std::vector<ccHObject*>           displays;
+	std::vector<ccPolyline*>          polylines;
+	try
 	{
 		for (auto& cloud : m_clouds)
 		{
 			if (cloud.entity)
 			{
 				box += cloud.entity->getOwnBB();
-				totalPointCount += cloud.entity->size();
+				clouds.push_back(cloud.entity);
+				displays.push_back(cloud.originalDisplay);
 			}
 		}
-	}
-
-	static double s_defaultThickness = -1.0;
-	if (s_defaultThickness <= 0)
-	{
-		s_defaultThickness = box.getMaxBoxDim() / 10.0;
-	}
 
-	bool   ok;
-	double thickness = QInputDialog::getDouble(MainWindow::TheInstance(), "Thickness", "Distance to polyline:", s_defaultThickness, 1.0e-6, 1.0e6, 6, &ok);
-	if (!ok)
-		return;
-	s_defaultThickness = thickness;
-
-	// projection direction
-	int vertDim = m_UI->vertAxisComboBox->currentIndex();
-	int xDim    = (vertDim < 2 ? vertDim + 1 : 0);
-	int yDim    = (xDim < 2 ? xDim + 1 : 0);
-
-	// we consider half of the total thickness as points can be on both sides!
-	double maxSquareDistToPolyline = (thickness / 2) * (thickness / 2);
-
-	std::vector<ccPolyline*> polylines;
-	try
-	{
 		if (m_selectedPoly)
 		{
-			polylines.reserve(1);
 			polylines.push_back(m_selectedPoly->entity);
 		}
 		else
@@ -1601,257 +1325,66 @@ void ccSectionExtractionTool::unfoldPoints()
 		return;
 	}
 
-	ccProgressDialog              pdlg(true);
-	CCCoreLib::NormalizedProgress nprogress(&pdlg, polylines.size() > 1 ? static_cast<unsigned>(polylines.size()) : totalPointCount);
-	pdlg.setMethodTitle(tr("Unfold cloud(s)"));
-	if (polylines.size() > 1)
+	static double s_defaultThickness = -1.0;
+	if (s_defaultThickness <= 0)
 	{
-		pdlg.setInfo(tr("Number of polylines: %1\nNumber of points: %2").arg(polylines.size()).arg(totalPointCount));
+		s_defaultThickness = box.getMaxBoxDim() / 10.0;
 	}
-	pdlg.start();
-	QCoreApplication::processEvents();
 
-	unsigned exportedClouds = 0;
-
-	for (ccPolyline* poly : polylines)
-	{
-		unsigned polyVertCount = poly->size();
-		if (polyVertCount < 2)
-		{
-			assert(false);
-			ccLog::Warning("Invalid polyline (less than 2 vertices)");
-			continue;
-		}
-
-		// prepare the computation of 2D distances
-		std::vector<Segment> segments;
-		unsigned             polySegmentCount = poly->isClosed() ? polyVertCount : polyVertCount - 1;
-		{
-			try
-			{
-				segments.reserve(polySegmentCount);
-			}
-			catch (const std::bad_alloc&)
-			{
-				// not enough memory
-				ccLog::Error("Not enough memory");
-				return;
-			}
-
-			PointCoordinateType curvPos = 0;
-			for (unsigned j = 0; j < polySegmentCount; ++j)
-			{
-				// current polyline segment
-				const CCVector3* A = poly->getPoint(j);
-				const CCVector3* B = poly->getPoint((j + 1) % polyVertCount);
-
-				Segment s;
-				{
-					s.A = CCVector2(A->u[xDim], A->u[yDim]);
-					s.B = CCVector2(B->u[xDim], B->u[yDim]);
-					s.u = s.B - s.A;
-					s.d = s.u.norm();
-					if (CCCoreLib::GreaterThanEpsilon(s.d))
-					{
-						s.curvPos = curvPos;
-						s.u /= s.d;
-						segments.push_back(s);
-					}
-				}
+	bool   ok;
+	double thickness = QInputDialog::getDouble(MainWindow::TheInstance(), "Thickness", "Distance to polyline:", s_defaultThickness, 1.0e-6, 1.0e6, 6, &ok);
+	if (!ok)
+		return;
+	s_defaultThickness = thickness;
 
-				// update curvilinear pos
-				curvPos += (*B - *A).norm();
-			}
-		}
+	// projection direction
+	int vertDim = m_UI->vertAxisComboBox->currentIndex();
 
-		if (polylines.size() == 1)
-		{
-			pdlg.setInfo(tr("Number of segments: %1\nNumber of points: %2").arg(polySegmentCount).arg(totalPointCount));
-		}
-		QCoreApplication::processEvents();
+	// unfold all the clouds along all the polylines at once
+	ccProgressDialog           pdlg(true);
+	std::vector<ccPointCloud*> unfoldedClouds;
+	if (!ccSectionExtractor::UnfoldClouds(clouds,
+	                                      polylines,
+	                                      static_cast<PointCoordinateType>(thickness),
+	                                      static_cast<unsigned char>(vertDim),
+	                                      box.minCorner(), // we start at the bounding-box limit
+	                                      unfoldedClouds,
+	                                      0,
+	                                      &pdlg))
+	{
+		ccLog::Error("An error occurred (see console)");
+		return;
+	}
 
-		// for each cloud
-		for (auto& pc : m_clouds)
+	unsigned exportedClouds = 0;
+	for (size_t p = 0; p < polylines.size(); ++p)
+	{
+		for (size_t c = 0; c < clouds.size(); ++c)
 		{
-			ccGenericPointCloud* cloud = pc.entity;
-			if (!cloud)
-			{
-				assert(false);
-				continue;
-			}
-
-			CCCoreLib::ReferenceCloud unfoldedIndexes(cloud);
-			if (!unfoldedIndexes.reserve(cloud->size()))
-			{
-				ccLog::Error("Not enough memory");
-				return;
-			}
-			std::vector<CCVector3> unfoldedPoints;
-			try
-			{
-				unfoldedPoints.reserve(cloud->size());
-			}
-			catch (const std::bad_alloc&)
-			{
-				ccLog::Error("Not enough memory");
-				return;
-			}
-
-			// now test each point and see if it's close to the current polyline (in 2D)
-			for (unsigned i = 0; i < cloud->size(); ++i)
-			{
-				const CCVector3* P = cloud->getPoint(i);
-				CCVector2        P2D(P->u[xDim], P->u[yDim]);
-
-				// test each segment
-				int                 closestSegment = -1;
-				PointCoordinateType minSquareDist  = -CCCoreLib::PC_ONE;
-				for (unsigned j = 0; j < polySegmentCount; ++j)
-				{
-					const Segment& s    = segments[j];
-					CCVector2      AP2D = P2D - s.A;
-
-					// longitudinal 'distance'
-					PointCoordinateType dotprod = s.u.dot(AP2D);
-
-					PointCoordinateType squareDist = 0;
-					if (dotprod < 0.0f)
-					{
-						// dist to nearest vertex
-						squareDist = AP2D.norm2();
-					}
-					else if (dotprod > s.d)
-					{
-						// dist to nearest vertex
-						squareDist = (P2D - s.B).norm2();
-					}
-					else
-					{
-						// orthogonal distance
-						squareDist = (AP2D - s.u * dotprod).norm2();
-					}
-
-					if (squareDist <= maxSquareDistToPolyline)
-					{
-						if (closestSegment < 0 || squareDist < minSquareDist)
-						{
-							minSquareDist  = squareDist;
-							closestSegment = static_cast<int>(j);
-						}
-					}
-				}
-
-				if (closestSegment >= 0)
-				{
-					const Segment& s = segments[closestSegment];
-
-					// we use the curvilinear position of the point in the X dimension (and Y is 0)
-					CCVector3 Q;
-					{
-						CCVector2           AP2D    = P2D - s.A;
-						PointCoordinateType dotprod = s.u.dot(AP2D);
-						PointCoordinateType d       = (AP2D - s.u * dotprod).norm();
-
-						// compute the sign of 'minDist'
-						PointCoordinateType crossprod = AP2D.y * s.u.x - AP2D.x * s.u.y;
-
-						Q.u[xDim]    = s.curvPos + dotprod;
-						Q.u[yDim]    = crossprod < 0 ? -d : d; // signed orthogonal distance to the polyline
-						Q.u[vertDim] = P->u[vertDim];
-					}
-
-					unfoldedIndexes.addPointIndex(i);
-					unfoldedPoints.push_back(Q);
-				}
-
-				if (polylines.size() == 1)
-				{
-					if (!nprogress.oneStep())
-					{
-						ccLog::Warning("[Unfold] Process cancelled by the user");
-						return;
-					}
-				}
-				else // multiple polylines: we don't display the progress, but we still check if the cancel button has been pressed
-				{
-					if (pdlg.isCancelRequested())
-					{
-						ccLog::Warning("[Unfold] Process cancelled by the user");
-						return;
-					}
-				}
-
-			} // for each point
-
-			if (unfoldedIndexes.size() != 0)
+			ccGenericPointCloud* cloud         = clouds[c];
+			ccPointCloud*        unfoldedCloud = unfoldedClouds[p * clouds.size() + c];
+			if (unfoldedCloud)
 			{
 				// assign the default global shift & scale info
-				ccPointCloud* unfoldedCloud = nullptr;
-				{
-					if (cloud->isA(CC_TYPES::POINT_CLOUD))
-						unfoldedCloud = static_cast<ccPointCloud*>(cloud)->partialClone(&unfoldedIndexes);
-					else
-						unfoldedCloud = ccPointCloud::From(&unfoldedIndexes, cloud);
-				}
-				if (!unfoldedCloud)
-				{
-					ccLog::Error("Not enough memory");
-					return;
-				}
-
-				assert(unfoldedCloud->size() == unfoldedPoints.size());
-				CCVector3 C  = box.minCorner();
-				C.u[vertDim] = 0;
-				C.u[xDim]    = box.minCorner().u[xDim]; // we start at the bounding-box limit
-				for (unsigned i = 0; i < unfoldedCloud->size(); ++i)
-				{
-					// update the points positions
-					*const_cast<CCVector3*>(unfoldedCloud->getPoint(i)) = unfoldedPoints[i] + C;
-				}
-				unfoldedCloud->invalidateBoundingBox();
-
 				unfoldedCloud->setName(cloud->getName() + ".unfolded");
 				unfoldedCloud->copyGlobalShiftAndScale(*cloud);
 
 				unfoldedCloud->shrinkToFit();
-				unfoldedCloud->setDisplay(pc.originalDisplay);
+				unfoldedCloud->setDisplay(displays[c]);
 				MainWindow::TheInstance()->addToDB(unfoldedCloud);
 
 				++exportedClouds;
 			}
-			else
+			else if (polylines[p] && polylines[p]->size() > 1)
 			{
 				ccLog::Warning(QString("[Unfold] No point of the cloud '%1' were unfolded (check parameters)").arg(cloud->getName()));
 			}
-
-		} // for each cloud
-
-		if (polylines.size() != 1) // multiple polylines only
-		{
-			if (!nprogress.oneStep())
-			{
-				ccLog::Warning("[Unfold] Process cancelled by the user");
-				return;
-			}
 		}
 	}
 
 	ccLog::Print(QString("[Unfold] %1 cloud(s) exported").arg(exportedClouds));
 }
 
-struct Segment2D
-{
-	Segment2D()
-	    : lAB(0)
-	    , s(0)
-	{
-	}
-
-	CCVector2           A, B, uAB;
-	PointCoordinateType lAB;
-	PointCoordinateType s; // curvilinear coordinate
-};
-
 void ccSectionExtractionTool::extractPoints()
 {
 	static double                            s_defaultSectionThickness    = -1.0;
@@ -1878,17 +1411,31 @@ void ccSectionExtractionTool::extractPoints()
 	}
 
 	// compute loaded clouds bounding-box
-	ccBBox   box;
-	unsigned pointCount = 0;
-
-	for (auto& cloud : m_clouds)
+	ccBBox                            box;
+	std::vector<ccGenericPointCloud*> clouds;
+	std::vector<ccPolyline*>          polylines;
+	try
 	{
-		if (cloud.entity)
+		for (auto& cloud : m_clouds)
 		{
-			box += cloud.entity->getOwnBB();
-			pointCount += cloud.entity->size();
+			if (cloud.entity)
+			{
+				box += cloud.entity->getOwnBB();
+				clouds.push_back(cloud.entity);
+			}
+		}
+
+		polylines.reserve(m_sections.size());
+		for (const auto& section : m_sections)
+		{
+			polylines.push_back(section.entity);
 		}
 	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("Not enough memory");
+		return;
+	}
 
 	if (s_defaultSectionThickness <= 0)
 	{
@@ -1919,319 +1466,90 @@ void ccSectionExtractionTool::extractPoints()
 	s_extractSectionsType        = sesDlg.getEnvelopeType();
 	s_multiPass                  = sesDlg.useMultiPass();
 	s_splitEnvelope              = sesDlg.splitEnvelopes();
-	bool visualDebugMode         = sesDlg.visualDebugMode();
 
-	// progress dialog
-	ccProgressDialog              pdlg(true);
-	CCCoreLib::NormalizedProgress nprogress(&pdlg, static_cast<unsigned>(sectionCount));
-	if (!visualDebugMode)
+	ccSectionExtractor::Parameters params;
+	params.vertDim          = static_cast<unsigned char>(m_UI->vertAxisComboBox->currentIndex());
+	params.thickness        = static_cast<PointCoordinateType>(s_defaultSectionThickness);
+	params.extractClouds    = s_extractSectionsAsClouds;
+	params.extractEnvelopes = s_extractSectionsAsEnvelopes;
+	params.envelopeType     = s_extractSectionsType;
+	params.maxEdgeLength    = static_cast<PointCoordinateType>(s_envelopeMaxEdgeLength);
+	params.multiPass        = s_multiPass;
+	params.splitEnvelopes   = s_splitEnvelope;
+	params.visualDebugMode  = sesDlg.visualDebugMode();
+
+	// extract all the sections at once (no progress dialog in visual debug mode)
+	QScopedPointer<ccProgressDialog>         pdlg(params.visualDebugMode ? nullptr : new ccProgressDialog(true));
+	std::vector<ccSectionExtractor::Section> sections;
+	if (!ccSectionExtractor::ExtractSections(clouds, polylines, params, sections, pdlg.data()))
 	{
-		pdlg.setMethodTitle(tr("Extract sections"));
-		pdlg.setInfo(tr("Number of sections: %1\nNumber of points: %2").arg(sectionCount).arg(pointCount));
-		pdlg.start();
-		QCoreApplication::processEvents();
+		ccLog::Error("An error occurred (see console)");
+		return;
 	}
 
-	int vertDim = m_UI->vertAxisComboBox->currentIndex();
-	int xDim    = (vertDim < 2 ? vertDim + 1 : 0);
-	int yDim    = (xDim < 2 ? xDim + 1 : 0);
-
-	// we consider half of the total thickness as points can be on both sides!
-	double sectionThicknessSq = std::pow(s_defaultSectionThickness / 2.0, 2.0);
-	bool   error              = false;
-
+	// add the results to the main DB
 	unsigned generatedEnvelopes = 0;
 	unsigned generatedClouds    = 0;
-
-	try
+	for (size_t s = 0; s < sections.size(); ++s)
 	{
-		// for each slice
-		for (int s = 0; s < m_sections.size(); ++s)
+		ccSectionExtractor::Section& section      = sections[s];
+		const unsigned               sectionIndex = static_cast<unsigned>(s + 1);
+
+		// sections as (polyline) envelopes
+		if (!section.envelopes.empty())
 		{
-			ccPolyline* poly = m_sections[s].entity;
-			if (poly)
+			// create output group if necessary
+			ccHObject* destEntity = getExportGroup(s_profileExportGroupID, "Extracted profiles");
+			assert(destEntity);
+
+			for (size_t p = 0; p < section.envelopes.size(); ++p)
 			{
-				unsigned polyVertCount = poly->size();
-				if (polyVertCount < 2)
+				ccPolyline* envelopePart = section.envelopes[p];
+				QString     name         = QString("Section envelope #%1").arg(sectionIndex);
+				if (section.envelopes.size() > 1)
 				{
-					assert(false);
-					continue;
+					name += QString("(part %1/%2)").arg(p + 1).arg(section.envelopes.size());
 				}
-				unsigned polySegmentCount = poly->isClosed() ? polyVertCount : polyVertCount - 1;
-
-				// project the section in '2D'
-				std::vector<Segment2D> polySegments2D;
+				envelopePart->setName(name);
+				envelopePart->setColor(s_defaultEnvelopeColor);
+				envelopePart->showColors(true);
+				// copy meta-data (import for Mascaret export!)
 				{
-					polySegments2D.reserve(polySegmentCount);
-					PointCoordinateType s = 0;
-					for (unsigned j = 0; j < polySegmentCount; ++j)
-					{
-						Segment2D        seg2D;
-						const CCVector3* A = poly->getPoint(j);
-						const CCVector3* B = poly->getPoint((j + 1) % polyVertCount);
-						seg2D.A            = CCVector2(A->u[xDim], A->u[yDim]);
-						seg2D.B            = CCVector2(B->u[xDim], B->u[yDim]);
-						seg2D.uAB          = seg2D.B - seg2D.A; //(unit) direction
-						seg2D.lAB          = seg2D.uAB.norm();  // length
-						seg2D.s            = s;
-						s += seg2D.lAB;
-
-						if (CCCoreLib::LessThanEpsilon(seg2D.lAB))
-						{
-							// ignore too small segments
-							continue;
-						}
-
-						seg2D.uAB /= seg2D.lAB;
-						polySegments2D.push_back(seg2D);
-					}
-
-					if (polySegments2D.empty())
+					const QVariantMap& metaData = polylines[s]->metaData();
+					for (QVariantMap::const_iterator it = metaData.begin(); it != metaData.end(); ++it)
 					{
-						assert(false);
-						continue;
+						envelopePart->setMetaData(it.key(), it.value());
 					}
 				}
 
-				int                                     cloudCount = m_clouds.size();
-				std::vector<CCCoreLib::ReferenceCloud*> refClouds;
-				if (s_extractSectionsAsClouds)
-				{
-					refClouds.resize(cloudCount, nullptr);
-				}
-
-				// for envelope extraction as a polyline
-				ccPointCloud* originalSlicePoints = nullptr;
-				ccPointCloud* unrolledSlicePoints = nullptr;
-				if (s_extractSectionsAsEnvelopes)
-				{
-					originalSlicePoints = new ccPointCloud("section.orig");
-					unrolledSlicePoints = new ccPointCloud("section.unroll");
-
-					// assign them the default (first!) global shift & scale info
-					assert(!m_clouds.empty());
-					ccGenericPointCloud* cloud = m_clouds.front().entity;
-					originalSlicePoints->copyGlobalShiftAndScale(*cloud);
-				}
-
-				// for each cloud
-				for (int c = 0; c < cloudCount; ++c)
-				{
-					ccGenericPointCloud* cloud = m_clouds[c].entity;
-					if (cloud)
-					{
-						// for envelope extraction as a cloud
-						CCCoreLib::ReferenceCloud* refCloud = nullptr;
-						if (s_extractSectionsAsClouds)
-						{
-							refCloud = new CCCoreLib::ReferenceCloud(cloud);
-						}
-
-						// compute the distance of each point to the current polyline segment
-						for (unsigned i = 0; i < cloud->size(); ++i)
-						{
-							const CCVector3* P = cloud->getPoint(i);
-							CCVector2        P2D(P->u[xDim], P->u[yDim]);
-
-							// for each vertex
-							PointCoordinateType minSquareDist  = -CCCoreLib::PC_ONE;
-							PointCoordinateType curvilinearPos = 0.0;
-							size_t              minIndex       = 0;
-							for (size_t j = 0; j < polySegments2D.size(); ++j)
-							{
-								const Segment2D& seg2D = polySegments2D[j];
-								CCVector2        AP2D  = P2D - seg2D.A;
-
-								// square distance to the polyline
-								PointCoordinateType squareDist = 0;
-
-								// longitudinal 'distance'
-								double dotprod = seg2D.uAB.dot(AP2D);
-								if (dotprod < 0)
-								{
-									if (j == 0 && !poly->isClosed())
-									{
-										continue;
-									}
-									squareDist = AP2D.norm2();
-								}
-								else if (dotprod > seg2D.lAB)
-								{
-									if (j + 1 == polySegments2D.size() && !poly->isClosed())
-									{
-										continue;
-									}
-									squareDist = (P2D - seg2D.B).norm2();
-								}
-								else
-								{
-									// orthogonal distance
-									squareDist = (AP2D - seg2D.uAB * dotprod).norm2();
-								}
-
-								if (minSquareDist < 0 || squareDist < minSquareDist)
-								{
-									minSquareDist  = squareDist;
-									curvilinearPos = dotprod;
-									minIndex       = j;
-								}
-							}
-
-							// elligible point?
-							if (minSquareDist >= 0 && minSquareDist < sectionThicknessSq)
-							{
-								// if we extract the section as cloud(s), we add the point to the (current) ref. cloud
-								if (s_extractSectionsAsClouds)
-								{
-									assert(refCloud);
-									unsigned refCloudSize = refCloud->size();
-									if (refCloudSize == refCloud->capacity())
-									{
-										refCloudSize += (refCloudSize / 2 + 1);
-										if (!refCloud->reserve(refCloudSize))
-										{
-											// not enough memory
-											ccLog::Warning("[ccSectionExtractionTool] Not enough memory");
-											error = true;
-											break;
-										}
-									}
-									refCloud->addPointIndex(i);
-								}
-
-								// if we extract the section as envelope(s), we add it to the 2D points set
-								if (s_extractSectionsAsEnvelopes)
-								{
-									assert(originalSlicePoints && unrolledSlicePoints);
-									assert(originalSlicePoints->size() == unrolledSlicePoints->size());
-
-									unsigned cloudSize = originalSlicePoints->size();
-									if (cloudSize == originalSlicePoints->capacity())
-									{
-										cloudSize += (cloudSize / 2 + 1);
-										if (!originalSlicePoints->reserve(cloudSize)
-										    || !unrolledSlicePoints->reserve(cloudSize))
-										{
-											// not enough memory
-											ccLog::Warning("[ccSectionExtractionTool] Not enough memory");
-											error = true;
-											break;
-										}
-									}
-
-									const Segment2D& seg2D = polySegments2D[minIndex];
-
-									// we project the 'real' 3D point in the section plane
-									CCVector3 Pproj3D;
-									{
-										Pproj3D.u[xDim]    = seg2D.A.x + seg2D.uAB.x * curvilinearPos;
-										Pproj3D.u[yDim]    = seg2D.A.y + seg2D.uAB.y * curvilinearPos;
-										Pproj3D.u[vertDim] = P->u[vertDim];
-									}
-									originalSlicePoints->addPoint(Pproj3D);
-									unrolledSlicePoints->addPoint(CCVector3(seg2D.s + curvilinearPos, P->u[vertDim], 0));
-								}
-							}
-
-							if (error)
-							{
-								break;
-							}
-
-						} // for each point
-
-						if (refCloud)
-						{
-							assert(s_extractSectionsAsClouds);
-							if (error || refCloud->size() == 0)
-							{
-								delete refCloud;
-								refCloud = nullptr;
-							}
-							else
-							{
-								refClouds[c] = refCloud;
-							}
-						}
-					}
-
-					if (error)
-					{
-						break;
-					}
-
-				} // for each cloud
-
-				if (!error)
-				{
-					// Extract sections as (polyline) envelopes
-					if (/*!error && */ s_extractSectionsAsEnvelopes)
-					{
-						assert(originalSlicePoints && unrolledSlicePoints);
-						bool envelopeGenerated = false;
-						error                  = !extractSectionEnvelope(poly,
-                                                        originalSlicePoints,
-                                                        unrolledSlicePoints,
-                                                        s + 1,
-                                                        s_extractSectionsType,
-                                                        s_envelopeMaxEdgeLength,
-                                                        s_multiPass,
-                                                        s_splitEnvelope,
-                                                        envelopeGenerated,
-                                                        visualDebugMode);
-
-						if (envelopeGenerated)
-						{
-							++generatedEnvelopes;
-						}
-					}
-
-					// Extract sections as clouds
-					if (!error && s_extractSectionsAsClouds)
-					{
-						assert(static_cast<int>(refClouds.size()) == cloudCount);
-						bool cloudGenerated = false;
-						error               = !extractSectionCloud(refClouds, s + 1, cloudGenerated);
-						if (cloudGenerated)
-							++generatedClouds;
-					}
-				}
+				// add to main DB
+				destEntity->addChild(envelopePart);
+				envelopePart->setDisplay_recursive(destEntity->getDisplay());
+				MainWindow::TheInstance()->addToDB(envelopePart, false, false);
+			}
+			section.envelopes.clear();
 
-				// release memory
-				for (auto& refCloud : refClouds)
-				{
-					delete refCloud;
-					refCloud = nullptr;
-				}
+			++generatedEnvelopes;
+		}
 
-				delete originalSlicePoints;
-				originalSlicePoints = nullptr;
+		// sections as clouds
+		if (section.cloud)
+		{
+			// create output group if necessary
+			ccHObject* destEntity = getExportGroup(s_cloudExportGroupID, "Extracted section clouds");
+			assert(destEntity);
 
-				delete unrolledSlicePoints;
-				unrolledSlicePoints = nullptr;
-			} // if (poly)
+			section.cloud->setName(QString("Section cloud #%1").arg(sectionIndex));
+			section.cloud->setDisplay(destEntity->getDisplay());
 
-			if (!nprogress.oneStep())
-			{
-				ccLog::Warning("[ccSectionExtractionTool] Canceled by user");
-				error = true;
-			}
+			// add to main DB
+			destEntity->addChild(section.cloud);
+			MainWindow::TheInstance()->addToDB(section.cloud, false, false);
+			section.cloud = nullptr;
 
-			if (error)
-				break;
-		} // for (int s=0; s<m_sections.size(); ++s)
-	}
-	catch (const std::bad_alloc&)
-	{
-		error = true;
+			++generatedClouds;
+		}
 	}
 
-	if (error)
-	{
-		ccLog::Error("An error occurred (see console)");
-	}
-	else
-	{
-		ccLog::Print(QString("[ccSectionExtractionTool] Job done (%1 envelope(s) and %2 cloud(s) were generated)").arg(generatedEnvelopes).arg(generatedClouds));
-	}
+	ccLog::Print(QString("[ccSectionExtractionTool] Job done (%1 envelope(s) and %2 cloud(s) were generated)").arg(generatedEnvelopes).arg(generatedClouds));
 }
@@ -92,23 +92,6 @@ class ccSectionExtractionTool : public ccOverlayDialog
 	//! Adds a 'step' on the undo stack
 	void addUndoStep();
 
-	//! Convert one or several ReferenceCloud instances to a single cloud and add it to the main DB
-	bool extractSectionCloud(const std::vector<CCCoreLib::ReferenceCloud*>& refClouds,
-	                         unsigned                                       sectionIndex,
-	                         bool&                                          cloudGenerated);
-
-	//! Extract the envelope from a set of 2D points and add it to the main DB
-	bool extractSectionEnvelope(const ccPolyline*                 originalSection,
-	                            const ccPointCloud*               originalSectionCloud,
-	                            ccPointCloud*                     unrolledSectionCloud, //'2D' cloud with Z = 0
-	                            unsigned                          sectionIndex,
-	                            ccEnvelopeExtractor::EnvelopeType type,
-	                            PointCoordinateType               maxEdgeLength,
-	                            bool                              multiPass,
-	                            bool                              splitEnvelope,
-	                            bool&                             envelopeGenerated,
-	                            bool                              visualDebugMode = false);
-
 	//! Creates (if necessary) and returns a group to store entities in the main DB
 	ccHObject* getExportGroup(unsigned& defaultGroupID, const QString& defaultName);
 
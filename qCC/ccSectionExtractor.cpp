@@ -0,0 +1,998 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#include "ccSectionExtractor.h"
+
+// CCCoreLib
+#include <GenericProgressCallback.h>
+#include <ReferenceCloud.h>
+
+// qCC_db
+#include <ccGenericPointCloud.h>
+#include <ccLog.h>
+#include <ccPointCloud.h>
+#include <ccPolyline.h>
+
+// Qt
+#include <QString>
+
+// System
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+#if defined(_OPENMP)
+// OpenMP
+#include <omp.h>
+#endif
+
+//! Number of points binned by each parallel task
+static const unsigned s_sectionChunkSize = 65536;
+//! Max number of cells of the segments grid (in each dimension)
+static const unsigned s_maxSegmentGridDim = 1024;
+
+namespace
+{
+	//! Section segment (projected in the horizontal plane)
+	struct Segment
+	{
+		CCVector2           A, B;
+		CCVector2           u;           //!< unit direction
+		PointCoordinateType length  = 0; //!< 2D length
+		PointCoordinateType curvPos = 0; //!< curvilinear position of A
+		unsigned            section = 0; //!< section (polyline) index
+		bool                skipBefore = false; //!< the points 'before' A are ignored (first segment of an open section)
+		bool                skipAfter  = false; //!< the points 'after' B are ignored (last segment of an open section)
+	};
+
+	//! Point lying in a section corridor
+	struct SectionPoint
+	{
+		unsigned            section;    //!< section index
+		unsigned            pointIndex; //!< point index (in its cloud)
+		unsigned            segment;    //!< closest segment (global index)
+		PointCoordinateType dotprod;    //!< longitudinal position of the point along the closest segment
+	};
+
+	//! Points of a cloud, sorted by section
+	struct BinnedCloud
+	{
+		std::vector<SectionPoint> points;
+		std::vector<unsigned>     sectionStart; //!< first point of each section (+ total count)
+
+		inline unsigned count(unsigned section) const
+		{
+			return sectionStart[section + 1] - sectionStart[section];
+		}
+		inline const SectionPoint* begin(unsigned section) const
+		{
+			return points.data() + sectionStart[section];
+		}
+	};
+
+	//! Uniform 2D grid indexing the (enlarged) bounding rectangles of the segments
+	/** The segments of each cell are stored in ascending order.
+	**/
+	class SegmentGrid
+	{
+	  public:
+		bool init(const std::vector<Segment>& segments, PointCoordinateType margin)
+		{
+			if (segments.empty())
+			{
+				return false;
+			}
+
+			// segments bounding rectangles
+			std::vector<CCVector2> rectMin(segments.size());
+			std::vector<CCVector2> rectMax(segments.size());
+			CCVector2              gridMax;
+			double                 extentSum = 0;
+			for (size_t i = 0; i < segments.size(); ++i)
+			{
+				const Segment& seg = segments[i];
+				rectMin[i]         = CCVector2(std::min(seg.A.x, seg.B.x) - margin, std::min(seg.A.y, seg.B.y) - margin);
+				rectMax[i]         = CCVector2(std::max(seg.A.x, seg.B.x) + margin, std::max(seg.A.y, seg.B.y) + margin);
+				extentSum += std::max(rectMax[i].x - rectMin[i].x, rectMax[i].y - rectMin[i].y);
+				if (i == 0)
+				{
+					m_min   = rectMin[i];
+					gridMax = rectMax[i];
+				}
+				else
+				{
+					m_min.x   = std::min(m_min.x, rectMin[i].x);
+					m_min.y   = std::min(m_min.y, rectMin[i].y);
+					gridMax.x = std::max(gridMax.x, rectMax[i].x);
+					gridMax.y = std::max(gridMax.y, rectMax[i].y);
+				}
+			}
+
+			// a segment should typically overlap a few cells only
+			PointCoordinateType maxExtent = std::max(gridMax.x - m_min.x, gridMax.y - m_min.y);
+			m_cellSize                    = static_cast<PointCoordinateType>(extentSum / segments.size());
+			m_cellSize                    = std::max(m_cellSize, 2 * margin);
+			m_cellSize                    = std::max(m_cellSize, maxExtent / s_maxSegmentGridDim);
+			if (!CCCoreLib::GreaterThanEpsilon(m_cellSize))
+			{
+				return false;
+			}
+			m_dimX = std::min(static_cast<unsigned>((gridMax.x - m_min.x) / m_cellSize) + 1, s_maxSegmentGridDim);
+			m_dimY = std::min(static_cast<unsigned>((gridMax.y - m_min.y) / m_cellSize) + 1, s_maxSegmentGridDim);
+
+			// count the segments of each cell, then store them (in ascending order)
+			m_cellStart.clear();
+			m_cellStart.resize(static_cast<size_t>(m_dimX) * m_dimY + 1, 0);
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				if (pass == 1)
+				{
+					for (size_t c = 1; c < m_cellStart.size(); ++c)
+					{
+						m_cellStart[c] += m_cellStart[c - 1];
+					}
+					m_segmentIndexes.resize(m_cellStart.back());
+				}
+
+				std::vector<unsigned> cursor;
+				if (pass == 1)
+				{
+					cursor.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+				}
+
+				for (size_t i = 0; i < segments.size(); ++i)
+				{
+					unsigned x0 = cellX(rectMin[i].x);
+					unsigned x1 = cellX(rectMax[i].x);
+					unsigned y0 = cellY(rectMin[i].y);
+					unsigned y1 = cellY(rectMax[i].y);
+					for (unsigned y = y0; y <= y1; ++y)
+					{
+						for (unsigned x = x0; x <= x1; ++x)
+						{
+							size_t cellIndex = static_cast<size_t>(y) * m_dimX + x;
+							if (pass == 0)
+								++m_cellStart[cellIndex + 1];
+							else
+								m_segmentIndexes[cursor[cellIndex]++] = static_cast<unsigned>(i);
+						}
+					}
+				}
+			}
+
+			return true;
+		}
+
+		//! Returns the segments that may be close enough to a given point
+		inline unsigned candidates(const CCVector2& P, const unsigned*& first) const
+		{
+			PointCoordinateType fx = (P.x - m_min.x) / m_cellSize;
+			PointCoordinateType fy = (P.y - m_min.y) / m_cellSize;
+			if (!(fx >= 0 && fy >= 0 && fx < m_dimX && fy < m_dimY)) // also rejects invalid points
+			{
+				return 0;
+			}
+			size_t cellIndex = static_cast<size_t>(fy) * m_dimX + static_cast<size_t>(fx);
+			first            = m_segmentIndexes.data() + m_cellStart[cellIndex];
+			return m_cellStart[cellIndex + 1] - m_cellStart[cellIndex];
+		}
+
+	  protected:
+		inline unsigned cellX(PointCoordinateType x) const
+		{
+			return std::min(static_cast<unsigned>(std::max<PointCoordinateType>((x - m_min.x) / m_cellSize, 0)), m_dimX - 1);
+		}
+		inline unsigned cellY(PointCoordinateType y) const
+		{
+			return std::min(static_cast<unsigned>(std::max<PointCoordinateType>((y - m_min.y) / m_cellSize, 0)), m_dimY - 1);
+		}
+
+		CCVector2             m_min;
+		PointCoordinateType   m_cellSize = 0;
+		unsigned              m_dimX     = 0;
+		unsigned              m_dimY     = 0;
+		std::vector<unsigned> m_cellStart;
+		std::vector<unsigned> m_segmentIndexes;
+	};
+
+	//! Binning mode
+	enum class BinningMode
+	{
+		EXTRACTION, //!< section extraction (open sections are not extended beyond their extremities)
+		UNFOLDING   //!< unfolding
+	};
+
+	//! Projects the sections in 2D (segments are ordered by section, then along each section)
+	void BuildSegments(const std::vector<ccPolyline*>& polylines, BinningMode mode, unsigned char xDim, unsigned char yDim, std::vector<Segment>& segments)
+	{
+		for (size_t p = 0; p < polylines.size(); ++p)
+		{
+			const ccPolyline* poly = polylines[p];
+			if (!poly || poly->size() < 2)
+			{
+				continue;
+			}
+
+			unsigned polyVertCount    = poly->size();
+			unsigned polySegmentCount = poly->isClosed() ? polyVertCount : polyVertCount - 1;
+			size_t   firstSegment     = segments.size();
+
+			PointCoordinateType curvPos = 0;
+			for (unsigned j = 0; j < polySegmentCount; ++j)
+			{
+				const CCVector3* A = poly->getPoint(j);
+				const CCVector3* B = poly->getPoint((j + 1) % polyVertCount);
+
+				Segment seg;
+				seg.A       = CCVector2(A->u[xDim], A->u[yDim]);
+				seg.B       = CCVector2(B->u[xDim], B->u[yDim]);
+				seg.u       = seg.B - seg.A;
+				seg.length  = seg.u.norm();
+				seg.curvPos = curvPos;
+				seg.section = static_cast<unsigned>(p);
+
+				bool valid = false;
+				if (mode == BinningMode::EXTRACTION)
+				{
+					// the curvilinear position is 2D (and too small segments are ignored)
+					curvPos += seg.length;
+					valid = !CCCoreLib::LessThanEpsilon(seg.length);
+				}
+				else
+				{
+					// the curvilinear position is 3D
+					curvPos += (*B - *A).norm();
+					valid = CCCoreLib::GreaterThanEpsilon(seg.length);
+				}
+
+				if (valid)
+				{
+					seg.u /= seg.length;
+					segments.push_back(seg);
+				}
+			}
+
+			if (mode == BinningMode::EXTRACTION && !poly->isClosed() && segments.size() != firstSegment)
+			{
+				segments[firstSegment].skipBefore = true;
+				segments.back().skipAfter         = true;
+			}
+		}
+	}
+
+	//! Bins the points of a cloud in the sections corridors (in parallel)
+	/** Each point is assigned to every section whose corridor contains it (with its
+	    closest segment in this section). The points of each section are then sorted
+	    by index, as if the sections were processed one after the other.
+	**/
+	bool BinCloud(ccGenericPointCloud*          cloud,
+	              const std::vector<Segment>&   segments,
+	              const SegmentGrid&            grid,
+	              unsigned                      sectionCount,
+	              BinningMode                   mode,
+	              PointCoordinateType           maxSquareDist,
+	              unsigned char                 xDim,
+	              unsigned char                 yDim,
+	              int                           maxThreadCount,
+	              CCCoreLib::NormalizedProgress* nProgress,
+	              BinnedCloud&                  binned)
+	{
+		const unsigned pointCount = cloud->size();
+		const int      chunkCount = static_cast<int>((pointCount + s_sectionChunkSize - 1) / s_sectionChunkSize);
+
+		std::vector<std::vector<SectionPoint>> chunkPoints;
+		try
+		{
+			chunkPoints.resize(chunkCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+
+		std::atomic<bool> cancelled(false);
+		std::atomic<bool> notEnoughMemory(false);
+#if defined(_OPENMP)
+		const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+#endif
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			if (cancelled || notEnoughMemory)
+			{
+				continue;
+			}
+
+			std::vector<SectionPoint>& points = chunkPoints[c];
+			const unsigned             begin  = static_cast<unsigned>(c) * s_sectionChunkSize;
+			const unsigned             end    = std::min(begin + s_sectionChunkSize, pointCount);
+			try
+			{
+				for (unsigned i = begin; i < end; ++i)
+				{
+					const CCVector3* P = cloud->getPoint(i);
+					CCVector2        P2D(P->u[xDim], P->u[yDim]);
+
+					const unsigned* candidates     = nullptr;
+					unsigned        candidateCount = grid.candidates(P2D, candidates);
+
+					// the candidates are grouped by section (and sorted along each section)
+					for (unsigned k = 0; k < candidateCount;)
+					{
+						const unsigned section = segments[candidates[k]].section;
+
+						PointCoordinateType minSquareDist = -CCCoreLib::PC_ONE;
+						PointCoordinateType minDotprod    = 0;
+						unsigned            minIndex      = 0;
+						for (; k < candidateCount && segments[candidates[k]].section == section; ++k)
+						{
+							const Segment& seg  = segments[candidates[k]];
+							CCVector2      AP2D = P2D - seg.A;
+
+							// longitudinal 'distance'
+							PointCoordinateType dotprod    = seg.u.dot(AP2D);
+							PointCoordinateType squareDist = 0;
+							if (dotprod < 0)
+							{
+								if (seg.skipBefore)
+									continue;
+								// dist to nearest vertex
+								squareDist = AP2D.norm2();
+							}
+							else if (dotprod > seg.length)
+							{
+								if (seg.skipAfter)
+									continue;
+								// dist to nearest vertex
+								squareDist = (P2D - seg.B).norm2();
+							}
+							else
+							{
+								// orthogonal distance
+								squareDist = (AP2D - seg.u * dotprod).norm2();
+							}
+
+							if (minSquareDist < 0 || squareDist < minSquareDist)
+							{
+								minSquareDist = squareDist;
+								minDotprod    = dotprod;
+								minIndex      = candidates[k];
+							}
+						}
+
+						// elligible point?
+						bool inside = (mode == BinningMode::EXTRACTION ? minSquareDist < maxSquareDist : minSquareDist <= maxSquareDist);
+						if (minSquareDist >= 0 && inside)
+						{
+							points.push_back({section, i, minIndex, minDotprod});
+						}
+					}
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+
+			if (nProgress && !nProgress->oneStep())
+			{
+				cancelled = true;
+			}
+		}
+
+		if (cancelled || notEnoughMemory)
+		{
+			if (notEnoughMemory)
+				ccLog::Warning("[ccSectionExtractor] Not enough memory");
+			return false;
+		}
+
+		// stable counting sort by section
+		try
+		{
+			binned.sectionStart.clear();
+			binned.sectionStart.resize(sectionCount + 1, 0);
+			size_t totalCount = 0;
+			for (const std::vector<SectionPoint>& points : chunkPoints)
+			{
+				for (const SectionPoint& sp : points)
+				{
+					++binned.sectionStart[sp.section + 1];
+				}
+				totalCount += points.size();
+			}
+			for (unsigned s = 1; s <= sectionCount; ++s)
+			{
+				binned.sectionStart[s] += binned.sectionStart[s - 1];
+			}
+
+			binned.points.resize(totalCount);
+			std::vector<unsigned> cursor(binned.sectionStart.begin(), binned.sectionStart.end() - 1);
+			for (std::vector<SectionPoint>& points : chunkPoints)
+			{
+				for (const SectionPoint& sp : points)
+				{
+					binned.points[cursor[sp.section]++] = sp;
+				}
+				points.clear();
+				points.shrink_to_fit();
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccSectionExtractor] Not enough memory");
+			return false;
+		}
+
+		return true;
+	}
+
+	//! Returns the number of binning tasks
+	unsigned BinningTaskCount(const std::vector<ccGenericPointCloud*>& clouds)
+	{
+		unsigned taskCount = 0;
+		for (ccGenericPointCloud* cloud : clouds)
+		{
+			taskCount += (cloud->size() + s_sectionChunkSize - 1) / s_sectionChunkSize;
+		}
+		return taskCount;
+	}
+
+	//! Bins the points of all the clouds
+	bool BinClouds(const std::vector<ccGenericPointCloud*>& clouds,
+	               const std::vector<ccPolyline*>&          polylines,
+	               BinningMode                              mode,
+	               PointCoordinateType                      thickness,
+	               unsigned char                            vertDim,
+	               int                                      maxThreadCount,
+	               CCCoreLib::NormalizedProgress*           nProgress,
+	               std::vector<Segment>&                    segments,
+	               std::vector<BinnedCloud>&                binnedClouds)
+	{
+		const unsigned char xDim = (vertDim < 2 ? vertDim + 1 : 0);
+		const unsigned char yDim = (xDim < 2 ? xDim + 1 : 0);
+
+		// we consider half of the total thickness as points can be on both sides!
+		const PointCoordinateType margin = thickness / 2;
+
+		SegmentGrid grid;
+		try
+		{
+			BuildSegments(polylines, mode, xDim, yDim, segments);
+			binnedClouds.resize(clouds.size());
+
+			// the rectangles are slightly enlarged so as to be robust to rounding errors
+			if (!grid.init(segments, margin * static_cast<PointCoordinateType>(1.001)))
+			{
+				ccLog::Warning("[ccSectionExtractor] No valid section");
+				return false;
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccSectionExtractor] Not enough memory");
+			return false;
+		}
+
+		for (size_t c = 0; c < clouds.size(); ++c)
+		{
+			if (!BinCloud(clouds[c],
+			              segments,
+			              grid,
+			              static_cast<unsigned>(polylines.size()),
+			              mode,
+			              margin * margin,
+			              xDim,
+			              yDim,
+			              maxThreadCount,
+			              nProgress,
+			              binnedClouds[c]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//! Extracts the binned points of a cloud as a new cloud
+	ccPointCloud* ExtractPart(ccGenericPointCloud* cloud, const SectionPoint* points, unsigned count)
+	{
+		CCCoreLib::ReferenceCloud selection(cloud);
+		if (!selection.reserve(count))
+		{
+			return nullptr;
+		}
+		for (unsigned n = 0; n < count; ++n)
+		{
+			selection.addPointIndex(points[n].pointIndex);
+		}
+
+		// if the cloud is a ccPointCloud, we can keep a lot more information
+		ccPointCloud* pc = dynamic_cast<ccPointCloud*>(cloud);
+		return pc ? pc->partialClone(&selection) : ccPointCloud::From(&selection, cloud);
+	}
+
+	//! Returns whether the parts of the clouds can be extracted in parallel
+	/** The child entities (if any) are cloned sequentially.
+	**/
+	bool CanCloneInParallel(const std::vector<ccGenericPointCloud*>& clouds)
+	{
+		for (ccGenericPointCloud* cloud : clouds)
+		{
+			if (cloud->getChildrenNumber() != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//! Starts the progress callback (if any)
+	void StartProgress(CCCoreLib::GenericProgressCallback* progressCb, const QString& title, size_t polylineCount, const std::vector<ccGenericPointCloud*>& clouds)
+	{
+		if (!progressCb)
+		{
+			return;
+		}
+
+		if (progressCb->textCanBeEdited())
+		{
+			unsigned pointCount = 0;
+			for (ccGenericPointCloud* cloud : clouds)
+			{
+				pointCount += cloud->size();
+			}
+			progressCb->setMethodTitle(qPrintable(title));
+			progressCb->setInfo(qPrintable(QString("Number of sections: %1\nNumber of points: %2").arg(polylineCount).arg(pointCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	//! Extracts the envelope of a section
+	/** \return false in case of error (an empty envelope is not an error)
+	**/
+	bool ExtractEnvelope(const std::vector<ccGenericPointCloud*>& clouds,
+	                     const std::vector<BinnedCloud>&          binnedClouds,
+	                     const std::vector<Segment>&              segments,
+	                     unsigned                                 sectionIndex,
+	                     const ccSectionExtractor::Parameters&    params,
+	                     ccSectionExtractor::Section&             section)
+	{
+		const unsigned char vertDim = params.vertDim;
+		const unsigned char xDim    = (vertDim < 2 ? vertDim + 1 : 0);
+		const unsigned char yDim    = (xDim < 2 ? xDim + 1 : 0);
+
+		if (section.pointCount < 2)
+		{
+			// nothing to do
+			ccLog::Warning(QString("[ccSectionExtractor][extract envelope] Section #%1 contains less than 2 points and will be ignored").arg(sectionIndex + 1));
+			return true;
+		}
+
+		ccPointCloud originalSectionCloud("section.orig");
+		ccPointCloud unrolledSectionCloud("section.unroll");
+		if (!originalSectionCloud.reserve(section.pointCount) || !unrolledSectionCloud.reserve(section.pointCount))
+		{
+			ccLog::Warning("[ccSectionExtractor] Not enough memory");
+			return false;
+		}
+
+		for (size_t c = 0; c < clouds.size(); ++c)
+		{
+			const BinnedCloud&  binned = binnedClouds[c];
+			const SectionPoint* points = binned.begin(sectionIndex);
+			const unsigned      count  = binned.count(sectionIndex);
+			for (unsigned n = 0; n < count; ++n)
+			{
+				const CCVector3* P   = clouds[c]->getPoint(points[n].pointIndex);
+				const Segment&   seg = segments[points[n].segment];
+
+				// we project the 'real' 3D point in the section plane
+				CCVector3 Pproj3D;
+				{
+					Pproj3D.u[xDim]    = seg.A.x + seg.u.x * points[n].dotprod;
+					Pproj3D.u[yDim]    = seg.A.y + seg.u.y * points[n].dotprod;
+					Pproj3D.u[vertDim] = P->u[vertDim];
+				}
+				originalSectionCloud.addPoint(Pproj3D);
+				unrolledSectionCloud.addPoint(CCVector3(seg.curvPos + points[n].dotprod, P->u[vertDim], 0));
+			}
+		}
+
+		// the points in 'unrolledSectionCloud' are 2D (X = curvilinear coordinate, Y = height, Z = 0)
+		CCVector3 N(0, 0, 1);
+		CCVector3 Y(0, 1, 0);
+
+		std::vector<unsigned> vertIndexes;
+		ccPolyline*           envelope = ccEnvelopeExtractor::ExtractFlatEnvelope(&unrolledSectionCloud,
+                                                                        params.multiPass,
+                                                                        params.maxEdgeLength,
+                                                                        N.u,
+                                                                        Y.u,
+                                                                        params.envelopeType,
+                                                                        &vertIndexes,
+                                                                        params.visualDebugMode,
+                                                                        0.0,
+                                                                        ccEnvelopeExtractor::FAST);
+		if (!envelope)
+		{
+			return true;
+		}
+
+		// update vertices (to replace 'unrolled' points by 'original' ones
+		CCCoreLib::GenericIndexedCloud* vertices = envelope->getAssociatedCloud();
+		if (vertIndexes.size() != static_cast<size_t>(vertices->size()))
+		{
+			ccLog::Warning("[ccSectionExtractor][extract envelope] Internal error (couldn't fetch original points indexes?!)");
+			delete envelope;
+			return false;
+		}
+		for (unsigned i = 0; i < vertices->size(); ++i)
+		{
+			const CCVector3* P = vertices->getPoint(i);
+			assert(vertIndexes[i] < originalSectionCloud.size());
+			*const_cast<CCVector3*>(P) = *originalSectionCloud.getPoint(vertIndexes[i]);
+		}
+		ccPointCloud* verticesAsPC = dynamic_cast<ccPointCloud*>(vertices);
+		if (verticesAsPC)
+		{
+			verticesAsPC->refreshBB();
+		}
+
+		if (params.splitEnvelopes)
+		{
+			/*bool success = */ envelope->split(params.maxEdgeLength, section.envelopes);
+			delete envelope;
+			envelope = nullptr;
+		}
+		else
+		{
+			section.envelopes.push_back(envelope);
+		}
+
+		// assign the default (first!) global shift & scale info
+		for (ccPolyline* part : section.envelopes)
+		{
+			part->copyGlobalShiftAndScale(*clouds.front());
+		}
+
+		return true;
+	}
+
+	//! Extracts the cloud of a section (all the input clouds merged)
+	/** \return false in case of error
+	**/
+	bool ExtractSectionCloud(const std::vector<ccGenericPointCloud*>& clouds,
+	                         const std::vector<BinnedCloud>&          binnedClouds,
+	                         unsigned                                 sectionIndex,
+	                         ccSectionExtractor::Section&             section)
+	{
+		for (size_t c = 0; c < clouds.size(); ++c)
+		{
+			const BinnedCloud& binned = binnedClouds[c];
+			const unsigned     count  = binned.count(sectionIndex);
+			if (count == 0)
+			{
+				continue;
+			}
+
+			// extract part/section from each cloud
+			ccPointCloud* part = ExtractPart(clouds[c], binned.begin(sectionIndex), count);
+			if (!part)
+			{
+				ccLog::Warning("[ccSectionExtractor][extract cloud] Not enough memory");
+				return false;
+			}
+
+			if (!section.cloud)
+			{
+				// we simply use this 'part' cloud as the section cloud
+				section.cloud = part;
+			}
+			else
+			{
+				// fuse it with the global cloud
+				unsigned cloudSizeBefore = section.cloud->size();
+				unsigned partSize        = part->size();
+				section.cloud->append(part, cloudSizeBefore, true);
+
+				// don't need it anymore
+				delete part;
+				part = nullptr;
+				// check that it actually worked!
+				if (section.cloud->size() != cloudSizeBefore + partSize)
+				{
+					ccLog::Warning("[ccSectionExtractor][extract cloud] Not enough memory");
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	//! Releases the sections
+	void ReleaseSections(std::vector<ccSectionExtractor::Section>& sections)
+	{
+		for (ccSectionExtractor::Section& section : sections)
+		{
+			delete section.cloud;
+			for (ccPolyline* envelope : section.envelopes)
+			{
+				delete envelope;
+			}
+		}
+		sections.clear();
+	}
+} // namespace
+
+bool ccSectionExtractor::ExtractSections(const std::vector<ccGenericPointCloud*>& clouds,
+                                         const std::vector<ccPolyline*>&          polylines,
+                                         const Parameters&                        params,
+                                         std::vector<Section>&                    sections,
+                                         CCCoreLib::GenericProgressCallback*      progressCb /*=nullptr*/)
+{
+	ReleaseSections(sections);
+
+	if (clouds.empty() || polylines.empty() || params.vertDim > 2 || !CCCoreLib::GreaterThanEpsilon(params.thickness))
+	{
+		ccLog::Warning("[ccSectionExtractor] Invalid input parameters");
+		return false;
+	}
+	if (!params.extractClouds && !params.extractEnvelopes)
+	{
+		// nothing to do
+		return true;
+	}
+
+	StartProgress(progressCb, QString("Extract sections"), polylines.size(), clouds);
+
+	// bin all the points in all the sections corridors at once
+	std::vector<Segment>          segments;
+	std::vector<BinnedCloud>      binnedClouds;
+	CCCoreLib::NormalizedProgress nProgress(progressCb, BinningTaskCount(clouds) + static_cast<unsigned>(polylines.size()));
+	if (!BinClouds(clouds, polylines, BinningMode::EXTRACTION, params.thickness, params.vertDim, params.maxThreadCount, progressCb ? &nProgress : nullptr, segments, binnedClouds))
+	{
+		if (progressCb)
+			progressCb->stop();
+		return false;
+	}
+
+	try
+	{
+		sections.resize(polylines.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccSectionExtractor] Not enough memory");
+		if (progressCb)
+			progressCb->stop();
+		return false;
+	}
+
+	// now process the sections in parallel
+	const bool parallel     = !params.visualDebugMode && (!params.extractClouds || CanCloneInParallel(clouds));
+	const int  sectionCount = static_cast<int>(polylines.size());
+
+	std::atomic<bool> cancelled(false);
+	std::atomic<bool> error(false);
+#if defined(_OPENMP)
+	const int threadCount = (params.maxThreadCount > 0 ? params.maxThreadCount : omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount) if (parallel)
+#endif
+	for (int s = 0; s < sectionCount; ++s)
+	{
+		if (cancelled || error)
+		{
+			continue;
+		}
+
+		const ccPolyline* poly = polylines[s];
+		if (poly && poly->size() > 1)
+		{
+			Section& section = sections[s];
+			for (const BinnedCloud& binned : binnedClouds)
+			{
+				section.pointCount += binned.count(static_cast<unsigned>(s));
+			}
+
+			try
+			{
+				if (params.extractEnvelopes && !ExtractEnvelope(clouds, binnedClouds, segments, static_cast<unsigned>(s), params, section))
+				{
+					error = true;
+				}
+				else if (params.extractClouds && !ExtractSectionCloud(clouds, binnedClouds, static_cast<unsigned>(s), section))
+				{
+					error = true;
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				ccLog::Warning("[ccSectionExtractor] Not enough memory");
+				error = true;
+			}
+		}
+
+		if (progressCb && !nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (cancelled || error)
+	{
+		if (cancelled)
+			ccLog::Warning("[ccSectionExtractor] Process cancelled by the user");
+		ReleaseSections(sections);
+		return false;
+	}
+
+	return true;
+}
+
+bool ccSectionExtractor::UnfoldClouds(const std::vector<ccGenericPointCloud*>& clouds,
+                                      const std::vector<ccPolyline*>&          polylines,
+                                      PointCoordinateType                      thickness,
+                                      unsigned char                            vertDim,
+                                      const CCVector3&                         origin,
+                                      std::vector<ccPointCloud*>&              unfoldedClouds,
+                                      int                                      maxThreadCount /*=0*/,
+                                      CCCoreLib::GenericProgressCallback*      progressCb /*=nullptr*/)
+{
+	for (ccPointCloud* cloud : unfoldedClouds)
+	{
+		delete cloud;
+	}
+	unfoldedClouds.clear();
+
+	if (clouds.empty() || polylines.empty() || vertDim > 2 || !CCCoreLib::GreaterThanEpsilon(thickness))
+	{
+		ccLog::Warning("[ccSectionExtractor] Invalid input parameters");
+		return false;
+	}
+
+	const unsigned char xDim = (vertDim < 2 ? vertDim + 1 : 0);
+	const unsigned char yDim = (xDim < 2 ? xDim + 1 : 0);
+
+	StartProgress(progressCb, QString("Unfold cloud(s)"), polylines.size(), clouds);
+
+	// one task per (polyline, cloud) couple
+	const int taskCount = static_cast<int>(polylines.size() * clouds.size());
+
+	// bin all the points in all the polylines corridors at once
+	std::vector<Segment>          segments;
+	std::vector<BinnedCloud>      binnedClouds;
+	CCCoreLib::NormalizedProgress nProgress(progressCb, BinningTaskCount(clouds) + static_cast<unsigned>(taskCount));
+	if (!BinClouds(clouds, polylines, BinningMode::UNFOLDING, thickness, vertDim, maxThreadCount, progressCb ? &nProgress : nullptr, segments, binnedClouds))
+	{
+		if (progressCb)
+			progressCb->stop();
+		return false;
+	}
+
+	try
+	{
+		unfoldedClouds.resize(taskCount, nullptr);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccSectionExtractor] Not enough memory");
+		if (progressCb)
+			progressCb->stop();
+		return false;
+	}
+
+	// we start at the bounding-box limit
+	CCVector3 C  = origin;
+	C.u[vertDim] = 0;
+
+	std::atomic<bool> cancelled(false);
+	std::atomic<bool> notEnoughMemory(false);
+#if defined(_OPENMP)
+	const int threadCount = (maxThreadCount > 0 ? maxThreadCount : omp_get_max_threads());
+#pragma omp parallel for schedule(dynamic) num_threads(threadCount) if (CanCloneInParallel(clouds))
+#endif
+	for (int t = 0; t < taskCount; ++t)
+	{
+		if (cancelled || notEnoughMemory)
+		{
+			continue;
+		}
+
+		const unsigned      p       = static_cast<unsigned>(t / clouds.size());
+		const size_t        c       = t % clouds.size();
+		const BinnedCloud&  binned  = binnedClouds[c];
+		const unsigned      count   = binned.count(p);
+		const SectionPoint* points  = binned.begin(p);
+		if (count != 0)
+		{
+			try
+			{
+				ccPointCloud* unfoldedCloud = ExtractPart(clouds[c], points, count);
+				if (unfoldedCloud)
+				{
+					assert(unfoldedCloud->size() == count);
+					for (unsigned n = 0; n < count; ++n)
+					{
+						const Segment& seg = segments[points[n].segment];
+						CCVector3*     P   = const_cast<CCVector3*>(unfoldedCloud->getPoint(n));
+
+						// we use the curvilinear position of the point in the X dimension
+						CCVector2           P2D(P->u[xDim], P->u[yDim]);
+						CCVector2           AP2D    = P2D - seg.A;
+						PointCoordinateType dotprod = points[n].dotprod;
+						PointCoordinateType d       = (AP2D - seg.u * dotprod).norm();
+
+						// compute the sign of the distance
+						PointCoordinateType crossprod = AP2D.y * seg.u.x - AP2D.x * seg.u.y;
+
+						CCVector3 Q;
+						Q.u[xDim]    = seg.curvPos + dotprod;
+						Q.u[yDim]    = crossprod < 0 ? -d : d; // signed orthogonal distance to the polyline
+						Q.u[vertDim] = P->u[vertDim];
+
+						// update the point position
+						*P = Q + C;
+					}
+					unfoldedCloud->invalidateBoundingBox();
+					unfoldedClouds[t] = unfoldedCloud;
+				}
+				else
+				{
+					notEnoughMemory = true;
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+		}
+
+		if (progressCb && !nProgress.oneStep())
+		{
+			cancelled = true;
+		}
+	}
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (cancelled || notEnoughMemory)
+	{
+		ccLog::Warning(cancelled ? "[ccSectionExtractor] Process cancelled by the user" : "[ccSectionExtractor] Not enough memory");
+		for (ccPointCloud*& cloud : unfoldedClouds)
+		{
+			delete cloud;
+			cloud = nullptr;
+		}
+		unfoldedClouds.clear();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,124 @@
+// ##########################################################################
+// #                                                                        #
+// #                              CLOUDCOMPARE                              #
+// #                                                                        #
+// #  This program is free software; you can redistribute it and/or modify  #
+// #  it under the terms of the GNU General Public License as published by  #
+// #  the Free Software Foundation; version 2 or later of the License.      #
+// #                                                                        #
+// #  This program is distributed in the hope that it will be useful,       #
+// #  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+// #  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+// #  GNU General Public License for more details.                          #
+// #                                                                        #
+// #          COPYRIGHT: CloudCompare project                               #
+// #                                                                        #
+// ##########################################################################
+
+#ifndef CC_SECTION_EXTRACTOR_HEADER
+#define CC_SECTION_EXTRACTOR_HEADER
+
+// Local
+#include "ccEnvelopeExtractor.h"
+
+// System
+#include <vector>
+
+namespace CCCoreLib
+{
+	class GenericProgressCallback;
+}
+
+class ccGenericPointCloud;
+class ccPointCloud;
+class ccPolyline;
+
+//! Batch section extraction engine (used by the 'Extract section' tool and the command line)
+/** The points of all the input clouds are binned against the corridors of all
+    the sections (polylines) in a single pass: the bounding rectangles of the
+    sections segments (enlarged by half the corridor width) are indexed in a 2D
+    grid, so that each point is only tested against the segments that may contain it.
+    Points are processed in parallel, and so are the sections afterwards
+    (clouds extraction, unfolding and envelopes extraction).
+    The results are the same as when the sections are processed one after the other.
+    Nothing here interacts with the GUI.
+**/
+class ccSectionExtractor
+{
+  public:
+	//! Section extraction parameters
+	struct Parameters
+	{
+		//! Vertical dimension (0 = X, 1 = Y, 2 = Z)
+		unsigned char vertDim = 2;
+		//! Section (corridor) thickness
+		PointCoordinateType thickness = 0;
+		//! Whether to extract the sections as clouds
+		bool extractClouds = false;
+		//! Whether to extract the sections envelopes
+		bool extractEnvelopes = true;
+		//! Envelope type
+		ccEnvelopeExtractor::EnvelopeType envelopeType = ccEnvelopeExtractor::LOWER;
+		//! Envelope max edge length
+		PointCoordinateType maxEdgeLength = 0;
+		//! Multi-pass envelope extraction
+		bool multiPass = false;
+		//! Whether to split the envelopes when the edges can't be smaller than 'maxEdgeLength'
+		bool splitEnvelopes = false;
+		//! Visual debug mode (the envelopes are then extracted sequentially)
+		bool visualDebugMode = false;
+		//! Max number of threads (0 = all)
+		int maxThreadCount = 0;
+	};
+
+	//! Extracted section
+	struct Section
+	{
+		//! Section cloud (the points of all the input clouds, if requested)
+		ccPointCloud* cloud = nullptr;
+		//! Section envelope (or envelope parts, if requested)
+		std::vector<ccPolyline*> envelopes;
+		//! Number of points in the section corridor
+		unsigned pointCount = 0;
+	};
+
+	//! Extracts the sections of several clouds along several polylines
+	/** The envelopes vertices are the input points projected on the section polylines.
+	    \param clouds input clouds
+	    \param polylines sections (polylines with less than 2 vertices are ignored)
+	    \param params extraction parameters
+	    \param[out] sections extracted sections (one per polyline - to be released by the caller)
+	    \param progressCb optional progress callback
+	    \return success (false if there's not enough memory or if the process was cancelled - nothing is output then)
+	**/
+	static bool ExtractSections(const std::vector<ccGenericPointCloud*>& clouds,
+	                            const std::vector<ccPolyline*>&          polylines,
+	                            const Parameters&                        params,
+	                            std::vector<Section>&                    sections,
+	                            CCCoreLib::GenericProgressCallback*      progressCb = nullptr);
+
+	//! Unfolds several clouds along several polylines
+	/** Each point closer than thickness/2 to a polyline (in 2D) is unfolded: its
+	    horizontal coordinates become its curvilinear position along the polyline and
+	    its signed distance to the polyline (the vertical coordinate is kept).
+	    \param clouds input clouds
+	    \param polylines unfolding polylines (polylines with less than 2 vertices are ignored)
+	    \param thickness corridor thickness
+	    \param vertDim vertical dimension (0 = X, 1 = Y, 2 = Z)
+	    \param origin origin of the unfolded clouds (the vertical coordinate is ignored)
+	    \param[out] unfoldedClouds unfolded clouds (index: polylineIndex * clouds.size() + cloudIndex - or null if no point was unfolded)
+	    \param maxThreadCount max number of threads (0 = all)
+	    \param progressCb optional progress callback
+	    \return success (false if there's not enough memory or if the process was cancelled)
+	**/
+	static bool UnfoldClouds(const std::vector<ccGenericPointCloud*>& clouds,
+	                         const std::vector<ccPolyline*>&          polylines,
+	                         PointCoordinateType                      thickness,
+	                         unsigned char                            vertDim,
+	                         const CCVector3&                         origin,
+	                         std::vector<ccPointCloud*>&              unfoldedClouds,
+	                         int                                      maxThreadCount = 0,
+	                         CCCoreLib::GenericProgressCallback*      progressCb     = nullptr);
+};
+
+#endif // CC_SECTION_EXTRACTOR_HEADER
@@ -159,6 +159,7 @@
 // System
 #include "ccShortcutDialog.h"
 
+#include <algorithm>
 #include <iostream>
 #include <random>
 
@@ -2451,20 +2452,28 @@ void MainWindow::doActionProjectUncertainty()
 
 void MainWindow::doActionCheckPointsInsideFrustum()
 {
-	// there should be only one camera sensor in the current selection!
-	if (!haveOneSelection() || !m_selectedEntities.front()->isKindOf(CC_TYPES::CAMERA_SENSOR))
+	// there should be only camera sensors in the current selection!
+	std::vector<ccCameraSensor*> sensors;
+	for (ccHObject* entity : getSelectedEntities())
 	{
-		ccConsole::Error(tr("Select one and only one camera sensor!"));
-		return;
+		ccCameraSensor* sensor = ccHObjectCaster::ToCameraSensor(entity);
+		if (!sensor)
+		{
+			ccConsole::Error(tr("Select one or several camera sensors!"));
+			return;
+		}
+		sensors.push_back(sensor);
 	}
-
-	ccCameraSensor* sensor = ccHObjectCaster::ToCameraSensor(m_selectedEntities.front());
-	if (!sensor)
+	if (sensors.empty())
+	{
+		ccConsole::Error(tr("Select one or several camera sensors!"));
 		return;
+	}
 
 	// we need a cloud to filter!
-	ccHObject*    defaultCloud = sensor->getParent() && sensor->getParent()->isA(CC_TYPES::POINT_CLOUD) ? sensor->getParent() : nullptr;
-	ccPointCloud* pointCloud   = askUserToSelectACloud(defaultCloud, tr("Select a cloud to filter:"));
+	ccCameraSensor* sensor       = sensors.front();
+	ccHObject*      defaultCloud = sensor->getParent() && sensor->getParent()->isA(CC_TYPES::POINT_CLOUD) ? sensor->getParent() : nullptr;
+	ccPointCloud*   pointCloud   = askUserToSelectACloud(defaultCloud, tr("Select a cloud to filter:"));
 	if (!pointCloud)
 	{
 		return;
@@ -2484,52 +2493,95 @@ void MainWindow::doActionCheckPointsInsideFrustum()
 	assert(octree);
 
 	// filter octree then project the points
-	std::vector<unsigned> inCameraFrustum;
-	if (!octree->intersectWithFrustum(sensor, inCameraFrustum))
+	ccOctree::FrustaIntersection inCameraFrusta;
+	if (sensors.size() == 1)
 	{
-		ccConsole::Error(tr("Failed to intersect sensor frustum with octree!"));
+		std::vector<unsigned> inCameraFrustum;
+		if (!octree->intersectWithFrustum(sensor, inCameraFrustum))
+		{
+			ccConsole::Error(tr("Failed to intersect sensor frustum with octree!"));
+			updateUI();
+			return;
+		}
+		inCameraFrusta.rangeStart = {0, inCameraFrustum.size()};
+		inCameraFrusta.pointIndexes.swap(inCameraFrustum);
 	}
 	else
 	{
-		// scalar field
-		const char sfName[] = "Frustum visibility";
-		int        sfIdx    = pointCloud->getScalarFieldIndexByName(sfName);
+		// all the frusta are intersected with the octree at once
+		ccProgressDialog pDlg(true, this);
+		if (!octree->intersectWithFrusta(sensors, inCameraFrusta, 0, &pDlg))
+		{
+			ccConsole::Error(tr("Failed to intersect sensors frusta with octree!"));
+			updateUI();
+			return;
+		}
+	}
+
+	// scalar field (number of sensors 'seeing' each point)
+	const char sfName[] = "Frustum visibility";
+	int        sfIdx    = pointCloud->getScalarFieldIndexByName(sfName);
 
-		if (inCameraFrustum.empty())
+	if (inCameraFrusta.pointIndexes.empty())
+	{
+		ccConsole::Error(tr("No point fell inside the frustum!"));
+		if (sfIdx >= 0)
+			pointCloud->deleteScalarField(sfIdx);
+	}
+	else
+	{
+		if (sfIdx < 0)
+			sfIdx = pointCloud->addScalarField(sfName);
+		if (sfIdx < 0)
 		{
-			ccConsole::Error(tr("No point fell inside the frustum!"));
-			if (sfIdx >= 0)
-				pointCloud->deleteScalarField(sfIdx);
+			ccLog::Error(tr("Failed to allocate memory for output scalar field!"));
+			return;
 		}
-		else
+
+		CCCoreLib::ScalarField* sf = pointCloud->getScalarField(sfIdx);
+		assert(sf);
+		if (sf)
 		{
-			if (sfIdx < 0)
-				sfIdx = pointCloud->addScalarField(sfName);
-			if (sfIdx < 0)
+			sf->fill(0);
+
+			// we sort the indexes of each sensor, so that the cloud can then be processed
+			// by (disjoint) ranges of points in parallel
+			const int sensorCount = static_cast<int>(inCameraFrusta.rangeStart.size()) - 1;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int k = 0; k < sensorCount; ++k)
 			{
-				ccLog::Error(tr("Failed to allocate memory for output scalar field!"));
-				return;
+				std::sort(inCameraFrusta.pointIndexes.begin() + inCameraFrusta.rangeStart[k],
+				          inCameraFrusta.pointIndexes.begin() + inCameraFrusta.rangeStart[k + 1]);
 			}
 
-			CCCoreLib::ScalarField* sf = pointCloud->getScalarField(sfIdx);
-			assert(sf);
-			if (sf)
+			static const unsigned BlockSize  = (1 << 16);
+			const unsigned        pointCount = pointCloud->size();
+			const int             blockCount = static_cast<int>((pointCount + BlockSize - 1) / BlockSize);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int b = 0; b < blockCount; ++b)
 			{
-				sf->fill(0);
-
-				const ScalarType c_insideValue = static_cast<ScalarType>(1);
-
-				for (unsigned index : inCameraFrustum)
+				const unsigned firstIndex = static_cast<unsigned>(b) * BlockSize;
+				const unsigned lastIndex  = std::min(firstIndex + BlockSize, pointCount);
+				for (int k = 0; k < sensorCount; ++k)
 				{
-					sf->setValue(index, c_insideValue);
+					const unsigned* begin = inCameraFrusta.points(k);
+					const unsigned* end   = begin + inCameraFrusta.pointCount(k);
+					for (const unsigned* it = std::lower_bound(begin, end, firstIndex); it != end && *it < lastIndex; ++it)
+					{
+						sf->setValue(*it, sf->getValue(*it) + static_cast<ScalarType>(1));
+					}
 				}
+			}
 
-				sf->computeMinAndMax();
-				pointCloud->setCurrentDisplayedScalarField(sfIdx);
-				pointCloud->showSF(true);
+			sf->computeMinAndMax();
+			pointCloud->setCurrentDisplayedScalarField(sfIdx);
+			pointCloud->showSF(true);
 
-				pointCloud->redrawDisplay();
-			}
+			pointCloud->redrawDisplay();
 		}
 	}
 
@@ -3843,8 +3895,9 @@ void MainWindow::doActionRegister()
 		parameters.useC2MSignedDistances   = rDlg.useC2MSignedDistances(parameters.robustC2MSignedDistances);
 		parameters.normalsMatching         = rDlg.normalsMatchingOption();
 	}
-	bool useDataSFAsWeights  = rDlg.useDataSFAsWeights();
-	bool useModelSFAsWeights = rDlg.useModelSFAsWeights();
+	bool                useDataSFAsWeights  = rDlg.useDataSFAsWeights();
+	bool                useModelSFAsWeights = rDlg.useModelSFAsWeights();
+	ccICPEngine::Metric metric              = (rDlg.usePointToPlaneMetric() ? ccICPEngine::POINT_TO_PLANE : ccICPEngine::POINT_TO_POINT);
 
 	// semi-persistent storage (for next call)
 	rDlg.saveParameters();
@@ -3863,7 +3916,8 @@ void MainWindow::doActionRegister()
 	                             parameters,
 	                             useDataSFAsWeights,
 	                             useModelSFAsWeights,
-	                             this))
+	                             this,
+	                             metric))
 	{
 		QString rmsString           = tr("Final RMS*: %1 (computed on %2 points)").arg(finalError).arg(finalPointCount);
 		QString rmsDisclaimerString = tr("(* RMS is potentially weighted, depending on the selected options)");
@@ -9419,24 +9473,52 @@ void MainWindow::doActionExportCloudInfo()
 
 void MainWindow::doActionCloudCloudDist()
 {
-	if (getSelectedEntities().size() != 2)
+	if (getSelectedEntities().size() < 2)
 	{
-		ccConsole::Error(tr("Select 2 point clouds!"));
+		ccConsole::Error(tr("Select 2 point clouds (or more)!"));
 		return;
 	}
 
-	if (!m_selectedEntities.front()->isKindOf(CC_TYPES::POINT_CLOUD) || !m_selectedEntities.back()->isKindOf(CC_TYPES::POINT_CLOUD))
+	for (ccHObject* entity : m_selectedEntities)
 	{
-		ccConsole::Error(tr("Select 2 point clouds!"));
-		return;
+		if (!entity->isKindOf(CC_TYPES::POINT_CLOUD))
+		{
+			ccConsole::Error(tr("Select 2 point clouds (or more)!"));
+			return;
+		}
 	}
 
-	ccOrderChoiceDlg dlg(m_selectedEntities.front(), tr("Compared"), m_selectedEntities.back(), tr("Reference"), this);
-	if (!dlg.exec())
-		return;
+	ccGenericPointCloud*    compCloud = nullptr;
+	ccGenericPointCloud*    refCloud  = nullptr;
+	std::vector<ccHObject*> batchClouds;
+	if (m_selectedEntities.size() == 2)
+	{
+		ccOrderChoiceDlg dlg(m_selectedEntities.front(), tr("Compared"), m_selectedEntities.back(), tr("Reference"), this);
+		if (!dlg.exec())
+			return;
 
-	ccGenericPointCloud* compCloud = ccHObjectCaster::ToGenericPointCloud(dlg.getFirstEntity());
-	ccGenericPointCloud* refCloud  = ccHObjectCaster::ToGenericPointCloud(dlg.getSecondEntity());
+		compCloud = ccHObjectCaster::ToGenericPointCloud(dlg.getFirstEntity());
+		refCloud  = ccHObjectCaster::ToGenericPointCloud(dlg.getSecondEntity());
+	}
+	else
+	{
+		// batch mode: all the other clouds are compared to the same reference
+		int refIndex = ccItemSelectionDlg::SelectEntity(m_selectedEntities, 0, this, tr("Select the reference cloud (all the other clouds will be compared to it)"));
+		if (refIndex < 0)
+			return;
+
+		refCloud = ccHObjectCaster::ToGenericPointCloud(m_selectedEntities[refIndex]);
+		for (size_t i = 0; i < m_selectedEntities.size(); ++i)
+		{
+			if (static_cast<int>(i) == refIndex)
+				continue;
+
+			if (!compCloud)
+				compCloud = ccHObjectCaster::ToGenericPointCloud(m_selectedEntities[i]);
+			else
+				batchClouds.push_back(m_selectedEntities[i]);
+		}
+	}
 
 	// assert(!m_compDlg);
 	if (m_compDlg)
@@ -9450,6 +9532,11 @@ void MainWindow::doActionCloudCloudDist()
 		m_compDlg = nullptr;
 		return;
 	}
+	if (!batchClouds.empty())
+	{
+		ccConsole::Print(tr("[Distances] Batch mode: the same parameters will be applied to %1 other cloud(s) once validated").arg(batchClouds.size()));
+		m_compDlg->setBatchEntities(batchClouds);
+	}
 
 	connect(m_compDlg, &QDialog::finished, this, &MainWindow::deactivateComparisonMode);
 	m_compDlg->show();
@@ -11471,7 +11558,7 @@ void MainWindow::enableUIItems(dbTreeSelectionInfo& selInfo)
 	m_UI->actionCreateGBLSensor->setEnabled(atLeastOneCloud);
 	m_UI->actionCreateCameraSensor->setEnabled(selInfo.selCount <= 1); // free now
 	m_UI->actionProjectUncertainty->setEnabled(exactlyOneCameraSensor);
-	m_UI->actionCheckPointsInsideFrustum->setEnabled(exactlyOneCameraSensor);
+	m_UI->actionCheckPointsInsideFrustum->setEnabled(atLeastOneCameraSensor);
 	m_UI->actionLabelConnectedComponents->setEnabled(atLeastOneCloud);
 	m_UI->actionSORFilter->setEnabled(atLeastOneCloud);
 	m_UI->actionNoiseFilter->setEnabled(atLeastOneCloud);
@@ -11518,7 +11605,7 @@ void MainWindow::enableUIItems(dbTreeSelectionInfo& selInfo)
 	m_UI->actionBBMaxCornerToOrigin->setEnabled(atLeastOneEntity);
 
 	m_UI->actionAlign->setEnabled(exactlyTwoEntities); // Aurelien BEY le 13/11/2008
-	m_UI->actionCloudCloudDist->setEnabled(exactlyTwoClouds);
+	m_UI->actionCloudCloudDist->setEnabled(selInfo.cloudCount >= 2 && selInfo.cloudCount == selInfo.selCount); // 2 clouds (or more: batch mode)
 	m_UI->actionCloudMeshDist->setEnabled(exactlyTwoEntities && atLeastOneMesh);
 	m_UI->actionCloudPrimitiveDist->setEnabled(atLeastOneCloud && (atLeastOnePrimitive || atLeastOnePolyline));
 	m_UI->actionCPS->setEnabled(exactlyTwoClouds);
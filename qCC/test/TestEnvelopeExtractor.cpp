@@ -0,0 +1,176 @@
+#include "TestEnvelopeExtractor.h"
+
+#include "ccEnvelopeExtractor.h"
+
+// qCC_db
+#include <ccPointCloud.h>
+#include <ccPolyline.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+//! Creates a flat (Z = 0) 'C' shaped cloud, so that the concave hull differs from the convex hull
+static ccPointCloud* CreateCShapedCloud(unsigned pointCount, unsigned seed)
+{
+	ccPointCloud* cloud = new ccPointCloud("C shape");
+	if (!cloud->reserve(pointCount))
+	{
+		delete cloud;
+		return nullptr;
+	}
+
+	std::mt19937                           generator(seed);
+	std::uniform_real_distribution<double> coord(-1.0, 1.0);
+	while (cloud->size() < pointCount)
+	{
+		double x = coord(generator);
+		double y = coord(generator);
+		double r = std::sqrt(x * x + y * y);
+		if (r > 1.0 || r < 0.5 || (x > 0.0 && std::abs(y) < 0.25))
+		{
+			continue;
+		}
+		cloud->addPoint(CCVector3(static_cast<PointCoordinateType>(x), static_cast<PointCoordinateType>(y), 0));
+	}
+
+	return cloud;
+}
+
+//! Extracts the envelope with both modes and checks that they select the same points (in the same order)
+static void CompareModes(ccPointCloud* cloud, PointCoordinateType maxEdgeLength, ccEnvelopeExtractor::EnvelopeType envelopeType)
+{
+	const PointCoordinateType normDir[3] = {0, 0, 1};
+	const PointCoordinateType upDir[3]   = {0, 1, 0};
+	bool                      withUpDir  = (envelopeType != ccEnvelopeExtractor::FULL);
+
+	std::vector<unsigned>       standardIndexes;
+	std::unique_ptr<ccPolyline> standardEnvelope(ccEnvelopeExtractor::ExtractFlatEnvelope(cloud,
+	                                                                                      false,
+	                                                                                      maxEdgeLength,
+	                                                                                      withUpDir ? normDir : nullptr,
+	                                                                                      withUpDir ? upDir : nullptr,
+	                                                                                      envelopeType,
+	                                                                                      &standardIndexes,
+	                                                                                      false,
+	                                                                                      0.0,
+	                                                                                      ccEnvelopeExtractor::STANDARD));
+	QVERIFY(standardEnvelope);
+	QVERIFY(standardIndexes.size() >= 3);
+
+	std::vector<unsigned>       fastIndexes;
+	std::unique_ptr<ccPolyline> fastEnvelope(ccEnvelopeExtractor::ExtractFlatEnvelope(cloud,
+	                                                                                  false,
+	                                                                                  maxEdgeLength,
+	                                                                                  withUpDir ? normDir : nullptr,
+	                                                                                  withUpDir ? upDir : nullptr,
+	                                                                                  envelopeType,
+	                                                                                  &fastIndexes,
+	                                                                                  false,
+	                                                                                  0.0,
+	                                                                                  ccEnvelopeExtractor::FAST));
+	QVERIFY(fastEnvelope);
+
+	QCOMPARE(fastIndexes, standardIndexes);
+	QCOMPARE(fastEnvelope->size(), standardEnvelope->size());
+}
+
+void TestEnvelopeExtractor::testConvexHull() const
+{
+	std::unique_ptr<ccPointCloud> cloud(CreateCShapedCloud(2000, 1));
+	QVERIFY(cloud);
+
+	CompareModes(cloud.get(), 0, ccEnvelopeExtractor::FULL);
+}
+
+void TestEnvelopeExtractor::testConcaveHull() const
+{
+	for (unsigned seed = 1; seed <= 3; ++seed)
+	{
+		std::unique_ptr<ccPointCloud> cloud(CreateCShapedCloud(5000, seed));
+		QVERIFY(cloud);
+
+		for (PointCoordinateType maxEdgeLength : {0.3f, 0.1f, 0.05f})
+		{
+			CompareModes(cloud.get(), maxEdgeLength, ccEnvelopeExtractor::FULL);
+		}
+	}
+}
+
+void TestEnvelopeExtractor::testPartialEnvelopes() const
+{
+	std::unique_ptr<ccPointCloud> cloud(CreateCShapedCloud(5000, 4));
+	QVERIFY(cloud);
+
+	CompareModes(cloud.get(), 0.1f, ccEnvelopeExtractor::UPPER);
+	CompareModes(cloud.get(), 0.1f, ccEnvelopeExtractor::LOWER);
+}
+
+void TestEnvelopeExtractor::testBatchExtraction() const
+{
+	static const unsigned                               CloudCount = 4;
+	std::vector<std::unique_ptr<ccPointCloud>>          clouds;
+	std::vector<CCCoreLib::GenericIndexedCloudPersist*> inputs;
+	for (unsigned i = 0; i < CloudCount; ++i)
+	{
+		clouds.emplace_back(CreateCShapedCloud(3000, 10 + i));
+		QVERIFY(clouds.back());
+		inputs.push_back(clouds.back().get());
+	}
+
+	ccEnvelopeExtractor::BatchParameters params;
+	params.maxEdgeLength  = 0.1f;
+	params.allowSplitting = false;
+	params.mode           = ccEnvelopeExtractor::FAST;
+
+	std::vector<std::vector<ccPolyline*>> envelopes;
+	std::vector<bool>                     success;
+	QCOMPARE(ccEnvelopeExtractor::ExtractFlatEnvelopes(inputs, params, envelopes, success), ccEnvelopeExtractor::BATCH_SUCCESS);
+	QCOMPARE(envelopes.size(), clouds.size());
+	QCOMPARE(success.size(), clouds.size());
+
+	for (unsigned i = 0; i < CloudCount; ++i)
+	{
+		// the (parallel) FAST batch must output the same envelope as the sequential STANDARD extraction
+		std::vector<ccPolyline*> standardParts;
+		QVERIFY(success[i]);
+		QVERIFY(ccEnvelopeExtractor::ExtractFlatEnvelope(clouds[i].get(),
+		                                                 false,
+		                                                 params.maxEdgeLength,
+		                                                 standardParts,
+		                                                 ccEnvelopeExtractor::FULL,
+		                                                 false,
+		                                                 nullptr,
+		                                                 nullptr,
+		                                                 false,
+		                                                 ccEnvelopeExtractor::STANDARD));
+		QCOMPARE(envelopes[i].size(), standardParts.size());
+
+		for (size_t j = 0; j < standardParts.size(); ++j)
+		{
+			const ccPolyline* fastPart     = envelopes[i][j];
+			const ccPolyline* standardPart = standardParts[j];
+			QCOMPARE(fastPart->size(), standardPart->size());
+			for (unsigned k = 0; k < standardPart->size(); ++k)
+			{
+				const CCVector3* A = fastPart->getPoint(k);
+				const CCVector3* B = standardPart->getPoint(k);
+				QCOMPARE(A->x, B->x);
+				QCOMPARE(A->y, B->y);
+				QCOMPARE(A->z, B->z);
+			}
+		}
+
+		for (ccPolyline* part : standardParts)
+		{
+			delete part;
+		}
+		for (ccPolyline* part : envelopes[i])
+		{
+			delete part;
+		}
+	}
+}
+
+QTEST_MAIN(TestEnvelopeExtractor)
@@ -0,0 +1,21 @@
+#ifndef CC_TEST_ENVELOPE_EXTRACTOR_HEADER
+#define CC_TEST_ENVELOPE_EXTRACTOR_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class TestEnvelopeExtractor : public QObject
+{
+	Q_OBJECT
+  private Q_SLOTS:
+	/* The FAST mode output is compared with the STANDARD mode output */
+	void testConvexHull() const;
+
+	void testConcaveHull() const;
+
+	void testPartialEnvelopes() const;
+
+	void testBatchExtraction() const;
+};
+
+#endif // CC_TEST_ENVELOPE_EXTRACTOR_HEADER